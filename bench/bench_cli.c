@@ -0,0 +1,169 @@
+// Cold-start-to-output time of the non-interactive CLI on a large task file:
+// every run reads, parses, filters and prints from scratch. The same commands
+// are then timed against a resident daemon holding the tasks in memory, and
+// tab completion is timed against the index the daemon writes.
+#include "../src/cli.h"
+#include "../src/completion.h"
+#include "../src/storage.h"
+#include "../src/app_clock.h"
+#include "../src/daemon.h"
+#include "../src/daemon_client.h"
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#define DEFAULT_TASKS 100000
+#define RUNS 5
+
+// Helper: wall-clock seconds as a double
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Helper: write a tasks file with n tasks spread over projects, states and due dates
+static int write_tasks(const char *home, long n, time_t now) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/.todo-app", home);
+    if (mkdir(path, 0700) != 0) return -1;
+    snprintf(path, sizeof(path), "%s/.todo-app/tasks.json", home);
+    FILE *f = fopen(path, "w");
+    if (!f) return -1;
+    unsigned int seed = 12345;
+    fputc('[', f);
+    for (long i = 0; i < n; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        long long day = (long long)(now / 86400) - 60 + (long long)(seed % 120u);
+        bool has_due = (seed >> 8) % 4 != 0;
+        bool done = (seed >> 12) % 3 == 0;
+        char due[64] = "null";
+        if (has_due) {
+            time_t t = (time_t)(day * 86400);
+            struct tm tm;
+            gmtime_r(&t, &tm);
+            strftime(due, sizeof(due), "\"%Y-%m-%dT00:00:00Z\",\"due_kind\":\"date\"", &tm);
+        }
+        fprintf(f, "%s{\"id\":\"%08lx-0000-4000-8000-000000000000\",\"name\":\"Task %ld\","
+                   "\"created\":\"2026-01-01T00:00:00Z\",\"due\":%s,\"tags\":[\"t%u\"],"
+                   "\"priority\":\"%s\",\"status\":\"%s\",\"project\":\"p%u\",\"note\":null}",
+                i ? "," : "", i, i, due, (seed >> 16) % 10u,
+                (seed >> 20) % 3 == 0 ? "high" : "low", done ? "done" : "pending", (seed >> 24) % 8u);
+    }
+    fputs("]\n", f);
+    return fclose(f);
+}
+
+// Helper: time one command with stdout discarded; returns ms per run
+static double time_run(int (*run)(int, char **), int argc, char **argv) {
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    int devnull = open("/dev/null", O_WRONLY);
+    dup2(devnull, STDOUT_FILENO);
+    close(devnull);
+
+    double start = now_seconds();
+    for (int r = 0; r < RUNS; ++r) {
+        if (run(argc, argv) != 0) break;
+        fflush(stdout);
+    }
+    double elapsed = now_seconds() - start;
+
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+    return elapsed * 1000.0 / RUNS;
+}
+
+// Helper: time one CLI invocation
+static double time_command(int argc, char **argv) {
+    return time_run(cli_main, argc, argv);
+}
+
+static int complete_to_stdout(int argc, char **argv) {
+    return completion_complete(argc, argv, stdout);
+}
+
+// Helper: start a daemon in a child process and wait until it answers
+static pid_t start_daemon(void) {
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) return -1;
+    if (pid == 0) {
+        int devnull = open("/dev/null", O_WRONLY);
+        dup2(devnull, STDOUT_FILENO);
+        close(devnull);
+        char *args[] = {"daemon"};
+        _exit(daemon_run(1, args));
+    }
+    cJSON *ping = cJSON_CreateObject();
+    cJSON_AddStringToObject(ping, "op", "ping");
+    for (int tries = 0; tries < 600; ++tries) {
+        cJSON *pong = NULL;
+        if (daemon_client_request(ping, &pong) == 0) {
+            cJSON_Delete(pong);
+            cJSON_Delete(ping);
+            return pid;
+        }
+        usleep(50000);
+    }
+    cJSON_Delete(ping);
+    kill(pid, SIGTERM);
+    waitpid(pid, NULL, 0);
+    return -1;
+}
+
+// Helper: time the benchmark's queries
+static void time_queries(void) {
+    char *overdue[] = {"list", "--overdue"};
+    printf("%-28s %10.1f ms/run\n", "list --overdue", time_command(2, overdue));
+    char *project[] = {"list", "--project", "p3", "--status", "pending"};
+    printf("%-28s %10.1f ms/run\n", "list --project --status", time_command(5, project));
+    char *all[] = {"list"};
+    printf("%-28s %10.1f ms/run\n", "list (all tasks)", time_command(1, all));
+}
+
+int main(int argc, char **argv) {
+    long n = argc > 1 ? atol(argv[1]) : DEFAULT_TASKS;
+    if (n <= 0) n = DEFAULT_TASKS;
+
+    char home[] = "/tmp/smartodo-bench-XXXXXX";
+    if (!mkdtemp(home)) return 1;
+    setenv("HOME", home, 1);
+    time_t now = 1792310400; // 2026-10-18
+    app_clock_set_fixed(now);
+    if (write_tasks(home, n, now) != 0) return 1;
+
+    printf("CLI cold start benchmark (%ld tasks, mean of %d runs)\n", n, RUNS);
+
+    time_queries();
+
+    pid_t daemon = start_daemon();
+    if (daemon > 0) {
+        printf("Through the daemon\n");
+        time_queries();
+        kill(daemon, SIGTERM);
+        waitpid(daemon, NULL, 0);
+
+        // The daemon wrote the completion index when it started
+        printf("Tab completion\n");
+        char *project[] = {"list", "--project", "p"};
+        printf("%-28s %10.1f ms/run\n", "list --project <Tab>", time_run(complete_to_stdout, 3, project));
+        char *ids[] = {"done", ""};
+        printf("%-28s %10.1f ms/run\n", "done <Tab>", time_run(complete_to_stdout, 2, ids));
+    } else {
+        printf("Daemon did not start; skipped\n");
+    }
+
+    // Saves also leave history checkpoints and stats behind
+    char cmd[256];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", home);
+    system(cmd);
+    return 0;
+}
@@ -0,0 +1,211 @@
+// Compares bench_micro JSON result files (harness.h) with a baseline and
+// fails on significant regressions. A benchmark regressed when its median
+// is more than the threshold slower than the baseline's and a one-sided
+// Mann-Whitney U test on the raw samples says the slowdown is not noise.
+// Given several current files (repeated runs), a regression must show in
+// every one of them; the table shows the last.
+//   bench_compare [--threshold PCT] [--alpha P] baseline.json current.json...
+#include <cjson/cJSON.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_THRESHOLD 25.0   // Percent slowdown of the median
+#define DEFAULT_ALPHA 0.01       // Significance level
+#define MAX_RUNS 8
+
+// Helper: read and parse a JSON file
+static cJSON *read_json(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) return NULL;
+    size_t cap = 1 << 16, len = 0;
+    char *buf = malloc(cap);
+    size_t n;
+    while (buf && (n = fread(buf + len, 1, cap - len, f)) > 0) {
+        len += n;
+        if (len == cap) {
+            char *grown = realloc(buf, cap *= 2);
+            if (!grown) free(buf);
+            buf = grown;
+        }
+    }
+    fclose(f);
+    cJSON *root = buf ? cJSON_ParseWithLength(buf, len) : NULL;
+    free(buf);
+    return root;
+}
+
+// Helper: the result named name in a results array, or NULL
+static const cJSON *find_result(const cJSON *results, const char *name) {
+    const cJSON *r;
+    cJSON_ArrayForEach(r, results) {
+        const char *n = cJSON_GetStringValue(cJSON_GetObjectItem(r, "name"));
+        if (n && strcmp(n, name) == 0) return r;
+    }
+    return NULL;
+}
+
+// Helper: copy a samples array; returns the count (0 on error)
+static size_t samples_of(const cJSON *result, double **out) {
+    const cJSON *arr = cJSON_GetObjectItem(result, "samples_ns");
+    int n = cJSON_GetArraySize(arr);
+    *out = n > 0 ? malloc((size_t)n * sizeof(double)) : NULL;
+    if (!*out) return 0;
+    int i = 0;
+    const cJSON *v;
+    cJSON_ArrayForEach(v, arr) (*out)[i++] = cJSON_GetNumberValue(v);
+    return (size_t)n;
+}
+
+typedef struct {
+    double value;
+    int group;     // 0 baseline, 1 current
+} Ranked;
+
+static int compare_ranked(const void *a, const void *b) {
+    double x = ((const Ranked *)a)->value, y = ((const Ranked *)b)->value;
+    return (x > y) - (x < y);
+}
+
+// Helper: one-sided Mann-Whitney U test that the current samples are
+// larger (slower) than the baseline's, by the normal approximation with
+// a correction for ties; returns the p-value
+static double mann_whitney_slower(const double *base, size_t n1, const double *cur, size_t n2) {
+    size_t n = n1 + n2;
+    Ranked *all = malloc(n * sizeof(Ranked));
+    if (!all) return 1.0;
+    for (size_t i = 0; i < n1; i++) all[i] = (Ranked){base[i], 0};
+    for (size_t i = 0; i < n2; i++) all[n1 + i] = (Ranked){cur[i], 1};
+    qsort(all, n, sizeof(Ranked), compare_ranked);
+
+    double rank_sum = 0, ties = 0;
+    for (size_t i = 0; i < n;) {
+        size_t j = i;
+        while (j < n && all[j].value == all[i].value) j++;
+        double rank = (double)(i + 1 + j) / 2.0;   // Average of ranks i+1..j
+        for (size_t k = i; k < j; k++) {
+            if (all[k].group == 1) rank_sum += rank;
+        }
+        double t = (double)(j - i);
+        ties += t * t * t - t;
+        i = j;
+    }
+    free(all);
+
+    double u = rank_sum - (double)n2 * (double)(n2 + 1) / 2.0;
+    double mean = (double)n1 * (double)n2 / 2.0;
+    double var = (double)n1 * (double)n2 / 12.0 * ((double)(n + 1) - ties / ((double)n * (double)(n - 1)));
+    if (var <= 0) return 1.0;
+    double z = (u - mean - 0.5) / sqrt(var);   // With continuity correction
+    return 0.5 * erfc(z / sqrt(2.0));
+}
+
+// Comparison of one benchmark in one run with the baseline
+typedef struct {
+    double base_median;
+    double cur_median;
+    double delta;                // Percent
+    double p;                    // Of the more likely direction
+    int verdict;                 // 1 slower, -1 faster, 0 same
+} Comparison;
+
+// Helper: compare one result with the baseline's
+static Comparison compare(const cJSON *b, const cJSON *r, double threshold, double alpha) {
+    Comparison c = {0};
+    c.base_median = cJSON_GetNumberValue(cJSON_GetObjectItem(b, "median_ns"));
+    c.cur_median = cJSON_GetNumberValue(cJSON_GetObjectItem(r, "median_ns"));
+    c.delta = c.base_median > 0 ? (c.cur_median - c.base_median) / c.base_median * 100.0 : 0;
+    double *bs = NULL, *cs = NULL;
+    size_t n1 = samples_of(b, &bs), n2 = samples_of(r, &cs);
+    double p_slower = (n1 && n2) ? mann_whitney_slower(bs, n1, cs, n2) : 1.0;
+    double p_faster = (n1 && n2) ? mann_whitney_slower(cs, n2, bs, n1) : 1.0;
+    free(bs);
+    free(cs);
+    c.p = p_slower < p_faster ? p_slower : p_faster;
+    if (c.delta > threshold && p_slower < alpha) c.verdict = 1;
+    else if (c.delta < -threshold && p_faster < alpha) c.verdict = -1;
+    return c;
+}
+
+int main(int argc, char **argv) {
+    double threshold = DEFAULT_THRESHOLD, alpha = DEFAULT_ALPHA;
+    const char *paths[MAX_RUNS + 1];
+    int npaths = 0;
+    bool usage = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) threshold = atof(argv[++i]);
+        else if (strcmp(argv[i], "--alpha") == 0 && i + 1 < argc) alpha = atof(argv[++i]);
+        else if (npaths <= MAX_RUNS && argv[i][0] != '-') paths[npaths++] = argv[i];
+        else usage = true;
+    }
+    if (usage || npaths < 2) {
+        fprintf(stderr, "Usage: bench_compare [--threshold PCT] [--alpha P] baseline.json current.json...\n");
+        return 2;
+    }
+
+    cJSON *docs[MAX_RUNS + 1] = {NULL};
+    for (int i = 0; i < npaths; i++) {
+        if (!(docs[i] = read_json(paths[i]))) {
+            fprintf(stderr, "Cannot read %s\n", paths[i]);
+            for (int k = 0; k < i; k++) cJSON_Delete(docs[k]);
+            return 2;
+        }
+    }
+    const cJSON *base = docs[0], *cur = docs[npaths - 1];
+    const cJSON *base_params = cJSON_GetObjectItem(base, "params");
+    const cJSON *param;
+    cJSON_ArrayForEach(param, cJSON_GetObjectItem(cur, "params")) {
+        const cJSON *other = cJSON_GetObjectItem(base_params, param->string);
+        if (!other || cJSON_GetNumberValue(other) != cJSON_GetNumberValue(param)) {
+            fprintf(stderr, "Warning: %s differs from the baseline's; results are not comparable\n", param->string);
+        }
+    }
+
+    printf("%-32s %12s %12s %8s %9s  %s\n", "benchmark", "baseline", "current", "delta", "p", "verdict");
+    int regressions = 0;
+    const cJSON *base_results = cJSON_GetObjectItem(base, "results");
+    const cJSON *r;
+    cJSON_ArrayForEach(r, cJSON_GetObjectItem(cur, "results")) {
+        const char *name = cJSON_GetStringValue(cJSON_GetObjectItem(r, "name"));
+        const cJSON *b = name ? find_result(base_results, name) : NULL;
+        if (!b) {
+            double median = cJSON_GetNumberValue(cJSON_GetObjectItem(r, "median_ns"));
+            printf("%-32s %12s %9.3f ms %8s %9s  new\n", name ? name : "?", "-", median / 1e6, "-", "-");
+            continue;
+        }
+        Comparison c = compare(b, r, threshold, alpha);
+
+        // Slower in the last run: a regression only if every run agrees
+        int slower_runs = 0;
+        for (int i = 1; c.verdict == 1 && i < npaths; i++) {
+            const cJSON *run = find_result(cJSON_GetObjectItem(docs[i], "results"), name);
+            slower_runs += run && compare(b, run, threshold, alpha).verdict == 1;
+        }
+        const char *verdict = c.verdict < 0 ? "faster" : "same";
+        if (c.verdict == 1 && slower_runs == npaths - 1) {
+            verdict = "REGRESSION";
+            regressions++;
+        } else if (c.verdict == 1) {
+            verdict = "noise (not in every run)";
+        }
+        printf("%-32s %9.3f ms %9.3f ms %+7.1f%% %9.2g  %s\n", name, c.base_median / 1e6, c.cur_median / 1e6,
+               c.delta, c.p, verdict);
+    }
+    cJSON_ArrayForEach(r, base_results) {
+        const char *name = cJSON_GetStringValue(cJSON_GetObjectItem(r, "name"));
+        if (name && !find_result(cJSON_GetObjectItem(cur, "results"), name)) {
+            printf("%-32s %12s %12s %8s %9s  missing\n", name, "-", "-", "-", "-");
+        }
+    }
+    for (int i = 0; i < npaths; i++) cJSON_Delete(docs[i]);
+
+    if (regressions) {
+        printf("%d significant regression%s (slower by more than %.0f%%, p < %g, in %d run%s)\n", regressions,
+               regressions == 1 ? "" : "s", threshold, alpha, npaths - 1, npaths == 2 ? "" : "s");
+        return 1;
+    }
+    printf("No significant regressions\n");
+    return 0;
+}
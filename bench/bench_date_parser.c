@@ -0,0 +1,51 @@
+// Throughput benchmark for parse_natural_date_ctx() with a fixed reference time,
+// as used by batch imports.
+#include "../src/date_parser.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define DEFAULT_ITERATIONS 1000000
+
+static const char *INPUTS[] = {
+    "tomorrow", "next friday 3pm", "in 2 weeks", "end of month", "the 15th",
+    "may 20", "20 may 2026 at 14:30", "2pm", "in 3 hours", "Dec 25 2pm",
+};
+
+#define INPUT_COUNT (sizeof(INPUTS) / sizeof(INPUTS[0]))
+
+// Helper: wall-clock seconds as a double
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+    long iterations = argc > 1 ? atol(argv[1]) : DEFAULT_ITERATIONS;
+    if (iterations <= 0) iterations = DEFAULT_ITERATIONS;
+
+    DateParseContext ctx;
+    date_parser_context_init(&ctx, time(NULL));
+
+    volatile long long sink = 0;
+    long failures = 0;
+
+    printf("Date parser benchmark (%ld iterations)\n", iterations);
+
+    double start = now_seconds();
+    for (long i = 0; i < iterations; ++i) {
+        time_t t;
+        if (parse_natural_date_ctx(&ctx, INPUTS[i % INPUT_COUNT], &t)) {
+            sink += t;
+        } else {
+            failures++;
+        }
+    }
+    double elapsed = now_seconds() - start;
+
+    printf("%-28s %10.1f ns/op %12.0f ops/sec\n", "parse_natural_date_ctx",
+           elapsed * 1e9 / (double)iterations, (double)iterations / elapsed);
+
+    return failures == 0 && sink != 42 ? 0 : 1;
+}
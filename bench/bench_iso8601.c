@@ -0,0 +1,79 @@
+// Throughput benchmark for the fixed-format ISO-8601 routines in utils.c,
+// compared against the strptime/timegm and gmtime_r/strftime paths they replace.
+#include "../src/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_ITERATIONS 2000000
+#define SAMPLE_COUNT 1024
+
+// Helper: wall-clock seconds as a double
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Helper: print one result line
+static void report(const char *name, long iterations, double elapsed) {
+    printf("%-28s %10.1f ns/op %12.0f ops/sec\n", name,
+           elapsed * 1e9 / (double)iterations, (double)iterations / elapsed);
+}
+
+int main(int argc, char **argv) {
+    long iterations = argc > 1 ? atol(argv[1]) : DEFAULT_ITERATIONS;
+    if (iterations <= 0) iterations = DEFAULT_ITERATIONS;
+
+    // Build a set of realistic timestamps (2000-2040) and their string forms
+    static time_t samples[SAMPLE_COUNT];
+    static char strings[SAMPLE_COUNT][UTILS_ISO8601_BUFSZ];
+    unsigned int seed = 12345;
+    for (int i = 0; i < SAMPLE_COUNT; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        samples[i] = (time_t)(946684800LL + (long long)(seed % 1262304000u));
+        utils_format_iso8601(samples[i], strings[i]);
+    }
+
+    volatile long long sink = 0;
+    char buf[UTILS_ISO8601_BUFSZ];
+    double start;
+
+    printf("ISO-8601 benchmark (%ld iterations)\n", iterations);
+
+    start = now_seconds();
+    for (long i = 0; i < iterations; ++i) {
+        utils_format_iso8601(samples[i % SAMPLE_COUNT], buf);
+        sink += buf[18];
+    }
+    report("format (utils_format)", iterations, now_seconds() - start);
+
+    start = now_seconds();
+    for (long i = 0; i < iterations; ++i) {
+        struct tm tm;
+        time_t t = samples[i % SAMPLE_COUNT];
+        gmtime_r(&t, &tm);
+        strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", &tm);
+        sink += buf[18];
+    }
+    report("format (gmtime_r+strftime)", iterations, now_seconds() - start);
+
+    start = now_seconds();
+    for (long i = 0; i < iterations; ++i) {
+        time_t t;
+        utils_parse_iso8601(strings[i % SAMPLE_COUNT], &t);
+        sink += t;
+    }
+    report("parse (utils_parse)", iterations, now_seconds() - start);
+
+    start = now_seconds();
+    for (long i = 0; i < iterations; ++i) {
+        struct tm tm = {0};
+        strptime(strings[i % SAMPLE_COUNT], "%Y-%m-%dT%H:%M:%SZ", &tm);
+        sink += timegm(&tm);
+    }
+    report("parse (strptime+timegm)", iterations, now_seconds() - start);
+
+    return sink == 42 ? 1 : 0;
+}
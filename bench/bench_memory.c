@@ -0,0 +1,303 @@
+// Memory footprint of a loaded task set (dataset.h), at several sizes:
+// resident set and heap after the load, the cJSON tree the load goes
+// through, and the bytes a task costs, field by field. Heap figures come
+// from the allocator (glibc's mallinfo2() and malloc_usable_size()), so
+// they include its per-block header and rounding; elsewhere only the
+// bytes requested are known and the heap columns are n/a.
+//   bench_memory [--tasks N[,N...]] [--json FILE|-]
+#include "dataset.h"
+#include "../src/storage.h"
+#include "../src/daemon_client.h"
+#include "../src/app_clock.h"
+#include <cjson/cJSON.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#define DEFAULT_SIZES "1000,10000,100000"
+#define MAX_SIZES 16
+#define MIB (1024.0 * 1024.0)
+
+// Where a task's bytes go
+enum { F_STRUCT, F_ID, F_NAME, F_TAGS, F_PROJECT, F_NOTE, F_RECUR, F_COUNT };
+static const char *const FIELD_NAMES[F_COUNT] = {"struct", "id", "name", "tags", "project", "note", "recur"};
+
+typedef struct {
+    size_t tasks;
+    long long file;          // Size of tasks.json
+    long long rss;           // Resident after the load, -1 if unknown
+    long long rss_load;      // Growth of the resident set over the load
+    long long heap;          // Heap the loaded tasks hold, -1 if unknown
+    long long tree;          // Heap of the parsed cJSON tree, -1 if unknown
+    long long peak;          // Heap while tree and tasks both live, -1 if unknown
+    double fields[F_COUNT];  // Bytes per task
+} Sample;
+
+// Helper: bytes in use on the heap, or -1 where the allocator cannot tell
+static long long heap_in_use(void) {
+#ifdef __GLIBC__
+    struct mallinfo2 mi = mallinfo2();
+    return (long long)(mi.uordblks + mi.hblkhd);
+#else
+    return -1;
+#endif
+}
+
+// Helper: resident set size in bytes, or -1 if unknown
+static long long rss_bytes(void) {
+    FILE *f = fopen("/proc/self/statm", "r");
+    long long pages = -1, resident = -1;
+    if (f) {
+        if (fscanf(f, "%lld %lld", &pages, &resident) != 2) resident = -1;
+        fclose(f);
+    }
+    if (resident >= 0) return resident * sysconf(_SC_PAGESIZE);
+
+    // Only the peak is portable; ru_maxrss is in KiB on Linux, bytes on macOS
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return -1;
+#ifdef __APPLE__
+    return (long long)ru.ru_maxrss;
+#else
+    return (long long)ru.ru_maxrss * 1024;
+#endif
+}
+
+// Helper: bytes a block costs the heap; the bytes asked for where the
+// allocator cannot tell
+static size_t block_bytes(const void *p, size_t requested) {
+    if (!p) return 0;
+#ifdef __GLIBC__
+    (void)requested;
+    return malloc_usable_size((void *)p) + sizeof(size_t);
+#else
+    return requested;
+#endif
+}
+
+// Helper: bytes a string costs the heap
+static size_t string_bytes(const char *s) {
+    return s ? block_bytes(s, strlen(s) + 1) : 0;
+}
+
+// Helper: add up the bytes of each field over a task set; the slot in the
+// task array counts toward the struct
+static void measure_fields(Task **tasks, size_t count, double *fields) {
+    memset(fields, 0, F_COUNT * sizeof(double));
+    for (size_t i = 0; i < count; i++) {
+        const Task *t = tasks[i];
+        fields[F_STRUCT] += (double)(block_bytes(t, sizeof(Task)) + sizeof(Task *));
+        fields[F_ID] += (double)string_bytes(t->id);
+        fields[F_NAME] += (double)string_bytes(t->name);
+        fields[F_TAGS] += (double)block_bytes(t->tags, t->tag_count * sizeof(char *));
+        for (size_t j = 0; j < t->tag_count; j++) fields[F_TAGS] += (double)string_bytes(t->tags[j]);
+        fields[F_PROJECT] += (double)string_bytes(t->project);
+        fields[F_NOTE] += (double)string_bytes(t->note);
+        fields[F_RECUR] += (double)string_bytes(t->recur);
+    }
+    for (int f = 0; f < F_COUNT; f++) fields[f] = count ? fields[f] / (double)count : 0;
+}
+
+// Helper: heap growth from a baseline, or -1 if the heap is not measured
+static long long heap_since(long long base) {
+    long long now = heap_in_use();
+    return (now < 0 || base < 0) ? -1 : now - base;
+}
+
+// Helper: write n tasks, then load them, measuring at the peak and after
+static int run_size(size_t n, Sample *s) {
+    memset(s, 0, sizeof(*s));
+    s->tasks = n;
+
+    DatasetSpec spec;
+    dataset_default_spec(&spec);
+    spec.count = n;
+    app_clock_set_fixed(spec.base);
+    size_t count = 0;
+    Task **generated = dataset_generate(&spec, &count);
+    if (!generated || storage_write_snapshot(generated, count) != 0) return -1;
+    storage_free_tasks(generated, count);
+
+    char *path = storage_path("tasks.json");
+    struct stat st;
+    s->file = (path && stat(path, &st) == 0) ? (long long)st.st_size : -1;
+    free(path);
+
+    // Hand freed memory back first, so the resident growth is the load's
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+    long long rss_before = rss_bytes();
+    long long base = heap_in_use();
+
+    // Open parses the whole file into one tree, and the tasks are built
+    // from it while it lives; what closing frees is the cJSON overhead
+    StorageLoader *loader = storage_loader_open();
+    if (!loader) return -1;
+    Task **tasks = storage_loader_rest(loader, &count);
+    s->peak = heap_since(base);
+    storage_loader_close(loader);
+    if (!tasks || count != n) {
+        storage_free_tasks(tasks, count);
+        return -1;
+    }
+    s->heap = heap_since(base);
+    s->tree = (s->peak >= 0 && s->heap >= 0) ? s->peak - s->heap : -1;
+    s->rss = rss_bytes();
+    s->rss_load = (s->rss >= 0 && rss_before >= 0) ? s->rss - rss_before : -1;
+    measure_fields(tasks, count, s->fields);
+    storage_free_tasks(tasks, count);
+    return 0;
+}
+
+// Helper: print bytes as MiB, or n/a
+static void print_mib(FILE *out, long long bytes, int width) {
+    if (bytes < 0) fprintf(out, " %*s", width, "n/a");
+    else fprintf(out, " %*.1f", width, (double)bytes / MIB);
+}
+
+// Helper: print bytes per task, or n/a
+static void print_per_task(FILE *out, long long bytes, size_t n, int width) {
+    if (bytes < 0) fprintf(out, " %*s", width, "n/a");
+    else fprintf(out, " %*.0f", width, (double)bytes / (double)n);
+}
+
+static void print_table(FILE *out, const Sample *samples, size_t count) {
+    fprintf(out, "Memory after loading N tasks (MiB; per task in bytes)\n");
+    fprintf(out, "%9s %9s %9s %9s %9s %9s %10s %10s %10s\n", "tasks", "file", "RSS", "RSS+load",
+            "heap", "peak", "heap/task", "cJSON/task", "file/task");
+    for (size_t i = 0; i < count; i++) {
+        const Sample *s = &samples[i];
+        fprintf(out, "%9zu", s->tasks);
+        print_mib(out, s->file, 9);
+        print_mib(out, s->rss, 9);
+        print_mib(out, s->rss_load, 9);
+        print_mib(out, s->heap, 9);
+        print_mib(out, s->peak, 9);
+        print_per_task(out, s->heap, s->tasks, 10);
+        print_per_task(out, s->tree, s->tasks, 10);
+        print_per_task(out, s->file, s->tasks, 10);
+        fprintf(out, "\n");
+    }
+
+    fprintf(out, "\nBytes per task by field%s\n",
+            heap_in_use() < 0 ? " (requested; allocator overhead unknown)" : "");
+    fprintf(out, "%9s", "tasks");
+    for (int f = 0; f < F_COUNT; f++) fprintf(out, " %8s", FIELD_NAMES[f]);
+    fprintf(out, " %8s\n", "total");
+    for (size_t i = 0; i < count; i++) {
+        double total = 0;
+        fprintf(out, "%9zu", samples[i].tasks);
+        for (int f = 0; f < F_COUNT; f++) {
+            fprintf(out, " %8.1f", samples[i].fields[f]);
+            total += samples[i].fields[f];
+        }
+        fprintf(out, " %8.1f\n", total);
+    }
+}
+
+// Helper: a byte count as JSON, null if unknown
+static void add_bytes(cJSON *obj, const char *key, long long bytes) {
+    if (bytes < 0) cJSON_AddNullToObject(obj, key);
+    else cJSON_AddNumberToObject(obj, key, (double)bytes);
+}
+
+static int write_json(const Sample *samples, size_t count, const char *path) {
+    cJSON *root = cJSON_CreateObject();
+    cJSON *results = root ? cJSON_AddArrayToObject(root, "results") : NULL;
+    if (!results) {
+        cJSON_Delete(root);
+        return -1;
+    }
+    cJSON_AddStringToObject(root, "suite", "memory");
+    for (size_t i = 0; i < count; i++) {
+        const Sample *s = &samples[i];
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddNumberToObject(item, "tasks", (double)s->tasks);
+        add_bytes(item, "file_bytes", s->file);
+        add_bytes(item, "rss_bytes", s->rss);
+        add_bytes(item, "rss_load_bytes", s->rss_load);
+        add_bytes(item, "heap_bytes", s->heap);
+        add_bytes(item, "cjson_bytes", s->tree);
+        add_bytes(item, "peak_heap_bytes", s->peak);
+        cJSON *fields = cJSON_AddObjectToObject(item, "bytes_per_task");
+        for (int f = 0; f < F_COUNT; f++) cJSON_AddNumberToObject(fields, FIELD_NAMES[f], s->fields[f]);
+        cJSON_AddItemToArray(results, item);
+    }
+    char *json = cJSON_Print(root);
+    cJSON_Delete(root);
+    if (!json) return -1;
+    int rc = 0;
+    if (strcmp(path, "-") == 0) {
+        printf("%s\n", json);
+    } else {
+        FILE *f = fopen(path, "w");
+        rc = (f && fprintf(f, "%s\n", json) >= 0) ? 0 : -1;
+        if (f && fclose(f) != 0) rc = -1;
+    }
+    free(json);
+    return rc;
+}
+
+// Helper: parse a comma-separated list of task counts
+static size_t parse_sizes(const char *list, size_t *sizes) {
+    size_t n = 0;
+    const char *p = list;
+    while (*p && n < MAX_SIZES) {
+        char *end = NULL;
+        unsigned long long v = strtoull(p, &end, 10);
+        if (end == p || v == 0 || p[0] == '-' || (*end != ',' && *end != '\0')) return 0;
+        sizes[n++] = (size_t)v;
+        p = *end ? end + 1 : end;
+    }
+    return *p ? 0 : n;
+}
+
+int main(int argc, char **argv) {
+    const char *list = DEFAULT_SIZES, *json_path = NULL;
+    for (int i = 1; i < argc; i++) {
+        const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "--tasks") == 0 && val) list = argv[++i];
+        else if (strcmp(argv[i], "--json") == 0 && val) json_path = argv[++i];
+        else {
+            fprintf(stderr, "Usage: bench_memory [--tasks N[,N...]] [--json FILE|-]\n");
+            return 2;
+        }
+    }
+    size_t sizes[MAX_SIZES];
+    size_t size_count = parse_sizes(list, sizes);
+    if (size_count == 0) {
+        fprintf(stderr, "bench_memory: --tasks takes up to %d counts, e.g. 1000,10000\n", MAX_SIZES);
+        return 2;
+    }
+
+    char home[] = "/tmp/smartodo-bench-XXXXXX";
+    if (!mkdtemp(home)) return 1;
+    setenv("HOME", home, 1);
+    daemon_client_set_enabled(false);
+
+    Sample samples[MAX_SIZES];
+    int rc = 0;
+    for (size_t i = 0; i < size_count && rc == 0; i++) {
+        if (run_size(sizes[i], &samples[i]) != 0) {
+            fprintf(stderr, "bench_memory: loading %zu tasks failed\n", sizes[i]);
+            rc = 1;
+        }
+    }
+    if (rc == 0) {
+        if (!json_path || strcmp(json_path, "-") != 0) print_table(stdout, samples, size_count);
+        if (json_path && write_json(samples, size_count, json_path) != 0) rc = 1;
+    }
+
+    char cmd[256];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", home);
+    system(cmd);
+    return rc;
+}
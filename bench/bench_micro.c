@@ -0,0 +1,227 @@
+// Microbenchmarks of the hot paths on a synthetic task set (dataset.h):
+// storage load and save, task JSON conversion, the search and date
+// filters, the sorts, and drawing the task list on a headless screen.
+// Operations are tasks processed, or frames for the draw.
+//   bench_micro [--tasks N] [--reps N] [--warmup N] [--filter TEXT] [--json FILE|-]
+#include "harness.h"
+#include "dataset.h"
+#include "../src/storage.h"
+#include "../src/task_manager.h"
+#include "../src/daemon_client.h"
+#include "../src/app_clock.h"
+#include "../src/ui.h"
+#include <curses.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define DEFAULT_TASKS 10000
+#define DEFAULT_REPS 21
+#define DEFAULT_WARMUP 3
+
+// Passes per timed run for the fast paths, so one sample takes long enough
+// to rise above timer and scheduler noise
+#define FILTER_PASSES 10
+#define DRAW_FRAMES 200
+
+// Shared state of the benchmarks
+typedef struct {
+    Task **tasks;           // The data set as loaded
+    size_t count;
+    Task **work;            // Scratch array: filter output, sort input
+    Task **loaded;          // Result of a timed load
+    size_t loaded_count;
+    char **json;            // Serialized tasks
+    Task **parsed;          // Tasks parsed back
+    const char *arg;        // Search term or date preset
+    int (*compare)(const void *, const void *);
+    void (*sort)(Task **, size_t);
+    volatile size_t sink;
+} Ctx;
+
+static void run_load(void *p) {
+    Ctx *c = p;
+    c->loaded = storage_load_tasks(&c->loaded_count);
+}
+
+static void reset_load(void *p) {
+    Ctx *c = p;
+    storage_free_tasks(c->loaded, c->loaded_count);
+    c->loaded = NULL;
+}
+
+static void run_save(void *p) {
+    Ctx *c = p;
+    c->sink += storage_save_tasks(c->tasks, c->count) == 0;
+}
+
+static void run_to_json(void *p) {
+    Ctx *c = p;
+    for (size_t i = 0; i < c->count; i++) c->json[i] = task_to_json(c->tasks[i]);
+}
+
+static void reset_to_json(void *p) {
+    Ctx *c = p;
+    for (size_t i = 0; i < c->count; i++) {
+        free(c->json[i]);
+        c->json[i] = NULL;
+    }
+}
+
+static void run_from_json(void *p) {
+    Ctx *c = p;
+    for (size_t i = 0; i < c->count; i++) c->parsed[i] = task_from_json(c->json[i]);
+}
+
+static void reset_from_json(void *p) {
+    Ctx *c = p;
+    for (size_t i = 0; i < c->count; i++) {
+        task_free(c->parsed[i]);
+        c->parsed[i] = NULL;
+    }
+}
+
+static void run_search(void *p) {
+    Ctx *c = p;
+    for (int i = 0; i < FILTER_PASSES; i++) {
+        c->sink += task_manager_filter_by_search(c->tasks, c->count, c->arg, c->work);
+    }
+}
+
+static void run_date_preset(void *p) {
+    Ctx *c = p;
+    for (int i = 0; i < FILTER_PASSES; i++) {
+        c->sink += task_manager_filter_by_date_preset(c->tasks, c->count, c->arg, c->work);
+    }
+}
+
+static void run_sort(void *p) {
+    Ctx *c = p;
+    if (c->sort) c->sort(c->work, c->count);
+    else qsort(c->work, c->count, sizeof(Task *), c->compare);
+}
+
+// Put the scratch array back in load order before the next sort
+static void reset_sort(void *p) {
+    Ctx *c = p;
+    memcpy(c->work, c->tasks, c->count * sizeof(Task *));
+}
+
+static void run_draw(void *p) {
+    Ctx *c = p;
+    for (int i = 0; i < DRAW_FRAMES; i++) ui_draw_tasks(c->tasks, c->count, c->count / 2);
+}
+
+// Helper: a curses screen writing to /dev/null, so drawing needs no terminal
+static SCREEN *headless_screen(void) {
+    FILE *out = fopen("/dev/null", "w");
+    FILE *in = fopen("/dev/null", "r");
+    SCREEN *screen = (out && in) ? newterm("xterm-256color", out, in) : NULL;
+    if (!screen) return NULL;
+    set_term(screen);
+    resizeterm(50, 160);
+    if (has_colors()) start_color();
+    return screen;
+}
+
+int main(int argc, char **argv) {
+    size_t n = DEFAULT_TASKS;
+    int reps = DEFAULT_REPS, warmup = DEFAULT_WARMUP;
+    const char *json_path = NULL, *filter = NULL;
+    for (int i = 1; i < argc; i++) {
+        const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "--tasks") == 0 && val) n = (size_t)atol(argv[++i]);
+        else if (strcmp(argv[i], "--reps") == 0 && val) reps = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--warmup") == 0 && val) warmup = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--filter") == 0 && val) filter = argv[++i];
+        else if (strcmp(argv[i], "--json") == 0 && val) json_path = argv[++i];
+        else {
+            fprintf(stderr, "Usage: bench_micro [--tasks N] [--reps N] [--warmup N] [--filter TEXT] [--json FILE|-]\n");
+            return 2;
+        }
+    }
+    if (n == 0) n = DEFAULT_TASKS;
+
+    char home[] = "/tmp/smartodo-bench-XXXXXX";
+    if (!mkdtemp(home)) return 1;
+    setenv("HOME", home, 1);
+    daemon_client_set_enabled(false);
+
+    DatasetSpec spec;
+    dataset_default_spec(&spec);
+    spec.count = n;
+    app_clock_set_fixed(spec.base);
+    size_t count = 0;
+    Task **generated = dataset_generate(&spec, &count);
+    if (!generated || storage_write_snapshot(generated, count) != 0) return 1;
+    storage_free_tasks(generated, count);
+
+    Ctx ctx = {0};
+    ctx.tasks = storage_load_tasks(&ctx.count);
+    ctx.work = malloc((n + 1) * sizeof(Task *));
+    ctx.json = calloc(n, sizeof(char *));
+    ctx.parsed = calloc(n, sizeof(Task *));
+    Harness *h = harness_create("micro", warmup, reps);
+    if (!ctx.tasks || ctx.count != n || !ctx.work || !ctx.json || !ctx.parsed || !h) return 1;
+    harness_set_param(h, "tasks", (double)n);
+    memcpy(ctx.work, ctx.tasks, n * sizeof(Task *));
+
+    // The JSON strings task_from_json parses
+    run_to_json(&ctx);
+
+    SCREEN *screen = headless_screen();
+    const HarnessBench benches[] = {
+        {"storage_load_tasks", n, run_load, reset_load, &ctx},
+        {"storage_save_tasks", n, run_save, NULL, &ctx},
+        {"task_from_json", n, run_from_json, reset_from_json, &ctx},
+        {"task_to_json", n, run_to_json, reset_to_json, &ctx},
+        {"filter_by_search", n * FILTER_PASSES, run_search, NULL, &ctx},
+        {"filter_by_date_preset/overdue", n * FILTER_PASSES, run_date_preset, NULL, &ctx},
+        {"filter_by_date_preset/this_week", n * FILTER_PASSES, run_date_preset, NULL, &ctx},
+        {"sort_by_name", n, run_sort, reset_sort, &ctx},
+        {"sort_by_due", n, run_sort, reset_sort, &ctx},
+        {"sort_by_creation", n, run_sort, reset_sort, &ctx},
+        {"ui_draw_tasks", DRAW_FRAMES, run_draw, NULL, &ctx},
+    };
+    int rc = 0;
+    for (size_t i = 0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+        const char *name = benches[i].name;
+        if (filter && !strstr(name, filter)) continue;
+        if (strcmp(name, "ui_draw_tasks") == 0 && !screen) {
+            fprintf(stderr, "No terminal description for a headless screen; ui_draw_tasks skipped\n");
+            continue;
+        }
+        ctx.arg = strcmp(name, "filter_by_search") == 0 ? "report"
+                : strstr(name, "/overdue") ? "overdue" : "this_week";
+        ctx.sort = strcmp(name, "sort_by_name") == 0 ? task_manager_sort_by_name
+                 : strcmp(name, "sort_by_due") == 0 ? task_manager_sort_by_due : NULL;
+        ctx.compare = task_compare_by_creation;
+        // task_to_json overwrites the strings: free them first, rebuild them after
+        if (strcmp(name, "task_to_json") == 0) reset_to_json(&ctx);
+        if (harness_run(h, &benches[i]) != 0) rc = 1;
+        if (strcmp(name, "task_to_json") == 0) run_to_json(&ctx);
+    }
+    if (screen) {
+        endwin();
+        delscreen(screen);
+    }
+
+    if (!json_path || strcmp(json_path, "-") != 0) {
+        printf("Microbenchmarks (%zu tasks, median and p99 of %d runs after %d warmup)\n", n, reps, warmup);
+        harness_print(h, stdout);
+    }
+    if (json_path && harness_write_json(h, json_path) != 0) rc = 1;
+
+    harness_free(h);
+    reset_to_json(&ctx);
+    storage_free_tasks(ctx.tasks, ctx.count);
+    free(ctx.work);
+    free(ctx.json);
+    free(ctx.parsed);
+
+    char cmd[256];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", home);
+    system(cmd);
+    return rc;
+}
@@ -0,0 +1,68 @@
+// Reminder queue scaling: schedule, reschedule and fire N reminders.
+#include "../src/reminder.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define DEFAULT_REMINDERS 100000
+
+// Helper: wall-clock seconds as a double
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Helper: print one result line
+static void report(const char *name, long iterations, double elapsed) {
+    printf("%-28s %10.1f ns/op %12.0f ops/sec\n", name,
+           elapsed * 1e9 / (double)iterations, (double)iterations / elapsed);
+}
+
+// Helper: count fired reminders
+static void count_fire(const char *key, time_t fire_at, void *data, void *user) {
+    (void)key;
+    (void)fire_at;
+    (void)data;
+    (*(long *)user)++;
+}
+
+int main(int argc, char **argv) {
+    long n = argc > 1 ? atol(argv[1]) : DEFAULT_REMINDERS;
+    if (n <= 0) n = DEFAULT_REMINDERS;
+
+    char (*keys)[24] = malloc((size_t)n * sizeof(*keys));
+    ReminderQueue *q = reminder_queue_create();
+    if (!keys || !q) return 1;
+    for (long i = 0; i < n; ++i) snprintf(keys[i], sizeof(keys[i]), "task-%08ld", i);
+
+    // Fire times spread over one year
+    unsigned int seed = 12345;
+    double start;
+
+    printf("Reminder queue benchmark (%ld reminders)\n", n);
+
+    start = now_seconds();
+    for (long i = 0; i < n; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        reminder_queue_schedule(q, keys[i], (time_t)(1767225600LL + seed % 31536000u), NULL);
+    }
+    report("schedule", n, now_seconds() - start);
+
+    start = now_seconds();
+    for (long i = 0; i < n; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        reminder_queue_schedule(q, keys[(long)(seed % (unsigned int)n)],
+                                (time_t)(1767225600LL + (seed >> 8) % 31536000u), NULL);
+    }
+    report("reschedule", n, now_seconds() - start);
+
+    long fired = 0;
+    start = now_seconds();
+    reminder_queue_pop_due(q, 1767225600LL + 31536000LL, count_fire, &fired);
+    report("fire", n, now_seconds() - start);
+
+    reminder_queue_free(q);
+    free(keys);
+    return fired == n ? 0 : 1;
+}
@@ -0,0 +1,57 @@
+// Local-day computation throughput: tz_cache_local_day() against localtime_r.
+#include "../src/tz_cache.h"
+#include "../src/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define DEFAULT_ITERATIONS 2000000
+#define SAMPLE_COUNT 1024
+
+// Helper: wall-clock seconds as a double
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Helper: print one result line
+static void report(const char *name, long iterations, double elapsed) {
+    printf("%-28s %10.1f ns/op %12.0f ops/sec\n", name,
+           elapsed * 1e9 / (double)iterations, (double)iterations / elapsed);
+}
+
+int main(int argc, char **argv) {
+    long iterations = argc > 1 ? atol(argv[1]) : DEFAULT_ITERATIONS;
+    if (iterations <= 0) iterations = DEFAULT_ITERATIONS;
+
+    // Due dates spread over +/- one year around a fixed instant
+    static time_t samples[SAMPLE_COUNT];
+    unsigned int seed = 12345;
+    for (int i = 0; i < SAMPLE_COUNT; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        samples[i] = (time_t)(1767225600LL - 31536000LL + (long long)(seed % 63072000u));
+    }
+
+    volatile long long sink = 0;
+    double start;
+
+    printf("Local day benchmark (%ld iterations)\n", iterations);
+
+    start = now_seconds();
+    for (long i = 0; i < iterations; ++i) {
+        sink += tz_cache_local_day(samples[i % SAMPLE_COUNT]);
+    }
+    report("local day (tz_cache)", iterations, now_seconds() - start);
+
+    start = now_seconds();
+    for (long i = 0; i < iterations; ++i) {
+        struct tm tm;
+        time_t t = samples[i % SAMPLE_COUNT];
+        localtime_r(&t, &tm);
+        sink += utils_days_from_civil(tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+    }
+    report("local day (localtime_r)", iterations, now_seconds() - start);
+
+    return sink == 42 ? 1 : 0;
+}
@@ -0,0 +1,226 @@
+// Synthetic task sets; see dataset.h
+#include "dataset.h"
+#include "../src/storage.h"
+#include "../src/utils.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DAY 86400
+
+static const char *const VERBS[] = {
+    "Write", "Review", "Call", "Fix", "Plan", "Update", "Email", "Buy", "Prepare", "Schedule",
+    "Clean", "Book", "Send", "Read", "Draft", "Test", "Order", "Pay", "Check", "Organize",
+};
+static const char *const NOUNS[] = {
+    "report", "budget", "dentist", "invoice", "slides", "release notes", "groceries", "car service",
+    "contract", "newsletter", "backlog", "flight", "garden", "tax return", "design doc", "kitchen",
+    "proposal", "meeting notes", "birthday gift", "quarterly review",
+};
+static const char *const WORDS[] = {
+    "the", "and", "before", "after", "check", "with", "team", "client", "follow", "up",
+    "remember", "ask", "about", "numbers", "draft", "final", "version", "details", "deadline", "link",
+    "call", "back", "notes", "from", "last", "week", "see", "attached", "list", "maybe",
+};
+static const char *const RULES[] = {"daily", "weekly", "weekdays", "monthly", "yearly"};
+
+#define COUNT_OF(a) (sizeof(a) / sizeof((a)[0]))
+
+// splitmix64: small, fast and good enough for test data
+typedef struct {
+    uint64_t state;
+} Rng;
+
+// Helper: next 64 random bits
+static uint64_t rng_next(Rng *r) {
+    uint64_t z = (r->state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Helper: uniform in [0, 1)
+static double rng_unit(Rng *r) {
+    return (double)(rng_next(r) >> 11) / 9007199254740992.0;
+}
+
+// Helper: uniform in [0, n)
+static size_t rng_below(Rng *r, size_t n) {
+    return n ? (size_t)(rng_unit(r) * (double)n) : 0;
+}
+
+// Helper: true with probability p
+static int rng_chance(Rng *r, double p) {
+    return rng_unit(r) < p;
+}
+
+// Helper: exponential with the given mean
+static double rng_exponential(Rng *r, double mean) {
+    return -mean * log(1.0 - rng_unit(r));
+}
+
+// Helper: standard normal (Box-Muller)
+static double rng_normal(Rng *r) {
+    double u = 1.0 - rng_unit(r);
+    double v = rng_unit(r);
+    return sqrt(-2.0 * log(u)) * cos(6.283185307179586 * v);
+}
+
+// Helper: index in [0, n) skewed toward 0, so a few projects and tags are
+// large and most are small, as in real lists
+static size_t rng_skewed(Rng *r, size_t n) {
+    double u = rng_unit(r);
+    return (size_t)(u * u * (double)n);
+}
+
+void dataset_default_spec(DatasetSpec *spec) {
+    memset(spec, 0, sizeof(*spec));
+    spec->seed = 1;
+    spec->count = 10000;
+    spec->projects = 8;
+    spec->tags = 20;
+    spec->max_tags = 3;
+    spec->base = 1792310400;   // 2026-10-18
+    spec->due_ratio = 0.7;
+    spec->due_dist = DATASET_DUE_UNIFORM;
+    spec->due_days = 60;
+    spec->datetime_ratio = 0.3;
+    spec->note_ratio = 0.2;
+    spec->note_mean = 80;
+    spec->done_ratio = 0.3;
+    spec->recur_ratio = 0.02;
+}
+
+int dataset_parse_due_dist(const char *name, DatasetDueDist *dist) {
+    if (strcmp(name, "uniform") == 0) *dist = DATASET_DUE_UNIFORM;
+    else if (strcmp(name, "normal") == 0) *dist = DATASET_DUE_NORMAL;
+    else if (strcmp(name, "overdue") == 0) *dist = DATASET_DUE_OVERDUE;
+    else return -1;
+    return 0;
+}
+
+// Helper: due date offset from the base, in days
+static double due_offset(Rng *r, const DatasetSpec *spec) {
+    switch (spec->due_dist) {
+        case DATASET_DUE_NORMAL:
+            return rng_normal(r) * spec->due_days;
+        case DATASET_DUE_OVERDUE:
+            // Nine in ten in the past
+            return rng_chance(r, 0.9) ? -rng_exponential(r, spec->due_days)
+                                      : rng_unit(r) * spec->due_days;
+        case DATASET_DUE_UNIFORM:
+        default:
+            return (rng_unit(r) * 2.0 - 1.0) * spec->due_days;
+    }
+}
+
+// Helper: a note of about the given length, from filler words
+static char *make_note(Rng *r, size_t length) {
+    if (length >= MAX_NOTE_LEN) length = MAX_NOTE_LEN - 1;
+    char *note = utils_malloc(length + 1);
+    if (!note) return NULL;
+    size_t n = 0;
+    while (n < length) {
+        const char *word = WORDS[rng_below(r, COUNT_OF(WORDS))];
+        size_t len = strlen(word);
+        if (n + len + 1 > length) break;
+        if (n > 0) note[n++] = ' ';
+        memcpy(note + n, word, len);
+        n += len;
+    }
+    note[n] = '\0';
+    return note;
+}
+
+// Helper: build one task; ids come from the generator so runs repeat exactly
+static Task *make_task(Rng *r, const DatasetSpec *spec, size_t i) {
+    char name[96];
+    snprintf(name, sizeof(name), "%s %s %zu", VERBS[rng_below(r, COUNT_OF(VERBS))],
+             NOUNS[rng_below(r, COUNT_OF(NOUNS))], i);
+
+    char tag_names[MAX_TAGS][16];
+    const char *tags[MAX_TAGS];
+    size_t max_tags = spec->max_tags < MAX_TAGS ? spec->max_tags : MAX_TAGS;
+    size_t tag_count = spec->tags ? rng_below(r, max_tags + 1) : 0;
+    size_t used = 0;
+    for (size_t k = 0; k < tag_count; k++) {
+        snprintf(tag_names[used], sizeof(tag_names[used]), "t%zu", rng_skewed(r, spec->tags));
+        bool seen = false;
+        for (size_t j = 0; j < used; j++) seen = seen || strcmp(tag_names[j], tag_names[used]) == 0;
+        if (!seen) {
+            tags[used] = tag_names[used];
+            used++;
+        }
+    }
+
+    uint64_t prio = rng_next(r) % 10;
+    Priority priority = prio < 5 ? PRIORITY_LOW : prio < 8 ? PRIORITY_MEDIUM : PRIORITY_HIGH;
+    Task *t = task_create(name, 0, DUE_NONE, tags, used, priority);
+    if (!t) return NULL;
+
+    uint64_t a = rng_next(r), b = rng_next(r);
+    char id[37];
+    snprintf(id, sizeof(id), "%08x-%04x-4%03x-%04x-%012llx", (unsigned)(a >> 32), (unsigned)(a >> 16) & 0xffffu,
+             (unsigned)a & 0xfffu, 0x8000u | ((unsigned)(b >> 48) & 0x3fffu),
+             (unsigned long long)(b & 0xffffffffffffULL));
+    char project[32];
+    snprintf(project, sizeof(project), "p%zu", spec->projects ? rng_skewed(r, spec->projects) : 0);
+    char *id_copy = utils_strdup(id);
+    char *project_copy = utils_strdup(project);
+    if (!id_copy || !project_copy) {
+        free(id_copy);
+        free(project_copy);
+        task_free(t);
+        return NULL;
+    }
+    free(t->id);
+    t->id = id_copy;
+    free(t->project);
+    t->project = project_copy;
+
+    // Created up to half a year before the base
+    t->created = spec->base - (time_t)(rng_unit(r) * 182 * DAY);
+    if (rng_chance(r, spec->due_ratio)) {
+        long long day = spec->base / DAY + (long long)floor(due_offset(r, spec));
+        if (rng_chance(r, spec->datetime_ratio)) {
+            // A quarter hour between 8:00 and 18:00 UTC
+            task_set_due(t, (time_t)(day * DAY + 8 * 3600 + (long long)rng_below(r, 40) * 900), DUE_DATETIME);
+        } else {
+            task_set_due(t, (time_t)(day * DAY), DUE_DATE);
+        }
+    }
+    if (rng_chance(r, spec->note_ratio)) {
+        char *note = make_note(r, (size_t)rng_exponential(r, spec->note_mean) + 1);
+        int rc = note ? task_set_note(t, note) : -1;
+        free(note);
+        if (rc != 0) {
+            task_free(t);
+            return NULL;
+        }
+    }
+    if (rng_chance(r, spec->done_ratio)) {
+        t->status = STATUS_DONE;
+    } else if (t->due && rng_chance(r, spec->recur_ratio)
+               && task_set_recurrence(t, RULES[rng_below(r, COUNT_OF(RULES))]) != 0) {
+        task_free(t);
+        return NULL;
+    }
+    return t;
+}
+
+Task **dataset_generate(const DatasetSpec *spec, size_t *count) {
+    Task **tasks = utils_malloc((spec->count + 1) * sizeof(Task *));
+    if (!tasks) return NULL;
+    Rng r = {spec->seed};
+    for (size_t i = 0; i < spec->count; i++) {
+        tasks[i] = make_task(&r, spec, i);
+        if (!tasks[i]) {
+            storage_free_tasks(tasks, i);
+            return NULL;
+        }
+    }
+    tasks[spec->count] = NULL;
+    *count = spec->count;
+    return tasks;
+}
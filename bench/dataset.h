@@ -0,0 +1,63 @@
+#ifndef TODO_APP_DATASET_H
+#define TODO_APP_DATASET_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include "../src/task.h"
+
+/**
+ * Synthetic task sets for benchmarks and for reproducing performance
+ * problems. Tasks are built with task_create() and the setters in task.h,
+ * so they look like tasks the app made. Every random choice comes from one
+ * seeded generator: the same spec gives the same tasks, ids included.
+ */
+
+// How due dates are spread around the spec's base time
+typedef enum {
+    DATASET_DUE_UNIFORM,     // Evenly over [-due_days, +due_days]
+    DATASET_DUE_NORMAL,      // Bell curve centered on the base, due_days wide (one sigma)
+    DATASET_DUE_OVERDUE      // Mostly past: exponential back from the base, mean due_days
+} DatasetDueDist;
+
+typedef struct {
+    uint64_t seed;
+    size_t count;            // Tasks to generate
+    size_t projects;         // Distinct projects (p0, p1, ...); skewed, p0 largest
+    size_t tags;             // Distinct tags (t0, t1, ...)
+    size_t max_tags;         // Most tags on one task (at most MAX_TAGS)
+    time_t base;             // "Now" of the data set; created and due are around it
+    double due_ratio;        // Fraction of tasks with a due date
+    DatasetDueDist due_dist;
+    double due_days;         // Spread of due dates in days
+    double datetime_ratio;   // Fraction of due dates with a time of day
+    double note_ratio;       // Fraction of tasks with a note
+    double note_mean;        // Mean note length in characters (exponential)
+    double done_ratio;       // Fraction of tasks done
+    double recur_ratio;      // Fraction of tasks recurring
+} DatasetSpec;
+
+/**
+ * Fill a spec with the defaults: 10000 tasks over 8 projects and 20 tags,
+ * 70% with a due date, 20% with a note, 30% done, seed 1.
+ * @param spec[out] Spec to fill
+ */
+void dataset_default_spec(DatasetSpec *spec);
+
+/**
+ * Generate a task set.
+ * @param spec What to generate
+ * @param count[out] Number of tasks
+ * @return NULL-terminated task array (free with storage_free_tasks()), or NULL on error
+ */
+Task **dataset_generate(const DatasetSpec *spec, size_t *count);
+
+/**
+ * Parse a due distribution name: uniform, normal or overdue.
+ * @param name Name
+ * @param dist[out] Distribution
+ * @return 0 on success, -1 if the name is unknown
+ */
+int dataset_parse_due_dist(const char *name, DatasetDueDist *dist);
+
+#endif // TODO_APP_DATASET_H
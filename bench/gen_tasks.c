@@ -0,0 +1,160 @@
+// Writes a synthetic task set (dataset.h) into a storage directory, so
+// performance problems can be reproduced on lists of any size:
+//   gen_tasks --home /tmp/big --count 1000000 --seed 7
+//   HOME=/tmp/big ../src/smartodo list --overdue
+#include "dataset.h"
+#include "../src/storage.h"
+#include "../src/daemon_client.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_COUNT 10000000
+
+// Helper: wall-clock seconds as a double
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void usage(void) {
+    fprintf(stderr,
+            "Usage: gen_tasks [--home DIR] [--count N] [--seed N] [--projects N] [--tags N]\n"
+            "                 [--max-tags N] [--due-ratio R] [--due-dist uniform|normal|overdue]\n"
+            "                 [--due-days D] [--note-ratio R] [--note-mean CHARS] [--done-ratio R]\n"
+            "                 [--recur-ratio R] [--base EPOCH] [--journal] [--force]\n"
+            "Writes HOME/.todo-app/tasks.json (and projects.json); with --journal every task is\n"
+            "also journaled as an add, as if entered one by one.\n");
+}
+
+// Helper: parse a count option
+static bool parse_size(const char *s, size_t min, size_t max, size_t *out) {
+    char *end = NULL;
+    unsigned long long v = strtoull(s, &end, 10);
+    if (!end || *end != '\0' || s[0] == '-' || v < min || v > max) return false;
+    *out = (size_t)v;
+    return true;
+}
+
+// Helper: parse a ratio or other non-negative number option
+static bool parse_number(const char *s, double max, double *out) {
+    char *end = NULL;
+    double v = strtod(s, &end);
+    if (!end || *end != '\0' || v < 0 || v > max) return false;
+    *out = v;
+    return true;
+}
+
+int main(int argc, char **argv) {
+    DatasetSpec spec;
+    dataset_default_spec(&spec);
+    bool journal = false, force = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char *opt = argv[i];
+        if (strcmp(opt, "--journal") == 0) {
+            journal = true;
+            continue;
+        }
+        if (strcmp(opt, "--force") == 0) {
+            force = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            usage();
+            return 2;
+        }
+        const char *val = argv[++i];
+        size_t n = 0;
+        bool ok;
+        if (strcmp(opt, "--home") == 0) {
+            ok = setenv("HOME", val, 1) == 0;
+        } else if (strcmp(opt, "--count") == 0) {
+            ok = parse_size(val, 1, MAX_COUNT, &spec.count);
+        } else if (strcmp(opt, "--seed") == 0) {
+            ok = parse_size(val, 0, SIZE_MAX, &n);
+            spec.seed = n;
+        } else if (strcmp(opt, "--projects") == 0) {
+            ok = parse_size(val, 1, 1000000, &spec.projects);
+        } else if (strcmp(opt, "--tags") == 0) {
+            ok = parse_size(val, 0, 1000000, &spec.tags);
+        } else if (strcmp(opt, "--max-tags") == 0) {
+            ok = parse_size(val, 0, MAX_TAGS, &spec.max_tags);
+        } else if (strcmp(opt, "--due-ratio") == 0) {
+            ok = parse_number(val, 1, &spec.due_ratio);
+        } else if (strcmp(opt, "--due-dist") == 0) {
+            ok = dataset_parse_due_dist(val, &spec.due_dist) == 0;
+        } else if (strcmp(opt, "--due-days") == 0) {
+            ok = parse_number(val, 36500, &spec.due_days);
+        } else if (strcmp(opt, "--note-ratio") == 0) {
+            ok = parse_number(val, 1, &spec.note_ratio);
+        } else if (strcmp(opt, "--note-mean") == 0) {
+            ok = parse_number(val, MAX_NOTE_LEN, &spec.note_mean);
+        } else if (strcmp(opt, "--done-ratio") == 0) {
+            ok = parse_number(val, 1, &spec.done_ratio);
+        } else if (strcmp(opt, "--recur-ratio") == 0) {
+            ok = parse_number(val, 1, &spec.recur_ratio);
+        } else if (strcmp(opt, "--base") == 0) {
+            double base = 0;
+            ok = parse_number(val, 4102444800.0, &base);
+            spec.base = (time_t)base;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            usage();
+            return 2;
+        }
+    }
+
+    // Write the files directly even if a daemon serves this HOME
+    daemon_client_set_enabled(false);
+    char *path = storage_tasks_path();
+    if (!path || storage_init() != 0) {
+        fprintf(stderr, "Cannot use the storage directory (is HOME set?)\n");
+        free(path);
+        return 1;
+    }
+    if (!force && access(path, F_OK) == 0) {
+        fprintf(stderr, "%s exists; pass --force to replace it\n", path);
+        free(path);
+        return 1;
+    }
+
+    double start = now_seconds();
+    size_t count = 0;
+    Task **tasks = dataset_generate(&spec, &count);
+    if (!tasks) {
+        fprintf(stderr, "Out of memory generating %zu tasks\n", spec.count);
+        free(path);
+        return 1;
+    }
+    double generated = now_seconds();
+
+    int rc = journal ? storage_save_tasks(tasks, count) : storage_write_snapshot(tasks, count);
+    char **projects = malloc(spec.projects * sizeof(char *));
+    size_t project_count = 0;
+    for (size_t i = 0; projects && rc == 0 && i < spec.projects; i++) {
+        char name[32];
+        snprintf(name, sizeof(name), "p%zu", i);
+        if (!(projects[project_count] = strdup(name))) break;
+        project_count++;
+    }
+    if (rc == 0 && (project_count != spec.projects || storage_save_projects(projects, project_count) != 0)) rc = -1;
+    for (size_t i = 0; i < project_count; i++) free(projects[i]);
+    free(projects);
+    storage_free_tasks(tasks, count);
+    if (rc != 0) {
+        fprintf(stderr, "Failed to write %s\n", path);
+        free(path);
+        return 1;
+    }
+    printf("Wrote %zu tasks to %s (seed %llu): generated in %.2f s, saved in %.2f s\n", count, path,
+           (unsigned long long)spec.seed, generated - start, now_seconds() - generated);
+    free(path);
+    return 0;
+}
@@ -0,0 +1,228 @@
+// Microbenchmark harness; see harness.h
+#include "harness.h"
+#include <cjson/cJSON.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+    char *name;
+    size_t ops;
+    double *samples;             // Run times in ns, sorted
+    double bytes_per_op;         // -1 if not counted
+    double allocs_per_op;
+} HarnessResult;
+
+typedef struct {
+    char *name;
+    double value;
+} HarnessParam;
+
+struct Harness {
+    char *suite;
+    int warmup;
+    int reps;
+    HarnessResult *results;
+    size_t result_count;
+    HarnessParam *params;
+    size_t param_count;
+};
+
+static atomic_ullong alloc_bytes;
+static atomic_ullong alloc_count;
+
+#ifdef __GLIBC__
+// Interpose the allocator for the whole process, libraries included, and
+// hand the calls on to glibc's own entry points
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size) {
+    atomic_fetch_add_explicit(&alloc_bytes, size, memory_order_relaxed);
+    atomic_fetch_add_explicit(&alloc_count, 1, memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size) {
+    atomic_fetch_add_explicit(&alloc_bytes, nmemb * size, memory_order_relaxed);
+    atomic_fetch_add_explicit(&alloc_count, 1, memory_order_relaxed);
+    return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    atomic_fetch_add_explicit(&alloc_bytes, size, memory_order_relaxed);
+    atomic_fetch_add_explicit(&alloc_count, 1, memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+
+bool harness_counts_allocations(void) {
+    return true;
+}
+#else
+bool harness_counts_allocations(void) {
+    return false;
+}
+#endif
+
+// Helper: monotonic time in ns
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// Helper: order samples
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Helper: value at a quantile of sorted samples (nearest rank)
+static double quantile(const double *sorted, int n, double q) {
+    int rank = (int)(q * n + 0.999999);
+    if (rank < 1) rank = 1;
+    if (rank > n) rank = n;
+    return sorted[rank - 1];
+}
+
+// Helper: median of sorted samples
+static double median(const double *sorted, int n) {
+    return n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2.0;
+}
+
+Harness *harness_create(const char *suite, int warmup, int reps) {
+    Harness *h = calloc(1, sizeof(Harness));
+    if (!h) return NULL;
+    h->suite = strdup(suite);
+    h->warmup = warmup < 0 ? 0 : warmup;
+    h->reps = reps < 1 ? 1 : reps;
+    if (!h->suite) {
+        free(h);
+        return NULL;
+    }
+    return h;
+}
+
+void harness_set_param(Harness *h, const char *name, double value) {
+    HarnessParam *grown = realloc(h->params, (h->param_count + 1) * sizeof(HarnessParam));
+    if (!grown) return;
+    h->params = grown;
+    if ((grown[h->param_count].name = strdup(name)) != NULL) {
+        grown[h->param_count++].value = value;
+    }
+}
+
+int harness_run(Harness *h, const HarnessBench *bench) {
+    HarnessResult *grown = realloc(h->results, (h->result_count + 1) * sizeof(HarnessResult));
+    if (!grown) return -1;
+    h->results = grown;
+    HarnessResult *r = &h->results[h->result_count];
+    memset(r, 0, sizeof(*r));
+    r->name = strdup(bench->name);
+    r->samples = malloc((size_t)h->reps * sizeof(double));
+    if (!r->name || !r->samples) {
+        free(r->name);
+        free(r->samples);
+        return -1;
+    }
+    r->ops = bench->ops ? bench->ops : 1;
+
+    for (int i = 0; i < h->warmup; i++) {
+        bench->run(bench->ctx);
+        if (bench->reset) bench->reset(bench->ctx);
+    }
+    unsigned long long bytes = 0, count = 0;
+    for (int i = 0; i < h->reps; i++) {
+        unsigned long long bytes0 = atomic_load(&alloc_bytes);
+        unsigned long long count0 = atomic_load(&alloc_count);
+        double start = now_ns();
+        bench->run(bench->ctx);
+        r->samples[i] = now_ns() - start;
+        bytes += atomic_load(&alloc_bytes) - bytes0;
+        count += atomic_load(&alloc_count) - count0;
+        if (bench->reset) bench->reset(bench->ctx);
+    }
+    qsort(r->samples, (size_t)h->reps, sizeof(double), compare_doubles);
+    double runs_ops = (double)h->reps * (double)r->ops;
+    r->bytes_per_op = harness_counts_allocations() ? (double)bytes / runs_ops : -1;
+    r->allocs_per_op = harness_counts_allocations() ? (double)count / runs_ops : -1;
+    h->result_count++;
+    return 0;
+}
+
+void harness_print(const Harness *h, FILE *out) {
+    fprintf(out, "%-32s %12s %12s %14s %12s %10s\n", "benchmark", "median", "p99", "ops/sec", "bytes/op", "allocs/op");
+    for (size_t i = 0; i < h->result_count; i++) {
+        const HarnessResult *r = &h->results[i];
+        double med = median(r->samples, h->reps);
+        fprintf(out, "%-32s %9.3f ms %9.3f ms %14.0f ", r->name, med / 1e6,
+                quantile(r->samples, h->reps, 0.99) / 1e6, (double)r->ops / (med / 1e9));
+        if (r->bytes_per_op >= 0) fprintf(out, "%12.1f %10.2f\n", r->bytes_per_op, r->allocs_per_op);
+        else fprintf(out, "%12s %10s\n", "-", "-");
+    }
+}
+
+int harness_write_json(const Harness *h, const char *path) {
+    cJSON *root = cJSON_CreateObject();
+    if (!root) return -1;
+    cJSON_AddStringToObject(root, "suite", h->suite);
+    cJSON *params = cJSON_AddObjectToObject(root, "params");
+    for (size_t i = 0; params && i < h->param_count; i++) {
+        cJSON_AddNumberToObject(params, h->params[i].name, h->params[i].value);
+    }
+    cJSON_AddNumberToObject(root, "warmup", h->warmup);
+    cJSON_AddNumberToObject(root, "reps", h->reps);
+    cJSON *results = cJSON_AddArrayToObject(root, "results");
+    for (size_t i = 0; results && i < h->result_count; i++) {
+        const HarnessResult *r = &h->results[i];
+        double med = median(r->samples, h->reps);
+        double sum = 0;
+        for (int k = 0; k < h->reps; k++) sum += r->samples[k];
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "name", r->name);
+        cJSON_AddNumberToObject(item, "ops", (double)r->ops);
+        cJSON_AddNumberToObject(item, "median_ns", med);
+        cJSON_AddNumberToObject(item, "p99_ns", quantile(r->samples, h->reps, 0.99));
+        cJSON_AddNumberToObject(item, "min_ns", r->samples[0]);
+        cJSON_AddNumberToObject(item, "mean_ns", sum / h->reps);
+        cJSON_AddNumberToObject(item, "ops_per_sec", (double)r->ops / (med / 1e9));
+        if (r->bytes_per_op >= 0) {
+            cJSON_AddNumberToObject(item, "bytes_per_op", r->bytes_per_op);
+            cJSON_AddNumberToObject(item, "allocs_per_op", r->allocs_per_op);
+        } else {
+            cJSON_AddNullToObject(item, "bytes_per_op");
+            cJSON_AddNullToObject(item, "allocs_per_op");
+        }
+        cJSON *samples = cJSON_AddArrayToObject(item, "samples_ns");
+        for (int k = 0; samples && k < h->reps; k++) {
+            cJSON_AddItemToArray(samples, cJSON_CreateNumber(r->samples[k]));
+        }
+        cJSON_AddItemToArray(results, item);
+    }
+    char *json = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    if (!json) return -1;
+
+    bool to_stdout = strcmp(path, "-") == 0;
+    FILE *f = to_stdout ? stdout : fopen(path, "w");
+    int rc = f && fprintf(f, "%s\n", json) >= 0 ? 0 : -1;
+    if (f && !to_stdout && fclose(f) != 0) rc = -1;
+    free(json);
+    return rc;
+}
+
+void harness_free(Harness *h) {
+    if (!h) return;
+    for (size_t i = 0; i < h->result_count; i++) {
+        free(h->results[i].name);
+        free(h->results[i].samples);
+    }
+    for (size_t i = 0; i < h->param_count; i++) free(h->params[i].name);
+    free(h->results);
+    free(h->params);
+    free(h->suite);
+    free(h);
+}
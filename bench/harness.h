@@ -0,0 +1,87 @@
+#ifndef TODO_APP_HARNESS_H
+#define TODO_APP_HARNESS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/**
+ * Microbenchmark harness: each benchmark is run a few times untimed to
+ * warm caches, then timed over a number of repetitions. The results give
+ * the median and p99 run time, operations per second and heap bytes and
+ * allocations per operation. They can be printed as a table or written as
+ * JSON, with the raw samples, for regression tracking.
+ *
+ * Allocations are counted by interposing malloc(), calloc() and realloc()
+ * for the whole process, which is possible on glibc only; elsewhere the
+ * byte counts are reported as unavailable (null in JSON).
+ */
+
+// One benchmark
+typedef struct {
+    const char *name;
+    size_t ops;                  // Operations one run performs (tasks processed, frames drawn)
+    void (*run)(void *ctx);      // Timed
+    void (*reset)(void *ctx);    // Untimed, after each run (may be NULL)
+    void *ctx;
+} HarnessBench;
+
+typedef struct Harness Harness;
+
+/**
+ * Create a harness.
+ * @param suite Name of the suite, recorded in the JSON
+ * @param warmup Untimed runs before the timed ones
+ * @param reps Timed runs
+ * @return New harness (free with harness_free()), or NULL on error
+ */
+Harness *harness_create(const char *suite, int warmup, int reps);
+
+/**
+ * Record a parameter of the suite (task count, ...) in the JSON.
+ * @param h Harness
+ * @param name Parameter name
+ * @param value Value
+ */
+void harness_set_param(Harness *h, const char *name, double value);
+
+/**
+ * Run a benchmark and keep its results.
+ * @param h Harness
+ * @param bench Benchmark
+ * @return 0 on success, -1 on error
+ */
+int harness_run(Harness *h, const HarnessBench *bench);
+
+/**
+ * Print the results as a table.
+ * @param h Harness
+ * @param out Stream to print to
+ */
+void harness_print(const Harness *h, FILE *out);
+
+/**
+ * Write the results as JSON:
+ *   {"suite":S,"params":{...},"warmup":W,"reps":R,"results":[{"name":N,
+ *    "ops":O,"median_ns":M,"p99_ns":P,"min_ns":L,"mean_ns":A,
+ *    "ops_per_sec":X,"bytes_per_op":B|null,"allocs_per_op":C|null,
+ *    "samples_ns":[...]},...]}
+ * @param h Harness
+ * @param path File to write, or "-" for stdout
+ * @return 0 on success, -1 on error
+ */
+int harness_write_json(const Harness *h, const char *path);
+
+/**
+ * Free a harness.
+ * @param h Harness (may be NULL)
+ */
+void harness_free(Harness *h);
+
+/**
+ * Whether allocations are being counted on this platform.
+ * @return true if bytes and allocations per operation are measured
+ */
+bool harness_counts_allocations(void);
+
+#endif // TODO_APP_HARNESS_H
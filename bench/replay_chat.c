@@ -0,0 +1,527 @@
+// Replays recorded AI chat sessions through the real chat loop,
+// ai_chat_repl(), on a headless screen, with the LLM transport replaced by
+// the session's canned answers (llm_set_transport()). A session gives the
+// starting tasks, the keys and commands typed, the model's answer to each
+// command and the tasks expected at the end; a replay that ends elsewhere
+// fails. Each turn's local cost is taken from the loop's tracing spans:
+// building the prompt, parsing the answer and running the action
+// (ai_chat_turn), then redrawing (ai_chat_frame), with the time spent in
+// the transport taken out of both.
+//   replay_chat [--reps N] [SESSION.json ...]     (default: sessions/*.json)
+#include "../src/ai_chat.h"
+#include "../src/llm_api.h"
+#include "../src/storage.h"
+#include "../src/task.h"
+#include "../src/task_manager.h"
+#include "../src/daemon_client.h"
+#include "../src/app_clock.h"
+#include "../src/trace.h"
+#include "../src/utils.h"
+#include <cjson/cJSON.h>
+#include <curses.h>
+#include <glob.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEFAULT_SESSIONS "sessions/*.json"
+#define DEFAULT_REPS 5
+#define MAX_REPS 1000
+#define DEFAULT_SUGGESTION "Start with the smallest step"
+#define REPLAY_TIMEOUT 30          // Seconds a replay may take before it is taken to hang
+#define MAX_DEPTH 64               // Nesting of spans followed when reading the trace
+
+// One command typed into the chat
+typedef struct {
+    char *keys;                    // Keys pressed before Enter (navigation), or NULL
+    char *input;                   // Command typed at the prompt
+    char *response;                // Content of the model's answer
+    bool fail;                     // The transport fails instead of answering
+} Turn;
+
+typedef struct {
+    const char *path;
+    cJSON *doc;
+    time_t now;
+    const char *suggestion;        // Answer to every task suggestion request
+    Turn *turns;
+    size_t turn_count;
+} Session;
+
+// State of the transport during one replay
+typedef struct {
+    const Session *session;
+    size_t next;                   // Turn whose command comes next
+    char error[256];               // First thing that went wrong, or ""
+} Replay;
+
+// Helper: keep the first error of a replay
+static void replay_error(char *error, size_t size, const char *fmt, ...) {
+    if (error[0]) return;
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(error, size, fmt, ap);
+    va_end(ap);
+}
+
+// Helper: a chat completion body answering with content
+static char *completion_body(const char *model, const char *content) {
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "id", "chatcmpl-replay");
+    cJSON_AddStringToObject(root, "object", "chat.completion");
+    cJSON_AddNumberToObject(root, "created", (double)app_clock_now());
+    cJSON_AddStringToObject(root, "model", model ? model : "replay");
+    cJSON *choices = cJSON_AddArrayToObject(root, "choices");
+    cJSON *choice = cJSON_CreateObject();
+    cJSON_AddNumberToObject(choice, "index", 0);
+    cJSON *message = cJSON_AddObjectToObject(choice, "message");
+    cJSON_AddStringToObject(message, "role", "assistant");
+    cJSON_AddStringToObject(message, "content", content);
+    cJSON_AddStringToObject(choice, "finish_reason", "stop");
+    cJSON_AddItemToArray(choices, choice);
+    char *body = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    return body;
+}
+
+// The LLM transport of a replay: suggestion requests get the session's
+// suggestion, commands the answer of their turn, in order
+static int replay_transport(const char *request_json, char **response_body, long *http_status, void *ctx) {
+    Replay *r = ctx;
+    cJSON *request = cJSON_Parse(request_json);
+    const char *model = cJSON_GetStringValue(cJSON_GetObjectItem(request, "model"));
+    const cJSON *messages = cJSON_GetObjectItem(request, "messages");
+    const char *user = cJSON_GetStringValue(cJSON_GetObjectItem(cJSON_GetArrayItem(messages, 1), "content"));
+    const char *content = NULL;
+    if (!user) {
+        replay_error(r->error, sizeof(r->error), "request without a user message");
+    } else if (strncmp(user, "Task: ", 6) == 0) {
+        content = r->session->suggestion;
+    } else if (r->next >= r->session->turn_count) {
+        replay_error(r->error, sizeof(r->error), "unexpected command \"%s\"", user);
+    } else {
+        const Turn *t = &r->session->turns[r->next++];
+        if (strcmp(user, t->input) != 0) {
+            replay_error(r->error, sizeof(r->error), "turn %zu sent \"%s\", expected \"%s\"", r->next, user, t->input);
+        } else if (!t->fail) {
+            content = t->response;
+        }
+    }
+    *response_body = content ? completion_body(model, content) : NULL;
+    *http_status = 200;
+    cJSON_Delete(request);
+    return *response_body ? 0 : -1;
+}
+
+// Helper: read a whole file
+static char *read_file(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    rewind(f);
+    char *data = size >= 0 ? malloc((size_t)size + 1) : NULL;
+    size_t n = data ? fread(data, 1, (size_t)size, f) : 0;
+    fclose(f);
+    if (data) data[n] = '\0';
+    return data;
+}
+
+static void session_free(Session *s) {
+    for (size_t i = 0; i < s->turn_count; i++) {
+        free(s->turns[i].keys);
+        free(s->turns[i].input);
+        free(s->turns[i].response);
+    }
+    free(s->turns);
+    cJSON_Delete(s->doc);
+}
+
+// Helper: load a session file
+static int session_load(const char *path, Session *s) {
+    memset(s, 0, sizeof(*s));
+    s->path = path;
+    char *data = read_file(path);
+    s->doc = data ? cJSON_Parse(data) : NULL;
+    free(data);
+    const char *now = cJSON_GetStringValue(cJSON_GetObjectItem(s->doc, "now"));
+    const cJSON *turns = cJSON_GetObjectItem(s->doc, "turns");
+    if (!now || !utils_parse_iso8601(now, &s->now) || !cJSON_IsArray(turns)) {
+        fprintf(stderr, "%s: not a session (needs \"now\" and \"turns\")\n", path);
+        return -1;
+    }
+    s->suggestion = cJSON_GetStringValue(cJSON_GetObjectItem(s->doc, "suggestion"));
+    if (!s->suggestion) s->suggestion = DEFAULT_SUGGESTION;
+
+    s->turns = calloc((size_t)cJSON_GetArraySize(turns) + 1, sizeof(Turn));
+    if (!s->turns) return -1;
+    const cJSON *item;
+    cJSON_ArrayForEach(item, turns) {
+        Turn *t = &s->turns[s->turn_count++];
+        const char *keys = cJSON_GetStringValue(cJSON_GetObjectItem(item, "keys"));
+        const char *input = cJSON_GetStringValue(cJSON_GetObjectItem(item, "input"));
+        const cJSON *response = cJSON_GetObjectItem(item, "response");
+        t->fail = cJSON_IsTrue(cJSON_GetObjectItem(item, "fail"));
+        if (!input || input[0] == '\0' || strcmp(input, "exit") == 0 || strchr(input, '\n')
+            || (!response && !t->fail)) {
+            fprintf(stderr, "%s: turn %zu needs an \"input\" command and a \"response\"\n", path, s->turn_count);
+            return -1;
+        }
+        t->keys = keys ? strdup(keys) : NULL;
+        t->input = strdup(input);
+        // An answer that is not a string is sent as its JSON text
+        t->response = cJSON_IsString(response) ? strdup(response->valuestring)
+                    : response ? cJSON_PrintUnformatted(response) : NULL;
+    }
+    return 0;
+}
+
+// Helper: write the session's starting tasks and projects; tasks may leave
+// out what the loader requires and get defaults
+static int write_fixture(const Session *s) {
+    const cJSON *items = cJSON_GetObjectItem(s->doc, "tasks");
+    size_t n = (size_t)cJSON_GetArraySize(items);
+    Task **tasks = calloc(n + 1, sizeof(Task *));
+    if (!tasks) return -1;
+    char created[UTILS_ISO8601_BUFSZ];
+    utils_format_iso8601(s->now - 86400, created);
+    size_t count = 0;
+    const cJSON *item;
+    cJSON_ArrayForEach(item, items) {
+        cJSON *obj = cJSON_Duplicate(item, 1);
+        char id[48];
+        snprintf(id, sizeof(id), "00000000-0000-4000-8000-%012zu", count + 1);
+        if (obj && !cJSON_HasObjectItem(obj, "id")) cJSON_AddStringToObject(obj, "id", id);
+        if (obj && !cJSON_HasObjectItem(obj, "created")) cJSON_AddStringToObject(obj, "created", created);
+        if (obj && !cJSON_HasObjectItem(obj, "tags")) cJSON_AddArrayToObject(obj, "tags");
+        if (obj && !cJSON_HasObjectItem(obj, "priority")) cJSON_AddStringToObject(obj, "priority", "low");
+        if (obj && !cJSON_HasObjectItem(obj, "status")) cJSON_AddStringToObject(obj, "status", "pending");
+        if (obj && !cJSON_HasObjectItem(obj, "project")) cJSON_AddStringToObject(obj, "project", "default");
+        tasks[count] = task_from_cjson(obj);
+        cJSON_Delete(obj);
+        if (!tasks[count]) {
+            fprintf(stderr, "%s: task %zu is not a task\n", s->path, count + 1);
+            storage_free_tasks(tasks, count);
+            return -1;
+        }
+        count++;
+    }
+    int rc = storage_write_snapshot(tasks, count);
+    storage_free_tasks(tasks, count);
+
+    char *projects[64] = {"default"};
+    size_t project_count = 0;
+    cJSON_ArrayForEach(item, cJSON_GetObjectItem(s->doc, "projects")) {
+        if (cJSON_IsString(item) && project_count < 64) projects[project_count++] = item->valuestring;
+    }
+    if (rc == 0 && storage_save_projects(projects, project_count ? project_count : 1) != 0) rc = -1;
+    return rc;
+}
+
+// Helper: the task of a name, or NULL
+static Task *find_task(Task **tasks, size_t count, const char *name) {
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(tasks[i]->name, name) == 0) return tasks[i];
+    }
+    return NULL;
+}
+
+// Helper: compare the saved tasks and projects with the session's "expect":
+// a task count, tasks by name with the fields given (as in tasks.json),
+// names that must be gone, and the project list
+static void check_state(const Session *s, char *error, size_t size) {
+    const cJSON *expect = cJSON_GetObjectItem(s->doc, "expect");
+    size_t count = 0;
+    Task **tasks = storage_load_tasks(&count);
+    if (!tasks) {
+        replay_error(error, size, "the tasks could not be loaded back");
+        return;
+    }
+
+    const cJSON *want_count = cJSON_GetObjectItem(expect, "count");
+    if (cJSON_IsNumber(want_count) && (size_t)want_count->valuedouble != count) {
+        replay_error(error, size, "%zu tasks, expected %d", count, want_count->valueint);
+    }
+    const cJSON *want;
+    cJSON_ArrayForEach(want, cJSON_GetObjectItem(expect, "tasks")) {
+        const char *name = cJSON_GetStringValue(cJSON_GetObjectItem(want, "name"));
+        Task *t = name ? find_task(tasks, count, name) : NULL;
+        if (!t) {
+            replay_error(error, size, "no task \"%s\"", name ? name : "(unnamed)");
+            continue;
+        }
+        cJSON *actual = task_to_cjson(t);
+        const cJSON *field;
+        cJSON_ArrayForEach(field, want) {
+            char *w = cJSON_PrintUnformatted(field);
+            const cJSON *a = cJSON_GetObjectItem(actual, field->string);
+            char *got = a ? cJSON_PrintUnformatted(a) : NULL;
+            if (!w || !got || strcmp(w, got) != 0) {
+                replay_error(error, size, "task \"%s\": %s is %s, expected %s", name, field->string,
+                             got ? got : "missing", w ? w : "?");
+            }
+            free(w);
+            free(got);
+        }
+        cJSON_Delete(actual);
+    }
+    cJSON_ArrayForEach(want, cJSON_GetObjectItem(expect, "absent")) {
+        const char *name = cJSON_GetStringValue(want);
+        if (name && find_task(tasks, count, name)) replay_error(error, size, "task \"%s\" is still there", name);
+    }
+    storage_free_tasks(tasks, count);
+
+    const cJSON *want_projects = cJSON_GetObjectItem(expect, "projects");
+    if (cJSON_IsArray(want_projects)) {
+        char **projects = NULL;
+        size_t project_count = storage_load_projects(&projects);
+        bool same = project_count == (size_t)cJSON_GetArraySize(want_projects);
+        for (size_t i = 0; same && i < project_count; i++) {
+            const char *p = cJSON_GetStringValue(cJSON_GetArrayItem(want_projects, (int)i));
+            same = p && strcmp(p, projects[i]) == 0;
+        }
+        if (!same) replay_error(error, size, "the projects are not the expected ones");
+        for (size_t i = 0; i < project_count; i++) free(projects[i]);
+        free(projects);
+    }
+}
+
+// A span being read back from the trace
+typedef struct {
+    const char *name;
+    double start;
+    double transport;              // Time in llm_request spans within it
+} OpenSpan;
+
+// Helper: the local cost of the last turns in the trace, in us: each
+// ai_chat_turn span and the frame drawn after it, less the time in
+// llm_request spans within them
+static int read_turn_costs(const char *trace_path, size_t turns, double *turn_us, double *frame_us) {
+    if (trace_dump(trace_path) != 0) return -1;
+    char *data = read_file(trace_path);
+    cJSON *root = data ? cJSON_Parse(data) : NULL;
+    free(data);
+    if (!root) return -1;
+
+    // Every turn in the trace; earlier replays' come first
+    double *costs = NULL;          // Turn, frame, turn, frame, ...
+    size_t seen = 0, cap = 0;
+    OpenSpan open[MAX_DEPTH];
+    size_t depth = 0;
+    bool want_frame = false;
+    const cJSON *e;
+    cJSON_ArrayForEach(e, cJSON_GetObjectItem(root, "traceEvents")) {
+        const char *ph = cJSON_GetStringValue(cJSON_GetObjectItem(e, "ph"));
+        const char *name = cJSON_GetStringValue(cJSON_GetObjectItem(e, "name"));
+        double ts = cJSON_GetNumberValue(cJSON_GetObjectItem(e, "ts"));
+        if (!ph || !name || cJSON_GetNumberValue(cJSON_GetObjectItem(e, "tid")) != 1) continue;
+        if (ph[0] == 'B') {
+            if (depth < MAX_DEPTH) open[depth++] = (OpenSpan){name, ts, 0};
+            continue;
+        }
+        if (ph[0] != 'E' || depth == 0) continue;
+        depth--;
+        double local = ts - open[depth].start - open[depth].transport;
+        if (strcmp(name, "llm_request") == 0) {
+            for (size_t i = 0; i < depth; i++) open[i].transport += ts - open[depth].start;
+        } else if (strcmp(name, "ai_chat_turn") == 0) {
+            if (seen == cap) {
+                cap = cap ? cap * 2 : 64;
+                double *grown = realloc(costs, cap * 2 * sizeof(double));
+                if (!grown) break;
+                costs = grown;
+            }
+            costs[seen * 2] = local;
+            costs[seen * 2 + 1] = 0;
+            seen++;
+            want_frame = true;
+        } else if (strcmp(name, "ai_chat_frame") == 0 && want_frame) {
+            costs[(seen - 1) * 2 + 1] = local;
+            want_frame = false;
+        }
+    }
+    cJSON_Delete(root);
+    int rc = seen >= turns ? 0 : -1;
+    for (size_t i = 0; rc == 0 && i < turns; i++) {
+        turn_us[i] = costs[(seen - turns + i) * 2];
+        frame_us[i] = costs[(seen - turns + i) * 2 + 1];
+    }
+    free(costs);
+    return rc;
+}
+
+static void on_timeout(int sig) {
+    (void)sig;
+    static const char msg[] = "replay_chat: a replay did not finish; the chat loop hangs\n";
+    ssize_t n = write(STDERR_FILENO, msg, sizeof(msg) - 1);
+    (void)n;
+    _exit(1);
+}
+
+// Helper: replay a session once; each turn's local cost goes to turn_us
+// and frame_us
+static int replay_once(const Session *s, const char *trace_path, double *turn_us, double *frame_us,
+                       char *error, size_t size) {
+    if (write_fixture(s) != 0) {
+        replay_error(error, size, "the starting tasks could not be written");
+        return -1;
+    }
+    app_clock_set_fixed(s->now);
+
+    // What is typed: each turn's keys, Enter, the command; q at the end
+    FILE *in = tmpfile();
+    FILE *out = fopen("/dev/null", "w");
+    if (!in || !out) {
+        if (in) fclose(in);
+        if (out) fclose(out);
+        return -1;
+    }
+    for (size_t i = 0; i < s->turn_count; i++) {
+        fprintf(in, "%s\n%s\n", s->turns[i].keys ? s->turns[i].keys : "", s->turns[i].input);
+    }
+    fputc('q', in);
+    rewind(in);
+
+    SCREEN *screen = newterm("xterm-256color", out, in);
+    if (!screen) {
+        replay_error(error, size, "no terminal description for a headless screen");
+        fclose(in);
+        fclose(out);
+        return -1;
+    }
+    set_term(screen);
+    resizeterm(40, 120);
+
+    // The loop prints on exit; keep the report clean
+    Replay r = {.session = s};
+    llm_set_transport(replay_transport, &r);
+    fflush(stdout);
+    int saved_stdout = dup(STDOUT_FILENO);
+    dup2(fileno(out), STDOUT_FILENO);
+    alarm(REPLAY_TIMEOUT);
+    int rc = ai_chat_repl();
+    alarm(0);
+    fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+    llm_set_transport(NULL, NULL);
+    delscreen(screen);
+    fclose(in);
+    fclose(out);
+
+    if (rc != 0) replay_error(error, size, "the chat loop failed (%d)", rc);
+    replay_error(error, size, "%s", r.error);
+    if (r.next < s->turn_count) {
+        replay_error(error, size, "only %zu of %zu commands reached the model", r.next, s->turn_count);
+    }
+    check_state(s, error, size);
+    if (!error[0] && read_turn_costs(trace_path, s->turn_count, turn_us, frame_us) != 0) {
+        replay_error(error, size, "the turns are missing from the trace");
+    }
+    return error[0] ? -1 : 0;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Helper: median of n values (reorders them)
+static double median(double *v, size_t n) {
+    qsort(v, n, sizeof(double), cmp_double);
+    return n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+}
+
+// Helper: replay a session reps times and print its turns' costs
+static int run_session(const char *path, int reps, const char *trace_path) {
+    Session s;
+    if (session_load(path, &s) != 0) {
+        session_free(&s);
+        return -1;
+    }
+    size_t n = s.turn_count ? s.turn_count : 1;
+    double *turn_us = calloc((size_t)reps * n, sizeof(double));
+    double *frame_us = calloc((size_t)reps * n, sizeof(double));
+    double *column = calloc((size_t)reps, sizeof(double));
+    char error[256] = "";
+    int rc = (turn_us && frame_us && column) ? 0 : -1;
+    for (int rep = 0; rc == 0 && rep < reps; rep++) {
+        rc = replay_once(&s, trace_path, turn_us + (size_t)rep * n, frame_us + (size_t)rep * n, error, sizeof(error));
+    }
+
+    if (rc != 0) {
+        printf("%s: FAILED: %s\n", path, error[0] ? error : "out of memory");
+    } else {
+        printf("%s: %zu turns, %d replays: ok\n", path, s.turn_count, reps);
+        printf("%5s  %-40s %10s %10s %10s\n", "turn", "command", "turn us", "max us", "redraw us");
+        for (size_t t = 0; t < s.turn_count; t++) {
+            double worst = 0;
+            for (int rep = 0; rep < reps; rep++) {
+                column[rep] = turn_us[(size_t)rep * n + t];
+                if (column[rep] > worst) worst = column[rep];
+            }
+            double turn = median(column, (size_t)reps);
+            for (int rep = 0; rep < reps; rep++) column[rep] = frame_us[(size_t)rep * n + t];
+            printf("%5zu  %-40.40s %10.1f %10.1f %10.1f\n", t + 1, s.turns[t].input, turn, worst,
+                   median(column, (size_t)reps));
+        }
+    }
+    free(turn_us);
+    free(frame_us);
+    free(column);
+    session_free(&s);
+    return rc;
+}
+
+int main(int argc, char **argv) {
+    int reps = DEFAULT_REPS;
+    int first = 1;
+    for (; first < argc && strncmp(argv[first], "--", 2) == 0; first++) {
+        char *end = NULL;
+        long n = (strcmp(argv[first], "--reps") == 0 && first + 1 < argc) ? strtol(argv[++first], &end, 10) : 0;
+        if (!end || *end != '\0' || n < 1 || n > MAX_REPS) {
+            fprintf(stderr, "Usage: replay_chat [--reps N] [SESSION.json ...]\n");
+            return 2;
+        }
+        reps = (int)n;
+    }
+    glob_t found = {0};
+    if (first == argc) {
+        if (glob(DEFAULT_SESSIONS, 0, NULL, &found) != 0) {
+            fprintf(stderr, "replay_chat: no sessions in %s\n", DEFAULT_SESSIONS);
+            return 2;
+        }
+    }
+
+    char home[] = "/tmp/smartodo-replay-XXXXXX";
+    if (!mkdtemp(home)) return 1;
+    setenv("HOME", home, 1);
+    setenv("TZ", "UTC", 1);
+    tzset();
+    char trace_path[256];
+    snprintf(trace_path, sizeof(trace_path), "%s/trace.json", home);
+    setenv(TRACE_ENV, trace_path, 1);
+    trace_init();
+    daemon_client_set_enabled(false);
+    utils_set_message_wait(false);
+    signal(SIGALRM, on_timeout);
+
+    int rc = 0;
+    size_t count = first == argc ? found.gl_pathc : (size_t)(argc - first);
+    for (size_t i = 0; i < count; i++) {
+        const char *path = first == argc ? found.gl_pathv[i] : argv[first + (int)i];
+        if (i > 0) printf("\n");
+        if (run_session(path, reps, trace_path) != 0) rc = 1;
+    }
+    if (first == argc) globfree(&found);
+
+    char cmd[256];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", home);
+    system(cmd);
+    return rc;
+}
@@ -0,0 +1,88 @@
+// Standalone main for the fuzz targets, for AFL and for replaying inputs
+// without libFuzzer:
+//   fuzz_task_json corpus/task_json crash-1234   # every file given or in a directory given
+//   fuzz_task_json < input                        # one input from stdin (AFL)
+#define _POSIX_C_SOURCE 200809L
+
+#include "fuzz.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+// Inputs larger than this are cut, as libFuzzer does with -max_len
+#define FUZZ_MAX_INPUT (1 << 20)
+
+// Helper: read a whole stream and run it
+static int run_stream(FILE *f, const char *name) {
+    uint8_t *data = malloc(FUZZ_MAX_INPUT);
+    if (!data) return -1;
+    size_t n = fread(data, 1, FUZZ_MAX_INPUT, f);
+    if (ferror(f)) {
+        fprintf(stderr, "Cannot read %s\n", name);
+        free(data);
+        return -1;
+    }
+    LLVMFuzzerTestOneInput(data, n);
+    free(data);
+    return 0;
+}
+
+// Helper: run one file; named first, as libFuzzer does, so a crash shows its input
+static int run_file(const char *path) {
+    fprintf(stderr, "Running: %s\n", path);
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return -1;
+    }
+    int rc = run_stream(f, path);
+    fclose(f);
+    return rc;
+}
+
+// Helper: run a file, or every file in a directory; returns inputs run or -1
+static long run_path(const char *path) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return -1;
+    }
+    if (!S_ISDIR(st.st_mode)) return run_file(path) == 0 ? 1 : -1;
+
+    DIR *dir = opendir(path);
+    if (!dir) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return -1;
+    }
+    long runs = 0;
+    struct dirent *de;
+    while ((de = readdir(dir)) != NULL) {
+        if (de->d_name[0] == '.') continue;
+        char file[4096];
+        snprintf(file, sizeof(file), "%s/%s", path, de->d_name);
+        if (stat(file, &st) != 0 || !S_ISREG(st.st_mode)) continue;
+        if (run_file(file) != 0) {
+            closedir(dir);
+            return -1;
+        }
+        runs++;
+    }
+    closedir(dir);
+    return runs;
+}
+
+int main(int argc, char **argv) {
+    LLVMFuzzerInitialize(&argc, &argv);
+    if (argc < 2) return run_stream(stdin, "stdin") == 0 ? 0 : 1;
+
+    long total = 0;
+    for (int i = 1; i < argc; i++) {
+        long runs = run_path(argv[i]);
+        if (runs < 0) return 1;
+        total += runs;
+    }
+    fprintf(stderr, "%s: %ld inputs ran\n", argv[0], total);
+    return 0;
+}
@@ -0,0 +1,55 @@
+#ifndef TODO_APP_FUZZ_H
+#define TODO_APP_FUZZ_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// "Now" of every target that reads the clock, so findings reproduce on any
+// day: 2025-03-14 15:09:26 UTC
+#define FUZZ_NOW 1741964966
+
+/**
+ * Fuzz targets for the parsers on the load path. Each target is one
+ * LLVMFuzzerTestOneInput(), the entry point of libFuzzer, so the same file
+ * builds three ways (see the Makefile):
+ *   - with clang -fsanitize=fuzzer, for libFuzzer;
+ *   - with afl-clang-fast and driver.c, for AFL, which feeds stdin;
+ *   - with any cc and driver.c, to replay corpora and crashes.
+ * A target must not keep state between inputs beyond what it sets up once
+ * in LLVMFuzzerInitialize(), and must free all it allocates, so leaks show.
+ */
+
+/**
+ * Run one input. Crashes and sanitizer reports are the findings.
+ * @param data Input bytes (not NUL-terminated)
+ * @param size Number of bytes
+ * @return 0 (other values are reserved by libFuzzer)
+ */
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+/**
+ * One-time setup before the first input.
+ * @param argc Pointer to the argument count
+ * @param argv Pointer to the arguments
+ * @return 0
+ */
+int LLVMFuzzerInitialize(int *argc, char ***argv);
+
+/**
+ * Copy an input into a NUL-terminated string; bytes after an embedded NUL
+ * are then invisible to string parsers, as they would be in a file read
+ * with fgets() or a JSON string.
+ * @param data Input bytes
+ * @param size Number of bytes
+ * @return Allocated string (caller must free), or NULL on allocation failure
+ */
+char *fuzz_cstring(const uint8_t *data, size_t size);
+
+/**
+ * Point HOME at a new private directory, removed again at exit, for
+ * targets that go through the storage files.
+ * @return 0 on success, -1 on error
+ */
+int fuzz_private_home(void);
+
+#endif // TODO_APP_FUZZ_H
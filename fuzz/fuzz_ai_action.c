@@ -0,0 +1,105 @@
+// handle_ai_response(): the JSON the model answers an AI chat command
+// with, run against a small session as the chat loop would run it. Every
+// input starts from the same tasks and projects, with an empty undo log.
+#include "fuzz.h"
+#include "../src/ai_chat_actions.h"
+#include "../src/task_manager.h"
+#include "../src/storage.h"
+#include "../src/daemon_client.h"
+#include "../src/app_clock.h"
+#include "../src/undo.h"
+#include "../src/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+int LLVMFuzzerInitialize(int *argc, char ***argv) {
+    (void)argc;
+    (void)argv;
+    if (fuzz_private_home() != 0) abort();
+    daemon_client_set_enabled(false);
+    if (task_manager_init() != 0) abort();
+    app_clock_set_fixed(FUZZ_NOW);
+    return 0;
+}
+
+// Helper: the session every input starts from
+static Task **build_tasks(size_t *count) {
+    static const struct {
+        const char *name;
+        time_t due;
+        Priority priority;
+        const char *project;
+    } fixture[] = {
+        {"Write report", FUZZ_NOW + 86400, PRIORITY_HIGH, "default"},
+        {"Call bank", FUZZ_NOW - 3600, PRIORITY_MEDIUM, "default"},
+        {"Water plants", 0, PRIORITY_LOW, "default"},
+        {"Plan sprint", FUZZ_NOW + 7 * 86400, PRIORITY_MEDIUM, "work"},
+    };
+    const size_t n = sizeof(fixture) / sizeof(fixture[0]);
+    const char *tags[] = {"home", "urgent"};
+    Task **tasks = utils_calloc(n + 1, sizeof(Task *));
+    if (!tasks) abort();
+    for (size_t i = 0; i < n; i++) {
+        tasks[i] = task_create(fixture[i].name, fixture[i].due, DUE_DATETIME, tags, i % 3, fixture[i].priority);
+        if (!tasks[i]) abort();
+        free(tasks[i]->project);
+        tasks[i]->project = utils_strdup(fixture[i].project);
+    }
+    task_set_note(tasks[0], "Quarterly numbers");
+    *count = n;
+    return tasks;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    char *content = fuzz_cstring(data, size);
+    if (!content) return 0;
+
+    char *initial_projects[] = {"default", "work"};
+    storage_save_projects(initial_projects, 2);
+    task_manager_load_projects();
+    undo_attach(0);
+
+    size_t count = 0;
+    Task **tasks = build_tasks(&count);
+    char **projects = NULL;
+    size_t project_count = task_manager_get_projects(&projects);
+    size_t selected_project_idx = 0;
+    const char *current_project = projects[0];
+
+    // The screen shows the current project's tasks, the second selected
+    Task **disp = utils_calloc(count + 1, sizeof(Task *));
+    if (!disp) abort();
+    size_t disp_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(tasks[i]->project, current_project) == 0) disp[disp_count++] = tasks[i];
+    }
+    size_t selected = 1;
+    char search_term[64] = "";
+    char last_error[MAX_ERR_LEN] = "";
+
+    ActionContext ctx = {
+        .tasks = &tasks, .count = &count,
+        .disp = disp, .disp_count = disp_count, .selected = &selected,
+        .projects = &projects, .project_count = &project_count,
+        .selected_project_idx = &selected_project_idx, .current_project = &current_project,
+        .search_term = search_term, .term_size = sizeof(search_term),
+    };
+    handle_ai_response(content, &ctx, last_error);
+
+    // What the chat loop does with the state next
+    if (selected_project_idx >= project_count || strcmp(current_project, projects[selected_project_idx]) != 0) abort();
+    for (size_t i = 0; i < count; i++) {
+        if (!tasks[i] || !tasks[i]->name || !tasks[i]->project) abort();
+        task_matches_search(tasks[i], search_term);
+    }
+    if (tasks[count]) abort();
+
+    undo_detach();
+    free(disp);
+    free(projects);
+    storage_free_tasks(tasks, count);
+    free(content);
+    return 0;
+}
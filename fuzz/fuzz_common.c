@@ -0,0 +1,28 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "fuzz.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static char home[] = "/tmp/smartodo-fuzz-XXXXXX";
+
+char *fuzz_cstring(const uint8_t *data, size_t size) {
+    char *s = malloc(size + 1);
+    if (!s) return NULL;
+    memcpy(s, data, size);
+    s[size] = '\0';
+    return s;
+}
+
+static void remove_home(void) {
+    char cmd[64];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", home);
+    if (system(cmd) != 0) fprintf(stderr, "Cannot remove %s\n", home);
+}
+
+int fuzz_private_home(void) {
+    if (!mkdtemp(home)) return -1;
+    atexit(remove_home);
+    return setenv("HOME", home, 1);
+}
@@ -0,0 +1,21 @@
+// parse_natural_date(): free text typed by users and produced by the model
+#include "fuzz.h"
+#include "../src/date_parser.h"
+#include "../src/app_clock.h"
+#include <stdlib.h>
+
+int LLVMFuzzerInitialize(int *argc, char ***argv) {
+    (void)argc;
+    (void)argv;
+    app_clock_set_fixed(FUZZ_NOW);
+    return 0;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    char *input = fuzz_cstring(data, size);
+    if (!input) return 0;
+    time_t result;
+    parse_natural_date(input, &result);
+    free(input);
+    return 0;
+}
@@ -0,0 +1,23 @@
+// utils_parse_date() and utils_parse_due(): due dates from the command
+// line, the HTTP API and AI actions.
+#include "fuzz.h"
+#include "../src/utils.h"
+#include "../src/app_clock.h"
+#include <stdlib.h>
+
+int LLVMFuzzerInitialize(int *argc, char ***argv) {
+    (void)argc;
+    (void)argv;
+    app_clock_set_fixed(FUZZ_NOW);
+    return 0;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    char *input = fuzz_cstring(data, size);
+    if (!input) return 0;
+    bool date_only;
+    utils_parse_date(input);
+    utils_parse_due(input, &date_only);
+    free(input);
+    return 0;
+}
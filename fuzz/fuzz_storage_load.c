@@ -0,0 +1,32 @@
+// storage_load_tasks(): the input is written as tasks.json under a private
+// HOME, then loaded the way the app loads it at startup.
+#include "fuzz.h"
+#include "../src/storage.h"
+#include "../src/daemon_client.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static char *tasks_path;
+
+int LLVMFuzzerInitialize(int *argc, char ***argv) {
+    (void)argc;
+    (void)argv;
+    if (fuzz_private_home() != 0) abort();
+    daemon_client_set_enabled(false);
+    if (storage_init() != 0) abort();
+    tasks_path = storage_tasks_path();
+    if (!tasks_path) abort();
+    return 0;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    FILE *f = fopen(tasks_path, "wb");
+    if (!f) abort();
+    fwrite(data, 1, size, f);
+    fclose(f);
+
+    size_t count = 0;
+    Task **tasks = storage_load_tasks(&count);
+    if (tasks) storage_free_tasks(tasks, count);
+    return 0;
+}
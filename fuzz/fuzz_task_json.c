@@ -0,0 +1,29 @@
+// task_from_json(): one task object, as in tasks.json or a daemon reply.
+// A task that parses must serialize and parse back.
+#include "fuzz.h"
+#include "../src/task.h"
+#include <stdlib.h>
+
+int LLVMFuzzerInitialize(int *argc, char ***argv) {
+    (void)argc;
+    (void)argv;
+    return 0;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    char *json = fuzz_cstring(data, size);
+    if (!json) return 0;
+    Task *t = task_from_json(json);
+    free(json);
+    if (!t) return 0;
+
+    char *out = task_to_json(t);
+    if (out) {
+        Task *back = task_from_json(out);
+        if (!back) abort();
+        task_free(back);
+        free(out);
+    }
+    task_free(t);
+    return 0;
+}
@@ -0,0 +1,217 @@
+// Writes seed corpora for the fuzz targets, one directory per target, from
+// synthetic task sets (bench/dataset.h), so the fuzzers start from input
+// the app really reads:
+//   seed_corpus corpus        # corpus/task_json, corpus/storage_load, ...
+#define _POSIX_C_SOURCE 200809L
+
+#include "fuzz.h"
+#include "../bench/dataset.h"
+#include "../src/storage.h"
+#include "../src/utils.h"
+#include <cjson/cJSON.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+// Phrases parse_natural_date() understands, plus near misses
+static const char *phrases[] = {
+    "today", "tomorrow", "yesterday", "tonight", "next friday", "next week", "next month",
+    "this weekend", "end of month", "end of week", "in 2 weeks", "in 3 days", "in 3 hours",
+    "in 45 minutes", "the 15th", "may 20", "20 may 2026", "20 may 2026 at 14:30",
+    "friday 3pm", "2pm", "14:30", "noon", "midnight", "tomorrow at 9am", "next monday 10:15",
+    "in 0 days", "in -1 days", "the 31st", "feb 29", "13:61", "25pm", "next", "in",
+};
+
+static const char *dir;
+static unsigned long written;
+
+// Helper: write one seed file to dir/target
+static int write_seed(const char *target, const char *data) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/%s", dir, target);
+    if (mkdir(path, 0755) != 0 && errno != EEXIST) return -1;
+    snprintf(path, sizeof(path), "%s/%s/seed-%05lu", dir, target, written++);
+    FILE *f = fopen(path, "wb");
+    if (!f) return -1;
+    fputs(data, f);
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+// Helper: serialize and write a cJSON item
+static int write_json(const char *target, const cJSON *item) {
+    char *json = cJSON_PrintUnformatted(item);
+    if (!json) return -1;
+    int rc = write_seed(target, json);
+    free(json);
+    return rc;
+}
+
+// Helper: a task set as tasks.json holds it
+static int write_snapshot(Task **tasks, size_t count) {
+    cJSON *array = cJSON_CreateArray();
+    if (!array) return -1;
+    for (size_t i = 0; i < count; i++) cJSON_AddItemToArray(array, task_to_cjson(tasks[i]));
+    int rc = write_json("storage_load", array);
+    cJSON_Delete(array);
+    return rc;
+}
+
+// Helper: due dates of a task in the forms users and the model write them
+static int write_dates(const Task *t) {
+    if (t->due == 0) return 0;
+    char iso[UTILS_ISO8601_BUFSZ], buf[64];
+    struct tm tm;
+    gmtime_r(&t->due, &tm);
+    int rc = 0;
+    if (utils_format_iso8601(t->due, iso)) rc |= write_seed("parse_date", iso);
+    strftime(buf, sizeof(buf), "%Y-%m-%d", &tm);
+    rc |= write_seed("parse_date", buf);
+    strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M", &tm);
+    rc |= write_seed("parse_date", buf);
+    strftime(buf, sizeof(buf), "%d %b %Y at %H:%M", &tm);
+    rc |= write_seed("natural_date", buf);
+    return rc;
+}
+
+// Helper: an AI response {"action": ..., "params": ...}; takes params
+static int write_action(const char *action, cJSON *params) {
+    cJSON *root = cJSON_CreateObject();
+    if (!root) {
+        cJSON_Delete(params);
+        return -1;
+    }
+    cJSON_AddStringToObject(root, "action", action);
+    cJSON_AddItemToObject(root, "params", params);
+    int rc = write_json("ai_action", root);
+    cJSON_Delete(root);
+    return rc;
+}
+
+// Helper: AI responses that act on one task, with its fields as parameters
+static int write_actions(const Task *t, int index) {
+    static const char *priorities[] = {"low", "medium", "high"};
+    char iso[UTILS_ISO8601_BUFSZ];
+    const char *due = t->due && utils_format_iso8601(t->due, iso) ? iso : NULL;
+    int rc = 0;
+
+    cJSON *p = cJSON_CreateObject();
+    cJSON_AddStringToObject(p, "name", t->name);
+    if (due) cJSON_AddStringToObject(p, "due", due);
+    cJSON *tags = cJSON_AddArrayToObject(p, "tags");
+    for (size_t i = 0; i < t->tag_count; i++) cJSON_AddItemToArray(tags, cJSON_CreateString(t->tags[i]));
+    cJSON_AddStringToObject(p, "priority", priorities[t->priority % 3]);
+    cJSON_AddStringToObject(p, "project", t->project);
+    if (t->recur) cJSON_AddStringToObject(p, "recur", t->recur);
+    rc |= write_action("add_task", p);
+
+    p = cJSON_CreateObject();
+    cJSON_AddNumberToObject(p, "index", index);
+    cJSON_AddStringToObject(p, "name", t->name);
+    if (due) cJSON_AddStringToObject(p, "due", due);
+    else cJSON_AddNullToObject(p, "due");
+    rc |= write_action("edit_task", p);
+
+    p = cJSON_CreateObject();
+    cJSON_AddNumberToObject(p, "index", index);
+    cJSON_AddStringToObject(p, "status", t->status == STATUS_DONE ? "done" : "pending");
+    rc |= write_action("edit_task_status", p);
+
+    if (t->note) {
+        p = cJSON_CreateObject();
+        cJSON_AddNumberToObject(p, "index", index);
+        cJSON_AddStringToObject(p, "note", t->note);
+        rc |= write_action("add_note", p);
+    }
+
+    p = cJSON_CreateObject();
+    cJSON_AddStringToObject(p, "action", "edit_task");
+    cJSON *nested = cJSON_AddObjectToObject(p, "params");
+    cJSON_AddStringToObject(nested, "name", t->name);
+    cJSON_AddStringToObject(nested, "priority", priorities[t->priority % 3]);
+    rc |= write_action("selected_task", p);
+
+    p = cJSON_CreateObject();
+    cJSON_AddStringToObject(p, "term", t->tag_count ? t->tags[0] : t->name);
+    rc |= write_action("search_tasks", p);
+    return rc;
+}
+
+// Helper: AI responses without a task of their own
+static int write_fixed_actions(void) {
+    static const char *responses[] = {
+        "{\"action\":\"delete_task\",\"params\":{\"index\":1}}",
+        "{\"action\":\"mark_done\",\"params\":{\"index\":2}}",
+        "{\"action\":\"view_note\",\"params\":{\"index\":1}}",
+        "{\"action\":\"sort_tasks\",\"params\":{\"by\":\"due\"}}",
+        "{\"action\":\"sort_tasks\",\"params\":{\"by\":\"name\"}}",
+        "{\"action\":\"filter_by_date\",\"params\":{\"range\":\"overdue\"}}",
+        "{\"action\":\"filter_by_priority\",\"params\":{\"level\":\"high\"}}",
+        "{\"action\":\"filter_by_status\",\"params\":{\"status\":\"done\"}}",
+        "{\"action\":\"filter_combined\",\"params\":{\"filters\":[{\"type\":\"priority\",\"value\":\"high\"},{\"type\":\"date\",\"value\":\"this_week\"}]}}",
+        "{\"action\":\"search_tasks\",\"params\":{\"term\":null}}",
+        "{\"action\":\"list_tasks\",\"params\":{}}",
+        "{\"action\":\"add_project\",\"params\":{\"name\":\"home\"}}",
+        "{\"action\":\"delete_project\",\"params\":{\"name\":\"work\"}}",
+        "{\"action\":\"selected_task\",\"params\":{\"action\":\"mark_done\",\"params\":{}}}",
+        "{\"action\":\"selected_task\",\"params\":{\"action\":\"delete_task\",\"params\":{}}}",
+        "{\"action\":\"undo\",\"params\":{}}",
+        "{\"action\":\"redo\",\"params\":{}}",
+        "{\"action\":\"exit\",\"params\":{}}",
+    };
+    int rc = 0;
+    for (size_t i = 0; i < sizeof(responses) / sizeof(responses[0]); i++) rc |= write_seed("ai_action", responses[i]);
+    return rc;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: seed_corpus DIR\n");
+        return 2;
+    }
+    dir = argv[1];
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Cannot create %s\n", dir);
+        return 1;
+    }
+
+    // Small sets with every optional field common, around the fuzzers' "now"
+    DatasetSpec spec;
+    dataset_default_spec(&spec);
+    spec.count = 64;
+    spec.projects = 3;
+    spec.base = FUZZ_NOW;
+    spec.due_days = 400;
+    spec.note_ratio = 0.5;
+    spec.note_mean = 40;
+    spec.recur_ratio = 0.2;
+    size_t count = 0;
+    Task **tasks = dataset_generate(&spec, &count);
+    if (!tasks) {
+        fprintf(stderr, "Out of memory generating tasks\n");
+        return 1;
+    }
+
+    int rc = 0;
+    for (size_t i = 0; i < count; i++) {
+        char *json = task_to_json(tasks[i]);
+        if (!json) rc = -1;
+        else rc |= write_seed("task_json", json);
+        free(json);
+        rc |= write_dates(tasks[i]);
+        if (i < 16) rc |= write_actions(tasks[i], (int)(i % 4) + 1);
+    }
+    for (size_t n = 0; n <= count; n = n ? n * 4 : 1) rc |= write_snapshot(tasks, n);
+    for (size_t i = 0; i < sizeof(phrases) / sizeof(phrases[0]); i++) rc |= write_seed("natural_date", phrases[i]);
+    rc |= write_fixed_actions();
+    storage_free_tasks(tasks, count);
+
+    if (rc != 0) {
+        fprintf(stderr, "Cannot write the corpora under %s\n", dir);
+        return 1;
+    }
+    printf("%lu seeds written under %s\n", written, dir);
+    return 0;
+}
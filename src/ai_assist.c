@@ -1,3 +1,6 @@
+// localtime_r() and gmtime_r() are POSIX, not ISO C
+#define _POSIX_C_SOURCE 200809L
+
 #include "ai_assist.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -8,17 +11,19 @@
 #include <time.h>
 #include "llm_api.h"
 #include "utils.h"
+#include "app_clock.h"
 
 void ai_smart_add(const char *prompt, int debug) {
-    // Get current date in ISO 8601 (UTC, no time)
-    time_t now = time(NULL);
+    // Get the local calendar date and the current time in ISO 8601 (UTC)
+    time_t now = app_clock_now();
     struct tm tm_now;
-    gmtime_r(&now, &tm_now);
+    localtime_r(&now, &tm_now);
     char today_str[20];
     strftime(today_str, sizeof(today_str), "%Y-%m-%d", &tm_now);
+    gmtime_r(&now, &tm_now);
     char iso_now[25];
     strftime(iso_now, sizeof(iso_now), "%Y-%m-%dT%H:%M:%SZ", &tm_now);
-    if (debug) fprintf(stderr, "[ai_smart_add] Today (UTC): %s\n", today_str);
+    if (debug) fprintf(stderr, "[ai_smart_add] Today (local): %s\n", today_str);
 
     // Compose system prompt with context for today
     char sys[2048];
@@ -75,13 +80,19 @@ void ai_smart_add(const char *prompt, int debug) {
         exit(1);
     }
     if (t && (!t->project || t->project[0]=='\0')) {
-        if (t->project) free(t->project);
+        if (t->project) utils_free(t->project);
         t->project = utils_strdup("default");
     }
     // Load, append, save
     size_t count = 0;
     Task **tasks = storage_load_tasks(&count);
-    tasks = realloc(tasks, (count+2)*sizeof(Task*));
+    Task **grown = utils_realloc(tasks, (count+2)*sizeof(Task*));
+    if (!grown) {
+        storage_free_tasks(tasks, count);
+        task_free(t);
+        exit(1);
+    }
+    tasks = grown;
     tasks[count++] = t;
     tasks[count] = NULL;
     if (storage_save_tasks(tasks, count) != 0) {
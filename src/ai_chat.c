@@ -1,3 +1,6 @@
+// localtime_r() and strdup() are POSIX, not ISO C
+#define _POSIX_C_SOURCE 200809L
+
 #include "ai_chat.h"
 #include "llm_api.h"
 #include "ui.h"         // For ncurses UI functions
@@ -6,6 +9,9 @@
 #include "utils.h"      // For common utilities
 #include "task_manager.h" // For centralized task management
 #include "ai_chat_actions.h" // For action handlers
+#include "app_clock.h"    // For the cached current time
+#include "undo.h"         // For undo/redo of changes
+#include "trace.h"        // For tracing spans
 #include <cjson/cJSON.h> // For parsing LLM response
 #include <curses.h>    // For ncurses functions
 #include <stdio.h>
@@ -41,9 +47,9 @@ static void build_system_prompt(char *prompt_buf, size_t buf_size, Task **tasks,
     int written;
 
     // Get current date for the prompt
-    time_t now = time(NULL);
+    time_t now = app_clock_now();
     struct tm tm_now;
-    gmtime_r(&now, &tm_now);
+    localtime_r(&now, &tm_now); // The user's calendar date
     char today_str[20];
     strftime(today_str, sizeof(today_str), "%Y-%m-%d", &tm_now);
     
@@ -89,7 +95,7 @@ static void build_system_prompt(char *prompt_buf, size_t buf_size, Task **tasks,
     remaining_size -= written;
     
     written = snprintf(ptr, remaining_size,
-             " add_task: { \"name\": string, \"due\": \"YYYY-MM-DD\" | null, \"tags\": [string], \"priority\": \"low\"|\"medium\"|\"high\", \"project\": string, \"note\": string? }\n"
+             " add_task: { \"name\": string, \"due\": \"YYYY-MM-DD\" | null, \"tags\": [string], \"priority\": \"low\"|\"medium\"|\"high\", \"project\": string, \"note\": string?, \"recur\": \"daily\"|\"weekly\"|\"monthly\"|\"yearly\"|RRULE string? (requires due) }\n"
              " mark_done: { \"index\": number }\n"
              " delete_task: { \"index\": number }\n");
     if (written < 0 || (size_t)written >= remaining_size) goto end_prompt;
@@ -120,6 +126,8 @@ static void build_system_prompt(char *prompt_buf, size_t buf_size, Task **tasks,
              " filter_combined: { \"filters\": [ {\"type\": \"date\"|\"priority\"|\"status\", \"value\": string}, ... ] } (Apply multiple filters)\n"
              " sort_tasks: { \"by\": \"name\"|\"due\"|\"creation\" }\n"
              " list_tasks: {} (Use this if the user asks to see tasks, effectively clears search)\n"
+             " undo: {} (Revert the most recent change; repeat to go further back)\n"
+             " redo: {} (Reapply the change undone last)\n"
              " exit: {} (Use this to exit the AI chat mode)\n"
              "\n"
              "Context:\n"
@@ -185,11 +193,7 @@ static void build_system_prompt(char *prompt_buf, size_t buf_size, Task **tasks,
             char due_str[32] = "no due date";
             
             // Format due date if present
-            if (tasks[i]->due > 0) {
-                struct tm tm_due;
-                gmtime_r(&tasks[i]->due, &tm_due);
-                strftime(due_str, sizeof(due_str), "%Y-%m-%d", &tm_due);
-            }
+            task_format_due_date(tasks[i], due_str, sizeof(due_str));
             
             // Format priority
             const char *prio_str = "low";
@@ -230,7 +234,7 @@ static void build_system_prompt(char *prompt_buf, size_t buf_size, Task **tasks,
         // Append task JSON string safely
         written = snprintf(ptr, remaining_size, "%s\n", task_json_str);
         
-        free(task_json_str); // Free the string returned by task_to_json
+        utils_free(task_json_str); // Free the string returned by task_to_json
 
         if (written < 0 || (size_t)written >= remaining_size) goto end_prompt; // Error or truncated
         ptr += written;
@@ -258,11 +262,7 @@ static char* generate_ai_suggestion(Task *task) {
     
     // Format the due date if available
     char due_str[32] = "no due date";
-    if (task->due > 0) {
-        struct tm tm_due;
-        gmtime_r(&task->due, &tm_due);
-        strftime(due_str, sizeof(due_str), "%Y-%m-%d", &tm_due);
-    }
+    task_format_due_date(task, due_str, sizeof(due_str));
     
     // Format the priority
     const char *priority_str = "low";
@@ -291,7 +291,10 @@ static char* generate_ai_suggestion(Task *task) {
     
     // Call LLM and get structured response
     LlmChatResponse *llm_resp = NULL;
-    if (llm_chat(system_prompt, user_prompt, &llm_resp, 0, "gpt-4.1-nano") != 0 || !llm_resp || llm_resp->n_choices < 1) {
+    trace_begin("ai_suggestion");
+    int llm_status = llm_chat(system_prompt, user_prompt, &llm_resp, 0, "gpt-4.1-nano");
+    trace_end("ai_suggestion");
+    if (llm_status != 0 || !llm_resp || llm_resp->n_choices < 1) {
         llm_chat_response_free(llm_resp);
         // fallback suggestion
         if (task->priority == PRIORITY_HIGH) {
@@ -346,10 +349,13 @@ int ai_chat_repl(void) {
     if (ui_init() != 0) {
         fprintf(stderr, "Failed to initialize UI.\n");
         task_manager_cleanup(tasks, count);
-        free(projects);
+        utils_free(projects);
         return 1;
     }
 
+    // Inside the TUI the undo log is already attached and stays with it
+    bool own_undo = undo_attach(0) == 0;
+
     size_t selected = 0; // Keep track of selection for potential future use (e.g., showing context)
     char search_term[64] = ""; // For potential future search integration
     char last_error[MAX_ERR_LEN] = ""; // To display errors
@@ -358,16 +364,26 @@ int ai_chat_repl(void) {
     if (!disp) {
         ui_teardown();
         task_manager_cleanup(tasks, count);
-        free(projects);
+        utils_free(projects);
         fprintf(stderr, "Failed to allocate memory for display list.\n");
         return 1;
     }
 
     while (1) {
+        app_clock_tick();
+
+        // Adding tasks and undoing deletes grow the list; keep room for all
+        Task **grown = utils_realloc(disp, (count + 1) * sizeof(Task*));
+        if (!grown) {
+            utils_free(disp);
+            break;
+        }
+        disp = grown;
+
         // --- Project sidebar logic ---
         // Use central project list
         if (projects) {
-            free(projects);
+            utils_free(projects);
             projects = NULL;
         }
         project_count = task_manager_get_projects(&projects);
@@ -387,6 +403,7 @@ int ai_chat_repl(void) {
         if (disp_count == 0) selected = 0;
 
         // Draw UI
+        trace_begin("ai_chat_frame");
         clear();
         ui_draw_header(search_term[0] ? search_term : "AI Chat Mode");
         ui_draw_projects(projects, project_count, selected_project_idx);
@@ -397,11 +414,11 @@ int ai_chat_repl(void) {
         if (disp_count > 0 && selected < disp_count) {
             Task *selected_task = disp[selected];
             if (selected_task->priority == PRIORITY_HIGH || 
-                (selected_task->due > 0 && selected_task->due < time(NULL))) {
+                (selected_task->due > 0 && task_due_deadline(selected_task) < app_clock_now())) {
                 char *ai_suggestion = generate_ai_suggestion(selected_task);
                 if (ai_suggestion && ai_suggestion[0]) {
                     ui_draw_suggestion(suggestion_y, ai_suggestion);
-                    free(ai_suggestion);
+                    utils_free(ai_suggestion);
                 }
             }
         }
@@ -415,11 +432,12 @@ int ai_chat_repl(void) {
              last_error[0] = '\0';
         }
         refresh();
+        trace_end("ai_chat_frame");
 
         // Get user input - handle navigation keys first
         int ch = ui_get_input();
         if (ch == 'q') {
-            free(disp); 
+            utils_free(disp); 
             break;
         }
         
@@ -443,7 +461,7 @@ int ai_chat_repl(void) {
                 if (proj_name[0] != '\0') {
                     if (task_manager_add_project(proj_name) == 0) {
                         task_manager_save_projects();
-                        free(projects);
+                        utils_free(projects);
                         project_count = task_manager_get_projects(&projects);
                         selected_project_idx = project_count - 1;
                         current_project = projects[selected_project_idx];
@@ -460,7 +478,7 @@ int ai_chat_repl(void) {
                 int del_result = task_manager_delete_project(to_delete, tasks, count);
                 if (del_result == 0) {
                     task_manager_save_projects();
-                    free(projects);
+                    utils_free(projects);
                     project_count = task_manager_get_projects(&projects);
                     if (selected_project_idx >= project_count) selected_project_idx = project_count - 1;
                     current_project = projects[selected_project_idx];
@@ -480,10 +498,14 @@ int ai_chat_repl(void) {
             case 'm': {
                 if (disp_count == 0) { continue; }
                 Task *t = disp[selected];
-                t->status = (t->status == STATUS_DONE) ? STATUS_PENDING : STATUS_DONE;
+                task_manager_toggle_status(t);
                 utils_show_message(t->status == STATUS_DONE ? "Task marked as done." : "Task marked as pending.", LINES-2, 2);
                 continue;
             }
+            case 'u':
+            case 'r':
+                handle_undo(&tasks, &count, ch == 'r', last_error);
+                continue;
                 
             case 10: // Enter key
                 // Only proceed to AI chat when Enter is pressed
@@ -498,17 +520,18 @@ int ai_chat_repl(void) {
         prompt_input("Enter command:", user_input, sizeof(user_input));
 
         if (strcmp(user_input, "exit") == 0 || strlen(user_input) == 0) {
-            free(disp); 
+            utils_free(disp); 
             break;
         }
 
         // ---- LLM Call, Parsing, and Action Execution ----
         last_error[0] = '\0'; // Clear previous error before new command
+        trace_begin("ai_chat_turn");
 
         // 1. Prepare System Prompt
-        time_t now = time(NULL);
+        time_t now = app_clock_now();
         struct tm tm_now;
-        gmtime_r(&now, &tm_now);
+        localtime_r(&now, &tm_now); // The user's calendar date
         char today_str[20];
         strftime(today_str, sizeof(today_str), "%Y-%m-%d", &tm_now);
 
@@ -523,11 +546,7 @@ int ai_chat_repl(void) {
                 char due_str[32] = "no due date";
                 
                 // Format due date if present
-                if (disp[i]->due > 0) {
-                    struct tm tm_due;
-                    gmtime_r(&disp[i]->due, &tm_due);
-                    strftime(due_str, sizeof(due_str), "%Y-%m-%d", &tm_due);
-                }
+                task_format_due_date(disp[i], due_str, sizeof(due_str));
                 
                 // Format priority
                 const char *prio_str = "low";
@@ -567,14 +586,19 @@ int ai_chat_repl(void) {
         }
 
         char sys_prompt[4096]; // Increased size
+        trace_begin("ai_chat_prompt");
         build_system_prompt(sys_prompt, sizeof(sys_prompt), disp, disp_count);
+        trace_end("ai_chat_prompt");
 
         // 2. Call LLM and get structured response
         LlmChatResponse *llm_resp = NULL;
+        trace_begin("ai_chat_llm");
         int llm_status = llm_chat(sys_prompt, user_input, &llm_resp, 0, NULL);
+        trace_end("ai_chat_llm");
         if (llm_status != 0 || !llm_resp || llm_resp->n_choices < 1) {
             snprintf(last_error, MAX_ERR_LEN, "AI interaction failed (status: %d)", llm_status);
             llm_chat_response_free(llm_resp);
+            trace_end("ai_chat_turn");
             continue;
         }
         // extract the AI's JSON content string
@@ -585,89 +609,25 @@ int ai_chat_repl(void) {
         llm_chat_response_free(llm_resp);
         if (!content) {
             snprintf(last_error, MAX_ERR_LEN, "Could not extract content from API response");
+            trace_end("ai_chat_turn");
             continue;
         }
 
-        // 3. Parse JSON Response
-        cJSON *root = cJSON_Parse(content);
-        free(content); // Free the extracted content string
-
-        if (!root) {
-            snprintf(last_error, MAX_ERR_LEN, "AI response was not valid JSON");
-            continue;
-        }
-
-        cJSON *action_item = cJSON_GetObjectItemCaseSensitive(root, "action");
-        cJSON *params_item = cJSON_GetObjectItemCaseSensitive(root, "params");
-
-        if (!cJSON_IsString(action_item) || !cJSON_IsObject(params_item)) {
-            utils_show_message("Request not understood. No action taken.", LINES-2, 2);
-            cJSON_Delete(root);
-            continue;
+        // 3. Parse the response and execute its action
+        ActionContext actx = {
+            .tasks = &tasks, .count = &count,
+            .disp = disp, .disp_count = disp_count, .selected = &selected,
+            .projects = &projects, .project_count = &project_count,
+            .selected_project_idx = &selected_project_idx, .current_project = &current_project,
+            .search_term = search_term, .term_size = sizeof(search_term),
+        };
+        ActionResult result = handle_ai_response(content, &actx, last_error);
+        utils_free(content); // Free the extracted content string
+        trace_end("ai_chat_turn");
+        if (result == ACTION_EXIT) {
+            utils_free(disp);
+            break; // Exit the main loop
         }
-
-        const char *action = action_item->valuestring;
-        cJSON *params = params_item;
-
-        // 3. Execute Action
-        ActionResult result = ACTION_ERROR;
-
-        if (strcmp(action, "add_task") == 0) {
-            result = handle_add_task(params, &tasks, &count, current_project, last_error);
-        } else if (strcmp(action, "delete_task") == 0) {
-            result = handle_delete_task(params, &tasks, &count, disp, disp_count, &selected, last_error);
-        } else if (strcmp(action, "edit_task") == 0) {
-            result = handle_edit_task(params, disp, disp_count, last_error);
-        } else if (strcmp(action, "mark_done") == 0) {
-            result = handle_mark_done(params, disp, disp_count, last_error);
-        } else if (strcmp(action, "edit_task_status") == 0) {
-            result = handle_edit_task_status(params, disp, disp_count, last_error);
-        } else if (strcmp(action, "selected_task") == 0) {
-            result = handle_selected_task(params, &tasks, &count, disp, disp_count, &selected, &selected, last_error);
-        } else if (strcmp(action, "sort_tasks") == 0) {
-            result = handle_sort_tasks(params, tasks, count, last_error);
-        } else if (strcmp(action, "filter_by_date") == 0) {
-            result = handle_filter_by_date(params, search_term, sizeof(search_term), last_error);
-            if (result == ACTION_SUCCESS) selected = 0; // Reset selection
-        } else if (strcmp(action, "filter_by_priority") == 0) {
-            result = handle_filter_by_priority(params, search_term, sizeof(search_term), last_error);
-            if (result == ACTION_SUCCESS) selected = 0; // Reset selection
-        } else if (strcmp(action, "filter_by_status") == 0) {
-            result = handle_filter_by_status(params, search_term, sizeof(search_term), last_error);
-            if (result == ACTION_SUCCESS) selected = 0; // Reset selection
-        } else if (strcmp(action, "filter_combined") == 0) {
-            result = handle_filter_combined(params, search_term, sizeof(search_term), last_error);
-            if (result == ACTION_SUCCESS) selected = 0; // Reset selection
-        } else if (strcmp(action, "search_tasks") == 0) {
-            result = handle_search_tasks(params, search_term, sizeof(search_term), last_error);
-            if (result == ACTION_SUCCESS) selected = 0; // Reset selection on search change
-        } else if (strcmp(action, "list_tasks") == 0) {
-            result = handle_list_tasks(search_term, last_error);
-            if (result == ACTION_SUCCESS) selected = 0; // Reset selection
-        } else if (strcmp(action, "add_note") == 0) {
-            result = handle_add_note(params, disp, disp_count, last_error);
-        } else if (strcmp(action, "view_note") == 0) {
-            result = handle_view_note(params, disp, disp_count, last_error);
-        } else if (strcmp(action, "add_project") == 0) {
-            result = handle_add_project(params, &projects, &project_count, &selected_project_idx, 
-                                        &current_project, tasks, count, last_error);
-        } else if (strcmp(action, "delete_project") == 0) {
-            result = handle_delete_project(params, &projects, &project_count, &selected_project_idx, 
-                                           &current_project, tasks, count, last_error);
-        } else if (strcmp(action, "exit") == 0) {
-            result = handle_exit(params, last_error);
-            if (result == ACTION_EXIT) {
-                cJSON_Delete(root);
-                free(disp);
-                break; // Exit the main loop
-            }
-        } else {
-            snprintf(last_error, MAX_ERR_LEN, "Unknown action '%s' received from AI.", action);
-            cJSON_Delete(root);
-            continue;
-        }
-
-        cJSON_Delete(root);
     }
 
     // Cleanup
@@ -680,7 +640,8 @@ int ai_chat_repl(void) {
 
     task_manager_save_projects();
     task_manager_cleanup(tasks, count);
-    free(projects);
+    utils_free(projects);
+    if (own_undo) undo_detach();
 
     printf("Exiting AI chat mode.\n"); // Print after ncurses is done
     return 0;
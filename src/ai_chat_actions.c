@@ -1,8 +1,14 @@
+// strcasecmp() is POSIX, not ISO C
+#define _POSIX_C_SOURCE 200809L
+
 #include "ai_chat_actions.h"
 #include "task_manager.h"
 #include "utils.h"
+#include "undo.h"
 #include "ui.h"  // For PROJECT_COL_WIDTH and UI functions
+#include "trace.h"
 #include <string.h>
+#include <strings.h>
 #include <time.h>
 #include <ncurses.h>
 #include <stdlib.h> // For free()
@@ -38,13 +44,22 @@ static Priority parse_priority_from_json(cJSON *priority) {
     return prio;
 }
 
+// Helper function to parse a due string and classify it
+static time_t parse_due_string(const char *s, DueKind *kind) {
+    bool date_only = false;
+    time_t due_time = utils_parse_due(s, &date_only);
+    *kind = date_only ? DUE_DATE : DUE_DATETIME;
+    return due_time;
+}
+
 // Helper function to parse due date from JSON
-static time_t parse_due_date_from_json(cJSON *due) {
+static time_t parse_due_date_from_json(cJSON *due, DueKind *kind) {
     time_t due_time = 0; // Default: no due date
+    *kind = DUE_NONE;
     
     if (due) {
         if (cJSON_IsString(due)) {
-            due_time = utils_parse_date(due->valuestring);
+            due_time = parse_due_string(due->valuestring, kind);
         } else if (cJSON_IsNull(due)) {
             due_time = 0; // Explicit null means clear the due date
         }
@@ -61,6 +76,7 @@ ActionResult handle_add_task(cJSON *params, Task ***tasks, size_t *count,
     cJSON *tags = cJSON_GetObjectItem(params, "tags");
     cJSON *priority = cJSON_GetObjectItem(params, "priority");
     cJSON *project = cJSON_GetObjectItem(params, "project");
+    cJSON *recur = cJSON_GetObjectItem(params, "recur");
 
     // Validate required parameters
     if (!cJSON_IsString(name) || name->valuestring[0] == '\0') {
@@ -76,7 +92,8 @@ ActionResult handle_add_task(cJSON *params, Task ***tasks, size_t *count,
     Priority prio = parse_priority_from_json(priority);
     
     // Parse due date
-    time_t due_time = parse_due_date_from_json(due);
+    DueKind due_kind;
+    time_t due_time = parse_due_date_from_json(due, &due_kind);
     
     // Parse project name
     const char *proj_name = current_project;
@@ -85,7 +102,10 @@ ActionResult handle_add_task(cJSON *params, Task ***tasks, size_t *count,
     }
 
     // Add task using task manager
-    if (task_manager_add_task(tasks, count, name->valuestring, due_time, tag_ptrs, tag_count, prio, proj_name) == 0) {
+    if (task_manager_add_task(tasks, count, name->valuestring, due_time, due_kind, tag_ptrs, tag_count, prio, proj_name) == 0) {
+        if (due_time != 0 && cJSON_IsString(recur) && recur->valuestring[0] != '\0') {
+            task_set_recurrence((*tasks)[*count - 1], recur->valuestring);
+        }
         utils_show_message("Task added.", LINES - 2, 2);
         return ACTION_SUCCESS;
     } else {
@@ -158,9 +178,10 @@ ActionResult handle_edit_task(cJSON *params, Task **disp, size_t disp_count,
     
     // Parse due date
     time_t due_time = -1; // -1 means don't change
+    DueKind due_kind = DUE_NONE;
     if (due) {
         if (cJSON_IsString(due)) {
-            due_time = utils_parse_date(due->valuestring);
+            due_time = parse_due_string(due->valuestring, &due_kind);
         } else if (cJSON_IsNull(due)) {
             due_time = 0; // Explicit null means clear the due date
         }
@@ -192,7 +213,7 @@ ActionResult handle_edit_task(cJSON *params, Task **disp, size_t disp_count,
     }
     
     // Update the task
-    if (task_manager_update_task(target_task, new_name, due_time, 
+    if (task_manager_update_task(target_task, new_name, due_time, due_kind, 
                                update_tags ? tag_ptrs : NULL, 
                                tag_count, prio, task_status) == 0) {
         utils_show_message("Task updated.", LINES - 2, 2);
@@ -225,7 +246,7 @@ ActionResult handle_mark_done(cJSON *params, Task **disp, size_t disp_count,
     Task *target_task = disp[index_0based]; // Get task from the *displayed* list
     
     // Use task manager to update status
-    if (task_manager_update_task(target_task, NULL, -1, NULL, 0, -1, STATUS_DONE) == 0) {
+    if (task_manager_update_task(target_task, NULL, -1, DUE_NONE, NULL, 0, -1, STATUS_DONE) == 0) {
         utils_show_message("Task marked done.", LINES - 2, 2);
         return ACTION_SUCCESS;
     } else {
@@ -272,7 +293,7 @@ ActionResult handle_edit_task_status(cJSON *params, Task **disp, size_t disp_cou
     }
     
     // Use task manager to update status
-    if (task_manager_update_task(target_task, NULL, -1, NULL, 0, -1, new_status) == 0) {
+    if (task_manager_update_task(target_task, NULL, -1, DUE_NONE, NULL, 0, -1, new_status) == 0) {
         utils_show_message("Task status updated.", LINES - 2, 2);
         return ACTION_SUCCESS;
     } else {
@@ -316,7 +337,7 @@ ActionResult handle_selected_task(cJSON *params, Task ***tasks, size_t *count,
    
     if (strcmp(nested_action, "mark_done") == 0) {
         // Update task status using task manager
-        if (task_manager_update_task(selected_task, NULL, -1, NULL, 0, -1, STATUS_DONE) == 0) {
+        if (task_manager_update_task(selected_task, NULL, -1, DUE_NONE, NULL, 0, -1, STATUS_DONE) == 0) {
             utils_show_message("Selected task marked as done.", LINES - 2, 2);
             return ACTION_SUCCESS;
         } else {
@@ -362,9 +383,10 @@ ActionResult handle_selected_task(cJSON *params, Task ***tasks, size_t *count,
         
         // Parse due date
         time_t due_time = -1; // -1 means don't change
+        DueKind due_kind = DUE_NONE;
         if (due) {
             if (cJSON_IsString(due)) {
-                due_time = utils_parse_date(due->valuestring);
+                due_time = parse_due_string(due->valuestring, &due_kind);
             } else if (cJSON_IsNull(due)) {
                 due_time = 0; // Explicit null means clear the due date
             }
@@ -396,7 +418,7 @@ ActionResult handle_selected_task(cJSON *params, Task ***tasks, size_t *count,
         }
         
         // Update the task
-        if (task_manager_update_task(selected_task, new_name, due_time, 
+        if (task_manager_update_task(selected_task, new_name, due_time, due_kind, 
                                    update_tags ? tag_ptrs : NULL, 
                                    tag_count, prio, task_status) == 0) {
             utils_show_message("Selected task updated.", LINES - 2, 2);
@@ -607,7 +629,7 @@ ActionResult handle_add_project(cJSON *params, char ***projects, size_t *project
     
     if (task_manager_add_project(name_item->valuestring) == 0) {
         task_manager_save_projects();
-        free(*projects);
+        utils_free(*projects);
         *project_count = task_manager_get_projects(projects);
         *selected_project_idx = *project_count - 1;
         *current_project = (*projects)[*selected_project_idx];
@@ -631,11 +653,17 @@ ActionResult handle_delete_project(cJSON *params, char ***projects, size_t *proj
         utils_show_message("Project name missing or invalid", LINES-2, 2);
         return ACTION_ERROR;
     }
+
+    // The chat always shows some project; the last one stays
+    if (*project_count <= 1) {
+        utils_show_message("The last project cannot be deleted", LINES-2, 2);
+        return ACTION_ERROR;
+    }
     
     int del_result = task_manager_delete_project(name_item->valuestring, tasks, count);
     if (del_result == 0) {
         task_manager_save_projects();
-        free(*projects);
+        utils_free(*projects);
         *project_count = task_manager_get_projects(projects);
         if (*selected_project_idx >= *project_count) *selected_project_idx = *project_count - 1;
         *current_project = (*projects)[*selected_project_idx];
@@ -672,7 +700,10 @@ ActionResult handle_add_note(cJSON *params, Task **disp, size_t disp_count, char
     
     // Set the note on the task
     Task *task = disp[idx];
-    if (task_set_note(task, note_item->valuestring) != 0) {
+    task_manager_notify_before_change(TASK_CHANGE_PUT, task);
+    int rc = task_set_note(task, note_item->valuestring);
+    task_manager_notify_change(TASK_CHANGE_PUT, task);
+    if (rc != 0) {
         snprintf(last_error, MAX_ERR_LEN, "Failed to set note for task");
         return ACTION_ERROR;
     }
@@ -734,6 +765,25 @@ ActionResult handle_view_note(cJSON *params, Task **disp, size_t disp_count, cha
     return ACTION_SUCCESS;
 }
 
+// Undo the newest change, or redo the change undone last
+ActionResult handle_undo(Task ***tasks, size_t *count, bool redo, char *last_error) {
+    char label[UNDO_LABEL_LEN];
+    int rc = redo ? undo_redo(tasks, count, label, sizeof(label)) : undo_undo(tasks, count, label, sizeof(label));
+    if (rc == 0) {
+        snprintf(last_error, MAX_ERR_LEN, redo ? "Nothing to redo." : "Nothing to undo.");
+        return ACTION_ERROR;
+    }
+    if (rc < 0) {
+        snprintf(last_error, MAX_ERR_LEN, "Could not fully %s '%s'.", redo ? "redo" : "undo", label);
+        return ACTION_ERROR;
+    }
+
+    char msg[UNDO_LABEL_LEN + 16];
+    snprintf(msg, sizeof(msg), "%s: %s", redo ? "Redone" : "Undone", label);
+    utils_show_message(msg, LINES - 2, 1);
+    return ACTION_SUCCESS;
+}
+
 // Handle exit command
 ActionResult handle_exit(cJSON *params, char *last_error) {
     (void)params; // Suppress unused parameter warning
@@ -743,3 +793,80 @@ ActionResult handle_exit(cJSON *params, char *last_error) {
     utils_show_message("Exiting AI chat mode...", LINES - 2, 1);
     return ACTION_EXIT;
 }
+
+// Helper: run one action on the session; filters reset the selection
+static ActionResult dispatch_action(const char *action, cJSON *params, ActionContext *ctx, char *last_error) {
+    ActionResult result;
+    if (strcmp(action, "add_task") == 0) {
+        return handle_add_task(params, ctx->tasks, ctx->count, *ctx->current_project, last_error);
+    } else if (strcmp(action, "delete_task") == 0) {
+        return handle_delete_task(params, ctx->tasks, ctx->count, ctx->disp, ctx->disp_count, ctx->selected, last_error);
+    } else if (strcmp(action, "edit_task") == 0) {
+        return handle_edit_task(params, ctx->disp, ctx->disp_count, last_error);
+    } else if (strcmp(action, "mark_done") == 0) {
+        return handle_mark_done(params, ctx->disp, ctx->disp_count, last_error);
+    } else if (strcmp(action, "edit_task_status") == 0) {
+        return handle_edit_task_status(params, ctx->disp, ctx->disp_count, last_error);
+    } else if (strcmp(action, "selected_task") == 0) {
+        return handle_selected_task(params, ctx->tasks, ctx->count, ctx->disp, ctx->disp_count,
+                                    ctx->selected, ctx->selected, last_error);
+    } else if (strcmp(action, "sort_tasks") == 0) {
+        return handle_sort_tasks(params, *ctx->tasks, *ctx->count, last_error);
+    } else if (strcmp(action, "filter_by_date") == 0) {
+        result = handle_filter_by_date(params, ctx->search_term, ctx->term_size, last_error);
+    } else if (strcmp(action, "filter_by_priority") == 0) {
+        result = handle_filter_by_priority(params, ctx->search_term, ctx->term_size, last_error);
+    } else if (strcmp(action, "filter_by_status") == 0) {
+        result = handle_filter_by_status(params, ctx->search_term, ctx->term_size, last_error);
+    } else if (strcmp(action, "filter_combined") == 0) {
+        result = handle_filter_combined(params, ctx->search_term, ctx->term_size, last_error);
+    } else if (strcmp(action, "search_tasks") == 0) {
+        result = handle_search_tasks(params, ctx->search_term, ctx->term_size, last_error);
+    } else if (strcmp(action, "list_tasks") == 0) {
+        result = handle_list_tasks(ctx->search_term, last_error);
+    } else if (strcmp(action, "add_note") == 0) {
+        return handle_add_note(params, ctx->disp, ctx->disp_count, last_error);
+    } else if (strcmp(action, "view_note") == 0) {
+        return handle_view_note(params, ctx->disp, ctx->disp_count, last_error);
+    } else if (strcmp(action, "add_project") == 0) {
+        return handle_add_project(params, ctx->projects, ctx->project_count, ctx->selected_project_idx,
+                                  ctx->current_project, *ctx->tasks, *ctx->count, last_error);
+    } else if (strcmp(action, "delete_project") == 0) {
+        return handle_delete_project(params, ctx->projects, ctx->project_count, ctx->selected_project_idx,
+                                     ctx->current_project, *ctx->tasks, *ctx->count, last_error);
+    } else if (strcmp(action, "undo") == 0 || strcmp(action, "redo") == 0) {
+        return handle_undo(ctx->tasks, ctx->count, action[0] == 'r', last_error);
+    } else if (strcmp(action, "exit") == 0) {
+        return handle_exit(params, last_error);
+    } else {
+        snprintf(last_error, MAX_ERR_LEN, "Unknown action '%s' received from AI.", action);
+        return ACTION_ERROR;
+    }
+    if (result == ACTION_SUCCESS) *ctx->selected = 0;
+    return result;
+}
+
+ActionResult handle_ai_response(const char *content, ActionContext *ctx, char *last_error) {
+    cJSON *root = cJSON_Parse(content);
+    if (!root) {
+        snprintf(last_error, MAX_ERR_LEN, "AI response was not valid JSON");
+        return ACTION_ERROR;
+    }
+
+    cJSON *action_item = cJSON_GetObjectItemCaseSensitive(root, "action");
+    cJSON *params_item = cJSON_GetObjectItemCaseSensitive(root, "params");
+    if (!cJSON_IsString(action_item) || !cJSON_IsObject(params_item)) {
+        utils_show_message("Request not understood. No action taken.", LINES-2, 2);
+        cJSON_Delete(root);
+        return ACTION_ERROR;
+    }
+
+    const char *action = action_item->valuestring;
+    undo_begin(action);
+    trace_begin("ai_chat_action");
+    ActionResult result = dispatch_action(action, params_item, ctx, last_error);
+    trace_end("ai_chat_action");
+    undo_end();
+    cJSON_Delete(root);
+    return result;
+}
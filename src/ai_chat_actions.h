@@ -3,6 +3,7 @@
 
 #include <cjson/cJSON.h>
 #include "task.h"
+#include <stdbool.h>
 
 // Common error message buffer size
 #define MAX_ERR_LEN 256
@@ -83,7 +84,35 @@ ActionResult handle_add_note(cJSON *params, Task **disp, size_t disp_count, char
 // View a note for a task
 ActionResult handle_view_note(cJSON *params, Task **disp, size_t disp_count, char *last_error);
 
+// Undo the newest change, or redo the change undone last
+ActionResult handle_undo(Task ***tasks, size_t *count, bool redo, char *last_error);
+
 // Handle exit command
 ActionResult handle_exit(cJSON *params, char *last_error);
 
+// Chat session state an AI response acts on; owned by the chat loop
+typedef struct {
+    Task ***tasks;
+    size_t *count;
+    Task **disp;                    // Tasks on screen, numbered from 1 for the model
+    size_t disp_count;
+    size_t *selected;
+    char ***projects;
+    size_t *project_count;
+    size_t *selected_project_idx;
+    const char **current_project;
+    char *search_term;
+    size_t term_size;
+} ActionContext;
+
+/**
+ * Carry out an AI response, a JSON object {"action": ..., "params": {...}}.
+ * Whatever the action changes is undone as one step.
+ * @param content Response text of the model
+ * @param ctx Session state to act on
+ * @param last_error[out] Error message buffer of MAX_ERR_LEN bytes
+ * @return Result of the action; ACTION_ERROR for malformed or unknown actions
+ */
+ActionResult handle_ai_response(const char *content, ActionContext *ctx, char *last_error);
+
 #endif // AI_CHAT_ACTIONS_H
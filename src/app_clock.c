@@ -0,0 +1,118 @@
+// localtime_r() is POSIX, not ISO C
+#define _POSIX_C_SOURCE 200809L
+
+#include "app_clock.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static time_t cached_now = 0;
+static time_t fixed_now = 0;
+static bool initialized = false;
+static AppClockDay day = {0};
+
+// Helper: local midnight `days` days after the local day in tm_base
+static time_t local_midnight(const struct tm *tm_base, int days) {
+    struct tm tm = *tm_base;
+    tm.tm_mday += days;
+    tm.tm_hour = 0;
+    tm.tm_min = 0;
+    tm.tm_sec = 0;
+    tm.tm_isdst = -1;
+    return mktime(&tm);
+}
+
+// Helper: recompute the day context for cached_now
+static void recompute_day(void) {
+    struct tm tm_now;
+    localtime_r(&cached_now, &tm_now);
+
+    int days_to_sunday = 7 - tm_now.tm_wday; // Sunday goes to next Sunday
+    int days_to_monday = (7 - tm_now.tm_wday + 1) % 7;
+    if (days_to_monday == 0) days_to_monday = 7; // If today is Monday, go to next Monday
+
+    day.wday = tm_now.tm_wday;
+    day.today_start = local_midnight(&tm_now, 0);
+    day.tomorrow_start = local_midnight(&tm_now, 1);
+    day.tomorrow_end = local_midnight(&tm_now, 2);
+    day.week_end = local_midnight(&tm_now, days_to_sunday + 1);
+    day.next_week_start = local_midnight(&tm_now, days_to_monday);
+    day.next_week_end = local_midnight(&tm_now, days_to_monday + 7);
+}
+
+// Helper: parse the SMARTODO_NOW override
+static bool parse_override(const char *s, time_t *out) {
+    if (s[0] == '@') {
+        char *end;
+        long long v = strtoll(s + 1, &end, 10);
+        if (end == s + 1 || *end != '\0' || v <= 0) return false;
+        *out = (time_t)v;
+        return true;
+    }
+
+    struct tm tm = {0};
+    int n = sscanf(s, "%4d-%2d-%2dT%2d:%2d:%2d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+                   &tm.tm_hour, &tm.tm_min, &tm.tm_sec);
+    if (n != 3 && n != 5 && n != 6) return false;
+    if (n == 3) tm.tm_hour = 12; // Date only: midday, away from DST edges
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    tm.tm_isdst = -1;
+    time_t t = mktime(&tm);
+    if (t == (time_t)-1 || t <= 0) return false;
+    *out = t;
+    return true;
+}
+
+void app_clock_init(void) {
+    const char *override = getenv("SMARTODO_NOW");
+    time_t t;
+    if (override && override[0] != '\0') {
+        if (parse_override(override, &t)) {
+            fixed_now = t;
+        } else {
+            fprintf(stderr, "Ignoring invalid SMARTODO_NOW value: %s\n", override);
+        }
+    }
+    initialized = true;
+    day.today_start = day.tomorrow_start = 0; // Force a day recompute
+    app_clock_tick();
+}
+
+void app_clock_tick(void) {
+    if (!initialized) {
+        app_clock_init();
+        return;
+    }
+    cached_now = fixed_now ? fixed_now : time(NULL);
+    if (cached_now < day.today_start || cached_now >= day.tomorrow_start) {
+        recompute_day();
+    }
+}
+
+time_t app_clock_now(void) {
+    if (!initialized) app_clock_init();
+    return cached_now;
+}
+
+const AppClockDay *app_clock_day(void) {
+    if (!initialized) app_clock_init();
+    return &day;
+}
+
+long long app_clock_local_day(time_t t) {
+    struct tm tm = {0};
+    localtime_r(&t, &tm);
+    return utils_days_from_civil(tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+}
+
+void app_clock_set_fixed(time_t t) {
+    if (!initialized) app_clock_init();
+    fixed_now = t;
+    app_clock_tick();
+}
+
+bool app_clock_is_fixed(void) {
+    return fixed_now != 0;
+}
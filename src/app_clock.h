@@ -0,0 +1,82 @@
+#ifndef APP_CLOCK_H
+#define APP_CLOCK_H
+
+#include <time.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Local-day boundaries for the current clock reading
+ *
+ * All boundaries are local midnights computed with mktime, so they stay
+ * correct across DST changes. Ranges are half-open: [start, end).
+ */
+typedef struct {
+    time_t today_start;      // Midnight today
+    time_t tomorrow_start;   // Midnight tomorrow (end of today)
+    time_t tomorrow_end;     // Midnight the day after tomorrow
+    time_t week_end;         // Midnight after this week's Sunday (next Sunday if today is Sunday)
+    time_t next_week_start;  // Midnight next Monday
+    time_t next_week_end;    // Midnight after next week's Sunday
+    int wday;                // Day of week today (0 = Sunday)
+} AppClockDay;
+
+/**
+ * @brief Initializes the clock, honouring the SMARTODO_NOW override
+ *
+ * SMARTODO_NOW pins the clock to a fixed local time, given as
+ * "YYYY-MM-DD", "YYYY-MM-DDTHH:MM[:SS]" or "@<epoch seconds>".
+ */
+void app_clock_init(void);
+
+/**
+ * @brief Refreshes the cached time; call once per frame or command
+ *
+ * The day context is only recomputed when the local day changes.
+ */
+void app_clock_tick(void);
+
+/**
+ * @brief Returns the cached current time
+ *
+ * @return time_t Time of the last tick (or the fixed time when pinned)
+ */
+time_t app_clock_now(void);
+
+/**
+ * @brief Returns the local-day context for the cached current time
+ *
+ * @return const AppClockDay* Pointer to internal storage, valid until the next tick
+ */
+const AppClockDay *app_clock_day(void);
+
+/**
+ * @brief Returns the local day number of a moment
+ *
+ * @param t Moment
+ * @return long long Days from 1970-01-01 to the local date of t
+ */
+long long app_clock_local_day(time_t t);
+
+/**
+ * @brief Pins the clock to a fixed time for tests and benchmarks
+ *
+ * @param t Fixed time, or 0 to return to the system clock
+ */
+void app_clock_set_fixed(time_t t);
+
+/**
+ * @brief Reports whether the clock is pinned to a fixed time
+ *
+ * @return bool True if a fixed time is in effect
+ */
+bool app_clock_is_fixed(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // APP_CLOCK_H
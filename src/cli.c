@@ -0,0 +1,696 @@
+// localtime_r() and sleep() are POSIX, not ISO C
+#define _POSIX_C_SOURCE 200809L
+
+#include "cli.h"
+#include "task.h"
+#include "task_manager.h"
+#include "storage.h"
+#include "utils.h"
+#include "app_clock.h"
+#include "recurrence.h"
+#include "daemon_client.h"
+#include "journal.h"
+#include "history.h"
+#include <cjson/cJSON.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define CLI_MAX_NAME 256
+
+// Seconds `changes --follow` waits before looking at the journal again
+#define CLI_FOLLOW_INTERVAL 1
+
+// Where a command finds its tasks and writes its output
+typedef struct {
+    CliTasks *set;    // Resident task set, or NULL to load and save through storage
+    FILE *out;
+    FILE *err;
+} CliContext;
+
+// Options shared by all subcommands; each command reads the ones it supports
+typedef struct {
+    const char *project;
+    const char *due;
+    const char *priority;
+    const char *name;
+    const char *note;
+    const char *repeat;
+    const char *status;
+    const char *sort;
+    const char *range;            // Search filter such as "date:overdue"
+    const char *since;
+    const char *limit;
+    const char *at;               // history: moment to show the tasks at
+    const char *from;             // history: range of completions
+    const char *to;
+    const char *tags[MAX_TAGS];
+    size_t tag_count;
+    bool json;
+    bool no_due;
+    bool no_repeat;
+    bool follow;
+    bool completed;
+    char words[CLI_MAX_NAME];     // Positional arguments joined by spaces
+} CliOptions;
+
+// Flags that select a date range, mapped to search filters
+static const struct {
+    const char *flag;
+    const char *filter;
+} RANGE_FLAGS[] = {
+    {"--today", "date:today"},
+    {"--tomorrow", "date:tomorrow"},
+    {"--week", "date:this_week"},
+    {"--next-week", "date:next_week"},
+    {"--overdue", "date:overdue"},
+};
+
+// Options taking a value, with the offset of the field they set
+static const struct {
+    const char *flag;
+    size_t offset;
+} VALUE_FLAGS[] = {
+    {"--project", offsetof(CliOptions, project)},
+    {"--due", offsetof(CliOptions, due)},
+    {"--priority", offsetof(CliOptions, priority)},
+    {"--name", offsetof(CliOptions, name)},
+    {"--note", offsetof(CliOptions, note)},
+    {"--repeat", offsetof(CliOptions, repeat)},
+    {"--status", offsetof(CliOptions, status)},
+    {"--sort", offsetof(CliOptions, sort)},
+    {"--since", offsetof(CliOptions, since)},
+    {"--limit", offsetof(CliOptions, limit)},
+    {"--at", offsetof(CliOptions, at)},
+    {"--from", offsetof(CliOptions, from)},
+    {"--to", offsetof(CliOptions, to)},
+};
+
+static void print_usage(FILE *err) {
+    fprintf(err,
+        "Usage:\n"
+        "  smartodo list [--project P] [--status pending|done|all] [--tag T] [--priority P]\n"
+        "                [--today|--tomorrow|--week|--next-week|--overdue]\n"
+        "                [--sort created|due|name] [--json]\n"
+        "  smartodo search <term> [--project P] [--json]\n"
+        "  smartodo add <name> [--due D] [--tag T]... [--priority P] [--project P]\n"
+        "               [--repeat RULE] [--note N] [--json]\n"
+        "  smartodo edit <id> [--name N] [--due D|--no-due] [--tag T]... [--priority P]\n"
+        "                [--project P] [--repeat RULE|--no-repeat] [--note N]\n"
+        "  smartodo done <id>\n"
+        "  smartodo rm <id>\n"
+        "  smartodo changes [--since SEQ] [--limit N] [--follow]\n"
+        "  smartodo history <id> [--json]\n"
+        "  smartodo history --at WHEN [--json]\n"
+        "  smartodo history --completed [--from WHEN] [--to WHEN] [--json]\n"
+        "Tasks are identified by any unique prefix of their id.\n");
+}
+
+// Helper: parse arguments after the subcommand; returns 0 or -1 on bad usage
+static int parse_options(int argc, char **argv, CliOptions *opts) {
+    memset(opts, 0, sizeof(*opts));
+    size_t used = 0;
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (strncmp(arg, "--", 2) != 0) {
+            // Positional words form the task name or search term
+            size_t len = strlen(arg);
+            if (used + len + 2 > sizeof(opts->words)) return -1;
+            if (used > 0) opts->words[used++] = ' ';
+            memcpy(opts->words + used, arg, len + 1);
+            used += len;
+            continue;
+        }
+        if (strcmp(arg, "--json") == 0) { opts->json = true; continue; }
+        if (strcmp(arg, "--no-due") == 0) { opts->no_due = true; continue; }
+        if (strcmp(arg, "--no-repeat") == 0) { opts->no_repeat = true; continue; }
+        if (strcmp(arg, "--follow") == 0) { opts->follow = true; continue; }
+        if (strcmp(arg, "--completed") == 0) { opts->completed = true; continue; }
+
+        bool matched = false;
+        for (size_t r = 0; r < sizeof(RANGE_FLAGS) / sizeof(RANGE_FLAGS[0]); r++) {
+            if (strcmp(arg, RANGE_FLAGS[r].flag) == 0) {
+                opts->range = RANGE_FLAGS[r].filter;
+                matched = true;
+            }
+        }
+        if (matched) continue;
+
+        if (i + 1 >= argc) return -1;
+        if (strcmp(arg, "--tag") == 0) {
+            if (opts->tag_count >= MAX_TAGS) return -1;
+            opts->tags[opts->tag_count++] = argv[++i];
+            continue;
+        }
+        for (size_t v = 0; v < sizeof(VALUE_FLAGS) / sizeof(VALUE_FLAGS[0]); v++) {
+            if (strcmp(arg, VALUE_FLAGS[v].flag) == 0) {
+                *(const char **)((char *)opts + VALUE_FLAGS[v].offset) = argv[++i];
+                matched = true;
+                break;
+            }
+        }
+        if (!matched) return -1;
+    }
+    return 0;
+}
+
+// Helper: parse a priority name; returns -1 if unknown
+static int parse_priority(const char *s) {
+    if (strcmp(s, "low") == 0) return PRIORITY_LOW;
+    if (strcmp(s, "medium") == 0) return PRIORITY_MEDIUM;
+    if (strcmp(s, "high") == 0) return PRIORITY_HIGH;
+    return -1;
+}
+
+static const char *priority_name(Priority p) {
+    return p == PRIORITY_HIGH ? "high" : p == PRIORITY_MEDIUM ? "medium" : "low";
+}
+
+// Helper: format the due value as local date, or date and time
+static void format_due(const Task *t, char *buf, size_t size) {
+    if (t->due == 0) {
+        snprintf(buf, size, "-");
+    } else if (t->due_kind == DUE_DATE) {
+        task_format_due_date(t, buf, size);
+    } else {
+        struct tm tm = {0};
+        localtime_r(&t->due, &tm);
+        strftime(buf, size, "%Y-%m-%d %H:%M", &tm);
+    }
+}
+
+static void print_task_line(FILE *out, const Task *t) {
+    char due[32];
+    format_due(t, due, sizeof(due));
+    fprintf(out, "%.8s  %s  %-16s  %-6s  %s", t->id, t->status == STATUS_DONE ? "[x]" : "[ ]",
+            due, priority_name(t->priority), t->name);
+    for (size_t i = 0; i < t->tag_count; i++) fprintf(out, "  #%s", t->tags[i]);
+    if (t->recur) fputs("  (R)", out);
+    fprintf(out, "  @%s\n", t->project ? t->project : "default");
+}
+
+// Helper: print tasks as plain lines or one JSON array
+static int print_tasks(FILE *out, Task **tasks, size_t count, bool json) {
+    if (!json) {
+        for (size_t i = 0; i < count; i++) print_task_line(out, tasks[i]);
+        return 0;
+    }
+    cJSON *arr = cJSON_CreateArray();
+    if (!arr) return 1;
+    for (size_t i = 0; i < count; i++) {
+        cJSON *obj = task_to_cjson(tasks[i]);
+        if (obj) cJSON_AddItemToArray(arr, obj);
+    }
+    char *text = cJSON_PrintUnformatted(arr);
+    cJSON_Delete(arr);
+    if (!text) return 1;
+    fprintf(out, "%s\n", text);
+    utils_free(text);
+    return 0;
+}
+
+// Helper: parse a due string; returns 0 and sets due/kind, or -1 if invalid
+static int parse_due(FILE *err, const char *s, time_t *due, DueKind *kind) {
+    bool date_only = false;
+    *due = utils_parse_due(s, &date_only);
+    if (*due == 0) {
+        fprintf(err, "Invalid due date: %s\n", s);
+        return -1;
+    }
+    *kind = date_only ? DUE_DATE : DUE_DATETIME;
+    return 0;
+}
+
+// Helper: find a task by unique id prefix; prints the error and returns -1
+static int find_task(FILE *err, Task **tasks, size_t count, const char *prefix, size_t *index) {
+    size_t len = strlen(prefix);
+    size_t matches = 0;
+    for (size_t i = 0; len > 0 && i < count; i++) {
+        if (tasks[i]->id && strncmp(tasks[i]->id, prefix, len) == 0) {
+            *index = i;
+            matches++;
+        }
+    }
+    if (matches == 1) return 0;
+    fprintf(err, matches == 0 ? "No task with id '%s'\n" : "Task id '%s' is ambiguous\n", prefix);
+    return -1;
+}
+
+// Helper: check that a repeat rule parses before anything is changed
+static int check_repeat(FILE *err, const char *rule) {
+    Recurrence r;
+    if (recurrence_parse(rule, &r) == 0) return 0;
+    fprintf(err, "Invalid repeat rule: %s\n", rule);
+    return -1;
+}
+
+// Helper: register a project so the TUI lists it
+static void remember_project(const char *project) {
+    task_manager_load_projects();
+    task_manager_add_project(project);
+    task_manager_save_projects();
+}
+
+// Helper: get the full task set for a change, loading it when not resident
+static int open_tasks(const CliContext *ctx, Task ***tasks, size_t *count) {
+    if (ctx->set) {
+        *tasks = ctx->set->tasks;
+        *count = ctx->set->count;
+        return 0;
+    }
+    if (task_manager_init() != 0) {
+        fprintf(ctx->err, "Failed to initialize task manager.\n");
+        return -1;
+    }
+    *tasks = task_manager_load_tasks(count);
+    if (!*tasks) {
+        fprintf(ctx->err, "Failed to load tasks.\n");
+        return -1;
+    }
+    return 0;
+}
+
+// Helper: finish a change: save a loaded set, or hand the array back to the
+// resident set (whose changes the change hook has already recorded)
+static int close_tasks(const CliContext *ctx, Task **tasks, size_t count, bool save) {
+    if (ctx->set) {
+        ctx->set->tasks = tasks;
+        ctx->set->count = count;
+        return 0;
+    }
+    int rc = 0;
+    if (save && task_manager_save_tasks(tasks, count) != 0) {
+        fprintf(ctx->err, "Failed to save tasks.\n");
+        rc = -1;
+    }
+    task_manager_cleanup(tasks, count);
+    return rc;
+}
+
+// list and search: load only the project/status slice the query can match
+static int cmd_list(const CliContext *ctx, const CliOptions *opts, bool search) {
+    if (search && opts->words[0] == '\0') return 2;
+
+    StorageQuery query = {opts->project, -1};
+    const char *status = opts->status ? opts->status : (opts->range && strcmp(opts->range, "date:overdue") == 0 ? "pending" : "all");
+    if (strcmp(status, "pending") == 0) query.status = STATUS_PENDING;
+    else if (strcmp(status, "done") == 0) query.status = STATUS_DONE;
+    else if (strcmp(status, "all") != 0) return 2;
+
+    int priority = -1;
+    if (opts->priority && (priority = parse_priority(opts->priority)) < 0) return 2;
+    const char *sort = opts->sort ? opts->sort : "created";
+    if (strcmp(sort, "created") != 0 && strcmp(sort, "due") != 0 && strcmp(sort, "name") != 0) return 2;
+
+    size_t count = 0;
+    Task **tasks = ctx->set ? ctx->set->tasks : storage_load_tasks_query(&query, &count);
+    if (ctx->set) count = ctx->set->count;
+    if (!tasks) {
+        fprintf(ctx->err, "Failed to load tasks.\n");
+        return 1;
+    }
+    Task **shown = utils_malloc((count + 1) * sizeof(Task *));
+    if (!shown) {
+        if (!ctx->set) storage_free_tasks(tasks, count);
+        return 1;
+    }
+
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++) {
+        Task *t = tasks[i];
+        // A resident set is unfiltered; a loaded one already passed the query
+        if (query.project && strcmp(t->project ? t->project : "default", query.project) != 0) continue;
+        if (query.status >= 0 && t->status != (Status)query.status) continue;
+        if (priority >= 0 && t->priority != (Priority)priority) continue;
+        if (opts->range && !task_matches_search(t, opts->range)) continue;
+        if (search && !task_matches_search(t, opts->words)) continue;
+        bool tagged = true;
+        for (size_t k = 0; k < opts->tag_count && tagged; k++) tagged = task_has_tag(t, opts->tags[k]);
+        if (!tagged) continue;
+        shown[n++] = t;
+    }
+
+    if (strcmp(sort, "due") == 0) task_manager_sort_by_due(shown, n);
+    else if (strcmp(sort, "name") == 0) task_manager_sort_by_name(shown, n);
+
+    int rc = print_tasks(ctx->out, shown, n, opts->json);
+    utils_free(shown);
+    if (!ctx->set) storage_free_tasks(tasks, count);
+    return rc;
+}
+
+static int cmd_add(const CliContext *ctx, const CliOptions *opts) {
+    if (opts->words[0] == '\0') return 2;
+    int priority = PRIORITY_LOW;
+    if (opts->priority && (priority = parse_priority(opts->priority)) < 0) return 2;
+
+    time_t due = 0;
+    DueKind kind = DUE_NONE;
+    if (opts->due && parse_due(ctx->err, opts->due, &due, &kind) != 0) return 1;
+    if (opts->repeat) {
+        if (due == 0) {
+            fprintf(ctx->err, "A repeating task needs a due date.\n");
+            return 1;
+        }
+        if (check_repeat(ctx->err, opts->repeat) != 0) return 1;
+    }
+
+    Task **tasks;
+    size_t count;
+    if (open_tasks(ctx, &tasks, &count) != 0) return 1;
+
+    const char *project = opts->project ? opts->project : "default";
+    const char *tags[MAX_TAGS];
+    memcpy(tags, opts->tags, sizeof(tags));
+    int rc = 1;
+    if (task_manager_add_task(&tasks, &count, opts->words, due, kind, tags, opts->tag_count,
+                              (Priority)priority, project) != 0) {
+        fprintf(ctx->err, "Failed to add task.\n");
+        goto out;
+    }
+    Task *t = tasks[count - 1];
+    if (opts->repeat && task_set_recurrence(t, opts->repeat) != 0) goto out;
+    if (opts->note && task_set_note(t, opts->note) != 0) goto out;
+    if (opts->repeat || opts->note) task_manager_notify_change(TASK_CHANGE_PUT, t);
+
+    if (opts->json) {
+        rc = print_tasks(ctx->out, &t, 1, true);
+    } else {
+        fprintf(ctx->out, "%s\n", t->id);
+        rc = 0;
+    }
+out:
+    if (close_tasks(ctx, tasks, count, rc == 0) != 0) rc = 1;
+    if (rc == 0 && opts->project) remember_project(project);
+    return rc;
+}
+
+// done, edit and rm: change one task in the full set
+static int cmd_modify(const CliContext *ctx, const char *command, const CliOptions *opts) {
+    if (opts->words[0] == '\0' || strchr(opts->words, ' ')) return 2;
+
+    int priority = -1;
+    if (opts->priority && (priority = parse_priority(opts->priority)) < 0) return 2;
+    time_t due = -1;
+    DueKind kind = DUE_NONE;
+    if (opts->no_due) due = 0;
+    else if (opts->due && parse_due(ctx->err, opts->due, &due, &kind) != 0) return 1;
+    if (opts->repeat && check_repeat(ctx->err, opts->repeat) != 0) return 1;
+
+    Task **tasks;
+    size_t count;
+    if (open_tasks(ctx, &tasks, &count) != 0) return 1;
+
+    int rc = 1;
+    size_t index = 0;
+    if (find_task(ctx->err, tasks, count, opts->words, &index) != 0) goto out;
+    Task *t = tasks[index];
+    char due_str[32];
+
+    if (strcmp(command, "done") == 0) {
+        if (t->status == STATUS_DONE) {
+            fprintf(ctx->err, "Task '%s' is already done.\n", t->name);
+            goto out;
+        }
+        if (task_manager_complete_task(t) == STATUS_PENDING) {
+            format_due(t, due_str, sizeof(due_str));
+            fprintf(ctx->out, "Completed occurrence of '%s'; next due %s\n", t->name, due_str);
+        } else {
+            fprintf(ctx->out, "Completed '%s'\n", t->name);
+        }
+    } else if (strcmp(command, "rm") == 0) {
+        fprintf(ctx->out, "Removed '%s'\n", t->name);
+        if (task_manager_delete_task(&tasks, &count, index) != 0) goto out;
+    } else {
+        // Checked up front so a resident set is never left half-edited
+        if (opts->repeat && (due == 0 || (due < 0 && t->due == 0))) {
+            fprintf(ctx->err, "A repeating task needs a due date.\n");
+            goto out;
+        }
+        const char *tags[MAX_TAGS];
+        memcpy(tags, opts->tags, sizeof(tags));
+        if (task_manager_update_task(t, opts->name, due, kind,
+                                     opts->tag_count > 0 ? tags : NULL, opts->tag_count,
+                                     priority, -1) != 0) {
+            goto out;
+        }
+        if (opts->project) {
+            char *project = utils_strdup(opts->project);
+            if (!project) goto out;
+            utils_free(t->project);
+            t->project = project;
+        }
+        if (opts->note && task_set_note(t, opts->note) != 0) goto out;
+        if (opts->no_repeat || t->due == 0) task_set_recurrence(t, NULL);
+        if (opts->repeat && task_set_recurrence(t, opts->repeat) != 0) goto out;
+        if (opts->project || opts->note || opts->repeat || opts->no_repeat) {
+            task_manager_notify_change(TASK_CHANGE_PUT, t);
+        }
+        print_task_line(ctx->out, t);
+    }
+    rc = 0;
+out:
+    if (close_tasks(ctx, tasks, count, rc == 0) != 0) rc = 1;
+    if (rc == 0 && opts->project) remember_project(opts->project);
+    return rc;
+}
+
+// Helper: parse a non-negative decimal number; returns -1 if malformed
+static int parse_count(const char *s, unsigned long long *value) {
+    char *end;
+    if (!s[0] || s[0] == '-') return -1;
+    *value = strtoull(s, &end, 10);
+    return *end == '\0' ? 0 : -1;
+}
+
+// changes: print the change feed (journal.h) as JSON lines, one per event.
+// Reads the journal directly, so it never waits on (or holds up) the daemon.
+static int cmd_changes(const CliContext *ctx, const CliOptions *opts) {
+    unsigned long long since = 0, limit = 0;
+    if (opts->words[0] != '\0') return 2;
+    if (opts->since && parse_count(opts->since, &since) != 0) return 2;
+    if (opts->limit && parse_count(opts->limit, &limit) != 0) return 2;
+
+    for (;;) {
+        unsigned long long next;
+        bool gap;
+        cJSON *events = journal_changes(since, (size_t)limit, &next, &gap);
+        if (!events) {
+            fprintf(ctx->err, "Failed to read the journal.\n");
+            return 1;
+        }
+        if (gap) {
+            fprintf(ctx->err, "Changes after %llu are no longer kept; reload all tasks and resume from %llu.\n",
+                    since, next);
+        }
+        const cJSON *event;
+        cJSON_ArrayForEach(event, events) {
+            char *text = cJSON_PrintUnformatted(event);
+            if (text) fprintf(ctx->out, "%s\n", text);
+            utils_free(text);
+        }
+        bool caught_up = cJSON_GetArraySize(events) == 0;
+        cJSON_Delete(events);
+        since = next;
+        if (!opts->follow) return 0;
+        fflush(ctx->out);
+        if (caught_up) sleep(CLI_FOLLOW_INTERVAL);
+    }
+}
+
+// Helper: parse a history time; a date alone means the start of that local
+// day, or its end when end_of_day is set. Returns -1 if invalid.
+static int parse_when(FILE *err, const char *s, bool end_of_day, time_t *when) {
+    bool date_only = false;
+    *when = utils_parse_due(s, &date_only);
+    if (*when == 0) {
+        fprintf(err, "Invalid time: %s\n", s);
+        return -1;
+    }
+    if (date_only) {
+        // Date-only input comes back as midnight UTC of the date
+        struct tm utc = {0}, local = {0};
+        gmtime_r(when, &utc);
+        local.tm_year = utc.tm_year;
+        local.tm_mon = utc.tm_mon;
+        local.tm_mday = utc.tm_mday + (end_of_day ? 1 : 0);
+        local.tm_isdst = -1;
+        *when = mktime(&local) - (end_of_day ? 1 : 0);
+    }
+    return 0;
+}
+
+static void format_time(time_t t, char *buf, size_t size) {
+    struct tm tm = {0};
+    localtime_r(&t, &tm);
+    strftime(buf, size, "%Y-%m-%d %H:%M", &tm);
+}
+
+// Helper: print one history event as "when  type  field: old -> new, ..."
+static void print_event(FILE *out, const cJSON *event) {
+    char when[32];
+    format_time((time_t)cJSON_GetNumberValue(cJSON_GetObjectItem(event, "ts")), when, sizeof(when));
+    const char *type = cJSON_GetStringValue(cJSON_GetObjectItem(event, "type"));
+    const cJSON *changes = cJSON_GetObjectItem(event, "changes");
+    fprintf(out, "%s  #%-5.0f %-6s", when, cJSON_GetNumberValue(cJSON_GetObjectItem(event, "seq")), type);
+    if (type && strcmp(type, "add") == 0) {
+        const cJSON *name = cJSON_GetObjectItem(cJSON_GetObjectItem(changes, "name"), "to");
+        fprintf(out, "  '%s'\n", cJSON_IsString(name) ? name->valuestring : "");
+        return;
+    }
+    const char *sep = "  ";
+    const cJSON *change;
+    cJSON_ArrayForEach(change, changes) {
+        char *from = cJSON_PrintUnformatted(cJSON_GetObjectItem(change, "from"));
+        char *to = cJSON_PrintUnformatted(cJSON_GetObjectItem(change, "to"));
+        fprintf(out, "%s%s: %s -> %s", sep, change->string, from ? from : "?", to ? to : "?");
+        utils_free(from);
+        utils_free(to);
+        sep = ", ";
+    }
+    fputc('\n', out);
+}
+
+// Helper: print a JSON array as one line per element
+static void print_json_lines(FILE *out, const cJSON *arr) {
+    const cJSON *item;
+    cJSON_ArrayForEach(item, arr) {
+        char *text = cJSON_PrintUnformatted(item);
+        if (text) fprintf(out, "%s\n", text);
+        utils_free(text);
+    }
+}
+
+// history: a task's field-level changes, the tasks as of a moment, or the
+// completions in a range (history.h). Reads the journal directly, like changes.
+static int cmd_history(const CliContext *ctx, const CliOptions *opts) {
+    int modes = (opts->words[0] != '\0') + (opts->at != NULL) + opts->completed;
+    if (modes != 1 || ((opts->from || opts->to) && !opts->completed)) return 2;
+
+    if (opts->at) {
+        time_t at;
+        if (parse_when(ctx->err, opts->at, true, &at) != 0) return 1;
+        size_t count = 0;
+        Task **tasks = history_state_at(at, &count);
+        if (!tasks) {
+            fprintf(ctx->err, "Failed to read the history.\n");
+            return 1;
+        }
+        task_manager_sort_by_due(tasks, count);
+        int rc = print_tasks(ctx->out, tasks, count, opts->json);
+        storage_free_tasks(tasks, count);
+        return rc;
+    }
+
+    cJSON *items;
+    if (opts->completed) {
+        time_t to = app_clock_now(), from = to - 7 * 24 * 60 * 60;
+        if (opts->from && parse_when(ctx->err, opts->from, false, &from) != 0) return 1;
+        if (opts->to && parse_when(ctx->err, opts->to, true, &to) != 0) return 1;
+        items = history_completed(opts->from ? from - 1 : from, to);
+    } else {
+        size_t matches = 0;
+        items = history_task(opts->words, &matches);
+        if (items && matches != 1) {
+            fprintf(ctx->err, matches == 0 ? "No task with id '%s' in the history\n"
+                                           : "Task id '%s' is ambiguous\n", opts->words);
+            cJSON_Delete(items);
+            return 1;
+        }
+    }
+    if (!items) {
+        fprintf(ctx->err, "Failed to read the history.\n");
+        return 1;
+    }
+
+    if (opts->json) {
+        print_json_lines(ctx->out, items);
+    } else if (opts->completed) {
+        const cJSON *entry;
+        cJSON_ArrayForEach(entry, items) {
+            Task *t = task_from_cjson(cJSON_GetObjectItem(entry, "task"));
+            if (!t) continue;
+            char when[32];
+            format_time((time_t)cJSON_GetNumberValue(cJSON_GetObjectItem(entry, "ts")), when, sizeof(when));
+            fprintf(ctx->out, "%s  ", when);
+            print_task_line(ctx->out, t);
+            task_free(t);
+        }
+    } else {
+        const cJSON *event;
+        cJSON_ArrayForEach(event, items) print_event(ctx->out, event);
+    }
+    cJSON_Delete(items);
+    return 0;
+}
+
+// Helper: run the command in the daemon if one is running; returns 0 and
+// sets *status when it did
+static int forward_to_daemon(int argc, char **argv, int *status) {
+    cJSON *request = cJSON_CreateObject();
+    if (!request) return -1;
+    cJSON_AddStringToObject(request, "op", "cli");
+    cJSON *args = cJSON_AddArrayToObject(request, "argv");
+    for (int i = 0; args && i < argc; i++) {
+        cJSON_AddItemToArray(args, cJSON_CreateString(argv[i]));
+    }
+    cJSON *response = NULL;
+    int rc = daemon_client_request(request, &response);
+    cJSON_Delete(request);
+    if (rc == DAEMON_CLIENT_UNAVAILABLE) return -1;
+    if (rc != 0) {
+        *status = 1;
+        return 0;
+    }
+    const cJSON *out = cJSON_GetObjectItem(response, "out");
+    const cJSON *err = cJSON_GetObjectItem(response, "err");
+    const cJSON *code = cJSON_GetObjectItem(response, "status");
+    if (cJSON_IsString(out)) fputs(out->valuestring, stdout);
+    if (cJSON_IsString(err)) fputs(err->valuestring, stderr);
+    *status = cJSON_IsNumber(code) ? code->valueint : 1;
+    cJSON_Delete(response);
+    return 0;
+}
+
+bool cli_is_command(const char *name) {
+    static const char *const COMMANDS[] = {"list", "add", "done", "edit", "rm", "search", "changes", "history"};
+    for (size_t i = 0; name && i < sizeof(COMMANDS) / sizeof(COMMANDS[0]); i++) {
+        if (strcmp(name, COMMANDS[i]) == 0) return true;
+    }
+    return false;
+}
+
+bool cli_is_forwarded(const char *name) {
+    return cli_is_command(name) && strcmp(name, "changes") != 0 && strcmp(name, "history") != 0;
+}
+
+int cli_execute(CliTasks *set, int argc, char **argv, FILE *out, FILE *err) {
+    CliOptions opts;
+    if (argc < 1 || !cli_is_command(argv[0]) || parse_options(argc, argv, &opts) != 0) {
+        print_usage(err);
+        return 2;
+    }
+    app_clock_tick();
+
+    CliContext ctx = {set, out, err};
+    const char *command = argv[0];
+    int rc;
+    if (strcmp(command, "list") == 0) rc = cmd_list(&ctx, &opts, false);
+    else if (strcmp(command, "search") == 0) rc = cmd_list(&ctx, &opts, true);
+    else if (strcmp(command, "add") == 0) rc = cmd_add(&ctx, &opts);
+    else if (strcmp(command, "changes") == 0) rc = cmd_changes(&ctx, &opts);
+    else if (strcmp(command, "history") == 0) rc = cmd_history(&ctx, &opts);
+    else rc = cmd_modify(&ctx, command, &opts);
+
+    if (rc == 2) print_usage(err);
+    return rc;
+}
+
+int cli_main(int argc, char **argv) {
+    int status;
+    if (argc > 0 && cli_is_forwarded(argv[0]) && forward_to_daemon(argc, argv, &status) == 0) return status;
+    return cli_execute(NULL, argc, argv, stdout, stderr);
+}
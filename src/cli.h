@@ -0,0 +1,56 @@
+#ifndef TODO_APP_CLI_H
+#define TODO_APP_CLI_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "task.h"
+
+/**
+ * Resident task set a command can run against instead of storage.
+ * Changes are reported through the task_manager change hook.
+ */
+typedef struct {
+    Task **tasks;     // NULL-terminated array, reallocated by add/rm
+    size_t count;
+} CliTasks;
+
+/**
+ * Check whether a word names a non-interactive subcommand
+ * (list, add, done, edit, rm, search, changes, history).
+ * @param name First command-line argument
+ * @return true if cli_main() handles it
+ */
+bool cli_is_command(const char *name);
+
+/**
+ * Check whether a subcommand runs in the daemon when one is running.
+ * changes and history read the journal themselves and may wait on it
+ * (changes --follow), so they always run in the calling process.
+ * @param name First command-line argument
+ * @return true if cli_main() forwards it
+ */
+bool cli_is_forwarded(const char *name);
+
+/**
+ * Run a subcommand against a resident task set or against storage.
+ * @param set Resident tasks, or NULL to load (and save) through storage
+ * @param argc Argument count, starting at the subcommand
+ * @param argv Arguments; argv[0] is the subcommand
+ * @param out Stream for normal output
+ * @param err Stream for error messages
+ * @return Exit status: 0 on success, 1 on failure, 2 on usage errors
+ */
+int cli_execute(CliTasks *set, int argc, char **argv, FILE *out, FILE *err);
+
+/**
+ * Run a non-interactive subcommand without starting the TUI. The command
+ * runs inside the daemon when one is running; otherwise read-only commands
+ * load only the tasks their query can match.
+ * @param argc Argument count, starting at the subcommand
+ * @param argv Arguments; argv[0] is the subcommand
+ * @return Exit status: 0 on success, 1 on failure, 2 on usage errors
+ */
+int cli_main(int argc, char **argv);
+
+#endif // TODO_APP_CLI_H
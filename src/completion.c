@@ -0,0 +1,341 @@
+#include "completion.h"
+#include "storage.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+
+// Words completed in the first position
+static const char *const COMMANDS =
+    "list search add done edit rm changes history stats sync daemon remind ai-chat ai-add ai-usage completion";
+
+// Options each subcommand accepts
+static const struct {
+    const char *command;
+    const char *flags;
+} COMMAND_FLAGS[] = {
+    {"list", "--project --status --tag --priority --today --tomorrow --week --next-week --overdue --sort --json"},
+    {"search", "--project --json"},
+    {"add", "--due --tag --priority --project --repeat --note --json"},
+    {"edit", "--name --due --no-due --tag --priority --project --repeat --no-repeat --note"},
+    {"changes", "--since --limit --follow"},
+    {"history", "--at --completed --from --to --json"},
+    {"stats", "--days --json"},
+    {"ai-usage", "--latency --days --json"},
+    {"daemon", "--http"},
+};
+
+// Options taking a value, with the fixed values offered for it (NULL: none)
+static const struct {
+    const char *flag;
+    const char *values;
+} VALUE_FLAGS[] = {
+    {"--priority", "low medium high"},
+    {"--status", "pending done all"},
+    {"--sort", "created due name"},
+    {"--repeat", "daily weekly weekdays monthly yearly"},
+    {"--due", "today tomorrow"},
+    {"--project", NULL},
+    {"--tag", NULL},
+    {"--name", NULL},
+    {"--note", NULL},
+    {"--since", NULL},
+    {"--limit", NULL},
+    {"--at", "today yesterday"},
+    {"--from", "today yesterday"},
+    {"--to", "today yesterday"},
+    {"--days", "7 14 30"},
+};
+
+// Distinct strings by open addressing; the strings are borrowed
+typedef struct {
+    const char **slots;
+    size_t cap;
+} StringSet;
+
+// Helper: size the set for at most `expected` insertions
+static int set_init(StringSet *set, size_t expected) {
+    set->cap = 16;
+    while (set->cap < 2 * expected + 2) set->cap *= 2;
+    set->slots = utils_calloc(set->cap, sizeof(const char *));
+    return set->slots ? 0 : -1;
+}
+
+static void set_add(StringSet *set, const char *s) {
+    if (!s || !*s) return;
+    size_t i = utils_fnv1a_str(s) & (set->cap - 1);
+    while (set->slots[i]) {
+        if (strcmp(set->slots[i], s) == 0) return;
+        i = (i + 1) & (set->cap - 1);
+    }
+    set->slots[i] = s;
+}
+
+static int compare_strings(const void *a, const void *b) {
+    return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+// Helper: write a field, turning the tabs and newlines the format uses into spaces
+static void put_field(FILE *f, const char *s) {
+    for (; *s; s++) fputc((*s == '\t' || *s == '\n' || *s == '\r') ? ' ' : *s, f);
+}
+
+// Helper: write the set's strings in sorted order, one "<kind>\t<string>" line each
+static int write_set(FILE *f, const StringSet *set, char kind) {
+    size_t n = 0;
+    for (size_t i = 0; i < set->cap; i++) n += set->slots[i] != NULL;
+    const char **sorted = utils_malloc((n + 1) * sizeof(const char *));
+    if (!sorted) return -1;
+    n = 0;
+    for (size_t i = 0; i < set->cap; i++) {
+        if (set->slots[i]) sorted[n++] = set->slots[i];
+    }
+    qsort(sorted, n, sizeof(const char *), compare_strings);
+    for (size_t i = 0; i < n; i++) {
+        fprintf(f, "%c\t", kind);
+        put_field(f, sorted[i]);
+        fputc('\n', f);
+    }
+    utils_free(sorted);
+    return 0;
+}
+
+// Helper: restore the min-heap (oldest at the root) below index i
+static void sift_down(const Task **heap, size_t n, size_t i) {
+    for (;;) {
+        size_t smallest = i, l = 2 * i + 1, r = 2 * i + 2;
+        if (l < n && heap[l]->created < heap[smallest]->created) smallest = l;
+        if (r < n && heap[r]->created < heap[smallest]->created) smallest = r;
+        if (smallest == i) return;
+        const Task *tmp = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = tmp;
+        i = smallest;
+    }
+}
+
+// Helper: restore the min-heap above index i
+static void sift_up(const Task **heap, size_t i) {
+    while (i > 0 && heap[(i - 1) / 2]->created > heap[i]->created) {
+        const Task *tmp = heap[i];
+        heap[i] = heap[(i - 1) / 2];
+        heap[(i - 1) / 2] = tmp;
+        i = (i - 1) / 2;
+    }
+}
+
+// Helper: order tasks newest first
+static int compare_newest(const void *a, const void *b) {
+    time_t ca = (*(const Task *const *)a)->created;
+    time_t cb = (*(const Task *const *)b)->created;
+    return (ca < cb) - (ca > cb);
+}
+
+int completion_index_write(Task **tasks, size_t count) {
+    char **projects = NULL;
+    size_t project_count = storage_load_projects(&projects);
+    size_t tag_total = 0;
+    for (size_t i = 0; i < count; i++) tag_total += tasks[i] ? tasks[i]->tag_count : 0;
+
+    StringSet project_set = {NULL, 0}, tag_set = {NULL, 0};
+    const Task **recent = utils_malloc((COMPLETION_RECENT_TASKS + 1) * sizeof(const Task *));
+    char *path = storage_path(COMPLETION_INDEX_FILE);
+    char *tmp = storage_path(COMPLETION_INDEX_FILE ".tmp");
+    int rc = -1;
+    if (!recent || !path || !tmp || set_init(&project_set, count + project_count) != 0
+        || set_init(&tag_set, tag_total) != 0) {
+        goto out;
+    }
+
+    // One pass: distinct projects and tags, and the newest tasks in a bounded heap
+    for (size_t i = 0; i < project_count; i++) set_add(&project_set, projects[i]);
+    size_t recent_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        const Task *t = tasks[i];
+        if (!t || !t->id) continue;
+        set_add(&project_set, t->project ? t->project : "default");
+        for (size_t k = 0; k < t->tag_count; k++) set_add(&tag_set, t->tags[k]);
+        if (recent_count < COMPLETION_RECENT_TASKS) {
+            recent[recent_count] = t;
+            sift_up(recent, recent_count++);
+        } else if (t->created > recent[0]->created) {
+            recent[0] = t;
+            sift_down(recent, recent_count, 0);
+        }
+    }
+    qsort(recent, recent_count, sizeof(const Task *), compare_newest);
+
+    // The index is a cache, so a plain replace (no fsync) is enough
+    FILE *f = fopen(tmp, "w");
+    if (!f) goto out;
+    bool ok = write_set(f, &project_set, 'P') == 0 && write_set(f, &tag_set, 'T') == 0;
+    for (size_t i = 0; ok && i < recent_count; i++) {
+        fprintf(f, "I\t%s\t%c\t", recent[i]->id, recent[i]->status == STATUS_DONE ? 'd' : 'p');
+        put_field(f, recent[i]->name ? recent[i]->name : "");
+        fputc('\n', f);
+    }
+    ok = (fclose(f) == 0) && ok;
+    if (ok && rename(tmp, path) == 0) rc = 0;
+    else remove(tmp);
+
+out:
+    utils_free(project_set.slots);
+    utils_free(tag_set.slots);
+    utils_free(recent);
+    utils_free(path);
+    utils_free(tmp);
+    for (size_t i = 0; i < project_count; i++) utils_free(projects[i]);
+    utils_free(projects);
+    return rc;
+}
+
+// Helper: read the index, building it first if no save has written it yet
+static char *read_index(void) {
+    char *path = storage_path(COMPLETION_INDEX_FILE);
+    if (!path) return NULL;
+    char *buf = utils_read_file(path, NULL);
+    if (!buf && errno == ENOENT) {
+        size_t count = 0;
+        Task **tasks = storage_load_tasks(&count);
+        if (tasks && completion_index_write(tasks, count) == 0) buf = utils_read_file(path, NULL);
+        storage_free_tasks(tasks, count);
+    }
+    utils_free(path);
+    return buf;
+}
+
+// Helper: print the space-separated words starting with prefix
+static void print_words(FILE *out, const char *words, const char *prefix) {
+    size_t plen = strlen(prefix);
+    while (*words) {
+        size_t len = strcspn(words, " ");
+        if (len >= plen && strncmp(words, prefix, plen) == 0) fprintf(out, "%.*s\n", (int)len, words);
+        words += len;
+        if (*words == ' ') words++;
+    }
+}
+
+// Helper: print index entries of one kind starting with prefix. Tasks are
+// offered as short ids (any unique prefix works) with the name as description.
+static void print_index(FILE *out, const char *prefix, char kind, bool pending_only) {
+    char *buf = read_index();
+    if (!buf) return;
+    size_t plen = strlen(prefix);
+    for (char *line = buf, *next; *line; line = next) {
+        char *nl = strchr(line, '\n');
+        next = nl ? nl + 1 : line + strlen(line);
+        if (nl) *nl = '\0';
+        if (line[0] != kind || line[1] != '\t') continue;
+        const char *value = line + 2;
+        if (strncmp(value, prefix, plen) != 0) continue;
+        if (kind != 'I') {
+            fprintf(out, "%s\n", value);
+            continue;
+        }
+        // I<TAB>id<TAB>p|d<TAB>name
+        const char *status = strchr(value, '\t');
+        if (!status || (pending_only && status[1] != 'p')) continue;
+        size_t id_len = (size_t)(status - value);
+        size_t shown = plen > 8 ? plen : 8;
+        fprintf(out, "%.*s\t%s\n", (int)(shown < id_len ? shown : id_len), value,
+                status[1] && status[2] == '\t' ? status + 3 : "");
+    }
+    utils_free(buf);
+}
+
+// Helper: find an option that takes a value; returns its index or -1
+static int value_flag(const char *word) {
+    for (size_t i = 0; i < sizeof(VALUE_FLAGS) / sizeof(VALUE_FLAGS[0]); i++) {
+        if (strcmp(word, VALUE_FLAGS[i].flag) == 0) return (int)i;
+    }
+    return -1;
+}
+
+int completion_complete(int argc, char **argv, FILE *out) {
+    const char *cur = argc > 0 ? argv[argc - 1] : "";
+    if (argc <= 1) {
+        print_words(out, COMMANDS, cur);
+        return 0;
+    }
+    const char *command = argv[0];
+    if (strcmp(command, "completion") == 0) {
+        if (argc == 2) print_words(out, "bash zsh fish", cur);
+        return 0;
+    }
+
+    // The value of an option
+    int flag = argc >= 3 ? value_flag(argv[argc - 2]) : -1;
+    if (flag >= 0) {
+        if (strcmp(VALUE_FLAGS[flag].flag, "--project") == 0) print_index(out, cur, 'P', false);
+        else if (strcmp(VALUE_FLAGS[flag].flag, "--tag") == 0) print_index(out, cur, 'T', false);
+        else if (VALUE_FLAGS[flag].values) print_words(out, VALUE_FLAGS[flag].values, cur);
+        return 0;
+    }
+
+    if (cur[0] == '-') {
+        for (size_t i = 0; i < sizeof(COMMAND_FLAGS) / sizeof(COMMAND_FLAGS[0]); i++) {
+            if (strcmp(command, COMMAND_FLAGS[i].command) == 0) print_words(out, COMMAND_FLAGS[i].flags, cur);
+        }
+        return 0;
+    }
+
+    // done, edit, rm and history take one task id before any options
+    bool takes_id = strcmp(command, "done") == 0 || strcmp(command, "edit") == 0 || strcmp(command, "rm") == 0
+                    || strcmp(command, "history") == 0;
+    int positional = 0;
+    for (int i = 1; i < argc - 1; i++) {
+        if (value_flag(argv[i]) >= 0) i++;
+        else if (strncmp(argv[i], "--", 2) != 0) positional++;
+    }
+    if (takes_id && positional == 0) print_index(out, cur, 'I', strcmp(command, "done") == 0);
+    return 0;
+}
+
+static const char BASH_SCRIPT[] =
+    "# bash completion for smartodo; load with: source <(smartodo completion bash)\n"
+    "_smartodo() {\n"
+    "    local IFS=$'\\n'\n"
+    "    COMPREPLY=($(\"${COMP_WORDS[0]}\" __complete \"${COMP_WORDS[@]:1:COMP_CWORD}\" 2>/dev/null | cut -f1))\n"
+    "}\n"
+    "complete -F _smartodo smartodo\n";
+
+static const char ZSH_SCRIPT[] =
+    "#compdef smartodo\n"
+    "# zsh completion for smartodo; load with: source <(smartodo completion zsh)\n"
+    "_smartodo() {\n"
+    "    local -a candidates\n"
+    "    local line\n"
+    "    for line in \"${(@f)$(\"${words[1]}\" __complete \"${(@)words[2,CURRENT]}\" 2>/dev/null)}\"; do\n"
+    "        [[ -n $line ]] || continue\n"
+    "        if [[ $line == *$'\\t'* ]]; then\n"
+    "            candidates+=(\"${${line%%$'\\t'*}//:/\\\\:}:${line#*$'\\t'}\")\n"
+    "        else\n"
+    "            candidates+=(\"${line//:/\\\\:}\")\n"
+    "        fi\n"
+    "    done\n"
+    "    _describe smartodo candidates\n"
+    "}\n"
+    "compdef _smartodo smartodo\n";
+
+static const char FISH_SCRIPT[] =
+    "# fish completion for smartodo; load with: smartodo completion fish | source\n"
+    "function __smartodo_complete\n"
+    "    set -l words (commandline -opc)\n"
+    "    set -l cmd $words[1]\n"
+    "    set -e words[1]\n"
+    "    set -l cur (commandline -ct)\n"
+    "    $cmd __complete $words \"$cur\" 2>/dev/null\n"
+    "end\n"
+    "complete -c smartodo -f -a '(__smartodo_complete)'\n";
+
+int completion_print_script(const char *shell, FILE *out) {
+    const char *script = NULL;
+    if (!shell) return -1;
+    if (strcmp(shell, "bash") == 0) script = BASH_SCRIPT;
+    else if (strcmp(shell, "zsh") == 0) script = ZSH_SCRIPT;
+    else if (strcmp(shell, "fish") == 0) script = FISH_SCRIPT;
+    if (!script) return -1;
+    fputs(script, out);
+    return 0;
+}
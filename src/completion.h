@@ -0,0 +1,52 @@
+#ifndef TODO_APP_COMPLETION_H
+#define TODO_APP_COMPLETION_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include "task.h"
+
+/**
+ * Shell completion. Saving tasks also writes a small index
+ * (~/.todo-app/completion.idx) of project names, tags and the most recent
+ * tasks, so `smartodo __complete` answers a Tab press without loading
+ * tasks.json or contacting the daemon. Each index line is one of
+ *   P<TAB>project
+ *   T<TAB>tag
+ *   I<TAB>id<TAB>p|d<TAB>name        (pending or done)
+ */
+
+#define COMPLETION_INDEX_FILE "completion.idx"
+
+// Tasks (newest first) whose ids the index keeps
+#define COMPLETION_RECENT_TASKS 256
+
+/**
+ * Rewrite the completion index from a task set and the registered projects.
+ * @param tasks Tasks
+ * @param count Number of tasks
+ * @return 0 on success, -1 on error
+ */
+int completion_index_write(Task **tasks, size_t count);
+
+/**
+ * Print the candidates for the word being completed, one per line; a tab
+ * separates a candidate from its description. Builds the index first if
+ * it does not exist yet.
+ * @param argc Number of words
+ * @param argv Words after the program name; the last is the (possibly
+ *        empty) word under the cursor
+ * @param out Stream for the candidates
+ * @return 0 on success, -1 on error
+ */
+int completion_complete(int argc, char **argv, FILE *out);
+
+/**
+ * Print the completion script for a shell, to be sourced from its startup
+ * file, e.g. `source <(smartodo completion bash)`.
+ * @param shell "bash", "zsh" or "fish"
+ * @param out Stream for the script
+ * @return 0 on success, -1 if the shell is not supported
+ */
+int completion_print_script(const char *shell, FILE *out);
+
+#endif // TODO_APP_COMPLETION_H
@@ -0,0 +1,439 @@
+// Sockets, SO_RCVTIMEO, sigaction() and open_memstream() are POSIX, not ISO C
+#define _POSIX_C_SOURCE 200809L
+
+#include "daemon.h"
+#include "daemon_client.h"
+#include "journal.h"
+#include "cli.h"
+#include "completion.h"
+#include "http_api.h"
+#include "storage.h"
+#include "task_manager.h"
+#include "utils.h"
+#include "app_clock.h"
+#include <cjson/cJSON.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+// Most arguments a forwarded command may carry
+#define DAEMON_MAX_ARGS 64
+
+// Longest the daemon waits on one client to send or take data; it serves
+// one connection at a time, so a silent client must not stall the others
+#define DAEMON_IO_TIMEOUT_SEC 5
+
+// State of the running daemon
+typedef struct {
+    CliTasks set;             // Current tasks
+    size_t journaled;         // Records appended since the last snapshot
+    bool journal_failed;      // An append failed; snapshot before replying
+    bool index_stale;         // The completion index misses recent changes
+    HttpApi *http;            // Local HTTP API, or NULL when not enabled
+} Daemon;
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void on_stop_signal(int sig) {
+    (void)sig;
+    stop_requested = 1;
+}
+
+// Helper: change hook; write every change through to the journal
+static void journal_change(TaskChangeKind kind, const Task *task, void *user) {
+    Daemon *d = user;
+    JournalOp op = kind == TASK_CHANGE_ADD ? JOURNAL_ADD
+                 : kind == TASK_CHANGE_DELETE ? JOURNAL_DELETE : JOURNAL_PUT;
+    if (journal_append(op, task) == 0) {
+        d->journaled++;
+    } else {
+        d->journal_failed = true;
+    }
+    d->index_stale = true;
+}
+
+// Helper: fold the journal into a fresh tasks.json
+static int compact(Daemon *d) {
+    if (storage_write_snapshot(d->set.tasks, d->set.count) != 0) return -1;
+    d->journaled = 0;
+    d->journal_failed = false;
+    d->index_stale = false;
+    return 0;
+}
+
+// Helper: make applied changes durable before they are acknowledged, and
+// compact a long journal; returns -1 if a change could not be written
+static int commit(void *user) {
+    Daemon *d = user;
+    if (d->journal_failed && compact(d) != 0) return -1;
+    if (d->journaled >= DAEMON_COMPACT_RECORDS && compact(d) != 0) {
+        fprintf(stderr, "daemon: failed to compact journal\n");
+    }
+    // Tab completion reads the index, not the daemon
+    if (d->index_stale && completion_index_write(d->set.tasks, d->set.count) == 0) d->index_stale = false;
+    return 0;
+}
+
+// Helper: build an error reply
+static cJSON *error_reply(const char *message) {
+    cJSON *reply = cJSON_CreateObject();
+    if (!reply) return NULL;
+    cJSON_AddFalseToObject(reply, "ok");
+    cJSON_AddStringToObject(reply, "error", message);
+    return reply;
+}
+
+// Helper: run a forwarded command, capturing what it prints
+static cJSON *handle_cli(Daemon *d, const cJSON *args) {
+    char *argv[DAEMON_MAX_ARGS + 1];
+    int argc = 0;
+    const cJSON *arg;
+    cJSON_ArrayForEach(arg, args) {
+        if (!cJSON_IsString(arg) || argc == DAEMON_MAX_ARGS) return error_reply("bad argv");
+        // --follow never returns, and the loop serves one request at a time
+        if (strcmp(arg->valuestring, "--follow") == 0) return error_reply("command not served by the daemon");
+        argv[argc++] = arg->valuestring;
+    }
+    argv[argc] = NULL;
+    if (argc == 0 || !cli_is_forwarded(argv[0])) return error_reply("command not served by the daemon");
+
+    char *out_buf = NULL, *err_buf = NULL;
+    size_t out_len = 0, err_len = 0;
+    FILE *out = open_memstream(&out_buf, &out_len);
+    FILE *err = open_memstream(&err_buf, &err_len);
+    cJSON *reply = NULL;
+    if (out && err) {
+        int status = cli_execute(&d->set, argc, argv, out, err);
+        fclose(out);
+        fclose(err);
+        out = err = NULL;
+        reply = cJSON_CreateObject();
+        if (reply) {
+            cJSON_AddTrueToObject(reply, "ok");
+            cJSON_AddNumberToObject(reply, "status", status);
+            cJSON_AddStringToObject(reply, "out", out_buf);
+            cJSON_AddStringToObject(reply, "err", err_buf);
+        }
+    }
+    if (out) fclose(out);
+    if (err) fclose(err);
+    utils_free(out_buf);
+    utils_free(err_buf);
+    return reply ? reply : error_reply("out of memory");
+}
+
+// Position of a task in the daemon's set, for lookup by id
+typedef struct {
+    const char *id;
+    size_t index;
+} TaskSlot;
+
+// Helper: order slots by id
+static int compare_slots(const void *a, const void *b) {
+    return strcmp(((const TaskSlot *)a)->id, ((const TaskSlot *)b)->id);
+}
+
+// Helper: the slot of an id, or NULL
+static TaskSlot *find_slot(TaskSlot *slots, size_t count, const char *id) {
+    TaskSlot key = {id, 0};
+    return count ? bsearch(&key, slots, count, sizeof(TaskSlot), compare_slots) : NULL;
+}
+
+// What a save does to a task already in the set
+enum { SLOT_KEPT, SLOT_REPLACED, SLOT_REMOVED };
+
+// Helper: apply a client's changes since it loaded: "put" tasks replace or
+// add by id, "del" ids are removed. Tasks the client did not change are
+// left as they are, so a save from a stale copy (the TUI loads once) does
+// not undo what other writers did meanwhile; a task both sides changed
+// takes the client's version.
+static cJSON *handle_save(Daemon *d, const cJSON *request) {
+    const cJSON *put = cJSON_GetObjectItem(request, "put");
+    const cJSON *del = cJSON_GetObjectItem(request, "del");
+    if (!cJSON_IsArray(put) || !cJSON_IsArray(del)) return error_reply("missing changes");
+
+    size_t put_count = (size_t)cJSON_GetArraySize(put);
+    size_t del_count = (size_t)cJSON_GetArraySize(del);
+    Task **incoming = utils_calloc(put_count + 1, sizeof(Task *));
+    size_t *target = utils_calloc(put_count + 1, sizeof(size_t));
+    Task **replaced = utils_calloc(put_count + del_count + 1, sizeof(Task *));
+    TaskSlot *slots = utils_calloc(d->set.count + 1, sizeof(TaskSlot));
+    unsigned char *state = utils_calloc(d->set.count + 1, 1);
+    Task **grown = utils_realloc(d->set.tasks, (d->set.count + put_count + 1) * sizeof(Task *));
+    if (grown) d->set.tasks = grown;
+    if (!incoming || !target || !replaced || !slots || !state || !grown) {
+        utils_free(incoming);
+        utils_free(target);
+        utils_free(replaced);
+        utils_free(slots);
+        utils_free(state);
+        return error_reply("out of memory");
+    }
+    Task **tasks = d->set.tasks;
+    size_t n = 0, old = 0;
+    const cJSON *item;
+    cJSON_ArrayForEach(item, put) {
+        Task *t = task_from_cjson(item);
+        if (t && t->id) incoming[n++] = t;
+        else task_free(t);
+    }
+    for (size_t i = 0; i < d->set.count; i++) slots[i] = (TaskSlot){tasks[i]->id, i};
+    qsort(slots, d->set.count, sizeof(TaskSlot), compare_slots);
+
+    // Find every target before anything is freed; the slots point at ids.
+    // The current versions of what the client touched are diffed against,
+    // so puts that change nothing are not journaled.
+    for (size_t i = 0; i < n; i++) {
+        TaskSlot *slot = find_slot(slots, d->set.count, incoming[i]->id);
+        target[i] = slot ? slot->index : SIZE_MAX;
+        if (slot && state[slot->index] == SLOT_KEPT) {
+            state[slot->index] = SLOT_REPLACED;
+            replaced[old++] = tasks[slot->index];
+        }
+    }
+    cJSON_ArrayForEach(item, del) {
+        TaskSlot *slot = cJSON_IsString(item) ? find_slot(slots, d->set.count, item->valuestring) : NULL;
+        if (slot && state[slot->index] == SLOT_KEPT) {
+            state[slot->index] = SLOT_REMOVED;
+            replaced[old++] = tasks[slot->index];
+        }
+    }
+    JournalPrints before = {0};
+    int appended = -1;
+    if (journal_prints_build(replaced, old, &before) == 0) {
+        appended = journal_append_diff(&before, incoming, n);
+        journal_prints_free(&before);
+    }
+
+    // Replace in place (the first copy of a duplicated id wins), add the
+    // new ones at the end, then close the gaps of the removed
+    size_t count = d->set.count;
+    for (size_t i = 0; i < n; i++) {
+        if (target[i] == SIZE_MAX) {
+            tasks[count++] = incoming[i];
+        } else if (state[target[i]] == SLOT_REPLACED) {
+            task_free(tasks[target[i]]);
+            tasks[target[i]] = incoming[i];
+            state[target[i]] = SLOT_KEPT;
+        } else {
+            task_free(incoming[i]);
+        }
+    }
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (i < d->set.count && state[i] == SLOT_REMOVED) task_free(tasks[i]);
+        else tasks[kept++] = tasks[i];
+    }
+    tasks[kept] = NULL;
+    d->set.count = kept;
+    utils_free(incoming);
+    utils_free(target);
+    utils_free(replaced);
+    utils_free(slots);
+    utils_free(state);
+    if (appended < 0) d->journal_failed = true;
+    else d->journaled += (size_t)appended;
+    d->index_stale = true;
+
+    cJSON *reply = cJSON_CreateObject();
+    if (reply) cJSON_AddTrueToObject(reply, "ok");
+    return reply;
+}
+
+// Helper: answer one request
+static cJSON *handle_request(Daemon *d, const char *line) {
+    cJSON *request = cJSON_Parse(line);
+    const cJSON *op = cJSON_GetObjectItem(request, "op");
+    cJSON *reply;
+    if (!cJSON_IsString(op)) {
+        reply = error_reply("bad request");
+    } else if (strcmp(op->valuestring, "cli") == 0) {
+        reply = handle_cli(d, cJSON_GetObjectItem(request, "argv"));
+    } else if (strcmp(op->valuestring, "save") == 0) {
+        reply = handle_save(d, request);
+    } else if (strcmp(op->valuestring, "load") == 0) {
+        reply = cJSON_CreateObject();
+        cJSON *array = reply ? cJSON_AddArrayToObject(reply, "tasks") : NULL;
+        for (size_t i = 0; array && i < d->set.count; i++) {
+            cJSON *obj = task_to_cjson(d->set.tasks[i]);
+            if (obj) cJSON_AddItemToArray(array, obj);
+        }
+        if (reply) cJSON_AddTrueToObject(reply, "ok");
+    } else if (strcmp(op->valuestring, "ping") == 0) {
+        reply = cJSON_CreateObject();
+        if (reply) cJSON_AddTrueToObject(reply, "ok");
+    } else {
+        reply = error_reply("unknown op");
+    }
+    cJSON_Delete(request);
+    return reply;
+}
+
+// Helper: serve one connection (one request, one reply)
+static void serve(Daemon *d, int fd) {
+    struct timeval tv = {DAEMON_IO_TIMEOUT_SEC, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    char *line = daemon_recv_line(fd);
+    if (!line) return;
+    app_clock_tick();
+    cJSON *reply = handle_request(d, line);
+    utils_free(line);
+
+    // Never acknowledge a change that is not on disk
+    if (commit(d) != 0) {
+        cJSON_Delete(reply);
+        reply = error_reply("failed to write journal");
+    }
+    char *text = reply ? cJSON_PrintUnformatted(reply) : NULL;
+    cJSON_Delete(reply);
+    if (text) daemon_send_line(fd, text);
+    utils_free(text);
+}
+
+// Helper: bind the listening socket; returns the fd, or -1 (with a message)
+static int open_listener(const char *path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    // A socket file nobody answers on is left over from a crash
+    cJSON *ping = cJSON_CreateObject();
+    cJSON_AddStringToObject(ping, "op", "ping");
+    cJSON *pong = NULL;
+    daemon_client_set_enabled(true);
+    int running = daemon_client_request(ping, &pong) == 0;
+    daemon_client_set_enabled(false);
+    cJSON_Delete(ping);
+    cJSON_Delete(pong);
+    if (running) {
+        fprintf(stderr, "A daemon is already running on %s\n", path);
+        return -1;
+    }
+    unlink(path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    mode_t old_mask = umask(077);
+    int bound = bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+    umask(old_mask);
+    if (bound != 0 || listen(fd, 16) != 0) {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int daemon_run(int argc, char **argv) {
+    int http_port = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--http") == 0) {
+            http_port = HTTP_API_DEFAULT_PORT;
+            if (i + 1 < argc && argv[i + 1][0] != '-') http_port = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: smartodo daemon [--http [PORT]]\n");
+            return 2;
+        }
+    }
+
+    // Storage calls in this process go to disk, not back to the socket
+    daemon_client_set_enabled(false);
+    if (storage_init() != 0) {
+        fprintf(stderr, "Failed to initialize storage.\n");
+        return 1;
+    }
+    char *path = daemon_socket_path();
+    if (!path) return 1;
+    int listen_fd = open_listener(path);
+    if (listen_fd < 0) {
+        utils_free(path);
+        return 1;
+    }
+
+    Daemon d = {{NULL, 0}, 0, false, false, NULL};
+    if (http_port) {
+        d.http = http_api_create(http_port, &d.set, commit, &d);
+        if (!d.http) fprintf(stderr, "Cannot listen on 127.0.0.1:%d\n", http_port);
+    }
+
+    // Loading replays a journal left by an earlier daemon; fold it in now
+    app_clock_tick();
+    d.set.tasks = (http_port && !d.http) ? NULL : storage_load_tasks(&d.set.count);
+    if (!d.set.tasks || compact(&d) != 0) {
+        if (!http_port || d.http) fprintf(stderr, "Failed to load tasks.\n");
+        storage_free_tasks(d.set.tasks, d.set.count);
+        http_api_free(d.http);
+        close(listen_fd);
+        unlink(path);
+        utils_free(path);
+        return 1;
+    }
+    task_manager_set_change_hook(journal_change, &d);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_stop_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    printf("smartodo daemon serving %zu task(s) on %s\n", d.set.count, path);
+    if (d.http) printf("HTTP API on http://127.0.0.1:%d/\n", http_port);
+    fflush(stdout);
+
+    int rc = 0;
+    while (!stop_requested) {
+        struct pollfd pfds[2] = {{listen_fd, POLLIN, 0}, {d.http ? http_api_fd(d.http) : -1, POLLIN, 0}};
+        int ready = poll(pfds, d.http ? 2 : 1, http_api_timeout_ms(d.http));
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            perror("poll");
+            rc = 1;
+            break;
+        }
+        if (pfds[0].revents & POLLIN) {
+            int fd = accept(listen_fd, NULL, NULL);
+            if (fd >= 0) {
+                serve(&d, fd);
+                close(fd);
+            }
+        }
+        if (d.http && (pfds[1].revents & POLLIN)) {
+            app_clock_tick();
+            http_api_accept(d.http);
+        }
+        // Changes from either listener, or timeouts, release long-polls
+        http_api_wake(d.http);
+    }
+
+    task_manager_set_change_hook(NULL, NULL);
+    http_api_free(d.http);
+    close(listen_fd);
+    unlink(path);
+    utils_free(path);
+    if (compact(&d) != 0) {
+        fprintf(stderr, "Failed to write tasks; the journal keeps the changes.\n");
+        rc = 1;
+    }
+    storage_free_tasks(d.set.tasks, d.set.count);
+    return rc;
+}
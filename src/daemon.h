@@ -0,0 +1,23 @@
+#ifndef TODO_APP_DAEMON_H
+#define TODO_APP_DAEMON_H
+
+/**
+ * Resident mode (`smartodo daemon`): keep the task set in memory and serve
+ * the requests described in daemon_client.h on ~/.todo-app/daemon.sock.
+ * Every change is appended to the journal before the reply is sent; the
+ * journal is folded into tasks.json once it grows and again on shutdown.
+ */
+
+// Journal records after which the daemon writes a fresh snapshot
+#define DAEMON_COMPACT_RECORDS 1000
+
+/**
+ * Run the daemon until SIGINT or SIGTERM.
+ * @param argc Argument count, starting at "daemon"
+ * @param argv Arguments; `--http [PORT]` also serves the HTTP API (http_api.h)
+ * @return Exit status: 0 after a clean shutdown, 1 on error or if another
+ *         daemon is already running
+ */
+int daemon_run(int argc, char **argv);
+
+#endif // TODO_APP_DAEMON_H
@@ -0,0 +1,134 @@
+// Sockets and SO_RCVTIMEO are POSIX, not ISO C
+#define _POSIX_C_SOURCE 200809L
+
+#include "daemon_client.h"
+#include "storage.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+// Longest the client waits for a reply before giving up
+#define DAEMON_REPLY_TIMEOUT_SEC 30
+
+static bool client_enabled = true;
+
+char *daemon_socket_path(void) {
+    return storage_path(DAEMON_SOCKET_FILE);
+}
+
+void daemon_client_set_enabled(bool enabled) {
+    client_enabled = enabled;
+}
+
+// Helper: write all bytes, retrying short writes
+static int write_all(int fd, const char *p, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+int daemon_send_line(int fd, const char *line) {
+    if (write_all(fd, line, strlen(line)) != 0) return -1;
+    return write_all(fd, "\n", 1);
+}
+
+char *daemon_recv_line(int fd) {
+    size_t cap = 4096;
+    size_t len = 0;
+    char *buf = utils_malloc(cap);
+    if (!buf) return NULL;
+    for (;;) {
+        if (len + 1 >= cap) {
+            char *grown = utils_realloc(buf, cap * 2);
+            if (!grown) {
+                utils_free(buf);
+                return NULL;
+            }
+            buf = grown;
+            cap *= 2;
+        }
+        ssize_t n = read(fd, buf + len, cap - len - 1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            utils_free(buf);
+            return NULL;
+        }
+        if (n == 0) break;
+        char *nl = memchr(buf + len, '\n', (size_t)n);
+        len += (size_t)n;
+        if (nl) {
+            len = (size_t)(nl - buf);
+            break;
+        }
+    }
+    if (len == 0) {
+        utils_free(buf);
+        return NULL;
+    }
+    buf[len] = '\0';
+    return buf;
+}
+
+// Helper: connect to the daemon socket; returns the fd or -1 if nobody listens
+static int connect_daemon(void) {
+    char *path = daemon_socket_path();
+    if (!path) return -1;
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        utils_free(path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+    utils_free(path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    struct timeval tv = {DAEMON_REPLY_TIMEOUT_SEC, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    return fd;
+}
+
+int daemon_client_request(const cJSON *request, cJSON **response) {
+    if (!client_enabled || getenv(DAEMON_DISABLE_ENV)) return DAEMON_CLIENT_UNAVAILABLE;
+    int fd = connect_daemon();
+    if (fd < 0) return DAEMON_CLIENT_UNAVAILABLE;
+
+    char *req = cJSON_PrintUnformatted(request);
+    int rc = -1;
+    if (req && daemon_send_line(fd, req) == 0) {
+        char *reply = daemon_recv_line(fd);
+        cJSON *obj = reply ? cJSON_Parse(reply) : NULL;
+        utils_free(reply);
+        if (cJSON_IsTrue(cJSON_GetObjectItem(obj, "ok"))) {
+            *response = obj;
+            rc = 0;
+        } else {
+            const cJSON *err = cJSON_GetObjectItem(obj, "error");
+            fprintf(stderr, "Daemon request failed: %s\n",
+                    cJSON_IsString(err) ? err->valuestring : "no reply");
+            cJSON_Delete(obj);
+        }
+    }
+    utils_free(req);
+    close(fd);
+    return rc;
+}
@@ -0,0 +1,68 @@
+#ifndef TODO_APP_DAEMON_CLIENT_H
+#define TODO_APP_DAEMON_CLIENT_H
+
+#include <stdbool.h>
+#include <cjson/cJSON.h>
+
+/**
+ * Client side of the daemon protocol. A request is one JSON object on one
+ * line, sent over the Unix socket ~/.todo-app/daemon.sock; the daemon answers
+ * with one JSON line and closes the connection.
+ *
+ * Requests:
+ *   {"op":"ping"}                     -> {"ok":true}
+ *   {"op":"cli","argv":[...]}         -> {"ok":true,"status":N,"out":"...","err":"..."}
+ *   {"op":"load"}                     -> {"ok":true,"tasks":[...]}
+ *   {"op":"save","put":[...],"del":["id",...]} -> {"ok":true}
+ * A save carries only what the client changed since it loaded: whole tasks
+ * to add or replace by id, and the ids it deleted; the daemon's other tasks
+ * are left alone. Failures answer {"ok":false,"error":"..."}.
+ */
+
+#define DAEMON_SOCKET_FILE "daemon.sock"
+
+// Environment variable that, when set, makes every command bypass the daemon
+#define DAEMON_DISABLE_ENV "SMARTODO_NO_DAEMON"
+
+// daemon_client_request() result when no daemon is listening
+#define DAEMON_CLIENT_UNAVAILABLE 1
+
+/**
+ * Get the daemon socket path.
+ * @return Newly allocated path (caller frees), or NULL if HOME is not set
+ */
+char *daemon_socket_path(void);
+
+/**
+ * Enable or disable use of the daemon in this process. The daemon disables
+ * it for itself so its own storage calls go to disk.
+ * @param enabled Whether requests may be sent
+ */
+void daemon_client_set_enabled(bool enabled);
+
+/**
+ * Send one request to the daemon and wait for the reply.
+ * @param request Request object
+ * @param response[out] Reply object on success (caller deletes)
+ * @return 0 on success, DAEMON_CLIENT_UNAVAILABLE if no daemon is running
+ *         or the client is disabled, -1 if the request failed
+ */
+int daemon_client_request(const cJSON *request, cJSON **response);
+
+/**
+ * Write a string followed by a newline, retrying short writes.
+ * @param fd Connected socket
+ * @param line Text without a trailing newline
+ * @return 0 on success, -1 on error
+ */
+int daemon_send_line(int fd, const char *line);
+
+/**
+ * Read up to the next newline or end of stream.
+ * @param fd Connected socket
+ * @return Newly allocated line without the newline (caller frees),
+ *         or NULL on error or if nothing was read
+ */
+char *daemon_recv_line(int fd);
+
+#endif // TODO_APP_DAEMON_CLIENT_H
@@ -1,97 +1,222 @@
+// localtime_r() is POSIX, not ISO C
+#define _POSIX_C_SOURCE 200809L
+
 #include "date_parser.h"
+#include "app_clock.h"
+#include "utils.h"
 #include <string.h>
 #include <time.h>
 #include <ctype.h>
 #include <stdlib.h>
 #include <stdio.h>
 
+// Default time of day for inputs that only name a date
+#define DEFAULT_HOUR 9
+#define TODAY_HOUR 17
+#define TONIGHT_HOUR 20
+
+#define MAX_TOKENS 16
+#define MAX_WORD_LEN 16
+
+// Keyword identifiers produced by the trie
+typedef enum {
+    KW_NONE = 0,
+    KW_TODAY, KW_TONIGHT, KW_TOMORROW, KW_YESTERDAY,
+    KW_NEXT, KW_THIS, KW_IN, KW_AT, KW_ON, KW_THE, KW_OF, KW_END, KW_A,
+    KW_NOON, KW_AM, KW_PM,
+    KW_MINUTE, KW_HOUR, KW_DAY, KW_WEEK, KW_MONTH, KW_YEAR,
+    KW_SUNDAY, KW_MONDAY, KW_TUESDAY, KW_WEDNESDAY, KW_THURSDAY, KW_FRIDAY, KW_SATURDAY,
+    KW_JANUARY, KW_FEBRUARY, KW_MARCH, KW_APRIL, KW_MAY, KW_JUNE,
+    KW_JULY, KW_AUGUST, KW_SEPTEMBER, KW_OCTOBER, KW_NOVEMBER, KW_DECEMBER
+} Keyword;
+
+// Keyword table used to build the trie
+static const struct {
+    const char *word;
+    Keyword kw;
+} KEYWORDS[] = {
+    {"today", KW_TODAY}, {"tonight", KW_TONIGHT},
+    {"tomorrow", KW_TOMORROW}, {"tmrw", KW_TOMORROW}, {"tmr", KW_TOMORROW},
+    {"yesterday", KW_YESTERDAY},
+    {"next", KW_NEXT}, {"this", KW_THIS}, {"in", KW_IN}, {"at", KW_AT},
+    {"on", KW_ON}, {"the", KW_THE}, {"of", KW_OF}, {"end", KW_END},
+    {"a", KW_A}, {"an", KW_A}, {"noon", KW_NOON}, {"am", KW_AM}, {"pm", KW_PM},
+    {"m", KW_MINUTE}, {"min", KW_MINUTE}, {"mins", KW_MINUTE},
+    {"minute", KW_MINUTE}, {"minutes", KW_MINUTE},
+    {"h", KW_HOUR}, {"hr", KW_HOUR}, {"hrs", KW_HOUR}, {"hour", KW_HOUR}, {"hours", KW_HOUR},
+    {"d", KW_DAY}, {"day", KW_DAY}, {"days", KW_DAY},
+    {"w", KW_WEEK}, {"wk", KW_WEEK}, {"wks", KW_WEEK}, {"week", KW_WEEK}, {"weeks", KW_WEEK},
+    {"mo", KW_MONTH}, {"month", KW_MONTH}, {"months", KW_MONTH},
+    {"y", KW_YEAR}, {"yr", KW_YEAR}, {"yrs", KW_YEAR}, {"year", KW_YEAR}, {"years", KW_YEAR},
+    {"sun", KW_SUNDAY}, {"sunday", KW_SUNDAY},
+    {"mon", KW_MONDAY}, {"monday", KW_MONDAY},
+    {"tue", KW_TUESDAY}, {"tues", KW_TUESDAY}, {"tuesday", KW_TUESDAY},
+    {"wed", KW_WEDNESDAY}, {"wednesday", KW_WEDNESDAY},
+    {"thu", KW_THURSDAY}, {"thur", KW_THURSDAY}, {"thurs", KW_THURSDAY}, {"thursday", KW_THURSDAY},
+    {"fri", KW_FRIDAY}, {"friday", KW_FRIDAY},
+    {"sat", KW_SATURDAY}, {"saturday", KW_SATURDAY},
+    {"jan", KW_JANUARY}, {"january", KW_JANUARY},
+    {"feb", KW_FEBRUARY}, {"february", KW_FEBRUARY},
+    {"mar", KW_MARCH}, {"march", KW_MARCH},
+    {"apr", KW_APRIL}, {"april", KW_APRIL},
+    {"may", KW_MAY},
+    {"jun", KW_JUNE}, {"june", KW_JUNE},
+    {"jul", KW_JULY}, {"july", KW_JULY},
+    {"aug", KW_AUGUST}, {"august", KW_AUGUST},
+    {"sep", KW_SEPTEMBER}, {"sept", KW_SEPTEMBER}, {"september", KW_SEPTEMBER},
+    {"oct", KW_OCTOBER}, {"october", KW_OCTOBER},
+    {"nov", KW_NOVEMBER}, {"november", KW_NOVEMBER},
+    {"dec", KW_DECEMBER}, {"december", KW_DECEMBER},
+};
+
+#define KEYWORD_COUNT (sizeof(KEYWORDS) / sizeof(KEYWORDS[0]))
+
+// Keyword trie over 'a'..'z'; node 0 is the root, child index 0 means "none"
+#define TRIE_MAX_NODES 512
+typedef struct {
+    short child[26];
+    unsigned char kw;
+} TrieNode;
+
+static TrieNode trie[TRIE_MAX_NODES];
+static int trie_node_count = 0;
+
+// Token kinds produced by the tokenizer
+typedef enum {
+    TOK_WORD,
+    TOK_NUMBER
+} TokenKind;
+
+typedef struct {
+    TokenKind kind;
+    Keyword kw;       // TOK_WORD: keyword id
+    int value;        // TOK_NUMBER: leading integer
+    int minutes;      // TOK_NUMBER: minutes after ':' or -1
+    bool ordinal;     // TOK_NUMBER: had st/nd/rd/th suffix
+    int meridiem;     // TOK_NUMBER: 0 none, 1 am, 2 pm
+} Token;
+
+// Parsed components before resolution
+typedef enum {
+    DATE_NONE,
+    DATE_OFFSET_DAYS,   // today/tomorrow/in N days/weeks
+    DATE_OFFSET_MONTHS, // in N months/years
+    DATE_WEEKDAY,       // [next|this] weekday
+    DATE_MONTH_DAY,     // may 20 [2026]
+    DATE_ORDINAL,       // the 15th
+    DATE_END_WEEK,
+    DATE_END_MONTH,
+    DATE_END_YEAR,
+    DATE_NEXT_WEEK,
+    DATE_NEXT_MONTH,
+    DATE_NEXT_YEAR,
+    DATE_DURATION       // in N hours/minutes (absolute offset from now)
+} DateKind;
+
+typedef struct {
+    DateKind date;
+    int amount;         // day/month offset, weekday, ordinal day or seconds
+    bool skip_today;    // Weekday: same weekday means next week
+    int month;          // DATE_MONTH_DAY: 0-11
+    int day;            // DATE_MONTH_DAY: 1-31
+    int year;           // DATE_MONTH_DAY: explicit year or -1
+    int default_hour;   // hour used when no time is given
+    bool has_time;
+    int hour;
+    int minute;
+} DateSpec;
+
 // Internal helper functions
-static bool parse_relative_date(const char *input, int *days, int *hours, int *minutes);
-static bool parse_absolute_date(const char *input, struct tm *tm);
-static bool parse_time(const char *input, struct tm *tm);
-static bool parse_weekday(const char *input, int *weekday);
-static bool parse_month(const char *input, int *month);
-static void skip_whitespace(const char **str);
-static bool starts_with(const char *str, const char *prefix);
+static void trie_init(void);
+static Keyword trie_lookup(const char *word, size_t len);
+static int tokenize(const char *input, Token *tokens, int max_tokens);
+static bool parse_spec(const Token *tokens, int count, DateSpec *spec);
+static bool resolve_spec(const DateParseContext *ctx, const DateSpec *spec, time_t *result);
+static bool token_to_time(const Token *tok, int *hour, int *minute);
+static long long local_seconds(const struct tm *tm);
+
+void date_parser_context_init(DateParseContext *ctx, time_t now) {
+    if (!ctx) return;
+    ctx->now = now;
+    localtime_r(&now, &ctx->tm_now);
+    ctx->utc_offset = (long)(local_seconds(&ctx->tm_now) - (long long)now);
+}
+
+bool parse_natural_date_ctx(const DateParseContext *ctx, const char *input, time_t *result) {
+    if (!ctx || !input || !result) return false;
+
+    Token tokens[MAX_TOKENS];
+    int count = tokenize(input, tokens, MAX_TOKENS);
+    if (count <= 0) return false;
+
+    DateSpec spec;
+    if (!parse_spec(tokens, count, &spec)) return false;
+
+    return resolve_spec(ctx, &spec, result);
+}
 
 bool parse_natural_date(const char *input, time_t *result) {
     if (!input || !result) return false;
-    
-    // Get current time
-    time_t now = time(NULL);
-    struct tm tm_now;
-    localtime_r(&now, &tm_now);
-    
-    // Initialize result with current time
-    struct tm tm_result = tm_now;
-    
-    // Check for relative dates (e.g., "tomorrow", "in 2 days")
-    int days_offset = 0, hours_offset = 0, minutes_offset = 0;
-    if (parse_relative_date(input, &days_offset, &hours_offset, &minutes_offset)) {
-        // Apply the offsets
-        tm_result.tm_mday += days_offset;
-        tm_result.tm_hour = hours_offset;
-        tm_result.tm_min = minutes_offset;
-        tm_result.tm_sec = 0;
-        
-        *result = mktime(&tm_result);
-        return true;
-    }
-    
-    // Check for absolute dates (e.g., "may 20", "next monday")
-    if (parse_absolute_date(input, &tm_result)) {
-        *result = mktime(&tm_result);
-        return true;
-    }
-    
-    // Try to parse as time only (e.g., "2pm", "14:30")
-    if (parse_time(input, &tm_result)) {
-        *result = mktime(&tm_result);
-        return true;
-    }
-    
-    return false;
+
+    DateParseContext ctx;
+    date_parser_context_init(&ctx, app_clock_now());
+    return parse_natural_date_ctx(&ctx, input, result);
 }
 
 bool parse_time_today(const char *time_str, time_t *result) {
     if (!time_str || !result) return false;
-    
+
+    // Only a single time token (with optional separate am/pm word) is accepted
+    Token tokens[MAX_TOKENS];
+    int count = tokenize(time_str, tokens, MAX_TOKENS);
+    if (count < 1 || count > 2 || tokens[0].kind != TOK_NUMBER) return false;
+
+    Token tok = tokens[0];
+    if (count == 2) {
+        if (tokens[1].kind != TOK_WORD || tok.meridiem != 0) return false;
+        if (tokens[1].kw == KW_AM) tok.meridiem = 1;
+        else if (tokens[1].kw == KW_PM) tok.meridiem = 2;
+        else return false;
+    }
+
+    int hour, minute;
+    if (!token_to_time(&tok, &hour, &minute)) return false;
+
     // Get current time
-    time_t now = time(NULL);
+    time_t now = app_clock_now();
     struct tm tm_now;
     localtime_r(&now, &tm_now);
-    
-    // Try to parse the time
-    if (!parse_time(time_str, &tm_now)) {
-        return false;
-    }
-    
+    tm_now.tm_hour = hour;
+    tm_now.tm_min = minute;
+    tm_now.tm_sec = 0;
+    tm_now.tm_isdst = -1;
+
     *result = mktime(&tm_now);
-    
+
     // If the time is in the past, assume it's for tomorrow
     if (*result < now) {
         *result += 24 * 60 * 60; // Add one day
     }
-    
+
     return true;
 }
 
 const char *format_natural_date(time_t timestamp, char *buf, size_t buf_size) {
     if (!buf || buf_size < 1) return NULL;
-    
+
     struct tm tm;
     localtime_r(&timestamp, &tm);
-    
+
     // Format as "Today at 2:30 PM" or "Tomorrow at 10:00 AM" or "May 20 at 3:00 PM"
-    time_t now = time(NULL);
+    time_t now = app_clock_now();
     struct tm tm_now;
     localtime_r(&now, &tm_now);
-    
+
     int days_diff = (tm.tm_yday - tm_now.tm_yday + 365) % 365;
-    
+
     char time_buf[32];
     strftime(time_buf, sizeof(time_buf), "%I:%M %p", &tm);
-    
+
     if (days_diff == 0) {
         snprintf(buf, buf_size, "Today at %s", time_buf);
     } else if (days_diff == 1) {
@@ -105,245 +230,446 @@ const char *format_natural_date(time_t timestamp, char *buf, size_t buf_size) {
         strftime(date_buf, sizeof(date_buf), "%b %d", &tm);
         snprintf(buf, buf_size, "%s at %s", date_buf, time_buf);
     }
-    
+
     return buf;
 }
 
 // Internal helper functions
 
-static bool parse_relative_date(const char *input, int *days, int *hours, int *minutes) {
-    if (!input) return false;
-    
-    const char *p = input;
-    skip_whitespace(&p);
-    
-    // Check for "tomorrow"
-    if (strncasecmp(p, "tomorrow", 8) == 0) {
-        *days = 1;
-        *hours = 9; // Default to 9 AM
-        *minutes = 0;
-        return true;
-    }
-    
-    // Check for "in X (days|hours|minutes)"
-    if (starts_with(p, "in ")) {
-        p += 3;
-        skip_whitespace(&p);
-        
-        // Parse number
-        char *endptr;
-        long num = strtol(p, &endptr, 10);
-        if (endptr == p) return false; // No number found
-        
-        p = endptr;
-        skip_whitespace(&p);
-        
-        // Parse time unit
-        if (starts_with(p, "day") || *p == 'd') {
-            *days = (int)num;
-        } else if (starts_with(p, "hour") || *p == 'h') {
-            *hours = (int)num;
-        } else if (starts_with(p, "minute") || starts_with(p, "min") || *p == 'm') {
-            *minutes = (int)num;
-        } else {
-            return false;
+// Build the keyword trie once from KEYWORDS
+static void trie_init(void) {
+    if (trie_node_count > 0) return;
+    trie_node_count = 1; // root
+
+    for (size_t i = 0; i < KEYWORD_COUNT; ++i) {
+        int node = 0;
+        for (const char *c = KEYWORDS[i].word; *c; ++c) {
+            int slot = *c - 'a';
+            if (trie[node].child[slot] == 0) {
+                if (trie_node_count >= TRIE_MAX_NODES) return;
+                trie[node].child[slot] = (short)trie_node_count++;
+            }
+            node = trie[node].child[slot];
         }
-        
-        return true;
+        trie[node].kw = (unsigned char)KEYWORDS[i].kw;
     }
-    
-    // Check for "next [weekday]"
-    if (starts_with(p, "next ")) {
-        p += 5;
-        int weekday;
-        if (parse_weekday(p, &weekday)) {
-            time_t now = time(NULL);
-            struct tm tm_now;
-            localtime_r(&now, &tm_now);
-            
-            int days_until = (weekday - tm_now.tm_wday + 7) % 7;
-            if (days_until == 0) days_until = 7; // Next week
-            
-            *days = days_until;
-            *hours = 9; // Default to 9 AM
-            *minutes = 0;
-            return true;
-        }
+}
+
+// Look up a lowercase word in the trie
+static Keyword trie_lookup(const char *word, size_t len) {
+    int node = 0;
+    for (size_t i = 0; i < len; ++i) {
+        int slot = word[i] - 'a';
+        if (slot < 0 || slot >= 26) return KW_NONE;
+        node = trie[node].child[slot];
+        if (node == 0) return KW_NONE;
     }
-    
-    return false;
+    return (Keyword)trie[node].kw;
 }
 
-static bool parse_absolute_date(const char *input, struct tm *tm) {
-    if (!input || !tm) return false;
-    
-    // Check for month names (e.g., "may 20")
-    int month;
-    if (parse_month(input, &month)) {
-        const char *p = input;
-        while (*p && !isdigit(*p)) p++;
-        
-        if (*p) {
-            char *endptr;
-            long day = strtol(p, &endptr, 10);
-            if (day >= 1 && day <= 31) {
-                // Found a valid month and day
-                tm->tm_mon = month;
-                tm->tm_mday = (int)day;
-                
-                // If the date is in the past, assume next year
-                struct tm tm_copy = *tm;
-                time_t t = mktime(&tm_copy);
-                time_t now = time(NULL);
-                
-                if (t < now) {
-                    tm->tm_year++;
+// Split input into tokens; returns the token count or -1 on unknown input
+static int tokenize(const char *input, Token *tokens, int max_tokens) {
+    trie_init();
+
+    int count = 0;
+    const char *p = input;
+
+    while (*p) {
+        unsigned char c = (unsigned char)*p;
+        if (isspace(c) || c == ',') {
+            p++;
+            continue;
+        }
+        if (count >= max_tokens) return -1;
+        Token *tok = &tokens[count];
+
+        if (isdigit(c)) {
+            long value = 0;
+            int digits = 0;
+            while (isdigit((unsigned char)*p)) {
+                if (++digits > 4) return -1;
+                value = value * 10 + (*p++ - '0');
+            }
+            tok->kind = TOK_NUMBER;
+            tok->kw = KW_NONE;
+            tok->value = (int)value;
+            tok->minutes = -1;
+            tok->ordinal = false;
+            tok->meridiem = 0;
+
+            if (*p == ':') {
+                p++;
+                if (!isdigit((unsigned char)p[0]) || !isdigit((unsigned char)p[1]) ||
+                    isdigit((unsigned char)p[2])) {
+                    return -1;
                 }
-                
-                // Default to 9 AM
-                tm->tm_hour = 9;
-                tm->tm_min = 0;
-                tm->tm_sec = 0;
-                
-                return true;
+                tok->minutes = (p[0] - '0') * 10 + (p[1] - '0');
+                p += 2;
+            }
+
+            // Attached suffix: ordinal (15th) or meridiem (2pm)
+            char suffix[3] = {0};
+            int n = 0;
+            while (isalpha((unsigned char)*p)) {
+                if (n >= 2) return -1;
+                suffix[n++] = (char)tolower((unsigned char)*p++);
             }
+            if (n > 0) {
+                if (strcmp(suffix, "am") == 0 || strcmp(suffix, "a") == 0) {
+                    tok->meridiem = 1;
+                } else if (strcmp(suffix, "pm") == 0 || strcmp(suffix, "p") == 0) {
+                    tok->meridiem = 2;
+                } else if (tok->minutes < 0 &&
+                           (strcmp(suffix, "st") == 0 || strcmp(suffix, "nd") == 0 ||
+                            strcmp(suffix, "rd") == 0 || strcmp(suffix, "th") == 0)) {
+                    tok->ordinal = true;
+                } else {
+                    return -1;
+                }
+            }
+            count++;
+            continue;
         }
+
+        if (isalpha(c)) {
+            char word[MAX_WORD_LEN];
+            size_t len = 0;
+            while (isalpha((unsigned char)*p)) {
+                if (len >= sizeof(word)) return -1;
+                word[len++] = (char)tolower((unsigned char)*p++);
+            }
+            // Allow a trailing period on abbreviations ("dec.", "mon.")
+            if (*p == '.') p++;
+            Keyword kw = trie_lookup(word, len);
+            if (kw == KW_NONE) return -1;
+            tok->kind = TOK_WORD;
+            tok->kw = kw;
+            count++;
+            continue;
+        }
+
+        return -1; // Unsupported character
     }
-    
-    // Check for weekdays (e.g., "monday")
-    int weekday;
-    if (parse_weekday(input, &weekday)) {
-        time_t now = time(NULL);
-        struct tm tm_now;
-        localtime_r(&now, &tm_now);
-        
-        int days_until = (weekday - tm_now.tm_wday + 7) % 7;
-        if (days_until == 0) days_until = 7; // Next week
-        
-        tm->tm_mday += days_until;
-        tm->tm_hour = 9; // Default to 9 AM
-        tm->tm_min = 0;
-        tm->tm_sec = 0;
-        
-        return true;
-    }
-    
-    return false;
+
+    return count;
 }
 
-static bool parse_time(const char *input, struct tm *tm) {
-    if (!input || !tm) return false;
-    
-    const char *p = input;
-    skip_whitespace(&p);
-    
-    // Parse hours
-    char *endptr;
-    long hours = strtol(p, &endptr, 10);
-    if (endptr == p) return false; // No number found
-    
-    p = endptr;
-    
-    // Check for AM/PM
-    bool is_pm = false;
-    bool has_am_pm = false;
-    
-    skip_whitespace(&p);
-    
-    if (*p == ':') {
-        p++;
-        // Parse minutes
-        long minutes = strtol(p, &endptr, 10);
-        if (endptr == p) return false; // No number after colon
-        
-        p = endptr;
-        tm->tm_min = (int)minutes;
-    } else {
-        tm->tm_min = 0;
-    }
-    
-    skip_whitespace(&p);
-    
-    // Check for AM/PM
-    if (toupper(*p) == 'A' || toupper(*p) == 'P') {
-        is_pm = (toupper(*p) == 'P');
-        has_am_pm = true;
-        p++;
-        if (toupper(*p) == 'M') p++;
-    }
-    
-    // Adjust hours for 12-hour format
-    if (has_am_pm) {
-        if (hours == 12) {
-            hours = is_pm ? 12 : 0;
-        } else if (is_pm) {
-            hours += 12;
-        }
-    } else if (hours >= 0 && hours < 12) {
+// Helper: is this keyword a weekday / month / unit
+static bool is_weekday(Keyword kw) { return kw >= KW_SUNDAY && kw <= KW_SATURDAY; }
+static bool is_month(Keyword kw) { return kw >= KW_JANUARY && kw <= KW_DECEMBER; }
+static bool is_unit(Keyword kw) { return kw >= KW_MINUTE && kw <= KW_YEAR; }
+
+// Convert a number token to hour/minute; bare hours below 12 default to PM
+static bool token_to_time(const Token *tok, int *hour, int *minute) {
+    if (tok->kind != TOK_NUMBER || tok->ordinal) return false;
+    int h = tok->value;
+    int m = tok->minutes < 0 ? 0 : tok->minutes;
+
+    if (tok->meridiem != 0) {
+        if (h < 1 || h > 12) return false;
+        if (h == 12) h = 0;
+        if (tok->meridiem == 2) h += 12;
+    } else if (h >= 0 && h < 12) {
         // Default to PM if no AM/PM specified and hours < 12
-        hours += 12;
+        h += 12;
     }
-    
-    if (hours < 0 || hours > 23) return false;
-    if (tm->tm_min < 0 || tm->tm_min > 59) return false;
-    
-    tm->tm_hour = (int)hours;
-    tm->tm_sec = 0;
-    
-    // Skip any remaining whitespace
-    skip_whitespace(&p);
-    
-    // If we haven't reached the end of the string, it's invalid
-    if (*p != '\0') {
-        return false;
-    }
-    
+
+    if (h < 0 || h > 23 || m < 0 || m > 59) return false;
+    *hour = h;
+    *minute = m;
+    return true;
+}
+
+// Helper: set the date component once
+static bool set_date(DateSpec *spec, DateKind kind, int amount) {
+    if (spec->date != DATE_NONE) return false;
+    spec->date = kind;
+    spec->amount = amount;
     return true;
 }
 
-static bool parse_weekday(const char *input, int *weekday) {
-    if (!input || !weekday) return false;
-    
-    const char *days[] = {"sunday", "monday", "tuesday", "wednesday", "thursday", "friday", "saturday"};
-    
-    for (int i = 0; i < 7; i++) {
-        if (strncasecmp(input, days[i], 3) == 0) { // Match first 3 letters
-            *weekday = i;
-            return true;
+// Grammar engine: turn the token stream into a DateSpec
+static bool parse_spec(const Token *tokens, int count, DateSpec *spec) {
+    memset(spec, 0, sizeof(*spec));
+    spec->date = DATE_NONE;
+    spec->year = -1;
+    spec->default_hour = DEFAULT_HOUR;
+
+    for (int i = 0; i < count; ++i) {
+        const Token *tok = &tokens[i];
+        const Token *next = (i + 1 < count) ? &tokens[i + 1] : NULL;
+
+        if (tok->kind == TOK_NUMBER) {
+            // "20 may [2026]"
+            if (next && next->kind == TOK_WORD && is_month(next->kw) && tok->minutes < 0 &&
+                tok->meridiem == 0) {
+                if (!set_date(spec, DATE_MONTH_DAY, 0)) return false;
+                spec->day = tok->value;
+                spec->month = next->kw - KW_JANUARY;
+                i++;
+                if (i + 1 < count && tokens[i + 1].kind == TOK_NUMBER && tokens[i + 1].value >= 1000) {
+                    spec->year = tokens[++i].value;
+                }
+                continue;
+            }
+            // "15th"
+            if (tok->ordinal) {
+                if (!set_date(spec, DATE_ORDINAL, tok->value)) return false;
+                continue;
+            }
+            // Time of day, with an optional separate am/pm word
+            Token time_tok = *tok;
+            if (next && next->kind == TOK_WORD && (next->kw == KW_AM || next->kw == KW_PM)) {
+                if (time_tok.meridiem != 0) return false;
+                time_tok.meridiem = next->kw == KW_AM ? 1 : 2;
+                i++;
+            }
+            if (spec->has_time) return false;
+            if (!token_to_time(&time_tok, &spec->hour, &spec->minute)) return false;
+            spec->has_time = true;
+            continue;
+        }
+
+        switch (tok->kw) {
+            case KW_TODAY:
+                if (!set_date(spec, DATE_OFFSET_DAYS, 0)) return false;
+                spec->default_hour = TODAY_HOUR;
+                break;
+            case KW_TONIGHT:
+                if (!set_date(spec, DATE_OFFSET_DAYS, 0)) return false;
+                spec->default_hour = TONIGHT_HOUR;
+                break;
+            case KW_TOMORROW:
+                if (!set_date(spec, DATE_OFFSET_DAYS, 1)) return false;
+                break;
+            case KW_YESTERDAY:
+                if (!set_date(spec, DATE_OFFSET_DAYS, -1)) return false;
+                break;
+            case KW_NOON:
+                if (spec->has_time) return false;
+                spec->has_time = true;
+                spec->hour = 12;
+                spec->minute = 0;
+                break;
+            case KW_AT:
+            case KW_ON:
+            case KW_THE:
+                break; // Filler words
+            case KW_NEXT:
+            case KW_THIS: {
+                if (!next || next->kind != TOK_WORD) return false;
+                bool is_next = tok->kw == KW_NEXT;
+                if (is_weekday(next->kw)) {
+                    if (!set_date(spec, DATE_WEEKDAY, next->kw - KW_SUNDAY)) return false;
+                    spec->skip_today = is_next; // "this friday" on a Friday is today
+                } else if (is_next && next->kw == KW_WEEK) {
+                    if (!set_date(spec, DATE_NEXT_WEEK, 0)) return false;
+                } else if (is_next && next->kw == KW_MONTH) {
+                    if (!set_date(spec, DATE_NEXT_MONTH, 0)) return false;
+                } else if (is_next && next->kw == KW_YEAR) {
+                    if (!set_date(spec, DATE_NEXT_YEAR, 0)) return false;
+                } else {
+                    return false;
+                }
+                i++;
+                break;
+            }
+            case KW_IN: {
+                // in N unit | in a/an unit
+                if (!next) return false;
+                int amount;
+                if (next->kind == TOK_NUMBER && next->minutes < 0 && next->meridiem == 0 &&
+                    !next->ordinal) {
+                    amount = next->value;
+                } else if (next->kind == TOK_WORD && next->kw == KW_A) {
+                    amount = 1;
+                } else {
+                    return false;
+                }
+                if (i + 2 >= count || tokens[i + 2].kind != TOK_WORD || !is_unit(tokens[i + 2].kw)) {
+                    return false;
+                }
+                Keyword unit = tokens[i + 2].kw;
+                bool ok;
+                switch (unit) {
+                    case KW_MINUTE: ok = set_date(spec, DATE_DURATION, amount * 60); break;
+                    case KW_HOUR:   ok = set_date(spec, DATE_DURATION, amount * 3600); break;
+                    case KW_DAY:    ok = set_date(spec, DATE_OFFSET_DAYS, amount); break;
+                    case KW_WEEK:   ok = set_date(spec, DATE_OFFSET_DAYS, amount * 7); break;
+                    case KW_MONTH:  ok = set_date(spec, DATE_OFFSET_MONTHS, amount); break;
+                    default:        ok = set_date(spec, DATE_OFFSET_MONTHS, amount * 12); break;
+                }
+                if (!ok) return false;
+                i += 2;
+                break;
+            }
+            case KW_END: {
+                // end [of] [the] week|month|year
+                int j = i + 1;
+                while (j < count && tokens[j].kind == TOK_WORD &&
+                       (tokens[j].kw == KW_OF || tokens[j].kw == KW_THE || tokens[j].kw == KW_THIS)) {
+                    j++;
+                }
+                if (j >= count || tokens[j].kind != TOK_WORD) return false;
+                DateKind kind;
+                if (tokens[j].kw == KW_WEEK) kind = DATE_END_WEEK;
+                else if (tokens[j].kw == KW_MONTH) kind = DATE_END_MONTH;
+                else if (tokens[j].kw == KW_YEAR) kind = DATE_END_YEAR;
+                else return false;
+                if (!set_date(spec, kind, 0)) return false;
+                i = j;
+                break;
+            }
+            default:
+                if (is_weekday(tok->kw)) {
+                    if (!set_date(spec, DATE_WEEKDAY, tok->kw - KW_SUNDAY)) return false;
+                    spec->skip_today = true;
+                } else if (is_month(tok->kw)) {
+                    // "may 20[th] [2026]"
+                    if (!next || next->kind != TOK_NUMBER || next->minutes >= 0 || next->meridiem != 0) {
+                        return false;
+                    }
+                    if (!set_date(spec, DATE_MONTH_DAY, 0)) return false;
+                    spec->month = tok->kw - KW_JANUARY;
+                    spec->day = next->value;
+                    i++;
+                    if (i + 1 < count && tokens[i + 1].kind == TOK_NUMBER && tokens[i + 1].value >= 1000) {
+                        spec->year = tokens[++i].value;
+                    }
+                } else {
+                    return false; // Keyword out of context (e.g. a bare unit)
+                }
+                break;
         }
     }
-    
-    return false;
+
+    // A duration is an exact offset; it cannot be combined with a time of day
+    if (spec->date == DATE_DURATION && spec->has_time) return false;
+
+    return spec->date != DATE_NONE || spec->has_time;
+}
+
+// Broken-down local fields as seconds since the epoch, ignoring the UTC offset
+static long long local_seconds(const struct tm *tm) {
+    return utils_days_from_civil(tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday) * 86400LL +
+           tm->tm_hour * 3600LL + tm->tm_min * 60LL + tm->tm_sec;
 }
 
-static bool parse_month(const char *input, int *month) {
-    if (!input || !month) return false;
-    
-    const char *months[] = {
-        "january", "february", "march", "april", "may", "june",
-        "july", "august", "september", "october", "november", "december"
-    };
-    
-    for (int i = 0; i < 12; i++) {
-        if (strncasecmp(input, months[i], 3) == 0) { // Match first 3 letters
-            *month = i;
-            return true;
+// Resolve a DateSpec against the reference context. The UTC offset of the
+// reference instant is tried first and confirmed with localtime_r; mktime is
+// only needed when the result lies across a DST/offset change.
+static bool resolve_spec(const DateParseContext *ctx, const DateSpec *spec, time_t *result) {
+    if (spec->date == DATE_DURATION) {
+        *result = ctx->now + spec->amount;
+        return true;
+    }
+
+    const struct tm *now = &ctx->tm_now;
+    int year = now->tm_year + 1900;
+    int month = now->tm_mon;
+    int day = now->tm_mday;
+
+    switch (spec->date) {
+        case DATE_NONE:
+            break; // Time only: today
+        case DATE_OFFSET_DAYS:
+            day += spec->amount; // mktime normalizes overflow
+            break;
+        case DATE_OFFSET_MONTHS: {
+            int total = month + spec->amount;
+            year += total >= 0 ? total / 12 : (total - 11) / 12;
+            month = ((total % 12) + 12) % 12;
+            if (day > utils_days_in_month(year, month + 1)) day = utils_days_in_month(year, month + 1);
+            break;
         }
+        case DATE_WEEKDAY: {
+            int days_until = (spec->amount - now->tm_wday + 7) % 7;
+            if (days_until == 0 && spec->skip_today) days_until = 7; // Next week
+            day += days_until;
+            break;
+        }
+        case DATE_MONTH_DAY:
+            month = spec->month;
+            if (spec->year >= 0) {
+                year = spec->year;
+            } else if (month < now->tm_mon || (month == now->tm_mon && spec->day < now->tm_mday)) {
+                year++; // Date already passed this year
+            }
+            if (spec->day < 1 || spec->day > utils_days_in_month(year, month + 1)) return false;
+            day = spec->day;
+            break;
+        case DATE_ORDINAL: {
+            if (spec->amount < 1 || spec->amount > 31) return false;
+            if (spec->amount < day) month++;
+            // Skip months that do not have this day (e.g. the 31st)
+            for (int guard = 0; guard < 12; ++guard) {
+                if (month > 11) {
+                    month -= 12;
+                    year++;
+                }
+                if (spec->amount <= utils_days_in_month(year, month + 1)) break;
+                month++;
+            }
+            day = spec->amount;
+            break;
+        }
+        case DATE_END_WEEK:
+            day += (7 - now->tm_wday) % 7; // Upcoming Sunday (today if Sunday)
+            break;
+        case DATE_END_MONTH:
+            day = utils_days_in_month(year, month + 1);
+            break;
+        case DATE_END_YEAR:
+            month = 11;
+            day = 31;
+            break;
+        case DATE_NEXT_WEEK: {
+            int days_to_monday = (8 - now->tm_wday) % 7;
+            if (days_to_monday == 0) days_to_monday = 7;
+            day += days_to_monday;
+            break;
+        }
+        case DATE_NEXT_MONTH:
+            month++;
+            day = 1;
+            break;
+        case DATE_NEXT_YEAR:
+            year++;
+            month = 0;
+            day = 1;
+            break;
+        case DATE_DURATION:
+            break; // Handled above
     }
-    
-    return false;
-}
 
-static void skip_whitespace(const char **str) {
-    if (!str || !*str) return;
-    
-    while (isspace(**str)) {
-        (*str)++;
+    struct tm tm_result = {0};
+    tm_result.tm_year = year - 1900;
+    tm_result.tm_mon = month;
+    tm_result.tm_mday = day;
+    if (spec->has_time) {
+        tm_result.tm_hour = spec->hour;
+        tm_result.tm_min = spec->minute;
+    } else {
+        tm_result.tm_hour = spec->default_hour;
+    }
+    tm_result.tm_isdst = -1;
+
+    // Normalize the month so the civil-day arithmetic below is valid
+    if (tm_result.tm_mon > 11) {
+        tm_result.tm_year += tm_result.tm_mon / 12;
+        tm_result.tm_mon %= 12;
     }
-}
 
-static bool starts_with(const char *str, const char *prefix) {
-    if (!str || !prefix) return false;
-    size_t len = strlen(prefix);
-    return strncasecmp(str, prefix, len) == 0;
+    long long wanted = local_seconds(&tm_result);
+    time_t t = (time_t)(wanted - ctx->utc_offset);
+    struct tm check;
+    if (localtime_r(&t, &check) && local_seconds(&check) == wanted) {
+        *result = t;
+        return true;
+    }
+
+    t = mktime(&tm_result);
+    if (t == (time_t)-1) return false;
+    *result = t;
+    return true;
 }
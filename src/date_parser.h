@@ -8,9 +8,46 @@
 extern "C" {
 #endif
 
+/**
+ * @brief Reference point for natural language parsing
+ *
+ * Holds "now" and its local broken-down form so that many inputs can be
+ * parsed against the same instant without calling time()/localtime_r per parse.
+ */
+typedef struct {
+    time_t now;         // Reference instant
+    struct tm tm_now;   // Local time of the reference instant
+    long utc_offset;    // Seconds east of UTC at the reference instant
+} DateParseContext;
+
+/**
+ * @brief Initializes a parse context for a reference instant
+ *
+ * @param ctx Context to initialize
+ * @param now The instant relative expressions are resolved against
+ */
+void date_parser_context_init(DateParseContext *ctx, time_t now);
+
+/**
+ * @brief Parses a natural language date string against a reference context
+ *
+ * Understands combinations of a date part and an optional time part, e.g.
+ * "tomorrow", "next friday 3pm", "in 2 weeks", "in 3 hours", "end of month",
+ * "the 15th", "may 20", "20 may 2026 at 14:30", "2pm". Date-only inputs
+ * default to 9:00 local time; "today" defaults to 17:00.
+ *
+ * @param ctx Reference context from date_parser_context_init()
+ * @param input The input string
+ * @param result Pointer to store the parsed time_t value
+ * @return bool True if parsing was successful, false otherwise
+ */
+bool parse_natural_date_ctx(const DateParseContext *ctx, const char *input, time_t *result);
+
 /**
  * @brief Parses a natural language date string into a time_t value
  * 
+ * Convenience wrapper around parse_natural_date_ctx() using app_clock_now().
+ *
  * @param input The input string containing a natural language date (e.g., "tomorrow at 2pm", "next monday")
  * @param result Pointer to store the parsed time_t value
  * @return bool True if parsing was successful, false otherwise
@@ -0,0 +1,565 @@
+// getline(), mkdir() and opendir() are POSIX, not ISO C
+#define _POSIX_C_SOURCE 200809L
+
+#include "history.h"
+#include "journal.h"
+#include "storage.h"
+#include "utils.h"
+#include <cjson/cJSON.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// A checkpoint file, known by its name
+typedef struct {
+    unsigned long long seq;     // Newest record the checkpoint includes
+    time_t ts;                  // Time of that record (0 for the first checkpoint)
+} Checkpoint;
+
+// Reads records in sequence order: the archive, then the journal
+typedef struct {
+    FILE *archive;
+    FILE *journal;
+    long long archive_pos;      // Archive offset after the last complete line read
+    unsigned long long last;    // Newest sequence number returned
+    char *line;
+    size_t cap;
+    JournalRecordInfo info;     // Of the line returned last
+} RecordReader;
+
+// Helper: open both files at an archive offset, returning records after seq.
+// The journal is opened first: a trim moves records to the archive before it
+// replaces the journal, so a record is always in one of the two handles.
+static void reader_open(RecordReader *r, long long archive_pos, unsigned long long seq) {
+    memset(r, 0, sizeof(*r));
+    r->last = seq;
+    char *path = storage_path(JOURNAL_FILE);
+    r->journal = path ? fopen(path, "r") : NULL;
+    utils_free(path);
+    path = storage_path(JOURNAL_ARCHIVE_FILE);
+    r->archive = path ? fopen(path, "r") : NULL;
+    utils_free(path);
+    if (r->archive && fseek(r->archive, archive_pos, SEEK_SET) == 0) {
+        r->archive_pos = archive_pos;
+    } else if (r->archive) {
+        fclose(r->archive);
+        r->archive = NULL;
+    }
+}
+
+// Helper: read the next record line into r->line; returns 1, or 0 at the end.
+// A torn last line ends its file; a record already returned (copied to the
+// archive by a trim that then failed) is skipped.
+static int reader_next(RecordReader *r) {
+    for (;;) {
+        FILE *f = r->archive ? r->archive : r->journal;
+        if (!f) return 0;
+        ssize_t len = getline(&r->line, &r->cap, f);
+        if (len <= 0 || r->line[len - 1] != '\n') {
+            if (f == r->archive) {
+                fclose(r->archive);
+                r->archive = NULL;
+                continue;
+            }
+            return 0;
+        }
+        if (f == r->archive) r->archive_pos += len;
+        r->line[len - 1] = '\0';
+        if (journal_scan_record(r->line, &r->info) != 0 || r->info.seq <= r->last) continue;
+        r->last = r->info.seq;
+        return 1;
+    }
+}
+
+static void reader_close(RecordReader *r) {
+    if (r->archive) fclose(r->archive);
+    if (r->journal) fclose(r->journal);
+    utils_free(r->line);
+}
+
+// Helper: order checkpoints by sequence number
+static int compare_checkpoints(const void *a, const void *b) {
+    unsigned long long sa = ((const Checkpoint *)a)->seq, sb = ((const Checkpoint *)b)->seq;
+    return sa < sb ? -1 : sa > sb;
+}
+
+// Helper: the checkpoints on disk, oldest first; returns the array (possibly
+// empty) or NULL on error
+static Checkpoint *list_checkpoints(size_t *count) {
+    *count = 0;
+    size_t cap = 16;
+    Checkpoint *cps = utils_malloc(cap * sizeof(Checkpoint));
+    char *path = storage_path(HISTORY_DIR);
+    DIR *dir = path ? opendir(path) : NULL;
+    utils_free(path);
+    if (!cps || !dir) return cps;
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        unsigned long long seq;
+        long long ts;
+        int end = 0;
+        if (sscanf(entry->d_name, "%llu-%lld.json%n", &seq, &ts, &end) != 2
+            || end == 0 || entry->d_name[end] != '\0') {
+            continue;
+        }
+        if (*count == cap) {
+            Checkpoint *grown = utils_realloc(cps, cap * 2 * sizeof(Checkpoint));
+            if (!grown) {
+                utils_free(cps);
+                closedir(dir);
+                return NULL;
+            }
+            cps = grown;
+            cap *= 2;
+        }
+        cps[*count].seq = seq;
+        cps[*count].ts = (time_t)ts;
+        (*count)++;
+    }
+    closedir(dir);
+    qsort(cps, *count, sizeof(Checkpoint), compare_checkpoints);
+    return cps;
+}
+
+// Helper: path of a checkpoint file (caller frees)
+static char *checkpoint_path(unsigned long long seq, time_t ts, const char *suffix) {
+    char name[80];
+    snprintf(name, sizeof(name), HISTORY_DIR "/%llu-%lld.json%s", seq, (long long)ts, suffix);
+    return storage_path(name);
+}
+
+// Helper: save a task set as the checkpoint after record seq
+static int write_checkpoint(unsigned long long seq, time_t ts, long long archive_pos,
+                            Task **tasks, size_t count) {
+    char *dir = storage_path(HISTORY_DIR);
+    int rc = (storage_init() == 0 && dir && (mkdir(dir, 0700) == 0 || errno == EEXIST)) ? 0 : -1;
+    utils_free(dir);
+    if (rc != 0) return -1;
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON *arr = root ? cJSON_AddArrayToObject(root, "tasks") : NULL;
+    for (size_t i = 0; arr && i < count; i++) {
+        cJSON *obj = task_to_cjson(tasks[i]);
+        if (!obj) {
+            arr = NULL;
+            break;
+        }
+        cJSON_AddItemToArray(arr, obj);
+    }
+    if (arr) cJSON_AddNumberToObject(root, "archive_pos", (double)archive_pos);
+    char *json = arr ? cJSON_PrintUnformatted(root) : NULL;
+    cJSON_Delete(root);
+
+    char *path = checkpoint_path(seq, ts, "");
+    rc = (json && path) ? utils_write_file_atomic(path, json, strlen(json)) : -1;
+    utils_free(json);
+    utils_free(path);
+    return rc;
+}
+
+// Helper: load a checkpoint as a NULL-terminated task array
+static Task **load_checkpoint(const Checkpoint *cp, size_t *count, long long *archive_pos) {
+    *count = 0;
+    char *path = checkpoint_path(cp->seq, cp->ts, "");
+    size_t len = 0;
+    char *buf = utils_read_file(path, &len);
+    utils_free(path);
+    if (!buf) return NULL;
+    cJSON *root = cJSON_ParseWithLength(buf, len);
+    utils_free(buf);
+    const cJSON *arr = cJSON_GetObjectItem(root, "tasks");
+    const cJSON *pos = cJSON_GetObjectItem(root, "archive_pos");
+    Task **tasks = (cJSON_IsArray(arr) && cJSON_IsNumber(pos))
+                   ? utils_calloc((size_t)cJSON_GetArraySize(arr) + 1, sizeof(Task *)) : NULL;
+    if (tasks) {
+        *archive_pos = (long long)pos->valuedouble;
+        const cJSON *item;
+        cJSON_ArrayForEach(item, arr) {
+            Task *t = task_from_cjson(item);
+            if (t) tasks[(*count)++] = t;
+        }
+    }
+    cJSON_Delete(root);
+    return tasks;
+}
+
+// Helper: order id strings
+static int compare_ids(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+int history_begin(void) {
+    size_t n = 0;
+    Checkpoint *cps = list_checkpoints(&n);
+    utils_free(cps);
+    if (!cps) return -1;
+    if (n > 0) return 0;
+    size_t count = 0;
+    Task **tasks = storage_load_snapshot(&count);
+    if (!tasks) return -1;
+    int rc = write_checkpoint(0, 0, 0, tasks, count);
+    storage_free_tasks(tasks, count);
+    return rc;
+}
+
+// Helper: write the first checkpoint of a journal begun without one, just
+// before the oldest record. It holds the current tasks no record mentions:
+// they have not changed since before history began.
+static int write_first_checkpoint(void) {
+    RecordReader r;
+    reader_open(&r, 0, 0);
+    unsigned long long first = 0;
+    char **ids = NULL;
+    size_t id_count = 0, id_cap = 0;
+    int rc = 0;
+    while (rc == 0 && reader_next(&r)) {
+        if (first == 0) first = r.info.seq;
+        if (!r.info.id) continue;
+        if (id_count == id_cap) {
+            id_cap = id_cap ? id_cap * 2 : 256;
+            char **grown = utils_realloc(ids, id_cap * sizeof(char *));
+            if (!grown) {
+                rc = -1;
+                break;
+            }
+            ids = grown;
+        }
+        ids[id_count] = utils_malloc(r.info.id_len + 1);
+        if (!ids[id_count]) {
+            rc = -1;
+            break;
+        }
+        memcpy(ids[id_count], r.info.id, r.info.id_len);
+        ids[id_count++][r.info.id_len] = '\0';
+    }
+    reader_close(&r);
+    if (ids) qsort(ids, id_count, sizeof(char *), compare_ids);
+
+    size_t count = 0, kept = 0;
+    Task **tasks = rc == 0 ? storage_load_tasks(&count) : NULL;
+    if (tasks) {
+        for (size_t i = 0; i < count; i++) {
+            const char *key = tasks[i]->id;
+            if (ids && bsearch(&key, ids, id_count, sizeof(char *), compare_ids)) {
+                task_free(tasks[i]);
+            } else {
+                tasks[kept++] = tasks[i];
+            }
+        }
+        unsigned long long seq = first > 0 ? first - 1 : journal_last_seq();
+        rc = write_checkpoint(seq, 0, 0, tasks, kept);
+        storage_free_tasks(tasks, kept);
+    } else {
+        rc = -1;
+    }
+    for (size_t i = 0; i < id_count; i++) utils_free(ids[i]);
+    utils_free(ids);
+    return rc;
+}
+
+int history_update(void) {
+    size_t n = 0;
+    Checkpoint *cps = list_checkpoints(&n);
+    if (!cps) return -1;
+    int written = 0;
+    if (n == 0) {
+        utils_free(cps);
+        if (write_first_checkpoint() != 0 || !(cps = list_checkpoints(&n)) || n == 0) {
+            utils_free(cps);
+            return -1;
+        }
+        written++;
+    }
+    Checkpoint newest = cps[n - 1];
+    utils_free(cps);
+    if (journal_last_seq() < newest.seq + HISTORY_CHECKPOINT_RECORDS) return written;
+
+    long long archive_pos = 0;
+    size_t count = 0;
+    Task **tasks = load_checkpoint(&newest, &count, &archive_pos);
+    if (!tasks) return -1;
+    RecordReader r;
+    reader_open(&r, archive_pos, newest.seq);
+    size_t since_checkpoint = 0;
+    while (reader_next(&r)) {
+        cJSON *rec = cJSON_Parse(r.line);
+        int rc = rec ? journal_apply_record(rec, &tasks, &count) : 0;
+        cJSON_Delete(rec);
+        if (rc < 0) {
+            written = -1;
+            break;
+        }
+        if (++since_checkpoint < HISTORY_CHECKPOINT_RECORDS) continue;
+        if (write_checkpoint(r.last, r.info.ts, r.archive_pos, tasks, count) != 0) {
+            written = -1;
+            break;
+        }
+        written++;
+        since_checkpoint = 0;
+    }
+    reader_close(&r);
+    storage_free_tasks(tasks, count);
+    return written;
+}
+
+// Helper: load the newest checkpoint taken at or before `at` and open a
+// reader at the records after it
+static Task **start_at(time_t at, size_t *count, RecordReader *r) {
+    history_update();   // Best effort: an older checkpoint only means more replay
+    size_t n = 0;
+    Checkpoint *cps = list_checkpoints(&n);
+    if (!cps || n == 0) {
+        utils_free(cps);
+        return NULL;
+    }
+    size_t pick = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (cps[i].ts <= at) pick = i;
+    }
+    long long archive_pos = 0;
+    Task **tasks = load_checkpoint(&cps[pick], count, &archive_pos);
+    if (tasks) reader_open(r, archive_pos, cps[pick].seq);
+    utils_free(cps);
+    return tasks;
+}
+
+// Helper: parse the next record made at or before `until`; records are in
+// time order, so the first later one ends the walk. Returns NULL at the end.
+static cJSON *next_until(RecordReader *r, time_t until) {
+    while (reader_next(r)) {
+        if (r->info.ts > until) return NULL;
+        cJSON *rec = cJSON_Parse(r->line);
+        if (rec) return rec;
+    }
+    return NULL;
+}
+
+Task **history_state_at(time_t at, size_t *count) {
+    RecordReader r;
+    Task **tasks = start_at(at, count, &r);
+    if (!tasks) return NULL;
+    cJSON *rec;
+    while ((rec = next_until(&r, at)) != NULL) {
+        int rc = journal_apply_record(rec, &tasks, count);
+        cJSON_Delete(rec);
+        if (rc < 0) {
+            reader_close(&r);
+            storage_free_tasks(tasks, *count);
+            return NULL;
+        }
+    }
+    reader_close(&r);
+
+    // The first checkpoint holds tasks from before history; leave out the
+    // ones not yet created
+    size_t kept = 0;
+    for (size_t i = 0; i < *count; i++) {
+        if (tasks[i]->created > at) {
+            task_free(tasks[i]);
+        } else {
+            tasks[kept++] = tasks[i];
+        }
+    }
+    tasks[kept] = NULL;
+    *count = kept;
+    return tasks;
+}
+
+// Helper: index of the task with id, or count if absent
+static size_t find_by_id(Task **tasks, size_t count, const char *id) {
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(tasks[i]->id, id) == 0) return i;
+    }
+    return count;
+}
+
+// Helper: check whether two task objects match apart from their due value
+static bool same_except_due(const Task *a, const Task *b) {
+    cJSON *oa = task_to_cjson(a);
+    cJSON *ob = task_to_cjson(b);
+    const char *const DUE_FIELDS[] = {"due", "due_kind", "due_tz"};
+    for (size_t i = 0; i < sizeof(DUE_FIELDS) / sizeof(DUE_FIELDS[0]); i++) {
+        cJSON_DeleteItemFromObject(oa, DUE_FIELDS[i]);
+        cJSON_DeleteItemFromObject(ob, DUE_FIELDS[i]);
+    }
+    char *ta = oa ? cJSON_PrintUnformatted(oa) : NULL;
+    char *tb = ob ? cJSON_PrintUnformatted(ob) : NULL;
+    bool same = ta && tb && strcmp(ta, tb) == 0;
+    utils_free(ta);
+    utils_free(tb);
+    cJSON_Delete(oa);
+    cJSON_Delete(ob);
+    return same;
+}
+
+// Helper: the task a record completes, or NULL: a task marked done, or a
+// pending recurring task whose due moved on with nothing else changed (the
+// occurrence that was completed is returned)
+static const Task *completed_by(const Task *before, const Task *after) {
+    if (!before || before->status != STATUS_PENDING) return NULL;
+    if (after->status == STATUS_DONE) return after;
+    if (before->recur && after->recur && after->due > before->due && same_except_due(before, after)) {
+        return before;
+    }
+    return NULL;
+}
+
+// Helper: the task a record adds, or NULL: one not in the set before
+// (new, or back after a delete)
+static const Task *added_by(const Task *before, const Task *after) {
+    return before ? NULL : after;
+}
+
+// Helper: list the tasks pick() finds in the put records of a time range,
+// as {"seq":N,"ts":T,"task":{...}}
+static cJSON *list_picked(time_t from, time_t to, const Task *(*pick)(const Task *, const Task *)) {
+    cJSON *entries = cJSON_CreateArray();
+    RecordReader r;
+    size_t count = 0;
+    Task **tasks = entries ? start_at(from, &count, &r) : NULL;
+    if (!tasks) {
+        cJSON_Delete(entries);
+        return NULL;
+    }
+    int rc = 0;
+    cJSON *rec;
+    while (rc >= 0 && (rec = next_until(&r, to)) != NULL) {
+        const cJSON *op = cJSON_GetObjectItem(rec, "op");
+        bool put = cJSON_IsString(op) && (strcmp(op->valuestring, "add") == 0 || strcmp(op->valuestring, "put") == 0);
+        Task *after = (r.info.ts > from && put) ? task_from_cjson(cJSON_GetObjectItem(rec, "task")) : NULL;
+        size_t i = after ? find_by_id(tasks, count, after->id) : count;
+        const Task *picked = after ? pick(i < count ? tasks[i] : NULL, after) : NULL;
+        cJSON *entry = picked ? cJSON_CreateObject() : NULL;
+        if (entry) {
+            cJSON_AddNumberToObject(entry, "seq", (double)r.info.seq);
+            cJSON_AddNumberToObject(entry, "ts", (double)r.info.ts);
+            cJSON_AddItemToObject(entry, "task", task_to_cjson(picked));
+            cJSON_AddItemToArray(entries, entry);
+        }
+        task_free(after);
+        rc = journal_apply_record(rec, &tasks, &count);
+        cJSON_Delete(rec);
+    }
+    reader_close(&r);
+    storage_free_tasks(tasks, count);
+    if (rc < 0) {
+        cJSON_Delete(entries);
+        return NULL;
+    }
+    return entries;
+}
+
+cJSON *history_completed(time_t from, time_t to) {
+    return list_picked(from, to, completed_by);
+}
+
+cJSON *history_added(time_t from, time_t to) {
+    return list_picked(from, to, added_by);
+}
+
+// Helper: the fields that differ between two task objects, as
+// {"field":{"from":old,"to":new}}; before may be NULL
+static cJSON *field_changes(const cJSON *before, const cJSON *after) {
+    cJSON *changes = cJSON_CreateObject();
+    const cJSON *field;
+    cJSON_ArrayForEach(field, after) {
+        const cJSON *old = before ? cJSON_GetObjectItemCaseSensitive(before, field->string) : NULL;
+        char *ta = old ? cJSON_PrintUnformatted(old) : NULL;
+        char *tb = old ? cJSON_PrintUnformatted(field) : NULL;
+        bool same = ta && tb && strcmp(ta, tb) == 0;
+        utils_free(ta);
+        utils_free(tb);
+        if (same) continue;
+        cJSON *change = cJSON_CreateObject();
+        cJSON_AddItemToObject(change, "from", old ? cJSON_Duplicate(old, true) : cJSON_CreateNull());
+        cJSON_AddItemToObject(change, "to", cJSON_Duplicate(field, true));
+        cJSON_AddItemToObject(changes, field->string, change);
+    }
+    cJSON_ArrayForEach(field, before) {
+        if (cJSON_GetObjectItemCaseSensitive(after, field->string)) continue;
+        cJSON *change = cJSON_CreateObject();
+        cJSON_AddItemToObject(change, "from", cJSON_Duplicate(field, true));
+        cJSON_AddItemToObject(change, "to", cJSON_CreateNull());
+        cJSON_AddItemToObject(changes, field->string, change);
+    }
+    return changes;
+}
+
+// Helper: check an id against a prefix, keeping the first id matched;
+// returns true if the id is that task's, and notes a second id in *matches
+static bool match_id(const char *id, size_t id_len, const char *prefix, char **matched, size_t *matches) {
+    size_t plen = strlen(prefix);
+    if (id_len < plen || memcmp(id, prefix, plen) != 0) return false;
+    if (!*matched) {
+        *matched = utils_malloc(id_len + 1);
+        if (!*matched) return false;
+        memcpy(*matched, id, id_len);
+        (*matched)[id_len] = '\0';
+        *matches = 1;
+        return true;
+    }
+    if (strlen(*matched) == id_len && memcmp(*matched, id, id_len) == 0) return true;
+    *matches = 2;
+    return false;
+}
+
+cJSON *history_task(const char *id_prefix, size_t *matches) {
+    *matches = 0;
+    cJSON *events = cJSON_CreateArray();
+    if (!events || !id_prefix[0]) return events;
+    history_update();
+
+    // A task from before history starts out as the first checkpoint has it
+    char *matched = NULL;
+    cJSON *state = NULL;
+    size_t n = 0;
+    Checkpoint *cps = list_checkpoints(&n);
+    long long archive_pos = 0;
+    size_t count = 0;
+    Task **first = (cps && n > 0) ? load_checkpoint(&cps[0], &count, &archive_pos) : NULL;
+    for (size_t i = 0; first && i < count; i++) {
+        if (match_id(first[i]->id, strlen(first[i]->id), id_prefix, &matched, matches) && !state) {
+            state = task_to_cjson(first[i]);
+        }
+    }
+    if (first) storage_free_tasks(first, count);
+    utils_free(cps);
+
+    RecordReader r;
+    reader_open(&r, 0, 0);
+    while (*matches < 2 && reader_next(&r)) {
+        if (!r.info.id || !match_id(r.info.id, r.info.id_len, id_prefix, &matched, matches)) continue;
+        cJSON *rec = cJSON_Parse(r.line);
+        const cJSON *op = cJSON_GetObjectItem(rec, "op");
+        if (!cJSON_IsString(op)) {
+            cJSON_Delete(rec);
+            continue;
+        }
+        cJSON *event = cJSON_CreateObject();
+        cJSON *task = cJSON_DetachItemFromObject(rec, "task");
+        bool deleted = strcmp(op->valuestring, "del") == 0;
+        cJSON_AddNumberToObject(event, "seq", (double)r.info.seq);
+        cJSON_AddNumberToObject(event, "ts", (double)r.info.ts);
+        cJSON_AddStringToObject(event, "type", deleted ? "delete"
+                                : strcmp(op->valuestring, "add") == 0 ? "add" : "update");
+        cJSON_AddItemToObject(event, "changes", task ? field_changes(state, task) : cJSON_CreateObject());
+        cJSON_AddItemToArray(events, event);
+        cJSON_Delete(state);
+        state = task;
+        cJSON_Delete(rec);
+    }
+    reader_close(&r);
+    cJSON_Delete(state);
+    utils_free(matched);
+    if (*matches != 1) {
+        cJSON_Delete(events);
+        events = cJSON_CreateArray();
+    }
+    return events;
+}
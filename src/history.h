@@ -0,0 +1,85 @@
+#ifndef TODO_APP_HISTORY_H
+#define TODO_APP_HISTORY_H
+
+#include <stddef.h>
+#include <time.h>
+#include "task.h"
+
+struct cJSON;
+
+/**
+ * Task history read from the mutation journal and its archive (journal.h).
+ * Time-travel queries start from a checkpoint, a full task set as of one
+ * sequence number saved in ~/.todo-app/history/<seq>-<ts>.json, and replay
+ * only the records after it. A checkpoint is written every
+ * HISTORY_CHECKPOINT_RECORDS records as queries pass them.
+ *
+ * History starts at the first journaled change. Just before that change is
+ * appended, the task set as it was (tasks.json) is saved as the first
+ * checkpoint, so tasks from before history show as they were until their
+ * first change. A journal begun without one gets a first checkpoint of the
+ * current tasks no record mentions; the others show up from their first
+ * change.
+ */
+
+#define HISTORY_DIR "history"
+
+// Records between two checkpoints
+#define HISTORY_CHECKPOINT_RECORDS 1000
+
+/**
+ * Save the task set from before history as the first checkpoint, unless
+ * there is one already. The journal calls this before it appends its first
+ * record, while tasks.json still holds that set.
+ * @return 0 on success, -1 on error
+ */
+int history_begin(void);
+
+/**
+ * Write the checkpoints missing since the last one.
+ * @return Number of checkpoints written, or -1 on error
+ */
+int history_update(void);
+
+/**
+ * Field-level history of one task. Each event is
+ *   {"seq":N,"ts":T,"type":"add"|"update"|"delete",
+ *    "changes":{"field":{"from":old,"to":new},...}}
+ * where an add lists every field (from null) and a delete lists none.
+ * @param id_prefix Unique prefix of the task id (the task may be deleted)
+ * @param matches[out] 0 if no task id has the prefix, 1 if one does, 2 if
+ *        several do; events are returned only for 1
+ * @return Newly allocated JSON array (caller deletes), or NULL on error
+ */
+struct cJSON *history_task(const char *id_prefix, size_t *matches);
+
+/**
+ * Reconstruct the task set as of a moment.
+ * @param at Time to look at
+ * @param count[out] Number of tasks
+ * @return NULL-terminated task array (free with storage_free_tasks()), or NULL on error
+ */
+Task **history_state_at(time_t at, size_t *count);
+
+/**
+ * List the completions in a time range: a task marked done, or an
+ * occurrence of a recurring task completed (its due moved on by itself).
+ * Each entry is {"seq":N,"ts":T,"task":{...}}: the task as marked done, or
+ * the occurrence that was completed.
+ * @param from Start of the range (exclusive)
+ * @param to End of the range (inclusive)
+ * @return Newly allocated JSON array (caller deletes), or NULL on error
+ */
+struct cJSON *history_completed(time_t from, time_t to);
+
+/**
+ * List the tasks added in a time range, including tasks put back after
+ * being deleted. Entries are as for history_completed(), with the task as
+ * added.
+ * @param from Start of the range (exclusive)
+ * @param to End of the range (inclusive)
+ * @return Newly allocated JSON array (caller deletes), or NULL on error
+ */
+struct cJSON *history_added(time_t from, time_t to);
+
+#endif // TODO_APP_HISTORY_H
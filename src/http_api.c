@@ -0,0 +1,1005 @@
+// Sockets, clock_gettime() and strncasecmp() are POSIX, not ISO C
+#define _POSIX_C_SOURCE 200809L
+
+#include "http_api.h"
+#include "journal.h"
+#include "task_manager.h"
+#include "recurrence.h"
+#include "utils.h"
+#include <cjson/cJSON.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#define HTTP_MAX_REQUEST (1024 * 1024)
+#define HTTP_MAX_BATCH 1000
+#define HTTP_MAX_WAITERS 64
+#define HTTP_POLL_DEFAULT_SEC 30
+#define HTTP_POLL_MAX_SEC 300
+#define HTTP_READ_TIMEOUT_SEC 5
+
+// A parked long-poll
+typedef struct {
+    int fd;
+    unsigned long long since;   // Journal sequence number the client has seen
+    size_t limit;
+    long long deadline_ms;      // Monotonic clock
+} Waiter;
+
+struct HttpApi {
+    int fd;
+    CliTasks *set;
+    HttpCommitFn commit;
+    void *user;
+    Waiter waiters[HTTP_MAX_WAITERS];
+    size_t waiter_count;
+};
+
+// One parsed request; the strings point into the request buffer
+typedef struct {
+    const char *method;
+    const char *path;
+    const char *query;          // After '?', or ""
+    const char *host;
+    const char *if_match;
+    const char *if_none_match;
+    const char *body;
+    size_t body_len;
+} HttpRequest;
+
+// Changes requested for one task, parsed and checked before anything runs
+typedef struct {
+    const char *name;
+    bool set_due;
+    time_t due;                 // 0 clears
+    DueKind due_kind;
+    bool set_tags;
+    const char *tags[MAX_TAGS];
+    size_t tag_count;
+    int priority;               // -1 keeps
+    int status;                 // -1 keeps
+    const char *project;
+    bool set_note;
+    const char *note;           // NULL clears
+    bool set_repeat;
+    const char *repeat;         // NULL clears
+} TaskFields;
+
+typedef enum { OP_ADD, OP_UPDATE, OP_DELETE } OpKind;
+
+// One mutation of a batch
+typedef struct {
+    OpKind kind;
+    const char *id;
+    TaskFields fields;
+} BatchOp;
+
+// Filters of a list request
+typedef struct {
+    char project[MAX_PROJECT_LEN + 1];
+    char tag[MAX_TAG_LEN + 1];
+    char q[128];
+    int status;                 // -1 for all
+    int priority;               // -1 for all
+} ListFilter;
+
+// Helper: milliseconds on the monotonic clock
+static long long monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+HttpApi *http_api_create(int port, CliTasks *set, HttpCommitFn commit, void *user) {
+    if (port <= 0 || port > 65535 || !set) return NULL;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return NULL;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    // Loopback only: the API has no authentication
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((unsigned short)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 16) != 0) {
+        close(fd);
+        return NULL;
+    }
+
+    HttpApi *api = utils_calloc(1, sizeof(HttpApi));
+    if (!api) {
+        close(fd);
+        return NULL;
+    }
+    api->fd = fd;
+    api->set = set;
+    api->commit = commit;
+    api->user = user;
+    return api;
+}
+
+void http_api_free(HttpApi *api) {
+    if (!api) return;
+    for (size_t i = 0; i < api->waiter_count; i++) close(api->waiters[i].fd);
+    close(api->fd);
+    utils_free(api);
+}
+
+int http_api_fd(const HttpApi *api) {
+    return api->fd;
+}
+
+// Helper: current generation (the journal's newest sequence number) as text
+static void format_generation(char *buf, size_t size) {
+    snprintf(buf, size, "%llu", journal_last_seq());
+}
+
+// Helper: parse a generation token (quoted, weak or bare); returns false if malformed
+static bool parse_generation(const char *token, unsigned long long *seq) {
+    if (strncmp(token, "W/", 2) == 0) token += 2;
+    if (*token == '"') token++;
+    if (!isdigit((unsigned char)*token)) return false;
+    char *end;
+    errno = 0;
+    *seq = strtoull(token, &end, 10);
+    return errno == 0 && (*end == '\0' || *end == '"');
+}
+
+// Helper: check a client's generation token against the current one
+static bool generation_matches(const char *token) {
+    unsigned long long seq;
+    return parse_generation(token, &seq) && seq == journal_last_seq();
+}
+
+// Helper: write all bytes, retrying short writes
+static void write_all(int fd, const char *p, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return;
+        p += n;
+        len -= (size_t)n;
+    }
+}
+
+static const char *status_text(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 201: return "Created";
+        case 204: return "No Content";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 412: return "Precondition Failed";
+        case 413: return "Payload Too Large";
+        case 503: return "Service Unavailable";
+        default: return "Internal Server Error";
+    }
+}
+
+// Helper: send a complete response; body may be NULL
+static void send_reply(int fd, int status, const cJSON *body) {
+    char *text = body ? cJSON_PrintUnformatted(body) : NULL;
+    size_t len = text ? strlen(text) : 0;
+    char generation[64];
+    format_generation(generation, sizeof(generation));
+    char head[384];
+    int n = snprintf(head, sizeof(head),
+                     "HTTP/1.1 %d %s\r\n"
+                     "Content-Type: application/json\r\n"
+                     "Content-Length: %zu\r\n"
+                     "ETag: \"%s\"\r\n"
+                     "Cache-Control: no-cache\r\n"
+                     "Connection: close\r\n\r\n",
+                     status, status_text(status), len, generation);
+    write_all(fd, head, (size_t)n);
+    if (text) write_all(fd, text, len);
+    utils_free(text);
+}
+
+// Helper: send {"error": message}
+static void send_error(int fd, int status, const char *message) {
+    cJSON *body = cJSON_CreateObject();
+    if (body) cJSON_AddStringToObject(body, "error", message);
+    send_reply(fd, status, body);
+    cJSON_Delete(body);
+}
+
+// Helper: read one request (headers and Content-Length body) into a buffer
+static char *read_request(int fd, size_t *header_len, size_t *total_len, int *status) {
+    size_t cap = 4096, len = 0, want = 0;
+    char *buf = utils_malloc(cap);
+    if (!buf) return NULL;
+    *status = 400;
+    for (;;) {
+        if (want && len >= want) break;
+        if (len + 1 >= cap) {
+            if (cap >= HTTP_MAX_REQUEST) {
+                *status = 413;
+                break;
+            }
+            char *grown = utils_realloc(buf, cap * 2);
+            if (!grown) break;
+            buf = grown;
+            cap *= 2;
+        }
+        ssize_t n = read(fd, buf + len, cap - len - 1);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        len += (size_t)n;
+        buf[len] = '\0';
+        if (!want) {
+            char *end = strstr(buf, "\r\n\r\n");
+            if (!end) continue;
+            *header_len = (size_t)(end - buf) + 4;
+            size_t body = 0;
+            for (char *p = buf; p && p < end; p = strstr(p, "\r\n")) {
+                if (*p == '\r') p += 2;
+                if (strncasecmp(p, "Content-Length:", 15) == 0) body = strtoul(p + 15, NULL, 10);
+            }
+            if (body > HTTP_MAX_REQUEST) {
+                *status = 413;
+                break;
+            }
+            want = *header_len + body;
+        }
+    }
+    if (!want || len < want) {
+        utils_free(buf);
+        return NULL;
+    }
+    *total_len = want;
+    return buf;
+}
+
+// Helper: split the request line and headers in place
+static int parse_request(char *buf, size_t header_len, size_t total_len, HttpRequest *req) {
+    memset(req, 0, sizeof(*req));
+    buf[header_len - 2] = '\0';
+    char *line_end = strstr(buf, "\r\n");
+    if (!line_end) return -1;
+    *line_end = '\0';
+
+    char *sp1 = strchr(buf, ' ');
+    char *sp2 = sp1 ? strchr(sp1 + 1, ' ') : NULL;
+    if (!sp1 || !sp2) return -1;
+    *sp1 = '\0';
+    *sp2 = '\0';
+    req->method = buf;
+    char *path = sp1 + 1;
+    char *q = strchr(path, '?');
+    if (q) *q++ = '\0';
+    req->path = path;
+    req->query = q ? q : "";
+
+    for (char *p = line_end + 2; *p; ) {
+        char *end = strstr(p, "\r\n");
+        if (end) *end = '\0';
+        char *colon = strchr(p, ':');
+        if (colon) {
+            *colon = '\0';
+            char *value = colon + 1;
+            while (*value == ' ') value++;
+            if (strcasecmp(p, "Host") == 0) req->host = value;
+            else if (strcasecmp(p, "If-Match") == 0) req->if_match = value;
+            else if (strcasecmp(p, "If-None-Match") == 0) req->if_none_match = value;
+        }
+        if (!end) break;
+        p = end + 2;
+    }
+    req->body = buf + header_len;
+    req->body_len = total_len - header_len;
+    return 0;
+}
+
+// Helper: get a URL-decoded query parameter; returns false if absent
+static bool query_param(const char *query, const char *name, char *out, size_t size) {
+    size_t name_len = strlen(name);
+    for (const char *p = query; p && *p; p = strchr(p, '&') ? strchr(p, '&') + 1 : NULL) {
+        if (strncmp(p, name, name_len) != 0 || p[name_len] != '=') continue;
+        size_t n = 0;
+        for (const char *v = p + name_len + 1; *v && *v != '&' && n + 1 < size; v++) {
+            if (*v == '+') {
+                out[n++] = ' ';
+            } else if (*v == '%' && isxdigit((unsigned char)v[1]) && isxdigit((unsigned char)v[2])) {
+                char hex[3] = {v[1], v[2], '\0'};
+                out[n++] = (char)strtol(hex, NULL, 16);
+                v += 2;
+            } else {
+                out[n++] = *v;
+            }
+        }
+        out[n] = '\0';
+        return true;
+    }
+    return false;
+}
+
+static int parse_priority(const char *s) {
+    if (strcmp(s, "low") == 0) return PRIORITY_LOW;
+    if (strcmp(s, "medium") == 0) return PRIORITY_MEDIUM;
+    if (strcmp(s, "high") == 0) return PRIORITY_HIGH;
+    return -1;
+}
+
+static int parse_status(const char *s) {
+    if (strcmp(s, "pending") == 0) return STATUS_PENDING;
+    if (strcmp(s, "done") == 0) return STATUS_DONE;
+    return -1;
+}
+
+// Helper: index of the task with this id, or set->count
+static size_t find_task(const CliTasks *set, const char *id) {
+    for (size_t i = 0; id && i < set->count; i++) {
+        if (set->tasks[i]->id && strcmp(set->tasks[i]->id, id) == 0) return i;
+    }
+    return set->count;
+}
+
+// Helper: parse task fields; returns NULL or the error message
+static const char *parse_fields(const cJSON *obj, TaskFields *f) {
+    memset(f, 0, sizeof(*f));
+    f->priority = -1;
+    f->status = -1;
+    if (!cJSON_IsObject(obj)) return "fields must be an object";
+
+    const cJSON *item;
+    cJSON_ArrayForEach(item, obj) {
+        const char *key = item->string;
+        const char *s = cJSON_IsString(item) ? item->valuestring : NULL;
+        if (strcmp(key, "id") == 0 || strcmp(key, "generation") == 0) {
+            continue;   // Addressing, not fields
+        } else if (strcmp(key, "name") == 0) {
+            if (!s || !*s) return "name must be a non-empty string";
+            f->name = s;
+        } else if (strcmp(key, "due") == 0) {
+            f->set_due = true;
+            if (cJSON_IsNull(item)) continue;
+            bool date_only = false;
+            if (!s || (f->due = utils_parse_due(s, &date_only)) == 0) return "invalid due";
+            f->due_kind = date_only ? DUE_DATE : DUE_DATETIME;
+        } else if (strcmp(key, "tags") == 0) {
+            if (!cJSON_IsArray(item) || cJSON_GetArraySize(item) > MAX_TAGS) return "tags must be an array of at most 5 strings";
+            f->set_tags = true;
+            const cJSON *tag;
+            cJSON_ArrayForEach(tag, item) {
+                if (!cJSON_IsString(tag)) return "tags must be strings";
+                f->tags[f->tag_count++] = tag->valuestring;
+            }
+        } else if (strcmp(key, "priority") == 0) {
+            if (!s || (f->priority = parse_priority(s)) < 0) return "priority must be low, medium or high";
+        } else if (strcmp(key, "status") == 0) {
+            if (!s || (f->status = parse_status(s)) < 0) return "status must be pending or done";
+        } else if (strcmp(key, "project") == 0) {
+            if (!s || !*s) return "project must be a non-empty string";
+            f->project = s;
+        } else if (strcmp(key, "note") == 0) {
+            if (!s && !cJSON_IsNull(item)) return "note must be a string or null";
+            f->set_note = true;
+            f->note = s;
+        } else if (strcmp(key, "repeat") == 0) {
+            Recurrence r;
+            if (!s && !cJSON_IsNull(item)) return "repeat must be a string or null";
+            if (s && recurrence_parse(s, &r) != 0) return "invalid repeat rule";
+            f->set_repeat = true;
+            f->repeat = s;
+        } else {
+            return "unknown field";
+        }
+    }
+    return NULL;
+}
+
+// Helper: check one batch operation; returns 0 or an HTTP status with *error set
+static int check_op(const CliTasks *set, const BatchOp *ops, size_t index, const char **error) {
+    const BatchOp *op = &ops[index];
+    if (op->kind == OP_ADD) {
+        if (!op->fields.name) {
+            *error = "name is required";
+            return 400;
+        }
+        if (op->fields.repeat && op->fields.due == 0) {
+            *error = "a repeating task needs a due date";
+            return 400;
+        }
+        return 0;
+    }
+
+    // Check against the task as the earlier operations leave it
+    size_t i = find_task(set, op->id);
+    time_t due = i < set->count ? set->tasks[i]->due : 0;
+    for (size_t k = 0; k < index && i < set->count; k++) {
+        if (ops[k].kind == OP_ADD || strcmp(ops[k].id, op->id) != 0) continue;
+        if (ops[k].kind == OP_DELETE) i = set->count;
+        else if (ops[k].fields.set_due) due = ops[k].fields.due;
+    }
+    if (i == set->count) {
+        *error = "no task with that id";
+        return 404;
+    }
+    const TaskFields *f = &op->fields;
+    if (op->kind == OP_UPDATE && f->repeat && (f->set_due ? f->due : due) == 0) {
+        *error = "a repeating task needs a due date";
+        return 400;
+    }
+    return 0;
+}
+
+// Helper: register a project so the TUI lists it
+static void remember_project(const char *project) {
+    task_manager_load_projects();
+    task_manager_add_project(project);
+    task_manager_save_projects();
+}
+
+// Helper: apply the fields the task_manager setters do not cover
+static int apply_extras(Task *t, const TaskFields *f) {
+    if (f->project) {
+        char *project = utils_strdup(f->project);
+        if (!project) return -1;
+        utils_free(t->project);
+        t->project = project;
+        remember_project(project);
+    }
+    if (f->set_note && task_set_note(t, f->note) != 0) return -1;
+    if (f->set_due && f->due == 0) task_set_recurrence(t, NULL);
+    if (f->set_repeat && task_set_recurrence(t, f->repeat) != 0) return -1;
+    if (f->project || f->set_note || f->set_repeat) task_manager_notify_change(TASK_CHANGE_PUT, t);
+    return 0;
+}
+
+// Helper: run one checked operation; returns its result object, or NULL on failure
+static cJSON *apply_op(CliTasks *set, const BatchOp *op) {
+    const TaskFields *f = &op->fields;
+    Task *t;
+    if (op->kind == OP_ADD) {
+        if (task_manager_add_task(&set->tasks, &set->count, f->name, f->set_due ? f->due : 0, f->due_kind,
+                                  (const char **)f->tags, f->tag_count,
+                                  f->priority >= 0 ? (Priority)f->priority : PRIORITY_LOW,
+                                  f->project ? f->project : "default") != 0) {
+            return NULL;
+        }
+        t = set->tasks[set->count - 1];
+        if (apply_extras(t, f) != 0) return NULL;
+        if (f->status == STATUS_DONE) task_manager_update_task(t, NULL, -1, DUE_NONE, NULL, 0, -1, STATUS_DONE);
+        return task_to_cjson(t);
+    }
+
+    size_t i = find_task(set, op->id);
+    if (i == set->count) return NULL;
+    t = set->tasks[i];
+    if (op->kind == OP_DELETE) {
+        cJSON *result = cJSON_CreateObject();
+        if (!result) return NULL;
+        cJSON_AddStringToObject(result, "id", t->id);
+        cJSON_AddTrueToObject(result, "deleted");
+        if (task_manager_delete_task(&set->tasks, &set->count, i) != 0) {
+            cJSON_Delete(result);
+            return NULL;
+        }
+        return result;
+    }
+
+    // Completing goes through task_manager so a recurring task advances
+    bool complete = f->status == STATUS_DONE && t->status == STATUS_PENDING;
+    if (f->name || f->set_due || f->set_tags || f->priority >= 0 || (f->status >= 0 && !complete)) {
+        if (task_manager_update_task(t, f->name, f->set_due ? f->due : -1, f->due_kind,
+                                     f->set_tags ? (const char **)f->tags : NULL, f->tag_count,
+                                     f->priority, complete ? -1 : f->status) != 0) {
+            return NULL;
+        }
+    }
+    if (apply_extras(t, f) != 0) return NULL;
+    if (complete) task_manager_complete_task(t);
+    return task_to_cjson(t);
+}
+
+// Helper: check every operation, then run them all; returns the results array
+// or NULL with *status and *error set
+static cJSON *run_ops(HttpApi *api, const BatchOp *ops, size_t count, int *status, const char **error) {
+    for (size_t i = 0; i < count; i++) {
+        if ((*status = check_op(api->set, ops, i, error)) != 0) return NULL;
+    }
+    cJSON *results = cJSON_CreateArray();
+    if (!results) {
+        *status = 500;
+        *error = "out of memory";
+        return NULL;
+    }
+    *status = 200;
+    for (size_t i = 0; i < count; i++) {
+        cJSON *result = apply_op(api->set, &ops[i]);
+        if (!result) {
+            *status = 500;
+            *error = "failed to apply change";
+            break;
+        }
+        cJSON_AddItemToArray(results, result);
+    }
+    // Whatever ran is already in memory and journaled by the change hook
+    if (api->commit && api->commit(api->user) != 0 && *status == 200) {
+        *status = 500;
+        *error = "failed to write change";
+    }
+    if (*status != 200) {
+        cJSON_Delete(results);
+        return NULL;
+    }
+    return results;
+}
+
+// Helper: parse a batch array into operations; returns NULL or the error message
+static const char *parse_batch(const cJSON *array, BatchOp **ops_out, size_t *count) {
+    *ops_out = NULL;
+    *count = 0;
+    if (!cJSON_IsArray(array)) return "batch must be an array";
+    int n = cJSON_GetArraySize(array);
+    if (n == 0 || n > HTTP_MAX_BATCH) return "batch must hold 1 to 1000 operations";
+    BatchOp *ops = utils_calloc((size_t)n, sizeof(BatchOp));
+    if (!ops) return "out of memory";
+
+    const cJSON *item;
+    cJSON_ArrayForEach(item, array) {
+        BatchOp *op = &ops[(*count)++];
+        const cJSON *kind = cJSON_GetObjectItem(item, "op");
+        const cJSON *id = cJSON_GetObjectItem(item, "id");
+        const cJSON *fields = cJSON_GetObjectItem(item, "fields");
+        const char *k = cJSON_IsString(kind) ? kind->valuestring : "";
+        if (strcmp(k, "add") == 0) op->kind = OP_ADD;
+        else if (strcmp(k, "update") == 0) op->kind = OP_UPDATE;
+        else if (strcmp(k, "delete") == 0) op->kind = OP_DELETE;
+        else goto bad_op;
+        if (op->kind != OP_ADD) {
+            if (!cJSON_IsString(id)) goto bad_op;
+            op->id = id->valuestring;
+        }
+        const char *error = parse_fields(fields ? fields : item, &op->fields);
+        if (op->kind == OP_DELETE) error = NULL;
+        else if (!fields) error = "fields are required";
+        if (error) {
+            utils_free(ops);
+            return error;
+        }
+    }
+    *ops_out = ops;
+    return NULL;
+
+bad_op:
+    utils_free(ops);
+    return "each operation needs op (add, update, delete) and, unless adding, id";
+}
+
+// Helper: read list filters from a query string or a JSON-RPC params object
+static const char *parse_filter(const char *query, const cJSON *params, ListFilter *lf) {
+    char status[16] = "all", priority[16] = "";
+    memset(lf, 0, sizeof(*lf));
+    if (query) {
+        query_param(query, "project", lf->project, sizeof(lf->project));
+        query_param(query, "tag", lf->tag, sizeof(lf->tag));
+        query_param(query, "q", lf->q, sizeof(lf->q));
+        query_param(query, "status", status, sizeof(status));
+        query_param(query, "priority", priority, sizeof(priority));
+    } else {
+        const char *const keys[] = {"project", "tag", "q", "status", "priority"};
+        char *const bufs[] = {lf->project, lf->tag, lf->q, status, priority};
+        const size_t sizes[] = {sizeof(lf->project), sizeof(lf->tag), sizeof(lf->q), sizeof(status), sizeof(priority)};
+        for (size_t i = 0; i < 5; i++) {
+            const cJSON *v = cJSON_GetObjectItem(params, keys[i]);
+            if (cJSON_IsString(v)) snprintf(bufs[i], sizes[i], "%s", v->valuestring);
+        }
+    }
+    lf->status = strcmp(status, "all") == 0 ? -1 : parse_status(status);
+    if (strcmp(status, "all") != 0 && lf->status < 0) return "status must be pending, done or all";
+    lf->priority = priority[0] ? parse_priority(priority) : -1;
+    if (priority[0] && lf->priority < 0) return "priority must be low, medium or high";
+    return NULL;
+}
+
+// Helper: build {"generation":..., "tasks":[...]} for the tasks passing the filter
+static cJSON *list_tasks(const HttpApi *api, const ListFilter *lf) {
+    cJSON *result = cJSON_CreateObject();
+    if (!result) return NULL;
+    char generation[64];
+    format_generation(generation, sizeof(generation));
+    cJSON_AddStringToObject(result, "generation", generation);
+    cJSON *array = cJSON_AddArrayToObject(result, "tasks");
+    for (size_t i = 0; array && i < api->set->count; i++) {
+        const Task *t = api->set->tasks[i];
+        if (lf->project[0] && strcmp(t->project ? t->project : "default", lf->project) != 0) continue;
+        if (lf->status >= 0 && t->status != (Status)lf->status) continue;
+        if (lf->priority >= 0 && t->priority != (Priority)lf->priority) continue;
+        if (lf->tag[0] && !task_has_tag(t, lf->tag)) continue;
+        if (lf->q[0] && !task_matches_search(t, lf->q)) continue;
+        cJSON *obj = task_to_cjson(t);
+        if (obj) cJSON_AddItemToArray(array, obj);
+    }
+    return result;
+}
+
+// Helper: build {"seq":..., "gap":..., "events":[...]} for the changes after since
+static cJSON *list_changes(unsigned long long since, size_t limit) {
+    unsigned long long next;
+    bool gap;
+    cJSON *events = journal_changes(since, limit, &next, &gap);
+    cJSON *result = events ? cJSON_CreateObject() : NULL;
+    if (!result) {
+        cJSON_Delete(events);
+        return NULL;
+    }
+    cJSON_AddNumberToObject(result, "seq", (double)next);
+    cJSON_AddBoolToObject(result, "gap", gap);
+    cJSON_AddItemToObject(result, "events", events);
+    return result;
+}
+
+// Helper: build a JSON-RPC error response
+static cJSON *rpc_error(const cJSON *id, int code, const char *message) {
+    cJSON *resp = cJSON_CreateObject();
+    if (!resp) return NULL;
+    cJSON_AddStringToObject(resp, "jsonrpc", "2.0");
+    cJSON *err = cJSON_AddObjectToObject(resp, "error");
+    if (err) {
+        cJSON_AddNumberToObject(err, "code", code);
+        cJSON_AddStringToObject(err, "message", message);
+    }
+    cJSON_AddItemToObject(resp, "id", id ? cJSON_Duplicate(id, true) : cJSON_CreateNull());
+    return resp;
+}
+
+// Helper: map an HTTP-style status to a JSON-RPC error code
+static int rpc_code(int status) {
+    switch (status) {
+        case 400: return -32602;
+        case 404: return -32004;
+        case 412: return -32009;
+        default: return -32603;
+    }
+}
+
+// Helper: run one JSON-RPC call; returns its response, or NULL for a notification
+static cJSON *rpc_call(HttpApi *api, const cJSON *call) {
+    const cJSON *id = cJSON_GetObjectItem(call, "id");
+    const cJSON *version = cJSON_GetObjectItem(call, "jsonrpc");
+    const cJSON *method = cJSON_GetObjectItem(call, "method");
+    const cJSON *params = cJSON_GetObjectItem(call, "params");
+    if (!cJSON_IsObject(call) || !cJSON_IsString(version) || strcmp(version->valuestring, "2.0") != 0
+        || !cJSON_IsString(method) || (params && !cJSON_IsObject(params))) {
+        return rpc_error(id, -32600, "invalid request");
+    }
+    const char *m = method->valuestring;
+    const cJSON *task_id = cJSON_GetObjectItem(params, "id");
+    const cJSON *generation = cJSON_GetObjectItem(params, "generation");
+    cJSON *result = NULL;
+    const char *error = NULL;
+    int status = 0;
+
+    if (strcmp(m, "tasks.list") == 0) {
+        ListFilter lf;
+        if ((error = parse_filter(NULL, params, &lf)) != NULL) status = 400;
+        else result = list_tasks(api, &lf);
+    } else if (strcmp(m, "tasks.get") == 0) {
+        size_t i = find_task(api->set, cJSON_IsString(task_id) ? task_id->valuestring : NULL);
+        if (i == api->set->count) {
+            status = 404;
+            error = "no task with that id";
+        } else {
+            result = task_to_cjson(api->set->tasks[i]);
+        }
+    } else if (strcmp(m, "tasks.add") == 0 || strcmp(m, "tasks.update") == 0
+               || strcmp(m, "tasks.delete") == 0 || strcmp(m, "tasks.batch") == 0) {
+        BatchOp single, *ops = &single;
+        size_t count = 1;
+        bool batch = strcmp(m, "tasks.batch") == 0;
+        memset(&single, 0, sizeof(single));
+        if (cJSON_IsString(generation) && !generation_matches(generation->valuestring)) {
+            status = 412;
+            error = "generation mismatch";
+        } else if (batch) {
+            if ((error = parse_batch(cJSON_GetObjectItem(params, "ops"), &ops, &count)) != NULL) status = 400;
+        } else {
+            single.kind = m[6] == 'a' ? OP_ADD : m[6] == 'u' ? OP_UPDATE : OP_DELETE;
+            single.id = cJSON_IsString(task_id) ? task_id->valuestring : NULL;
+            if (single.kind != OP_ADD && !single.id) error = "id is required";
+            else if (single.kind != OP_DELETE) error = parse_fields(params, &single.fields);
+            if (error) status = 400;
+        }
+        if (!error) {
+            cJSON *results = run_ops(api, ops, count, &status, &error);
+            if (results && !batch) {
+                result = cJSON_DetachItemFromArray(results, 0);
+                cJSON_Delete(results);
+            } else {
+                result = results;
+            }
+        }
+        if (ops != &single) utils_free(ops);
+    } else if (strcmp(m, "changes.list") == 0) {
+        const cJSON *since = cJSON_GetObjectItem(params, "since");
+        const cJSON *limit = cJSON_GetObjectItem(params, "limit");
+        if ((since && (!cJSON_IsNumber(since) || since->valuedouble < 0))
+            || (limit && (!cJSON_IsNumber(limit) || limit->valuedouble < 0))) {
+            status = 400;
+            error = "since and limit must be non-negative numbers";
+        } else {
+            result = list_changes(since ? (unsigned long long)since->valuedouble : 0,
+                                  limit ? (size_t)limit->valuedouble : 0);
+            if (!result) error = "cannot read the journal";
+        }
+    } else {
+        if (!id) return NULL;
+        return rpc_error(id, -32601, "method not found");
+    }
+
+    if (!id) {
+        cJSON_Delete(result);
+        return NULL;
+    }
+    if (!result) return rpc_error(id, rpc_code(status), error ? error : "out of memory");
+    cJSON *resp = cJSON_CreateObject();
+    if (!resp) {
+        cJSON_Delete(result);
+        return NULL;
+    }
+    cJSON_AddStringToObject(resp, "jsonrpc", "2.0");
+    cJSON_AddItemToObject(resp, "result", result);
+    cJSON_AddItemToObject(resp, "id", cJSON_Duplicate(id, true));
+    return resp;
+}
+
+// Helper: POST /rpc with a single call or a batch
+static void handle_rpc(HttpApi *api, int fd, const HttpRequest *req) {
+    cJSON *body = cJSON_ParseWithLength(req->body, req->body_len);
+    cJSON *reply = NULL;
+    if (!body) {
+        reply = rpc_error(NULL, -32700, "parse error");
+    } else if (cJSON_IsArray(body)) {
+        if (cJSON_GetArraySize(body) == 0) {
+            reply = rpc_error(NULL, -32600, "invalid request");
+        } else {
+            reply = cJSON_CreateArray();
+            const cJSON *call;
+            cJSON_ArrayForEach(call, body) {
+                cJSON *resp = rpc_call(api, call);
+                if (resp && reply) cJSON_AddItemToArray(reply, resp);
+                else cJSON_Delete(resp);
+            }
+            if (reply && cJSON_GetArraySize(reply) == 0) {
+                cJSON_Delete(reply);
+                reply = NULL;
+            }
+        }
+    } else {
+        reply = rpc_call(api, body);
+    }
+    cJSON_Delete(body);
+    send_reply(fd, reply ? 200 : 204, reply);
+    cJSON_Delete(reply);
+}
+
+// Helper: run REST mutations and send the reply
+static void handle_mutation(HttpApi *api, int fd, const HttpRequest *req, OpKind kind, const char *id) {
+    if (req->if_match && strcmp(req->if_match, "*") != 0 && !generation_matches(req->if_match)) {
+        send_error(fd, 412, "generation mismatch");
+        return;
+    }
+    cJSON *body = NULL;
+    if (kind != OP_DELETE || req->body_len > 0) {
+        body = cJSON_ParseWithLength(req->body, req->body_len);
+        if (!body) {
+            send_error(fd, 400, "body must be JSON");
+            return;
+        }
+    }
+
+    BatchOp single, *ops = &single;
+    size_t count = 1;
+    const char *error = NULL;
+    memset(&single, 0, sizeof(single));
+    bool batch = id == NULL && kind == OP_UPDATE;   // POST /tasks/batch
+    if (batch) {
+        error = parse_batch(body, &ops, &count);
+    } else {
+        single.kind = kind;
+        single.id = id;
+        if (kind != OP_DELETE) error = parse_fields(body, &single.fields);
+    }
+
+    int status = 400;
+    cJSON *results = error ? NULL : run_ops(api, ops, count, &status, &error);
+    if (!results) {
+        send_error(fd, status, error);
+    } else if (batch) {
+        cJSON *reply = cJSON_CreateObject();
+        char generation[64];
+        format_generation(generation, sizeof(generation));
+        if (reply) {
+            cJSON_AddStringToObject(reply, "generation", generation);
+            cJSON_AddItemToObject(reply, "results", results);
+            results = NULL;
+        }
+        send_reply(fd, 200, reply);
+        cJSON_Delete(reply);
+    } else if (kind == OP_DELETE) {
+        send_reply(fd, 204, NULL);
+    } else {
+        send_reply(fd, kind == OP_ADD ? 201 : 200, cJSON_GetArrayItem(results, 0));
+    }
+    cJSON_Delete(results);
+    cJSON_Delete(body);
+    if (ops != &single) utils_free(ops);
+}
+
+// Helper: answer a /changes request
+static void send_changes(int fd, unsigned long long since, size_t limit) {
+    cJSON *reply = list_changes(since, limit);
+    if (reply) send_reply(fd, 200, reply);
+    else send_error(fd, 500, "cannot read the journal");
+    cJSON_Delete(reply);
+}
+
+// Helper: GET /changes; answers now or parks the connection. Returns true if parked.
+static bool handle_changes(HttpApi *api, int fd, const HttpRequest *req) {
+    char since_text[32] = "", limit_text[16] = "", timeout[16] = "";
+    query_param(req->query, "since", since_text, sizeof(since_text));
+    query_param(req->query, "limit", limit_text, sizeof(limit_text));
+    query_param(req->query, "timeout", timeout, sizeof(timeout));
+    long seconds = timeout[0] ? strtol(timeout, NULL, 10) : HTTP_POLL_DEFAULT_SEC;
+    if (seconds < 0) seconds = 0;
+    if (seconds > HTTP_POLL_MAX_SEC) seconds = HTTP_POLL_MAX_SEC;
+    long limit = limit_text[0] ? strtol(limit_text, NULL, 10) : 0;
+    if (limit < 0) limit = 0;
+
+    // Without since, report where the feed is so the client can start there
+    unsigned long long since = journal_last_seq();
+    if (since_text[0] && !parse_generation(since_text, &since)) {
+        send_error(fd, 400, "since must be a sequence number");
+        return false;
+    }
+    if (since != journal_last_seq() || seconds == 0) {
+        send_changes(fd, since, (size_t)limit);
+        return false;
+    }
+    if (api->waiter_count == HTTP_MAX_WAITERS) {
+        send_error(fd, 503, "too many waiting clients");
+        return false;
+    }
+    Waiter *w = &api->waiters[api->waiter_count++];
+    w->fd = fd;
+    w->since = since;
+    w->limit = (size_t)limit;
+    w->deadline_ms = monotonic_ms() + seconds * 1000;
+    return true;
+}
+
+// Helper: only loopback names may be used to reach the API (DNS rebinding)
+static bool host_allowed(const char *host) {
+    if (!host) return true;
+    const char *const names[] = {"127.0.0.1", "localhost", "[::1]"};
+    for (size_t i = 0; i < 3; i++) {
+        size_t len = strlen(names[i]);
+        if (strncasecmp(host, names[i], len) == 0 && (host[len] == '\0' || host[len] == ':')) return true;
+    }
+    return false;
+}
+
+// Helper: route a parsed request; returns true if the connection was parked
+static bool route(HttpApi *api, int fd, const HttpRequest *req) {
+    const char *m = req->method;
+    const char *path = req->path;
+    if (!host_allowed(req->host)) {
+        send_error(fd, 403, "forbidden host");
+        return false;
+    }
+
+    if (strcmp(path, "/rpc") == 0) {
+        if (strcmp(m, "POST") == 0) handle_rpc(api, fd, req);
+        else send_error(fd, 405, "use POST");
+    } else if (strcmp(path, "/changes") == 0) {
+        if (strcmp(m, "GET") == 0) return handle_changes(api, fd, req);
+        send_error(fd, 405, "use GET");
+    } else if (strcmp(path, "/tasks") == 0) {
+        if (strcmp(m, "GET") == 0) {
+            ListFilter lf;
+            const char *error = parse_filter(req->query, NULL, &lf);
+            if (error) {
+                send_error(fd, 400, error);
+            } else if (req->if_none_match && generation_matches(req->if_none_match)) {
+                send_reply(fd, 304, NULL);
+            } else {
+                cJSON *reply = list_tasks(api, &lf);
+                send_reply(fd, reply ? 200 : 500, reply);
+                cJSON_Delete(reply);
+            }
+        } else if (strcmp(m, "POST") == 0) {
+            handle_mutation(api, fd, req, OP_ADD, NULL);
+        } else {
+            send_error(fd, 405, "use GET or POST");
+        }
+    } else if (strcmp(path, "/tasks/batch") == 0) {
+        if (strcmp(m, "POST") == 0) handle_mutation(api, fd, req, OP_UPDATE, NULL);
+        else send_error(fd, 405, "use POST");
+    } else if (strncmp(path, "/tasks/", 7) == 0) {
+        const char *id = path + 7;
+        if (strcmp(m, "GET") == 0) {
+            size_t i = find_task(api->set, id);
+            if (i == api->set->count) {
+                send_error(fd, 404, "no task with that id");
+            } else {
+                cJSON *reply = task_to_cjson(api->set->tasks[i]);
+                send_reply(fd, reply ? 200 : 500, reply);
+                cJSON_Delete(reply);
+            }
+        } else if (strcmp(m, "PATCH") == 0) {
+            handle_mutation(api, fd, req, OP_UPDATE, id);
+        } else if (strcmp(m, "DELETE") == 0) {
+            handle_mutation(api, fd, req, OP_DELETE, id);
+        } else {
+            send_error(fd, 405, "use GET, PATCH or DELETE");
+        }
+    } else {
+        send_error(fd, 404, "no such endpoint");
+    }
+    return false;
+}
+
+void http_api_accept(HttpApi *api) {
+    int fd = accept(api->fd, NULL, NULL);
+    if (fd < 0) return;
+    struct timeval tv = {HTTP_READ_TIMEOUT_SEC, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    size_t header_len = 0, total_len = 0;
+    int status = 400;
+    char *buf = read_request(fd, &header_len, &total_len, &status);
+    HttpRequest req;
+    bool parked = false;
+    if (!buf) {
+        send_error(fd, status, status == 413 ? "request too large" : "malformed request");
+    } else if (parse_request(buf, header_len, total_len, &req) != 0) {
+        send_error(fd, 400, "malformed request");
+    } else {
+        parked = route(api, fd, &req);
+    }
+    utils_free(buf);
+    if (!parked) close(fd);
+}
+
+void http_api_wake(HttpApi *api) {
+    if (!api || api->waiter_count == 0) return;
+    long long now = monotonic_ms();
+    unsigned long long newest = journal_last_seq();
+    size_t kept = 0;
+    for (size_t i = 0; i < api->waiter_count; i++) {
+        Waiter w = api->waiters[i];
+        if (w.since == newest && now < w.deadline_ms) {
+            api->waiters[kept++] = w;
+            continue;
+        }
+        send_changes(w.fd, w.since, w.limit);
+        close(w.fd);
+    }
+    api->waiter_count = kept;
+}
+
+int http_api_timeout_ms(const HttpApi *api) {
+    if (!api || api->waiter_count == 0) return -1;
+    long long now = monotonic_ms();
+    long long soonest = api->waiters[0].deadline_ms;
+    for (size_t i = 1; i < api->waiter_count; i++) {
+        if (api->waiters[i].deadline_ms < soonest) soonest = api->waiters[i].deadline_ms;
+    }
+    return soonest <= now ? 0 : (int)(soonest - now);
+}
@@ -0,0 +1,80 @@
+#ifndef TODO_APP_HTTP_API_H
+#define TODO_APP_HTTP_API_H
+
+#include "cli.h"
+
+/**
+ * Local HTTP/JSON API served by the daemon on 127.0.0.1 (`smartodo daemon
+ * --http [PORT]`). One request per connection; bodies are JSON.
+ *
+ *   GET    /tasks[?project=&status=&tag=&priority=&q=]  list; ETag + If-None-Match
+ *   GET    /tasks/<id>                                  one task
+ *   POST   /tasks                                       add (fields below)
+ *   PATCH  /tasks/<id>                                  update
+ *   DELETE /tasks/<id>                                  delete
+ *   POST   /tasks/batch  [{"op":"add|update|delete","id":..,"fields":{..}}]
+ *                        all-or-nothing: every op is checked before any runs
+ *   GET    /changes?since=<seq>&limit=<n>&timeout=<sec>  change feed (journal.h):
+ *                        {"seq":next,"gap":bool,"events":[...]}; waits until
+ *                        something follows since (or the timeout ends)
+ *   POST   /rpc          JSON-RPC 2.0 (single or batch): tasks.list, tasks.get,
+ *                        tasks.add, tasks.update, tasks.delete, tasks.batch,
+ *                        changes.list {since, limit}
+ *
+ * Task fields: name, due (any date the CLI accepts, or null), tags,
+ * priority (low|medium|high), status (pending|done), project, note, repeat.
+ * The generation is the journal's newest sequence number, so it survives
+ * restarts. Every response carries it as its ETag; mutations honour
+ * If-Match (412 when the set changed since that generation).
+ */
+
+#define HTTP_API_DEFAULT_PORT 8765
+
+// Called before a mutation is acknowledged; returns 0 once it is durable
+typedef int (*HttpCommitFn)(void *user);
+
+typedef struct HttpApi HttpApi;
+
+/**
+ * Bind the listener on 127.0.0.1.
+ * @param port TCP port
+ * @param set Task set the API reads and changes (owned by the caller)
+ * @param commit Durability callback run after each successful mutation
+ * @param user Passed to commit
+ * @return New API, or NULL if the port cannot be bound
+ */
+HttpApi *http_api_create(int port, CliTasks *set, HttpCommitFn commit, void *user);
+
+/**
+ * Close the listener and every waiting long-poll.
+ * @param api API, or NULL
+ */
+void http_api_free(HttpApi *api);
+
+/**
+ * Get the listening socket, for poll().
+ * @param api API
+ * @return File descriptor
+ */
+int http_api_fd(const HttpApi *api);
+
+/**
+ * Accept one connection and answer it, or park it if it is a long-poll.
+ * @param api API
+ */
+void http_api_accept(HttpApi *api);
+
+/**
+ * Answer long-polls whose generation moved or whose timeout passed.
+ * @param api API
+ */
+void http_api_wake(HttpApi *api);
+
+/**
+ * Get how long poll() may sleep before a long-poll times out.
+ * @param api API
+ * @return Milliseconds, or -1 if nobody is waiting
+ */
+int http_api_timeout_ms(const HttpApi *api);
+
+#endif // TODO_APP_HTTP_API_H
@@ -0,0 +1,694 @@
+// fsync(), fileno(), pread(), fcntl() locks and getline() are POSIX, not ISO C
+#define _POSIX_C_SOURCE 200809L
+
+#include "journal.h"
+#include "storage.h"
+#include "history.h"
+#include "utils.h"
+#include "app_clock.h"
+#include <cjson/cJSON.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// Bytes read back from the end of the journal to find the newest sequence number
+#define JOURNAL_TAIL_BYTES 65536
+
+// Every record starts with this, so the sequence number is found without parsing
+#define RECORD_PREFIX "{\"seq\":"
+
+static FILE *journal_fp = NULL;             // Append handle, kept open between records
+static unsigned long long last_seq = 0;     // Newest sequence number known
+static long long known_size = -1;           // Journal size last_seq was read at
+
+// Helper: read journal.base; a missing file reads as nothing checkpointed
+static void read_base(unsigned long long *seq, long long *offset) {
+    *seq = 0;
+    *offset = 0;
+    char *path = storage_path(JOURNAL_BASE_FILE);
+    FILE *f = path ? fopen(path, "r") : NULL;
+    utils_free(path);
+    if (!f) return;
+    if (fscanf(f, "%llu %lld", seq, offset) != 2) {
+        *seq = 0;
+        *offset = 0;
+    }
+    fclose(f);
+}
+
+// Helper: replace journal.base atomically
+static int write_base(unsigned long long seq, long long offset) {
+    char line[64];
+    int n = snprintf(line, sizeof(line), "%llu %lld\n", seq, offset);
+    char *path = storage_path(JOURNAL_BASE_FILE);
+    int rc = path ? utils_write_file_atomic(path, line, (size_t)n) : -1;
+    utils_free(path);
+    return rc;
+}
+
+// Helper: sequence number of the last record in an open journal of this size
+static unsigned long long scan_last_seq(FILE *f, long long size) {
+    long long start = size > JOURNAL_TAIL_BYTES ? size - JOURNAL_TAIL_BYTES : 0;
+    char *buf = utils_malloc(JOURNAL_TAIL_BYTES + 2);
+    if (!buf) return 0;
+    buf[0] = '\n';    // A record at the very start is found like the others
+    size_t n = 0;
+    if (fseek(f, start, SEEK_SET) == 0) n = fread(buf + 1, 1, (size_t)(size - start), f);
+    buf[n + 1] = '\0';
+
+    unsigned long long seq = 0;
+    for (char *p = buf; (p = strstr(p, "\n" RECORD_PREFIX)) != NULL; p++) {
+        seq = strtoull(p + 1 + strlen(RECORD_PREFIX), NULL, 10);
+    }
+    utils_free(buf);
+    return seq;
+}
+
+// Helper: bring last_seq up to date if the journal changed since it was read
+static void sync_last_seq(FILE *f) {
+    struct stat st;
+    if (fstat(fileno(f), &st) != 0 || (long long)st.st_size == known_size) return;
+    unsigned long long base_seq;
+    long long offset;
+    read_base(&base_seq, &offset);
+    unsigned long long seq = scan_last_seq(f, (long long)st.st_size);
+    last_seq = seq > base_seq ? seq : base_seq;
+    known_size = (long long)st.st_size;
+    fseek(f, 0, SEEK_END);
+}
+
+// Helper: serialize one record
+static char *format_record(JournalOp op, const Task *task, unsigned long long seq) {
+    cJSON *rec = cJSON_CreateObject();
+    if (!rec) return NULL;
+    cJSON_AddNumberToObject(rec, "seq", (double)seq);
+    cJSON_AddStringToObject(rec, "op", op == JOURNAL_ADD ? "add" : op == JOURNAL_PUT ? "put" : "del");
+    cJSON_AddNumberToObject(rec, "ts", (double)app_clock_now());
+    if (op == JOURNAL_DELETE) {
+        cJSON_AddStringToObject(rec, "id", task->id);
+    } else {
+        cJSON *obj = task_to_cjson(task);
+        if (!obj) {
+            cJSON_Delete(rec);
+            return NULL;
+        }
+        cJSON_AddItemToObject(rec, "task", obj);
+    }
+    char *line = cJSON_PrintUnformatted(rec);
+    cJSON_Delete(rec);
+    return line;
+}
+
+// Helper: take or release the whole-file lock shared by appends and trims
+static int lock_file(FILE *f, short type) {
+    struct flock lock;
+    memset(&lock, 0, sizeof(lock));
+    lock.l_type = type;
+    lock.l_whence = SEEK_SET;
+    return fcntl(fileno(f), type == F_UNLCK ? F_SETLK : F_SETLKW, &lock);
+}
+
+// Helper: check whether an open handle still refers to the file at path
+static bool is_current(FILE *f, const char *path) {
+    struct stat open_st, path_st;
+    return fstat(fileno(f), &open_st) == 0 && stat(path, &path_st) == 0
+           && open_st.st_ino == path_st.st_ino && open_st.st_dev == path_st.st_dev;
+}
+
+// Helper: open the append handle if needed and lock it; a handle whose file
+// another process has since trimmed (replaced) is reopened
+static int lock_for_append(void) {
+    if (storage_init() != 0) return -1;
+    char *path = storage_path(JOURNAL_FILE);
+    if (!path) return -1;
+    for (;;) {
+        if (!journal_fp) {
+            journal_fp = utils_fopen(path, "a+");
+            known_size = -1;
+            if (!journal_fp) break;
+        }
+        if (lock_file(journal_fp, F_WRLCK) != 0) break;
+        if (is_current(journal_fp, path)) {
+            utils_free(path);
+            return 0;
+        }
+        fclose(journal_fp);
+        journal_fp = NULL;
+    }
+    utils_free(path);
+    return -1;
+}
+
+// Helper: write one record under the next sequence number; the caller holds
+// the lock and flushes
+static int write_record(JournalOp op, const Task *task) {
+    // End a line torn by a crash so it cannot swallow this record
+    char last = '\n';
+    if (known_size > 0 && pread(fileno(journal_fp), &last, 1, known_size - 1) != 1) last = '\n';
+    bool torn = last != '\n';
+
+    // Before the first record, keep the set it changes for history. Best
+    // effort: without it history falls back to a first checkpoint of the
+    // tasks no record mentions.
+    if (last_seq == 0) history_begin();
+
+    char *line = format_record(op, task, last_seq + 1);
+    if (!line) return -1;
+    // One record per line; a torn last line is skipped on replay
+    int rc = ((!torn || fputc('\n', journal_fp) != EOF) && fputs(line, journal_fp) >= 0
+              && fputc('\n', journal_fp) != EOF) ? 0 : -1;
+    if (rc == 0) {
+        last_seq++;
+        known_size += (long long)strlen(line) + 1 + (torn ? 1 : 0);
+    } else {
+        known_size = -1;
+    }
+    utils_free(line);
+    return rc;
+}
+
+// Helper: make written records durable and release the lock
+static int flush_and_unlock(int rc) {
+    if (rc == 0 && (fflush(journal_fp) != 0 || fsync(fileno(journal_fp)) != 0)) rc = -1;
+    if (rc != 0) known_size = -1;
+    lock_file(journal_fp, F_UNLCK);
+    return rc;
+}
+
+int journal_append(JournalOp op, const Task *task) {
+    if (!task || !task->id) return -1;
+
+    // Other processes may append too; the lock keeps sequence numbers unique
+    if (lock_for_append() != 0) return -1;
+    sync_last_seq(journal_fp);
+    return flush_and_unlock(write_record(op, task));
+}
+
+unsigned long long journal_last_seq(void) {
+    if (journal_fp) {
+        sync_last_seq(journal_fp);
+        return last_seq;
+    }
+    char *path = storage_path(JOURNAL_FILE);
+    FILE *f = path ? fopen(path, "r") : NULL;
+    utils_free(path);
+    if (!f) {
+        long long offset;
+        read_base(&last_seq, &offset);
+        known_size = -1;
+        return last_seq;
+    }
+    sync_last_seq(f);
+    fclose(f);
+    return last_seq;
+}
+
+bool journal_has_records(void) {
+    char *path = storage_path(JOURNAL_FILE);
+    if (!path) return false;
+    struct stat st;
+    bool exists = stat(path, &st) == 0;
+    utils_free(path);
+    if (!exists) return false;
+    unsigned long long seq;
+    long long offset;
+    read_base(&seq, &offset);
+    return (long long)st.st_size > offset;
+}
+
+int journal_scan_record(const char *line, JournalRecordInfo *info) {
+    memset(info, 0, sizeof(*info));
+    if (strncmp(line, RECORD_PREFIX, strlen(RECORD_PREFIX)) != 0) return -1;
+    info->seq = strtoull(line + strlen(RECORD_PREFIX), NULL, 10);
+    // seq, op and ts come first in a record, so the first "ts" and "id"
+    // keys are the record's and its task's
+    const char *ts = strstr(line, "\"ts\":");
+    if (ts) info->ts = (time_t)strtod(ts + 5, NULL);
+    const char *id = strstr(line, "\"id\":\"");
+    if (id) {
+        info->id = id + 6;
+        const char *end = strchr(info->id, '"');
+        info->id_len = end ? (size_t)(end - info->id) : 0;
+    }
+    return info->seq > 0 ? 0 : -1;
+}
+
+// Helper: index of the task with id, or count if absent
+static size_t find_by_id(Task **tasks, size_t count, const char *id) {
+    for (size_t i = 0; i < count; i++) {
+        if (tasks[i] && tasks[i]->id && strcmp(tasks[i]->id, id) == 0) return i;
+    }
+    return count;
+}
+
+int journal_apply_record(const cJSON *rec, Task ***tasks, size_t *count) {
+    const cJSON *op = cJSON_GetObjectItem(rec, "op");
+    if (!cJSON_IsString(op)) return 0;
+
+    if (strcmp(op->valuestring, "add") == 0 || strcmp(op->valuestring, "put") == 0) {
+        Task *t = task_from_cjson(cJSON_GetObjectItem(rec, "task"));
+        if (!t) return 0;
+        size_t i = find_by_id(*tasks, *count, t->id);
+        if (i < *count) {
+            task_free((*tasks)[i]);
+            (*tasks)[i] = t;
+            return 1;
+        }
+        Task **grown = utils_realloc(*tasks, (*count + 2) * sizeof(Task *));
+        if (!grown) {
+            task_free(t);
+            return -1;
+        }
+        *tasks = grown;
+        (*tasks)[(*count)++] = t;
+        (*tasks)[*count] = NULL;
+        return 1;
+    }
+
+    if (strcmp(op->valuestring, "del") == 0) {
+        const cJSON *id = cJSON_GetObjectItem(rec, "id");
+        if (!cJSON_IsString(id)) return 0;
+        size_t i = find_by_id(*tasks, *count, id->valuestring);
+        if (i == *count) return 0;
+        task_free((*tasks)[i]);
+        memmove(&(*tasks)[i], &(*tasks)[i + 1], (*count - i) * sizeof(Task *));
+        (*count)--;
+        return 1;
+    }
+    return 0;
+}
+
+int journal_replay(Task ***tasks, size_t *count) {
+    if (!tasks || !*tasks || !count) return -1;
+    char *path = storage_path(JOURNAL_FILE);
+    if (!path) return -1;
+    FILE *f = fopen(path, "r");
+    utils_free(path);
+    if (!f) return errno == ENOENT ? 0 : -1;
+
+    // Records up to the checkpoint are already in the snapshot. Replaying a
+    // few of them again (after a crash mid-checkpoint) is harmless: every
+    // record holds a task's whole state.
+    unsigned long long seq;
+    long long offset;
+    read_base(&seq, &offset);
+    if (fseek(f, offset, SEEK_SET) != 0) rewind(f);
+
+    int applied = 0;
+    char *line = NULL;
+    size_t cap = 0;
+    while (getline(&line, &cap, f) >= 0) {
+        cJSON *rec = cJSON_Parse(line);
+        if (!rec) continue;   // Torn or corrupt line
+        int rc = journal_apply_record(rec, tasks, count);
+        cJSON_Delete(rec);
+        if (rc < 0) {
+            applied = -1;
+            break;
+        }
+        applied += rc;
+    }
+    utils_free(line);
+    fclose(f);
+    return applied;
+}
+
+// Helper: read a whole open file; returns the buffer (NUL-terminated) or NULL
+static char *read_all(FILE *f, size_t *len) {
+    struct stat st;
+    char *buf = NULL;
+    if (fstat(fileno(f), &st) == 0 && (buf = utils_malloc((size_t)st.st_size + 1)) != NULL) {
+        rewind(f);
+        *len = fread(buf, 1, (size_t)st.st_size, f);
+        buf[*len] = '\0';
+    }
+    return buf;
+}
+
+// Helper: append records dropped from the journal to the archive and flush them
+static int archive_records(const char *text, size_t len) {
+    char *path = storage_path(JOURNAL_ARCHIVE_FILE);
+    FILE *f = path ? utils_fopen(path, "a") : NULL;
+    utils_free(path);
+    if (!f) return -1;
+    bool ok = fwrite(text, 1, len, f) == len && fflush(f) == 0 && fsync(fileno(f)) == 0;
+    return (fclose(f) == 0 && ok) ? 0 : -1;
+}
+
+// Helper: keep only the newest JOURNAL_KEEP_RECORDS records, moving the
+// older ones to the archive; sets *size to the new size
+static int trim_journal(const char *path, long long *size) {
+    // Hold the append lock so no record lands in the file being replaced
+    if (lock_for_append() != 0) return -1;
+    size_t len = 0;
+    char *buf = read_all(journal_fp, &len);
+    if (!buf) {
+        lock_file(journal_fp, F_UNLCK);
+        return -1;
+    }
+    // Walk back to the start of the JOURNAL_KEEP_RECORDS-th line from the end
+    size_t start = len, lines = 0;
+    while (start > 0) {
+        if (start < len && buf[start - 1] == '\n' && ++lines == JOURNAL_KEEP_RECORDS) break;
+        start--;
+    }
+
+    // Archived first: a reader holding the old journal open still sees every
+    // record, and one opening the new journal finds the rest in the archive
+    if (start > 0 && archive_records(buf, start) != 0) {
+        utils_free(buf);
+        lock_file(journal_fp, F_UNLCK);
+        return -1;
+    }
+
+    int rc = utils_write_file_atomic(path, buf + start, len - start);
+    utils_free(buf);
+    lock_file(journal_fp, F_UNLCK);
+    if (rc == 0) {
+        // The append handle points at the replaced file
+        fclose(journal_fp);
+        journal_fp = NULL;
+        known_size = -1;
+        *size = (long long)(len - start);
+    }
+    return rc;
+}
+
+int journal_checkpoint(void) {
+    char *path = storage_path(JOURNAL_FILE);
+    if (!path) return -1;
+    unsigned long long seq = journal_last_seq();
+    struct stat st;
+    long long size = stat(path, &st) == 0 ? (long long)st.st_size : 0;
+    int rc = 0;
+    if (size > JOURNAL_TRIM_BYTES) rc = trim_journal(path, &size);
+    utils_free(path);
+    return rc == 0 ? write_base(seq, size) : -1;
+}
+
+// One journal line, indexed without parsing it
+typedef struct {
+    const char *text;
+    unsigned long long seq;
+    const char *id;             // Start of the id, inside text
+    size_t id_len;
+} LineRef;
+
+// Helper: the sequence number and task id of a line (both 0/NULL if absent)
+static void index_line(LineRef *ref) {
+    JournalRecordInfo info;
+    journal_scan_record(ref->text, &info);
+    ref->seq = info.seq;
+    ref->id = info.id;
+    ref->id_len = info.id_len;
+}
+
+// Helper: compare two JSON values by their serialized form
+static bool same_value(const cJSON *a, const cJSON *b) {
+    char *ta = cJSON_PrintUnformatted(a);
+    char *tb = cJSON_PrintUnformatted(b);
+    bool same = ta && tb && strcmp(ta, tb) == 0;
+    utils_free(ta);
+    utils_free(tb);
+    return same;
+}
+
+// Helper: names of the fields that differ between two task objects
+static cJSON *changed_fields(const cJSON *before, const cJSON *after) {
+    cJSON *names = cJSON_CreateArray();
+    const cJSON *field;
+    cJSON_ArrayForEach(field, after) {
+        const cJSON *old = cJSON_GetObjectItemCaseSensitive(before, field->string);
+        if (!old || !same_value(old, field)) cJSON_AddItemToArray(names, cJSON_CreateString(field->string));
+    }
+    cJSON_ArrayForEach(field, before) {
+        if (!cJSON_GetObjectItemCaseSensitive(after, field->string)) {
+            cJSON_AddItemToArray(names, cJSON_CreateString(field->string));
+        }
+    }
+    return names;
+}
+
+// Helper: turn a record into a feed event; prev is the id's previous record or NULL
+static cJSON *make_event(const LineRef *ref, const LineRef *prev) {
+    cJSON *rec = cJSON_Parse(ref->text);
+    const cJSON *op = cJSON_GetObjectItem(rec, "op");
+    if (!cJSON_IsString(op)) {
+        cJSON_Delete(rec);
+        return NULL;
+    }
+    cJSON *event = cJSON_CreateObject();
+    if (!event) {
+        cJSON_Delete(rec);
+        return NULL;
+    }
+    const char *type = strcmp(op->valuestring, "add") == 0 ? "add"
+                     : strcmp(op->valuestring, "del") == 0 ? "delete" : "update";
+    cJSON_AddNumberToObject(event, "seq", (double)ref->seq);
+    cJSON_AddItemToObject(event, "ts", cJSON_Duplicate(cJSON_GetObjectItem(rec, "ts"), true));
+    cJSON_AddStringToObject(event, "type", type);
+
+    cJSON *task = cJSON_DetachItemFromObject(rec, "task");
+    const cJSON *id = task ? cJSON_GetObjectItem(task, "id") : cJSON_GetObjectItem(rec, "id");
+    cJSON_AddStringToObject(event, "id", cJSON_IsString(id) ? id->valuestring : "");
+    if (task && prev && strcmp(type, "update") == 0) {
+        cJSON *prev_rec = cJSON_Parse(prev->text);
+        const cJSON *before = cJSON_GetObjectItem(prev_rec, "task");
+        if (before) cJSON_AddItemToObject(event, "changed", changed_fields(before, task));
+        cJSON_Delete(prev_rec);
+    }
+    if (task) cJSON_AddItemToObject(event, "task", task);
+    cJSON_Delete(rec);
+    return event;
+}
+
+cJSON *journal_changes(unsigned long long since, size_t limit, unsigned long long *next, bool *gap) {
+    if (limit == 0) limit = JOURNAL_CHANGES_LIMIT;
+    *gap = false;
+    *next = since;
+    cJSON *events = cJSON_CreateArray();
+    if (!events) return NULL;
+
+    unsigned long long newest = journal_last_seq();
+    if (since >= newest) {
+        // Nothing new, or the journal was reset under the reader
+        if (since > newest) {
+            *gap = true;
+            *next = newest;
+        }
+        return events;
+    }
+
+    char *path = storage_path(JOURNAL_FILE);
+    size_t len = 0;
+    FILE *f = path ? fopen(path, "r") : NULL;
+    char *buf = f ? read_all(f, &len) : NULL;
+    if (f) fclose(f);
+    utils_free(path);
+    size_t line_count = 0;
+    for (size_t i = 0; buf && i < len; i++) line_count += buf[i] == '\n';
+    LineRef *lines = buf ? utils_calloc(line_count + 1, sizeof(LineRef)) : NULL;
+    size_t slots = 16;
+    while (slots < 2 * (line_count + 1)) slots *= 2;
+    size_t *latest = lines ? utils_malloc(slots * sizeof(size_t)) : NULL;   // Open addressing: id -> line + 1
+    if (!latest) {
+        utils_free(lines);
+        utils_free(buf);
+        *gap = true;
+        *next = newest;
+        return events;
+    }
+    memset(latest, 0, slots * sizeof(size_t));
+
+    // Split into complete lines; a torn last line has no newline and is left out
+    size_t n = 0;
+    for (char *p = buf, *nl; (nl = memchr(p, '\n', len - (size_t)(p - buf))) != NULL; p = nl + 1) {
+        *nl = '\0';
+        lines[n].text = p;
+        index_line(&lines[n]);
+        if (lines[n].seq > 0) n++;
+    }
+
+    if (n == 0 || lines[0].seq > since + 1) {
+        *gap = true;
+        *next = newest;
+    } else {
+        // Walk forward, remembering each id's latest line to diff against
+        size_t emitted = 0;
+        for (size_t i = 0; i < n && emitted < limit; i++) {
+            LineRef *ref = &lines[i];
+            size_t slot = ref->id ? utils_fnv1a(UTILS_FNV1A_INIT, ref->id, ref->id_len) & (slots - 1) : 0;
+            while (ref->id && latest[slot]) {
+                const LineRef *other = &lines[latest[slot] - 1];
+                if (other->id_len == ref->id_len && memcmp(other->id, ref->id, ref->id_len) == 0) break;
+                slot = (slot + 1) & (slots - 1);
+            }
+            if (ref->seq > since) {
+                const LineRef *prev = (ref->id && latest[slot]) ? &lines[latest[slot] - 1] : NULL;
+                cJSON *event = make_event(ref, prev);
+                if (event) {
+                    cJSON_AddItemToArray(events, event);
+                    emitted++;
+                }
+                *next = ref->seq;
+            }
+            if (ref->id) latest[slot] = i + 1;
+        }
+    }
+    utils_free(latest);
+    utils_free(lines);
+    utils_free(buf);
+    return events;
+}
+
+// Helper: index slot holding the print of id, or the empty slot where it would go
+static size_t find_print(const JournalPrints *prints, const char *id) {
+    size_t mask = prints->slot_cap - 1;
+    size_t i = (size_t)utils_fnv1a_str(id) & mask;
+    while (prints->slots[i] && strcmp(prints->items[prints->slots[i] - 1].id, id) != 0) {
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+// Helper: the print of id, or NULL if there is none
+static JournalPrint *lookup_print(const JournalPrints *prints, const char *id) {
+    if (!prints->slot_cap) return NULL;
+    size_t index = prints->slots[find_print(prints, id)];
+    return index ? &prints->items[index - 1] : NULL;
+}
+
+// Helper: fold a string, or its absence, into a hash; the terminator keeps
+// adjacent fields apart
+static uint64_t hash_string(uint64_t h, const char *s) {
+    unsigned char present = s != NULL;
+    h = utils_fnv1a(h, &present, 1);
+    return s ? utils_fnv1a(h, s, strlen(s) + 1) : h;
+}
+
+// Helper: fold a number into a hash
+static uint64_t hash_number(uint64_t h, long long v) {
+    return utils_fnv1a(h, &v, sizeof(v));
+}
+
+// Helper: content hash of a task as it would be written. Folds in the fields
+// task_to_cjson() writes, normalized the same way, without building the JSON.
+static unsigned long long hash_task(const Task *task) {
+    uint64_t h = hash_string(UTILS_FNV1A_INIT, task->id);
+    h = hash_string(h, task->name);
+    h = hash_number(h, (long long)task->created);
+    if (task->due > 0) {
+        h = hash_number(h, (long long)task->due);
+        h = hash_number(h, task->due_kind);
+        if (task->due_kind == DUE_DATETIME) h = hash_number(h, task->due_tz);
+    } else {
+        h = hash_number(h, 0);
+    }
+    h = hash_number(h, (long long)task->tag_count);
+    for (size_t i = 0; i < task->tag_count; i++) h = hash_string(h, task->tags[i]);
+    h = hash_number(h, task->priority);
+    h = hash_number(h, task->status);
+    h = hash_string(h, task->project ? task->project : "default");
+    h = hash_string(h, task->note);
+    h = hash_string(h, task->recur);
+    return h;
+}
+
+int journal_prints_build(Task **tasks, size_t count, JournalPrints *prints) {
+    // The blocks are kept from the last build when they are big enough: a
+    // large block allocated or freed right after a load makes malloc sweep
+    // every small chunk the load has just freed
+    size_t id_bytes = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (tasks[i] && tasks[i]->id) id_bytes += strlen(tasks[i]->id) + 1;
+    }
+    size_t slot_cap = 16;
+    while (slot_cap < 2 * count + 2) slot_cap *= 2;
+    prints->count = 0;
+    if (count + 1 > prints->items_cap) {
+        utils_free(prints->items);
+        prints->items = utils_malloc((count + 1) * sizeof(JournalPrint));
+        prints->items_cap = prints->items ? count + 1 : 0;
+    }
+    if (id_bytes + 1 > prints->ids_cap) {
+        utils_free(prints->ids);
+        prints->ids = utils_malloc(id_bytes + 1);
+        prints->ids_cap = prints->ids ? id_bytes + 1 : 0;
+    }
+    if (slot_cap > prints->slot_cap) {
+        utils_free(prints->slots);
+        prints->slots = utils_malloc(slot_cap * sizeof(size_t));
+        prints->slot_cap = prints->slots ? slot_cap : 0;
+    }
+    if (!prints->items || !prints->ids || !prints->slots) {
+        journal_prints_free(prints);
+        return -1;
+    }
+    memset(prints->slots, 0, prints->slot_cap * sizeof(size_t));
+
+    // All ids go in one block; a duplicate id keeps its first print, so it
+    // never reads as a delete
+    char *next = prints->ids;
+    for (size_t i = 0; i < count; i++) {
+        if (!tasks[i] || !tasks[i]->id) continue;
+        size_t slot = find_print(prints, tasks[i]->id);
+        if (prints->slots[slot]) continue;
+        JournalPrint *p = &prints->items[prints->count++];
+        size_t len = strlen(tasks[i]->id) + 1;
+        p->id = memcpy(next, tasks[i]->id, len);
+        p->hash = hash_task(tasks[i]);
+        p->seen = false;
+        next += len;
+        prints->slots[slot] = prints->count;
+    }
+    return 0;
+}
+
+void journal_prints_free(JournalPrints *prints) {
+    utils_free(prints->items);
+    utils_free(prints->ids);
+    utils_free(prints->slots);
+    memset(prints, 0, sizeof(*prints));
+}
+
+int journal_prints_diff(JournalPrints *before, Task **tasks, size_t count, JournalDiffFn fn, void *user) {
+    for (size_t i = 0; i < before->count; i++) before->items[i].seen = false;
+    for (size_t i = 0; i < count; i++) {
+        const Task *t = tasks[i];
+        if (!t || !t->id) continue;
+        unsigned long long hash = hash_task(t);
+        JournalPrint *p = lookup_print(before, t->id);
+        if (p && p->seen) continue;   // Duplicate id; the first copy wins on load as well
+        if (p) p->seen = true;
+        if (p && p->hash == hash) continue;
+        if (fn(p ? JOURNAL_PUT : JOURNAL_ADD, t, user) != 0) return -1;
+    }
+    for (size_t i = 0; i < before->count; i++) {
+        if (before->items[i].seen) continue;
+        Task gone = {0};
+        gone.id = before->items[i].id;
+        if (fn(JOURNAL_DELETE, &gone, user) != 0) return -1;
+    }
+    return 0;
+}
+
+// Helper: journal_prints_diff() callback; write one record and count it
+static int append_change(JournalOp op, const Task *task, void *user) {
+    if (write_record(op, task) != 0) return -1;
+    (*(int *)user)++;
+    return 0;
+}
+
+int journal_append_diff(JournalPrints *before, Task **tasks, size_t count) {
+    // One lock and one fsync for the whole diff
+    if (lock_for_append() != 0) return -1;
+    sync_last_seq(journal_fp);
+    int appended = 0;
+    int rc = journal_prints_diff(before, tasks, count, append_change, &appended);
+    return flush_and_unlock(rc) == 0 ? appended : -1;
+}
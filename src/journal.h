@@ -0,0 +1,185 @@
+#ifndef TODO_APP_JOURNAL_H
+#define TODO_APP_JOURNAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "task.h"
+
+struct cJSON;
+
+/**
+ * Mutation journal: an append-only JSON Lines log (~/.todo-app/journal.jsonl)
+ * of task changes. Each line is
+ *   {"seq":N,"op":"add"|"put","ts":<epoch>,"task":{...}} or
+ *   {"seq":N,"op":"del","ts":<epoch>,"id":"..."}
+ * with seq increasing by one per record. journal.base holds the last seq and
+ * the byte offset the tasks.json snapshot covers; loading replays only the
+ * records after it. Older records are kept (up to a bound) as the change feed;
+ * records trimmed past that bound move to journal.archive.jsonl, so the whole
+ * history stays readable (history.h).
+ */
+
+#define JOURNAL_FILE "journal.jsonl"
+#define JOURNAL_BASE_FILE "journal.base"
+#define JOURNAL_ARCHIVE_FILE "journal.archive.jsonl"
+
+// A checkpoint trims the journal once it is this large...
+#define JOURNAL_TRIM_BYTES (4L * 1024 * 1024)
+// ...down to this many most recent records
+#define JOURNAL_KEEP_RECORDS 5000
+
+// Most events journal_changes() returns by default
+#define JOURNAL_CHANGES_LIMIT 1000
+
+typedef enum {
+    JOURNAL_ADD,      // Task created; the record holds the whole task
+    JOURNAL_PUT,      // Task changed; the record holds the whole task
+    JOURNAL_DELETE    // Task removed
+} JournalOp;
+
+// What a record line says about itself, read without parsing the JSON
+typedef struct {
+    unsigned long long seq;
+    time_t ts;
+    const char *id;       // Start of the task id, inside the line (NULL if absent)
+    size_t id_len;
+} JournalRecordInfo;
+
+// Fingerprint (id and content hash) of one task as last written
+typedef struct {
+    char *id;                   // Inside the set's ids block
+    unsigned long long hash;
+    bool seen;
+} JournalPrint;
+
+// Fingerprints of a whole task set, one per id, with an index by id
+typedef struct {
+    JournalPrint *items;
+    size_t count;
+    char *ids;                  // The ids, one after another
+    size_t *slots;              // Open addressing; item index + 1, 0 if empty
+    size_t items_cap;
+    size_t ids_cap;
+    size_t slot_cap;            // Power of two
+} JournalPrints;
+
+/**
+ * Append one record under the next sequence number and flush it to disk
+ * before returning. Safe against other processes appending at the same time.
+ * @param op Kind of change
+ * @param task The changed task (for JOURNAL_DELETE only its id is used)
+ * @return 0 on success, -1 on error
+ */
+int journal_append(JournalOp op, const Task *task);
+
+/**
+ * Get the sequence number of the newest record.
+ * @return Sequence number, or 0 if nothing was ever journaled
+ */
+unsigned long long journal_last_seq(void);
+
+/**
+ * Check whether the journal holds records not yet in the snapshot.
+ * @return true if records follow the snapshot's checkpoint
+ */
+bool journal_has_records(void);
+
+/**
+ * Apply the records newer than the snapshot to a task array, in order.
+ * @param tasks Pointer to a NULL-terminated task array (may be reallocated)
+ * @param count Pointer to the task count
+ * @return Number of records applied, or -1 on error
+ */
+int journal_replay(Task ***tasks, size_t *count);
+
+/**
+ * Read the sequence number, time and task id of one record line.
+ * @param line Record line (NUL-terminated, without the newline)
+ * @param info[out] What the line holds
+ * @return 0 if the line is a record, -1 otherwise
+ */
+int journal_scan_record(const char *line, JournalRecordInfo *info);
+
+/**
+ * Apply one parsed record to a task array.
+ * @param rec Record object
+ * @param tasks Pointer to a NULL-terminated task array (may be reallocated)
+ * @param count Pointer to the task count
+ * @return 1 if applied, 0 if skipped (malformed, or deletes a missing task), -1 on error
+ */
+int journal_apply_record(const struct cJSON *rec, Task ***tasks, size_t *count);
+
+/**
+ * Mark every record as covered by the snapshot just written, and move old
+ * records to the archive once the journal passes JOURNAL_TRIM_BYTES.
+ * @return 0 on success, -1 on error
+ */
+int journal_checkpoint(void);
+
+/**
+ * Read the change feed after a sequence number. Each event is
+ *   {"seq":N,"ts":T,"type":"add"|"update"|"delete","id":"...",
+ *    "changed":["name",...],"task":{...}}
+ * where "changed" lists the fields that differ from the task's previous
+ * record (omitted when that record is no longer kept) and "task" is absent
+ * for deletes.
+ * @param since Return events with a greater sequence number
+ * @param limit Most events to return (0 for JOURNAL_CHANGES_LIMIT)
+ * @param next[out] Sequence number to resume from
+ * @param gap[out] true if events after since were trimmed away; the reader
+ *        should reload every task, then resume from *next
+ * @return Newly allocated JSON array (caller deletes), or NULL on error
+ */
+struct cJSON *journal_changes(unsigned long long since, size_t limit,
+                              unsigned long long *next, bool *gap);
+
+/**
+ * Fingerprint a task set, to find later what a full save changed.
+ * @param tasks Tasks
+ * @param count Number of tasks
+ * @param prints[in,out] Fingerprints, zeroed or from an earlier build whose
+ *        memory is reused (free with journal_prints_free())
+ * @return 0 on success, -1 on error
+ */
+int journal_prints_build(Task **tasks, size_t count, JournalPrints *prints);
+
+/**
+ * Free fingerprints and reset them to empty.
+ * @param prints Fingerprints
+ */
+void journal_prints_free(JournalPrints *prints);
+
+/**
+ * Called by journal_prints_diff() once per difference.
+ * @param op JOURNAL_ADD or JOURNAL_PUT with the current task, or
+ *        JOURNAL_DELETE with a task that has only its id set
+ * @param task The task
+ * @param user User pointer given to journal_prints_diff()
+ * @return 0 to go on, -1 to stop with an error
+ */
+typedef int (*JournalDiffFn)(JournalOp op, const Task *task, void *user);
+
+/**
+ * Walk the difference between fingerprinted and current tasks: an add for
+ * each new id, a put for each changed task and a delete for each missing id.
+ * @param before Fingerprints of the previous state
+ * @param tasks Current tasks
+ * @param count Number of current tasks
+ * @param fn Called for each difference
+ * @param user Passed to fn
+ * @return 0 on success, -1 on error or if fn failed
+ */
+int journal_prints_diff(JournalPrints *before, Task **tasks, size_t count, JournalDiffFn fn, void *user);
+
+/**
+ * Journal the difference between fingerprinted and current tasks: an add for
+ * each new id, a put for each changed task and a delete for each missing id,
+ * written under one lock and flushed to disk once.
+ * @param before Fingerprints of the previous state
+ * @param tasks Current tasks
+ * @param count Number of current tasks
+ * @return Number of records appended, or -1 on error
+ */
+int journal_append_diff(JournalPrints *before, Task **tasks, size_t count);
+
+#endif // TODO_APP_JOURNAL_H
@@ -1,10 +1,19 @@
+// strdup() is POSIX, not ISO C
+#define _POSIX_C_SOURCE 200809L
+
 #include "llm_api.h"
+#include "llm_usage.h"
+#include "trace.h"
+#include "utils.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <curl/curl.h>
 #include <cjson/cJSON.h>
 
+// API path requests go to; usage is recorded under it
+#define LLM_ENDPOINT "chat/completions"
+
 /**
  * Structure to hold the memory chunk for curl write callback.
  */
@@ -26,7 +35,7 @@ struct curl_mem {
 static size_t write_cb(void *contents, size_t size, size_t nmemb, void *userp) {
     size_t realsize = size * nmemb;
     struct curl_mem *mem = (struct curl_mem *)userp;
-    char *ptr = realloc(mem->ptr, mem->len + realsize + 1);
+    char *ptr = utils_realloc(mem->ptr, mem->len + realsize + 1);
     if (!ptr) return 0;
     mem->ptr = ptr;
     memcpy(&(mem->ptr[mem->len]), contents, realsize);
@@ -36,41 +45,55 @@ static size_t write_cb(void *contents, size_t size, size_t nmemb, void *userp) {
 }
 
 /**
- * Send a chat completion request to the OpenAI API.
- * 
+ * Record the latency and token counts of a finished call (llm_usage.h).
+ *
+ * @param curl The handle that made the call.
+ * @param model The model asked for.
+ * @param resp The parsed response, or NULL if the call failed.
+ */
+static void record_call(CURL *curl, const char *model, const LlmChatResponse *resp) {
+    curl_off_t connect = 0, tls = 0, ttfb = 0, total = 0;
+    curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &connect);
+    curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME_T, &tls);
+    curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME_T, &ttfb);
+    curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &total);
+    LlmCall call = {
+        .model = model,
+        .endpoint = LLM_ENDPOINT,
+        .ok = resp && resp->http_status >= 200 && resp->http_status < 300,
+    };
+    call.values[LLM_METRIC_CONNECT] = (uint64_t)(tls > 0 ? tls : connect);
+    call.values[LLM_METRIC_TTFB] = (uint64_t)ttfb;
+    call.values[LLM_METRIC_TOTAL] = (uint64_t)total;
+    if (resp) {
+        call.values[LLM_METRIC_PROMPT_TOKENS] = resp->usage.prompt_tokens > 0 ? (uint64_t)resp->usage.prompt_tokens : 0;
+        call.values[LLM_METRIC_COMPLETION_TOKENS] = resp->usage.completion_tokens > 0 ? (uint64_t)resp->usage.completion_tokens : 0;
+    }
+    llm_usage_record(&call);
+}
+
+// Replaces the HTTP exchange while set (llm_set_transport())
+static LlmTransport transport_fn = NULL;
+static void *transport_ctx = NULL;
+
+void llm_set_transport(LlmTransport transport, void *ctx) {
+    transport_fn = transport;
+    transport_ctx = transport ? ctx : NULL;
+}
+
+/**
+ * Compose the JSON body of a chat completion request.
+ *
  * @param system_prompt The system prompt.
  * @param user_prompt The user prompt.
- * @param response_obj The response from the API.
- * @param debug Whether to print debug messages.
- * @param model The model to use (optional, defaults to gpt-4.1-mini).
- * 
- * @return 0 on success, non-zero on failure.
+ * @param model The model to use.
+ *
+ * @return The body (caller frees), or NULL on error.
  */
-int llm_chat(const char *system_prompt, const char *user_prompt, LlmChatResponse **response_obj, int debug, const char *model) {
-    const char *api_key = getenv("OPENAI_API_KEY");
-    if (!api_key) {
-        if (debug) fprintf(stderr, "OPENAI_API_KEY not set\n");
-        return 1;
-    }
-    CURL *curl = curl_easy_init();
-    if (!curl) return 2;
-    struct curl_mem chunk = {malloc(1), 0};
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(headers, "Content-Type: application/json");
-    char auth[256];
-    snprintf(auth, sizeof(auth), "Authorization: Bearer %s", api_key);
-    headers = curl_slist_append(headers, auth);
-    curl_easy_setopt(curl, CURLOPT_URL, "https://api.openai.com/v1/chat/completions");
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_cb);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&chunk);
-    // Compose JSON body with system and user prompt using cJSON
+static char *build_request(const char *system_prompt, const char *user_prompt, const char *model) {
     cJSON *root = cJSON_CreateObject();
-    
-    // Use the provided model or default to gpt-4.1-mini
-    const char *model_to_use = model ? model : "gpt-4.1-mini";
-    cJSON_AddStringToObject(root, "model", model_to_use);
-    
+    cJSON_AddStringToObject(root, "model", model);
+
     cJSON *msgs = cJSON_CreateArray();
     cJSON *sys_msg = cJSON_CreateObject();
     cJSON_AddStringToObject(sys_msg, "role", "system");
@@ -83,32 +106,25 @@ int llm_chat(const char *system_prompt, const char *user_prompt, LlmChatResponse
     cJSON_AddItemToObject(root, "messages", msgs);
     cJSON_AddNumberToObject(root, "temperature", 0.0);
     char *json_body = cJSON_PrintUnformatted(root);
-    if (debug) fprintf(stderr, "[llm_chat] Request JSON: %s\n", json_body);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, json_body);
-    CURLcode res = curl_easy_perform(curl);
-    long http_code = 0;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
-    if (debug) fprintf(stderr, "[llm_chat] HTTP status: %ld\n", http_code);
-    if (res != CURLE_OK) {
-        if (debug) fprintf(stderr, "curl failed: %s\n", curl_easy_strerror(res));
-        curl_easy_cleanup(curl);
-        curl_slist_free_all(headers);
-        free(chunk.ptr);
-        cJSON_Delete(root);
-        free(json_body);
-        return 3;
-    }
-    if (debug) fprintf(stderr, "[llm_chat] Raw response: %s\n", chunk.ptr);
-    // clean up request object
     cJSON_Delete(root);
-    // parse JSON and build structured response
-    cJSON *json = cJSON_Parse(chunk.ptr);
+    return json_body;
+}
+
+/**
+ * Build the structured response from a response body.
+ *
+ * @param body The body; kept as raw_json on success, freed otherwise.
+ * @param http_code The HTTP status the body came with.
+ *
+ * @return The response, or NULL if the body is not JSON.
+ */
+static LlmChatResponse *parse_response(char *body, long http_code) {
+    trace_begin("llm_parse");
+    cJSON *json = cJSON_Parse(body);
     if (!json) {
-        free(chunk.ptr);
-        curl_easy_cleanup(curl);
-        curl_slist_free_all(headers);
-        free(json_body);
-        return 4;
+        trace_end("llm_parse");
+        utils_free(body);
+        return NULL;
     }
     LlmChatResponse *resp = calloc(1, sizeof(*resp));
     resp->http_status = http_code;
@@ -141,11 +157,92 @@ int llm_chat(const char *system_prompt, const char *user_prompt, LlmChatResponse
         item = cJSON_GetObjectItem(usage, "completion_tokens"); if (cJSON_IsNumber(item)) resp->usage.completion_tokens = item->valueint;
         item = cJSON_GetObjectItem(usage, "total_tokens"); if (cJSON_IsNumber(item)) resp->usage.total_tokens = item->valueint;
     }
-    resp->raw_json = chunk.ptr;
+    resp->raw_json = body;
     cJSON_Delete(json);
+    trace_end("llm_parse");
+    return resp;
+}
+
+/**
+ * Send a chat completion request to the OpenAI API.
+ * 
+ * @param system_prompt The system prompt.
+ * @param user_prompt The user prompt.
+ * @param response_obj The response from the API.
+ * @param debug Whether to print debug messages.
+ * @param model The model to use (optional, defaults to gpt-4.1-mini).
+ * 
+ * @return 0 on success, non-zero on failure.
+ */
+int llm_chat(const char *system_prompt, const char *user_prompt, LlmChatResponse **response_obj, int debug, const char *model) {
+    const char *api_key = getenv("OPENAI_API_KEY");
+    if (!api_key && !transport_fn) {
+        if (debug) fprintf(stderr, "OPENAI_API_KEY not set\n");
+        return 1;
+    }
+    // Use the provided model or default to gpt-4.1-mini
+    const char *model_to_use = model ? model : "gpt-4.1-mini";
+    char *json_body = build_request(system_prompt, user_prompt, model_to_use);
+    if (!json_body) return 2;
+    if (debug) fprintf(stderr, "[llm_chat] Request JSON: %s\n", json_body);
+
+    // A replaced transport is not a call to the API; its usage is not recorded
+    if (transport_fn) {
+        char *body = NULL;
+        long http_code = 0;
+        trace_begin("llm_request");
+        int rc = transport_fn(json_body, &body, &http_code, transport_ctx);
+        trace_end("llm_request");
+        utils_free(json_body);
+        if (rc != 0 || !body) {
+            utils_free(body);
+            return 3;
+        }
+        LlmChatResponse *resp = parse_response(body, http_code);
+        if (!resp) return 4;
+        *response_obj = resp;
+        return 0;
+    }
+
+    CURL *curl = curl_easy_init();
+    if (!curl) {
+        utils_free(json_body);
+        return 2;
+    }
+    struct curl_mem chunk = {malloc(1), 0};
+    struct curl_slist *headers = NULL;
+    headers = curl_slist_append(headers, "Content-Type: application/json");
+    char auth[256];
+    snprintf(auth, sizeof(auth), "Authorization: Bearer %s", api_key);
+    headers = curl_slist_append(headers, auth);
+    curl_easy_setopt(curl, CURLOPT_URL, "https://api.openai.com/v1/" LLM_ENDPOINT);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_cb);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&chunk);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, json_body);
+    trace_begin("llm_request");
+    CURLcode res = curl_easy_perform(curl);
+    trace_end("llm_request");
+    long http_code = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+    if (debug) fprintf(stderr, "[llm_chat] HTTP status: %ld\n", http_code);
+    if (res != CURLE_OK) {
+        if (debug) fprintf(stderr, "curl failed: %s\n", curl_easy_strerror(res));
+        record_call(curl, model_to_use, NULL);
+        curl_easy_cleanup(curl);
+        curl_slist_free_all(headers);
+        utils_free(chunk.ptr);
+        utils_free(json_body);
+        return 3;
+    }
+    if (debug) fprintf(stderr, "[llm_chat] Raw response: %s\n", chunk.ptr);
+    // parse JSON and build structured response
+    LlmChatResponse *resp = parse_response(chunk.ptr, http_code);
+    record_call(curl, model_to_use, resp);
     curl_easy_cleanup(curl);
     curl_slist_free_all(headers);
-    free(json_body);
+    utils_free(json_body);
+    if (!resp) return 4;
     *response_obj = resp;
     return 0;
 }
@@ -154,14 +251,14 @@ int llm_chat(const char *system_prompt, const char *user_prompt, LlmChatResponse
 void llm_chat_response_free(LlmChatResponse *resp) {
     if (!resp) return;
     for (size_t i = 0; i < resp->n_choices; ++i) {
-        free(resp->choices[i].message.role);
-        free(resp->choices[i].message.content);
-        free(resp->choices[i].finish_reason);
+        utils_free(resp->choices[i].message.role);
+        utils_free(resp->choices[i].message.content);
+        utils_free(resp->choices[i].finish_reason);
     }
-    free(resp->choices);
-    free(resp->id);
-    free(resp->object);
-    free(resp->model);
-    free(resp->raw_json);
-    free(resp);
+    utils_free(resp->choices);
+    utils_free(resp->id);
+    utils_free(resp->object);
+    utils_free(resp->model);
+    utils_free(resp->raw_json);
+    utils_free(resp);
 }
@@ -44,4 +44,14 @@ void llm_chat_response_free(LlmChatResponse *resp);
 // Chat with the LLM and get a structured response
 int llm_chat(const char *system_prompt, const char *user_prompt, LlmChatResponse **response_obj, int debug, const char *model);
 
+// An HTTP exchange in place of the API, for replaying recorded sessions.
+// Given the request body llm_chat() would send, it sets *response_body to
+// a malloc'd response body and *http_status to its status, and returns 0;
+// nonzero fails the call as a network error would.
+typedef int (*LlmTransport)(const char *request_json, char **response_body, long *http_status, void *ctx);
+
+// Send requests through transport instead of the API (NULL: the API again).
+// No API key is needed while it is set, and no usage is recorded.
+void llm_set_transport(LlmTransport transport, void *ctx);
+
 #endif // LLM_API_H
@@ -0,0 +1,456 @@
+// fcntl() locks and fileno() are POSIX, not ISO C
+#define _POSIX_C_SOURCE 200809L
+
+#include "llm_usage.h"
+#include "stats.h"
+#include "storage.h"
+#include "utils.h"
+#include "app_clock.h"
+#include <cjson/cJSON.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define LLM_USAGE_LOCK_FILE "llm_usage.lock"
+
+// Keys of the metrics in llm_usage.json and the JSON report
+static const char *const METRIC_KEYS[LLM_METRIC_COUNT] = {
+    "connect_us", "ttfb_us", "total_us", "prompt_tokens", "completion_tokens"
+};
+
+// Keys of the metrics in the JSON report, where latencies are in ms
+static const char *const REPORT_KEYS[LLM_METRIC_COUNT] = {
+    "connect_ms", "ttfb_ms", "total_ms", "prompt_tokens", "completion_tokens"
+};
+
+// Labels of the latency metrics in the text report
+static const char *const LATENCY_LABELS[] = {"connect", "ttfb", "total"};
+
+size_t llm_hist_bucket(uint64_t value) {
+    if (value < LLM_HIST_SUB_COUNT) return (size_t)value;
+    int bits = 63;
+    while (!(value >> bits)) bits--;
+    if (bits >= LLM_HIST_MAX_BITS) return LLM_HIST_BUCKETS - 1;
+    int shift = bits - LLM_HIST_SUB_BITS;
+    size_t sub = (size_t)(value >> shift) - LLM_HIST_SUB_COUNT;
+    return LLM_HIST_SUB_COUNT * (size_t)(shift + 1) + sub;
+}
+
+uint64_t llm_hist_bucket_high(size_t bucket) {
+    if (bucket < LLM_HIST_SUB_COUNT) return bucket;
+    int shift = (int)(bucket / LLM_HIST_SUB_COUNT) - 1;
+    uint64_t sub = bucket % LLM_HIST_SUB_COUNT;
+    return ((LLM_HIST_SUB_COUNT + sub + 1) << shift) - 1;
+}
+
+void llm_hist_record(LlmHist *h, uint64_t value) {
+    h->counts[llm_hist_bucket(value)]++;
+    h->count++;
+    h->sum += value;
+    if (value > h->max) h->max = value;
+}
+
+void llm_hist_merge(LlmHist *into, const LlmHist *from) {
+    for (size_t i = 0; i < LLM_HIST_BUCKETS; i++) into->counts[i] += from->counts[i];
+    into->count += from->count;
+    into->sum += from->sum;
+    if (from->max > into->max) into->max = from->max;
+}
+
+uint64_t llm_hist_percentile(const LlmHist *h, double percentile) {
+    if (h->count == 0) return 0;
+    uint64_t rank = (uint64_t)(percentile / 100.0 * (double)h->count + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > h->count) rank = h->count;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < LLM_HIST_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen >= rank) {
+            uint64_t high = llm_hist_bucket_high(i);
+            return high < h->max ? high : h->max;
+        }
+    }
+    return h->max;
+}
+
+// Helper: a histogram as [count, sum, max, bucket, count, bucket, count, ...]
+static cJSON *hist_to_cjson(const LlmHist *h) {
+    cJSON *arr = cJSON_CreateArray();
+    if (!arr) return NULL;
+    cJSON_AddItemToArray(arr, cJSON_CreateNumber((double)h->count));
+    cJSON_AddItemToArray(arr, cJSON_CreateNumber((double)h->sum));
+    cJSON_AddItemToArray(arr, cJSON_CreateNumber((double)h->max));
+    for (size_t i = 0; i < LLM_HIST_BUCKETS; i++) {
+        if (!h->counts[i]) continue;
+        cJSON_AddItemToArray(arr, cJSON_CreateNumber((double)i));
+        cJSON_AddItemToArray(arr, cJSON_CreateNumber((double)h->counts[i]));
+    }
+    return arr;
+}
+
+// Helper: add a histogram in the form above to h; malformed entries are skipped
+static void hist_add_cjson(LlmHist *h, const cJSON *arr) {
+    int n = cJSON_GetArraySize(arr);
+    if (!cJSON_IsArray(arr) || n < 3) return;
+    LlmHist from;
+    memset(&from, 0, sizeof(from));
+    from.sum = (uint64_t)cJSON_GetNumberValue(cJSON_GetArrayItem(arr, 1));
+    from.max = (uint64_t)cJSON_GetNumberValue(cJSON_GetArrayItem(arr, 2));
+    const cJSON *item = cJSON_GetArrayItem(arr, 3);
+    while (item && item->next) {
+        double bucket = cJSON_GetNumberValue(item);
+        double count = cJSON_GetNumberValue(item->next);
+        if (bucket >= 0 && bucket < LLM_HIST_BUCKETS && count > 0) {
+            from.counts[(size_t)bucket] += (uint64_t)count;
+            from.count += (uint64_t)count;
+        }
+        item = item->next->next;
+    }
+    llm_hist_merge(h, &from);
+}
+
+// Helper: read llm_usage.json; an empty document if there is none or it is unreadable
+static cJSON *usage_load(void) {
+    char *path = storage_path(LLM_USAGE_FILE);
+    size_t len = 0;
+    char *buf = utils_read_file(path, &len);
+    utils_free(path);
+    cJSON *root = buf ? cJSON_ParseWithLength(buf, len) : NULL;
+    utils_free(buf);
+    if (!cJSON_IsArray(cJSON_GetObjectItem(root, "days"))) {
+        cJSON_Delete(root);
+        root = cJSON_CreateObject();
+        if (root && !cJSON_AddArrayToObject(root, "days")) {
+            cJSON_Delete(root);
+            root = NULL;
+        }
+    }
+    return root;
+}
+
+// Helper: write llm_usage.json through a temporary file
+static int usage_save(const cJSON *root) {
+    char *json = cJSON_PrintUnformatted(root);
+    char *path = storage_path(LLM_USAGE_FILE);
+    int rc = (json && path) ? utils_write_file_atomic(path, json, strlen(json)) : -1;
+    utils_free(json);
+    utils_free(path);
+    return rc;
+}
+
+// Helper: take or release the lock that serializes recording across processes
+static int usage_lock(FILE *f, short type) {
+    struct flock lock;
+    memset(&lock, 0, sizeof(lock));
+    lock.l_type = type;
+    lock.l_whence = SEEK_SET;
+    return fcntl(fileno(f), type == F_UNLCK ? F_SETLK : F_SETLKW, &lock);
+}
+
+// Helper: whether a day entry belongs to a model and endpoint
+static bool entry_is(const cJSON *entry, long day, const char *model, const char *endpoint) {
+    const char *m = cJSON_GetStringValue(cJSON_GetObjectItem(entry, "model"));
+    const char *e = cJSON_GetStringValue(cJSON_GetObjectItem(entry, "endpoint"));
+    return (long)cJSON_GetNumberValue(cJSON_GetObjectItem(entry, "day")) == day
+           && m && e && strcmp(m, model) == 0 && strcmp(e, endpoint) == 0;
+}
+
+// Helper: fold a call into the entry of its day, creating it if needed
+static int fold_call(cJSON *days, long today, const LlmCall *call) {
+    cJSON *entry = NULL;
+    cJSON *item;
+    cJSON_ArrayForEach(item, days) {
+        if (entry_is(item, today, call->model, call->endpoint)) {
+            entry = item;
+            break;
+        }
+    }
+    if (!entry) {
+        entry = cJSON_CreateObject();
+        if (!entry) return -1;
+        cJSON_AddNumberToObject(entry, "day", (double)today);
+        cJSON_AddStringToObject(entry, "model", call->model);
+        cJSON_AddStringToObject(entry, "endpoint", call->endpoint);
+        cJSON_AddNumberToObject(entry, "calls", 0);
+        cJSON_AddNumberToObject(entry, "errors", 0);
+        cJSON_AddItemToArray(days, entry);
+    }
+
+    cJSON *calls = cJSON_GetObjectItem(entry, "calls");
+    cJSON *errors = cJSON_GetObjectItem(entry, "errors");
+    if (!cJSON_IsNumber(calls) || !cJSON_IsNumber(errors)) return -1;
+    cJSON_SetNumberValue(calls, calls->valuedouble + 1);
+    if (!call->ok) {
+        cJSON_SetNumberValue(errors, errors->valuedouble + 1);
+        return 0;
+    }
+
+    LlmHist *h = utils_malloc(sizeof(LlmHist));
+    if (!h) return -1;
+    int rc = 0;
+    for (int m = 0; m < LLM_METRIC_COUNT && rc == 0; m++) {
+        memset(h, 0, sizeof(*h));
+        hist_add_cjson(h, cJSON_GetObjectItem(entry, METRIC_KEYS[m]));
+        llm_hist_record(h, call->values[m]);
+        cJSON *arr = hist_to_cjson(h);
+        if (!arr) rc = -1;
+        else if (cJSON_GetObjectItem(entry, METRIC_KEYS[m])) cJSON_ReplaceItemInObject(entry, METRIC_KEYS[m], arr);
+        else cJSON_AddItemToObject(entry, METRIC_KEYS[m], arr);
+    }
+    utils_free(h);
+    return rc;
+}
+
+int llm_usage_record(const LlmCall *call) {
+    if (!call || !call->model || !call->endpoint || storage_init() != 0) return -1;
+    char *lock_path = storage_path(LLM_USAGE_LOCK_FILE);
+    FILE *lock = lock_path ? fopen(lock_path, "a") : NULL;
+    utils_free(lock_path);
+    if (!lock) return -1;
+    if (usage_lock(lock, F_WRLCK) != 0) {
+        fclose(lock);
+        return -1;
+    }
+
+    int rc = -1;
+    cJSON *root = usage_load();
+    cJSON *days = cJSON_GetObjectItem(root, "days");
+    if (days) {
+        // Drop the days no report reaches any more
+        long today = app_clock_local_day(app_clock_now());
+        int i = 0;
+        while (i < cJSON_GetArraySize(days)) {
+            double day = cJSON_GetNumberValue(cJSON_GetObjectItem(cJSON_GetArrayItem(days, i), "day"));
+            if ((long)day <= today - LLM_USAGE_KEEP_DAYS) cJSON_DeleteItemFromArray(days, i);
+            else i++;
+        }
+        if (fold_call(days, today, call) == 0) rc = usage_save(root);
+    }
+    cJSON_Delete(root);
+    usage_lock(lock, F_UNLCK);
+    fclose(lock);
+    return rc;
+}
+
+// Helper: the series of a model and endpoint, added if new
+static LlmUsageSeries *series_get(LlmUsageReport *r, const char *model, const char *endpoint) {
+    for (size_t i = 0; i < r->series_count; i++) {
+        LlmUsageSeries *s = &r->series[i];
+        if (strcmp(s->model, model) == 0 && strcmp(s->endpoint, endpoint) == 0) return s;
+    }
+    LlmUsageSeries *grown = utils_realloc(r->series, (r->series_count + 1) * sizeof(LlmUsageSeries));
+    if (!grown) return NULL;
+    r->series = grown;
+    LlmUsageSeries *s = &r->series[r->series_count];
+    memset(s, 0, sizeof(*s));
+    s->model = utils_strdup(model);
+    s->endpoint = utils_strdup(endpoint);
+    s->daily_p50 = utils_calloc((size_t)r->days, sizeof(uint64_t));
+    if (!s->model || !s->endpoint || !s->daily_p50) {
+        utils_free(s->model);
+        utils_free(s->endpoint);
+        utils_free(s->daily_p50);
+        return NULL;
+    }
+    r->series_count++;
+    return s;
+}
+
+// Helper: order series by model, then endpoint
+static int series_cmp(const void *a, const void *b) {
+    const LlmUsageSeries *x = a, *y = b;
+    int c = strcmp(x->model, y->model);
+    return c ? c : strcmp(x->endpoint, y->endpoint);
+}
+
+LlmUsageReport *llm_usage_report(int days) {
+    if (days < 1) return NULL;
+    cJSON *root = usage_load();
+    if (!root) return NULL;
+    LlmUsageReport *r = utils_calloc(1, sizeof(LlmUsageReport));
+    LlmHist *day_total = utils_malloc(sizeof(LlmHist));
+    if (!r || !day_total) {
+        utils_free(r);
+        utils_free(day_total);
+        cJSON_Delete(root);
+        return NULL;
+    }
+    r->days = days;
+    long today = app_clock_local_day(app_clock_now());
+    r->first_day = today - days + 1;
+
+    const cJSON *entry;
+    cJSON_ArrayForEach(entry, cJSON_GetObjectItem(root, "days")) {
+        long day = (long)cJSON_GetNumberValue(cJSON_GetObjectItem(entry, "day"));
+        const char *model = cJSON_GetStringValue(cJSON_GetObjectItem(entry, "model"));
+        const char *endpoint = cJSON_GetStringValue(cJSON_GetObjectItem(entry, "endpoint"));
+        if (day < r->first_day || day > today || !model || !endpoint) continue;
+        LlmUsageSeries *s = series_get(r, model, endpoint);
+        if (!s) {
+            llm_usage_report_free(r);
+            r = NULL;
+            break;
+        }
+        s->calls += (uint64_t)cJSON_GetNumberValue(cJSON_GetObjectItem(entry, "calls"));
+        s->errors += (uint64_t)cJSON_GetNumberValue(cJSON_GetObjectItem(entry, "errors"));
+        for (int m = 0; m < LLM_METRIC_COUNT; m++) {
+            hist_add_cjson(&s->hists[m], cJSON_GetObjectItem(entry, METRIC_KEYS[m]));
+        }
+        memset(day_total, 0, sizeof(*day_total));
+        hist_add_cjson(day_total, cJSON_GetObjectItem(entry, METRIC_KEYS[LLM_METRIC_TOTAL]));
+        s->daily_p50[day - r->first_day] = llm_hist_percentile(day_total, 50);
+    }
+    utils_free(day_total);
+    cJSON_Delete(root);
+    if (r && r->series_count > 1) qsort(r->series, r->series_count, sizeof(LlmUsageSeries), series_cmp);
+    return r;
+}
+
+void llm_usage_report_free(LlmUsageReport *r) {
+    if (!r) return;
+    for (size_t i = 0; i < r->series_count; i++) {
+        utils_free(r->series[i].model);
+        utils_free(r->series[i].endpoint);
+        utils_free(r->series[i].daily_p50);
+    }
+    utils_free(r->series);
+    utils_free(r);
+}
+
+// Helper: microseconds as milliseconds, with a decimal below 10 ms
+static const char *format_ms(uint64_t us, char *buf, size_t size) {
+    if (us < 10000) snprintf(buf, size, "%.1f ms", (double)us / 1000.0);
+    else snprintf(buf, size, "%.0f ms", (double)us / 1000.0);
+    return buf;
+}
+
+// Helper: latency percentiles and the daily median of one series
+static void print_latency(FILE *out, const LlmUsageReport *r, const LlmUsageSeries *s) {
+    fprintf(out, "%s  %s  (%llu calls, %llu failed)\n", s->model, s->endpoint,
+            (unsigned long long)s->calls, (unsigned long long)s->errors);
+    fprintf(out, "             %10s %10s %10s %10s\n", "p50", "p90", "p99", "max");
+    static const double PERCENTILES[] = {50, 90, 99};
+    char buf[32];
+    for (int m = LLM_METRIC_CONNECT; m <= LLM_METRIC_TOTAL; m++) {
+        fprintf(out, "  %-10s", LATENCY_LABELS[m]);
+        for (size_t p = 0; p < 3; p++) {
+            fprintf(out, " %10s", format_ms(llm_hist_percentile(&s->hists[m], PERCENTILES[p]), buf, sizeof(buf)));
+        }
+        fprintf(out, " %10s\n", format_ms(s->hists[m].max, buf, sizeof(buf)));
+    }
+
+    // The daily median total time, scaled for the sparkline
+    unsigned *values = utils_calloc((size_t)r->days, sizeof(unsigned));
+    char *line = utils_malloc((size_t)r->days + 1);
+    if (values && line) {
+        for (int d = 0; d < r->days; d++) values[d] = (unsigned)(s->daily_p50[d] / 1000);
+        stats_sparkline(values, (size_t)r->days, line, (size_t)r->days + 1);
+        fprintf(out, "  daily p50  [%s]\n", line);
+    }
+    utils_free(values);
+    utils_free(line);
+}
+
+void llm_usage_print(FILE *out, const LlmUsageReport *r, bool latency) {
+    fprintf(out, "AI %s, last %d day%s\n", latency ? "latency" : "usage", r->days, r->days == 1 ? "" : "s");
+    if (r->series_count == 0) {
+        fprintf(out, "No AI calls recorded.\n");
+        return;
+    }
+    if (latency) {
+        for (size_t i = 0; i < r->series_count; i++) {
+            fprintf(out, "\n");
+            print_latency(out, r, &r->series[i]);
+        }
+        return;
+    }
+    fprintf(out, "%-20s  %-20s  %6s  %6s  %12s  %12s\n", "model", "endpoint", "calls", "failed",
+            "prompt tok", "output tok");
+    for (size_t i = 0; i < r->series_count; i++) {
+        const LlmUsageSeries *s = &r->series[i];
+        fprintf(out, "%-20.20s  %-20.20s  %6llu  %6llu  %12llu  %12llu\n", s->model, s->endpoint,
+                (unsigned long long)s->calls, (unsigned long long)s->errors,
+                (unsigned long long)s->hists[LLM_METRIC_PROMPT_TOKENS].sum,
+                (unsigned long long)s->hists[LLM_METRIC_COMPLETION_TOKENS].sum);
+    }
+}
+
+// Helper: the report as JSON; latencies in ms
+static cJSON *report_to_cjson(const LlmUsageReport *r) {
+    cJSON *root = cJSON_CreateObject();
+    cJSON *series = root ? cJSON_AddArrayToObject(root, "series") : NULL;
+    if (!series) {
+        cJSON_Delete(root);
+        return NULL;
+    }
+    char date[16];
+    stats_format_day(r->first_day, date, sizeof(date));
+    cJSON_AddStringToObject(root, "from", date);
+    cJSON_AddNumberToObject(root, "days", r->days);
+    for (size_t i = 0; i < r->series_count; i++) {
+        const LlmUsageSeries *s = &r->series[i];
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "model", s->model);
+        cJSON_AddStringToObject(item, "endpoint", s->endpoint);
+        cJSON_AddNumberToObject(item, "calls", (double)s->calls);
+        cJSON_AddNumberToObject(item, "errors", (double)s->errors);
+        for (int m = 0; m < LLM_METRIC_COUNT; m++) {
+            const LlmHist *h = &s->hists[m];
+            double scale = m <= LLM_METRIC_TOTAL ? 1000.0 : 1.0;
+            cJSON *stats = cJSON_AddObjectToObject(item, REPORT_KEYS[m]);
+            cJSON_AddNumberToObject(stats, "p50", (double)llm_hist_percentile(h, 50) / scale);
+            cJSON_AddNumberToObject(stats, "p90", (double)llm_hist_percentile(h, 90) / scale);
+            cJSON_AddNumberToObject(stats, "p99", (double)llm_hist_percentile(h, 99) / scale);
+            cJSON_AddNumberToObject(stats, "max", (double)h->max / scale);
+            cJSON_AddNumberToObject(stats, "sum", (double)h->sum / scale);
+        }
+        cJSON *daily = cJSON_AddArrayToObject(item, "daily_p50_ms");
+        for (int d = 0; daily && d < r->days; d++) {
+            cJSON_AddItemToArray(daily, cJSON_CreateNumber((double)s->daily_p50[d] / 1000.0));
+        }
+        cJSON_AddItemToArray(series, item);
+    }
+    return root;
+}
+
+int llm_usage_main(int argc, char **argv) {
+    int days = LLM_USAGE_DAYS;
+    bool latency = false, json = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--latency") == 0) {
+            latency = true;
+            continue;
+        }
+        if (strcmp(argv[i], "--json") == 0) {
+            json = true;
+            continue;
+        }
+        char *end = NULL;
+        long n = (strcmp(argv[i], "--days") == 0 && i + 1 < argc) ? strtol(argv[++i], &end, 10) : 0;
+        if (!end || *end != '\0' || n <= 0 || n > LLM_USAGE_KEEP_DAYS) {
+            fprintf(stderr, "Usage: smartodo ai-usage [--latency] [--days N] [--json]\n");
+            return 2;
+        }
+        days = (int)n;
+    }
+    app_clock_tick();
+    LlmUsageReport *r = llm_usage_report(days);
+    if (!r) {
+        fprintf(stderr, "Failed to read the AI usage.\n");
+        return 1;
+    }
+    if (json) {
+        cJSON *root = report_to_cjson(r);
+        char *text = root ? cJSON_PrintUnformatted(root) : NULL;
+        if (text) printf("%s\n", text);
+        utils_free(text);
+        cJSON_Delete(root);
+    } else {
+        llm_usage_print(stdout, r, latency);
+    }
+    llm_usage_report_free(r);
+    return 0;
+}
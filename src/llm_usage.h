@@ -0,0 +1,151 @@
+#ifndef TODO_APP_LLM_USAGE_H
+#define TODO_APP_LLM_USAGE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * Latency and token accounting of LLM calls. Every call made by llm_chat()
+ * is folded into histograms of its local day, model and endpoint in
+ * ~/.todo-app/llm_usage.json: connect time, time to first byte and total
+ * time in microseconds, and prompt and completion tokens. Histograms are
+ * log-linear in the manner of HdrHistogram: exact below 2^LLM_HIST_SUB_BITS,
+ * then 2^LLM_HIST_SUB_BITS buckets per power of two, so a percentile is
+ * within about 3% of the true value. `smartodo ai-usage` reports them.
+ */
+
+#define LLM_USAGE_FILE "llm_usage.json"
+
+// Days a report covers by default
+#define LLM_USAGE_DAYS 30
+
+// Days of histograms kept; older days are dropped when a call is recorded
+#define LLM_USAGE_KEEP_DAYS 120
+
+// Buckets per power of two, as a power of two
+#define LLM_HIST_SUB_BITS 5
+#define LLM_HIST_SUB_COUNT (1u << LLM_HIST_SUB_BITS)
+
+// Largest value kept apart; larger values share the last bucket
+#define LLM_HIST_MAX_BITS 40
+#define LLM_HIST_BUCKETS (LLM_HIST_SUB_COUNT * (LLM_HIST_MAX_BITS - LLM_HIST_SUB_BITS + 1))
+
+// What a call is measured by
+typedef enum {
+    LLM_METRIC_CONNECT,            // Until connected, TLS handshake included, us
+    LLM_METRIC_TTFB,               // Until the first byte of the response, us
+    LLM_METRIC_TOTAL,              // Until the whole response was read, us
+    LLM_METRIC_PROMPT_TOKENS,
+    LLM_METRIC_COMPLETION_TOKENS,
+    LLM_METRIC_COUNT
+} LlmMetric;
+
+typedef struct {
+    uint64_t counts[LLM_HIST_BUCKETS];
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+} LlmHist;
+
+// One finished call
+typedef struct {
+    const char *model;
+    const char *endpoint;          // API path, e.g. "chat/completions"
+    bool ok;                       // Failed calls are counted, not measured
+    uint64_t values[LLM_METRIC_COUNT];
+} LlmCall;
+
+// One model and endpoint over a report's days
+typedef struct {
+    char *model;
+    char *endpoint;
+    uint64_t calls;                // Failed ones included
+    uint64_t errors;
+    LlmHist hists[LLM_METRIC_COUNT];
+    uint64_t *daily_p50;           // Median total time of each day in us, oldest first (0 without calls)
+} LlmUsageSeries;
+
+typedef struct {
+    int days;
+    long first_day;                // Local day number of the first day
+    size_t series_count;
+    LlmUsageSeries *series;        // Sorted by model, then endpoint
+} LlmUsageReport;
+
+/**
+ * Bucket of a value.
+ * @param value Value
+ * @return Bucket index (below LLM_HIST_BUCKETS)
+ */
+size_t llm_hist_bucket(uint64_t value);
+
+/**
+ * Highest value that falls into a bucket.
+ * @param bucket Bucket index
+ * @return Highest value of the bucket
+ */
+uint64_t llm_hist_bucket_high(size_t bucket);
+
+/**
+ * Add a value to a histogram.
+ * @param h Histogram
+ * @param value Value
+ */
+void llm_hist_record(LlmHist *h, uint64_t value);
+
+/**
+ * Add every value of one histogram to another.
+ * @param into Histogram to add to
+ * @param from Histogram to add
+ */
+void llm_hist_merge(LlmHist *into, const LlmHist *from);
+
+/**
+ * Value at a percentile: the highest value of the bucket holding it, but at
+ * most the largest value recorded.
+ * @param h Histogram
+ * @param percentile 0 to 100
+ * @return Value, or 0 if the histogram is empty
+ */
+uint64_t llm_hist_percentile(const LlmHist *h, double percentile);
+
+/**
+ * Fold one call into today's histograms in llm_usage.json.
+ * @param call Finished call
+ * @return 0 on success, -1 on error
+ */
+int llm_usage_record(const LlmCall *call);
+
+/**
+ * Aggregate the recorded calls of the last days, today included.
+ * @param days Number of days (1 or more)
+ * @return Report (free with llm_usage_report_free()), or NULL on error
+ */
+LlmUsageReport *llm_usage_report(int days);
+
+/**
+ * Free a report.
+ * @param r Report (may be NULL)
+ */
+void llm_usage_report_free(LlmUsageReport *r);
+
+/**
+ * Print a report: calls and tokens per model and endpoint, or with latency
+ * their percentiles and the daily median as a sparkline.
+ * @param out Stream to print to
+ * @param r Report
+ * @param latency Whether to show latency
+ */
+void llm_usage_print(FILE *out, const LlmUsageReport *r, bool latency);
+
+/**
+ * Entry point for `smartodo ai-usage [--latency] [--days N] [--json]`.
+ * @param argc Argument count, starting at "ai-usage"
+ * @param argv Arguments
+ * @return Exit status: 0 on success, 1 on error, 2 on bad usage
+ */
+int llm_usage_main(int argc, char **argv);
+
+#endif // TODO_APP_LLM_USAGE_H
@@ -1,6 +1,11 @@
+// strdup(), strtok_r(), strncasecmp(), localtime_r() and gmtime_r() are
+// POSIX, not ISO C
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <strings.h>
 #include <time.h>
 #include <curses.h>
 #include <ctype.h>
@@ -12,6 +17,18 @@
 #include "ai_chat.h"
 #include "utils.h"
 #include "task_manager.h"
+#include "app_clock.h"
+#include "recurrence.h"
+#include "notify.h"
+#include "cli.h"
+#include "daemon.h"
+#include "completion.h"
+#include "sync.h"
+#include "undo.h"
+#include "stats.h"
+#include "llm_usage.h"
+#include "trace.h"
+#include "startup.h"
 
 // Sort modes
 enum { BY_CREATION, BY_NAME } SortMode;
@@ -50,7 +67,7 @@ static void handle_add_project(size_t *proj_count, size_t *proj_selected, char *
     prompt_input("New project name:", proj_name, sizeof(proj_name));
     if (proj_name[0] != '\0') {
         if (task_manager_add_project(proj_name) == 0) {
-            free(*projects);
+            utils_free(*projects);
             *proj_count = task_manager_get_projects(projects);
             *proj_selected = *proj_count - 1;
             *current_project = (*projects)[*proj_selected];
@@ -71,7 +88,7 @@ static void handle_delete_project(size_t proj_count, size_t *proj_selected, char
     int del_result = task_manager_delete_project(to_delete, tasks, count);
     if (del_result == 0) {
         task_manager_save_projects();
-        free(projects);
+        utils_free(projects);
         proj_count = task_manager_get_projects(&projects);
         if (*proj_selected >= proj_count) *proj_selected = proj_count - 1;
         *current_project = projects[*proj_selected];
@@ -95,7 +112,7 @@ static void handle_cursor_up(size_t *selected) {
 
 // handle_add_task prompts the user for task details and adds a new task to the task manager for the current project.
 static void handle_add_task(Task ***tasks, size_t *count, const char *current_project) {
-    char name[128], date_str[64], tags_str[128], prio_str[8], confirm[8];
+    char name[128], date_str[64], tags_str[128], prio_str[8], confirm[8], repeat_str[96] = "";
     
     // Get task name
     prompt_input("Task name:", name, sizeof(name));
@@ -103,6 +120,7 @@ static void handle_add_task(Task ***tasks, size_t *count, const char *current_pr
     
     // Get and parse due date with natural language support
     bool date_valid = false;
+    bool date_only = false;
     time_t due = 0;
     
     while (!date_valid) {
@@ -115,7 +133,7 @@ static void handle_add_task(Task ***tasks, size_t *count, const char *current_pr
         }
         
         // Try to parse the date
-        due = utils_parse_date(date_str);
+        due = utils_parse_due(date_str, &date_only);
         
         if (due == 0) {
             // Invalid date format
@@ -129,8 +147,13 @@ static void handle_add_task(Task ***tasks, size_t *count, const char *current_pr
         // Show the parsed date for confirmation
         char formatted_date[64];
         struct tm tm_due;
-        localtime_r(&due, &tm_due);
-        strftime(formatted_date, sizeof(formatted_date), "%A, %B %d at %I:%M %p", &tm_due);
+        if (date_only) {
+            gmtime_r(&due, &tm_due); // Calendar date stored as midnight UTC
+            strftime(formatted_date, sizeof(formatted_date), "%A, %B %d", &tm_due);
+        } else {
+            localtime_r(&due, &tm_due);
+            strftime(formatted_date, sizeof(formatted_date), "%A, %B %d at %I:%M %p", &tm_due);
+        }
         
         snprintf(confirm, sizeof(confirm), "%s", "");
         mvprintw(LINES - 2, 1, "Due: %s. Okay? (Y/n): ", formatted_date);
@@ -152,6 +175,18 @@ static void handle_add_task(Task ***tasks, size_t *count, const char *current_pr
         date_valid = true;
     }
     
+    // Get recurrence rule (only meaningful with a due date)
+    while (due != 0) {
+        prompt_input("Repeat (daily/weekly/monthly/weekdays/every 2 weeks/RRULE, optional):",
+                     repeat_str, sizeof(repeat_str));
+        Recurrence rule;
+        if (repeat_str[0] == '\0' || recurrence_parse(repeat_str, &rule) == 0) break;
+        mvprintw(LINES - 2, 1, "Invalid repeat rule. Try 'weekly' or 'FREQ=WEEKLY;BYDAY=MO,FR'.");
+        clrtoeol();
+        refresh();
+        napms(1500);
+    }
+    
     // Get tags
     prompt_input("Tags (comma-separated, optional):", tags_str, sizeof(tags_str));
     
@@ -207,16 +242,18 @@ static void handle_add_task(Task ***tasks, size_t *count, const char *current_pr
     }
     
     // Add task using task manager
-    if (task_manager_add_task(tasks, count, name, due, (const char **)tag_tokens, tag_count, prio, current_project) != 0) {
+    if (task_manager_add_task(tasks, count, name, due, date_only ? DUE_DATE : DUE_DATETIME, (const char **)tag_tokens, tag_count, prio, current_project) != 0) {
         mvprintw(LINES - 2, 1, "Failed to add task");
         clrtoeol();
         refresh();
         napms(1500);
+    } else if (repeat_str[0] != '\0') {
+        task_set_recurrence((*tasks)[*count - 1], repeat_str);
     }
     
     // Free allocated tag strings
     for (size_t i = 0; i < tag_count; i++) {
-        free(tag_tokens[i]);
+        utils_free(tag_tokens[i]);
     }
     
     // Sort tasks by due date
@@ -255,11 +292,7 @@ static void handle_edit_task(Task **disp, size_t disp_count, size_t selected, in
     
     // Pre-fill with current values
     strncpy(name, t->name ? t->name : "", sizeof(name));
-    if (t->due > 0) {
-        struct tm tm;
-        gmtime_r(&t->due, &tm);
-        strftime(date_str, sizeof(date_str), "%Y-%m-%d", &tm);
-    } else {
+    if (!task_format_due_date(t, date_str, sizeof(date_str))) {
         date_str[0] = '\0';
     }
     
@@ -285,6 +318,7 @@ static void handle_edit_task(Task **disp, size_t disp_count, size_t selected, in
 
     // Edit due date with natural language support
     bool date_valid = false;
+    bool new_date_only = false;
     time_t new_due = -1; // -1 means don't change
     
     prompt_input("New due date (e.g., 'tomorrow 2pm', 'next monday', 'may 20', empty to keep):", 
@@ -293,7 +327,7 @@ static void handle_edit_task(Task **disp, size_t disp_count, size_t selected, in
     if (date_str[0] != '\0') {
         while (!date_valid) {
             // Try to parse the date
-            new_due = utils_parse_date(date_str);
+            new_due = utils_parse_due(date_str, &new_date_only);
             
             if (new_due == 0) {
                 // Invalid date format
@@ -310,8 +344,13 @@ static void handle_edit_task(Task **disp, size_t disp_count, size_t selected, in
             // Show the parsed date for confirmation
             char formatted_date[64];
             struct tm tm_due;
-            localtime_r(&new_due, &tm_due);
-            strftime(formatted_date, sizeof(formatted_date), "%A, %B %d at %I:%M %p", &tm_due);
+            if (new_date_only) {
+                gmtime_r(&new_due, &tm_due); // Calendar date stored as midnight UTC
+                strftime(formatted_date, sizeof(formatted_date), "%A, %B %d", &tm_due);
+            } else {
+                localtime_r(&new_due, &tm_due);
+                strftime(formatted_date, sizeof(formatted_date), "%A, %B %d at %I:%M %p", &tm_due);
+            }
             
             mvprintw(LINES - 2, 1, "New due date: %s. Okay? (Y/n): ", formatted_date);
             clrtoeol();
@@ -389,6 +428,7 @@ static void handle_edit_task(Task **disp, size_t disp_count, size_t selected, in
         disp[selected],
         edit_name,  // Use the edit_name which has either new name or existing name
         date_valid ? new_due : -1,
+        new_date_only ? DUE_DATE : DUE_DATETIME,
         tag_count > 0 ? (const char **)tag_tokens : NULL,
         tag_count,
         new_prio_str[0] ? new_prio : -1,
@@ -397,7 +437,7 @@ static void handle_edit_task(Task **disp, size_t disp_count, size_t selected, in
     
     // Free allocated tag strings
     for (size_t i = 0; i < tag_count; i++) {
-        free(tag_tokens[i]);
+        utils_free(tag_tokens[i]);
     }
     
     if (result != 0) {
@@ -422,6 +462,24 @@ static void handle_toggle_status(Task **disp, size_t disp_count, size_t selected
     task_manager_toggle_status(t);
 }
 
+// handle_undo undoes (or redoes) the newest step and tells the user what it was.
+static void handle_undo(Task ***tasks, size_t *count, int sort_mode, bool redo) {
+    char label[UNDO_LABEL_LEN];
+    char msg[UNDO_LABEL_LEN + 32];
+    int rc = redo ? undo_redo(tasks, count, label, sizeof(label)) : undo_undo(tasks, count, label, sizeof(label));
+    if (rc == 0) {
+        snprintf(msg, sizeof(msg), redo ? "Nothing to redo" : "Nothing to undo");
+    } else {
+        snprintf(msg, sizeof(msg), "%s%s: %s", rc < 0 ? "Partly " : "", redo ? "Redone" : "Undone", label);
+    }
+    if (sort_mode == BY_NAME) {
+        task_manager_sort_by_name(*tasks, *count);
+    } else {
+        task_manager_sort_by_due(*tasks, *count);
+    }
+    utils_show_message(msg, LINES - 2, 1);
+}
+
 // handle_sort_tasks prompts the user for a sorting criterion (name or date) and sorts the task list accordingly.
 static void handle_sort_tasks(int *sort_mode, Task **tasks, size_t count) {
     char opt[8];
@@ -475,25 +533,64 @@ bool toggle_note_visibility(Task **disp, size_t disp_count, size_t selected, boo
 #define MAX_PROJECTS 64
 
 int main(int argc, char *argv[]) {
+    if (argc >= 2 && strcmp(argv[1], STARTUP_PROFILE_FLAG) == 0) {
+        startup_profile_enable();
+        argc = 1;
+    }
+    app_clock_init();
+    trace_init();
+
+    // Tab completion runs on every key press; answer before anything else
+    if (argc >= 2 && strcmp(argv[1], "__complete") == 0) {
+        return completion_complete(argc - 2, argv + 2, stdout) == 0 ? 0 : 1;
+    }
+    if (argc >= 2 && strcmp(argv[1], "completion") == 0) {
+        if (completion_print_script(argc >= 3 ? argv[2] : NULL, stdout) == 0) return 0;
+        fprintf(stderr, "Usage: smartodo completion bash|zsh|fish\n");
+        return 2;
+    }
     if (argc >= 2 && strcmp(argv[1], "ai-chat") == 0) {
         return ai_chat_repl();
     }
+    if (argc >= 2 && cli_is_command(argv[1])) {
+        return cli_main(argc - 1, argv + 1);
+    }
+    if (argc >= 2 && strcmp(argv[1], "remind") == 0) {
+        return notify_run_reminders();
+    }
+    if (argc >= 2 && strcmp(argv[1], "daemon") == 0) {
+        return daemon_run(argc - 1, argv + 1);
+    }
+    if (argc >= 2 && strcmp(argv[1], "sync") == 0) {
+        return sync_main(argc - 1, argv + 1);
+    }
+    if (argc >= 2 && strcmp(argv[1], "stats") == 0) {
+        return stats_main(argc - 1, argv + 1);
+    }
+    if (argc >= 2 && strcmp(argv[1], "ai-usage") == 0) {
+        return llm_usage_main(argc - 1, argv + 1);
+    }
     if (argc >= 3 && strcmp(argv[1], "ai-add") == 0) {
         ai_smart_add_default(argv[2]);
         return 0;
     }
 
-    // Initialize task manager
-    if (task_manager_init() != 0) {
-        fprintf(stderr, "Failed to initialize task manager.\n");
+    // Paint the shell before touching the disk
+    if (ui_init() != 0) {
+        ui_teardown();
+        fprintf(stderr, "Failed to initialize UI.\n");
         return 1;
     }
+    startup_mark("ui_init");
+    ui_draw_header("Loading...");
+    ui_draw_standard_footer();
+    refresh();
+    startup_mark("first_paint");
 
-    // Load tasks
-    size_t count = 0;
-    Task **tasks = task_manager_load_tasks(&count);
-    if (!tasks) {
-        fprintf(stderr, "Failed to load tasks.\n");
+    // Initialize task manager
+    if (task_manager_init() != 0) {
+        ui_teardown();
+        fprintf(stderr, "Failed to initialize task manager.\n");
         return 1;
     }
 
@@ -509,12 +606,28 @@ int main(int argc, char *argv[]) {
     }
     size_t proj_selected = 0;
     const char *current_project = projects[proj_selected];
+    startup_mark("projects");
 
-    // Initialize UI
-    if (ui_init() != 0) {
-        fprintf(stderr, "Failed to initialize UI.\n");
-        task_manager_cleanup(tasks, count);
-        free(projects);
+    // Load tasks: the file is parsed once, the current project's tasks are
+    // built and shown first, then the others
+    size_t count = 0;
+    StorageLoader *loader = storage_loader_open();
+    startup_mark("read_parse");
+    Task **first = loader ? storage_loader_first(loader, current_project, &count) : NULL;
+    if (first) {
+        ui_draw_projects(projects, proj_count, proj_selected);
+        ui_draw_tasks(first, count, 0);
+        refresh();
+        utils_free(first);
+    }
+    startup_mark("project_paint");
+    Task **tasks = loader ? storage_loader_rest(loader, &count) : NULL;
+    storage_loader_close(loader);
+    startup_mark("all_tasks");
+    if (!tasks) {
+        ui_teardown();
+        fprintf(stderr, "Failed to load tasks.\n");
+        utils_free(projects);
         return 1;
     }
 
@@ -522,14 +635,23 @@ int main(int argc, char *argv[]) {
     int sort_mode = BY_CREATION;
     char search_term[64] = "";
     bool show_note = false; // Track whether we're showing a note
+    StatsReport *stats = NULL; // Shown in place of the task list while set
+#ifdef UTILS_ALLOC_STATS
+    bool show_alloc = false; // Allocation overlay of debug builds
+#endif
+    undo_attach(0);
 
     while (1) {
+        // One clock reading per frame
+        app_clock_tick();
+        trace_begin("frame");
+
         // Build display list with search/filter
         Task **disp = utils_malloc((count + 1) * sizeof(Task*));
         if (!disp) {
             ui_teardown();
             task_manager_cleanup(tasks, count);
-            free(projects);
+            utils_free(projects);
             fprintf(stderr, "Failed to allocate memory for display list.\n");
             return 1;
         }
@@ -545,10 +667,14 @@ int main(int argc, char *argv[]) {
         clear();
         ui_draw_header(search_term[0] ? search_term : "All Tasks");
         ui_draw_projects(projects, proj_count, proj_selected);
-        ui_draw_tasks(disp, disp_count, selected);
+        if (stats) {
+            ui_draw_stats(stats);
+        } else {
+            ui_draw_tasks(disp, disp_count, selected);
+        }
         
         // Display note if show_note is true and there's a selected task
-        if (show_note && disp_count > 0 && selected < disp_count) {
+        if (!stats && show_note && disp_count > 0 && selected < disp_count) {
             int note_area_height = 7; // 1 for separator, 1 for header, 5 for content
             int note_y_base = LINES - note_area_height - 1;
             int note_max_display_lines = 5;
@@ -571,13 +697,13 @@ int main(int argc, char *argv[]) {
         }
         
         // Add a suggestion for the selected task if applicable (Restoring this section)
-        if (disp_count > 0 && selected < disp_count) {
+        if (!stats && disp_count > 0 && selected < disp_count) {
             Task *selected_task = disp[selected];
             char suggestion[128] = "";
             if (selected_task->status == STATUS_PENDING) {
                 if (selected_task->due > 0) {
-                    time_t now_time = time(NULL);
-                    if (selected_task->due < now_time) {
+                    time_t now_time = app_clock_now();
+                    if (task_due_deadline(selected_task) < now_time) {
                         strcpy(suggestion, "Mark as done or reschedule");
                     } else if (selected_task->priority == PRIORITY_HIGH) {
                         strcpy(suggestion, "Break into smaller steps");
@@ -600,8 +726,24 @@ int main(int argc, char *argv[]) {
             }
         }
         
+#ifdef UTILS_ALLOC_STATS
+        if (show_alloc) ui_draw_alloc_overlay();
+#endif
         ui_draw_standard_footer();
         refresh();
+        trace_end("frame");
+
+        // Profiling stops at the first full frame; nothing changed, so nothing is saved
+        if (startup_profile_enabled()) {
+            startup_mark("first_frame");
+            utils_free(disp);
+            ui_teardown();
+            undo_detach();
+            startup_report(stdout);
+            task_manager_cleanup(tasks, count);
+            utils_free(projects);
+            return 0;
+        }
 
         int ch = ui_get_input();
         if (ch == 'q' || ch == 'Q') break;
@@ -642,16 +784,30 @@ int main(int argc, char *argv[]) {
                 }
                 break;
             case 'a':
+                undo_begin("Add task");
                 handle_add_task(&tasks, &count, current_project);
+                undo_end();
                 break;
             case 'd':
+                undo_begin("Delete task");
                 handle_delete_task(&tasks, &count, disp, disp_count, &selected);
+                undo_end();
                 break;
             case 'e':
+                undo_begin("Edit task");
                 handle_edit_task(disp, disp_count, selected, sort_mode, tasks, count); // Corrected: removed & from tasks and count
+                undo_end();
                 break;
             case 'm':
+                undo_begin("Mark task");
                 handle_toggle_status(disp, disp_count, selected);
+                undo_end();
+                break;
+            case 'u':
+                handle_undo(&tasks, &count, sort_mode, false);
+                break;
+            case 'r':
+                handle_undo(&tasks, &count, sort_mode, true);
                 break;
             case 's':
                 handle_sort_tasks(&sort_mode, tasks, count);
@@ -662,6 +818,25 @@ int main(int argc, char *argv[]) {
             case 'v':
                 show_note = toggle_note_visibility(disp, disp_count, selected, show_note);
                 break;
+            case 'S':
+                if (stats) {
+                    stats_report_free(stats);
+                    stats = NULL;
+                } else {
+                    stats = stats_report(0);
+                    if (!stats) utils_show_message("Failed to compute statistics", LINES - 2, 1);
+                }
+                break;
+            case 'T':
+                if (trace_dump(NULL) == 0) utils_show_message("Trace written", LINES - 2, 1);
+                else if (!trace_enabled()) utils_show_message("Tracing is off (set " TRACE_ENV ")", LINES - 2, 1);
+                else utils_show_message("Failed to write the trace", LINES - 2, 1);
+                break;
+#ifdef UTILS_ALLOC_STATS
+            case 'M':
+                show_alloc = !show_alloc;
+                break;
+#endif
             case 'N': 
             case 'n': 
                 if (disp_count > 0 && selected < disp_count) {
@@ -675,7 +850,11 @@ int main(int argc, char *argv[]) {
     
                     // Call the new UI function for note editing
                     if (ui_handle_note_edit(stdscr, current_note, temp_note_buffer, MAX_NOTE_LEN, disp[selected]->name)) {
+                        undo_begin("Edit note");
+                        task_manager_notify_before_change(TASK_CHANGE_PUT, disp[selected]);
                         task_set_note(disp[selected], temp_note_buffer); // Save the note if changes were made
+                        task_manager_notify_change(TASK_CHANGE_PUT, disp[selected]);
+                        undo_end();
                     }
                 }
                 show_note = false; // Hide note view after editing session
@@ -691,15 +870,22 @@ int main(int argc, char *argv[]) {
         }
         
         task_manager_save_tasks(tasks, count);
-        free(disp);
+        if (stats) {
+            // Pick up what the key just changed
+            stats_report_free(stats);
+            stats = stats_report(0);
+        }
+        utils_free(disp);
     }
 
 cleanup_and_exit: // Label for AI chat to exit application
     ui_teardown();
+    undo_detach();
+    stats_report_free(stats);
     task_manager_save_tasks(tasks, count);
     task_manager_save_projects();
     task_manager_cleanup(tasks, count);
-    for(size_t i=0; i<proj_count; ++i) free(projects[i]);
-    free(projects);
+    for(size_t i=0; i<proj_count; ++i) utils_free(projects[i]);
+    utils_free(projects);
     return 0;
 }
@@ -0,0 +1,213 @@
+// fork(), waitpid() and localtime_r() are POSIX, not ISO C
+#define _POSIX_C_SOURCE 200809L
+
+#include "notify.h"
+#include "reminder.h"
+#include "storage.h"
+#include "journal.h"
+#include "task.h"
+#include "utils.h"
+#include "app_clock.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+// Without inotify the tasks file is checked for changes this often
+#define NOTIFY_POLL_MS 60000
+
+// Size and mtime of a file when it was last read (zero if it did not exist)
+typedef struct {
+    time_t mtime;
+    off_t size;
+} FileStamp;
+
+// State of the reminder loop
+typedef struct {
+    Task **tasks;
+    size_t count;
+    ReminderQueue *queue;
+    char *tasks_path;
+    char *journal_path;
+    FileStamp tasks_stamp;    // Tasks file when last loaded
+    FileStamp journal_stamp;  // Daemon journal when last loaded
+    time_t watermark;         // Reminders at or before this time were delivered
+} ReminderLoop;
+
+int notify_send(const char *title, const char *message) {
+    const char *cmd = getenv(NOTIFY_CMD_ENV);
+    if (!cmd || cmd[0] == '\0') {
+        // Terminal bell plus one line per reminder
+        printf("\a[%s] %s\n", title, message);
+        fflush(stdout);
+        return 0;
+    }
+
+    // Pass the text as positional parameters so it is never parsed by the shell
+    pid_t pid = fork();
+    if (pid < 0) return -1;
+    if (pid == 0) {
+        execl("/bin/sh", "sh", "-c", cmd, "smartodo", title, message, (char *)NULL);
+        _exit(127);
+    }
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) return -1;
+    }
+    return (WIFEXITED(status) && WEXITSTATUS(status) == 0) ? 0 : -1;
+}
+
+// Helper: format the notification text for a task
+static void format_reminder(const Task *t, char *buf, size_t size) {
+    char when[32] = "";
+    if (t->due_kind == DUE_DATETIME) {
+        struct tm tm = {0};
+        localtime_r(&t->due, &tm);
+        strftime(when, sizeof(when), "%H:%M", &tm);
+    } else {
+        task_format_due_date(t, when, sizeof(when));
+    }
+    snprintf(buf, size, "%s (due %s)", t->name ? t->name : "", when);
+}
+
+// Helper: deliver a fired reminder
+static void on_reminder(const char *key, time_t fire_at, void *data, void *user) {
+    (void)key;
+    (void)fire_at;
+    (void)user;
+    const Task *t = data;
+    char msg[MAX_TASK_SERIALIZE_LEN];
+    format_reminder(t, msg, sizeof(msg));
+    if (notify_send("smartodo reminder", msg) != 0) {
+        fprintf(stderr, "Failed to run notification command for '%s'\n", t->name ? t->name : "");
+    }
+}
+
+// Helper: read a file's current stamp
+static FileStamp stamp_file(const char *path) {
+    FileStamp stamp = {0, 0};
+    struct stat st;
+    if (stat(path, &st) == 0) {
+        stamp.mtime = st.st_mtime;
+        stamp.size = st.st_size;
+    }
+    return stamp;
+}
+
+// Helper: check whether the tasks file or the daemon journal changed since
+// the tasks were last loaded
+static bool tasks_file_changed(const ReminderLoop *loop) {
+    FileStamp tasks = stamp_file(loop->tasks_path);
+    FileStamp journal = stamp_file(loop->journal_path);
+    return tasks.mtime != loop->tasks_stamp.mtime || tasks.size != loop->tasks_stamp.size
+        || journal.mtime != loop->journal_stamp.mtime || journal.size != loop->journal_stamp.size;
+}
+
+// Helper: (re)load tasks and schedule every reminder after the watermark
+static int load_reminders(ReminderLoop *loop) {
+    loop->tasks_stamp = stamp_file(loop->tasks_path);
+    loop->journal_stamp = stamp_file(loop->journal_path);
+
+    reminder_queue_clear(loop->queue);
+    storage_free_tasks(loop->tasks, loop->count);
+    loop->count = 0;
+    loop->tasks = storage_load_tasks(&loop->count);
+    if (!loop->tasks) return -1;
+
+    for (size_t i = 0; i < loop->count; i++) {
+        Task *t = loop->tasks[i];
+        time_t at = task_remind_at(t);
+        if (at == 0 || at <= loop->watermark || !t->id) continue;
+        if (reminder_queue_schedule(loop->queue, t->id, at, t) != 0) return -1;
+    }
+    return 0;
+}
+
+#ifdef __linux__
+// Helper: watch the storage directory so edits wake the loop immediately
+static int open_watch(const char *tasks_path) {
+    char *dir = utils_strdup(tasks_path);
+    if (!dir) return -1;
+    char *slash = strrchr(dir, '/');
+    if (slash) *slash = '\0';
+    int fd = inotify_init1(IN_CLOEXEC);
+    if (fd >= 0 && inotify_add_watch(fd, dir, IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO | IN_DELETE) < 0) {
+        close(fd);
+        fd = -1;
+    }
+    utils_free(dir);
+    return fd;
+}
+#endif
+
+int notify_run_reminders(void) {
+    // The timer follows the wall clock, which a pinned app clock never reaches
+    if (app_clock_is_fixed()) {
+        fprintf(stderr, "Reminders need the system clock; unset SMARTODO_NOW.\n");
+        return 1;
+    }
+
+    ReminderLoop loop = {0};
+    loop.tasks_path = storage_tasks_path();
+    loop.journal_path = storage_path(JOURNAL_FILE);
+    loop.queue = reminder_queue_create();
+    if (!loop.tasks_path || !loop.journal_path || !loop.queue) {
+        fprintf(stderr, "Failed to initialize reminders.\n");
+        utils_free(loop.tasks_path);
+        utils_free(loop.journal_path);
+        reminder_queue_free(loop.queue);
+        return 1;
+    }
+
+    int watch_fd = -1;
+#ifdef __linux__
+    watch_fd = open_watch(loop.tasks_path);
+#endif
+
+    app_clock_tick();
+    loop.watermark = app_clock_now();
+    int rc = load_reminders(&loop);
+    if (rc == 0) {
+        printf("Watching %zu reminder(s). Press Ctrl-C to stop.\n", reminder_queue_size(loop.queue));
+        fflush(stdout);
+    }
+
+    while (rc == 0) {
+        int woke = reminder_queue_wait(loop.queue, watch_fd, app_clock_now(),
+                                       watch_fd >= 0 ? -1 : NOTIFY_POLL_MS);
+        if (woke < 0) {
+            rc = -1;
+            break;
+        }
+        if (woke == 2) {
+            // Drain pending events; the file check below decides on reloading
+            char events[4096];
+            if (read(watch_fd, events, sizeof(events)) < 0 && errno != EINTR) {
+                rc = -1;
+                break;
+            }
+        }
+
+        app_clock_tick();
+        time_t now = app_clock_now();
+        if (tasks_file_changed(&loop)) rc = load_reminders(&loop);
+        reminder_queue_pop_due(loop.queue, now, on_reminder, NULL);
+        if (now > loop.watermark) loop.watermark = now;
+    }
+
+    fprintf(stderr, "Reminder loop stopped after an error.\n");
+    if (watch_fd >= 0) close(watch_fd);
+    reminder_queue_free(loop.queue);
+    storage_free_tasks(loop.tasks, loop.count);
+    utils_free(loop.tasks_path);
+    utils_free(loop.journal_path);
+    return 1;
+}
@@ -0,0 +1,28 @@
+#ifndef TODO_APP_NOTIFY_H
+#define TODO_APP_NOTIFY_H
+
+/**
+ * Environment variable naming a shell command used to deliver notifications.
+ * The command runs under /bin/sh with the title as $1 and the message as $2,
+ * e.g. SMARTODO_NOTIFY_CMD='notify-send "$1" "$2"'. When unset, notifications
+ * are printed to the terminal.
+ */
+#define NOTIFY_CMD_ENV "SMARTODO_NOTIFY_CMD"
+
+/**
+ * Deliver a notification through the configured command or the terminal.
+ * @param title Short title
+ * @param message Notification text
+ * @return 0 on success, -1 if the command could not be run or failed
+ */
+int notify_send(const char *title, const char *message);
+
+/**
+ * Run the reminder loop: schedule a reminder for every pending task with a
+ * due date and notify as each one fires. The tasks file is reloaded when it
+ * changes. Only reminders after the loop starts are delivered.
+ * @return Exit status (does not return unless an error occurs)
+ */
+int notify_run_reminders(void);
+
+#endif // TODO_APP_NOTIFY_H
@@ -0,0 +1,276 @@
+#include "recurrence.h"
+#include "utils.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+// Upper bound on candidate periods examined per lookup
+#define MAX_PERIOD_STEPS 1000
+
+static const char *WEEKDAY_CODES[7] = {"SU", "MO", "TU", "WE", "TH", "FR", "SA"};
+
+// Helper: weekday of a day number (0 = Sunday); 1970-01-01 was a Thursday
+static int weekday_of(long long day) {
+    long long w = (day + 4) % 7;
+    return (int)(w < 0 ? w + 7 : w);
+}
+
+// Helper: parse a positive integer field; returns -1 on error
+static int parse_positive(const char *s, size_t len) {
+    if (len == 0 || len > 6) return -1;
+    int v = 0;
+    for (size_t i = 0; i < len; ++i) {
+        if (!isdigit((unsigned char)s[i])) return -1;
+        v = v * 10 + (s[i] - '0');
+    }
+    return v;
+}
+
+// Helper: parse "every N unit" and the single-word shorthands
+static int parse_shorthand(const char *s, Recurrence *r) {
+    if (strcasecmp(s, "daily") == 0) { r->freq = RECUR_DAILY; return 0; }
+    if (strcasecmp(s, "weekly") == 0) { r->freq = RECUR_WEEKLY; return 0; }
+    if (strcasecmp(s, "monthly") == 0) { r->freq = RECUR_MONTHLY; return 0; }
+    if (strcasecmp(s, "yearly") == 0 || strcasecmp(s, "annually") == 0) { r->freq = RECUR_YEARLY; return 0; }
+    if (strcasecmp(s, "weekdays") == 0) {
+        r->freq = RECUR_WEEKLY;
+        r->byday = 0x3E; // MO-FR
+        return 0;
+    }
+
+    int n = 0;
+    char unit[16];
+    if (sscanf(s, "every %d %15s", &n, unit) != 2 || n < 1 || n > 999) return -1;
+    size_t len = strlen(unit);
+    if (len > 1 && tolower((unsigned char)unit[len - 1]) == 's') unit[len - 1] = '\0';
+    if (strcasecmp(unit, "day") == 0) r->freq = RECUR_DAILY;
+    else if (strcasecmp(unit, "week") == 0) r->freq = RECUR_WEEKLY;
+    else if (strcasecmp(unit, "month") == 0) r->freq = RECUR_MONTHLY;
+    else if (strcasecmp(unit, "year") == 0) r->freq = RECUR_YEARLY;
+    else return -1;
+    r->interval = n;
+    return 0;
+}
+
+// Helper: apply one KEY=VALUE part of an RRULE
+static int parse_rrule_part(const char *key, size_t key_len, const char *val, size_t val_len,
+                            Recurrence *r, bool *has_freq) {
+    if (key_len == 4 && strncasecmp(key, "FREQ", 4) == 0) {
+        if (val_len == 5 && strncasecmp(val, "DAILY", 5) == 0) r->freq = RECUR_DAILY;
+        else if (val_len == 6 && strncasecmp(val, "WEEKLY", 6) == 0) r->freq = RECUR_WEEKLY;
+        else if (val_len == 7 && strncasecmp(val, "MONTHLY", 7) == 0) r->freq = RECUR_MONTHLY;
+        else if (val_len == 6 && strncasecmp(val, "YEARLY", 6) == 0) r->freq = RECUR_YEARLY;
+        else return -1;
+        *has_freq = true;
+        return 0;
+    }
+    if (key_len == 8 && strncasecmp(key, "INTERVAL", 8) == 0) {
+        r->interval = parse_positive(val, val_len);
+        return r->interval >= 1 && r->interval <= 999 ? 0 : -1;
+    }
+    if (key_len == 5 && strncasecmp(key, "COUNT", 5) == 0) {
+        r->count = parse_positive(val, val_len);
+        return r->count >= 1 ? 0 : -1;
+    }
+    if (key_len == 10 && strncasecmp(key, "BYMONTHDAY", 10) == 0) {
+        if (val_len == 2 && strncmp(val, "-1", 2) == 0) {
+            r->bymonthday = -1;
+            return 0;
+        }
+        r->bymonthday = parse_positive(val, val_len);
+        return r->bymonthday >= 1 && r->bymonthday <= 31 ? 0 : -1;
+    }
+    if (key_len == 5 && strncasecmp(key, "UNTIL", 5) == 0) {
+        // YYYYMMDD, optionally followed by THHMMSS[Z]; only the date is used
+        if (val_len < 8) return -1;
+        int y = parse_positive(val, 4), m = parse_positive(val + 4, 2), d = parse_positive(val + 6, 2);
+        if (y < 1970 || m < 1 || m > 12 || d < 1 || d > utils_days_in_month(y, m)) return -1;
+        if (val_len > 8 && (val[8] != 'T' || val_len > 16)) return -1;
+        r->until_day = utils_days_from_civil(y, m, d);
+        return 0;
+    }
+    if (key_len == 5 && strncasecmp(key, "BYDAY", 5) == 0) {
+        r->byday = 0;
+        size_t i = 0;
+        while (i < val_len) {
+            if (i + 2 > val_len) return -1;
+            int found = -1;
+            for (int w = 0; w < 7; ++w) {
+                if (strncasecmp(val + i, WEEKDAY_CODES[w], 2) == 0) found = w;
+            }
+            if (found < 0) return -1;
+            r->byday |= 1u << found;
+            i += 2;
+            if (i < val_len && val[i++] != ',') return -1;
+        }
+        return r->byday ? 0 : -1;
+    }
+    if (key_len == 4 && strncasecmp(key, "WKST", 4) == 0) {
+        return val_len == 2 && strncasecmp(val, "MO", 2) == 0 ? 0 : -1; // Only Monday weeks
+    }
+    return -1; // Unsupported part
+}
+
+int recurrence_parse(const char *s, Recurrence *out) {
+    if (!s || !out) return -1;
+    while (isspace((unsigned char)*s)) s++;
+    if (*s == '\0') return -1;
+
+    Recurrence r = {.freq = RECUR_DAILY, .interval = 1};
+
+    if (!strchr(s, '=')) {
+        if (parse_shorthand(s, &r) != 0) return -1;
+        *out = r;
+        return 0;
+    }
+
+    if (strncasecmp(s, "RRULE:", 6) == 0) s += 6;
+
+    bool has_freq = false;
+    const char *p = s;
+    while (*p) {
+        const char *end = strchr(p, ';');
+        size_t part_len = end ? (size_t)(end - p) : strlen(p);
+        const char *eq = memchr(p, '=', part_len);
+        if (!eq) return -1;
+        if (parse_rrule_part(p, (size_t)(eq - p), eq + 1, part_len - (size_t)(eq - p) - 1, &r, &has_freq) != 0) {
+            return -1;
+        }
+        p += part_len;
+        if (*p == ';') p++;
+    }
+
+    if (!has_freq) return -1;
+    if (r.byday && r.freq != RECUR_DAILY && r.freq != RECUR_WEEKLY) return -1;
+    if (r.bymonthday && r.freq != RECUR_MONTHLY) return -1;
+
+    *out = r;
+    return 0;
+}
+
+char *recurrence_format(const Recurrence *r, char *buf, size_t size) {
+    static const char *FREQ_NAMES[] = {"DAILY", "WEEKLY", "MONTHLY", "YEARLY"};
+    if (!r || !buf || size == 0) return NULL;
+
+    int n = snprintf(buf, size, "FREQ=%s", FREQ_NAMES[r->freq]);
+    size_t len = n > 0 ? (size_t)n : 0;
+
+    if (r->interval > 1 && len < size) {
+        len += snprintf(buf + len, size - len, ";INTERVAL=%d", r->interval);
+    }
+    if (r->byday && len < size) {
+        len += snprintf(buf + len, size - len, ";BYDAY=");
+        bool first = true;
+        // Emit in Monday-first order to match the week start
+        for (int i = 1; i <= 7 && len < size; ++i) {
+            int w = i % 7;
+            if (!(r->byday & (1u << w))) continue;
+            len += snprintf(buf + len, size - len, "%s%s", first ? "" : ",", WEEKDAY_CODES[w]);
+            first = false;
+        }
+    }
+    if (r->bymonthday && len < size) {
+        len += snprintf(buf + len, size - len, ";BYMONTHDAY=%d", r->bymonthday);
+    }
+    if (r->count > 0 && len < size) {
+        len += snprintf(buf + len, size - len, ";COUNT=%d", r->count);
+    }
+    if (r->until_day > 0 && len < size) {
+        int y, m, d;
+        utils_civil_from_days(r->until_day, &y, &m, &d);
+        len += snprintf(buf + len, size - len, ";UNTIL=%04d%02d%02d", y, m, d);
+    }
+
+    return len < size ? buf : NULL;
+}
+
+// Helper: first occurrence on or after `start`, ignoring COUNT and UNTIL
+static bool next_candidate(const Recurrence *r, long long anchor, long long start, long long *out) {
+    if (start < anchor) start = anchor;
+    long long interval = r->interval > 0 ? r->interval : 1;
+
+    switch (r->freq) {
+        case RECUR_DAILY: {
+            long long k = (start - anchor + interval - 1) / interval;
+            long long day = anchor + k * interval;
+            // With BYDAY the weekday pattern repeats after at most 7 steps
+            for (int i = 0; i < 7; ++i, day += interval) {
+                if (!r->byday || (r->byday & (1u << weekday_of(day)))) {
+                    *out = day;
+                    return true;
+                }
+            }
+            return false;
+        }
+        case RECUR_WEEKLY: {
+            unsigned mask = r->byday ? r->byday : 1u << weekday_of(anchor);
+            long long anchor_week = anchor - (weekday_of(anchor) + 6) % 7; // Monday
+            long long week = start - (weekday_of(start) + 6) % 7;
+            long long offset = (week - anchor_week) / 7 % interval;
+            if (offset != 0) week += (interval - offset) * 7;
+            for (int steps = 0; steps < MAX_PERIOD_STEPS; ++steps, week += interval * 7) {
+                for (int i = 0; i < 7; ++i) {
+                    long long day = week + i;
+                    if (day >= start && (mask & (1u << weekday_of(day)))) {
+                        *out = day;
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+        case RECUR_MONTHLY:
+        case RECUR_YEARLY: {
+            int ay, am, ad, sy, sm, sd;
+            utils_civil_from_days(anchor, &ay, &am, &ad);
+            utils_civil_from_days(start, &sy, &sm, &sd);
+            long long step = r->freq == RECUR_YEARLY ? 12 * interval : interval;
+            int target = r->freq == RECUR_MONTHLY && r->bymonthday ? r->bymonthday : ad;
+
+            long long months = (long long)(sy - ay) * 12 + (sm - am);
+            long long k = months > 0 ? months / step : 0;
+            for (int steps = 0; steps < MAX_PERIOD_STEPS; ++steps, ++k) {
+                long long total = (long long)(am - 1) + k * step;
+                int y = ay + (int)(total / 12);
+                int m = (int)(total % 12) + 1;
+                int dim = utils_days_in_month(y, m);
+                int d = target == -1 ? dim : target;
+                if (d > dim) continue; // Month lacks this day (e.g. the 31st, Feb 29)
+                long long day = utils_days_from_civil(y, m, d);
+                if (day >= start) {
+                    *out = day;
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+    return false;
+}
+
+bool recurrence_next(const Recurrence *r, long long anchor_day, long long after_day, long long *next_day) {
+    if (!r || !next_day) return false;
+
+    long long day;
+    if (r->count > 0) {
+        // COUNT is measured from the anchor, so walk the series in order
+        long long cur = anchor_day - 1;
+        for (int i = 0; i < r->count; ++i) {
+            if (!next_candidate(r, anchor_day, cur + 1, &day)) return false;
+            if (r->until_day > 0 && day > r->until_day) return false;
+            if (day > after_day) {
+                *next_day = day;
+                return true;
+            }
+            cur = day;
+        }
+        return false;
+    }
+
+    if (!next_candidate(r, anchor_day, after_day + 1, &day)) return false;
+    if (r->until_day > 0 && day > r->until_day) return false;
+    *next_day = day;
+    return true;
+}
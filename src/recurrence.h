@@ -0,0 +1,78 @@
+#ifndef RECURRENCE_H
+#define RECURRENCE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Maximum length of a canonical rule string from recurrence_format
+#define RECURRENCE_MAX_LEN 96
+
+// Recurrence frequency
+typedef enum {
+    RECUR_DAILY,
+    RECUR_WEEKLY,
+    RECUR_MONTHLY,
+    RECUR_YEARLY
+} RecurFreq;
+
+/**
+ * @brief Parsed recurrence rule (subset of RFC 5545 RRULE)
+ *
+ * Occurrences are calendar days counted from an anchor day (the template
+ * task's current due date). Weeks start on Monday.
+ */
+typedef struct {
+    RecurFreq freq;
+    int interval;          // Every N periods (>= 1)
+    unsigned byday;        // Weekday bitmask, bit 0 = Sunday; 0 if unset (DAILY/WEEKLY only)
+    int bymonthday;        // Day of month 1-31, -1 for the last day, 0 if unset (MONTHLY only)
+    int count;             // Occurrences remaining including the anchor, 0 for unlimited
+    long long until_day;   // Last allowed day (days since 1970-01-01), 0 if unset
+} Recurrence;
+
+/**
+ * @brief Parses a recurrence rule
+ *
+ * Accepts the shorthands "daily", "weekly", "monthly", "yearly", "weekdays",
+ * "every N days|weeks|months|years", and RRULE strings using FREQ, INTERVAL,
+ * BYDAY (e.g. MO,WE), BYMONTHDAY, COUNT and UNTIL (YYYYMMDD), with or
+ * without an "RRULE:" prefix.
+ *
+ * @param s Rule text
+ * @param out Parsed rule
+ * @return int 0 on success, -1 if the rule is invalid or unsupported
+ */
+int recurrence_parse(const char *s, Recurrence *out);
+
+/**
+ * @brief Formats a rule as a canonical RRULE string
+ *
+ * @param r The rule
+ * @param buf Output buffer (RECURRENCE_MAX_LEN bytes is always enough)
+ * @param size Size of buf
+ * @return char* buf, or NULL if buf is too small
+ */
+char *recurrence_format(const Recurrence *r, char *buf, size_t size);
+
+/**
+ * @brief Finds the first occurrence after a given day
+ *
+ * Only the occurrences needed are computed; nothing is expanded up front.
+ *
+ * @param r The rule
+ * @param anchor_day Day of the first occurrence (days since 1970-01-01)
+ * @param after_day Return the first occurrence strictly after this day
+ * @param next_day[out] The occurrence
+ * @return bool True if found, false if the series ended (COUNT/UNTIL)
+ */
+bool recurrence_next(const Recurrence *r, long long anchor_day, long long after_day, long long *next_day);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RECURRENCE_H
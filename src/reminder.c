@@ -0,0 +1,319 @@
+// poll() and struct itimerspec are POSIX, not ISO C
+#define _POSIX_C_SOURCE 200809L
+
+#include "reminder.h"
+#include "utils.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/timerfd.h>
+#endif
+
+// Initial capacities; both tables grow by doubling
+#define REMINDER_INITIAL_HEAP 16
+#define REMINDER_INITIAL_SLOTS 32
+
+typedef struct {
+    char *key;
+    uint64_t hash;
+    time_t fire_at;
+    void *data;
+    size_t pos;       // Index in the heap
+} ReminderEntry;
+
+struct ReminderQueue {
+    ReminderEntry **heap;     // Min-heap ordered by fire_at
+    size_t count;
+    size_t heap_cap;
+    ReminderEntry **slots;    // Open-addressing index by key (linear probing)
+    size_t slot_cap;          // Power of two, kept at least twice count
+    int timer_fd;             // timerfd on Linux, -1 elsewhere
+    time_t armed_at;          // Fire time the timer is armed for, 0 if disarmed
+};
+
+// Helper: index slot holding key, or the empty slot where it would go
+static size_t find_slot(const ReminderQueue *q, const char *key, uint64_t hash) {
+    size_t mask = q->slot_cap - 1;
+    size_t i = (size_t)hash & mask;
+    while (q->slots[i]) {
+        if (q->slots[i]->hash == hash && strcmp(q->slots[i]->key, key) == 0) break;
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+// Helper: double the index size and reinsert all entries
+static int grow_slots(ReminderQueue *q) {
+    size_t new_cap = q->slot_cap * 2;
+    ReminderEntry **slots = utils_calloc(new_cap, sizeof(ReminderEntry *));
+    if (!slots) return -1;
+    for (size_t i = 0; i < q->count; i++) {
+        ReminderEntry *e = q->heap[i];
+        size_t j = (size_t)e->hash & (new_cap - 1);
+        while (slots[j]) j = (j + 1) & (new_cap - 1);
+        slots[j] = e;
+    }
+    utils_free(q->slots);
+    q->slots = slots;
+    q->slot_cap = new_cap;
+    return 0;
+}
+
+// Helper: remove the entry in slot i, shifting later probes back into the gap
+static void remove_slot(ReminderQueue *q, size_t i) {
+    size_t mask = q->slot_cap - 1;
+    q->slots[i] = NULL;
+    size_t j = i;
+    for (;;) {
+        j = (j + 1) & mask;
+        if (!q->slots[j]) break;
+        size_t home = (size_t)q->slots[j]->hash & mask;
+        // Move the entry only if its home slot does not lie in (i, j]
+        bool in_range = (i <= j) ? (home > i && home <= j) : (home > i || home <= j);
+        if (!in_range) {
+            q->slots[i] = q->slots[j];
+            q->slots[j] = NULL;
+            i = j;
+        }
+    }
+}
+
+// Helper: place an entry at heap index i
+static void heap_set(ReminderQueue *q, size_t i, ReminderEntry *e) {
+    q->heap[i] = e;
+    e->pos = i;
+}
+
+// Helper: move the entry at i towards the root
+static void sift_up(ReminderQueue *q, size_t i) {
+    ReminderEntry *e = q->heap[i];
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (q->heap[parent]->fire_at <= e->fire_at) break;
+        heap_set(q, i, q->heap[parent]);
+        i = parent;
+    }
+    heap_set(q, i, e);
+}
+
+// Helper: move the entry at i towards the leaves
+static void sift_down(ReminderQueue *q, size_t i) {
+    ReminderEntry *e = q->heap[i];
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= q->count) break;
+        if (child + 1 < q->count && q->heap[child + 1]->fire_at < q->heap[child]->fire_at) child++;
+        if (e->fire_at <= q->heap[child]->fire_at) break;
+        heap_set(q, i, q->heap[child]);
+        i = child;
+    }
+    heap_set(q, i, e);
+}
+
+// Helper: take an entry out of the heap without touching the index
+static void heap_remove(ReminderQueue *q, size_t i) {
+    q->count--;
+    if (i == q->count) return;
+    heap_set(q, i, q->heap[q->count]);
+    if (i > 0 && q->heap[(i - 1) / 2]->fire_at > q->heap[i]->fire_at) {
+        sift_up(q, i);
+    } else {
+        sift_down(q, i);
+    }
+}
+
+static void entry_free(ReminderEntry *e) {
+    utils_free(e->key);
+    utils_free(e);
+}
+
+ReminderQueue *reminder_queue_create(void) {
+    ReminderQueue *q = utils_calloc(1, sizeof(ReminderQueue));
+    if (!q) return NULL;
+    q->heap = utils_malloc(REMINDER_INITIAL_HEAP * sizeof(ReminderEntry *));
+    q->slots = utils_calloc(REMINDER_INITIAL_SLOTS, sizeof(ReminderEntry *));
+    if (!q->heap || !q->slots) {
+        utils_free(q->heap);
+        utils_free(q->slots);
+        utils_free(q);
+        return NULL;
+    }
+    q->heap_cap = REMINDER_INITIAL_HEAP;
+    q->slot_cap = REMINDER_INITIAL_SLOTS;
+    q->timer_fd = -1;
+    return q;
+}
+
+void reminder_queue_free(ReminderQueue *q) {
+    if (!q) return;
+    reminder_queue_clear(q);
+    if (q->timer_fd >= 0) close(q->timer_fd);
+    utils_free(q->heap);
+    utils_free(q->slots);
+    utils_free(q);
+}
+
+int reminder_queue_schedule(ReminderQueue *q, const char *key, time_t fire_at, void *data) {
+    if (!q || !key) return -1;
+    uint64_t hash = utils_fnv1a_str(key);
+    size_t slot = find_slot(q, key, hash);
+    ReminderEntry *e = q->slots[slot];
+    if (e) {
+        // Reschedule in place
+        time_t old = e->fire_at;
+        e->fire_at = fire_at;
+        e->data = data;
+        if (fire_at < old) sift_up(q, e->pos);
+        else if (fire_at > old) sift_down(q, e->pos);
+        return 0;
+    }
+
+    if (q->count == q->heap_cap) {
+        ReminderEntry **heap = utils_realloc(q->heap, q->heap_cap * 2 * sizeof(ReminderEntry *));
+        if (!heap) return -1;
+        q->heap = heap;
+        q->heap_cap *= 2;
+    }
+    if ((q->count + 1) * 2 > q->slot_cap) {
+        if (grow_slots(q) != 0) return -1;
+        slot = find_slot(q, key, hash);
+    }
+
+    e = utils_malloc(sizeof(ReminderEntry));
+    if (!e) return -1;
+    e->key = utils_strdup(key);
+    if (!e->key) {
+        utils_free(e);
+        return -1;
+    }
+    e->hash = hash;
+    e->fire_at = fire_at;
+    e->data = data;
+    q->slots[slot] = e;
+    q->heap[q->count] = e;
+    e->pos = q->count++;
+    sift_up(q, e->pos);
+    return 0;
+}
+
+int reminder_queue_cancel(ReminderQueue *q, const char *key) {
+    if (!q || !key) return -1;
+    size_t slot = find_slot(q, key, utils_fnv1a_str(key));
+    ReminderEntry *e = q->slots[slot];
+    if (!e) return -1;
+    remove_slot(q, slot);
+    heap_remove(q, e->pos);
+    entry_free(e);
+    return 0;
+}
+
+void reminder_queue_clear(ReminderQueue *q) {
+    if (!q) return;
+    for (size_t i = 0; i < q->count; i++) entry_free(q->heap[i]);
+    q->count = 0;
+    memset(q->slots, 0, q->slot_cap * sizeof(ReminderEntry *));
+}
+
+size_t reminder_queue_size(const ReminderQueue *q) {
+    return q ? q->count : 0;
+}
+
+bool reminder_queue_peek(const ReminderQueue *q, time_t *out) {
+    if (!q || q->count == 0) return false;
+    if (out) *out = q->heap[0]->fire_at;
+    return true;
+}
+
+size_t reminder_queue_pop_due(ReminderQueue *q, time_t now, ReminderFireFn fn, void *user) {
+    size_t fired = 0;
+    while (q && q->count > 0 && q->heap[0]->fire_at <= now) {
+        ReminderEntry *e = q->heap[0];
+        remove_slot(q, find_slot(q, e->key, e->hash));
+        heap_remove(q, 0);
+        if (fn) fn(e->key, e->fire_at, e->data, user);
+        entry_free(e);
+        fired++;
+    }
+    return fired;
+}
+
+#ifdef __linux__
+// Helper: arm the timerfd for the earliest reminder (absolute wall-clock
+// time, cancelled if the clock is set so the caller can re-check)
+static int arm_timer(ReminderQueue *q) {
+    if (q->timer_fd < 0) {
+        q->timer_fd = timerfd_create(CLOCK_REALTIME, TFD_CLOEXEC);
+        if (q->timer_fd < 0) return -1;
+        q->armed_at = 0;
+    }
+    time_t next = 0;
+    reminder_queue_peek(q, &next);
+    if (next == q->armed_at) return 0;
+
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    // A zero it_value disarms; fire times at or before the epoch fire at once
+    its.it_value.tv_sec = next > 0 ? next : (q->count > 0 ? 1 : 0);
+    if (timerfd_settime(q->timer_fd, TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET, &its, NULL) != 0) {
+        return -1;
+    }
+    q->armed_at = next;
+    return 0;
+}
+#endif
+
+int reminder_queue_wait(ReminderQueue *q, int extra_fd, time_t now, int timeout_ms) {
+    if (!q) return -1;
+    struct pollfd fds[2];
+    nfds_t nfds = 0;
+    int timer_idx = -1;
+    int extra_idx = -1;
+    int wait_ms = timeout_ms;
+    bool reminder_bound = false;
+
+#ifdef __linux__
+    if (arm_timer(q) == 0) {
+        fds[nfds].fd = q->timer_fd;
+        fds[nfds].events = POLLIN;
+        timer_idx = (int)nfds++;
+    }
+#endif
+    if (timer_idx < 0) {
+        // No timer: bound the wait by the earliest reminder
+        time_t next;
+        if (reminder_queue_peek(q, &next)) {
+            if (next <= now) return 1;
+            long long ms = (long long)(next - now) * 1000;
+            if (ms > INT_MAX) ms = INT_MAX;
+            if (wait_ms < 0 || ms < wait_ms) {
+                wait_ms = (int)ms;
+                reminder_bound = true;
+            }
+        }
+    }
+    if (extra_fd >= 0) {
+        fds[nfds].fd = extra_fd;
+        fds[nfds].events = POLLIN;
+        extra_idx = (int)nfds++;
+    }
+
+    int rc = poll(fds, nfds, wait_ms);
+    if (rc < 0) return errno == EINTR ? 0 : -1;
+    if (extra_idx >= 0 && (fds[extra_idx].revents & POLLIN)) return 2;
+    if (timer_idx >= 0) {
+        if (fds[timer_idx].revents & POLLIN) {
+            // Drain the expiration count; ECANCELED means the clock was set
+            uint64_t expirations;
+            if (read(q->timer_fd, &expirations, sizeof(expirations)) < 0 && errno != ECANCELED) return -1;
+            q->armed_at = 0;
+            return 1;
+        }
+        return 0;
+    }
+    return rc == 0 && reminder_bound ? 1 : 0;
+}
@@ -0,0 +1,98 @@
+#ifndef TODO_APP_REMINDER_H
+#define TODO_APP_REMINDER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+/**
+ * Reminder queue: a binary min-heap of fire times with a key index, so
+ * scheduling, rescheduling and cancelling a reminder are O(log n).
+ * On Linux the queue owns one timerfd that is armed for the earliest
+ * reminder; elsewhere waiting falls back to poll() with a timeout.
+ */
+typedef struct ReminderQueue ReminderQueue;
+
+/**
+ * Callback invoked for each reminder that fires.
+ * @param key Key the reminder was scheduled under
+ * @param fire_at Scheduled fire time
+ * @param data User data passed to reminder_queue_schedule()
+ * @param user User pointer passed to reminder_queue_pop_due()
+ */
+typedef void (*ReminderFireFn)(const char *key, time_t fire_at, void *data, void *user);
+
+/**
+ * Create an empty reminder queue.
+ * @return New queue, or NULL on allocation failure
+ */
+ReminderQueue *reminder_queue_create(void);
+
+/**
+ * Free a reminder queue and close its timer.
+ * @param q The queue (may be NULL)
+ */
+void reminder_queue_free(ReminderQueue *q);
+
+/**
+ * Schedule a reminder, or move an existing reminder with the same key.
+ * @param q The queue
+ * @param key Reminder key, e.g. a task id (copied)
+ * @param fire_at Time the reminder fires
+ * @param data User data returned when the reminder fires
+ * @return 0 on success, -1 on error
+ */
+int reminder_queue_schedule(ReminderQueue *q, const char *key, time_t fire_at, void *data);
+
+/**
+ * Cancel the reminder scheduled under a key.
+ * @param q The queue
+ * @param key Reminder key
+ * @return 0 if a reminder was removed, -1 if none was scheduled
+ */
+int reminder_queue_cancel(ReminderQueue *q, const char *key);
+
+/**
+ * Remove all reminders.
+ * @param q The queue
+ */
+void reminder_queue_clear(ReminderQueue *q);
+
+/**
+ * Get the number of scheduled reminders.
+ * @param q The queue
+ * @return Number of reminders
+ */
+size_t reminder_queue_size(const ReminderQueue *q);
+
+/**
+ * Get the fire time of the earliest reminder.
+ * @param q The queue
+ * @param out[out] Earliest fire time
+ * @return true if the queue is not empty
+ */
+bool reminder_queue_peek(const ReminderQueue *q, time_t *out);
+
+/**
+ * Remove and fire every reminder due at or before now, earliest first.
+ * @param q The queue
+ * @param now Current time
+ * @param fn Callback for each fired reminder (may be NULL)
+ * @param user User pointer passed to fn
+ * @return Number of reminders fired
+ */
+size_t reminder_queue_pop_due(ReminderQueue *q, time_t now, ReminderFireFn fn, void *user);
+
+/**
+ * Sleep until the earliest reminder is due, an extra descriptor becomes
+ * readable, or the timeout expires. Nothing wakes the caller in between.
+ * @param q The queue
+ * @param extra_fd Additional descriptor to watch, or -1
+ * @param now Current time, used to compute the fallback timeout
+ * @param timeout_ms Upper bound on the wait in milliseconds, or -1 for none
+ * @return 1 if a reminder may be due, 2 if extra_fd is readable,
+ *         0 on timeout, -1 on error
+ */
+int reminder_queue_wait(ReminderQueue *q, int extra_fd, time_t now, int timeout_ms);
+
+#endif // TODO_APP_REMINDER_H
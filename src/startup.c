@@ -0,0 +1,49 @@
+// clock_gettime() is POSIX, not ISO C
+#define _POSIX_C_SOURCE 200809L
+
+#include "startup.h"
+#include <time.h>
+
+typedef struct {
+    const char *phase;
+    double at;            // ms since startup_profile_enable()
+} StartupMark;
+
+static bool enabled = false;
+static double origin = 0;
+static StartupMark marks[STARTUP_MAX_PHASES];
+static int mark_count = 0;
+
+// Helper: monotonic time in ms
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+void startup_profile_enable(void) {
+    enabled = true;
+    origin = now_ms();
+    mark_count = 0;
+}
+
+bool startup_profile_enabled(void) {
+    return enabled;
+}
+
+void startup_mark(const char *phase) {
+    if (!enabled || mark_count >= STARTUP_MAX_PHASES) return;
+    marks[mark_count].phase = phase;
+    marks[mark_count].at = now_ms() - origin;
+    mark_count++;
+}
+
+void startup_report(FILE *out) {
+    fprintf(out, "%-20s %10s %10s\n", "phase", "start ms", "took ms");
+    double prev = 0;
+    for (int i = 0; i < mark_count; i++) {
+        fprintf(out, "%-20s %10.2f %10.2f\n", marks[i].phase, prev, marks[i].at - prev);
+        prev = marks[i].at;
+    }
+    fprintf(out, "%-20s %10s %10.2f\n", "total", "", prev);
+}
@@ -0,0 +1,42 @@
+#ifndef TODO_APP_STARTUP_H
+#define TODO_APP_STARTUP_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+/**
+ * Startup timeline. `smartodo --startup-profile` starts the TUI as usual,
+ * marks the end of each startup phase (UI init, first paint, projects,
+ * reading the tasks, painting the current project, the whole set, the
+ * first full frame) and then prints how long each took and exits.
+ */
+
+#define STARTUP_PROFILE_FLAG "--startup-profile"
+
+// Most phases recorded
+#define STARTUP_MAX_PHASES 32
+
+/**
+ * Start the timeline; phases are measured from this call.
+ */
+void startup_profile_enable(void);
+
+/**
+ * Whether the timeline is being recorded
+ * @return true after startup_profile_enable()
+ */
+bool startup_profile_enabled(void);
+
+/**
+ * Mark the end of a phase, which began at the previous mark.
+ * @param phase Phase name (string literal)
+ */
+void startup_mark(const char *phase);
+
+/**
+ * Print the timeline: each phase with its start and duration in ms.
+ * @param out Stream to print to
+ */
+void startup_report(FILE *out);
+
+#endif // TODO_APP_STARTUP_H
@@ -0,0 +1,813 @@
+// getline(), fileno() and gmtime_r() are POSIX, not ISO C
+#define _POSIX_C_SOURCE 200809L
+
+#include "stats.h"
+#include "history.h"
+#include "journal.h"
+#include "storage.h"
+#include "utils.h"
+#include "app_clock.h"
+#include <cjson/cJSON.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// Day number of a task without a due date
+#define NO_DAY LONG_MIN
+
+// What the aggregates remember of one task
+typedef struct {
+    char *id;
+    char *project;
+    bool pending;
+    bool gone;           // Deleted; the entry is kept so the id's slot stays valid
+    bool recur;
+    time_t created;
+    time_t due;
+    long due_day;        // Day the task is due, or NO_DAY
+    unsigned hash;       // Content apart from the due value (recurring tasks only)
+} StatsTask;
+
+// Counts for one day and project
+typedef struct {
+    long day;
+    char *project;
+    unsigned opened;
+    unsigned closed;
+    unsigned completed;
+    unsigned lead_count;
+    long long lead_sum;  // Seconds
+} StatsBucket;
+
+// Pending tasks overdue as a day began
+typedef struct {
+    long day;
+    unsigned count;
+} StatsOverdue;
+
+// The aggregates, as stored in stats.json
+typedef struct {
+    unsigned long long seq;     // Newest journal record folded in
+    long long offset;           // Journal offset after that record
+    long sampled;               // Newest day with an overdue count
+    StatsTask *tasks;
+    size_t task_count, task_cap;
+    size_t *slots;              // Open addressing: id -> index + 1
+    size_t slot_cap;
+    StatsBucket *buckets;
+    size_t bucket_count, bucket_cap;
+    StatsOverdue *overdue;
+    size_t overdue_count, overdue_cap;
+} Stats;
+
+// Helper: day a task is due; a date-only due holds midnight UTC of its date
+static long due_day(const Task *t) {
+    if (t->due == 0) return NO_DAY;
+    if (t->due_kind != DUE_DATE) return app_clock_local_day(t->due);
+    struct tm tm = {0};
+    gmtime_r(&t->due, &tm);
+    return (long)utils_days_from_civil(tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+}
+
+// Helper: hash of a task without its due value, to tell a completed
+// occurrence (only the due moves on) from an edit
+static unsigned content_hash(const Task *t) {
+    cJSON *obj = task_to_cjson(t);
+    cJSON_DeleteItemFromObject(obj, "due");
+    cJSON_DeleteItemFromObject(obj, "due_kind");
+    cJSON_DeleteItemFromObject(obj, "due_tz");
+    char *text = obj ? cJSON_PrintUnformatted(obj) : NULL;
+    cJSON_Delete(obj);
+    // 32 bits so the hash survives a JSON number
+    unsigned h = text ? utils_fnv1a32_str(text) : 0;
+    utils_free(text);
+    return h;
+}
+
+// Helper: rebuild the id index at twice the task capacity
+static int index_rebuild(Stats *s) {
+    size_t cap = 64;
+    while (cap < 2 * (s->task_count + 1)) cap *= 2;
+    size_t *slots = utils_calloc(cap, sizeof(size_t));
+    if (!slots) return -1;
+    for (size_t i = 0; i < s->task_count; i++) {
+        size_t slot = utils_fnv1a32_str(s->tasks[i].id) & (cap - 1);
+        while (slots[slot]) slot = (slot + 1) & (cap - 1);
+        slots[slot] = i + 1;
+    }
+    utils_free(s->slots);
+    s->slots = slots;
+    s->slot_cap = cap;
+    return 0;
+}
+
+// Helper: the entry for an id, added (blank, marked gone) if create is set
+static StatsTask *task_get(Stats *s, const char *id, bool create) {
+    if (s->slot_cap) {
+        size_t slot = utils_fnv1a32_str(id) & (s->slot_cap - 1);
+        for (; s->slots[slot]; slot = (slot + 1) & (s->slot_cap - 1)) {
+            StatsTask *st = &s->tasks[s->slots[slot] - 1];
+            if (strcmp(st->id, id) == 0) return st;
+        }
+    }
+    if (!create) return NULL;
+    if (s->task_count == s->task_cap) {
+        size_t cap = s->task_cap ? s->task_cap * 2 : 64;
+        StatsTask *grown = utils_realloc(s->tasks, cap * sizeof(StatsTask));
+        if (!grown) return NULL;
+        s->tasks = grown;
+        s->task_cap = cap;
+    }
+    StatsTask *st = &s->tasks[s->task_count];
+    memset(st, 0, sizeof(*st));
+    if (!(st->id = utils_strdup(id))) return NULL;
+    st->gone = true;
+    s->task_count++;
+    if (2 * s->task_count >= s->slot_cap && index_rebuild(s) == 0) return st;
+    size_t slot = utils_fnv1a32_str(id) & (s->slot_cap - 1);
+    while (s->slots[slot]) slot = (slot + 1) & (s->slot_cap - 1);
+    s->slots[slot] = s->task_count;
+    return st;
+}
+
+// Helper: remember a task's current state
+static int task_set(StatsTask *st, const Task *t) {
+    char *project = utils_strdup(t->project ? t->project : "default");
+    if (!project) return -1;
+    utils_free(st->project);
+    st->project = project;
+    st->pending = t->status == STATUS_PENDING;
+    st->gone = false;
+    st->recur = t->recur != NULL;
+    st->created = t->created;
+    st->due = t->due;
+    st->due_day = due_day(t);
+    st->hash = st->recur ? content_hash(t) : 0;
+    return 0;
+}
+
+// Helper: the bucket for a day and project, added if missing; recent days
+// are at the end, so the search starts there
+static StatsBucket *bucket_get(Stats *s, long day, const char *project) {
+    for (size_t i = s->bucket_count; i-- > 0;) {
+        StatsBucket *b = &s->buckets[i];
+        if (b->day == day && strcmp(b->project, project) == 0) return b;
+        if (b->day < day - 1) break;
+    }
+    if (s->bucket_count == s->bucket_cap) {
+        size_t cap = s->bucket_cap ? s->bucket_cap * 2 : 64;
+        StatsBucket *grown = utils_realloc(s->buckets, cap * sizeof(StatsBucket));
+        if (!grown) return NULL;
+        s->buckets = grown;
+        s->bucket_cap = cap;
+    }
+    StatsBucket *b = &s->buckets[s->bucket_count];
+    memset(b, 0, sizeof(*b));
+    if (!(b->project = utils_strdup(project))) return NULL;
+    b->day = day;
+    s->bucket_count++;
+    return b;
+}
+
+// Helper: count a completion
+static int add_completion(Stats *s, long day, const char *project, time_t at, time_t created, bool recur) {
+    StatsBucket *b = bucket_get(s, day, project);
+    if (!b) return -1;
+    b->completed++;
+    if (!recur && created > 0 && at >= created) {
+        b->lead_count++;
+        b->lead_sum += (long long)(at - created);
+    }
+    return 0;
+}
+
+// Helper: append the overdue count of a day
+static int overdue_append(Stats *s, long day, unsigned count) {
+    if (s->overdue_count == s->overdue_cap) {
+        size_t cap = s->overdue_cap ? s->overdue_cap * 2 : 64;
+        StatsOverdue *grown = utils_realloc(s->overdue, cap * sizeof(StatsOverdue));
+        if (!grown) return -1;
+        s->overdue = grown;
+        s->overdue_cap = cap;
+    }
+    s->overdue[s->overdue_count].day = day;
+    s->overdue[s->overdue_count++].count = count;
+    return 0;
+}
+
+// Helper: record the overdue count for each day up to `through` that has
+// none yet; the tasks have not changed since the last record, so the
+// current state is the state those days began with
+static int fill_overdue(Stats *s, long through) {
+    long from = s->sampled + 1;
+    if (from < through - STATS_MAX_FILL_DAYS + 1) from = through - STATS_MAX_FILL_DAYS + 1;
+    for (long day = from; day <= through; day++) {
+        unsigned count = 0;
+        for (size_t i = 0; i < s->task_count; i++) {
+            const StatsTask *st = &s->tasks[i];
+            if (!st->gone && st->pending && st->due_day != NO_DAY && st->due_day < day) count++;
+        }
+        if (overdue_append(s, day, count) != 0) return -1;
+    }
+    if (through > s->sampled) s->sampled = through;
+    return 0;
+}
+
+// Helper: fold one journal record into the aggregates
+static int apply_record(Stats *s, const cJSON *rec, time_t ts) {
+    long day = app_clock_local_day(ts);
+    if (day > s->sampled && fill_overdue(s, day) != 0) return -1;
+
+    const char *op = cJSON_GetStringValue(cJSON_GetObjectItem(rec, "op"));
+    if (!op) return 0;
+    if (strcmp(op, "del") == 0) {
+        const char *id = cJSON_GetStringValue(cJSON_GetObjectItem(rec, "id"));
+        StatsTask *st = id ? task_get(s, id, false) : NULL;
+        if (!st || st->gone) return 0;
+        st->gone = true;
+        if (!st->pending) return 0;
+        StatsBucket *b = bucket_get(s, day, st->project);
+        if (!b) return -1;
+        b->closed++;
+        return 0;
+    }
+
+    Task *t = task_from_cjson(cJSON_GetObjectItem(rec, "task"));
+    if (!t) return 0;
+    StatsTask *st = task_get(s, t->id, true);
+    if (!st) {
+        task_free(t);
+        return -1;
+    }
+    const char *project = t->project ? t->project : "default";
+    bool pending = t->status == STATUS_PENDING;
+    StatsBucket *b = NULL;
+    int rc = 0;
+    if (st->gone || st->pending != pending || strcmp(st->project, project) != 0) {
+        // Leaving the open tasks of the old project...
+        if (!st->gone && st->pending) {
+            if (!(b = bucket_get(s, day, st->project))) rc = -1;
+            else b->closed++;
+        }
+        // ...and joining those of the new one
+        if (rc == 0 && pending) {
+            if (!(b = bucket_get(s, day, project))) rc = -1;
+            else b->opened++;
+        }
+        if (rc == 0 && !st->gone && st->pending && !pending) {
+            rc = add_completion(s, day, project, ts, t->created, t->recur != NULL);
+        }
+    } else if (pending && st->recur && t->recur && t->due > st->due && content_hash(t) == st->hash) {
+        // A recurring task moves on to its next occurrence when one is completed
+        rc = add_completion(s, day, project, ts, t->created, true);
+    }
+    if (rc == 0) rc = task_set(st, t);
+    task_free(t);
+    return rc;
+}
+
+// Helper: forget every task and remember a task set instead
+static int reset_tasks(Stats *s, Task **tasks, size_t count) {
+    for (size_t i = 0; i < s->task_count; i++) {
+        utils_free(s->tasks[i].id);
+        utils_free(s->tasks[i].project);
+    }
+    s->task_count = 0;
+    utils_free(s->slots);
+    s->slots = NULL;
+    s->slot_cap = 0;
+    for (size_t i = 0; i < count; i++) {
+        StatsTask *st = task_get(s, tasks[i]->id, true);
+        if (!st || task_set(st, tasks[i]) != 0) return -1;
+    }
+    return 0;
+}
+
+static void stats_free(Stats *s) {
+    for (size_t i = 0; i < s->task_count; i++) {
+        utils_free(s->tasks[i].id);
+        utils_free(s->tasks[i].project);
+    }
+    for (size_t i = 0; i < s->bucket_count; i++) utils_free(s->buckets[i].project);
+    utils_free(s->tasks);
+    utils_free(s->slots);
+    utils_free(s->buckets);
+    utils_free(s->overdue);
+    memset(s, 0, sizeof(*s));
+}
+
+// Helper: number at an array index
+static double num_at(const cJSON *arr, int i) {
+    return cJSON_GetNumberValue(cJSON_GetArrayItem(arr, i));
+}
+
+// Helper: read stats.json; returns 1 if read, 0 if there is none yet, -1 on error.
+// Tasks are [id, project, pending, created, due, due_day|null, recur, hash],
+// buckets [day, project, opened, closed, completed, lead_count, lead_sum] and
+// overdue counts [day, count].
+static int stats_load(Stats *s) {
+    memset(s, 0, sizeof(*s));
+    char *path = storage_path(STATS_FILE);
+    size_t len = 0;
+    char *buf = utils_read_file(path, &len);
+    utils_free(path);
+    if (!buf) return 0;
+    cJSON *root = cJSON_ParseWithLength(buf, len);
+    utils_free(buf);
+    if (!root) return 0;    // Unreadable; start over
+
+    s->seq = (unsigned long long)cJSON_GetNumberValue(cJSON_GetObjectItem(root, "seq"));
+    s->offset = (long long)cJSON_GetNumberValue(cJSON_GetObjectItem(root, "offset"));
+    s->sampled = (long)cJSON_GetNumberValue(cJSON_GetObjectItem(root, "sampled"));
+    int rc = 1;
+    const cJSON *item;
+    cJSON_ArrayForEach(item, cJSON_GetObjectItem(root, "tasks")) {
+        const char *id = cJSON_GetStringValue(cJSON_GetArrayItem(item, 0));
+        const char *project = cJSON_GetStringValue(cJSON_GetArrayItem(item, 1));
+        StatsTask *t = (id && project) ? task_get(s, id, true) : NULL;
+        if (!t || !(t->project = utils_strdup(project))) {
+            rc = -1;
+            break;
+        }
+        t->gone = false;
+        t->pending = num_at(item, 2) != 0;
+        t->created = (time_t)num_at(item, 3);
+        t->due = (time_t)num_at(item, 4);
+        t->due_day = cJSON_IsNumber(cJSON_GetArrayItem(item, 5)) ? (long)num_at(item, 5) : NO_DAY;
+        t->recur = num_at(item, 6) != 0;
+        t->hash = (unsigned)num_at(item, 7);
+    }
+    cJSON_ArrayForEach(item, cJSON_GetObjectItem(root, "buckets")) {
+        const char *project = cJSON_GetStringValue(cJSON_GetArrayItem(item, 1));
+        StatsBucket *b = (rc == 1 && project) ? bucket_get(s, (long)num_at(item, 0), project) : NULL;
+        if (!b) {
+            rc = -1;
+            break;
+        }
+        b->opened = (unsigned)num_at(item, 2);
+        b->closed = (unsigned)num_at(item, 3);
+        b->completed = (unsigned)num_at(item, 4);
+        b->lead_count = (unsigned)num_at(item, 5);
+        b->lead_sum = (long long)num_at(item, 6);
+    }
+    cJSON_ArrayForEach(item, cJSON_GetObjectItem(root, "overdue")) {
+        if (rc != 1) break;
+        if (overdue_append(s, (long)num_at(item, 0), (unsigned)num_at(item, 1)) != 0) rc = -1;
+    }
+    cJSON_Delete(root);
+    if (rc != 1) stats_free(s);
+    return rc;
+}
+
+// Helper: replace stats.json atomically
+static int stats_save(const Stats *s) {
+    cJSON *root = cJSON_CreateObject();
+    if (!root) return -1;
+    cJSON_AddNumberToObject(root, "seq", (double)s->seq);
+    cJSON_AddNumberToObject(root, "offset", (double)s->offset);
+    cJSON_AddNumberToObject(root, "sampled", (double)s->sampled);
+    cJSON *tasks = cJSON_AddArrayToObject(root, "tasks");
+    for (size_t i = 0; tasks && i < s->task_count; i++) {
+        const StatsTask *t = &s->tasks[i];
+        if (t->gone) continue;
+        cJSON *item = cJSON_CreateArray();
+        cJSON_AddItemToArray(item, cJSON_CreateString(t->id));
+        cJSON_AddItemToArray(item, cJSON_CreateString(t->project));
+        cJSON_AddItemToArray(item, cJSON_CreateNumber(t->pending));
+        cJSON_AddItemToArray(item, cJSON_CreateNumber((double)t->created));
+        cJSON_AddItemToArray(item, cJSON_CreateNumber((double)t->due));
+        cJSON_AddItemToArray(item, t->due_day == NO_DAY ? cJSON_CreateNull() : cJSON_CreateNumber((double)t->due_day));
+        cJSON_AddItemToArray(item, cJSON_CreateNumber(t->recur));
+        cJSON_AddItemToArray(item, cJSON_CreateNumber(t->hash));
+        cJSON_AddItemToArray(tasks, item);
+    }
+    cJSON *buckets = cJSON_AddArrayToObject(root, "buckets");
+    for (size_t i = 0; buckets && i < s->bucket_count; i++) {
+        const StatsBucket *b = &s->buckets[i];
+        cJSON *item = cJSON_CreateArray();
+        cJSON_AddItemToArray(item, cJSON_CreateNumber((double)b->day));
+        cJSON_AddItemToArray(item, cJSON_CreateString(b->project));
+        cJSON_AddItemToArray(item, cJSON_CreateNumber(b->opened));
+        cJSON_AddItemToArray(item, cJSON_CreateNumber(b->closed));
+        cJSON_AddItemToArray(item, cJSON_CreateNumber(b->completed));
+        cJSON_AddItemToArray(item, cJSON_CreateNumber(b->lead_count));
+        cJSON_AddItemToArray(item, cJSON_CreateNumber((double)b->lead_sum));
+        cJSON_AddItemToArray(buckets, item);
+    }
+    cJSON *overdue = cJSON_AddArrayToObject(root, "overdue");
+    for (size_t i = 0; overdue && i < s->overdue_count; i++) {
+        cJSON *item = cJSON_CreateArray();
+        cJSON_AddItemToArray(item, cJSON_CreateNumber((double)s->overdue[i].day));
+        cJSON_AddItemToArray(item, cJSON_CreateNumber(s->overdue[i].count));
+        cJSON_AddItemToArray(overdue, item);
+    }
+    char *json = (tasks && buckets && overdue) ? cJSON_PrintUnformatted(root) : NULL;
+    cJSON_Delete(root);
+
+    char *path = storage_path(STATS_FILE);
+    int rc = (json && path) ? utils_write_file_atomic(path, json, strlen(json)) : -1;
+    utils_free(json);
+    utils_free(path);
+    return rc;
+}
+
+// Helper: size of the journal, 0 if there is none
+static long long journal_size(void) {
+    char *path = storage_path(JOURNAL_FILE);
+    struct stat st;
+    long long size = (path && stat(path, &st) == 0) ? (long long)st.st_size : 0;
+    utils_free(path);
+    return size;
+}
+
+// Helper: fold in the records after s->seq, reading from s->offset when it
+// still points at the next record and from the start when a trim moved it.
+// Returns records folded in, -1 on error, or -2 if records were missed.
+static int fold_journal(Stats *s) {
+    char *path = storage_path(JOURNAL_FILE);
+    FILE *f = path ? fopen(path, "r") : NULL;
+    utils_free(path);
+    if (!f) return -2;
+    struct stat st;
+    long long size = fstat(fileno(f), &st) == 0 ? (long long)st.st_size : 0;
+
+    int applied = 0;
+    char *line = NULL;
+    size_t cap = 0;
+    bool missed = false;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        long long pos = attempt == 0 ? s->offset : 0;
+        if (pos > size || fseek(f, pos, SEEK_SET) != 0) continue;
+        missed = false;
+        ssize_t len;
+        while ((len = getline(&line, &cap, f)) > 0 && line[len - 1] == '\n') {
+            pos += len;
+            line[len - 1] = '\0';
+            JournalRecordInfo info;
+            if (journal_scan_record(line, &info) != 0 || info.seq <= s->seq) continue;
+            if (info.seq != s->seq + 1) {
+                missed = true;
+                break;
+            }
+            cJSON *rec = cJSON_Parse(line);
+            int rc = rec ? apply_record(s, rec, info.ts) : 0;
+            cJSON_Delete(rec);
+            if (rc != 0) {
+                applied = -1;
+                break;
+            }
+            s->seq = info.seq;
+            s->offset = pos;
+            applied++;
+        }
+        if (applied < 0 || !missed) break;
+    }
+    utils_free(line);
+    fclose(f);
+    return applied < 0 ? -1 : missed ? -2 : applied;
+}
+
+// Helper: bring loaded aggregates up to date; tasks (or, if NULL, the
+// stored ones) replace the remembered state when records were missed
+static int stats_fold(Stats *s, Task **tasks, size_t count) {
+    unsigned long long newest = journal_last_seq();
+    if (newest == s->seq) return 0;
+    int applied = newest > s->seq ? fold_journal(s) : -2;
+    if (applied != -2) return applied;
+
+    // The journal was reset or trimmed past our position: resynchronize the
+    // task states; the changes in between are not counted
+    Task **loaded = tasks ? NULL : storage_load_tasks(&count);
+    if (!tasks && !loaded) return -1;
+    int rc = reset_tasks(s, tasks ? tasks : loaded, count);
+    if (loaded) storage_free_tasks(loaded, count);
+    s->seq = journal_last_seq();
+    s->offset = journal_size();
+    return rc == 0 ? 0 : -1;
+}
+
+// Helper: start the aggregates from a task set (NULL to load the stored
+// one), with the additions and completions so far taken from the task
+// history
+static int stats_start(Stats *s, Task **tasks, size_t count) {
+    memset(s, 0, sizeof(*s));
+    s->seq = journal_last_seq();
+    s->offset = journal_size();
+    time_t now = app_clock_now();
+    s->sampled = app_clock_local_day(now) - 1;
+
+    Task **loaded = tasks ? NULL : storage_load_tasks(&count);
+    if (!tasks && !loaded) return -1;
+    int rc = reset_tasks(s, tasks ? tasks : loaded, count);
+    if (loaded) storage_free_tasks(loaded, count);
+
+    cJSON *added = rc == 0 ? history_added(0, now) : NULL;
+    cJSON *done = added ? history_completed(0, now) : NULL;
+    if (!done) {
+        cJSON_Delete(added);
+        added = NULL;
+        rc = -1;
+    }
+    const cJSON *entry;
+    cJSON_ArrayForEach(entry, added) {
+        time_t ts = (time_t)cJSON_GetNumberValue(cJSON_GetObjectItem(entry, "ts"));
+        Task *t = task_from_cjson(cJSON_GetObjectItem(entry, "task"));
+        if (!t) continue;
+        if (t->status == STATUS_PENDING) {
+            StatsBucket *b = bucket_get(s, app_clock_local_day(ts), t->project ? t->project : "default");
+            if (b) b->opened++;
+            else rc = -1;
+        }
+        task_free(t);
+        if (rc != 0) break;
+    }
+    cJSON_ArrayForEach(entry, done) {
+        if (rc != 0) break;
+        time_t ts = (time_t)cJSON_GetNumberValue(cJSON_GetObjectItem(entry, "ts"));
+        Task *t = task_from_cjson(cJSON_GetObjectItem(entry, "task"));
+        if (!t) continue;
+        rc = add_completion(s, app_clock_local_day(ts), t->project ? t->project : "default", ts, t->created, t->recur != NULL);
+        task_free(t);
+    }
+    cJSON_Delete(added);
+    cJSON_Delete(done);
+    if (rc != 0) stats_free(s);
+    return rc;
+}
+
+int stats_update(Task **tasks, size_t count) {
+    Stats s;
+    int rc = stats_load(&s);
+    if (rc < 0) return rc;
+    if (rc == 0) {
+        // The first write starts the aggregates; its records are in the history
+        if (stats_start(&s, tasks, count) != 0) return -1;
+        rc = stats_save(&s);
+        stats_free(&s);
+        return rc;
+    }
+    unsigned long long seq = s.seq;
+    rc = stats_fold(&s, tasks, count);
+    if (rc >= 0 && s.seq != seq && stats_save(&s) != 0) rc = -1;
+    stats_free(&s);
+    return rc;
+}
+
+// Helper: order project names
+static int compare_names(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+// Helper: the projects a report lists: those with open tasks or activity
+// in its days; returns a sorted array of borrowed names
+static const char **report_projects(const Stats *s, long first, size_t *count) {
+    const char **names = utils_malloc((s->task_count + s->bucket_count + 1) * sizeof(char *));
+    if (!names) return NULL;
+    size_t n = 0;
+    for (size_t i = 0; i < s->task_count; i++) {
+        if (!s->tasks[i].gone && s->tasks[i].pending) names[n++] = s->tasks[i].project;
+    }
+    for (size_t i = 0; i < s->bucket_count; i++) {
+        if (s->buckets[i].day >= first) names[n++] = s->buckets[i].project;
+    }
+    qsort(names, n, sizeof(char *), compare_names);
+    size_t unique = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (unique == 0 || strcmp(names[unique - 1], names[i]) != 0) names[unique++] = names[i];
+    }
+    *count = unique;
+    return names;
+}
+
+// Helper: summarize up-to-date aggregates
+static StatsReport *build_report(const Stats *s, int days, long today) {
+    long first = today - days + 1;
+    StatsReport *r = utils_calloc(1, sizeof(StatsReport));
+    size_t project_count = 0;
+    const char **names = r ? report_projects(s, first, &project_count) : NULL;
+    if (r) r->days = utils_calloc((size_t)days, sizeof(StatsDay));
+    if (r && names) r->projects = utils_calloc(project_count + 1, sizeof(StatsProject));
+    if (!names || !r->days || !r->projects) {
+        utils_free(names);
+        stats_report_free(r);
+        return NULL;
+    }
+    r->day_count = (size_t)days;
+    for (int i = 0; i < days; i++) {
+        r->days[i].day = first + i;
+        r->days[i].overdue = -1;
+    }
+    for (size_t i = 0; i < s->overdue_count; i++) {
+        if (s->overdue[i].day >= first && s->overdue[i].day <= today) {
+            r->days[s->overdue[i].day - first].overdue = (int)s->overdue[i].count;
+        }
+    }
+
+    unsigned long long lead_count = 0, lead_count_all = 0;
+    long long lead_sum = 0, lead_sum_all = 0;
+    for (size_t i = 0; i < s->bucket_count; i++) {
+        const StatsBucket *b = &s->buckets[i];
+        lead_count_all += b->lead_count;
+        lead_sum_all += b->lead_sum;
+        if (b->day < first || b->day > today) continue;
+        StatsDay *d = &r->days[b->day - first];
+        d->completed += b->completed;
+        d->opened += b->opened;
+        d->closed += b->closed;
+        r->completed += b->completed;
+        lead_count += b->lead_count;
+        lead_sum += b->lead_sum;
+    }
+    r->lead_days = lead_count ? (double)lead_sum / (double)lead_count / 86400.0 : 0;
+    r->lead_days_all = lead_count_all ? (double)lead_sum_all / (double)lead_count_all / 86400.0 : 0;
+
+    for (size_t p = 0; p < project_count; p++) {
+        StatsProject *proj = &r->projects[r->project_count];
+        proj->burndown = utils_calloc((size_t)days, sizeof(unsigned));
+        proj->name = utils_strdup(names[p]);
+        if (!proj->burndown || !proj->name) {
+            utils_free(proj->burndown);
+            utils_free(proj->name);
+            utils_free(names);
+            stats_report_free(r);
+            return NULL;
+        }
+        r->project_count++;
+        for (size_t i = 0; i < s->task_count; i++) {
+            const StatsTask *st = &s->tasks[i];
+            if (!st->gone && st->pending && strcmp(st->project, names[p]) == 0) proj->open++;
+        }
+        // Walk back from today's open count, undoing each day's changes
+        long long *net = utils_calloc((size_t)days, sizeof(long long));
+        if (!net) {
+            utils_free(names);
+            stats_report_free(r);
+            return NULL;
+        }
+        for (size_t i = 0; i < s->bucket_count; i++) {
+            const StatsBucket *b = &s->buckets[i];
+            if (b->day < first || b->day > today || strcmp(b->project, names[p]) != 0) continue;
+            net[b->day - first] += (long long)b->opened - (long long)b->closed;
+            proj->completed += b->completed;
+        }
+        long long open = proj->open;
+        for (int i = days - 1; i >= 0; i--) {
+            proj->burndown[i] = open > 0 ? (unsigned)open : 0;
+            open -= net[i];
+        }
+        utils_free(net);
+    }
+    utils_free(names);
+    return r;
+}
+
+StatsReport *stats_report(int days) {
+    if (days <= 0) days = STATS_DAYS;
+    if (storage_init() != 0) return NULL;
+    Stats s;
+    int rc = stats_load(&s);
+    if (rc == 0) rc = stats_start(&s, NULL, 0);
+    else if (rc == 1) rc = stats_fold(&s, NULL, 0) < 0 ? -1 : 0;
+    if (rc != 0) {
+        stats_free(&s);
+        return NULL;
+    }
+    long today = app_clock_local_day(app_clock_now());
+    StatsReport *r = NULL;
+    if (fill_overdue(&s, today) == 0 && stats_save(&s) == 0) r = build_report(&s, days, today);
+    stats_free(&s);
+    return r;
+}
+
+void stats_report_free(StatsReport *report) {
+    if (!report) return;
+    for (size_t i = 0; i < report->project_count; i++) {
+        utils_free(report->projects[i].name);
+        utils_free(report->projects[i].burndown);
+    }
+    utils_free(report->projects);
+    utils_free(report->days);
+    utils_free(report);
+}
+
+void stats_format_day(long day, char *buf, size_t size) {
+    int y, m, d;
+    utils_civil_from_days(day, &y, &m, &d);
+    snprintf(buf, size, "%04d-%02d-%02d", y, m, d);
+}
+
+void stats_sparkline(const unsigned *values, size_t count, char *buf, size_t size) {
+    static const char LEVELS[] = " .:-=+*#";
+    unsigned max = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (values[i] > max) max = values[i];
+    }
+    size_t n = 0;
+    for (size_t i = 0; i < count && n + 1 < size; i++) {
+        size_t level = max ? (values[i] * (sizeof(LEVELS) - 2) + max - 1) / max : 0;
+        buf[n++] = LEVELS[level];
+    }
+    if (size > 0) buf[n] = '\0';
+}
+
+// Helper: the report as JSON
+static cJSON *report_to_cjson(const StatsReport *r) {
+    cJSON *root = cJSON_CreateObject();
+    cJSON *days = root ? cJSON_AddArrayToObject(root, "days") : NULL;
+    cJSON *projects = root ? cJSON_AddArrayToObject(root, "projects") : NULL;
+    if (!days || !projects) {
+        cJSON_Delete(root);
+        return NULL;
+    }
+    char date[16];
+    for (size_t i = 0; i < r->day_count; i++) {
+        const StatsDay *d = &r->days[i];
+        cJSON *item = cJSON_CreateObject();
+        stats_format_day(d->day, date, sizeof(date));
+        cJSON_AddStringToObject(item, "date", date);
+        cJSON_AddNumberToObject(item, "completed", d->completed);
+        cJSON_AddNumberToObject(item, "opened", d->opened);
+        cJSON_AddNumberToObject(item, "closed", d->closed);
+        if (d->overdue >= 0) cJSON_AddNumberToObject(item, "overdue", d->overdue);
+        else cJSON_AddNullToObject(item, "overdue");
+        cJSON_AddItemToArray(days, item);
+    }
+    for (size_t i = 0; i < r->project_count; i++) {
+        const StatsProject *p = &r->projects[i];
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "name", p->name);
+        cJSON_AddNumberToObject(item, "open", p->open);
+        cJSON_AddNumberToObject(item, "completed", p->completed);
+        cJSON *burndown = cJSON_AddArrayToObject(item, "burndown");
+        for (size_t k = 0; k < r->day_count; k++) cJSON_AddItemToArray(burndown, cJSON_CreateNumber(p->burndown[k]));
+        cJSON_AddItemToArray(projects, item);
+    }
+    cJSON_AddNumberToObject(root, "completed", r->completed);
+    cJSON_AddNumberToObject(root, "lead_days", r->lead_days);
+    cJSON_AddNumberToObject(root, "lead_days_all", r->lead_days_all);
+    return root;
+}
+
+// Helper: print the report as text
+static void print_report(FILE *out, const StatsReport *r) {
+    fprintf(out, "Last %zu days: %u completed, average lead time %.1f days (all time %.1f days)\n\n",
+            r->day_count, r->completed, r->lead_days, r->lead_days_all);
+    fprintf(out, "Date        Done  Opened  Closed  Overdue\n");
+    char date[16];
+    for (size_t i = 0; i < r->day_count; i++) {
+        const StatsDay *d = &r->days[i];
+        stats_format_day(d->day, date, sizeof(date));
+        fprintf(out, "%s  %4u  %6u  %6u  ", date, d->completed, d->opened, d->closed);
+        if (d->overdue >= 0) fprintf(out, "%7d\n", d->overdue);
+        else fprintf(out, "%7s\n", "-");
+    }
+    if (r->project_count == 0) return;
+    fprintf(out, "\nProject               Open  Done  Burndown\n");
+    char *line = utils_malloc(r->day_count + 1);
+    for (size_t i = 0; line && i < r->project_count; i++) {
+        const StatsProject *p = &r->projects[i];
+        stats_sparkline(p->burndown, r->day_count, line, r->day_count + 1);
+        fprintf(out, "%-20.20s  %4u  %4u  [%s]\n", p->name, p->open, p->completed, line);
+    }
+    utils_free(line);
+}
+
+int stats_main(int argc, char **argv) {
+    int days = STATS_DAYS;
+    bool json = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            json = true;
+            continue;
+        }
+        char *end = NULL;
+        long n = (strcmp(argv[i], "--days") == 0 && i + 1 < argc) ? strtol(argv[++i], &end, 10) : 0;
+        if (!end || *end != '\0' || n <= 0 || n > STATS_MAX_FILL_DAYS) {
+            fprintf(stderr, "Usage: smartodo stats [--days N] [--json]\n");
+            return 2;
+        }
+        days = (int)n;
+    }
+    app_clock_tick();
+    StatsReport *r = stats_report(days);
+    if (!r) {
+        fprintf(stderr, "Failed to compute statistics.\n");
+        return 1;
+    }
+    if (json) {
+        cJSON *root = report_to_cjson(r);
+        char *text = root ? cJSON_PrintUnformatted(root) : NULL;
+        if (text) printf("%s\n", text);
+        utils_free(text);
+        cJSON_Delete(root);
+    } else {
+        print_report(stdout, r);
+    }
+    stats_report_free(r);
+    return 0;
+}
@@ -0,0 +1,110 @@
+#ifndef TODO_APP_STATS_H
+#define TODO_APP_STATS_H
+
+#include <stddef.h>
+#include "task.h"
+
+/**
+ * Productivity statistics. Aggregates bucketed by local day and project
+ * live in ~/.todo-app/stats.json and are kept up to date from the mutation
+ * journal: every snapshot write folds in the records since the last one,
+ * so a report never scans the task set. Per bucket:
+ *   opened     pending tasks added, reopened or moved into the project
+ *   closed     pending tasks completed, deleted or moved out
+ *   completed  completions, counting each occurrence of a recurring task
+ * plus the lead time (creation to completion) of completed one-off tasks,
+ * and per day the number of pending tasks overdue when it began.
+ *
+ * The aggregates start with the first snapshot write (or the first report,
+ * if stats.json was removed); additions and completions before that are
+ * filled in once from the task history (history.h).
+ */
+
+#define STATS_FILE "stats.json"
+
+// Days a report covers by default
+#define STATS_DAYS 14
+
+// Most days of overdue counts filled in after a long gap
+#define STATS_MAX_FILL_DAYS 366
+
+// One day of a report
+typedef struct {
+    long day;             // Local day number (days since 1970-01-01)
+    unsigned completed;
+    unsigned opened;
+    unsigned closed;
+    int overdue;          // Pending tasks overdue as the day began, or -1 if not recorded
+} StatsDay;
+
+// One project of a report
+typedef struct {
+    char *name;
+    unsigned open;        // Pending tasks now
+    unsigned completed;   // Completions in the report's days
+    unsigned *burndown;   // Pending tasks at the end of each of the report's days
+} StatsProject;
+
+// What `smartodo stats` and the TUI stats pane show
+typedef struct {
+    size_t day_count;
+    StatsDay *days;             // Oldest first; the last is today
+    size_t project_count;
+    StatsProject *projects;     // Sorted by name
+    unsigned completed;         // Completions in the report's days
+    double lead_days;           // Average lead time in the report's days (0 if none)
+    double lead_days_all;       // Average lead time over every recorded completion
+} StatsReport;
+
+/**
+ * Fold the journal records written since the last update into the
+ * aggregates, starting them if there are none yet. Called by storage
+ * after each snapshot write.
+ * @param tasks Task set just saved, used instead of the records if some
+ *        were trimmed away unseen (NULL to load the stored tasks)
+ * @param count Number of tasks
+ * @return Number of records folded in (0 when starting), or -1 on error
+ */
+int stats_update(Task **tasks, size_t count);
+
+/**
+ * Bring the aggregates up to date (starting them if needed) and summarize
+ * the last days.
+ * @param days Days to cover, ending today (0 for STATS_DAYS)
+ * @return Newly allocated report (free with stats_report_free()), or NULL on error
+ */
+StatsReport *stats_report(int days);
+
+/**
+ * Free a report.
+ * @param report Report (may be NULL)
+ */
+void stats_report_free(StatsReport *report);
+
+/**
+ * Format a day number as YYYY-MM-DD.
+ * @param day Day number since 1970-01-01
+ * @param buf Output buffer (11 bytes or more)
+ * @param size Size of buf
+ */
+void stats_format_day(long day, char *buf, size_t size);
+
+/**
+ * Render values as a one-character-per-value bar chart scaled to the
+ * largest, e.g. for a burndown.
+ * @param values Values
+ * @param count Number of values
+ * @param buf Output buffer (count + 1 bytes for the whole chart)
+ * @param size Size of buf
+ */
+void stats_sparkline(const unsigned *values, size_t count, char *buf, size_t size);
+
+/**
+ * Entry point for `smartodo stats [--days N] [--json]`.
+ * @param argc Argument count, starting at "stats"
+ * @param argv Arguments
+ * @return Exit status: 0 on success, 1 on error, 2 on bad usage
+ */
+int stats_main(int argc, char **argv);
+
+#endif // TODO_APP_STATS_H
@@ -1,6 +1,14 @@
+// stat() and mkdir() are POSIX, not ISO C
+#define _POSIX_C_SOURCE 200809L
+
 #include "storage.h"
 #include "task.h"
 #include "utils.h"
+#include "journal.h"
+#include "daemon_client.h"
+#include "completion.h"
+#include "stats.h"
+#include "trace.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -8,6 +16,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <errno.h>
+#include <stdbool.h>
 #include <cjson/cJSON.h>
 
 #define STORAGE_DIR ".todo-app"
@@ -36,132 +45,415 @@ int storage_init(void) {
     struct stat st = {0};
     if (stat(dir, &st) == -1) {
         if (mkdir(dir, 0700) == -1) {
-            free(dir);
+            utils_free(dir);
             return -1;
         }
     }
-    free(dir);
+    utils_free(dir);
     return 0;
 }
 
+char *storage_path(const char *filename) {
+    return build_path(filename);
+}
+
+char *storage_tasks_path(void) {
+    return build_path(TASKS_FILE);
+}
+
+// Helper: check a task's project and status against the load query
+static bool query_accepts(const StorageQuery *query, const char *project, bool done) {
+    if (!query) return true;
+    if (query->project && strcmp(project ? project : "default", query->project) != 0) return false;
+    if (query->status >= 0 && done != (query->status == STATUS_DONE)) return false;
+    return true;
+}
+
+// Helper: check whether a stored task object passes the load query
+static bool matches_query(const cJSON *item, const StorageQuery *query) {
+    if (!query) return true;
+    const cJSON *project = cJSON_GetObjectItem(item, "project");
+    const cJSON *status = cJSON_GetObjectItem(item, "status");
+    return query_accepts(query, cJSON_IsString(project) ? project->valuestring : NULL,
+                         cJSON_IsString(status) && strcmp(status->valuestring, "done") == 0);
+}
+
+// Helper: build the tasks passing query from a parsed JSON array
+static Task **tasks_from_array(const cJSON *root, const StorageQuery *query, size_t *count) {
+    if (!cJSON_IsArray(root)) return NULL;
+    size_t total = cJSON_GetArraySize(root);
+    Task **tasks = utils_malloc((total + 1) * sizeof(Task *));
+    if (!tasks) return NULL;
+
+    // Walk the array once; indexed access would be quadratic
+    size_t n = 0;
+    const cJSON *item;
+    cJSON_ArrayForEach(item, root) {
+        if (!cJSON_IsObject(item) || !matches_query(item, query)) continue;
+        Task *t = task_from_cjson(item);
+        if (t) tasks[n++] = t;
+    }
+    tasks[n] = NULL;
+    *count = n;
+    return tasks;
+}
+
 // Load tasks from tasks.json; returns NULL on error, count set to number
 Task **storage_load_tasks(size_t *count) {
-    *count = 0;
+    return storage_load_tasks_query(NULL, count);
+}
+
+// Helper: read and parse the tasks.json snapshot; an empty array if there is none
+static cJSON *read_snapshot(void) {
     char *path = build_path(TASKS_FILE);
     if (!path) return NULL;
-    
-    FILE *f = utils_fopen(path, "r");
-    free(path);
-    if (!f) {
-        // No file yet: return empty list
-        return utils_calloc(1, sizeof(Task *));
-    }
-    
-    // Get file size
-    fseek(f, 0, SEEK_END);
-    long size = ftell(f);
-    rewind(f);
-    
-    // Read file contents
-    char *data = utils_malloc(size + 1);
-    if (!data) { 
-        utils_fclose(f); 
-        return NULL; 
-    }
-    
-    fread(data, 1, size, f);
-    data[size] = '\0';
-    utils_fclose(f);
+    size_t size = 0;
+    char *data = utils_read_file(path, &size);
+    utils_free(path);
+    // No file yet: no tasks
+    if (!data) return errno == ENOENT ? cJSON_CreateArray() : NULL;
 
     // Parse JSON
-    cJSON *root = cJSON_Parse(data);
-    free(data);
-    if (!root || !cJSON_IsArray(root)) {
-        cJSON_Delete(root);
+    trace_begin("storage_parse");
+    cJSON *root = cJSON_ParseWithLength(data, size);
+    trace_end("storage_parse");
+    utils_free(data);
+    return root;
+}
+
+// Helper: load the tasks passing query from the tasks.json snapshot
+static Task **load_snapshot(const StorageQuery *query, size_t *count) {
+    cJSON *root = read_snapshot();
+    if (!root) return NULL;
+    trace_begin("storage_build");
+    Task **tasks = tasks_from_array(root, query, count);
+    trace_end("storage_build");
+    cJSON_Delete(root);
+    return tasks;
+}
+
+Task **storage_load_snapshot(size_t *count) {
+    *count = 0;
+    return load_snapshot(NULL, count);
+}
+
+// Fingerprints of the tasks as last loaded or saved, so the next save can
+// journal, or send the daemon, only what it changed
+static JournalPrints last_prints;
+static unsigned long long last_prints_seq = 0;
+static bool last_prints_valid = false;
+
+// Helper: remember the state as of journal record seq. A load passes the
+// seq it read before loading, so a record appended meanwhile makes the
+// next save read the files back rather than miss it.
+static void remember_prints(Task **tasks, size_t count, unsigned long long seq) {
+    last_prints_valid = journal_prints_build(tasks, count, &last_prints) == 0;
+    last_prints_seq = seq;
+}
+
+// Helper: load the tasks passing query from the snapshot plus the journal
+static Task **load_local(const StorageQuery *query, size_t *count) {
+    if (!journal_has_records()) return load_snapshot(query, count);
+
+    // Journal records apply to the whole set, so filter after replaying
+    Task **tasks = load_snapshot(NULL, count);
+    if (!tasks) return NULL;
+    trace_begin("journal_replay");
+    int replayed = journal_replay(&tasks, count);
+    trace_end("journal_replay");
+    if (replayed < 0) {
+        storage_free_tasks(tasks, *count);
+        *count = 0;
         return NULL;
     }
-    
-    // Create tasks array
-    size_t n = cJSON_GetArraySize(root);
-    Task **tasks = utils_malloc((n + 1) * sizeof(Task *));
-    if (!tasks) {
-        cJSON_Delete(root);
+    size_t n = 0;
+    for (size_t i = 0; i < *count; i++) {
+        if (query_accepts(query, tasks[i]->project, tasks[i]->status == STATUS_DONE)) {
+            tasks[n++] = tasks[i];
+        } else {
+            task_free(tasks[i]);
+        }
+    }
+    tasks[n] = NULL;
+    *count = n;
+    return tasks;
+}
+
+// Helper: load the tasks passing query, from the daemon or the files
+static Task **load_query(const StorageQuery *query, size_t *count) {
+    *count = 0;
+    unsigned long long seq = query ? 0 : journal_last_seq();
+
+    // A running daemon holds the current state; ask it first
+    cJSON *request = cJSON_CreateObject();
+    cJSON *response = NULL;
+    cJSON_AddStringToObject(request, "op", "load");
+    int rc = daemon_client_request(request, &response);
+    cJSON_Delete(request);
+    Task **tasks;
+    if (rc == 0) {
+        tasks = tasks_from_array(cJSON_GetObjectItem(response, "tasks"), query, count);
+        cJSON_Delete(response);
+    } else if (rc < 0) {
         return NULL;
+    } else {
+        tasks = load_local(query, count);
     }
-    
-    // Parse each task
-    for (size_t i = 0; i < n; ++i) {
-        cJSON *item = cJSON_GetArrayItem(root, i);
-        if (!cJSON_IsObject(item)) {
-            tasks[i] = NULL;
-            continue;
+
+    // The next save journals, or sends the daemon, only what changed since
+    if (tasks && !query) remember_prints(tasks, *count, seq);
+    return tasks;
+}
+
+// Load the tasks passing query; non-matching entries are never built
+Task **storage_load_tasks_query(const StorageQuery *query, size_t *count) {
+    trace_begin("storage_load_tasks");
+    Task **tasks = load_query(query, count);
+    trace_end("storage_load_tasks");
+    return tasks;
+}
+
+struct StorageLoader {
+    cJSON *doc;           // Parsed snapshot or daemon response, or NULL
+    const cJSON *array;   // The tasks array within doc
+    Task **built;         // Per array item: its task once built; total + 1 slots
+    size_t total;
+    Task **tasks;         // The whole set, when it could not be staged
+    size_t count;
+    unsigned long long seq;   // Newest journal record when the load began
+};
+
+StorageLoader *storage_loader_open(void) {
+    StorageLoader *loader = utils_calloc(1, sizeof(StorageLoader));
+    if (!loader) return NULL;
+    trace_begin("storage_loader_open");
+    loader->seq = journal_last_seq();
+
+    // A running daemon sends the set as one array, like the snapshot
+    cJSON *request = cJSON_CreateObject();
+    cJSON *response = NULL;
+    cJSON_AddStringToObject(request, "op", "load");
+    int rc = daemon_client_request(request, &response);
+    cJSON_Delete(request);
+    if (rc == 0) {
+        loader->doc = response;
+        loader->array = cJSON_GetObjectItem(response, "tasks");
+    } else if (rc > 0 && journal_has_records()) {
+        // Journal records apply to the whole set; no stages
+        loader->tasks = load_local(NULL, &loader->count);
+    } else if (rc > 0) {
+        loader->doc = read_snapshot();
+        loader->array = loader->doc;
+    }
+
+    bool ok = loader->tasks || cJSON_IsArray(loader->array);
+    if (ok && !loader->tasks) {
+        loader->total = cJSON_GetArraySize(loader->array);
+        loader->built = utils_calloc(loader->total + 1, sizeof(Task *));
+        ok = loader->built != NULL;
+    }
+    trace_end("storage_loader_open");
+    if (!ok) {
+        storage_loader_close(loader);
+        return NULL;
+    }
+    return loader;
+}
+
+Task **storage_loader_first(StorageLoader *loader, const char *project, size_t *count) {
+    *count = 0;
+    size_t total = loader->tasks ? loader->count : loader->total;
+    Task **out = utils_malloc((total + 1) * sizeof(Task *));
+    if (!out) return NULL;
+    trace_begin("storage_loader_first");
+    StorageQuery query = {project, -1};
+    size_t n = 0;
+    if (loader->tasks) {
+        for (size_t i = 0; i < loader->count; i++) {
+            if (query_accepts(&query, loader->tasks[i]->project, false)) out[n++] = loader->tasks[i];
         }
-        char *item_str = cJSON_PrintUnformatted(item);
-        if (!item_str) {
-            tasks[i] = NULL;
-            continue;
+    } else {
+        size_t i = 0;
+        const cJSON *item;
+        cJSON_ArrayForEach(item, loader->array) {
+            if (!loader->built[i] && cJSON_IsObject(item) && matches_query(item, &query)) {
+                loader->built[i] = task_from_cjson(item);
+            }
+            if (loader->built[i] && query_accepts(&query, loader->built[i]->project, false)) out[n++] = loader->built[i];
+            i++;
         }
-        tasks[i] = task_from_json(item_str);
-        free(item_str);
     }
-    
-    // Null-terminate the array
-    tasks[n] = NULL;
+    trace_end("storage_loader_first");
+    out[n] = NULL;
     *count = n;
-    cJSON_Delete(root);
+    return out;
+}
+
+Task **storage_loader_rest(StorageLoader *loader, size_t *count) {
+    *count = 0;
+    Task **tasks = loader->tasks;
+    size_t n = loader->count;
+    if (!tasks && loader->built) {
+        trace_begin("storage_loader_rest");
+
+        // Build what the first stage skipped, then close the gaps of
+        // items that did not parse
+        size_t i = 0;
+        const cJSON *item;
+        cJSON_ArrayForEach(item, loader->array) {
+            if (!loader->built[i] && cJSON_IsObject(item)) loader->built[i] = task_from_cjson(item);
+            if (loader->built[i]) loader->built[n++] = loader->built[i];
+            i++;
+        }
+        tasks = loader->built;
+        tasks[n] = NULL;
+        trace_end("storage_loader_rest");
+    }
+    loader->tasks = NULL;
+    loader->built = NULL;
+    *count = tasks ? n : 0;
+    if (tasks) remember_prints(tasks, n, loader->seq);
     return tasks;
 }
 
-// Save tasks to tasks.json; return 0 on success
-int storage_save_tasks(Task **tasks, size_t count) {
-    if (storage_init() != 0) return -1;
-    
+void storage_loader_close(StorageLoader *loader) {
+    if (!loader) return;
+    if (loader->tasks) storage_free_tasks(loader->tasks, loader->count);
+    for (size_t i = 0; loader->built && i < loader->total; i++) task_free(loader->built[i]);
+    utils_free(loader->built);
+    cJSON_Delete(loader->doc);
+    utils_free(loader);
+}
+
+// Helper: write the snapshot atomically, then checkpoint the journal it covers
+static int write_snapshot(const char *json) {
+    trace_begin("storage_write");
     char *path = build_path(TASKS_FILE);
-    if (!path) return -1;
+    int rc = path ? utils_write_file_atomic(path, json, strlen(json)) : -1;
+    if (rc == 0) rc = journal_checkpoint();
+    utils_free(path);
+    trace_end("storage_write");
+    return rc;
+}
 
+// Helper: build the JSON array stored in tasks.json
+static cJSON *tasks_to_array(Task **tasks, size_t count) {
     cJSON *root = cJSON_CreateArray();
-    if (!root) { 
-        free(path); 
-        return -1; 
-    }
-    
+    if (!root) return NULL;
+    trace_begin("storage_to_json");
+
     // Add each task to the JSON array
     for (size_t i = 0; i < count; ++i) {
         if (!tasks[i]) continue;
         
-        char *tstr = task_to_json(tasks[i]);
-        if (!tstr) continue;
-        
-        cJSON *obj = cJSON_Parse(tstr);
-        free(tstr);
-        
+        cJSON *obj = task_to_cjson(tasks[i]);
         if (obj) {
             cJSON_AddItemToArray(root, obj);
         }
     }
-    
+    trace_end("storage_to_json");
+    return root;
+}
+
+// Helper: journal how tasks differ from what is on disk
+static int journal_save(Task **tasks, size_t count) {
+    // Nothing loaded, or another process wrote since; read the files back
+    unsigned long long seq = journal_last_seq();
+    if (!last_prints_valid || last_prints_seq != seq) {
+        size_t n = 0;
+        Task **on_disk = load_local(NULL, &n);
+        if (!on_disk) return -1;
+        remember_prints(on_disk, n, seq);
+        storage_free_tasks(on_disk, n);
+        if (!last_prints_valid) return -1;
+    }
+    return journal_append_diff(&last_prints, tasks, count) < 0 ? -1 : 0;
+}
+
+int storage_write_snapshot(Task **tasks, size_t count) {
+    if (storage_init() != 0) return -1;
+    cJSON *root = tasks_to_array(tasks, count);
+    char *out = root ? cJSON_PrintUnformatted(root) : NULL;
+    cJSON_Delete(root);
+    if (!out) return -1;
+    int rc = write_snapshot(out);
+    utils_free(out);
+    if (rc == 0) {
+        completion_index_write(tasks, count);
+        stats_update(tasks, count);
+    }
+    return rc;
+}
+
+// Helper: journal_prints_diff() callback; add one change to a save request
+static int add_change(JournalOp op, const Task *task, void *user) {
+    cJSON *request = user;
+    cJSON *item = op == JOURNAL_DELETE ? cJSON_CreateString(task->id) : task_to_cjson(task);
+    if (!item) return -1;
+    cJSON_AddItemToArray(cJSON_GetObjectItem(request, op == JOURNAL_DELETE ? "del" : "put"), item);
+    return 0;
+}
+
+// Helper: send the daemon what changed since this process last loaded or
+// saved, so tasks other writers changed meanwhile are left alone; with
+// nothing loaded every task is sent and nothing deleted
+static int save_to_daemon(Task **tasks, size_t count) {
+    cJSON *request = cJSON_CreateObject();
+    if (!request) return -1;
+    cJSON_AddStringToObject(request, "op", "save");
+    cJSON_AddArrayToObject(request, "put");
+    cJSON_AddArrayToObject(request, "del");
+    JournalPrints none = {0};
+    int rc = journal_prints_diff(last_prints_valid ? &last_prints : &none, tasks, count,
+                                 add_change, request);
+    cJSON *response = NULL;
+    if (rc == 0) rc = daemon_client_request(request, &response);
+    cJSON_Delete(response);
+    cJSON_Delete(request);
+    if (rc == 0) remember_prints(tasks, count, journal_last_seq());
+    return rc;
+}
+
+// Helper: save tasks through the daemon, or to the files
+static int save_tasks(Task **tasks, size_t count) {
+    if (storage_init() != 0) return -1;
+
+    // A running daemon serializes all writers
+    int rc = save_to_daemon(tasks, count);
+    if (rc != DAEMON_CLIENT_UNAVAILABLE) return rc == 0 ? 0 : -1;
+
+    cJSON *root = tasks_to_array(tasks, count);
+    if (!root) return -1;
+
     // Convert JSON to string
+    trace_begin("storage_print");
     char *out = cJSON_PrintUnformatted(root);
     cJSON_Delete(root);
-    
-    if (!out) {
-        free(path);
-        return -1;
-    }
-
-    // Write to file
-    FILE *f = utils_fopen(path, "w");
-    if (!f) {
-        free(out);
-        free(path);
-        return -1;
-    }
-    
-    fwrite(out, 1, strlen(out), f);
-    utils_fclose(f);
-    free(out);
-    free(path);
-    return 0;
+    trace_end("storage_print");
+    if (!out) return -1;
+
+    // The change feed reads the journal, so a full save records its diff too
+    trace_begin("journal_save");
+    rc = journal_save(tasks, count);
+    trace_end("journal_save");
+    rc = rc == 0 ? write_snapshot(out) : -1;
+    utils_free(out);
+    if (rc == 0) {
+        remember_prints(tasks, count, journal_last_seq());
+        trace_begin("storage_indexes");
+        completion_index_write(tasks, count);
+        stats_update(tasks, count);
+        trace_end("storage_indexes");
+    }
+    return rc;
+}
+
+// Save tasks to tasks.json; return 0 on success
+int storage_save_tasks(Task **tasks, size_t count) {
+    trace_begin("storage_save_tasks");
+    int rc = save_tasks(tasks, count);
+    trace_end("storage_save_tasks");
+    return rc;
 }
 
 // Save array of project names to projects.json
@@ -174,12 +466,12 @@ int storage_save_projects(char **projects, size_t count) {
     }
     char *json = cJSON_PrintUnformatted(root);
     FILE *f = fopen(path, "w");
-    free(path);
-    if (!f) { cJSON_Delete(root); free(json); return -1; }
+    utils_free(path);
+    if (!f) { cJSON_Delete(root); utils_free(json); return -1; }
     fputs(json, f);
     fclose(f);
     cJSON_Delete(root);
-    free(json);
+    utils_free(json);
     return 0;
 }
 
@@ -188,18 +480,11 @@ size_t storage_load_projects(char ***projects_out) {
     *projects_out = NULL;
     char *path = build_path(PROJECTS_FILE);
     if (!path) return 0;
-    FILE *f = fopen(path, "r");
-    free(path);
-    if (!f) return 0;
-    fseek(f, 0, SEEK_END);
-    long len = ftell(f);
-    fseek(f, 0, SEEK_SET);
-    char *buf = utils_malloc(len+1);
-    fread(buf, 1, len, f);
-    buf[len] = 0;
-    fclose(f);
+    char *buf = utils_read_file(path, NULL);
+    utils_free(path);
+    if (!buf) return 0;
     cJSON *root = cJSON_Parse(buf);
-    free(buf);
+    utils_free(buf);
     if (!root) return 0;
     size_t n = cJSON_GetArraySize(root);
     char **arr = utils_malloc(n * sizeof(char*));
@@ -221,5 +506,5 @@ void storage_free_tasks(Task **tasks, size_t count) {
     for (size_t i = 0; i < count; ++i) {
         task_free(tasks[i]);
     }
-    free(tasks);
+    utils_free(tasks);
 }
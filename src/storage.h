@@ -11,7 +11,21 @@
 int storage_init(void);
 
 /**
- * Load tasks from ~/.todo-app/tasks.json.
+ * Get the path of a file in the storage directory.
+ * @param filename File name within ~/.todo-app
+ * @return Newly allocated path (caller frees), or NULL if HOME is not set
+ */
+char *storage_path(const char *filename);
+
+/**
+ * Get the path of the tasks file (~/.todo-app/tasks.json).
+ * @return Newly allocated path (caller frees), or NULL if HOME is not set
+ */
+char *storage_tasks_path(void);
+
+/**
+ * Load tasks from ~/.todo-app/tasks.json with the journal replayed on top,
+ * or from the daemon when one is running.
  * @param count[out] number of tasks loaded
  * @return NULL-terminated array of Task* on success, or NULL on error.
  *         Caller must free tasks via storage_free_tasks().
@@ -19,13 +33,96 @@ int storage_init(void);
 Task **storage_load_tasks(size_t *count);
 
 /**
- * Save an array of tasks to ~/.todo-app/tasks.json.
+ * Filter applied while loading, before any Task is built.
+ */
+typedef struct {
+    const char *project;   // Only tasks in this project, or NULL for all
+    int status;            // Only tasks with this Status, or -1 for all
+} StorageQuery;
+
+/**
+ * Load only the tasks matching a query from ~/.todo-app/tasks.json.
+ * Read-only callers use this to avoid building tasks they will not show;
+ * never save the result back, as non-matching tasks are missing.
+ * @param query Filter, or NULL to load everything
+ * @param count[out] number of tasks loaded
+ * @return NULL-terminated array of Task* on success, or NULL on error.
+ *         Caller must free tasks via storage_free_tasks().
+ */
+Task **storage_load_tasks_query(const StorageQuery *query, size_t *count);
+
+/**
+ * Staged load, for startup: storage_loader_open() reads and parses the
+ * snapshot once, storage_loader_first() builds just the tasks of one
+ * project so they can be shown, and storage_loader_rest() builds the
+ * others and returns the whole set, the same as storage_load_tasks().
+ * With a running daemon or unreplayed journal records the whole set is
+ * loaded on open and the stages only hand it out.
+ */
+typedef struct StorageLoader StorageLoader;
+
+/**
+ * Read and parse the tasks.
+ * @return New loader (close with storage_loader_close()), or NULL on error
+ */
+StorageLoader *storage_loader_open(void);
+
+/**
+ * Build the tasks of one project.
+ * @param loader Loader
+ * @param project Project name
+ * @param count[out] Number of tasks returned
+ * @return NULL-terminated array on success, or NULL on error. Free the
+ *         array with free(); the tasks stay the loader's until
+ *         storage_loader_rest() hands them out with the others.
+ */
+Task **storage_loader_first(StorageLoader *loader, const char *project, size_t *count);
+
+/**
+ * Build the remaining tasks and hand out the whole set, in file order.
+ * @param loader Loader; call once
+ * @param count[out] Number of tasks loaded
+ * @return NULL-terminated array of Task* on success, or NULL on error.
+ *         Caller must free tasks via storage_free_tasks().
+ */
+Task **storage_loader_rest(StorageLoader *loader, size_t *count);
+
+/**
+ * Close a loader, freeing whatever it still owns.
+ * @param loader Loader (may be NULL)
+ */
+void storage_loader_close(StorageLoader *loader);
+
+/**
+ * Save an array of tasks to ~/.todo-app/tasks.json, replacing the file
+ * atomically; goes through the daemon when one is running. What changed
+ * since the last load or save is journaled first, for the change feed,
+ * and the shell-completion index (completion.h) is rewritten after.
  * @param tasks NULL-terminated array of Task*
  * @param count number of tasks
  * @return 0 on success, -1 on error.
  */
 int storage_save_tasks(Task **tasks, size_t count);
 
+/**
+ * Load ~/.todo-app/tasks.json alone: no journal records applied and no
+ * daemon asked. Before anything is journaled this is the whole task set.
+ * @param count[out] number of tasks loaded
+ * @return NULL-terminated array of Task* on success, or NULL on error.
+ *         Caller must free tasks via storage_free_tasks().
+ */
+Task **storage_load_snapshot(size_t *count);
+
+/**
+ * Write tasks.json, checkpoint the journal and rewrite the completion
+ * index, without journaling anything; for a writer (the daemon) whose
+ * changes are already in the journal.
+ * @param tasks NULL-terminated array of Task*
+ * @param count number of tasks
+ * @return 0 on success, -1 on error.
+ */
+int storage_write_snapshot(Task **tasks, size_t count);
+
 /**
  * Free an array of tasks previously returned by storage_load_tasks.
  * @param tasks NULL-terminated array of Task*
@@ -0,0 +1,920 @@
+// fcntl() locks, fsync(), pread(), realpath() and directory listing are POSIX
+// (realpath() is in its XSI part), not ISO C
+#define _XOPEN_SOURCE 700
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <uuid/uuid.h>
+#include <cjson/cJSON.h>
+#include "sync.h"
+#include "storage.h"
+#include "journal.h"
+#include "task.h"
+#include "utils.h"
+#include "app_clock.h"
+
+// Largest HLC counter; a clock that would pass it moves on to the next millisecond
+#define HLC_MAX_COUNTER 0xffffu
+
+// Printed HLC: 12 hex digits of milliseconds, 4 of counter, then the device
+#define HLC_BUFSZ 96
+
+// Fields merged one by one; "due" carries its kind and zone along
+typedef struct {
+    const char *name;
+    const char *keys[3];
+} SyncField;
+
+static const SyncField FIELDS[] = {
+    {"name", {"name"}},
+    {"created", {"created"}},
+    {"due", {"due", "due_kind", "due_tz"}},
+    {"tags", {"tags"}},
+    {"priority", {"priority"}},
+    {"status", {"status"}},
+    {"project", {"project"}},
+    {"note", {"note"}},
+    {"recur", {"recur"}},
+};
+#define FIELD_COUNT (sizeof(FIELDS) / sizeof(FIELDS[0]))
+
+// Hybrid logical clock; orders by wall, then counter, then device id
+typedef struct {
+    unsigned long long wall;   // Milliseconds since the epoch (0 if unset)
+    unsigned int counter;      // Orders events within one millisecond
+    unsigned int device;       // Index into Sync.devices
+} Hlc;
+
+// Open-addressing hash map from id strings to pointers
+typedef struct {
+    char **keys;
+    void **values;
+    size_t cap;     // Power of two
+    size_t count;
+} IdMap;
+
+// What this device last synced of one task
+typedef struct {
+    char *id;
+    cJSON *base;                // Task as last synced, or NULL once deleted
+    Hlc clocks[FIELD_COUNT];    // When each field last changed
+    Hlc deleted;                // When the task was deleted (wall 0 if alive)
+} SyncEntry;
+
+typedef struct {
+    char *dir;
+    char **devices;             // Device ids; 0 is this device
+    size_t device_count;
+    IdMap device_index;         // Device id -> index + 1
+    Hlc clock;
+    unsigned long long journal_seq;
+    bool have_seq;              // False until the first sync exports everything
+    cJSON *offsets;             // Log file name -> bytes already read
+    SyncEntry **entries;
+    size_t entry_count;
+    IdMap entry_index;          // Task id -> SyncEntry
+    Task **tasks;
+    size_t task_count;
+    IdMap task_index;           // Task id -> index in tasks + 1 (0 once deleted)
+    char *outbox;               // Records to append to this device's log
+    size_t outbox_len;
+    size_t outbox_cap;
+    SyncStats stats;
+} Sync;
+
+// Helper: double the capacity of a map (or give it its first table)
+static int map_grow(IdMap *m) {
+    size_t cap = m->cap ? m->cap * 2 : 64;
+    char **keys = utils_calloc(cap, sizeof(char *));
+    void **values = utils_calloc(cap, sizeof(void *));
+    if (!keys || !values) {
+        utils_free(keys);
+        utils_free(values);
+        return -1;
+    }
+    for (size_t i = 0; i < m->cap; i++) {
+        if (!m->keys[i]) continue;
+        size_t j = (size_t)utils_fnv1a_str(m->keys[i]) & (cap - 1);
+        while (keys[j]) j = (j + 1) & (cap - 1);
+        keys[j] = m->keys[i];
+        values[j] = m->values[i];
+    }
+    utils_free(m->keys);
+    utils_free(m->values);
+    m->keys = keys;
+    m->values = values;
+    m->cap = cap;
+    return 0;
+}
+
+// Helper: the value slot for a key; inserts a NULL value if asked to.
+// Returns NULL if the key is absent (and not inserted) or on error.
+static void **map_slot(IdMap *m, const char *key, bool insert) {
+    if (insert && (m->count + 1) * 2 > m->cap && map_grow(m) != 0) return NULL;
+    if (!m->cap) return NULL;
+    size_t i = (size_t)utils_fnv1a_str(key) & (m->cap - 1);
+    while (m->keys[i]) {
+        if (strcmp(m->keys[i], key) == 0) return &m->values[i];
+        i = (i + 1) & (m->cap - 1);
+    }
+    if (!insert || !(m->keys[i] = utils_strdup(key))) return NULL;
+    m->values[i] = NULL;
+    m->count++;
+    return &m->values[i];
+}
+
+// Helper: the value for a key, or NULL
+static void *map_get(IdMap *m, const char *key) {
+    void **slot = map_slot(m, key, false);
+    return slot ? *slot : NULL;
+}
+
+static void map_free(IdMap *m) {
+    for (size_t i = 0; i < m->cap; i++) utils_free(m->keys[i]);
+    utils_free(m->keys);
+    utils_free(m->values);
+}
+
+// Helper: index of a device id, adding it to the table if new; -1 on error
+static int device_index(Sync *s, const char *device) {
+    void **slot = map_slot(&s->device_index, device, true);
+    if (!slot) return -1;
+    if (!*slot) {
+        char **devices = utils_realloc(s->devices, (s->device_count + 1) * sizeof(char *));
+        if (!devices) return -1;
+        s->devices = devices;
+        if (!(s->devices[s->device_count] = utils_strdup(device))) return -1;
+        *slot = (void *)(uintptr_t)++s->device_count;
+    }
+    return (int)((uintptr_t)*slot - 1);
+}
+
+static int hlc_compare(const Sync *s, Hlc a, Hlc b) {
+    if (a.wall != b.wall) return a.wall < b.wall ? -1 : 1;
+    if (a.counter != b.counter) return a.counter < b.counter ? -1 : 1;
+    return strcmp(s->devices[a.device], s->devices[b.device]);
+}
+
+// Helper: keep the counter within its printed width
+static void hlc_normalize(Hlc *c) {
+    if (c->counter > HLC_MAX_COUNTER) {
+        c->wall++;
+        c->counter = 0;
+    }
+}
+
+// Helper: stamp a local change made at a physical time (milliseconds)
+static Hlc hlc_tick(Sync *s, unsigned long long ms) {
+    if (ms > s->clock.wall) {
+        s->clock.wall = ms;
+        s->clock.counter = 0;
+    } else {
+        s->clock.counter++;
+        hlc_normalize(&s->clock);
+    }
+    s->clock.device = 0;
+    return s->clock;
+}
+
+// Helper: move the clock past a stamp read from another device
+static void hlc_receive(Sync *s, Hlc remote) {
+    unsigned long long now = (unsigned long long)app_clock_now() * 1000;
+    Hlc *c = &s->clock;
+    if (now > c->wall && now > remote.wall) {
+        c->wall = now;
+        c->counter = 0;
+    } else if (remote.wall > c->wall) {
+        c->wall = remote.wall;
+        c->counter = remote.counter + 1;
+    } else if (remote.wall == c->wall) {
+        c->counter = (remote.counter > c->counter ? remote.counter : c->counter) + 1;
+    } else {
+        c->counter++;
+    }
+    c->device = 0;
+    hlc_normalize(c);
+}
+
+static void hlc_format(const Sync *s, Hlc c, char *buf) {
+    snprintf(buf, HLC_BUFSZ, "%012llx.%04x.%s", c.wall, c.counter, s->devices[c.device]);
+}
+
+// Helper: parse a printed HLC; 0 on success, -1 if malformed
+static int hlc_parse(Sync *s, const char *str, Hlc *out) {
+    unsigned long long wall;
+    unsigned int counter;
+    int used = 0;
+    if (!str || sscanf(str, "%12llx.%4x.%n", &wall, &counter, &used) != 2 || used == 0 || !str[used]) return -1;
+    int device = device_index(s, str + used);
+    if (device < 0) return -1;
+    out->wall = wall;
+    out->counter = counter;
+    out->device = (unsigned int)device;
+    return 0;
+}
+
+// Helper: one field of a task object (caller deletes)
+static cJSON *field_value(const cJSON *obj, const SyncField *f) {
+    if (!f->keys[1]) {
+        cJSON *item = cJSON_GetObjectItem(obj, f->keys[0]);
+        return item ? cJSON_Duplicate(item, true) : cJSON_CreateNull();
+    }
+    cJSON *group = cJSON_CreateObject();
+    for (size_t k = 0; group && k < 3 && f->keys[k]; k++) {
+        cJSON *item = cJSON_GetObjectItem(obj, f->keys[k]);
+        if (item) cJSON_AddItemToObject(group, f->keys[k], cJSON_Duplicate(item, true));
+    }
+    return group;
+}
+
+// Helper: set one field of a task object from a value made by field_value()
+static void field_apply(cJSON *obj, const SyncField *f, const cJSON *value) {
+    for (size_t k = 0; k < 3 && f->keys[k]; k++) cJSON_DeleteItemFromObject(obj, f->keys[k]);
+    if (!f->keys[1]) {
+        cJSON_AddItemToObject(obj, f->keys[0], cJSON_Duplicate(value, true));
+        return;
+    }
+    for (size_t k = 0; k < 3 && f->keys[k]; k++) {
+        cJSON *item = cJSON_GetObjectItem(value, f->keys[k]);
+        if (item) cJSON_AddItemToObject(obj, f->keys[k], cJSON_Duplicate(item, true));
+    }
+}
+
+// Helper: index of a field name, or -1
+static int field_index(const char *name) {
+    for (size_t i = 0; i < FIELD_COUNT; i++) {
+        if (strcmp(FIELDS[i].name, name) == 0) return (int)i;
+    }
+    return -1;
+}
+
+// Helper: whether two JSON values print the same
+static bool same_value(const cJSON *a, const cJSON *b) {
+    char *pa = cJSON_PrintUnformatted(a);
+    char *pb = cJSON_PrintUnformatted(b);
+    bool same = pa && pb && strcmp(pa, pb) == 0;
+    utils_free(pa);
+    utils_free(pb);
+    return same;
+}
+
+// Helper: the entry for a task id, created if asked to
+static SyncEntry *entry_get(Sync *s, const char *id, bool create) {
+    SyncEntry *e = map_get(&s->entry_index, id);
+    if (e || !create) return e;
+    if (s->entry_count % 256 == 0) {
+        SyncEntry **entries = utils_realloc(s->entries, (s->entry_count + 256) * sizeof(SyncEntry *));
+        if (!entries) return NULL;
+        s->entries = entries;
+    }
+    void **slot = map_slot(&s->entry_index, id, true);
+    if (!slot || !(e = utils_calloc(1, sizeof(SyncEntry))) || !(e->id = utils_strdup(id))) {
+        utils_free(e);
+        return NULL;
+    }
+    s->entries[s->entry_count++] = e;
+    *slot = e;
+    return e;
+}
+
+// Helper: the local task with an id, or NULL
+static Task *task_get(Sync *s, const char *id) {
+    uintptr_t i = (uintptr_t)map_get(&s->task_index, id);
+    return i ? s->tasks[i - 1] : NULL;
+}
+
+// Helper: queue a record for this device's log
+static int outbox_add(Sync *s, cJSON *rec) {
+    char *line = cJSON_PrintUnformatted(rec);
+    cJSON_Delete(rec);
+    if (!line) return -1;
+    size_t len = strlen(line);
+    if (s->outbox_len + len + 1 > s->outbox_cap) {
+        size_t cap = (s->outbox_cap + len + 1) * 2;
+        char *buf = utils_realloc(s->outbox, cap);
+        if (!buf) {
+            utils_free(line);
+            return -1;
+        }
+        s->outbox = buf;
+        s->outbox_cap = cap;
+    }
+    memcpy(s->outbox + s->outbox_len, line, len);
+    s->outbox[s->outbox_len + len] = '\n';
+    s->outbox_len += len + 1;
+    utils_free(line);
+    s->stats.sent++;
+    return 0;
+}
+
+// Helper: start a record for a task change
+static cJSON *record_new(const Sync *s, Hlc stamp, const char *id) {
+    char hlc[HLC_BUFSZ];
+    hlc_format(s, stamp, hlc);
+    cJSON *rec = cJSON_CreateObject();
+    if (rec) {
+        cJSON_AddStringToObject(rec, "hlc", hlc);
+        cJSON_AddStringToObject(rec, "id", id);
+    }
+    return rec;
+}
+
+// Helper: queue the fields of a local task that differ from the last sync
+static int export_task(Sync *s, const Task *t, unsigned long long ms) {
+    SyncEntry *e = entry_get(s, t->id, true);
+    cJSON *obj = e ? task_to_cjson(t) : NULL;
+    if (!obj) return -1;
+
+    cJSON *fields = NULL;
+    Hlc stamp = {0, 0, 0};
+    for (size_t i = 0; i < FIELD_COUNT; i++) {
+        cJSON *value = field_value(obj, &FIELDS[i]);
+        cJSON *old = e->base ? field_value(e->base, &FIELDS[i]) : NULL;
+        if (value && (!old || !same_value(value, old))) {
+            if (!fields) {
+                fields = cJSON_CreateObject();
+                stamp = hlc_tick(s, ms);
+            }
+            cJSON_AddItemToObject(fields, FIELDS[i].name, value);
+            e->clocks[i] = stamp;
+            value = NULL;
+        }
+        cJSON_Delete(value);
+        cJSON_Delete(old);
+    }
+    cJSON_Delete(e->base);
+    e->base = obj;
+    if (!fields) return 0;
+
+    e->deleted.wall = 0;
+    cJSON *rec = record_new(s, stamp, t->id);
+    if (!rec) {
+        cJSON_Delete(fields);
+        return -1;
+    }
+    cJSON_AddItemToObject(rec, "fields", fields);
+    return outbox_add(s, rec);
+}
+
+// Helper: queue the deletion of a task synced before
+static int export_delete(Sync *s, SyncEntry *e, unsigned long long ms) {
+    e->deleted = hlc_tick(s, ms);
+    cJSON_Delete(e->base);
+    e->base = NULL;
+    cJSON *rec = record_new(s, e->deleted, e->id);
+    if (!rec) return -1;
+    cJSON_AddTrueToObject(rec, "deleted");
+    return outbox_add(s, rec);
+}
+
+// A task id changed locally and when
+typedef struct {
+    const char *id;
+    unsigned long long ms;
+} Changed;
+
+static int compare_changed(const void *a, const void *b) {
+    const Changed *x = a, *y = b;
+    return (x->ms > y->ms) - (x->ms < y->ms);
+}
+
+// Helper: collect the ids the journal changed since the last sync, oldest
+// change first. Sets *gap if the journal no longer reaches back that far.
+static int changed_since(Sync *s, IdMap *ids, Changed **out, size_t *count, bool *gap) {
+    unsigned long long since = s->journal_seq;
+    *gap = false;
+    for (;;) {
+        unsigned long long next = since;
+        cJSON *events = journal_changes(since, 0, &next, gap);
+        if (!events) return -1;
+        cJSON *ev;
+        cJSON_ArrayForEach(ev, events) {
+            cJSON *id = cJSON_GetObjectItem(ev, "id");
+            cJSON *ts = cJSON_GetObjectItem(ev, "ts");
+            void **slot = cJSON_IsString(id) ? map_slot(ids, id->valuestring, true) : NULL;
+            if (!slot) continue;
+            uintptr_t ms = cJSON_IsNumber(ts) ? (uintptr_t)ts->valuedouble * 1000 : 1;
+            if (ms > (uintptr_t)*slot) *slot = (void *)ms;
+        }
+        bool done = cJSON_GetArraySize(events) == 0 || *gap;
+        cJSON_Delete(events);
+        since = next;
+        if (done) break;
+    }
+    s->journal_seq = since;
+    if (*gap) return 0;
+
+    *out = utils_malloc((ids->count ? ids->count : 1) * sizeof(Changed));
+    if (!*out) return -1;
+    *count = 0;
+    for (size_t i = 0; i < ids->cap; i++) {
+        if (ids->keys[i]) (*out)[(*count)++] = (Changed){ids->keys[i], (uintptr_t)ids->values[i]};
+    }
+    qsort(*out, *count, sizeof(Changed), compare_changed);
+    return 0;
+}
+
+// Helper: queue every local change since the last sync
+static int export_changes(Sync *s) {
+    unsigned long long now = (unsigned long long)app_clock_now() * 1000;
+    IdMap ids = {0};
+    Changed *changed = NULL;
+    size_t count = 0;
+    bool gap = false;
+    int rc = 0;
+
+    // The journal says which tasks changed; without it, compare them all
+    bool full = !s->have_seq;
+    unsigned long long seq = journal_last_seq();
+    if (!full && changed_since(s, &ids, &changed, &count, &gap) != 0) rc = -1;
+    if (gap || !s->have_seq) {
+        full = true;
+        s->journal_seq = seq;
+    }
+
+    if (rc == 0 && full) {
+        for (size_t i = 0; i < s->task_count && rc == 0; i++) rc = export_task(s, s->tasks[i], now);
+        for (size_t i = 0; i < s->entry_count && rc == 0; i++) {
+            SyncEntry *e = s->entries[i];
+            if (e->base && !task_get(s, e->id)) rc = export_delete(s, e, now);
+        }
+    } else {
+        for (size_t i = 0; i < count && rc == 0; i++) {
+            Task *t = task_get(s, changed[i].id);
+            SyncEntry *e = entry_get(s, changed[i].id, false);
+            if (t) {
+                rc = export_task(s, t, changed[i].ms);
+            } else if (e && e->base) {
+                rc = export_delete(s, e, changed[i].ms);
+            }
+        }
+    }
+    utils_free(changed);
+    map_free(&ids);
+    s->have_seq = true;
+    return rc;
+}
+
+// Helper: append the queued records to this device's log
+static int flush_outbox(Sync *s) {
+    if (s->outbox_len == 0) return 0;
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/%s%s", s->dir, s->devices[0], SYNC_LOG_SUFFIX);
+    int fd = open(path, O_WRONLY | O_APPEND | O_CREAT, 0644);
+    if (fd < 0) {
+        perror(path);
+        return -1;
+    }
+    // End a line an interrupted sync left unfinished, so readers skip only it
+    struct stat st;
+    char last = '\n';
+    bool ok = fstat(fd, &st) == 0;
+    if (ok && st.st_size > 0 && pread(fd, &last, 1, st.st_size - 1) == 1 && last != '\n') {
+        ok = write(fd, "\n", 1) == 1;
+    }
+    for (size_t done = 0; ok && done < s->outbox_len;) {
+        ssize_t n = write(fd, s->outbox + done, s->outbox_len - done);
+        if (n < 0 && errno == EINTR) continue;
+        ok = n > 0;
+        if (ok) done += (size_t)n;
+    }
+    ok = fsync(fd) == 0 && ok;
+    close(fd);
+    if (!ok) perror(path);
+    return ok ? 0 : -1;
+}
+
+// Helper: replace or add a local task
+static int put_task(Sync *s, Task *t) {
+    void **slot = map_slot(&s->task_index, t->id, true);
+    if (!slot) return -1;
+    uintptr_t i = (uintptr_t)*slot;
+    if (i && s->tasks[i - 1]) {
+        task_free(s->tasks[i - 1]);
+        s->tasks[i - 1] = t;
+        return 0;
+    }
+    Task **tasks = utils_realloc(s->tasks, (s->task_count + 1) * sizeof(Task *));
+    if (!tasks) return -1;
+    s->tasks = tasks;
+    s->tasks[s->task_count++] = t;
+    *slot = (void *)(uintptr_t)s->task_count;
+    return 0;
+}
+
+// Helper: apply a delete from another device
+static int apply_delete(Sync *s, const char *id, Hlc stamp) {
+    SyncEntry *e = entry_get(s, id, true);
+    if (!e) return -1;
+    if (e->deleted.wall) return 0;
+    e->deleted = stamp;
+    cJSON_Delete(e->base);
+    e->base = NULL;
+    void **slot = map_slot(&s->task_index, id, false);
+    if (slot && *slot) {
+        uintptr_t i = (uintptr_t)*slot;
+        task_free(s->tasks[i - 1]);
+        s->tasks[i - 1] = NULL;
+        *slot = NULL;
+        s->stats.applied++;
+    }
+    return 0;
+}
+
+// Helper: apply field changes from another device; older fields lose
+static int apply_fields(Sync *s, const char *id, Hlc stamp, const cJSON *fields) {
+    SyncEntry *e = entry_get(s, id, false);
+    if (e && e->deleted.wall) return 0;   // Deletes win
+
+    Task *local = task_get(s, id);
+    cJSON *obj = local ? task_to_cjson(local) : cJSON_CreateObject();
+    if (!obj) return -1;
+    if (!local) cJSON_AddStringToObject(obj, "id", id);
+    bool won[FIELD_COUNT] = {false};
+    bool any = false;
+    const cJSON *value;
+    cJSON_ArrayForEach(value, fields) {
+        int f = value->string ? field_index(value->string) : -1;
+        if (f < 0 || (e && e->clocks[f].wall && hlc_compare(s, stamp, e->clocks[f]) <= 0)) continue;
+        field_apply(obj, &FIELDS[f], value);
+        won[f] = any = true;
+    }
+    // Fields for a task this device never had are useless unless complete
+    Task *t = any ? task_from_cjson(obj) : NULL;
+    cJSON_Delete(obj);
+    if (!t) return 0;
+
+    if (!e && !(e = entry_get(s, id, true))) {
+        task_free(t);
+        return -1;
+    }
+    for (size_t i = 0; i < FIELD_COUNT; i++) {
+        if (won[i]) e->clocks[i] = stamp;
+    }
+    cJSON_Delete(e->base);
+    e->base = task_to_cjson(t);
+    if (put_task(s, t) != 0) {
+        task_free(t);
+        return -1;
+    }
+    s->stats.applied++;
+    return 0;
+}
+
+// Helper: apply one log line from another device; malformed lines are skipped
+static int apply_line(Sync *s, const char *line, size_t len) {
+    cJSON *rec = cJSON_ParseWithLength(line, len);
+    cJSON *id = cJSON_GetObjectItem(rec, "id");
+    cJSON *fields = cJSON_GetObjectItem(rec, "fields");
+    Hlc stamp;
+    int rc = 0;
+    if (cJSON_IsString(id) && hlc_parse(s, cJSON_GetStringValue(cJSON_GetObjectItem(rec, "hlc")), &stamp) == 0) {
+        hlc_receive(s, stamp);
+        if (cJSON_IsTrue(cJSON_GetObjectItem(rec, "deleted"))) {
+            rc = apply_delete(s, id->valuestring, stamp);
+        } else if (cJSON_IsObject(fields)) {
+            rc = apply_fields(s, id->valuestring, stamp, fields);
+        }
+    }
+    cJSON_Delete(rec);
+    return rc;
+}
+
+// Helper: apply what one device appended since the last sync
+static int import_log(Sync *s, const char *name) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/%s", s->dir, name);
+    cJSON *seen = cJSON_GetObjectItem(s->offsets, name);
+    long long offset = cJSON_IsNumber(seen) ? (long long)seen->valuedouble : 0;
+
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0) close(fd);
+        perror(path);
+        return -1;
+    }
+    s->stats.devices++;
+    if (st.st_size < offset) offset = 0;   // Log was recreated; merging again is harmless
+    size_t len = (size_t)(st.st_size - offset);
+    char *buf = utils_malloc(len + 1);
+    size_t got = 0;
+    while (buf && got < len) {
+        ssize_t n = pread(fd, buf + got, len - got, offset + (off_t)got);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        got += (size_t)n;
+    }
+    close(fd);
+    if (!buf) return -1;
+
+    // Only whole lines; a line still being written is read next time
+    int rc = 0;
+    size_t start = 0;
+    for (size_t i = 0; i < got && rc == 0; i++) {
+        if (buf[i] != '\n') continue;
+        if (i > start) rc = apply_line(s, buf + start, i - start);
+        start = i + 1;
+    }
+    utils_free(buf);
+    if (rc != 0) return -1;
+
+    cJSON *pos = cJSON_CreateNumber((double)(offset + (long long)start));
+    if (!pos) return -1;
+    if (seen) {
+        cJSON_ReplaceItemInObject(s->offsets, name, pos);
+    } else {
+        cJSON_AddItemToObject(s->offsets, name, pos);
+    }
+    return 0;
+}
+
+// Helper: apply every other device's new records
+static int import_changes(Sync *s) {
+    DIR *d = opendir(s->dir);
+    if (!d) {
+        perror(s->dir);
+        return -1;
+    }
+    size_t own_len = strlen(s->devices[0]);
+    size_t suffix_len = strlen(SYNC_LOG_SUFFIX);
+    int rc = 0;
+    struct dirent *ent;
+    while (rc == 0 && (ent = readdir(d)) != NULL) {
+        size_t len = strlen(ent->d_name);
+        if (len <= suffix_len || strcmp(ent->d_name + len - suffix_len, SYNC_LOG_SUFFIX) != 0) continue;
+        if (len == own_len + suffix_len && strncmp(ent->d_name, s->devices[0], own_len) == 0) continue;
+        rc = import_log(s, ent->d_name);
+    }
+    closedir(d);
+    return rc;
+}
+
+// Helper: read ~/.todo-app/sync.json, or start a new state with a new device id
+static int load_state(Sync *s) {
+    char *path = storage_path(SYNC_STATE_FILE);
+    if (!path) return -1;
+    size_t len = 0;
+    char *buf = utils_read_file(path, &len);
+    bool missing = !buf && errno == ENOENT;
+    utils_free(path);
+    cJSON *root = NULL;
+    if (!missing) {
+        root = buf ? cJSON_ParseWithLength(buf, len) : NULL;
+        utils_free(buf);
+        if (!root) {
+            fprintf(stderr, "Cannot read %s; remove it to start over.\n", SYNC_STATE_FILE);
+            return -1;
+        }
+    }
+
+    const char *device = cJSON_GetStringValue(cJSON_GetObjectItem(root, "device"));
+    char fresh[37];
+    if (!device) {
+        uuid_t bin;
+        uuid_generate(bin);
+        uuid_unparse_lower(bin, fresh);
+        device = fresh;
+    }
+    int rc = device_index(s, device) == 0 ? 0 : -1;
+    const char *dir = cJSON_GetStringValue(cJSON_GetObjectItem(root, "dir"));
+    if (rc == 0 && dir && !(s->dir = utils_strdup(dir))) rc = -1;
+    if (rc == 0 && cJSON_GetObjectItem(root, "clock")) {
+        rc = hlc_parse(s, cJSON_GetStringValue(cJSON_GetObjectItem(root, "clock")), &s->clock);
+    }
+    cJSON *seq = cJSON_GetObjectItem(root, "journal_seq");
+    if (cJSON_IsNumber(seq)) {
+        s->journal_seq = (unsigned long long)seq->valuedouble;
+        s->have_seq = true;
+    }
+    cJSON *offsets = cJSON_GetObjectItem(root, "offsets");
+    s->offsets = cJSON_IsObject(offsets) ? cJSON_Duplicate(offsets, true) : cJSON_CreateObject();
+    if (!s->offsets) rc = -1;
+
+    cJSON *item;
+    cJSON_ArrayForEach(item, cJSON_GetObjectItem(root, "tasks")) {
+        if (rc != 0) break;
+        const char *id = cJSON_GetStringValue(cJSON_GetObjectItem(item, "id"));
+        SyncEntry *e = id ? entry_get(s, id, true) : NULL;
+        if (!e) {
+            rc = -1;
+            break;
+        }
+        cJSON *base = cJSON_GetObjectItem(item, "base");
+        if (cJSON_IsObject(base)) e->base = cJSON_Duplicate(base, true);
+        cJSON *clocks = cJSON_GetObjectItem(item, "clocks");
+        cJSON *clock;
+        cJSON_ArrayForEach(clock, clocks) {
+            int f = clock->string ? field_index(clock->string) : -1;
+            if (f >= 0 && hlc_parse(s, cJSON_GetStringValue(clock), &e->clocks[f]) != 0) rc = -1;
+        }
+        cJSON *deleted = cJSON_GetObjectItem(item, "deleted");
+        if (deleted && hlc_parse(s, cJSON_GetStringValue(deleted), &e->deleted) != 0) rc = -1;
+    }
+    cJSON_Delete(root);
+    if (rc != 0) fprintf(stderr, "Cannot read %s; remove it to start over.\n", SYNC_STATE_FILE);
+    return rc;
+}
+
+// Helper: build the JSON for the sync state
+static cJSON *state_to_cjson(Sync *s) {
+    char hlc[HLC_BUFSZ];
+    cJSON *root = cJSON_CreateObject();
+    cJSON *tasks = root ? cJSON_CreateArray() : NULL;
+    if (!tasks) {
+        cJSON_Delete(root);
+        return NULL;
+    }
+    cJSON_AddStringToObject(root, "device", s->devices[0]);
+    cJSON_AddStringToObject(root, "dir", s->dir);
+    hlc_format(s, s->clock, hlc);
+    cJSON_AddStringToObject(root, "clock", hlc);
+    cJSON_AddNumberToObject(root, "journal_seq", (double)s->journal_seq);
+    cJSON_AddItemToObject(root, "offsets", cJSON_Duplicate(s->offsets, true));
+    cJSON_AddItemToObject(root, "tasks", tasks);
+
+    for (size_t i = 0; i < s->entry_count; i++) {
+        SyncEntry *e = s->entries[i];
+        cJSON *item = cJSON_CreateObject();
+        cJSON *clocks = item ? cJSON_CreateObject() : NULL;
+        if (!clocks) {
+            cJSON_Delete(item);
+            cJSON_Delete(root);
+            return NULL;
+        }
+        cJSON_AddStringToObject(item, "id", e->id);
+        if (e->base) cJSON_AddItemToObject(item, "base", cJSON_Duplicate(e->base, true));
+        for (size_t f = 0; f < FIELD_COUNT; f++) {
+            if (!e->clocks[f].wall) continue;
+            hlc_format(s, e->clocks[f], hlc);
+            cJSON_AddStringToObject(clocks, FIELDS[f].name, hlc);
+        }
+        cJSON_AddItemToObject(item, "clocks", clocks);
+        if (e->deleted.wall) {
+            hlc_format(s, e->deleted, hlc);
+            cJSON_AddStringToObject(item, "deleted", hlc);
+        }
+        cJSON_AddItemToArray(tasks, item);
+    }
+    return root;
+}
+
+// Helper: replace ~/.todo-app/sync.json; it must survive a crash, since a
+// lost state would send every task again with new clocks
+static int save_state(Sync *s) {
+    cJSON *root = state_to_cjson(s);
+    char *json = root ? cJSON_PrintUnformatted(root) : NULL;
+    cJSON_Delete(root);
+    char *path = storage_path(SYNC_STATE_FILE);
+    int rc = (json && path) ? utils_write_file_atomic(path, json, strlen(json)) : -1;
+    utils_free(json);
+    utils_free(path);
+    return rc;
+}
+
+// Helper: take ~/.todo-app/sync.lock; returns the descriptor holding it, or -1
+static int lock_state(void) {
+    char *path = storage_path(SYNC_LOCK_FILE);
+    int fd = path ? open(path, O_RDWR | O_CREAT, 0600) : -1;
+    utils_free(path);
+    if (fd < 0) return -1;
+    struct flock fl;
+    memset(&fl, 0, sizeof(fl));
+    fl.l_type = F_WRLCK;
+    fl.l_whence = SEEK_SET;
+    if (fcntl(fd, F_SETLK, &fl) != 0) {
+        fprintf(stderr, "Another sync is running.\n");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void sync_free(Sync *s) {
+    utils_free(s->dir);
+    for (size_t i = 0; i < s->device_count; i++) utils_free(s->devices[i]);
+    utils_free(s->devices);
+    map_free(&s->device_index);
+    cJSON_Delete(s->offsets);
+    for (size_t i = 0; i < s->entry_count; i++) {
+        utils_free(s->entries[i]->id);
+        cJSON_Delete(s->entries[i]->base);
+        utils_free(s->entries[i]);
+    }
+    utils_free(s->entries);
+    map_free(&s->entry_index);
+    storage_free_tasks(s->tasks, s->task_count);
+    map_free(&s->task_index);
+    utils_free(s->outbox);
+}
+
+// Helper: point the state at a directory; a new one starts from scratch
+static int use_dir(Sync *s, const char *dir) {
+    if (dir && (!s->dir || strcmp(s->dir, dir) != 0)) {
+        char *copy = utils_strdup(dir);
+        cJSON *offsets = cJSON_CreateObject();
+        if (!copy || !offsets) {
+            utils_free(copy);
+            cJSON_Delete(offsets);
+            return -1;
+        }
+        utils_free(s->dir);
+        s->dir = copy;
+        cJSON_Delete(s->offsets);
+        s->offsets = offsets;
+        s->have_seq = false;
+        for (size_t i = 0; i < s->entry_count; i++) {
+            cJSON_Delete(s->entries[i]->base);
+            s->entries[i]->base = NULL;
+        }
+    }
+    if (!s->dir) {
+        fprintf(stderr, "No sync directory yet; run `smartodo sync DIR` once.\n");
+        return -1;
+    }
+    // Remember an absolute path, so later syncs work from any directory
+    char *abs = NULL;
+    if ((mkdir(s->dir, 0755) != 0 && errno != EEXIST) || !(abs = realpath(s->dir, NULL))) {
+        perror(s->dir);
+        return -1;
+    }
+    utils_free(s->dir);
+    s->dir = abs;
+    return 0;
+}
+
+// Helper: load the local tasks and index them by id
+static int load_tasks(Sync *s) {
+    s->tasks = storage_load_tasks(&s->task_count);
+    if (!s->tasks) {
+        fprintf(stderr, "Failed to load tasks.\n");
+        return -1;
+    }
+    for (size_t i = 0; i < s->task_count; i++) {
+        void **slot = map_slot(&s->task_index, s->tasks[i]->id, true);
+        if (!slot) return -1;
+        *slot = (void *)(uintptr_t)(i + 1);
+    }
+    return 0;
+}
+
+// Helper: save the local tasks after applying remote changes
+static int save_tasks(Sync *s) {
+    size_t n = 0;
+    for (size_t i = 0; i < s->task_count; i++) {
+        if (s->tasks[i]) s->tasks[n++] = s->tasks[i];
+    }
+    s->task_count = n;
+    if (storage_save_tasks(s->tasks, s->task_count) != 0) {
+        fprintf(stderr, "Failed to save tasks.\n");
+        return -1;
+    }
+    return 0;
+}
+
+int sync_run(const char *dir, SyncStats *stats) {
+    if (storage_init() != 0) {
+        fprintf(stderr, "Failed to initialize storage.\n");
+        return -1;
+    }
+    int lock_fd = lock_state();
+    if (lock_fd < 0) return -1;
+
+    // Export before import: local changes get stamped before remote clocks
+    // move this device's clock forward
+    Sync s;
+    memset(&s, 0, sizeof(s));
+    int rc = load_state(&s);
+    if (rc == 0) rc = use_dir(&s, dir);
+    if (rc == 0) rc = load_tasks(&s);
+    if (rc == 0) rc = export_changes(&s);
+    if (rc == 0) rc = flush_outbox(&s);
+    if (rc == 0) rc = import_changes(&s);
+    if (rc == 0 && s.stats.applied > 0) rc = save_tasks(&s);
+    if (rc == 0) rc = save_state(&s);
+    if (stats) *stats = s.stats;
+
+    sync_free(&s);
+    close(lock_fd);
+    return rc;
+}
+
+int sync_main(int argc, char **argv) {
+    if (argc > 2 || (argc == 2 && argv[1][0] == '-')) {
+        fprintf(stderr, "Usage: smartodo sync [DIR]\n");
+        return 2;
+    }
+    SyncStats stats;
+    if (sync_run(argc == 2 ? argv[1] : NULL, &stats) != 0) return 1;
+    printf("Synced with %zu device(s): sent %zu change(s), applied %zu change(s).\n",
+           stats.devices, stats.sent, stats.applied);
+    return 0;
+}
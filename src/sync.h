@@ -0,0 +1,51 @@
+#ifndef TODO_APP_SYNC_H
+#define TODO_APP_SYNC_H
+
+#include <stddef.h>
+
+/**
+ * Directory sync (`smartodo sync [DIR]`). Devices share a directory, e.g. a
+ * synced cloud folder or a USB stick, and each appends its changes to its
+ * own log there:
+ *   DIR/<device>.jsonl
+ * One record per line, stamped with a hybrid logical clock (HLC):
+ *   {"hlc":"...","id":"...","fields":{"name":...,"due":{...},...}}
+ *   {"hlc":"...","id":"...","deleted":true}
+ * A sync appends the local changes made since the last sync, then reads
+ * only the bytes other devices appended since then. Fields merge one by one
+ * (the newest HLC wins), so edits to different fields of a task on two
+ * devices both survive; a delete wins over any edit of the same task.
+ *
+ * Local sync state (device id, clock, read offsets and, per task, the
+ * last synced fields and their clocks) lives in ~/.todo-app/sync.json.
+ */
+
+#define SYNC_STATE_FILE "sync.json"
+#define SYNC_LOCK_FILE  "sync.lock"
+#define SYNC_LOG_SUFFIX ".jsonl"
+
+// What one sync did
+typedef struct {
+    size_t devices;   // Other devices whose logs were read
+    size_t sent;      // Changes appended to this device's log
+    size_t applied;   // Changes from other devices applied to local tasks
+} SyncStats;
+
+/**
+ * Exchange changes with the other devices sharing a directory.
+ * @param dir Shared directory (created if missing), or NULL for the one
+ *        used last time; switching directories resends every task
+ * @param stats[out] What the sync did (may be NULL)
+ * @return 0 on success, -1 on error (a message is printed to stderr)
+ */
+int sync_run(const char *dir, SyncStats *stats);
+
+/**
+ * Entry point for `smartodo sync [DIR]`.
+ * @param argc Argument count, starting at "sync"
+ * @param argv Arguments
+ * @return Exit status: 0 on success, 1 on error, 2 on bad usage
+ */
+int sync_main(int argc, char **argv);
+
+#endif // TODO_APP_SYNC_H
@@ -1,10 +1,20 @@
+// strcasecmp() is POSIX and strcasestr() a GNU extension, not ISO C
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include "task.h"
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <uuid/uuid.h>
 #include <cjson/cJSON.h>
 #include <time.h>
 #include "utils.h"
+#include "app_clock.h"
+#include "tz_cache.h"
+#include "recurrence.h"
+#include <stdio.h>
 
 // Helper: convert Priority to string
 static const char *priority_to_str(Priority p) {
@@ -28,12 +38,33 @@ static const char *status_to_str(Status s) {
     return s == STATUS_DONE ? "done" : "pending";
 }
 
+// Helper: convert DueKind to string
+static const char *due_kind_to_str(DueKind k) {
+    return k == DUE_DATE ? "date" : "datetime";
+}
+
+// Helper: format a UTC offset in minutes as +hh:mm
+static void format_tz_offset(int minutes, char *buf, size_t size) {
+    char sign = minutes < 0 ? '-' : '+';
+    if (minutes < 0) minutes = -minutes;
+    snprintf(buf, size, "%c%02d:%02d", sign, minutes / 60, minutes % 60);
+}
+
+// Helper: parse +hh:mm into minutes; returns 0 for malformed input
+static int parse_tz_offset(const char *s) {
+    int h, m;
+    char sign;
+    if (sscanf(s, "%c%2d:%2d", &sign, &h, &m) != 3 || (sign != '+' && sign != '-')) return 0;
+    int minutes = h * 60 + m;
+    return sign == '-' ? -minutes : minutes;
+}
+
 // Helper: parse string to Status
 static Status str_to_status(const char *s) {
     return strcmp(s, "done") == 0 ? STATUS_DONE : STATUS_PENDING;
 }
 
-Task *task_create(const char *name, time_t due, const char *tags[], size_t tag_count, Priority priority) {
+Task *task_create(const char *name, time_t due, DueKind due_kind, const char *tags[], size_t tag_count, Priority priority) {
     Task *t = utils_calloc(1, sizeof(Task));
     if (!t) return NULL;
     
@@ -44,30 +75,31 @@ Task *task_create(const char *name, time_t due, const char *tags[], size_t tag_c
     uuid_unparse_lower(binuuid, uuid_str);
     t->id = utils_strdup(uuid_str);
     if (!t->id) {
-        free(t);
+        utils_free(t);
         return NULL;
     }
     
     t->name = utils_strdup(name);
     if (!t->name) {
-        free(t->id);
-        free(t);
+        utils_free(t->id);
+        utils_free(t);
         return NULL;
     }
     
-    t->created = time(NULL);
-    t->due = due;
+    t->created = app_clock_now();
+    task_set_due(t, due, due_kind);
     t->priority = priority;
     t->status = STATUS_PENDING;
     t->note = NULL; // Initialize note to NULL
+    t->recur = NULL;
 
     t->tag_count = tag_count;
     if (tag_count > 0) {
         t->tags = utils_malloc(tag_count * sizeof(char*));
         if (!t->tags) {
-            free(t->name);
-            free(t->id);
-            free(t);
+            utils_free(t->name);
+            utils_free(t->id);
+            utils_free(t);
             return NULL;
         }
         
@@ -76,12 +108,12 @@ Task *task_create(const char *name, time_t due, const char *tags[], size_t tag_c
             if (!t->tags[i]) {
                 // Clean up already allocated tags
                 for (size_t j = 0; j < i; ++j) {
-                    free(t->tags[j]);
+                    utils_free(t->tags[j]);
                 }
-                free(t->tags);
-                free(t->name);
-                free(t->id);
-                free(t);
+                utils_free(t->tags);
+                utils_free(t->name);
+                utils_free(t->id);
+                utils_free(t);
                 return NULL;
             }
         }
@@ -92,11 +124,11 @@ Task *task_create(const char *name, time_t due, const char *tags[], size_t tag_c
     // Set default project
     t->project = utils_strdup("default");
     if (!t->project) {
-        for (size_t j = 0; j < t->tag_count; ++j) free(t->tags[j]);
-        free(t->tags);
-        free(t->name);
-        free(t->id);
-        free(t);
+        for (size_t j = 0; j < t->tag_count; ++j) utils_free(t->tags[j]);
+        utils_free(t->tags);
+        utils_free(t->name);
+        utils_free(t->id);
+        utils_free(t);
         return NULL;
     }
 
@@ -105,40 +137,45 @@ Task *task_create(const char *name, time_t due, const char *tags[], size_t tag_c
 
 void task_free(Task *t) {
     if (!t) return;
-    free(t->id);
-    free(t->name);
+    utils_free(t->id);
+    utils_free(t->name);
     for (size_t i = 0; i < t->tag_count; ++i) {
-        free(t->tags[i]);
+        utils_free(t->tags[i]);
     }
-    free(t->tags);
-    free(t->project);
-    free(t->note); // Free the note if it exists
-    free(t);
+    utils_free(t->tags);
+    utils_free(t->project);
+    utils_free(t->note); // Free the note if it exists
+    utils_free(t->recur);
+    utils_free(t);
 }
 
-char *task_to_json(const Task *t) {
+cJSON *task_to_cjson(const Task *t) {
     cJSON *obj = cJSON_CreateObject();
     if (!obj) return NULL;
 
     cJSON_AddStringToObject(obj, "id", t->id);
     cJSON_AddStringToObject(obj, "name", t->name);
 
-    char *created_str = utils_time_to_iso8601(t->created);
-    if (!created_str) {
+    char created_str[UTILS_ISO8601_BUFSZ];
+    if (!utils_format_iso8601(t->created, created_str)) {
         cJSON_Delete(obj);
         return NULL;
     }
     cJSON_AddStringToObject(obj, "created", created_str);
-    free(created_str);
 
     if (t->due > 0) {
-        char *due_str = utils_time_to_iso8601(t->due);
-        if (!due_str) {
+        char due_str[UTILS_ISO8601_BUFSZ];
+        if (!utils_format_iso8601(t->due, due_str)) {
             cJSON_Delete(obj);
             return NULL;
         }
         cJSON_AddStringToObject(obj, "due", due_str);
-        free(due_str);
+        cJSON_AddStringToObject(obj, "due_kind", due_kind_to_str(t->due_kind));
+        if (t->due_kind == DUE_DATETIME) {
+            char tz_str[16];
+            format_tz_offset(t->due_tz, tz_str, sizeof(tz_str));
+            cJSON_AddStringToObject(obj, "due_tz", tz_str);
+        }
     } else {
         cJSON_AddNullToObject(obj, "due");
     }
@@ -169,6 +206,17 @@ char *task_to_json(const Task *t) {
         cJSON_AddNullToObject(obj, "note");
     }
 
+    // Recurrence rule is only written for recurring tasks
+    if (t->recur) {
+        cJSON_AddStringToObject(obj, "recur", t->recur);
+    }
+
+    return obj;
+}
+
+char *task_to_json(const Task *t) {
+    cJSON *obj = task_to_cjson(t);
+    if (!obj) return NULL;
     char *json_str = cJSON_PrintUnformatted(obj);
     cJSON_Delete(obj);
     return json_str;
@@ -177,41 +225,47 @@ char *task_to_json(const Task *t) {
 Task *task_from_json(const char *json_str) {
     cJSON *obj = cJSON_Parse(json_str);
     if (!obj) return NULL;
+    Task *t = task_from_cjson(obj);
+    cJSON_Delete(obj);
+    return t;
+}
+
+Task *task_from_cjson(const cJSON *obj) {
+    if (!cJSON_IsObject(obj)) return NULL;
 
     cJSON *id = cJSON_GetObjectItem(obj, "id");
     cJSON *name = cJSON_GetObjectItem(obj, "name");
     cJSON *created = cJSON_GetObjectItem(obj, "created");
     cJSON *due = cJSON_GetObjectItem(obj, "due");
+    cJSON *due_kind = cJSON_GetObjectItem(obj, "due_kind");
+    cJSON *due_tz = cJSON_GetObjectItem(obj, "due_tz");
     cJSON *tags = cJSON_GetObjectItem(obj, "tags");
     cJSON *priority = cJSON_GetObjectItem(obj, "priority");
     cJSON *status = cJSON_GetObjectItem(obj, "status");
     cJSON *project = cJSON_GetObjectItem(obj, "project");
     cJSON *note = cJSON_GetObjectItem(obj, "note"); // Get note if it exists
+    cJSON *recur = cJSON_GetObjectItem(obj, "recur");
 
     if (!cJSON_IsString(id) || !cJSON_IsString(name) || !cJSON_IsString(created)
         || !cJSON_IsArray(tags) || !cJSON_IsString(priority) || !cJSON_IsString(status)) {
-        cJSON_Delete(obj);
         return NULL;
     }
 
     Task *t = utils_calloc(1, sizeof(Task));
     if (!t) {
-        cJSON_Delete(obj);
         return NULL;
     }
 
     t->id = utils_strdup(id->valuestring);
     if (!t->id) {
-        free(t);
-        cJSON_Delete(obj);
+        utils_free(t);
         return NULL;
     }
     
     t->name = utils_strdup(name->valuestring);
     if (!t->name) {
-        free(t->id);
-        free(t);
-        cJSON_Delete(obj);
+        utils_free(t->id);
+        utils_free(t);
         return NULL;
     }
     
@@ -222,6 +276,17 @@ Task *task_from_json(const char *json_str) {
     } else {
         t->due = 0;
     }
+    if (t->due == 0) {
+        t->due_kind = DUE_NONE;
+    } else if (cJSON_IsString(due_kind)) {
+        t->due_kind = strcmp(due_kind->valuestring, "date") == 0 ? DUE_DATE : DUE_DATETIME;
+    } else {
+        t->due_kind = task_infer_due_kind(t->due); // Files written before due_kind existed
+    }
+    if (t->due_kind == DUE_DATETIME) {
+        t->due_tz = cJSON_IsString(due_tz) ? parse_tz_offset(due_tz->valuestring)
+                                           : (int)(tz_cache_offset(t->due) / 60);
+    }
 
     // Tags
     size_t count = cJSON_GetArraySize(tags);
@@ -229,10 +294,9 @@ Task *task_from_json(const char *json_str) {
     if (count > 0) {
         t->tags = utils_malloc(count * sizeof(char*));
         if (!t->tags) {
-            free(t->name);
-            free(t->id);
-            free(t);
-            cJSON_Delete(obj);
+            utils_free(t->name);
+            utils_free(t->id);
+            utils_free(t);
             return NULL;
         }
         
@@ -243,13 +307,12 @@ Task *task_from_json(const char *json_str) {
                 if (!t->tags[i]) {
                     // Clean up already allocated tags
                     for (size_t j = 0; j < i; ++j) {
-                        free(t->tags[j]);
+                        utils_free(t->tags[j]);
                     }
-                    free(t->tags);
-                    free(t->name);
-                    free(t->id);
-                    free(t);
-                    cJSON_Delete(obj);
+                    utils_free(t->tags);
+                    utils_free(t->name);
+                    utils_free(t->id);
+                    utils_free(t);
                     return NULL;
                 }
             } else {
@@ -257,13 +320,12 @@ Task *task_from_json(const char *json_str) {
                 if (!t->tags[i]) {
                     // Clean up already allocated tags
                     for (size_t j = 0; j < i; ++j) {
-                        free(t->tags[j]);
+                        utils_free(t->tags[j]);
                     }
-                    free(t->tags);
-                    free(t->name);
-                    free(t->id);
-                    free(t);
-                    cJSON_Delete(obj);
+                    utils_free(t->tags);
+                    utils_free(t->name);
+                    utils_free(t->id);
+                    utils_free(t);
                     return NULL;
                 }
             }
@@ -282,11 +344,10 @@ Task *task_from_json(const char *json_str) {
     }
     if (!t->project) {
         // cleanup memory
-        free(t->name); free(t->id);
-        for (size_t i = 0; i < t->tag_count; ++i) free(t->tags[i]);
-        free(t->tags);
-        free(t);
-        cJSON_Delete(obj);
+        utils_free(t->name); utils_free(t->id);
+        for (size_t i = 0; i < t->tag_count; ++i) utils_free(t->tags[i]);
+        utils_free(t->tags);
+        utils_free(t);
         return NULL;
     }
 
@@ -295,19 +356,22 @@ Task *task_from_json(const char *json_str) {
         t->note = utils_strdup(note->valuestring);
         if (!t->note) {
             // cleanup memory
-            free(t->project);
-            free(t->name); free(t->id);
-            for (size_t i = 0; i < t->tag_count; ++i) free(t->tags[i]);
-            free(t->tags);
-            free(t);
-            cJSON_Delete(obj);
+            utils_free(t->project);
+            utils_free(t->name); utils_free(t->id);
+            for (size_t i = 0; i < t->tag_count; ++i) utils_free(t->tags[i]);
+            utils_free(t->tags);
+            utils_free(t);
             return NULL;
         }
     } else {
         t->note = NULL; // No note or null note
     }
 
-    cJSON_Delete(obj);
+    // Invalid rules are dropped rather than failing the whole task
+    if (cJSON_IsString(recur) && t->due != 0) {
+        task_set_recurrence(t, recur->valuestring);
+    }
+
     return t;
 }
 
@@ -338,8 +402,63 @@ int task_compare_by_due(const void *a, const void *b) {
     if (t1->due == 0) return 1;
     if (t2->due == 0) return -1;
     
-    // Compare due dates
-    return (t1->due > t2->due) - (t1->due < t2->due);
+    // Compare due dates (date-only dues sort at the start of their local day)
+    time_t d1 = task_due_start(t1);
+    time_t d2 = task_due_start(t2);
+    return (d1 > d2) - (d1 < d2);
+}
+
+void task_set_due(Task *t, time_t due, DueKind kind) {
+    if (!t) return;
+    if (due == 0 || kind == DUE_NONE) {
+        t->due = 0;
+        t->due_kind = DUE_NONE;
+        t->due_tz = 0;
+        return;
+    }
+    t->due = due;
+    t->due_kind = kind;
+    t->due_tz = kind == DUE_DATETIME ? (int)(tz_cache_offset(due) / 60) : 0;
+}
+
+DueKind task_infer_due_kind(time_t due) {
+    if (due == 0) return DUE_NONE;
+    return due % 86400 == 0 ? DUE_DATE : DUE_DATETIME;
+}
+
+long long task_due_local_day(const Task *t) {
+    if (t->due_kind == DUE_DATE) {
+        // The calendar date is stored as midnight UTC; no zone conversion
+        long long day = (long long)t->due / 86400;
+        return (long long)t->due % 86400 < 0 ? day - 1 : day;
+    }
+    return tz_cache_local_day(t->due);
+}
+
+time_t task_due_start(const Task *t) {
+    if (!t || t->due == 0) return 0;
+    if (t->due_kind == DUE_DATE) return tz_cache_local_time(task_due_local_day(t), 0);
+    return t->due;
+}
+
+time_t task_due_deadline(const Task *t) {
+    if (!t || t->due == 0) return 0;
+    if (t->due_kind == DUE_DATE) return tz_cache_local_time(task_due_local_day(t) + 1, 0);
+    return t->due;
+}
+
+time_t task_remind_at(const Task *t) {
+    if (!t || t->due == 0 || t->status == STATUS_DONE) return 0;
+    if (t->due_kind == DUE_DATE) return tz_cache_local_time(task_due_local_day(t), TASK_REMIND_HOUR * 3600L);
+    return t->due;
+}
+
+char *task_format_due_date(const Task *t, char *buf, size_t size) {
+    if (!t || !buf || size < 11 || t->due == 0) return NULL;
+    int y, m, d;
+    utils_civil_from_days(task_due_local_day(t), &y, &m, &d);
+    snprintf(buf, size, "%04d-%02d-%02d", y, m, d);
+    return buf;
 }
 
 bool task_has_tag(const Task *t, const char *tag) {
@@ -358,111 +477,32 @@ bool task_has_status(const Task *t, Status status) {
 static bool task_matches_filter(const Task *t, const char *filter) {
     if (!t || !filter || filter[0] == '\0') return false;
     
-    // Date filters
-    if (strncmp(filter, "date:today", 10) == 0) {
-        // Filter for tasks due today
-        time_t now = time(NULL);
-        struct tm tm_now, tm_due;
-        localtime_r(&now, &tm_now);
-        
+    // Date filters use the clock's precomputed local-day boundaries
+    if (strncmp(filter, "date:", 5) == 0) {
         // Skip tasks with no due date
         if (t->due == 0) return false;
-        
-        localtime_r(&t->due, &tm_due);
-        
-        // Check if due date is today
-        return (tm_now.tm_year == tm_due.tm_year && 
-                tm_now.tm_mon == tm_due.tm_mon && 
-                tm_now.tm_mday == tm_due.tm_mday);
-    }
-    else if (strncmp(filter, "date:tomorrow", 13) == 0) {
-        // Filter for tasks due tomorrow
-        time_t now = time(NULL);
-        time_t tomorrow = now + 24 * 60 * 60; // Add one day in seconds
-        struct tm tm_tomorrow, tm_due;
-        localtime_r(&tomorrow, &tm_tomorrow);
-        
-        // Skip tasks with no due date
-        if (t->due == 0) return false;
-        
-        localtime_r(&t->due, &tm_due);
-        
-        // Check if due date is tomorrow
-        return (tm_tomorrow.tm_year == tm_due.tm_year && 
-                tm_tomorrow.tm_mon == tm_due.tm_mon && 
-                tm_tomorrow.tm_mday == tm_due.tm_mday);
-    }
-    else if (strncmp(filter, "date:this_week", 14) == 0) {
-        // Filter for tasks due this week (today through Sunday)
-        time_t now = time(NULL);
-        struct tm tm_now, tm_due;
-        localtime_r(&now, &tm_now);
-        
-        // Skip tasks with no due date
-        if (t->due == 0) return false;
-        
-        localtime_r(&t->due, &tm_due);
-        
-        // Calculate start of today
-        struct tm tm_start = tm_now;
-        tm_start.tm_hour = 0;
-        tm_start.tm_min = 0;
-        tm_start.tm_sec = 0;
-        time_t start_time = mktime(&tm_start);
-        
-        // Calculate end of week (end of Sunday)
-        int days_to_end = 7 - tm_now.tm_wday;
-        if (days_to_end == 0) days_to_end = 7; // If today is Sunday, go to next Sunday
-        time_t end_of_week = start_time + days_to_end * 24 * 60 * 60 - 1; // -1 to get 23:59:59
-        
-        // Check if due date is within this week
-        return (t->due >= start_time && t->due <= end_of_week);
-    }
-    else if (strncmp(filter, "date:next_week", 14) == 0) {
-        // Filter for tasks due next week (next Monday through Sunday)
-        time_t now = time(NULL);
-        struct tm tm_now, tm_due;
-        localtime_r(&now, &tm_now);
-        
-        // Skip tasks with no due date
-        if (t->due == 0) return false;
-        
-        localtime_r(&t->due, &tm_due);
-        
-        // Calculate days until next Monday
-        int days_to_monday = (7 - tm_now.tm_wday + 1) % 7;
-        if (days_to_monday == 0) days_to_monday = 7; // If today is Monday, go to next Monday
-        
-        // Calculate start of next Monday
-        struct tm tm_start = tm_now;
-        tm_start.tm_hour = 0;
-        tm_start.tm_min = 0;
-        tm_start.tm_sec = 0;
-        time_t next_monday = mktime(&tm_start) + days_to_monday * 24 * 60 * 60;
-        
-        // Calculate end of next Sunday
-        time_t next_sunday = next_monday + 7 * 24 * 60 * 60 - 1; // -1 to get 23:59:59
-        
-        // Check if due date is within next week
-        return (t->due >= next_monday && t->due <= next_sunday);
-    }
-    else if (strncmp(filter, "date:overdue", 12) == 0) {
-        // Filter for overdue tasks (due before today)
-        time_t now = time(NULL);
-        struct tm tm_now;
-        localtime_r(&now, &tm_now);
-        
-        // Skip tasks with no due date
-        if (t->due == 0) return false;
-        
-        // Calculate start of today
-        tm_now.tm_hour = 0;
-        tm_now.tm_min = 0;
-        tm_now.tm_sec = 0;
-        time_t start_of_today = mktime(&tm_now);
-        
-        // Check if due date is before today
-        return (t->due < start_of_today);
+
+        // Recurring tasks match if any occurrence falls in the range
+        const AppClockDay *day = app_clock_day();
+        if (strncmp(filter, "date:today", 10) == 0) {
+            return task_occurs_between(t, day->today_start, day->tomorrow_start);
+        }
+        if (strncmp(filter, "date:tomorrow", 13) == 0) {
+            return task_occurs_between(t, day->tomorrow_start, day->tomorrow_end);
+        }
+        if (strncmp(filter, "date:this_week", 14) == 0) {
+            // Today through Sunday
+            return task_occurs_between(t, day->today_start, day->week_end);
+        }
+        if (strncmp(filter, "date:next_week", 14) == 0) {
+            // Next Monday through Sunday
+            return task_occurs_between(t, day->next_week_start, day->next_week_end);
+        }
+        if (strncmp(filter, "date:overdue", 12) == 0) {
+            // Due before today
+            return task_due_start(t) < day->today_start;
+        }
+        return false;
     }
     // Priority filters
     else if (strncmp(filter, "priority:high", 13) == 0) {
@@ -539,7 +579,7 @@ int task_set_note(Task *task, const char *note) {
     
     // Free existing note if any
     if (task->note) {
-        free(task->note);
+        utils_free(task->note);
         task->note = NULL;
     }
     
@@ -557,6 +597,91 @@ int task_set_note(Task *task, const char *note) {
     return 0;
 }
 
+// Helper: start of a recurring task's occurrence on a given local day
+static time_t occurrence_start(const Task *t, long long day) {
+    if (t->due_kind == DUE_DATE) return tz_cache_local_time(day, 0);
+    long long local = (long long)t->due + tz_cache_offset(t->due);
+    long seconds = (long)(((local % 86400) + 86400) % 86400);
+    return tz_cache_local_time(day, seconds);
+}
+
+int task_set_recurrence(Task *task, const char *rule) {
+    if (!task) return -1;
+
+    if (!rule || rule[0] == '\0') {
+        utils_free(task->recur);
+        task->recur = NULL;
+        return 0;
+    }
+
+    Recurrence r;
+    char canonical[RECURRENCE_MAX_LEN];
+    if (recurrence_parse(rule, &r) != 0 || !recurrence_format(&r, canonical, sizeof(canonical))) {
+        return -1;
+    }
+
+    char *copy = utils_strdup(canonical);
+    if (!copy) return -1;
+    utils_free(task->recur);
+    task->recur = copy;
+    return 0;
+}
+
+bool task_occurs_between(const Task *t, time_t start, time_t end) {
+    if (!t || t->due == 0) return false;
+
+    time_t first = task_due_start(t);
+    Recurrence r;
+    if (!t->recur || recurrence_parse(t->recur, &r) != 0) {
+        return first >= start && first < end;
+    }
+
+    // Walk occurrences from the day before the window; local days and
+    // instants can differ by one around the window edges
+    long long anchor = task_due_local_day(t);
+    long long after = anchor - 1;
+    if (start > first) {
+        long long window_day = tz_cache_local_day(start) - 2;
+        if (window_day > after) after = window_day;
+    }
+
+    long long day;
+    while (recurrence_next(&r, anchor, after, &day)) {
+        time_t at = occurrence_start(t, day);
+        if (at >= end) return false;
+        if (at >= start) return true;
+        after = day;
+    }
+    return false;
+}
+
+int task_advance_recurrence(Task *t) {
+    if (!t || !t->recur || t->due == 0) return -1;
+
+    Recurrence r;
+    if (recurrence_parse(t->recur, &r) != 0) return -1;
+
+    long long anchor = task_due_local_day(t);
+    long long next;
+    if (!recurrence_next(&r, anchor, anchor, &next)) return 1;
+
+    task_set_due(t, t->due_kind == DUE_DATE ? (time_t)(next * 86400) : occurrence_start(t, next), t->due_kind);
+
+    // COUNT tracks the occurrences left, so it shrinks as the anchor moves
+    if (r.count > 0) {
+        char canonical[RECURRENCE_MAX_LEN];
+        r.count--;
+        if (recurrence_format(&r, canonical, sizeof(canonical))) {
+            char *copy = utils_strdup(canonical);
+            if (copy) {
+                utils_free(t->recur);
+                t->recur = copy;
+            }
+        }
+    }
+    return 0;
+}
+
 /**
  * Get the note for a task.
  * @param task The task to get the note from
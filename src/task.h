@@ -5,12 +5,15 @@
 #include <stddef.h>
 #include <time.h>
 
+struct cJSON;
+
 // Constants
 #define MAX_TAGS 5
 #define MAX_TAG_LEN 20
 #define MAX_PROJECT_LEN 40
 #define MAX_NOTE_LEN 512
 #define MAX_TASK_SERIALIZE_LEN 1280
+#define TASK_REMIND_HOUR 9   // Local hour date-only tasks are reminded at
 
 // Priority levels for tasks
 typedef enum {
@@ -25,29 +28,54 @@ typedef enum {
     STATUS_DONE
 } Status;
 
+// Kind of due value
+typedef enum {
+    DUE_NONE,       // No due date
+    DUE_DATE,       // Calendar date only; due holds midnight UTC of that date
+    DUE_DATETIME    // Exact instant
+} DueKind;
+
 // Task structure
 typedef struct {
     char *id;            // Unique identifier (UUID string)
     char *name;          // Task description
     time_t created;      // Creation timestamp
     time_t due;          // Due date timestamp, or 0 if none
+    DueKind due_kind;    // How due is interpreted
+    int due_tz;          // UTC offset (minutes) of the zone a datetime due was set in
     char **tags;         // Array of tag strings
     size_t tag_count;    // Number of tags
     char *project;       // Project name (defaults to "default")
     Priority priority;   // Priority level
     Status status;       // Pending or done
     char *note;          // Optional note for additional context
+    char *recur;         // Recurrence rule (canonical RRULE), or NULL if not recurring
 } Task;
 
 // Function forward declarations
 Task *task_create(const char *name,
                   time_t due,
+                  DueKind due_kind,
                   const char *tags[],
                   size_t tag_count,
                   Priority priority);
 void task_free(Task *task);
 char *task_to_json(const Task *task);
 Task *task_from_json(const char *json_str);
+
+/**
+ * Build the JSON object for a task without printing it.
+ * @param task The task
+ * @return New cJSON object (caller deletes), or NULL on error
+ */
+struct cJSON *task_to_cjson(const Task *task);
+
+/**
+ * Create a task from an already parsed JSON object.
+ * @param obj JSON object (not modified or freed)
+ * @return New task, or NULL if the object is not a valid task
+ */
+Task *task_from_cjson(const struct cJSON *obj);
 int task_compare_by_name(const void *a, const void *b);
 int task_compare_by_creation(const void *a, const void *b);
 int task_compare_by_due(const void *a, const void *b);
@@ -55,6 +83,87 @@ bool task_has_tag(const Task *task, const char *tag);
 bool task_has_status(const Task *task, Status status);
 bool task_matches_search(const Task *task, const char *search_term);
 
+/**
+ * Set the due value of a task.
+ * @param task The task to update
+ * @param due Due timestamp (midnight UTC of the date for DUE_DATE), or 0 to clear
+ * @param kind DUE_DATE or DUE_DATETIME; ignored when due is 0
+ */
+void task_set_due(Task *task, time_t due, DueKind kind);
+
+/**
+ * Infer the due kind of a value without explicit kind (legacy data):
+ * midnight UTC is treated as a date-only due.
+ * @param due Due timestamp
+ * @return DUE_NONE, DUE_DATE or DUE_DATETIME
+ */
+DueKind task_infer_due_kind(time_t due);
+
+/**
+ * Get the local calendar day a task is due on.
+ * @param task The task
+ * @return Days since 1970-01-01 in local time (undefined for DUE_NONE)
+ */
+long long task_due_local_day(const Task *task);
+
+/**
+ * Get the instant the task's due day or time begins in local time.
+ * @param task The task
+ * @return Local midnight of the date for DUE_DATE, due for DUE_DATETIME, 0 if none
+ */
+time_t task_due_start(const Task *task);
+
+/**
+ * Get the instant after which the task is overdue.
+ * @param task The task
+ * @return End of the local day for DUE_DATE, due for DUE_DATETIME, 0 if none
+ */
+time_t task_due_deadline(const Task *task);
+
+/**
+ * Get the instant a reminder for the task should fire: the due time for
+ * DUE_DATETIME, TASK_REMIND_HOUR local time on the day for DUE_DATE.
+ * @param task The task
+ * @return Reminder time, or 0 if the task has no due date or is done
+ */
+time_t task_remind_at(const Task *task);
+
+/**
+ * Format the local due date as YYYY-MM-DD.
+ * @param task The task
+ * @param buf Output buffer (at least 11 bytes)
+ * @param size Size of buf
+ * @return buf, or NULL if the task has no due date or buf is too small
+ */
+char *task_format_due_date(const Task *task, char *buf, size_t size);
+
+/**
+ * Set or clear the recurrence rule of a task. A recurring task is a single
+ * template whose due date is its current occurrence.
+ * @param task The task to update
+ * @param rule Rule accepted by recurrence_parse(), or NULL/empty to clear
+ * @return 0 on success, -1 if the rule is invalid or on allocation failure
+ */
+int task_set_recurrence(Task *task, const char *rule);
+
+/**
+ * Check whether a task (or any occurrence of a recurring task) is due within
+ * [start, end). Occurrences are computed lazily up to the end of the window.
+ * @param task The task
+ * @param start Window start (inclusive)
+ * @param end Window end (exclusive)
+ * @return true if an occurrence starts within the window
+ */
+bool task_occurs_between(const Task *task, time_t start, time_t end);
+
+/**
+ * Complete the current occurrence of a recurring task by moving its due
+ * date to the next occurrence.
+ * @param task The task
+ * @return 0 if advanced, 1 if the series has ended, -1 if not recurring
+ */
+int task_advance_recurrence(Task *task);
+
 /**
  * Set a note for a task.
  * @param task The task to set the note for
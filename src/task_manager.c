@@ -1,3 +1,6 @@
+// strcasecmp() is POSIX, not ISO C
+#define _POSIX_C_SOURCE 200809L
+
 /**
  * @file task_manager.c
  * @brief Centralized task management functions implementation
@@ -6,14 +9,52 @@
 #include "task_manager.h"
 #include "storage.h"
 #include "utils.h"
+#include "app_clock.h"
+#include "trace.h"
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <time.h>
+#include <limits.h>
 
 #define MAX_PROJECTS 64
 static char *project_list[MAX_PROJECTS];
 static size_t project_count = 0;
 
+static TaskChangeHook change_hook = NULL;
+static void *change_hook_user = NULL;
+static TaskChangeHook before_hook = NULL;
+static void *before_hook_user = NULL;
+
+void task_manager_set_change_hook(TaskChangeHook hook, void *user) {
+    change_hook = hook;
+    change_hook_user = user;
+}
+
+void task_manager_notify_change(TaskChangeKind kind, const Task *task) {
+    if (change_hook && task) change_hook(kind, task, change_hook_user);
+}
+
+void task_manager_set_before_change_hook(TaskChangeHook hook, void *user) {
+    before_hook = hook;
+    before_hook_user = user;
+}
+
+void task_manager_notify_before_change(TaskChangeKind kind, const Task *task) {
+    if (before_hook && task) before_hook(kind, task, before_hook_user);
+}
+
+// Helper: complete a task without reporting the change
+static Status complete_task(Task *task) {
+    // A recurring task moves on to its next occurrence and stays pending
+    if (task->recur && task_advance_recurrence(task) == 0) {
+        task->status = STATUS_PENDING;
+    } else {
+        task->status = STATUS_DONE;
+    }
+    return task->status;
+}
+
 int task_manager_init(void) {
     return storage_init();
 }
@@ -27,20 +68,20 @@ int task_manager_save_tasks(Task **tasks, size_t count) {
 }
 
 int task_manager_add_task(Task ***tasks, size_t *count, const char *name, 
-                          time_t due, const char **tags, size_t tag_count, 
+                          time_t due, DueKind due_kind, const char **tags, size_t tag_count, 
                           Priority priority, const char *project) {
     if (!tasks || !*tasks || !count || !name) {
         return -1;
     }
     
     // Create the new task
-    Task *new_task = task_create(name, due, tags, tag_count, priority);
+    Task *new_task = task_create(name, due, due_kind, tags, tag_count, priority);
     if (!new_task) {
         return -1;
     }
     
     if (new_task && project) {
-        free(new_task->project);
+        utils_free(new_task->project);
         new_task->project = utils_strdup(project);
     }
     
@@ -61,10 +102,11 @@ int task_manager_add_task(Task ***tasks, size_t *count, const char *name,
     new_tasks[*count + 1] = NULL;
     
     // Free old array and update pointers
-    free(*tasks);
+    utils_free(*tasks);
     *tasks = new_tasks;
     (*count)++;
     
+    task_manager_notify_change(TASK_CHANGE_ADD, new_task);
     return 0;
 }
 
@@ -74,6 +116,7 @@ int task_manager_delete_task(Task ***tasks, size_t *count, size_t task_index) {
     }
     
     // Free the task being deleted
+    task_manager_notify_change(TASK_CHANGE_DELETE, (*tasks)[task_index]);
     task_free((*tasks)[task_index]);
     
     // Shift remaining tasks
@@ -94,12 +137,13 @@ int task_manager_delete_task(Task ***tasks, size_t *count, size_t task_index) {
     return 0;
 }
 
-int task_manager_update_task(Task *task, const char *name, time_t due,
+int task_manager_update_task(Task *task, const char *name, time_t due, DueKind due_kind,
                              const char **tags, size_t tag_count,
                              int priority, int status) {
     if (!task) {
         return -1;
     }
+    task_manager_notify_before_change(TASK_CHANGE_PUT, task);
     
     // Update name if provided
     if (name) {
@@ -107,22 +151,22 @@ int task_manager_update_task(Task *task, const char *name, time_t due,
         if (!new_name) {
             return -1;
         }
-        free(task->name);
+        utils_free(task->name);
         task->name = new_name;
     }
     
     // Update due date if provided (negative value means "don't change")
     if (due >= 0) {
-        task->due = due;
+        task_set_due(task, due, due_kind);
     }
     
     // Update tags if provided
     if (tags) {
         // Free existing tags
         for (size_t i = 0; i < task->tag_count; i++) {
-            free(task->tags[i]);
+            utils_free(task->tags[i]);
         }
-        free(task->tags);
+        utils_free(task->tags);
         
         // Allocate and copy new tags
         if (tag_count > 0) {
@@ -137,9 +181,9 @@ int task_manager_update_task(Task *task, const char *name, time_t due,
                 if (!task->tags[i]) {
                     // Clean up on failure
                     for (size_t j = 0; j < i; j++) {
-                        free(task->tags[j]);
+                        utils_free(task->tags[j]);
                     }
-                    free(task->tags);
+                    utils_free(task->tags);
                     task->tags = NULL;
                     task->tag_count = 0;
                     return -1;
@@ -158,31 +202,55 @@ int task_manager_update_task(Task *task, const char *name, time_t due,
     }
     
     // Update status if provided (negative value means "don't change")
-    if (status >= 0 && status <= STATUS_DONE) {
+    if (status == STATUS_DONE && task->status == STATUS_PENDING) {
+        complete_task(task);
+    } else if (status >= 0 && status <= STATUS_DONE) {
         task->status = (Status)status;
     }
     
+    task_manager_notify_change(TASK_CHANGE_PUT, task);
     return 0;
 }
 
+Status task_manager_complete_task(Task *task) {
+    if (!task) {
+        return STATUS_PENDING; // Default return value on error
+    }
+    
+    task_manager_notify_before_change(TASK_CHANGE_PUT, task);
+    Status status = complete_task(task);
+    task_manager_notify_change(TASK_CHANGE_PUT, task);
+    return status;
+}
+
 Status task_manager_toggle_status(Task *task) {
     if (!task) {
         return STATUS_PENDING; // Default return value on error
     }
     
-    task->status = (task->status == STATUS_DONE) ? STATUS_PENDING : STATUS_DONE;
+    task_manager_notify_before_change(TASK_CHANGE_PUT, task);
+    if (task->status == STATUS_PENDING) {
+        complete_task(task);
+    } else {
+        task->status = STATUS_PENDING;
+    }
+    task_manager_notify_change(TASK_CHANGE_PUT, task);
     return task->status;
 }
 
 void task_manager_sort_by_name(Task **tasks, size_t count) {
     if (tasks && count > 0) {
+        trace_begin("sort_by_name");
         qsort(tasks, count, sizeof(Task*), task_compare_by_name);
+        trace_end("sort_by_name");
     }
 }
 
 void task_manager_sort_by_due(Task **tasks, size_t count) {
     if (tasks && count > 0) {
+        trace_begin("sort_by_due");
         qsort(tasks, count, sizeof(Task*), task_compare_by_due);
+        trace_end("sort_by_due");
     }
 }
 
@@ -204,11 +272,13 @@ size_t task_manager_filter_by_search(Task **tasks, size_t count,
     }
     
     // Otherwise, filter by search term
+    trace_begin("filter_by_search");
     for (size_t i = 0; i < count; i++) {
         if (task_matches_search(tasks[i], search_term)) {
             filtered_tasks[filtered_count++] = tasks[i];
         }
     }
+    trace_end("filter_by_search");
     
     return filtered_count;
 }
@@ -217,12 +287,14 @@ size_t task_manager_filter_by_project(Task **tasks, size_t count,
                                       const char *project,
                                       Task **filtered_tasks) {
     if (!tasks || !filtered_tasks || !project) return 0;
+    trace_begin("filter_by_project");
     size_t n = 0;
     for (size_t i = 0; i < count; ++i) {
         if (strcmp(tasks[i]->project, project) == 0) {
             filtered_tasks[n++] = tasks[i];
         }
     }
+    trace_end("filter_by_project");
     return n;
 }
 
@@ -234,51 +306,26 @@ size_t task_manager_filter_by_date_range(Task **tasks, size_t count,
     }
     
     size_t filtered_count = 0;
+    trace_begin("filter_by_date_range");
     
     for (size_t i = 0; i < count; i++) {
         if (!tasks[i] || tasks[i]->due == 0) {
             continue; // Skip tasks with no due date
         }
         
-        // Check if task is within date range
-        bool in_range = true;
-        
-        if (start_date > 0 && tasks[i]->due < start_date) {
-            in_range = false; // Due date is before start date
-        }
+        // Check if task (or an occurrence of a recurring task) is within date range
+        time_t window_start = start_date > 0 ? start_date : 0;
+        time_t window_end = end_date > 0 ? end_date + 1 : (time_t)LLONG_MAX;
         
-        if (end_date > 0 && tasks[i]->due > end_date) {
-            in_range = false; // Due date is after end date
-        }
-        
-        if (in_range) {
+        if (task_occurs_between(tasks[i], window_start, window_end)) {
             filtered_tasks[filtered_count++] = tasks[i];
         }
     }
+    trace_end("filter_by_date_range");
     
     return filtered_count;
 }
 
-// Helper function to get the start of a day (midnight)
-static time_t get_start_of_day(time_t t) {
-    struct tm tm_date;
-    localtime_r(&t, &tm_date);
-    tm_date.tm_hour = 0;
-    tm_date.tm_min = 0;
-    tm_date.tm_sec = 0;
-    return mktime(&tm_date);
-}
-
-// Helper function to get the end of a day (23:59:59)
-static time_t get_end_of_day(time_t t) {
-    struct tm tm_date;
-    localtime_r(&t, &tm_date);
-    tm_date.tm_hour = 23;
-    tm_date.tm_min = 59;
-    tm_date.tm_sec = 59;
-    return mktime(&tm_date);
-}
-
 size_t task_manager_filter_by_date_preset(Task **tasks, size_t count, 
                                          const char *range_type,
                                          Task **filtered_tasks) {
@@ -286,58 +333,36 @@ size_t task_manager_filter_by_date_preset(Task **tasks, size_t count,
         return 0;
     }
     
-    time_t now = time(NULL);
+    // Day boundaries are precomputed by the clock as half-open ranges;
+    // the date range filter is inclusive, hence the -1 on each end date.
+    const AppClockDay *day = app_clock_day();
     time_t start_date = 0;
     time_t end_date = 0;
     
     // Calculate start and end dates based on range type
     if (strcasecmp(range_type, "today") == 0) {
         // Today: from midnight to 23:59:59 today
-        start_date = get_start_of_day(now);
-        end_date = get_end_of_day(now);
+        start_date = day->today_start;
+        end_date = day->tomorrow_start - 1;
     } 
     else if (strcasecmp(range_type, "tomorrow") == 0) {
         // Tomorrow: from midnight to 23:59:59 tomorrow
-        time_t tomorrow = now + 24 * 60 * 60; // Add one day in seconds
-        start_date = get_start_of_day(tomorrow);
-        end_date = get_end_of_day(tomorrow);
+        start_date = day->tomorrow_start;
+        end_date = day->tomorrow_end - 1;
     } 
     else if (strcasecmp(range_type, "this_week") == 0) {
         // This week: from today to end of the week (Sunday)
-        struct tm tm_now;
-        localtime_r(&now, &tm_now);
-        
-        // Start from today
-        start_date = get_start_of_day(now);
-        
-        // Calculate days until end of week (Sunday)
-        int days_to_end = 7 - tm_now.tm_wday;
-        if (days_to_end == 0) days_to_end = 7; // If today is Sunday, go to next Sunday
-        
-        // End date is end of Sunday
-        time_t end_of_week = now + days_to_end * 24 * 60 * 60;
-        end_date = get_end_of_day(end_of_week);
+        start_date = day->today_start;
+        end_date = day->week_end - 1;
     } 
     else if (strcasecmp(range_type, "next_week") == 0) {
         // Next week: from next Monday to next Sunday
-        struct tm tm_now;
-        localtime_r(&now, &tm_now);
-        
-        // Calculate days until next Monday
-        int days_to_monday = (7 - tm_now.tm_wday + 1) % 7;
-        if (days_to_monday == 0) days_to_monday = 7; // If today is Monday, go to next Monday
-        
-        // Start date is beginning of next Monday
-        time_t next_monday = now + days_to_monday * 24 * 60 * 60;
-        start_date = get_start_of_day(next_monday);
-        
-        // End date is end of next Sunday (7 days after next Monday)
-        time_t next_sunday = next_monday + 6 * 24 * 60 * 60;
-        end_date = get_end_of_day(next_sunday);
+        start_date = day->next_week_start;
+        end_date = day->next_week_end - 1;
     } 
     else if (strcasecmp(range_type, "overdue") == 0) {
         // Overdue: before today
-        end_date = get_start_of_day(now) - 1; // End at 23:59:59 yesterday
+        end_date = day->today_start - 1; // End at 23:59:59 yesterday
     }
     else {
         // Unknown range type
@@ -369,7 +394,7 @@ int task_manager_delete_project(const char *name, Task **tasks, size_t task_coun
     // Find and remove from project_list
     for (size_t i = 0; i < project_count; ++i) {
         if (strcmp(project_list[i], name) == 0) {
-            free(project_list[i]);
+            utils_free(project_list[i]);
             for (size_t j = i + 1; j < project_count; ++j) {
                 project_list[j-1] = project_list[j];
             }
@@ -394,14 +419,14 @@ int task_manager_save_projects(void) {
 }
 
 int task_manager_load_projects(void) {
-    for (size_t i = 0; i < project_count; ++i) free(project_list[i]);
+    for (size_t i = 0; i < project_count; ++i) utils_free(project_list[i]);
     project_count = 0;
     char **loaded = NULL;
     size_t n = storage_load_projects(&loaded);
     for (size_t i = 0; i < n && i < MAX_PROJECTS; ++i) {
         project_list[project_count++] = loaded[i];
     }
-    free(loaded);
+    utils_free(loaded);
     return 0;
 }
 
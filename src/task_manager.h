@@ -9,6 +9,56 @@
 #include "task.h"
 #include <stdbool.h>
 
+/**
+ * Kind of change reported to the change hook
+ */
+typedef enum {
+    TASK_CHANGE_ADD,      // Task added
+    TASK_CHANGE_PUT,      // Task modified
+    TASK_CHANGE_DELETE    // Task about to be freed
+} TaskChangeKind;
+
+/**
+ * Callback run after a task_manager function changes a task
+ * @param kind Kind of change
+ * @param task The task (valid only during the call)
+ * @param user User pointer given to task_manager_set_change_hook()
+ */
+typedef void (*TaskChangeHook)(TaskChangeKind kind, const Task *task, void *user);
+
+/**
+ * Install the change hook (one per process; NULL removes it)
+ * @param hook Callback, or NULL
+ * @param user User pointer passed to the callback
+ */
+void task_manager_set_change_hook(TaskChangeHook hook, void *user);
+
+/**
+ * Report a change made outside the task_manager functions, such as a
+ * direct edit of a task's fields
+ * @param kind Kind of change
+ * @param task The changed task
+ */
+void task_manager_notify_change(TaskChangeKind kind, const Task *task);
+
+/**
+ * Install the before-change hook (one per process; NULL removes it). It runs
+ * just before a task_manager function modifies a task in place, while the
+ * task still holds its old values, so an undo log (undo.h) can record what
+ * the change overwrites.
+ * @param hook Callback (called with TASK_CHANGE_PUT), or NULL
+ * @param user User pointer passed to the callback
+ */
+void task_manager_set_before_change_hook(TaskChangeHook hook, void *user);
+
+/**
+ * Report that a task is about to be edited outside the task_manager
+ * functions; pair with task_manager_notify_change() once the edit is done
+ * @param kind Kind of change about to happen
+ * @param task The task, still unchanged
+ */
+void task_manager_notify_before_change(TaskChangeKind kind, const Task *task);
+
 /**
  * Initialize the task manager
  * @return 0 on success, -1 on failure
@@ -36,6 +86,7 @@ int task_manager_save_tasks(Task **tasks, size_t count);
  * @param count Pointer to task count (will be incremented)
  * @param name Task name
  * @param due Due date (0 for none)
+ * @param due_kind DUE_DATE or DUE_DATETIME (ignored when due is 0)
  * @param tags Array of tag strings
  * @param tag_count Number of tags
  * @param priority Task priority
@@ -43,7 +94,7 @@ int task_manager_save_tasks(Task **tasks, size_t count);
  * @return 0 on success, -1 on failure
  */
 int task_manager_add_task(Task ***tasks, size_t *count, const char *name, 
-                          time_t due, const char **tags, size_t tag_count, 
+                          time_t due, DueKind due_kind, const char **tags, size_t tag_count, 
                           Priority priority, const char *project);
 
 /**
@@ -59,19 +110,29 @@ int task_manager_delete_task(Task ***tasks, size_t *count, size_t task_index);
  * Update a task's properties
  * @param task Task to update
  * @param name New name (NULL to keep current)
- * @param due New due date (negative to keep current)
+ * @param due New due date (negative to keep current, 0 to clear)
+ * @param due_kind DUE_DATE or DUE_DATETIME for a new due date
  * @param tags New tags (NULL to keep current)
  * @param tag_count Number of new tags
  * @param priority New priority (negative to keep current)
  * @param status New status (negative to keep current)
  * @return 0 on success, -1 on failure
  */
-int task_manager_update_task(Task *task, const char *name, time_t due,
+int task_manager_update_task(Task *task, const char *name, time_t due, DueKind due_kind,
                              const char **tags, size_t tag_count,
                              int priority, int status);
 
+/**
+ * Complete a task. A recurring task advances to its next occurrence and
+ * stays pending; it is marked done once its series has ended.
+ * @param task Task to complete
+ * @return New status
+ */
+Status task_manager_complete_task(Task *task);
+
 /**
  * Toggle a task's status between done and pending
+ * (completing a recurring task advances it, see task_manager_complete_task)
  * @param task Task to toggle
  * @return New status
  */
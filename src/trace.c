@@ -0,0 +1,161 @@
+// clock_gettime() and getpid() are POSIX, not ISO C
+#define _POSIX_C_SOURCE 200809L
+
+#include "trace.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// One slot of a ring. The owner may overwrite a slot while a dump reads
+// it, so the fields are atomics and seq tells a dump whether what it read
+// is the event it wanted: index + 1 once written, 0 while being written.
+typedef struct {
+    atomic_size_t seq;
+    _Atomic(const char *) name;
+    _Atomic uint64_t ts;  // Monotonic ns
+    atomic_char phase;    // 'B' or 'E'
+} TraceEvent;
+
+// Ring of one thread; only that thread writes it. Rings are never freed,
+// so the spans of threads that have ended still get dumped.
+typedef struct TraceRing {
+    struct TraceRing *next;
+    unsigned tid;                      // 1 for the first thread that recorded
+    atomic_size_t head;                // Events ever recorded
+    TraceEvent events[TRACE_RING_EVENTS];
+} TraceRing;
+
+static atomic_bool trace_on;
+static _Atomic(TraceRing *) trace_rings;
+static atomic_uint trace_next_tid;
+static _Thread_local TraceRing *trace_ring;
+static uint64_t trace_start;
+static char trace_path[1024];
+
+// Helper: monotonic time in ns
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Helper: create the ring of the calling thread and publish it
+static TraceRing *ring_register(void) {
+    TraceRing *ring = calloc(1, sizeof(TraceRing));
+    if (!ring) return NULL;
+    ring->tid = atomic_fetch_add(&trace_next_tid, 1) + 1;
+    TraceRing *head = atomic_load(&trace_rings);
+    do {
+        ring->next = head;
+    } while (!atomic_compare_exchange_weak(&trace_rings, &head, ring));
+    trace_ring = ring;
+    return ring;
+}
+
+// Helper: append an event to the calling thread's ring
+static void record(const char *name, char phase) {
+    TraceRing *ring = trace_ring ? trace_ring : ring_register();
+    if (!ring) return;
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    TraceEvent *e = &ring->events[head & (TRACE_RING_EVENTS - 1)];
+    atomic_store_explicit(&e->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&e->name, name, memory_order_relaxed);
+    atomic_store_explicit(&e->ts, now_ns(), memory_order_relaxed);
+    atomic_store_explicit(&e->phase, phase, memory_order_relaxed);
+    atomic_store_explicit(&e->seq, head + 1, memory_order_release);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+static void dump_at_exit(void) {
+    trace_dump(NULL);
+}
+
+void trace_init(void) {
+    const char *env = getenv(TRACE_ENV);
+    if (!env || env[0] == '\0' || atomic_load(&trace_on)) return;
+
+    // Expand %p to the process id
+    size_t n = 0;
+    for (const char *p = env; *p && n + 1 < sizeof(trace_path); p++) {
+        if (p[0] == '%' && p[1] == 'p') {
+            n += (size_t)snprintf(trace_path + n, sizeof(trace_path) - n, "%ld", (long)getpid());
+            if (n >= sizeof(trace_path)) n = sizeof(trace_path) - 1;
+            p++;
+        } else {
+            trace_path[n++] = *p;
+        }
+    }
+    trace_path[n] = '\0';
+
+    trace_start = now_ns();
+    atomic_store(&trace_on, true);
+    atexit(dump_at_exit);
+}
+
+bool trace_enabled(void) {
+    return atomic_load_explicit(&trace_on, memory_order_relaxed);
+}
+
+void trace_begin(const char *name) {
+    if (atomic_load_explicit(&trace_on, memory_order_relaxed)) record(name, 'B');
+}
+
+void trace_end(const char *name) {
+    if (atomic_load_explicit(&trace_on, memory_order_relaxed)) record(name, 'E');
+}
+
+// Helper: read event i of a ring; false if its slot has been overwritten
+// since, or is being overwritten now
+static bool read_event(TraceRing *ring, size_t i, const char **name, uint64_t *ts, char *phase) {
+    TraceEvent *e = &ring->events[i & (TRACE_RING_EVENTS - 1)];
+    if (atomic_load_explicit(&e->seq, memory_order_acquire) != i + 1) return false;
+    *name = atomic_load_explicit(&e->name, memory_order_relaxed);
+    *ts = atomic_load_explicit(&e->ts, memory_order_relaxed);
+    *phase = atomic_load_explicit(&e->phase, memory_order_relaxed);
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&e->seq, memory_order_relaxed) == i + 1;
+}
+
+// Helper: write the events of one ring, oldest first; the ring may have
+// wrapped, so ends of spans whose beginning was overwritten are skipped
+static void dump_ring(FILE *f, TraceRing *ring, long pid, bool *first) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    size_t start = head > TRACE_RING_EVENTS ? head - TRACE_RING_EVENTS : 0;
+    fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%ld,\"tid\":%u,\"args\":{\"name\":\"%s %u\"}}",
+            *first ? "" : ",\n", pid, ring->tid, ring->tid == 1 ? "main" : "thread", ring->tid);
+    *first = false;
+    int depth = 0;
+    for (size_t i = start; i < head; i++) {
+        const char *name;
+        uint64_t at;
+        char phase;
+        if (!read_event(ring, i, &name, &at, &phase)) continue;
+        if (phase == 'E' && depth == 0) continue;
+        depth += phase == 'B' ? 1 : -1;
+        double ts = at >= trace_start ? (double)(at - trace_start) / 1000.0 : 0;
+        fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"smartodo\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%ld,\"tid\":%u}",
+                name, phase, ts, pid, ring->tid);
+    }
+}
+
+int trace_dump(const char *path) {
+    if (!atomic_load(&trace_on)) return -1;
+    if (!path) path = trace_path;
+    FILE *f = fopen(path, "w");
+    if (!f) return -1;
+
+    long pid = (long)getpid();
+    bool first = true;
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (TraceRing *ring = atomic_load(&trace_rings); ring; ring = ring->next) {
+        dump_ring(f, ring, pid, &first);
+    }
+    fprintf(f, "%s{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%ld,\"args\":{\"name\":\"smartodo\"}}\n]}\n",
+            first ? "" : ",\n", pid);
+    return fclose(f) == 0 ? 0 : -1;
+}
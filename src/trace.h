@@ -0,0 +1,58 @@
+#ifndef TODO_APP_TRACE_H
+#define TODO_APP_TRACE_H
+
+#include <stdbool.h>
+
+/**
+ * Tracing spans. With SMARTODO_TRACE set to a file name, trace_init()
+ * turns recording on: every trace_begin()/trace_end() pair becomes a span
+ * of the calling thread. Each thread records into a ring buffer of its own
+ * (the newest TRACE_RING_EVENTS events), without locks. The spans are
+ * written as Chrome trace-event JSON, to open in Perfetto
+ * (ui.perfetto.dev) or chrome://tracing, at exit or on demand with
+ * trace_dump(). A "%p" in the file name is replaced by the process id, so
+ * the daemon and its clients can trace to one pattern.
+ *
+ * Span names must be string literals (they are kept by pointer) of plain
+ * characters. While recording is off a span costs one flag test.
+ */
+
+#define TRACE_ENV "SMARTODO_TRACE"
+
+// Events kept per thread; a power of two
+#define TRACE_RING_EVENTS 65536
+
+/**
+ * Turn recording on if SMARTODO_TRACE is set, and dump at exit.
+ */
+void trace_init(void);
+
+/**
+ * Whether spans are being recorded
+ * @return true after trace_init() with SMARTODO_TRACE set
+ */
+bool trace_enabled(void);
+
+/**
+ * Open a span on the calling thread.
+ * @param name Span name (string literal)
+ */
+void trace_begin(const char *name);
+
+/**
+ * Close the innermost open span of the calling thread.
+ * @param name Span name, as passed to trace_begin()
+ */
+void trace_end(const char *name);
+
+/**
+ * Write the recorded spans of all threads as Chrome trace-event JSON.
+ * Threads still recording may lose their latest few events, and events
+ * their owner overwrites while they are read are left out, so a dump is
+ * safe at any time.
+ * @param path File to write, or NULL for the SMARTODO_TRACE file
+ * @return 0 on success, -1 on error or if recording is off
+ */
+int trace_dump(const char *path);
+
+#endif // TODO_APP_TRACE_H
@@ -0,0 +1,160 @@
+// localtime_r() is POSIX, not ISO C
+#define _POSIX_C_SOURCE 200809L
+
+#include "tz_cache.h"
+#include "utils.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#define SECONDS_PER_DAY 86400LL
+
+// Maximum number of cached offset segments before the table is flushed
+#define TZ_CACHE_MAX_SEGMENTS 64
+
+// Probe step when searching for a transition. Must stay shorter than the
+// shortest offset period so a short DST interval cannot be stepped over.
+#define TZ_PROBE_STEP (16 * SECONDS_PER_DAY)
+
+// How far a single lookup searches for transitions in each direction
+#define TZ_SEARCH_SPAN (400 * SECONDS_PER_DAY)
+
+// A span [start, end) with a constant UTC offset
+typedef struct {
+    time_t start;
+    time_t end;
+    long offset;
+} TzSegment;
+
+static TzSegment segments[TZ_CACHE_MAX_SEGMENTS];
+static size_t segment_count = 0;
+
+// Helper: ask libc for the offset at t
+static long query_offset(time_t t) {
+    struct tm tm = {0};
+    localtime_r(&t, &tm);
+    long long local = utils_days_from_civil(tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday) * SECONDS_PER_DAY +
+                      tm.tm_hour * 3600LL + tm.tm_min * 60LL + tm.tm_sec;
+    return (long)(local - (long long)t);
+}
+
+// Helper: index of the first segment with start > t
+static size_t upper_bound(time_t t) {
+    size_t lo = 0, hi = segment_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (segments[mid].start <= t) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// Helper: earliest instant in (limit, t] from which the offset stays `offset` up to t
+static time_t find_start(time_t t, long offset, time_t limit) {
+    time_t good = t;
+    time_t step = SECONDS_PER_DAY;
+    while (good > limit) {
+        time_t probe = good - step < limit ? limit : good - step;
+        if (query_offset(probe) != offset) {
+            // Transition lies in (probe, good]
+            time_t bad = probe;
+            while (good - bad > 1) {
+                time_t mid = bad + (good - bad) / 2;
+                if (query_offset(mid) == offset) good = mid;
+                else bad = mid;
+            }
+            return good;
+        }
+        good = probe;
+        if (step < TZ_PROBE_STEP) step *= 2;
+    }
+    return limit;
+}
+
+// Helper: first instant after t, up to limit, where the offset changes
+static time_t find_end(time_t t, long offset, time_t limit) {
+    time_t good = t;
+    time_t step = SECONDS_PER_DAY;
+    while (good < limit) {
+        time_t probe = good + step > limit ? limit : good + step;
+        if (query_offset(probe) != offset) {
+            // Transition lies in (good, probe]
+            time_t bad = probe;
+            while (bad - good > 1) {
+                time_t mid = good + (bad - good) / 2;
+                if (query_offset(mid) == offset) good = mid;
+                else bad = mid;
+            }
+            return bad;
+        }
+        good = probe;
+        if (step < TZ_PROBE_STEP) step *= 2;
+    }
+    return limit;
+}
+
+// Helper: build and insert the segment containing t between its cached neighbours
+static long fill_segment(time_t t, size_t pos) {
+    long offset = query_offset(t);
+
+    time_t lower = t - TZ_SEARCH_SPAN;
+    time_t upper = t + TZ_SEARCH_SPAN;
+    if (pos > 0 && segments[pos - 1].end > lower) lower = segments[pos - 1].end;
+    if (pos < segment_count && segments[pos].start < upper) upper = segments[pos].start;
+
+    TzSegment seg = {
+        .start = find_start(t, offset, lower),
+        .end = find_end(t, offset, upper),
+        .offset = offset,
+    };
+    if (seg.end <= t) seg.end = t + 1;
+
+    // Extend an adjacent segment with the same offset instead of inserting
+    if (pos > 0 && segments[pos - 1].end == seg.start && segments[pos - 1].offset == offset) {
+        segments[pos - 1].end = seg.end;
+        return offset;
+    }
+    if (pos < segment_count && segments[pos].start == seg.end && segments[pos].offset == offset) {
+        segments[pos].start = seg.start;
+        return offset;
+    }
+
+    if (segment_count >= TZ_CACHE_MAX_SEGMENTS) {
+        // Table full: start over with just this segment
+        segments[0] = seg;
+        segment_count = 1;
+        return offset;
+    }
+
+    for (size_t i = segment_count; i > pos; --i) {
+        segments[i] = segments[i - 1];
+    }
+    segments[pos] = seg;
+    segment_count++;
+    return offset;
+}
+
+long tz_cache_offset(time_t t) {
+    size_t pos = upper_bound(t);
+    if (pos > 0 && t < segments[pos - 1].end) {
+        return segments[pos - 1].offset;
+    }
+    return fill_segment(t, pos);
+}
+
+long long tz_cache_local_day(time_t t) {
+    long long local = (long long)t + tz_cache_offset(t);
+    long long day = local / SECONDS_PER_DAY;
+    if (local % SECONDS_PER_DAY < 0) day--; // Floor for instants before the epoch
+    return day;
+}
+
+time_t tz_cache_local_time(long long day, long seconds) {
+    long long wall = day * SECONDS_PER_DAY + seconds;
+    long guess = tz_cache_offset((time_t)wall);
+    long offset = tz_cache_offset((time_t)(wall - guess));
+    return (time_t)(wall - offset);
+}
+
+void tz_cache_reset(void) {
+    segment_count = 0;
+}
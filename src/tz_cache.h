@@ -0,0 +1,54 @@
+#ifndef TZ_CACHE_H
+#define TZ_CACHE_H
+
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Cached UTC-offset transition table for the local time zone
+ *
+ * Offsets are looked up with localtime_r once per offset segment (the span
+ * between two DST/offset transitions) and then served from a sorted table,
+ * so per-task local-day computations do not call localtime_r.
+ */
+
+/**
+ * @brief Returns the local UTC offset in effect at an instant
+ *
+ * @param t Instant to query
+ * @return long Seconds east of UTC
+ */
+long tz_cache_offset(time_t t);
+
+/**
+ * @brief Returns the local calendar day of an instant
+ *
+ * @param t Instant to query
+ * @return long long Days since 1970-01-01 in local time
+ */
+long long tz_cache_local_day(time_t t);
+
+/**
+ * @brief Converts a local wall-clock time to an instant
+ *
+ * Times inside a DST gap resolve using the offset in effect before the gap.
+ *
+ * @param day Local day number (days since 1970-01-01)
+ * @param seconds Seconds since local midnight
+ * @return time_t The instant
+ */
+time_t tz_cache_local_time(long long day, long seconds);
+
+/**
+ * @brief Discards all cached segments (e.g. after TZ changes)
+ */
+void tz_cache_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TZ_CACHE_H
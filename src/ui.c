@@ -1,5 +1,12 @@
 /* ui.c */
+// strdup() is POSIX, not ISO C
+#define _POSIX_C_SOURCE 200809L
+
 #include "ui.h"
+#include "app_clock.h"
+#include "stats.h"
+#include "utils.h"
+#include "trace.h"
 #include <ncurses.h>
 #include <time.h>
 #include <string.h>
@@ -10,7 +17,8 @@ static const time_t APPROACH_THRESH = 3 * 24 * 60 * 60;
 int PROJECT_COL_WIDTH = 18;
 
 int ui_init(void) {
-    initscr();
+    // A screen set up beforehand (a headless one, for replays) is kept
+    if (!stdscr) initscr();
     if (!has_colors()) return -1;
     start_color();
     use_default_colors();
@@ -71,7 +79,7 @@ void ui_draw_standard_footer(void) {
     int y = LINES - 1;
     attron(A_REVERSE);
     mvhline(y, 0, ' ', COLS);
-    mvprintw(y, 1, "a:Add e:Edit d:Delete m:Mark v:ViewNote n:EditNote s:Sort /:Search +:NewProj -:DelProj q:Quit");
+    mvprintw(y, 1, "a:Add e:Edit d:Delete m:Mark u:Undo r:Redo v:ViewNote n:EditNote s:Sort /:Search S:Stats +:NewProj -:DelProj q:Quit");
     attroff(A_REVERSE);
 }
 
@@ -80,19 +88,96 @@ void ui_draw_ai_chat_footer(void) {
     int y = LINES - 1;
     attron(A_REVERSE);
     mvhline(y, 0, ' ', COLS);
-    mvprintw(y, 1, "AI Chat | j/k:Navigate h/l:Proj v:ViewNote n:EditNote +:NewProj -:DelProj Enter:Command m:Mark q:Quit");
+    mvprintw(y, 1, "AI Chat | j/k:Navigate h/l:Proj v:ViewNote n:EditNote +:NewProj -:DelProj Enter:Command m:Mark u:Undo r:Redo q:Quit");
     attroff(A_REVERSE);
 }
 
 int ui_color_for_due(time_t due) {
     if (due == 0) return CP_FUTURE;
-    time_t now = time(NULL);
+    time_t now = app_clock_now();
     if (due < now) return CP_OVERDUE;
     if ((due - now) <= APPROACH_THRESH) return CP_APPROACH;
     return CP_FUTURE;
 }
 
+void ui_draw_stats(const StatsReport *report) {
+    int offsetx = PROJECT_COL_WIDTH + 1;
+    for (int i = 2; i < LINES - 1; i++) {
+        move(i, offsetx);
+        clrtoeol();
+    }
+    int y = 2;
+    attron(A_BOLD);
+    mvprintw(y++, offsetx, "Last %zu days: %u completed, lead time %.1f days (all time %.1f)",
+             report->day_count, report->completed, report->lead_days, report->lead_days_all);
+    attroff(A_BOLD);
+    y++;
+
+    // Newest days first, as many as fit above the projects
+    int rows = (int)report->day_count;
+    int room = (LINES - 1) - y - 1 - (int)report->project_count - 2;
+    if (rows > room) rows = room > 0 ? room : 0;
+    if (rows > 0) mvprintw(y++, offsetx, "Date        Done  Opened  Closed  Overdue");
+    for (int i = 0; i < rows && y < LINES - 1; i++) {
+        const StatsDay *d = &report->days[report->day_count - 1 - i];
+        char date[16];
+        stats_format_day(d->day, date, sizeof(date));
+        mvprintw(y, offsetx, "%s  %4u  %6u  %6u  ", date, d->completed, d->opened, d->closed);
+        if (d->overdue > 0) attron(COLOR_PAIR(CP_OVERDUE));
+        if (d->overdue >= 0) printw("%7d", d->overdue);
+        else printw("%7s", "-");
+        if (d->overdue > 0) attroff(COLOR_PAIR(CP_OVERDUE));
+        y++;
+    }
+
+    if (report->project_count == 0 || y + 2 >= LINES - 1) return;
+    y++;
+    mvprintw(y++, offsetx, "Project             Open  Done  Burndown");
+    char *line = malloc(report->day_count + 1);
+    for (size_t i = 0; line && i < report->project_count && y < LINES - 1; i++) {
+        const StatsProject *p = &report->projects[i];
+        stats_sparkline(p->burndown, report->day_count, line, report->day_count + 1);
+        mvprintw(y++, offsetx, "%-18.18s  %4u  %4u  %s", p->name, p->open, p->completed, line);
+    }
+    utils_free(line);
+}
+
+// Helper: bytes with a binary unit
+static void format_bytes(unsigned long long bytes, char *buf, size_t len) {
+    if (bytes >= 1024ULL * 1024 * 1024) snprintf(buf, len, "%.1fG", bytes / (1024.0 * 1024 * 1024));
+    else if (bytes >= 1024 * 1024) snprintf(buf, len, "%.1fM", bytes / (1024.0 * 1024));
+    else if (bytes >= 1024) snprintf(buf, len, "%.1fK", bytes / 1024.0);
+    else snprintf(buf, len, "%lluB", bytes);
+}
+
+#define ALLOC_OVERLAY_WIDTH 58
+#define ALLOC_OVERLAY_SITES 8
+
+void ui_draw_alloc_overlay(void) {
+    UtilsAllocSite total, sites[ALLOC_OVERLAY_SITES];
+    int rows = LINES - 5;   // Below the header, above the footer and message line
+    if (rows > ALLOC_OVERLAY_SITES) rows = ALLOC_OVERLAY_SITES;
+    size_t n = utils_alloc_snapshot(&total, sites, rows > 0 ? (size_t)rows : 0);
+    int width = COLS < ALLOC_OVERLAY_WIDTH ? COLS : ALLOC_OVERLAY_WIDTH;
+    int x = COLS - width, y = 2;
+    char live[16], peak[16], bytes[16];
+
+    attron(A_REVERSE);
+    format_bytes(total.live, live, sizeof(live));
+    format_bytes(total.peak, peak, sizeof(peak));
+    format_bytes(total.bytes, bytes, sizeof(bytes));
+    mvhline(y, x, ' ', width);
+    mvprintw(y++, x, " Heap: live %s  peak %s  %llu allocs, %s", live, peak, total.count, bytes);
+    for (size_t i = 0; i < n; i++, y++) {
+        format_bytes(sites[i].live, live, sizeof(live));
+        format_bytes(sites[i].bytes, bytes, sizeof(bytes));
+        mvprintw(y, x, " %-*.*s %8s %8s ", width - 19, width - 19, sites[i].site, live, bytes);
+    }
+    attroff(A_REVERSE);
+}
+
 void ui_draw_tasks(Task **tasks, size_t count, size_t selected) {
+    trace_begin("ui_draw_tasks");
     int maxy = LINES - 3; // excluding header/footer
     int offsetx = PROJECT_COL_WIDTH + 1;
     size_t start = 0;
@@ -122,11 +207,7 @@ void ui_draw_tasks(Task **tasks, size_t count, size_t selected) {
         
         // Format due date
         char due_str[16] = "--";
-        if (t->due > 0) {
-            struct tm tm_due;
-            gmtime_r(&t->due, &tm_due);
-            strftime(due_str, sizeof(due_str), "%Y-%m-%d", &tm_due);
-        }
+        task_format_due_date(t, due_str, sizeof(due_str));
         
         // Determine task status indicator
         char status_brackets[4] = "[ ]";
@@ -152,7 +233,7 @@ void ui_draw_tasks(Task **tasks, size_t count, size_t selected) {
         }
         
         // Prepare task name with appropriate color
-        int cp = ui_color_for_due(t->due);
+        int cp = ui_color_for_due(task_due_deadline(t));
         
         // Highlight selected task
         if (idx == selected) {
@@ -177,9 +258,11 @@ void ui_draw_tasks(Task **tasks, size_t count, size_t selected) {
             // Print status indicator
             mvprintw(y, offsetx + 22, "%s", status_brackets);
             
-            // Print note icon (if present)
+            // Print note icon (if present), else the recurrence icon
             if (t->note && t->note[0] != '\0') {
                 mvprintw(y, offsetx + 25, "(N)");
+            } else if (t->recur) {
+                mvprintw(y, offsetx + 25, "(R)");
             } else {
                 mvprintw(y, offsetx + 25, "   ");
             }
@@ -223,9 +306,11 @@ void ui_draw_tasks(Task **tasks, size_t count, size_t selected) {
             // Print status indicator
             mvprintw(y, offsetx + 22, "%s", status_brackets);
             
-            // Print note icon (if present)
+            // Print note icon (if present), else the recurrence icon
             if (t->note && t->note[0] != '\0') {
                 mvprintw(y, offsetx + 25, "(N)");
+            } else if (t->recur) {
+                mvprintw(y, offsetx + 25, "(R)");
             } else {
                 mvprintw(y, offsetx + 25, "   ");
             }
@@ -245,6 +330,7 @@ void ui_draw_tasks(Task **tasks, size_t count, size_t selected) {
             }
         }
     }
+    trace_end("ui_draw_tasks");
 }
 
 /**
@@ -373,7 +459,7 @@ void ui_draw_note_view(const Task *task, int scroll_offset, bool *out_has_more_c
         }
         
         if (note_copy) {
-            free(note_copy); 
+            utils_free(note_copy); 
         }
         note_copy = strdup(full_note_text);
         line = strtok(note_copy, "\n");
@@ -419,7 +505,7 @@ void ui_draw_note_view(const Task *task, int scroll_offset, bool *out_has_more_c
             displayed_original_lines_count++;
             if(!temp_line && screen_lines_from_current_orig_lines < max_lines) break; // No more original lines
         }
-        free(temp_copy);
+        utils_free(temp_copy);
 
         // Now check if there are original lines *after* these displayed_original_lines_count (from the scroll_offset point)
         temp_copy = strdup(full_note_text);
@@ -430,9 +516,9 @@ void ui_draw_note_view(const Task *task, int scroll_offset, bool *out_has_more_c
         if (temp_line != NULL) { // If there's an original line after the ones we displayed / accounted for
             more_content_below_current_display = true;
         }
-        free(temp_copy);
+        utils_free(temp_copy);
         if (note_copy) {
-            free(note_copy); // Free the second strdup
+            utils_free(note_copy); // Free the second strdup
         }
 
         *out_has_more_content = more_content_below_current_display;
@@ -7,6 +7,7 @@
 #include <stddef.h>
 #include <time.h>
 #include "task.h"
+#include "stats.h"
 
 // Color pair definitions
 #define CP_DEFAULT    1
@@ -17,6 +18,7 @@
 
 /**
  * Initialize the TUI environment including colors and screen settings.
+ * Uses the current screen if one was made with newterm(), else the terminal.
  * @return 0 on success, non-zero on failure
  */
 int ui_init(void);
@@ -41,6 +43,18 @@ void ui_draw_header(const char *status_msg);
  */
 void ui_draw_tasks(Task **tasks, size_t count, size_t selected);
 
+/**
+ * Draw the statistics pane in place of the task list.
+ * @param report Report to show (from stats_report())
+ */
+void ui_draw_stats(const StatsReport *report);
+
+/**
+ * Draw the allocation overlay of debug builds over the top right corner:
+ * live and peak heap bytes and the busiest call sites (see utils.h).
+ */
+void ui_draw_alloc_overlay(void);
+
 /**
  * Draw the application footer with help keys.
  * General purpose footer display function.
@@ -0,0 +1,456 @@
+// ftruncate() and fileno() are POSIX, not ISO C
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <cjson/cJSON.h>
+#include "undo.h"
+#include "task_manager.h"
+#include "utils.h"
+
+// One delta: remove a task, insert a task, or restore some of its fields
+typedef enum {
+    OP_REMOVE,
+    OP_INSERT,
+    OP_PATCH
+} OpKind;
+
+typedef struct {
+    OpKind kind;
+    char *id;
+    char *data;     // INSERT: the task as JSON; PATCH: {"field": value|null}; REMOVE: NULL
+} UndoOp;
+
+// Deltas applied together, last first
+typedef struct {
+    char label[UNDO_LABEL_LEN];
+    UndoOp *ops;
+    size_t count;
+    size_t cap;
+    size_t bytes;   // Memory held, counted against the budget
+} UndoStep;
+
+typedef struct {
+    UndoStep **steps;   // Oldest first
+    size_t count;
+    size_t cap;
+} StepStack;
+
+static bool attached = false;
+static bool replaying = false;          // Applying a step; ignore the hooks
+static size_t budget = UNDO_BUDGET_BYTES;
+static size_t memory_bytes = 0;
+static StepStack undo_steps = {NULL, 0, 0};
+static StepStack redo_steps = {NULL, 0, 0};
+static UndoStep *open_step = NULL;      // Step the current group adds to
+static int group_depth = 0;
+static FILE *spill = NULL;              // Older undo steps, one JSON line each, newest last
+static size_t spilled = 0;
+static cJSON *pending = NULL;           // Task as it was before the change in progress
+
+static const char *const OP_NAMES[] = {"remove", "insert", "patch"};
+
+static UndoStep *step_new(const char *label) {
+    UndoStep *step = utils_calloc(1, sizeof(UndoStep));
+    if (!step) return NULL;
+    snprintf(step->label, sizeof(step->label), "%s", label ? label : "Change");
+    step->bytes = sizeof(UndoStep);
+    return step;
+}
+
+static void step_free(UndoStep *step) {
+    if (!step) return;
+    for (size_t i = 0; i < step->count; i++) {
+        utils_free(step->ops[i].id);
+        utils_free(step->ops[i].data);
+    }
+    utils_free(step->ops);
+    utils_free(step);
+}
+
+// Helper: append a delta; takes ownership of data. 0 on success, -1 on error
+static int step_add(UndoStep *step, OpKind kind, const char *id, char *data) {
+    if (step->count == step->cap) {
+        size_t cap = step->cap ? step->cap * 2 : 2;
+        UndoOp *ops = utils_realloc(step->ops, cap * sizeof(UndoOp));
+        if (!ops) {
+            utils_free(data);
+            return -1;
+        }
+        step->bytes += (cap - step->cap) * sizeof(UndoOp);
+        step->ops = ops;
+        step->cap = cap;
+    }
+    char *copy = utils_strdup(id);
+    if (!copy) {
+        utils_free(data);
+        return -1;
+    }
+    step->ops[step->count++] = (UndoOp){kind, copy, data};
+    step->bytes += strlen(id) + 1 + (data ? strlen(data) + 1 : 0);
+    return 0;
+}
+
+static int stack_push(StepStack *stack, UndoStep *step) {
+    if (stack->count == stack->cap) {
+        size_t cap = stack->cap ? stack->cap * 2 : 16;
+        UndoStep **steps = utils_realloc(stack->steps, cap * sizeof(UndoStep *));
+        if (!steps) return -1;
+        stack->steps = steps;
+        stack->cap = cap;
+    }
+    stack->steps[stack->count++] = step;
+    memory_bytes += step->bytes;
+    return 0;
+}
+
+static UndoStep *stack_pop(StepStack *stack) {
+    if (stack->count == 0) return NULL;
+    UndoStep *step = stack->steps[--stack->count];
+    memory_bytes -= step->bytes;
+    return step;
+}
+
+// Helper: take the oldest step off a stack
+static UndoStep *stack_take_oldest(StepStack *stack) {
+    if (stack->count == 0) return NULL;
+    UndoStep *step = stack->steps[0];
+    memmove(stack->steps, stack->steps + 1, --stack->count * sizeof(UndoStep *));
+    memory_bytes -= step->bytes;
+    return step;
+}
+
+static void stack_clear(StepStack *stack) {
+    while (stack->count > 0) step_free(stack_pop(stack));
+}
+
+// Helper: write a step as one line at the end of the spill journal
+static int spill_step(const UndoStep *step) {
+    if (!spill && !(spill = tmpfile())) return -1;
+    cJSON *line = cJSON_CreateObject();
+    cJSON *ops = line ? cJSON_AddArrayToObject(line, "ops") : NULL;
+    if (!ops) {
+        cJSON_Delete(line);
+        return -1;
+    }
+    cJSON_AddStringToObject(line, "label", step->label);
+    for (size_t i = 0; i < step->count; i++) {
+        const UndoOp *op = &step->ops[i];
+        cJSON *item = cJSON_CreateObject();
+        if (!item) break;
+        cJSON_AddStringToObject(item, "op", OP_NAMES[op->kind]);
+        cJSON_AddStringToObject(item, "id", op->id);
+        if (op->data) cJSON_AddItemToObject(item, "data", cJSON_Parse(op->data));
+        cJSON_AddItemToArray(ops, item);
+    }
+    char *text = cJSON_PrintUnformatted(line);
+    cJSON_Delete(line);
+    int rc = -1;
+    if (text && fseek(spill, 0, SEEK_END) == 0 && fputs(text, spill) >= 0 && fputc('\n', spill) != EOF
+        && fflush(spill) == 0) {
+        spilled++;
+        rc = 0;
+    }
+    utils_free(text);
+    return rc;
+}
+
+// Helper: remove the newest line of the spill journal and return it as a step
+static UndoStep *unspill_step(void) {
+    if (spilled == 0 || fseek(spill, 0, SEEK_END) != 0) return NULL;
+    long end = ftell(spill);
+    long start = 0;
+
+    // Walk back from the last line's newline to the one before it
+    char buf[4096];
+    for (long pos = end - 1; pos > 0 && start == 0;) {
+        long chunk = pos < (long)sizeof(buf) ? pos : (long)sizeof(buf);
+        if (fseek(spill, pos - chunk, SEEK_SET) != 0 || fread(buf, 1, (size_t)chunk, spill) != (size_t)chunk) return NULL;
+        for (long i = chunk - 1; i >= 0; i--) {
+            if (buf[i] == '\n') {
+                start = pos - chunk + i + 1;
+                break;
+            }
+        }
+        pos -= chunk;
+    }
+
+    size_t len = (size_t)(end - start);
+    char *text = utils_malloc(len + 1);
+    if (!text || fseek(spill, start, SEEK_SET) != 0 || fread(text, 1, len, spill) != len) {
+        utils_free(text);
+        return NULL;
+    }
+    text[len] = '\0';
+    cJSON *line = cJSON_Parse(text);
+    utils_free(text);
+    if (fflush(spill) != 0 || ftruncate(fileno(spill), start) != 0) {
+        cJSON_Delete(line);
+        return NULL;
+    }
+    spilled--;
+
+    UndoStep *step = line ? step_new(cJSON_GetStringValue(cJSON_GetObjectItem(line, "label"))) : NULL;
+    cJSON *item;
+    cJSON_ArrayForEach(item, cJSON_GetObjectItem(line, "ops")) {
+        if (!step) break;
+        const char *name = cJSON_GetStringValue(cJSON_GetObjectItem(item, "op"));
+        const char *id = cJSON_GetStringValue(cJSON_GetObjectItem(item, "id"));
+        cJSON *data = cJSON_GetObjectItem(item, "data");
+        OpKind kind = OP_REMOVE;
+        while (name && kind < OP_PATCH && strcmp(OP_NAMES[kind], name) != 0) kind++;
+        if (!id || (kind != OP_REMOVE && !data)
+            || step_add(step, kind, id, data ? cJSON_PrintUnformatted(data) : NULL) != 0) {
+            step_free(step);
+            step = NULL;
+        }
+    }
+    cJSON_Delete(line);
+    return step;
+}
+
+// Helper: get back under the budget; older undo steps go to the spill
+// journal, and redo steps beyond the budget are dropped
+static void enforce_budget(void) {
+    while (memory_bytes > budget && undo_steps.count > 0) {
+        UndoStep *step = stack_take_oldest(&undo_steps);
+        spill_step(step);
+        step_free(step);
+    }
+    while (memory_bytes > budget && redo_steps.count > 1) {
+        step_free(stack_take_oldest(&redo_steps));
+    }
+}
+
+// Helper: make a finished step undoable; a new change ends the redo history
+static void commit_step(UndoStep *step) {
+    if (step->count == 0 || stack_push(&undo_steps, step) != 0) {
+        step_free(step);
+        return;
+    }
+    stack_clear(&redo_steps);
+    enforce_budget();
+}
+
+// Helper: record the delta undoing one change; takes ownership of data
+static void record(OpKind kind, const char *id, char *data) {
+    UndoStep *step = open_step ? open_step : step_new(NULL);
+    if (!step) {
+        utils_free(data);
+        return;
+    }
+    step_add(step, kind, id, data);
+    if (!open_step) commit_step(step);
+}
+
+// Helper: the fields of before that after changed, with their old values
+// (null for fields after added); NULL if nothing changed
+static char *diff_fields(const cJSON *before, const cJSON *after) {
+    cJSON *patch = cJSON_CreateObject();
+    if (!patch) return NULL;
+    const cJSON *item;
+    cJSON_ArrayForEach(item, before) {
+        const cJSON *now = cJSON_GetObjectItem(after, item->string);
+        char *a = cJSON_PrintUnformatted(item);
+        char *b = now ? cJSON_PrintUnformatted(now) : NULL;
+        if (!a || !b || strcmp(a, b) != 0) cJSON_AddItemToObject(patch, item->string, cJSON_Duplicate(item, true));
+        utils_free(a);
+        utils_free(b);
+    }
+    cJSON_ArrayForEach(item, after) {
+        if (!cJSON_GetObjectItem(before, item->string)) cJSON_AddNullToObject(patch, item->string);
+    }
+    char *text = patch->child ? cJSON_PrintUnformatted(patch) : NULL;
+    cJSON_Delete(patch);
+    return text;
+}
+
+// Before-change hook: keep the task's old fields until the change is reported
+static void on_before_change(TaskChangeKind kind, const Task *task, void *user) {
+    (void)kind;
+    (void)user;
+    if (replaying) return;
+    cJSON_Delete(pending);
+    pending = task_to_cjson(task);
+}
+
+// Change hook: record the inverse of each change
+static void on_change(TaskChangeKind kind, const Task *task, void *user) {
+    (void)user;
+    if (replaying) return;
+    if (kind == TASK_CHANGE_ADD) {
+        record(OP_REMOVE, task->id, NULL);
+    } else if (kind == TASK_CHANGE_DELETE) {
+        char *json = task_to_json(task);
+        if (json) record(OP_INSERT, task->id, json);
+    } else if (pending && strcmp(cJSON_GetStringValue(cJSON_GetObjectItem(pending, "id")), task->id) == 0) {
+        // An edit without a before-change report cannot be undone
+        cJSON *now = task_to_cjson(task);
+        char *patch = now ? diff_fields(pending, now) : NULL;
+        cJSON_Delete(now);
+        if (patch) record(OP_PATCH, task->id, patch);
+    }
+    if (kind == TASK_CHANGE_PUT) {
+        cJSON_Delete(pending);
+        pending = NULL;
+    }
+}
+
+// Helper: index of the task with an id, or count if none
+static size_t find_task(Task **tasks, size_t count, const char *id) {
+    size_t i = 0;
+    while (i < count && strcmp(tasks[i]->id, id) != 0) i++;
+    return i;
+}
+
+// Helper: restore some fields of a task in place; the old values go to inverse
+static int apply_patch(Task *t, const char *data, UndoStep *inverse) {
+    cJSON *obj = task_to_cjson(t);
+    cJSON *patch = cJSON_Parse(data);
+    cJSON *undo = cJSON_CreateObject();
+    int rc = -1;
+    if (obj && patch && undo) {
+        cJSON *item;
+        cJSON_ArrayForEach(item, patch) {
+            cJSON *cur = cJSON_GetObjectItem(obj, item->string);
+            cJSON_AddItemToObject(undo, item->string, cur ? cJSON_Duplicate(cur, true) : cJSON_CreateNull());
+            cJSON_DeleteItemFromObject(obj, item->string);
+            if (!cJSON_IsNull(item)) cJSON_AddItemToObject(obj, item->string, cJSON_Duplicate(item, true));
+        }
+        Task *fresh = task_from_cjson(obj);
+        if (fresh) {
+            // Swap contents so pointers held by the caller stay valid
+            Task old = *t;
+            *t = *fresh;
+            *fresh = old;
+            task_free(fresh);
+            task_manager_notify_change(TASK_CHANGE_PUT, t);
+            rc = step_add(inverse, OP_PATCH, t->id, cJSON_PrintUnformatted(undo));
+        }
+    }
+    cJSON_Delete(obj);
+    cJSON_Delete(patch);
+    cJSON_Delete(undo);
+    return rc;
+}
+
+// Helper: apply one delta and record the delta reversing it in inverse.
+// A delta for a task that is gone (or already back) is skipped.
+static int apply_op(const UndoOp *op, Task ***tasks, size_t *count, UndoStep *inverse) {
+    size_t i = find_task(*tasks, *count, op->id);
+    if (op->kind == OP_REMOVE) {
+        if (i == *count) return 0;
+        char *json = task_to_json((*tasks)[i]);
+        if (!json || task_manager_delete_task(tasks, count, i) != 0) {
+            utils_free(json);
+            return -1;
+        }
+        return step_add(inverse, OP_INSERT, op->id, json);
+    }
+    if (op->kind == OP_PATCH) {
+        return i == *count ? 0 : apply_patch((*tasks)[i], op->data, inverse);
+    }
+    if (i < *count) return 0;
+    Task *t = task_from_json(op->data);
+    Task **grown = t ? utils_realloc(*tasks, (*count + 2) * sizeof(Task *)) : NULL;
+    if (!grown) {
+        task_free(t);
+        return -1;
+    }
+    grown[(*count)++] = t;
+    grown[*count] = NULL;
+    *tasks = grown;
+    task_manager_notify_change(TASK_CHANGE_ADD, t);
+    return step_add(inverse, OP_REMOVE, op->id, NULL);
+}
+
+// Helper: apply the newest step of from and push its inverse onto to
+static int replay(StepStack *from, StepStack *to, Task ***tasks, size_t *count, char *label, size_t label_size) {
+    UndoStep *step = stack_pop(from);
+    if (!step && from == &undo_steps) step = unspill_step();
+    if (!step) return spilled > 0 && from == &undo_steps ? -1 : 0;
+    UndoStep *inverse = step_new(step->label);
+    if (!inverse) {
+        stack_push(from, step);
+        return -1;
+    }
+
+    int rc = 1;
+    replaying = true;
+    for (size_t i = step->count; i-- > 0;) {
+        if (apply_op(&step->ops[i], tasks, count, inverse) != 0) rc = -1;
+    }
+    replaying = false;
+
+    if (label && label_size > 0) snprintf(label, label_size, "%s", step->label);
+    step_free(step);
+    if (inverse->count == 0 || stack_push(to, inverse) != 0) {
+        step_free(inverse);
+    } else {
+        enforce_budget();
+    }
+    return rc;
+}
+
+int undo_attach(size_t bytes) {
+    if (attached) return 1;
+    budget = bytes ? bytes : UNDO_BUDGET_BYTES;
+    attached = true;
+    task_manager_set_before_change_hook(on_before_change, NULL);
+    task_manager_set_change_hook(on_change, NULL);
+    return 0;
+}
+
+void undo_detach(void) {
+    if (!attached) return;
+    task_manager_set_before_change_hook(NULL, NULL);
+    task_manager_set_change_hook(NULL, NULL);
+    stack_clear(&undo_steps);
+    stack_clear(&redo_steps);
+    utils_free(undo_steps.steps);
+    utils_free(redo_steps.steps);
+    undo_steps = (StepStack){NULL, 0, 0};
+    redo_steps = (StepStack){NULL, 0, 0};
+    step_free(open_step);
+    open_step = NULL;
+    group_depth = 0;
+    if (spill) fclose(spill);
+    spill = NULL;
+    spilled = 0;
+    cJSON_Delete(pending);
+    pending = NULL;
+    attached = false;
+}
+
+void undo_begin(const char *label) {
+    if (!attached) return;
+    if (group_depth++ == 0) open_step = step_new(label);
+}
+
+void undo_end(void) {
+    if (!attached || group_depth == 0 || --group_depth > 0) return;
+    UndoStep *step = open_step;
+    open_step = NULL;
+    if (step) commit_step(step);
+}
+
+int undo_undo(Task ***tasks, size_t *count, char *label, size_t label_size) {
+    if (!attached) return 0;
+    return replay(&undo_steps, &redo_steps, tasks, count, label, label_size);
+}
+
+int undo_redo(Task ***tasks, size_t *count, char *label, size_t label_size) {
+    if (!attached) return 0;
+    return replay(&redo_steps, &undo_steps, tasks, count, label, label_size);
+}
+
+size_t undo_depth(void) {
+    return undo_steps.count + spilled;
+}
+
+size_t undo_memory_bytes(void) {
+    return memory_bytes;
+}
@@ -0,0 +1,81 @@
+#ifndef TODO_APP_UNDO_H
+#define TODO_APP_UNDO_H
+
+#include <stddef.h>
+#include "task.h"
+
+/**
+ * Undo/redo for the interactive modes. Once attached, the log watches the
+ * task_manager change hooks and records, for every change, only what
+ * undoing it takes: the id of an added task, the fields an edit overwrote,
+ * or the whole task for a delete. Undoing a step records the opposite
+ * delta as a redo step, and a new change clears the redo steps.
+ *
+ * Steps are kept in memory up to a byte budget; older steps are spilled to
+ * an anonymous journal file and read back when the undo reaches them.
+ */
+
+// Default memory budget for undo and redo steps
+#define UNDO_BUDGET_BYTES (256 * 1024)
+
+// Longest label kept for a step
+#define UNDO_LABEL_LEN 64
+
+/**
+ * Start recording task changes (installs both task_manager change hooks).
+ * @param budget Bytes of steps kept in memory (0 for UNDO_BUDGET_BYTES)
+ * @return 0 if attached now, 1 if the log was already attached, -1 on error
+ */
+int undo_attach(size_t budget);
+
+/**
+ * Stop recording, remove the hooks and forget every step.
+ */
+void undo_detach(void);
+
+/**
+ * Group the changes until undo_end() into one step, e.g. all changes an AI
+ * action makes. Changes made outside a group become one step each.
+ * Groups nest; the outermost label is kept.
+ * @param label Shown when the step is undone or redone
+ */
+void undo_begin(const char *label);
+
+/**
+ * Close the group opened by undo_begin().
+ */
+void undo_end(void);
+
+/**
+ * Undo the newest step.
+ * @param tasks Pointer to the task array (may be reallocated)
+ * @param count Pointer to the task count
+ * @param label[out] Label of the step undone (may be NULL)
+ * @param label_size Size of label
+ * @return 1 if a step was undone, 0 if there is nothing to undo, -1 on error
+ */
+int undo_undo(Task ***tasks, size_t *count, char *label, size_t label_size);
+
+/**
+ * Redo the step undone last.
+ * @param tasks Pointer to the task array (may be reallocated)
+ * @param count Pointer to the task count
+ * @param label[out] Label of the step redone (may be NULL)
+ * @param label_size Size of label
+ * @return 1 if a step was redone, 0 if there is nothing to redo, -1 on error
+ */
+int undo_redo(Task ***tasks, size_t *count, char *label, size_t label_size);
+
+/**
+ * Number of steps that can be undone, in memory and spilled.
+ * @return Step count
+ */
+size_t undo_depth(void);
+
+/**
+ * Bytes of undo and redo steps held in memory.
+ * @return Byte count
+ */
+size_t undo_memory_bytes(void);
+
+#endif // TODO_APP_UNDO_H
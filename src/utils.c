@@ -1,3 +1,8 @@
+// strdup(), gmtime_r(), fileno() and fsync() are POSIX, strptime() is in
+// its XSI part, and timegm() is a BSD extension; none of them are ISO C
+#define _XOPEN_SOURCE 700
+#define _DEFAULT_SOURCE
+
 #include "utils.h"
 #include "date_parser.h"
 #include <stdlib.h>
@@ -6,9 +11,17 @@
 #include <unistd.h>
 #include <errno.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
 
 // Parse date in various formats to time_t (midnight UTC), 0 if empty/invalid
 time_t utils_parse_date(const char *s) {
+    return utils_parse_due(s, NULL);
+}
+
+time_t utils_parse_due(const char *s, bool *date_only) {
+    if (date_only) *date_only = false;
     if (!s || s[0] == '\0') return 0;
     
     // First try natural language parsing
@@ -21,10 +34,16 @@ time_t utils_parse_date(const char *s) {
     struct tm tm = {0};
     
     // 1. ISO 8601 date with time (YYYY-MM-DDThh:mm:ssZ)
+    if (utils_parse_iso8601(s, &result)) {
+        return result;
+    }
     if (strptime(s, "%Y-%m-%dT%H:%M:%SZ", &tm)) {
         return timegm(&tm);
     }
     
+    // Remaining formats are calendar dates
+    if (date_only) *date_only = true;
+
     // 2. ISO 8601 date only (YYYY-MM-DD)
     if (strptime(s, "%Y-%m-%d", &tm)) {
         // Set to midnight UTC
@@ -47,28 +66,146 @@ time_t utils_parse_date(const char *s) {
     }
     
     // No valid format found
+    if (date_only) *date_only = false;
     return 0;
 }
 
+// Days since 1970-01-01 for a civil date (H. Hinnant's days_from_civil)
+long long utils_days_from_civil(int y, int m, int d) {
+    y -= m <= 2;
+    long long era = (y >= 0 ? y : y - 399) / 400;
+    long long yoe = y - era * 400;                                   // [0, 399]
+    long long doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;  // [0, 365]
+    long long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;           // [0, 146096]
+    return era * 146097 + doe - 719468;
+}
+
+// Civil date for a day number since 1970-01-01 (inverse of the above)
+void utils_civil_from_days(long long z, int *y, int *m, int *d) {
+    z += 719468;
+    long long era = (z >= 0 ? z : z - 146096) / 146097;
+    long long doe = z - era * 146097;                                      // [0, 146096]
+    long long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365; // [0, 399]
+    long long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);               // [0, 365]
+    long long mp = (5 * doy + 2) / 153;                                    // [0, 11]
+    *d = (int)(doy - (153 * mp + 2) / 5 + 1);
+    *m = (int)(mp < 10 ? mp + 3 : mp - 9);
+    *y = (int)(yoe + era * 400 + (*m <= 2));
+}
+
+// Number of days in a month of a given year
+int utils_days_in_month(int y, int m) {
+    static const int mdays[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if (m == 2 && (y % 4 == 0 && (y % 100 != 0 || y % 400 == 0))) return 29;
+    return mdays[m - 1];
+}
+
+// Helper: write a zero-padded decimal of fixed width
+static void put_digits(char *p, int v, int width) {
+    for (int i = width - 1; i >= 0; --i) {
+        p[i] = (char)('0' + v % 10);
+        v /= 10;
+    }
+}
+
+// Helper: read a fixed-width decimal, -1 if any character is not a digit
+static int get_digits(const char *p, int width) {
+    int v = 0;
+    for (int i = 0; i < width; ++i) {
+        if (p[i] < '0' || p[i] > '9') return -1;
+        v = v * 10 + (p[i] - '0');
+    }
+    return v;
+}
+
+// Format time_t as YYYY-MM-DDThh:mm:ssZ without allocating
+char *utils_format_iso8601(time_t t, char *buf) {
+    if (!buf) return NULL;
+    long long days = (long long)t / 86400;
+    long long secs = (long long)t % 86400;
+    if (secs < 0) {
+        secs += 86400;
+        days--;
+    }
+    int y, m, d;
+    utils_civil_from_days(days, &y, &m, &d);
+    if (y < 0 || y > 9999) return NULL;
+
+    put_digits(buf, y, 4);
+    buf[4] = '-';
+    put_digits(buf + 5, m, 2);
+    buf[7] = '-';
+    put_digits(buf + 8, d, 2);
+    buf[10] = 'T';
+    put_digits(buf + 11, (int)(secs / 3600), 2);
+    buf[13] = ':';
+    put_digits(buf + 14, (int)(secs / 60 % 60), 2);
+    buf[16] = ':';
+    put_digits(buf + 17, (int)(secs % 60), 2);
+    buf[19] = 'Z';
+    buf[20] = '\0';
+    return buf;
+}
+
+// Strictly parse YYYY-MM-DDThh:mm:ssZ
+bool utils_parse_iso8601(const char *s, time_t *out) {
+    if (!s || !out) return false;
+    // The length first: short input ends before the separators
+    size_t len = 0;
+    while (len < 21 && s[len]) len++;
+    if (len != 20) return false;
+    if (s[4] != '-' || s[7] != '-' || s[10] != 'T' || s[13] != ':' ||
+        s[16] != ':' || s[19] != 'Z') {
+        return false;
+    }
+    int y = get_digits(s, 4);
+    int m = get_digits(s + 5, 2);
+    int d = get_digits(s + 8, 2);
+    int hh = get_digits(s + 11, 2);
+    int mm = get_digits(s + 14, 2);
+    int ss = get_digits(s + 17, 2);
+    if (y < 0 || m < 1 || m > 12 || d < 1 || d > utils_days_in_month(y, m)) return false;
+    if (hh < 0 || hh > 23 || mm < 0 || mm > 59 || ss < 0 || ss > 59) return false;
+
+    *out = (time_t)(utils_days_from_civil(y, m, d) * 86400 + hh * 3600 + mm * 60 + ss);
+    return true;
+}
+
 // Format time_t as ISO8601 string
 char *utils_time_to_iso8601(time_t t) {
-    struct tm tm;
-    gmtime_r(&t, &tm);
-    char *buf = utils_malloc(21); // YYYY-MM-DDThh:mm:ssZ\0
+    char *buf = utils_malloc(UTILS_ISO8601_BUFSZ); // YYYY-MM-DDThh:mm:ssZ\0
     if (!buf) return NULL;
-    strftime(buf, 21, "%Y-%m-%dT%H:%M:%SZ", &tm);
+    if (!utils_format_iso8601(t, buf)) {
+        // Out of the 4-digit year range: let strftime deal with it
+        struct tm tm;
+        gmtime_r(&t, &tm);
+        strftime(buf, UTILS_ISO8601_BUFSZ, "%Y-%m-%dT%H:%M:%SZ", &tm);
+    }
     return buf;
 }
 
 // Parse ISO8601 to time_t
 time_t utils_iso8601_to_time(const char *s) {
+    time_t t;
+    if (utils_parse_iso8601(s, &t)) return t;
+
+    // Nonstandard input: fall back to strptime
     struct tm tm = {0};
     strptime(s, "%Y-%m-%dT%H:%M:%SZ", &tm);
     return timegm(&tm);
 }
 
+// Whether utils_show_message() waits out its seconds
+static bool message_wait = true;
+
+void utils_set_message_wait(bool enabled) {
+    message_wait = enabled;
+}
+
 // Display a temporary message at the specified line
 void utils_show_message(const char *msg, int line, int seconds) {
+    // Without a screen (command line, tests) there is nobody to wait for
+    if (!stdscr) return;
     attron(A_REVERSE);
     mvhline(line, 0, ' ', COLS);
     mvprintw(line, 1, "%s", msg);
@@ -76,15 +213,18 @@ void utils_show_message(const char *msg, int line, int seconds) {
     refresh();
     
     // Only sleep if seconds > 0, otherwise just show the message without clearing
-    if (seconds > 0) {
+    if (seconds > 0 && message_wait) {
         sleep(seconds);
         mvhline(line, 0, ' ', COLS); // Clear the message
         refresh();
     }
 }
 
+// The allocators are named in parentheses so that the accounting macros of
+// utils.h (UTILS_ALLOC_STATS) do not expand here
+
 // Safe memory allocation with error checking
-void *utils_malloc(size_t size) {
+void *(utils_malloc)(size_t size) {
     void *ptr = malloc(size);
     if (!ptr && size > 0) {
         // Log error to stderr if allocation fails
@@ -94,7 +234,7 @@ void *utils_malloc(size_t size) {
 }
 
 // Safe calloc with error checking
-void *utils_calloc(size_t nmemb, size_t size) {
+void *(utils_calloc)(size_t nmemb, size_t size) {
     void *ptr = calloc(nmemb, size);
     if (!ptr && nmemb > 0 && size > 0) {
         // Log error to stderr if allocation fails
@@ -104,7 +244,7 @@ void *utils_calloc(size_t nmemb, size_t size) {
 }
 
 // Safe memory reallocation with error checking
-void *utils_realloc(void *ptr, size_t size) {
+void *(utils_realloc)(void *ptr, size_t size) {
     void *new_ptr = realloc(ptr, size);
     if (!new_ptr && size > 0) {
         // Log error to stderr if reallocation fails
@@ -114,7 +254,7 @@ void *utils_realloc(void *ptr, size_t size) {
 }
 
 // Safe string duplication with error checking
-char *utils_strdup(const char *s) {
+char *(utils_strdup)(const char *s) {
     if (!s) return NULL;
     
     char *new_str = strdup(s);
@@ -125,6 +265,266 @@ char *utils_strdup(const char *s) {
     return new_str;
 }
 
+#ifdef UTILS_ALLOC_STATS
+#define ALLOC_MAX_SITES 1024       // Power of two; further sites are counted as "other"
+#define ALLOC_REPORT_TOP 20
+
+// A live block: its size and the site that allocated it
+typedef struct {
+    void *ptr;
+    size_t size;
+    UtilsAllocSite *site;
+} AllocBlock;
+
+static UtilsAllocSite alloc_sites[ALLOC_MAX_SITES];
+static size_t alloc_site_count;
+static UtilsAllocSite alloc_other = {"other", 0, 0, 0, 0};
+static UtilsAllocSite alloc_total = {"total", 0, 0, 0, 0};
+static AllocBlock *alloc_blocks;   // Open addressing, keyed by pointer
+static size_t alloc_block_cap;     // Power of two, or 0
+static size_t alloc_block_count;
+static atomic_flag alloc_lock = ATOMIC_FLAG_INIT;
+static bool alloc_dump_registered;
+
+static void alloc_acquire(void) {
+    while (atomic_flag_test_and_set_explicit(&alloc_lock, memory_order_acquire)) {
+    }
+}
+
+static void alloc_release(void) {
+    atomic_flag_clear_explicit(&alloc_lock, memory_order_release);
+}
+
+// Helper: hash a pointer; the low bits are alignment
+static size_t alloc_hash(const void *p) {
+    uint64_t h = ((uint64_t)(uintptr_t)p >> 4) * 0x9E3779B97F4A7C15ULL;
+    return (size_t)(h ^ (h >> 32));
+}
+
+// Helper: the record of a call site; site strings are literals, so the
+// pointer identifies the site
+static UtilsAllocSite *alloc_site(const char *site) {
+    size_t mask = ALLOC_MAX_SITES - 1;
+    for (size_t i = alloc_hash(site) & mask;; i = (i + 1) & mask) {
+        if (alloc_sites[i].site == site) return &alloc_sites[i];
+        if (!alloc_sites[i].site) {
+            // Keep a quarter free so probes stay short
+            if (alloc_site_count >= ALLOC_MAX_SITES / 4 * 3) return &alloc_other;
+            alloc_sites[i].site = site;
+            alloc_site_count++;
+            return &alloc_sites[i];
+        }
+    }
+}
+
+// Helper: add to or take from the live bytes of a site and the total
+static void alloc_add_live(UtilsAllocSite *site, size_t size, bool add) {
+    if (add) {
+        site->live += size;
+        alloc_total.live += size;
+        if (site->live > site->peak) site->peak = site->live;
+        if (alloc_total.live > alloc_total.peak) alloc_total.peak = alloc_total.live;
+    } else {
+        site->live -= size;
+        alloc_total.live -= size;
+    }
+}
+
+// Helper: slot of a live block, or of the free slot where it would go
+static size_t alloc_block_slot(const void *ptr) {
+    size_t mask = alloc_block_cap - 1;
+    size_t i = alloc_hash(ptr) & mask;
+    while (alloc_blocks[i].ptr && alloc_blocks[i].ptr != ptr) i = (i + 1) & mask;
+    return i;
+}
+
+// Helper: double the block table; false if out of memory
+static bool alloc_blocks_grow(void) {
+    size_t cap = alloc_block_cap ? alloc_block_cap * 2 : 4096;
+    AllocBlock *grown = calloc(cap, sizeof(AllocBlock));
+    if (!grown) return false;
+    AllocBlock *old = alloc_blocks;
+    size_t old_cap = alloc_block_cap;
+    alloc_blocks = grown;
+    alloc_block_cap = cap;
+    for (size_t i = 0; i < old_cap; i++) {
+        if (old[i].ptr) alloc_blocks[alloc_block_slot(old[i].ptr)] = old[i];
+    }
+    free(old);
+    return true;
+}
+
+// Helper: forget a live block, if it is one, with backward-shift deletion
+static void alloc_untrack(void *ptr) {
+    if (!ptr || alloc_block_count == 0) return;
+    size_t i = alloc_block_slot(ptr);
+    if (!alloc_blocks[i].ptr) return;   // Not allocated through utils
+    alloc_add_live(alloc_blocks[i].site, alloc_blocks[i].size, false);
+    alloc_block_count--;
+
+    size_t mask = alloc_block_cap - 1;
+    for (size_t j = (i + 1) & mask; alloc_blocks[j].ptr; j = (j + 1) & mask) {
+        size_t home = alloc_hash(alloc_blocks[j].ptr) & mask;
+        bool stays = i <= j ? (i < home && home <= j) : (i < home || home <= j);
+        if (stays) continue;
+        alloc_blocks[i] = alloc_blocks[j];
+        i = j;
+    }
+    alloc_blocks[i].ptr = NULL;
+}
+
+static void alloc_dump_at_exit(void) {
+    const char *dest = getenv("SMARTODO_ALLOC_REPORT");
+    if (dest && strcmp(dest, "off") == 0) return;
+    bool to_stderr = !dest || dest[0] == '\0' || strcmp(dest, "-") == 0;
+    FILE *out = to_stderr ? stderr : fopen(dest, "w");
+    if (!out) return;
+    utils_alloc_report(out, ALLOC_REPORT_TOP);
+    if (!to_stderr) fclose(out);
+}
+
+// Helper: count an allocation; the lock is held
+static void alloc_track(void *ptr, size_t size, const char *site) {
+    if (!alloc_dump_registered) {
+        alloc_dump_registered = true;
+        atexit(alloc_dump_at_exit);
+    }
+    UtilsAllocSite *s = alloc_site(site ? site : "?");
+    s->count++;
+    s->bytes += size;
+    alloc_total.count++;
+    alloc_total.bytes += size;
+    if ((alloc_block_count + 1) * 2 > alloc_block_cap && !alloc_blocks_grow()) return;
+    size_t i = alloc_block_slot(ptr);
+    // A block still listed was released with plain free(); its address is
+    // being reused, so its bytes are not live any more
+    if (!alloc_blocks[i].ptr) alloc_block_count++;
+    else alloc_add_live(alloc_blocks[i].site, alloc_blocks[i].size, false);
+    alloc_blocks[i] = (AllocBlock){ptr, size, s};
+    alloc_add_live(s, size, true);
+}
+
+// The block is forgotten before free(), so its address cannot be handed
+// out again while it is still listed
+void utils_free(void *ptr) {
+    if (!ptr) return;
+    alloc_acquire();
+    alloc_untrack(ptr);
+    alloc_release();
+    free(ptr);
+}
+
+void *utils_malloc_at(size_t size, const char *site) {
+    void *ptr = (utils_malloc)(size);
+    if (ptr) {
+        alloc_acquire();
+        alloc_track(ptr, size, site);
+        alloc_release();
+    }
+    return ptr;
+}
+
+void *utils_calloc_at(size_t nmemb, size_t size, const char *site) {
+    void *ptr = (utils_calloc)(nmemb, size);
+    if (ptr) {
+        alloc_acquire();
+        alloc_track(ptr, nmemb * size, site);
+        alloc_release();
+    }
+    return ptr;
+}
+
+// The lock is held across realloc(), so the old block cannot be handed to
+// another thread before it is forgotten
+void *utils_realloc_at(void *ptr, size_t size, const char *site) {
+    uintptr_t old_ptr = (uintptr_t)ptr;   // Only a key once realloc() has run
+    alloc_acquire();
+    void *new_ptr = realloc(ptr, size);
+    if (new_ptr || size == 0) alloc_untrack((void *)old_ptr);
+    if (new_ptr) alloc_track(new_ptr, size, site);
+    alloc_release();
+    if (!new_ptr && size > 0) {
+        fprintf(stderr, "Memory reallocation failed for %zu bytes\n", size);
+    }
+    return new_ptr;
+}
+
+char *utils_strdup_at(const char *s, const char *site) {
+    char *ptr = (utils_strdup)(s);
+    if (ptr) {
+        alloc_acquire();
+        alloc_track(ptr, strlen(ptr) + 1, site);
+        alloc_release();
+    }
+    return ptr;
+}
+
+bool utils_alloc_stats_enabled(void) {
+    return true;
+}
+
+// Helper: order sites by live, then allocated bytes
+static int compare_alloc_sites(const void *a, const void *b) {
+    const UtilsAllocSite *x = a, *y = b;
+    if (x->live != y->live) return x->live < y->live ? 1 : -1;
+    if (x->bytes != y->bytes) return x->bytes < y->bytes ? 1 : -1;
+    return 0;
+}
+
+size_t utils_alloc_snapshot(UtilsAllocSite *total, UtilsAllocSite *sites, size_t max) {
+    UtilsAllocSite *all = (sites && max > 0) ? malloc((ALLOC_MAX_SITES + 1) * sizeof(UtilsAllocSite)) : NULL;
+    size_t n = 0;
+    alloc_acquire();
+    if (total) *total = alloc_total;
+    for (size_t i = 0; all && i < ALLOC_MAX_SITES; i++) {
+        if (alloc_sites[i].site) all[n++] = alloc_sites[i];
+    }
+    if (all && alloc_other.count > 0) all[n++] = alloc_other;
+    alloc_release();
+    if (!all) return 0;
+
+    qsort(all, n, sizeof(UtilsAllocSite), compare_alloc_sites);
+    if (n > max) n = max;
+    memcpy(sites, all, n * sizeof(UtilsAllocSite));
+    free(all);
+    return n;
+}
+
+void utils_alloc_report(FILE *out, size_t top) {
+    UtilsAllocSite total;
+    UtilsAllocSite *sites = top > 0 ? malloc(top * sizeof(UtilsAllocSite)) : NULL;
+    size_t n = utils_alloc_snapshot(&total, sites, sites ? top : 0);
+    fprintf(out, "Allocations through utils: %llu (%llu bytes), live %zu bytes, peak %zu bytes\n",
+            total.count, total.bytes, total.live, total.peak);
+    if (n > 0) fprintf(out, "%-36s %10s %14s %12s %12s\n", "site", "allocs", "bytes", "live", "peak");
+    for (size_t i = 0; i < n; i++) {
+        fprintf(out, "%-36s %10llu %14llu %12zu %12zu\n", sites[i].site, sites[i].count, sites[i].bytes,
+                sites[i].live, sites[i].peak);
+    }
+    free(sites);
+}
+#else
+void utils_free(void *ptr) {
+    free(ptr);
+}
+
+bool utils_alloc_stats_enabled(void) {
+    return false;
+}
+
+size_t utils_alloc_snapshot(UtilsAllocSite *total, UtilsAllocSite *sites, size_t max) {
+    (void)sites;
+    (void)max;
+    if (total) *total = (UtilsAllocSite){"total", 0, 0, 0, 0};
+    return 0;
+}
+
+void utils_alloc_report(FILE *out, size_t top) {
+    (void)top;
+    fprintf(out, "Allocation accounting is not compiled in (build with -DUTILS_ALLOC_STATS)\n");
+}
+#endif
+
 // Safe file opening with error checking
 FILE *utils_fopen(const char *path, const char *mode) {
     if (!path || !mode) return NULL;
@@ -144,3 +544,71 @@ void utils_fclose(FILE *fp) {
         fclose(fp);
     }
 }
+
+// Read a whole file; NULL (errno kept) if it cannot be read
+char *utils_read_file(const char *path, size_t *len) {
+    if (len) *len = 0;
+    FILE *f = path ? fopen(path, "r") : NULL;
+    if (!f) return NULL;
+    struct stat st;
+    char *buf = NULL;
+    if (fstat(fileno(f), &st) == 0 && (buf = utils_malloc((size_t)st.st_size + 1)) != NULL) {
+        size_t n = fread(buf, 1, (size_t)st.st_size, f);
+        buf[n] = '\0';
+        if (len) *len = n;
+    }
+    int saved = errno;
+    fclose(f);
+    errno = saved;
+    return buf;
+}
+
+// Replace a file through path.tmp, flushed to disk before the rename
+int utils_write_file_atomic(const char *path, const char *data, size_t len) {
+    if (!path || !data) return -1;
+    size_t plen = strlen(path);
+    char *tmp = utils_malloc(plen + sizeof(".tmp"));
+    if (!tmp) return -1;
+    memcpy(tmp, path, plen);
+    memcpy(tmp + plen, ".tmp", sizeof(".tmp"));
+    int rc = -1;
+    FILE *f = utils_fopen(tmp, "w");
+    if (f) {
+        bool ok = fwrite(data, 1, len, f) == len && fflush(f) == 0 && fsync(fileno(f)) == 0;
+        ok = (fclose(f) == 0) && ok;
+        rc = (ok && rename(tmp, path) == 0) ? 0 : -1;
+        if (rc != 0) unlink(tmp);
+    }
+    utils_free(tmp);
+    return rc;
+}
+
+// FNV-1a, 64-bit, over a byte range
+uint64_t utils_fnv1a(uint64_t h, const void *data, size_t len) {
+    const unsigned char *p = data;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// FNV-1a, 64-bit, over a string
+uint64_t utils_fnv1a_str(const char *s) {
+    uint64_t h = UTILS_FNV1A_INIT;
+    for (; *s; s++) {
+        h ^= (unsigned char)*s;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// FNV-1a, 32-bit, over a string
+uint32_t utils_fnv1a32_str(const char *s) {
+    uint32_t h = 2166136261u;
+    for (; *s; s++) {
+        h ^= (unsigned char)*s;
+        h *= 16777619u;
+    }
+    return h;
+}
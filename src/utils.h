@@ -4,6 +4,7 @@
 #include <time.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdint.h>
 
 /**
  * Parse date in YYYY-MM-DD to time_t (midnight UTC)
@@ -12,6 +13,16 @@
  */
 time_t utils_parse_date(const char *s);
 
+/**
+ * Parse a due date string and report whether it names a date only.
+ * Natural language and ISO date-times yield instants; YYYY-MM-DD and the
+ * other date-only formats yield midnight UTC of the calendar date.
+ * @param s Date string
+ * @param date_only[out] Set to true for date-only input (may be NULL)
+ * @return time_t timestamp, or 0 if empty/invalid
+ */
+time_t utils_parse_due(const char *s, bool *date_only);
+
 /**
  * Format time_t as ISO8601 string (YYYY-MM-DDT00:00:00Z)
  * @param t time_t timestamp
@@ -21,11 +32,60 @@ char *utils_time_to_iso8601(time_t t);
 
 /**
  * Parse ISO8601 string to time_t
+ * Uses utils_parse_iso8601() and falls back to strptime for nonstandard input.
  * @param s ISO8601 string (YYYY-MM-DDT00:00:00Z)
  * @return time_t timestamp
  */
 time_t utils_iso8601_to_time(const char *s);
 
+// Buffer size for utils_format_iso8601 (YYYY-MM-DDThh:mm:ssZ plus terminator)
+#define UTILS_ISO8601_BUFSZ 21
+
+/**
+ * Format time_t as YYYY-MM-DDThh:mm:ssZ into a caller-provided buffer.
+ * Allocation-free; does not call gmtime_r or strftime.
+ * @param t time_t timestamp (years 0000-9999)
+ * @param buf Output buffer of at least UTILS_ISO8601_BUFSZ bytes
+ * @return buf on success, or NULL if t is out of range
+ */
+char *utils_format_iso8601(time_t t, char *buf);
+
+/**
+ * Strictly parse the fixed form YYYY-MM-DDThh:mm:ssZ (exactly 20 characters).
+ * Rejects out-of-range fields (e.g. Feb 30, hour 24) and trailing characters.
+ * @param s Input string
+ * @param out[out] Parsed UTC timestamp
+ * @return true on success, false if s is not in the exact form
+ */
+bool utils_parse_iso8601(const char *s, time_t *out);
+
+/**
+ * Days since 1970-01-01 for a proleptic Gregorian civil date.
+ * @param y Year
+ * @param m Month (1-12)
+ * @param d Day of month (1-31); days past the month's end count on into
+ *          the following months
+ * @return Day number (negative before the epoch)
+ */
+long long utils_days_from_civil(int y, int m, int d);
+
+/**
+ * Number of days in a month of the proleptic Gregorian calendar.
+ * @param y Year
+ * @param m Month (1-12)
+ * @return Days in the month (28-31)
+ */
+int utils_days_in_month(int y, int m);
+
+/**
+ * Civil date for a day number since 1970-01-01 (inverse of utils_days_from_civil).
+ * @param z Day number
+ * @param y[out] Year
+ * @param m[out] Month (1-12)
+ * @param d[out] Day of month (1-31)
+ */
+void utils_civil_from_days(long long z, int *y, int *m, int *d);
+
 /**
  * Display a temporary message at the specified line
  * @param msg Message to display
@@ -34,6 +94,13 @@ time_t utils_iso8601_to_time(const char *s);
  */
 void utils_show_message(const char *msg, int line, int seconds);
 
+/**
+ * Enable or disable the wait of utils_show_message(). Replays of recorded
+ * sessions disable it so a turn's time is the work it does.
+ * @param enabled Whether messages stay up for their seconds
+ */
+void utils_set_message_wait(bool enabled);
+
 /**
  * Safe memory allocation with error checking
  * @param size Size in bytes to allocate
@@ -64,6 +131,71 @@ void *utils_realloc(void *ptr, size_t size);
  */
 char *utils_strdup(const char *s);
 
+/**
+ * Free memory from the allocators above. Memory from elsewhere may be
+ * passed too; NULL is ignored.
+ * @param ptr Block to free
+ */
+void utils_free(void *ptr);
+
+/**
+ * Allocation accounting. Built with -DUTILS_ALLOC_STATS (make debug), the
+ * four allocators above are tagged with their call site ("file.c:123") and
+ * counted: allocations and bytes, and live and peak bytes per site and in
+ * total. A block stops being live when utils_free() or utils_realloc()
+ * releases it; one released with plain free() is counted live until its
+ * address is handed out again. Without the flag the allocators are the
+ * plain functions and the calls below report nothing.
+ */
+#ifdef UTILS_ALLOC_STATS
+#define UTILS_ALLOC_STR_(x) #x
+#define UTILS_ALLOC_STR(x) UTILS_ALLOC_STR_(x)
+#define UTILS_ALLOC_SITE __FILE__ ":" UTILS_ALLOC_STR(__LINE__)
+
+void *utils_malloc_at(size_t size, const char *site);
+void *utils_calloc_at(size_t nmemb, size_t size, const char *site);
+void *utils_realloc_at(void *ptr, size_t size, const char *site);
+char *utils_strdup_at(const char *s, const char *site);
+
+#define utils_malloc(size) utils_malloc_at((size), UTILS_ALLOC_SITE)
+#define utils_calloc(nmemb, size) utils_calloc_at((nmemb), (size), UTILS_ALLOC_SITE)
+#define utils_realloc(ptr, size) utils_realloc_at((ptr), (size), UTILS_ALLOC_SITE)
+#define utils_strdup(s) utils_strdup_at((s), UTILS_ALLOC_SITE)
+#endif
+
+// Accounting of one call site, or of all of them
+typedef struct {
+    const char *site;              // "file.c:123", or "total"
+    unsigned long long count;      // Allocations
+    unsigned long long bytes;      // Bytes requested
+    size_t live;                   // Bytes not freed yet
+    size_t peak;                   // Highest live
+} UtilsAllocSite;
+
+/**
+ * Whether allocation accounting is compiled in
+ * @return true in builds with UTILS_ALLOC_STATS
+ */
+bool utils_alloc_stats_enabled(void);
+
+/**
+ * Take a snapshot of the accounting.
+ * @param total[out] Totals over all sites (may be NULL)
+ * @param sites[out] The busiest sites, by live then allocated bytes (may be NULL)
+ * @param max Capacity of sites
+ * @return Number of sites written
+ */
+size_t utils_alloc_snapshot(UtilsAllocSite *total, UtilsAllocSite *sites, size_t max);
+
+/**
+ * Print the accounting as a table. In accounting builds this also runs at
+ * exit, to the file named by SMARTODO_ALLOC_REPORT ("-" or unset for
+ * stderr, "off" for none).
+ * @param out Stream to print to
+ * @param top Number of sites to list
+ */
+void utils_alloc_report(FILE *out, size_t top);
+
 /**
  * Safe file opening with error checking
  * @param path File path
@@ -78,4 +210,49 @@ FILE *utils_fopen(const char *path, const char *mode);
  */
 void utils_fclose(FILE *fp);
 
+/**
+ * Read a whole file into memory.
+ * @param path File path
+ * @param len[out] Bytes read, not counting the terminator (may be NULL)
+ * @return Allocated NUL-terminated contents (caller must free), or NULL if
+ *         the file cannot be read; errno is ENOENT if it does not exist
+ */
+char *utils_read_file(const char *path, size_t *len);
+
+/**
+ * Replace a file so that it survives a crash: write path.tmp, flush it to
+ * disk, then rename it over path.
+ * @param path File path
+ * @param data Contents
+ * @param len Length of data in bytes
+ * @return 0 on success, -1 on failure (path is left as it was)
+ */
+int utils_write_file_atomic(const char *path, const char *data, size_t len);
+
+// Starting value of an FNV-1a hash
+#define UTILS_FNV1A_INIT 1469598103934665603ULL
+
+/**
+ * Continue a 64-bit FNV-1a hash over a byte range.
+ * @param h Hash so far (UTILS_FNV1A_INIT to start)
+ * @param data Bytes to hash
+ * @param len Number of bytes
+ * @return Updated hash
+ */
+uint64_t utils_fnv1a(uint64_t h, const void *data, size_t len);
+
+/**
+ * 64-bit FNV-1a hash of a string.
+ * @param s NUL-terminated string
+ * @return Hash
+ */
+uint64_t utils_fnv1a_str(const char *s);
+
+/**
+ * 32-bit FNV-1a hash of a string, for hashes stored as JSON numbers.
+ * @param s NUL-terminated string
+ * @return Hash
+ */
+uint32_t utils_fnv1a32_str(const char *s);
+
 #endif // TODO_APP_UTILS_H
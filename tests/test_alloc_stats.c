@@ -0,0 +1,165 @@
+// Built with UTILS_ALLOC_STATS, against utils.c built the same way
+#include "minunit.h"
+#include "../src/utils.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+// Test counter
+int tests_run = 0;
+
+// Forward declarations for test functions
+static char *test_counts_per_site(void);
+static char *test_live_and_peak(void);
+static char *test_realloc_moves_bytes(void);
+static char *test_snapshot_order(void);
+static char *test_plain_free(void);
+
+// Helper function to run all tests
+static char *all_tests(void) {
+    mu_run_test(test_counts_per_site);
+    mu_run_test(test_live_and_peak);
+    mu_run_test(test_realloc_moves_bytes);
+    mu_run_test(test_snapshot_order);
+    mu_run_test(test_plain_free);
+    return 0;
+}
+
+// Call sites of the helpers below, as the accounting names them
+static const char *site_a, *site_b;
+
+// Helper: the accounting of a site
+static bool find_site(const char *site, UtilsAllocSite *out) {
+    UtilsAllocSite sites[64];
+    size_t n = utils_alloc_snapshot(NULL, sites, 64);
+    for (size_t i = 0; i < n; i++) {
+        if (strcmp(sites[i].site, site) == 0) {
+            *out = sites[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+// Helper: one allocation site
+static void *alloc_a(size_t size) {
+    site_a = UTILS_ALLOC_SITE; return utils_malloc(size);
+}
+
+// Helper: another
+static char *dup_b(const char *s) {
+    site_b = UTILS_ALLOC_SITE; return utils_strdup(s);
+}
+
+static char *test_counts_per_site(void) {
+    mu_assert("accounting compiled in", utils_alloc_stats_enabled());
+    UtilsAllocSite before, after;
+    utils_alloc_snapshot(&before, NULL, 0);
+    void *p[3];
+    for (int i = 0; i < 3; i++) p[i] = alloc_a(100);
+    char *s = dup_b("hello");
+    utils_alloc_snapshot(&after, NULL, 0);
+    mu_assert("total count", after.count - before.count == 4);
+    mu_assert("total bytes", after.bytes - before.bytes == 306);
+
+    UtilsAllocSite a, b;
+    mu_assert("malloc site found", find_site(site_a, &a));
+    mu_assert("malloc site counts", a.count == 3 && a.bytes == 300);
+    mu_assert("strdup site found", find_site(site_b, &b));
+    mu_assert("strdup site counts", b.count == 1 && b.bytes == 6);
+
+    for (int i = 0; i < 3; i++) utils_free(p[i]);
+    utils_free(s);
+    return 0;
+}
+
+static char *test_live_and_peak(void) {
+    UtilsAllocSite before, during, after;
+    utils_alloc_snapshot(&before, NULL, 0);
+    int *a = utils_calloc(1000, sizeof(int));
+    int *b = utils_calloc(1000, sizeof(int));
+    mu_assert("allocated", a && b);
+    utils_alloc_snapshot(&during, NULL, 0);
+    utils_free(a);
+    utils_free(b);
+    utils_alloc_snapshot(&after, NULL, 0);
+    mu_assert("live while held", during.live - before.live == 2000 * sizeof(int));
+    mu_assert("live after free", after.live == before.live);
+    mu_assert("peak kept", after.peak >= before.live + 2000 * sizeof(int));
+    return 0;
+}
+
+static char *test_realloc_moves_bytes(void) {
+    UtilsAllocSite before, after;
+    utils_alloc_snapshot(&before, NULL, 0);
+    char *buf = utils_malloc(16);
+    char *grown = utils_realloc(buf, 1 << 20);
+    mu_assert("realloc", grown != NULL);
+    utils_alloc_snapshot(&after, NULL, 0);
+    mu_assert("two allocations", after.count - before.count == 2);
+    mu_assert("live is the new size", after.live - before.live == 1 << 20);
+    utils_free(grown);
+    utils_alloc_snapshot(&after, NULL, 0);
+    mu_assert("nothing live", after.live == before.live);
+
+    // Memory from outside utils is freed without disturbing the accounting
+    char *plain = malloc(64);
+    utils_free(plain);
+    UtilsAllocSite last;
+    utils_alloc_snapshot(&last, NULL, 0);
+    mu_assert("plain free ignored", last.live == after.live && last.count == after.count);
+    return 0;
+}
+
+static char *test_snapshot_order(void) {
+    void *big = utils_malloc(1 << 16);
+    UtilsAllocSite sites[4];
+    size_t n = utils_alloc_snapshot(NULL, sites, 4);
+    mu_assert("sites", n > 0 && n <= 4);
+    mu_assert("largest live first", sites[0].live == 1 << 16);
+    for (size_t i = 1; i < n; i++) {
+        mu_assert("ordered", sites[i - 1].live > sites[i].live ||
+                                 (sites[i - 1].live == sites[i].live && sites[i - 1].bytes >= sites[i].bytes));
+    }
+    utils_free(big);
+    return 0;
+}
+
+static char *test_plain_free(void) {
+    UtilsAllocSite before, after;
+    utils_alloc_snapshot(&before, NULL, 0);
+    void *p = alloc_a(4096);
+    free(p);
+
+    // Released behind the accounting's back: live until the address comes
+    // back (if the allocator reuses it), then counted once
+    void *q = NULL;
+    for (int i = 0; i < 100 && q != p; i++) {
+        utils_free(q);
+        q = alloc_a(4096);
+    }
+    utils_alloc_snapshot(&after, NULL, 0);
+    if (q == p) mu_assert("counted once", after.live - before.live == 4096);
+    utils_free(q);
+    utils_alloc_snapshot(&after, NULL, 0);
+    mu_assert("nothing live", after.live == before.live || (q != p && after.live - before.live == 4096));
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    (void)argc;  // Unused parameter
+    (void)argv;  // Unused parameter
+
+    printf("Running allocation accounting tests...\n");
+    setenv("SMARTODO_ALLOC_REPORT", "off", 1);
+
+    char *result = all_tests();
+    if (result != 0) {
+        printf("TEST FAILED: %s\n", result);
+    } else {
+        printf("ALL TESTS PASSED\n");
+    }
+    printf("Tests run: %d\n", tests_run);
+    return result != 0;
+}
@@ -0,0 +1,128 @@
+#include "minunit.h"
+#include "../src/app_clock.h"
+#include "../src/date_parser.h"
+#include <time.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+// Test counter
+int tests_run = 0;
+
+// Forward declarations for test functions
+static char *test_fixed_clock(void);
+static char *test_day_context(void);
+static char *test_day_context_sunday(void);
+static char *test_parser_uses_clock(void);
+static char *test_local_day(void);
+
+// Helper function to run all tests
+static char *all_tests(void) {
+    mu_run_test(test_fixed_clock);
+    mu_run_test(test_day_context);
+    mu_run_test(test_day_context_sunday);
+    mu_run_test(test_parser_uses_clock);
+    mu_run_test(test_local_day);
+    return 0;
+}
+
+// Helper: build a local timestamp
+static time_t local_time(int year, int mon, int mday, int hour, int min) {
+    struct tm tm = {0};
+    tm.tm_year = year - 1900;
+    tm.tm_mon = mon - 1;
+    tm.tm_mday = mday;
+    tm.tm_hour = hour;
+    tm.tm_min = min;
+    tm.tm_isdst = -1;
+    return mktime(&tm);
+}
+
+static char *test_fixed_clock(void) {
+    time_t fixed = local_time(2026, 10, 14, 10, 0);
+    app_clock_set_fixed(fixed);
+
+    mu_assert("clock should be fixed", app_clock_is_fixed());
+    mu_assert("now should be the fixed time", app_clock_now() == fixed);
+    app_clock_tick();
+    mu_assert("tick keeps the fixed time", app_clock_now() == fixed);
+
+    app_clock_set_fixed(0);
+    mu_assert("clock should follow the system time", !app_clock_is_fixed());
+    mu_assert("now should be current", app_clock_now() >= fixed);
+
+    return 0;
+}
+
+static char *test_day_context(void) {
+    // Wednesday 2026-10-14 10:00 local
+    app_clock_set_fixed(local_time(2026, 10, 14, 10, 0));
+    const AppClockDay *day = app_clock_day();
+
+    mu_assert("wday", day->wday == 3);
+    mu_assert("today_start", day->today_start == local_time(2026, 10, 14, 0, 0));
+    mu_assert("tomorrow_start", day->tomorrow_start == local_time(2026, 10, 15, 0, 0));
+    mu_assert("tomorrow_end", day->tomorrow_end == local_time(2026, 10, 16, 0, 0));
+    mu_assert("week_end", day->week_end == local_time(2026, 10, 19, 0, 0));
+    mu_assert("next_week_start", day->next_week_start == local_time(2026, 10, 19, 0, 0));
+    mu_assert("next_week_end", day->next_week_end == local_time(2026, 10, 26, 0, 0));
+
+    app_clock_set_fixed(0);
+    return 0;
+}
+
+static char *test_day_context_sunday(void) {
+    // Sunday 2026-10-18 23:30 local: this week runs through next Sunday
+    app_clock_set_fixed(local_time(2026, 10, 18, 23, 30));
+    const AppClockDay *day = app_clock_day();
+
+    mu_assert("wday", day->wday == 0);
+    mu_assert("week_end", day->week_end == local_time(2026, 10, 26, 0, 0));
+    mu_assert("next_week_start", day->next_week_start == local_time(2026, 10, 19, 0, 0));
+
+    // Crossing midnight recomputes the day context
+    app_clock_set_fixed(local_time(2026, 10, 19, 0, 30));
+    mu_assert("day rolls over", app_clock_day()->today_start == local_time(2026, 10, 19, 0, 0));
+
+    app_clock_set_fixed(0);
+    return 0;
+}
+
+static char *test_parser_uses_clock(void) {
+    app_clock_set_fixed(local_time(2026, 10, 14, 10, 0));
+    time_t result;
+
+    mu_assert("tomorrow", parse_natural_date("tomorrow", &result) &&
+              result == local_time(2026, 10, 15, 9, 0));
+    mu_assert("parse_time_today rolls over", parse_time_today("9am", &result) &&
+              result == local_time(2026, 10, 15, 9, 0));
+
+    app_clock_set_fixed(0);
+    return 0;
+}
+
+static char *test_local_day(void) {
+    // 2026-10-14 is day 20740 wherever the clock is read
+    mu_assert("midnight", app_clock_local_day(local_time(2026, 10, 14, 0, 0)) == 20740);
+    mu_assert("late evening", app_clock_local_day(local_time(2026, 10, 14, 23, 59)) == 20740);
+    mu_assert("next day", app_clock_local_day(local_time(2026, 10, 15, 0, 0)) == 20741);
+    mu_assert("before the epoch", app_clock_local_day(local_time(1969, 12, 31, 12, 0)) == -1);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    (void)argc;  // Unused parameter
+    (void)argv;  // Unused parameter
+
+    printf("Running app_clock tests...\n");
+
+    char *result = all_tests();
+    if (result != 0) {
+        printf("TEST FAILED: %s\n", result);
+    } else {
+        printf("ALL TESTS PASSED\n");
+    }
+    printf("Tests run: %d\n", tests_run);
+
+    return result != 0;
+}
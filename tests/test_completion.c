@@ -0,0 +1,150 @@
+#include "minunit.h"
+#include "test_utils.h"
+#include "../src/completion.h"
+#include "../src/storage.h"
+#include "../src/journal.h"
+#include "../src/daemon_client.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <unistd.h>
+
+// Test counter
+int tests_run = 0;
+
+static char output[8192];
+
+// Forward declarations for test functions
+static char *test_index_on_save(void);
+static char *test_complete_values(void);
+static char *test_complete_ids(void);
+static char *test_scripts(void);
+
+// Helper function to run all tests
+static char *all_tests(void) {
+    mu_run_test(test_index_on_save);
+    mu_run_test(test_complete_values);
+    mu_run_test(test_complete_ids);
+    mu_run_test(test_scripts);
+    return 0;
+}
+
+// Helper: create a task with a project, one tag and a creation time
+static Task *make_task(const char *name, const char *project, const char *tag, time_t created) {
+    const char *tags[] = {tag};
+    Task *t = task_create(name, 0, DUE_NONE, tags, 1, PRIORITY_LOW);
+    if (!t) return NULL;
+    free(t->project);
+    t->project = strdup(project);
+    t->created = created;
+    return t;
+}
+
+// Helper: complete a command line given as words; the last is the current word
+static const char *complete(int argc, char **argv) {
+    FILE *out = fmemopen(output, sizeof(output) - 1, "w");
+    memset(output, 0, sizeof(output));
+    completion_complete(argc, argv, out);
+    fclose(out);
+    return output;
+}
+
+static char *test_index_on_save(void) {
+    Task *tasks[3] = {
+        make_task("Write report", "work", "urgent", 1000),
+        make_task("Buy milk", "home", "errand", 3000),
+        make_task("Call Bob", "work", "urgent", 2000),
+    };
+    tasks[2]->status = STATUS_DONE;
+    mu_assert("save", storage_save_tasks(tasks, 3) == 0);
+
+    char *path = storage_path(COMPLETION_INDEX_FILE);
+    FILE *f = fopen(path, "r");
+    free(path);
+    mu_assert("index written", f != NULL);
+    char buf[1024];
+    size_t len = fread(buf, 1, sizeof(buf) - 1, f);
+    buf[len] = '\0';
+    fclose(f);
+    mu_assert("projects once, sorted", strstr(buf, "P\thome\nP\twork\n") != NULL);
+    mu_assert("tags once, sorted", strstr(buf, "T\terrand\nT\turgent\n") != NULL);
+    mu_assert("newest task first", strstr(buf, "Buy milk") < strstr(buf, "Call Bob")
+              && strstr(buf, "Call Bob") < strstr(buf, "Write report"));
+    mu_assert("status kept", strstr(buf, "\td\tCall Bob\n") != NULL);
+
+    for (size_t i = 0; i < 3; i++) task_free(tasks[i]);
+    return 0;
+}
+
+static char *test_complete_values(void) {
+    mu_assert("commands", strcmp(complete(1, (char *[]){"se"}), "search\n") == 0);
+    mu_assert("flags", strcmp(complete(2, (char *[]){"list", "--p"}), "--project\n--priority\n") == 0);
+    mu_assert("projects", strcmp(complete(3, (char *[]){"list", "--project", "w"}), "work\n") == 0);
+    mu_assert("tags", strcmp(complete(3, (char *[]){"add", "--tag", ""}), "errand\nurgent\n") == 0);
+    mu_assert("fixed values", strcmp(complete(3, (char *[]){"list", "--status", "d"}), "done\n") == 0);
+    mu_assert("free text", strcmp(complete(2, (char *[]){"add", "Bu"}), "") == 0);
+    return 0;
+}
+
+static char *test_complete_ids(void) {
+    size_t count = 0;
+    Task **tasks = storage_load_tasks(&count);
+    mu_assert("load", tasks && count == 3);
+
+    // rm offers every recent task; done only pending ones
+    const char *out = complete(2, (char *[]){"rm", ""});
+    mu_assert("all ids", strstr(out, "\tWrite report\n") && strstr(out, "\tCall Bob\n"));
+    char line[64];
+    snprintf(line, sizeof(line), "%.8s\tBuy milk\n", tasks[1]->id);
+    mu_assert("short id and name", strstr(out, line) != NULL);
+    out = complete(2, (char *[]){"done", ""});
+    mu_assert("pending only", strstr(out, "Buy milk") && !strstr(out, "Call Bob"));
+
+    char prefix[4];
+    snprintf(prefix, sizeof(prefix), "%.3s", tasks[0]->id);
+    out = complete(2, (char *[]){"done", prefix});
+    mu_assert("prefix", strstr(out, "Write report") != NULL);
+    mu_assert("id only once", strcmp(complete(3, (char *[]){"edit", prefix, ""}), "") == 0);
+
+    // A missing index is rebuilt from the tasks
+    char *path = storage_path(COMPLETION_INDEX_FILE);
+    unlink(path);
+    free(path);
+    mu_assert("rebuilt", strcmp(complete(3, (char *[]){"list", "--project", "h"}), "home\n") == 0);
+
+    storage_free_tasks(tasks, count);
+    return 0;
+}
+
+static char *test_scripts(void) {
+    char script[4096];
+    FILE *out = fmemopen(script, sizeof(script), "w");
+    mu_assert("bash", completion_print_script("bash", out) == 0);
+    mu_assert("zsh", completion_print_script("zsh", out) == 0);
+    mu_assert("fish", completion_print_script("fish", out) == 0);
+    mu_assert("unknown shell", completion_print_script("tcsh", out) != 0);
+    fclose(out);
+    mu_assert("scripts call __complete", strstr(script, "__complete") != NULL);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    (void)argc;  // Unused parameter
+    (void)argv;  // Unused parameter
+
+    printf("Running completion tests...\n");
+
+    if (!test_home_setup()) return 1;
+
+    char *result = all_tests();
+    if (result != 0) {
+        printf("TEST FAILED: %s\n", result);
+    } else {
+        printf("ALL TESTS PASSED\n");
+    }
+    printf("Tests run: %d\n", tests_run);
+
+    test_home_teardown();
+    return result != 0;
+}
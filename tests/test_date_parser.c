@@ -1,6 +1,5 @@
 #include "minunit.h"
 #include "../src/date_parser.h"
-#include "test_utils.h"
 #include <time.h>
 #include <string.h>
 #include <stdbool.h>
@@ -12,11 +11,13 @@ int tests_run = 0;
 // Forward declarations for test functions
 static char *test_parse_time_today(void);
 static char *test_parse_natural_date(void);
+static char *test_parse_natural_date_ctx(void);
 
 // Helper function to run all tests
 static char *all_tests(void) {
     mu_run_test(test_parse_time_today);
     mu_run_test(test_parse_natural_date);
+    mu_run_test(test_parse_natural_date_ctx);
     return 0;
 }
 
@@ -60,6 +61,59 @@ static char *test_parse_natural_date(void) {
     return 0;
 }
 
+// Helper: build a local timestamp
+static time_t local_time(int year, int mon, int mday, int hour, int min) {
+    struct tm tm = {0};
+    tm.tm_year = year - 1900;
+    tm.tm_mon = mon - 1;
+    tm.tm_mday = mday;
+    tm.tm_hour = hour;
+    tm.tm_min = min;
+    tm.tm_isdst = -1;
+    return mktime(&tm);
+}
+
+static char *test_parse_natural_date_ctx(void) {
+    // Reference: Wednesday 2026-10-14 10:00 local
+    DateParseContext ctx;
+    date_parser_context_init(&ctx, local_time(2026, 10, 14, 10, 0));
+    time_t result;
+
+    mu_assert("tomorrow", parse_natural_date_ctx(&ctx, "tomorrow", &result) &&
+              result == local_time(2026, 10, 15, 9, 0));
+    mu_assert("today", parse_natural_date_ctx(&ctx, "today", &result) &&
+              result == local_time(2026, 10, 14, 17, 0));
+    mu_assert("next friday 3pm", parse_natural_date_ctx(&ctx, "next friday 3pm", &result) &&
+              result == local_time(2026, 10, 16, 15, 0));
+    mu_assert("wednesday", parse_natural_date_ctx(&ctx, "wednesday", &result) &&
+              result == local_time(2026, 10, 21, 9, 0));
+    mu_assert("in 2 weeks", parse_natural_date_ctx(&ctx, "in 2 weeks", &result) &&
+              result == local_time(2026, 10, 28, 9, 0));
+    mu_assert("in 3 hours", parse_natural_date_ctx(&ctx, "in 3 hours", &result) &&
+              result == ctx.now + 3 * 3600);
+    mu_assert("end of month", parse_natural_date_ctx(&ctx, "end of month", &result) &&
+              result == local_time(2026, 10, 31, 9, 0));
+    mu_assert("the 5th", parse_natural_date_ctx(&ctx, "the 5th", &result) &&
+              result == local_time(2026, 11, 5, 9, 0));
+    mu_assert("Dec 25 2pm", parse_natural_date_ctx(&ctx, "Dec 25 2pm", &result) &&
+              result == local_time(2026, 12, 25, 14, 0));
+    mu_assert("may 20", parse_natural_date_ctx(&ctx, "may 20", &result) &&
+              result == local_time(2027, 5, 20, 9, 0));
+    mu_assert("20 may 2026 at 14:30",
+              parse_natural_date_ctx(&ctx, "20 may 2026 at 14:30", &result) &&
+              result == local_time(2026, 5, 20, 14, 30));
+    mu_assert("noon", parse_natural_date_ctx(&ctx, "noon", &result) &&
+              result == local_time(2026, 10, 14, 12, 0));
+
+    mu_assert("Two dates should fail", !parse_natural_date_ctx(&ctx, "today tomorrow", &result));
+    mu_assert("Bare unit should fail", !parse_natural_date_ctx(&ctx, "weeks", &result));
+    mu_assert("Feb 30 should fail", !parse_natural_date_ctx(&ctx, "feb 30", &result));
+    mu_assert("ISO date is not natural language",
+              !parse_natural_date_ctx(&ctx, "2026-10-14", &result));
+
+    return 0;
+}
+
 int main(int argc, char **argv) {
     (void)argc;  // Unused parameter
     (void)argv;  // Unused parameter
@@ -0,0 +1,251 @@
+#include "minunit.h"
+#include "test_utils.h"
+#include "../src/history.h"
+#include "../src/storage.h"
+#include "../src/task_manager.h"
+#include "../src/daemon_client.h"
+#include "../src/app_clock.h"
+#include <cjson/cJSON.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <dirent.h>
+
+#define T0 1790000000
+
+// Test counter
+int tests_run = 0;
+
+static char report_id[64];
+
+// Forward declarations for test functions
+static char *test_task_from_before(void);
+static char *test_task_history(void);
+static char *test_state_at(void);
+static char *test_completed(void);
+static char *test_checkpoints(void);
+
+// Helper function to run all tests
+static char *all_tests(void) {
+    mu_run_test(test_task_from_before);
+    mu_run_test(test_task_history);
+    mu_run_test(test_state_at);
+    mu_run_test(test_completed);
+    mu_run_test(test_checkpoints);
+    return 0;
+}
+
+// Helper: the task named name, or NULL
+static Task *find(Task **tasks, size_t count, const char *name) {
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(tasks[i]->name, name) == 0) return tasks[i];
+    }
+    return NULL;
+}
+
+// Helper: add a task at a given time and save
+static int add_task(time_t now, const char *name, time_t due, const char *repeat) {
+    app_clock_set_fixed(now);
+    size_t count = 0;
+    Task **tasks = storage_load_tasks(&count);
+    if (!tasks || task_manager_add_task(&tasks, &count, name, due, DUE_DATETIME, NULL, 0,
+                                        PRIORITY_LOW, "work") != 0) {
+        return -1;
+    }
+    tasks[count - 1]->created = now;
+    if (repeat && task_set_recurrence(tasks[count - 1], repeat) != 0) return -1;
+    int rc = storage_save_tasks(tasks, count);
+    storage_free_tasks(tasks, count);
+    return rc;
+}
+
+// Helper: change one task at a given time and save
+static int edit(time_t now, const char *name, void (*change)(Task *)) {
+    app_clock_set_fixed(now);
+    size_t count = 0;
+    Task **tasks = storage_load_tasks(&count);
+    Task *t = tasks ? find(tasks, count, name) : NULL;
+    if (!t) return -1;
+    change(t);
+    int rc = storage_save_tasks(tasks, count);
+    storage_free_tasks(tasks, count);
+    return rc;
+}
+
+static void set_high(Task *t) { t->priority = PRIORITY_HIGH; }
+static void set_done(Task *t) { t->status = STATUS_DONE; }
+static void complete(Task *t) { task_manager_complete_task(t); }
+
+// Helper: the change of one field in a history event
+static const cJSON *change_of(const cJSON *event, const char *field) {
+    return cJSON_GetObjectItem(cJSON_GetObjectItem(event, "changes"), field);
+}
+
+static char *test_task_from_before(void) {
+    // Changed before any history query: the first checkpoint must still
+    // hold the task as it was before the journal began
+    mu_assert("edit", edit(T0 - 500, "Legacy", set_high) == 0);
+
+    size_t count = 0;
+    Task **tasks = history_state_at(T0 - 600, &count);
+    Task *t = tasks ? find(tasks, count, "Legacy") : NULL;
+    mu_assert("there before its first change", t && t->priority == PRIORITY_MEDIUM);
+    char prefix[9];
+    snprintf(prefix, sizeof(prefix), "%.8s", t ? t->id : "");
+    storage_free_tasks(tasks, count);
+
+    size_t matches = 0;
+    cJSON *events = history_task(prefix, &matches);
+    const cJSON *high = cJSON_GetArrayItem(events, 0);
+    mu_assert("one update", events && matches == 1 && cJSON_GetArraySize(events) == 1
+              && strcmp(cJSON_GetStringValue(cJSON_GetObjectItem(high, "type")), "update") == 0);
+    mu_assert("only the priority changed", cJSON_GetArraySize(cJSON_GetObjectItem(high, "changes")) == 1
+              && strcmp(cJSON_GetStringValue(cJSON_GetObjectItem(change_of(high, "priority"), "from")), "medium") == 0);
+    cJSON_Delete(events);
+    return 0;
+}
+
+static char *test_task_history(void) {
+    mu_assert("add", add_task(T0, "Report", 0, NULL) == 0);
+    mu_assert("edit", edit(T0 + 100, "Report", set_high) == 0);
+    mu_assert("done", edit(T0 + 200, "Report", set_done) == 0);
+
+    size_t count = 0;
+    Task **tasks = storage_load_tasks(&count);
+    mu_assert("loaded", tasks && find(tasks, count, "Report"));
+    snprintf(report_id, sizeof(report_id), "%s", find(tasks, count, "Report")->id);
+    storage_free_tasks(tasks, count);
+
+    char prefix[9];
+    snprintf(prefix, sizeof(prefix), "%.8s", report_id);
+    size_t matches = 0;
+    cJSON *events = history_task(prefix, &matches);
+    mu_assert("one match", events && matches == 1 && cJSON_GetArraySize(events) == 3);
+    const cJSON *add = cJSON_GetArrayItem(events, 0);
+    const cJSON *high = cJSON_GetArrayItem(events, 1);
+    const cJSON *done = cJSON_GetArrayItem(events, 2);
+    mu_assert("add event", strcmp(cJSON_GetStringValue(cJSON_GetObjectItem(add, "type")), "add") == 0
+              && cJSON_IsNull(cJSON_GetObjectItem(change_of(add, "name"), "from")));
+    mu_assert("priority change", cJSON_GetArraySize(cJSON_GetObjectItem(high, "changes")) == 1
+              && strcmp(cJSON_GetStringValue(cJSON_GetObjectItem(change_of(high, "priority"), "from")), "low") == 0
+              && strcmp(cJSON_GetStringValue(cJSON_GetObjectItem(change_of(high, "priority"), "to")), "high") == 0);
+    mu_assert("change time", cJSON_GetNumberValue(cJSON_GetObjectItem(high, "ts")) == T0 + 100);
+    mu_assert("status change", change_of(done, "status") && !change_of(done, "priority"));
+    cJSON_Delete(events);
+
+    events = history_task("zzzz", &matches);
+    mu_assert("no match", events && matches == 0 && cJSON_GetArraySize(events) == 0);
+    cJSON_Delete(events);
+    return 0;
+}
+
+static char *test_state_at(void) {
+    size_t count = 0;
+    Task **tasks = history_state_at(T0 - 1, &count);
+    mu_assert("before the add only the old task", tasks && count == 1 && find(tasks, count, "Legacy"));
+    storage_free_tasks(tasks, count);
+
+    tasks = history_state_at(T0 + 150, &count);
+    Task *t = tasks ? find(tasks, count, "Report") : NULL;
+    mu_assert("edited, not done", count == 2 && t && t->priority == PRIORITY_HIGH && t->status == STATUS_PENDING);
+    storage_free_tasks(tasks, count);
+
+    tasks = history_state_at(T0 + 200, &count);
+    t = tasks ? find(tasks, count, "Report") : NULL;
+    mu_assert("done", t && t->status == STATUS_DONE);
+    storage_free_tasks(tasks, count);
+    return 0;
+}
+
+static char *test_completed(void) {
+    mu_assert("add recurring", add_task(T0 + 300, "Standup", T0 + 86400, "daily") == 0);
+    mu_assert("complete occurrence", edit(T0 + 400, "Standup", complete) == 0);
+
+    cJSON *entries = history_completed(T0, T0 + 500);
+    mu_assert("two completions", entries && cJSON_GetArraySize(entries) == 2);
+    Task *report = task_from_cjson(cJSON_GetObjectItem(cJSON_GetArrayItem(entries, 0), "task"));
+    Task *standup = task_from_cjson(cJSON_GetObjectItem(cJSON_GetArrayItem(entries, 1), "task"));
+    mu_assert("report done", report && strcmp(report->name, "Report") == 0 && report->status == STATUS_DONE);
+    mu_assert("occurrence completed", standup && strcmp(standup->name, "Standup") == 0 && standup->due == T0 + 86400);
+    task_free(report);
+    task_free(standup);
+    cJSON_Delete(entries);
+
+    entries = history_completed(T0 + 200, T0 + 399);
+    mu_assert("range excludes both", entries && cJSON_GetArraySize(entries) == 0);
+    cJSON_Delete(entries);
+    return 0;
+}
+
+// Helper: number of checkpoint files
+static int checkpoint_files(void) {
+    char *path = storage_path(HISTORY_DIR);
+    DIR *dir = path ? opendir(path) : NULL;
+    free(path);
+    int n = 0;
+    struct dirent *entry;
+    while (dir && (entry = readdir(dir)) != NULL) n += strstr(entry->d_name, ".json") != NULL;
+    if (dir) closedir(dir);
+    return n;
+}
+
+// Helper: rename the task Counter to its next value
+static int counter = 0;
+static void bump(Task *t) {
+    char name[32];
+    snprintf(name, sizeof(name), "v%d", ++counter);
+    free(t->name);
+    t->name = strdup(name);
+}
+
+static char *test_checkpoints(void) {
+    mu_assert("one checkpoint so far", checkpoint_files() == 1);
+    mu_assert("add", add_task(T0 + 1000, "v0", 0, NULL) == 0);
+    for (int i = 0; i < 2 * HISTORY_CHECKPOINT_RECORDS; i++) {
+        char name[32];
+        snprintf(name, sizeof(name), "v%d", counter);
+        mu_assert("rename", edit(T0 + 1001 + i, name, bump) == 0);
+    }
+    mu_assert("checkpoints written", history_update() == 2 && checkpoint_files() == 3);
+    mu_assert("none missing", history_update() == 0);
+
+    size_t count = 0;
+    Task **tasks = history_state_at(T0 + 1000 + 1500, &count);
+    mu_assert("between checkpoints", tasks && find(tasks, count, "v1500") && find(tasks, count, "Standup"));
+    storage_free_tasks(tasks, count);
+
+    tasks = history_state_at(T0 + 150, &count);
+    Task *t = tasks ? find(tasks, count, "Report") : NULL;
+    mu_assert("early state still right", t && t->priority == PRIORITY_HIGH && !find(tasks, count, "v0"));
+    storage_free_tasks(tasks, count);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    (void)argc;  // Unused parameter
+    (void)argv;  // Unused parameter
+
+    printf("Running history tests...\n");
+
+    if (!test_home_setup()) return 1;
+
+    // A task saved before anything was journaled
+    Task *legacy = task_create("Legacy", 0, DUE_NONE, NULL, 0, PRIORITY_MEDIUM);
+    if (!legacy || storage_init() != 0) return 1;
+    legacy->created = T0 - 1000;
+    Task *snapshot[] = {legacy, NULL};
+    if (storage_write_snapshot(snapshot, 1) != 0) return 1;
+    task_free(legacy);
+
+    char *result = all_tests();
+    if (result != 0) {
+        printf("TEST FAILED: %s\n", result);
+    } else {
+        printf("ALL TESTS PASSED\n");
+    }
+    printf("Tests run: %d\n", tests_run);
+
+    test_home_teardown();
+    return result != 0;
+}
@@ -0,0 +1,229 @@
+#include "minunit.h"
+#include "test_utils.h"
+#include "../src/http_api.h"
+#include "../src/daemon_client.h"
+#include "../src/journal.h"
+#include "../src/task_manager.h"
+#include "../src/utils.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#define TEST_PORT 18765
+
+// Test counter
+int tests_run = 0;
+
+static HttpApi *api;
+static CliTasks set;
+static char response[65536];
+
+// Forward declarations for test functions
+static char *test_add_and_get(void);
+static char *test_conditional_list(void);
+static char *test_batch_is_atomic(void);
+static char *test_batch_sees_earlier_ops(void);
+static char *test_add_done_recurring(void);
+static char *test_json_rpc(void);
+static char *test_changes(void);
+
+// Helper function to run all tests
+static char *all_tests(void) {
+    mu_run_test(test_add_and_get);
+    mu_run_test(test_conditional_list);
+    mu_run_test(test_batch_is_atomic);
+    mu_run_test(test_batch_sees_earlier_ops);
+    mu_run_test(test_add_done_recurring);
+    mu_run_test(test_json_rpc);
+    mu_run_test(test_changes);
+    return 0;
+}
+
+// Helper: send a request, let the API answer it, and read the response.
+// The request fits in the socket buffer, so one process can play both sides.
+static const char *request(const char *method, const char *path, const char *headers, const char *body) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(TEST_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) return "";
+
+    char head[512];
+    snprintf(head, sizeof(head), "%s %s HTTP/1.1\r\nHost: 127.0.0.1\r\n%sContent-Length: %zu\r\n\r\n",
+             method, path, headers ? headers : "", body ? strlen(body) : 0);
+    write(fd, head, strlen(head));
+    if (body) write(fd, body, strlen(body));
+    http_api_accept(api);
+
+    size_t len = 0;
+    ssize_t n;
+    while ((n = read(fd, response + len, sizeof(response) - len - 1)) > 0) len += (size_t)n;
+    response[len] = '\0';
+    close(fd);
+    return response;
+}
+
+// Helper: the status code of the last response
+static int status_of(const char *resp) {
+    return strncmp(resp, "HTTP/1.1 ", 9) == 0 ? atoi(resp + 9) : 0;
+}
+
+// Helper: the change hook journals changes like the daemon's does
+static void on_change(TaskChangeKind kind, const Task *task, void *user) {
+    (void)user;
+    journal_append(kind == TASK_CHANGE_ADD ? JOURNAL_ADD : kind == TASK_CHANGE_DELETE ? JOURNAL_DELETE : JOURNAL_PUT,
+                   task);
+}
+
+static char *test_add_and_get(void) {
+    const char *resp = request("POST", "/tasks", NULL,
+                               "{\"name\":\"Write report\",\"due\":\"2026-11-02\",\"tags\":[\"work\"],\"priority\":\"high\"}");
+    mu_assert("add is 201", status_of(resp) == 201);
+    mu_assert("one task", set.count == 1 && strcmp(set.tasks[0]->name, "Write report") == 0);
+    mu_assert("fields applied", set.tasks[0]->priority == PRIORITY_HIGH && set.tasks[0]->due_kind == DUE_DATE);
+
+    char path[128];
+    snprintf(path, sizeof(path), "/tasks/%s", set.tasks[0]->id);
+    resp = request("GET", path, NULL, NULL);
+    mu_assert("get", status_of(resp) == 200 && strstr(resp, "\"Write report\""));
+    mu_assert("unknown id", status_of(request("GET", "/tasks/nope", NULL, NULL)) == 404);
+    mu_assert("bad field", status_of(request("POST", "/tasks", NULL, "{\"name\":\"x\",\"priority\":\"urgent\"}")) == 400);
+    mu_assert("nothing added on error", set.count == 1);
+    return 0;
+}
+
+static char *test_conditional_list(void) {
+    const char *resp = request("GET", "/tasks?priority=high", NULL, NULL);
+    mu_assert("list", status_of(resp) == 200 && strstr(resp, "\"Write report\""));
+    const char *etag = strstr(resp, "ETag: ");
+    mu_assert("etag", etag != NULL);
+    char header[96];
+    snprintf(header, sizeof(header), "If-None-Match: %.*s\r\n", (int)strcspn(etag + 6, "\r"), etag + 6);
+    mu_assert("not modified", status_of(request("GET", "/tasks", header, NULL)) == 304);
+
+    char if_match[96];
+    snprintf(if_match, sizeof(if_match), "If-Match: %s", header + 15);
+    char path[128];
+    snprintf(path, sizeof(path), "/tasks/%s", set.tasks[0]->id);
+    mu_assert("update with current generation", status_of(request("PATCH", path, if_match, "{\"status\":\"done\"}")) == 200);
+    mu_assert("status changed", set.tasks[0]->status == STATUS_DONE);
+    mu_assert("stale generation", status_of(request("PATCH", path, if_match, "{\"name\":\"x\"}")) == 412);
+    mu_assert("modified", status_of(request("GET", "/tasks", header, NULL)) == 200);
+    return 0;
+}
+
+static char *test_batch_is_atomic(void) {
+    const char *resp = request("POST", "/tasks/batch", NULL,
+                               "[{\"op\":\"add\",\"fields\":{\"name\":\"A\"}},{\"op\":\"delete\",\"id\":\"nope\"}]");
+    mu_assert("batch rejected", status_of(resp) == 404 && set.count == 1);
+
+    char body[256];
+    snprintf(body, sizeof(body), "[{\"op\":\"add\",\"fields\":{\"name\":\"A\"}},{\"op\":\"delete\",\"id\":\"%s\"}]",
+             set.tasks[0]->id);
+    resp = request("POST", "/tasks/batch", NULL, body);
+    mu_assert("batch applied", status_of(resp) == 200 && set.count == 1 && strcmp(set.tasks[0]->name, "A") == 0);
+    return 0;
+}
+
+static char *test_batch_sees_earlier_ops(void) {
+    mu_assert("add dated", status_of(request("POST", "/tasks", NULL, "{\"name\":\"Dated\",\"due\":\"2026-11-05\"}")) == 201);
+    Task *t = set.tasks[set.count - 1];
+    time_t due = t->due;
+
+    // The repeat is valid on its own and only fails once the due is cleared
+    char body[256];
+    snprintf(body, sizeof(body),
+             "[{\"op\":\"update\",\"id\":\"%s\",\"fields\":{\"due\":null}},"
+             "{\"op\":\"update\",\"id\":\"%s\",\"fields\":{\"repeat\":\"daily\"}}]",
+             t->id, t->id);
+    mu_assert("batch rejected", status_of(request("POST", "/tasks/batch", NULL, body)) == 400);
+    mu_assert("task unchanged", t->due == due && t->recur == NULL);
+
+    snprintf(body, sizeof(body), "[{\"op\":\"delete\",\"id\":\"%s\"}]", t->id);
+    mu_assert("cleanup", status_of(request("POST", "/tasks/batch", NULL, body)) == 200);
+    return 0;
+}
+
+static char *test_add_done_recurring(void) {
+    const char *resp = request("POST", "/tasks", NULL,
+                               "{\"name\":\"Standup\",\"due\":\"2026-11-05\",\"repeat\":\"daily\",\"status\":\"done\"}");
+    mu_assert("add is 201", status_of(resp) == 201);
+    Task *t = set.tasks[set.count - 1];
+    mu_assert("advanced to the next occurrence",
+              t->status == STATUS_PENDING && t->due > utils_parse_date("2026-11-05") && t->recur != NULL);
+
+    char body[256];
+    snprintf(body, sizeof(body), "[{\"op\":\"delete\",\"id\":\"%s\"}]", t->id);
+    mu_assert("cleanup", status_of(request("POST", "/tasks/batch", NULL, body)) == 200);
+    return 0;
+}
+
+static char *test_json_rpc(void) {
+    const char *resp = request("POST", "/rpc", NULL,
+        "[{\"jsonrpc\":\"2.0\",\"method\":\"tasks.add\",\"params\":{\"name\":\"B\",\"due\":\"2026-11-03\",\"repeat\":\"weekly\"},\"id\":1},"
+        "{\"jsonrpc\":\"2.0\",\"method\":\"tasks.list\",\"params\":{\"q\":\"B\"},\"id\":2},"
+        "{\"jsonrpc\":\"2.0\",\"method\":\"tasks.delete\",\"params\":{\"id\":\"nope\"},\"id\":3},"
+        "{\"jsonrpc\":\"2.0\",\"method\":\"tasks.get\",\"params\":{\"id\":\"nope\"}}]");
+    mu_assert("rpc ok", status_of(resp) == 200);
+    mu_assert("added", set.count == 2 && set.tasks[1]->recur != NULL);
+    mu_assert("listed", strstr(resp, "\"id\":2") && strstr(resp, "\"tasks\":[{"));
+    mu_assert("error reported", strstr(resp, "-32004") && strstr(resp, "\"id\":3"));
+    mu_assert("notification has no response", !strstr(resp, "\"id\":4"));
+    return 0;
+}
+
+static char *test_changes(void) {
+    const char *resp = request("GET", "/changes?since=0&timeout=0", NULL, NULL);
+    mu_assert("changes", status_of(resp) == 200 && strstr(resp, "\"gap\":false"));
+    mu_assert("first event", strstr(resp, "{\"seq\":1,") && strstr(resp, "\"type\":\"add\""));
+    mu_assert("changed fields", strstr(resp, "\"type\":\"update\"") && strstr(resp, "\"changed\":[\"status\"]"));
+    mu_assert("deletes", strstr(resp, "\"type\":\"delete\""));
+
+    char path[64];
+    snprintf(path, sizeof(path), "/changes?since=%llu&timeout=0", journal_last_seq());
+    resp = request("GET", path, NULL, NULL);
+    mu_assert("caught up", status_of(resp) == 200 && strstr(resp, "\"events\":[]"));
+    mu_assert("bad since", status_of(request("GET", "/changes?since=x", NULL, NULL)) == 400);
+
+    resp = request("POST", "/rpc", NULL,
+                   "{\"jsonrpc\":\"2.0\",\"method\":\"changes.list\",\"params\":{\"since\":1,\"limit\":1},\"id\":5}");
+    mu_assert("rpc page", status_of(resp) == 200 && strstr(resp, "\"seq\":2,") && strstr(resp, "\"events\":[{\"seq\":2,"));
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    (void)argc;  // Unused parameter
+    (void)argv;  // Unused parameter
+
+    printf("Running HTTP API tests...\n");
+
+    if (!test_home_setup()) return 1;
+
+    set.tasks = utils_calloc(1, sizeof(Task *));
+    api = http_api_create(TEST_PORT, &set, NULL, NULL);
+    if (!api) {
+        printf("Cannot bind port %d; skipping\n", TEST_PORT);
+        return 0;
+    }
+    task_manager_set_change_hook(on_change, NULL);
+
+    char *result = all_tests();
+    if (result != 0) {
+        printf("TEST FAILED: %s\n", result);
+    } else {
+        printf("ALL TESTS PASSED\n");
+    }
+    printf("Tests run: %d\n", tests_run);
+
+    http_api_free(api);
+    task_manager_cleanup(set.tasks, set.count);
+    test_home_teardown();
+    return result != 0;
+}
@@ -0,0 +1,129 @@
+#include "minunit.h"
+#include "../src/utils.h"
+#include <time.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Test counter
+int tests_run = 0;
+
+// Forward declarations for test functions
+static char *test_format_iso8601(void);
+static char *test_parse_iso8601(void);
+static char *test_parse_iso8601_rejects(void);
+static char *test_round_trip_matches_libc(void);
+static char *test_iso8601_to_time_fallback(void);
+
+// Helper function to run all tests
+static char *all_tests(void) {
+    mu_run_test(test_format_iso8601);
+    mu_run_test(test_parse_iso8601);
+    mu_run_test(test_parse_iso8601_rejects);
+    mu_run_test(test_round_trip_matches_libc);
+    mu_run_test(test_iso8601_to_time_fallback);
+    return 0;
+}
+
+static char *test_format_iso8601(void) {
+    char buf[UTILS_ISO8601_BUFSZ];
+
+    mu_assert("epoch", strcmp(utils_format_iso8601(0, buf), "1970-01-01T00:00:00Z") == 0);
+    mu_assert("2025-04-16T20:40:00Z",
+              strcmp(utils_format_iso8601(1744836000, buf), "2025-04-16T20:40:00Z") == 0);
+    mu_assert("leap day", strcmp(utils_format_iso8601(951782400, buf), "2000-02-29T00:00:00Z") == 0);
+    mu_assert("pre-epoch", strcmp(utils_format_iso8601(-1, buf), "1969-12-31T23:59:59Z") == 0);
+    mu_assert("NULL buffer", utils_format_iso8601(0, NULL) == NULL);
+
+    return 0;
+}
+
+static char *test_parse_iso8601(void) {
+    time_t t = 0;
+
+    mu_assert("epoch", utils_parse_iso8601("1970-01-01T00:00:00Z", &t) && t == 0);
+    mu_assert("2025-04-16T20:40:00Z",
+              utils_parse_iso8601("2025-04-16T20:40:00Z", &t) && t == 1744836000);
+    mu_assert("leap day", utils_parse_iso8601("2000-02-29T00:00:00Z", &t) && t == 951782400);
+    mu_assert("end of day", utils_parse_iso8601("1999-12-31T23:59:59Z", &t) && t == 946684799);
+
+    return 0;
+}
+
+static char *test_parse_iso8601_rejects(void) {
+    time_t t = 0;
+
+    mu_assert("NULL input should fail", !utils_parse_iso8601(NULL, &t));
+    mu_assert("Empty string should fail", !utils_parse_iso8601("", &t));
+    mu_assert("Date only should fail", !utils_parse_iso8601("2025-04-16", &t));
+    mu_assert("Input ending before a separator should fail", !utils_parse_iso8601("2025-1", &t));
+    mu_assert("Missing Z should fail", !utils_parse_iso8601("2025-04-16T20:40:00", &t));
+    mu_assert("Trailing garbage should fail", !utils_parse_iso8601("2025-04-16T20:40:00Zx", &t));
+    mu_assert("Month 13 should fail", !utils_parse_iso8601("2025-13-01T00:00:00Z", &t));
+    mu_assert("Feb 29 in non-leap year should fail", !utils_parse_iso8601("2025-02-29T00:00:00Z", &t));
+    mu_assert("Feb 29 in 1900 should fail", !utils_parse_iso8601("1900-02-29T00:00:00Z", &t));
+    mu_assert("Hour 24 should fail", !utils_parse_iso8601("2025-04-16T24:00:00Z", &t));
+    mu_assert("Second 60 should fail", !utils_parse_iso8601("2025-04-16T23:59:60Z", &t));
+    mu_assert("Non-digit should fail", !utils_parse_iso8601("2025-04-1xT00:00:00Z", &t));
+
+    // Every prefix of a valid timestamp, each in a buffer of its own length,
+    // so a read past the end is caught by a sanitizer build
+    const char *full = "2025-04-16T20:40:00Z";
+    for (size_t len = 0; len < strlen(full); len++) {
+        char *prefix = malloc(len + 1);
+        mu_assert("alloc", prefix != NULL);
+        memcpy(prefix, full, len);
+        prefix[len] = '\0';
+        bool ok = utils_parse_iso8601(prefix, &t);
+        free(prefix);
+        mu_assert("Truncated input should fail", !ok);
+    }
+
+    return 0;
+}
+
+static char *test_round_trip_matches_libc(void) {
+    char buf[UTILS_ISO8601_BUFSZ];
+    char expected[32];
+
+    // Walk ~200 years in irregular steps and compare against gmtime_r/strftime
+    for (time_t t = -2208988800LL; t < 4102444800LL; t += 7777777) {
+        struct tm tm;
+        gmtime_r(&t, &tm);
+        strftime(expected, sizeof(expected), "%Y-%m-%dT%H:%M:%SZ", &tm);
+        mu_assert("format differs from strftime", strcmp(utils_format_iso8601(t, buf), expected) == 0);
+
+        time_t back = 0;
+        mu_assert("parse of formatted value failed", utils_parse_iso8601(buf, &back));
+        mu_assert("round trip mismatch", back == t);
+    }
+
+    return 0;
+}
+
+static char *test_iso8601_to_time_fallback(void) {
+    // Exact form takes the fast path
+    mu_assert("fast path", utils_iso8601_to_time("2025-04-16T20:40:00Z") == 1744836000);
+    // Single-digit fields are not the fixed form but strptime still accepts them
+    mu_assert("strptime fallback", utils_iso8601_to_time("2025-4-16T20:40:00Z") == 1744836000);
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    (void)argc;  // Unused parameter
+    (void)argv;  // Unused parameter
+
+    printf("Running iso8601 tests...\n");
+
+    char *result = all_tests();
+    if (result != 0) {
+        printf("TEST FAILED: %s\n", result);
+    } else {
+        printf("ALL TESTS PASSED\n");
+    }
+    printf("Tests run: %d\n", tests_run);
+
+    return result != 0;
+}
@@ -0,0 +1,191 @@
+#include "minunit.h"
+#include "test_utils.h"
+#include "../src/llm_usage.h"
+#include "../src/storage.h"
+#include "../src/app_clock.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+// Noon UTC of day 20717; the tests run in UTC
+#define DAY 86400
+#define BASE (20717LL * DAY + 12 * 3600)
+
+// Test counter
+int tests_run = 0;
+
+
+// Forward declarations for test functions
+static char *test_buckets(void);
+static char *test_percentiles(void);
+static char *test_record_and_report(void);
+static char *test_errors_not_measured(void);
+static char *test_days_window(void);
+static char *test_old_days_dropped(void);
+
+// Helper function to run all tests
+static char *all_tests(void) {
+    mu_run_test(test_buckets);
+    mu_run_test(test_percentiles);
+    mu_run_test(test_record_and_report);
+    mu_run_test(test_errors_not_measured);
+    mu_run_test(test_days_window);
+    mu_run_test(test_old_days_dropped);
+    return 0;
+}
+
+// Helper: record a call at a given time
+static int record(time_t now, const char *model, bool ok, uint64_t total_us, uint64_t prompt, uint64_t completion) {
+    app_clock_set_fixed(now);
+    LlmCall call = {.model = model, .endpoint = "chat/completions", .ok = ok};
+    call.values[LLM_METRIC_CONNECT] = total_us / 10;
+    call.values[LLM_METRIC_TTFB] = total_us / 2;
+    call.values[LLM_METRIC_TOTAL] = total_us;
+    call.values[LLM_METRIC_PROMPT_TOKENS] = prompt;
+    call.values[LLM_METRIC_COMPLETION_TOKENS] = completion;
+    return llm_usage_record(&call);
+}
+
+// Helper: start over without recorded calls
+static void reset(void) {
+    char *path = storage_path(LLM_USAGE_FILE);
+    if (path) unlink(path);
+    free(path);
+}
+
+static char *test_buckets(void) {
+    for (uint64_t v = 0; v < LLM_HIST_SUB_COUNT; v++) {
+        mu_assert("exact below the first power", llm_hist_bucket(v) == v && llm_hist_bucket_high(v) == v);
+    }
+
+    // Every value lies in its bucket, within the bucket's relative width
+    size_t last = 0;
+    for (uint64_t v = 1; v < (1ULL << 36); v = v * 3 / 2 + 1) {
+        size_t b = llm_hist_bucket(v);
+        uint64_t high = llm_hist_bucket_high(b);
+        uint64_t low = b > 0 ? llm_hist_bucket_high(b - 1) + 1 : 0;
+        mu_assert("monotonic", b >= last);
+        mu_assert("in bucket", low <= v && v <= high);
+        mu_assert("bounded error", (double)(high - low) <= (double)v / LLM_HIST_SUB_COUNT + 1);
+        last = b;
+    }
+    mu_assert("huge values share the last bucket", llm_hist_bucket(UINT64_MAX) == LLM_HIST_BUCKETS - 1);
+    return 0;
+}
+
+static char *test_percentiles(void) {
+    static LlmHist h;
+    mu_assert("empty", llm_hist_percentile(&h, 50) == 0);
+    for (uint64_t v = 1; v <= 1000; v++) llm_hist_record(&h, v * 1000);
+    mu_assert("count and sum", h.count == 1000 && h.sum == 500500000 && h.max == 1000000);
+
+    uint64_t p50 = llm_hist_percentile(&h, 50);
+    uint64_t p99 = llm_hist_percentile(&h, 99);
+    mu_assert("p50 within 3%", p50 >= 500000 && p50 <= 515000);
+    mu_assert("p99 within 3%", p99 >= 990000 && p99 <= 1000000);
+    mu_assert("p100 is the max", llm_hist_percentile(&h, 100) == 1000000);
+
+    static LlmHist other;
+    llm_hist_record(&other, 5000000);
+    llm_hist_merge(&h, &other);
+    mu_assert("merged", h.count == 1001 && h.max == 5000000 && llm_hist_percentile(&h, 100) == 5000000);
+    return 0;
+}
+
+static char *test_record_and_report(void) {
+    reset();
+    for (int i = 1; i <= 100; i++) {
+        mu_assert("record", record(BASE, "gpt-4o", true, (uint64_t)i * 10000, 200, 50) == 0);
+    }
+    mu_assert("record other", record(BASE, "gpt-3.5-turbo", true, 300000, 100, 20) == 0);
+
+    LlmUsageReport *r = llm_usage_report(7);
+    mu_assert("report", r != NULL && r->series_count == 2);
+    mu_assert("sorted", strcmp(r->series[0].model, "gpt-3.5-turbo") == 0);
+    const LlmUsageSeries *s = &r->series[1];
+    mu_assert("endpoint", strcmp(s->endpoint, "chat/completions") == 0);
+    mu_assert("calls", s->calls == 100 && s->errors == 0);
+    mu_assert("all measured", s->hists[LLM_METRIC_TOTAL].count == 100);
+    mu_assert("tokens", s->hists[LLM_METRIC_PROMPT_TOKENS].sum == 20000
+                        && s->hists[LLM_METRIC_COMPLETION_TOKENS].sum == 5000);
+    uint64_t p90 = llm_hist_percentile(&s->hists[LLM_METRIC_TOTAL], 90);
+    mu_assert("p90 survives the file", p90 >= 900000 && p90 <= 930000);
+    mu_assert("max", s->hists[LLM_METRIC_TOTAL].max == 1000000);
+    mu_assert("today's median", s->daily_p50[6] >= 500000 && s->daily_p50[6] <= 515000);
+    mu_assert("no earlier days", s->daily_p50[0] == 0);
+    llm_usage_report_free(r);
+    return 0;
+}
+
+static char *test_errors_not_measured(void) {
+    reset();
+    mu_assert("ok", record(BASE, "gpt-4o", true, 200000, 10, 10) == 0);
+    mu_assert("failed", record(BASE, "gpt-4o", false, 0, 0, 0) == 0);
+    mu_assert("failed", record(BASE, "gpt-4o", false, 0, 0, 0) == 0);
+
+    LlmUsageReport *r = llm_usage_report(1);
+    mu_assert("report", r != NULL && r->series_count == 1);
+    mu_assert("failed counted", r->series[0].calls == 3 && r->series[0].errors == 2);
+    mu_assert("failed not measured", r->series[0].hists[LLM_METRIC_TOTAL].count == 1);
+    mu_assert("no zero latency", llm_hist_percentile(&r->series[0].hists[LLM_METRIC_TOTAL], 0) > 0);
+    llm_usage_report_free(r);
+    return 0;
+}
+
+static char *test_days_window(void) {
+    reset();
+    mu_assert("long ago", record(BASE - 10 * DAY, "gpt-4o", true, 900000, 1, 1) == 0);
+    mu_assert("yesterday", record(BASE - DAY, "gpt-4o", true, 100000, 1, 1) == 0);
+    mu_assert("today", record(BASE, "gpt-4o", true, 300000, 1, 1) == 0);
+
+    LlmUsageReport *r = llm_usage_report(7);
+    mu_assert("report", r != NULL && r->series_count == 1);
+    mu_assert("window", r->series[0].calls == 2 && r->series[0].hists[LLM_METRIC_TOTAL].max == 300000);
+    mu_assert("per day", r->series[0].daily_p50[5] > 0 && r->series[0].daily_p50[5] < r->series[0].daily_p50[6]);
+    llm_usage_report_free(r);
+
+    r = llm_usage_report(30);
+    mu_assert("wider window", r != NULL && r->series[0].calls == 3);
+    llm_usage_report_free(r);
+
+    mu_assert("no days", llm_usage_report(0) == NULL);
+    return 0;
+}
+
+static char *test_old_days_dropped(void) {
+    reset();
+    mu_assert("old", record(BASE, "gpt-4o", true, 100000, 1, 1) == 0);
+    mu_assert("much later", record(BASE + LLM_USAGE_KEEP_DAYS * DAY, "gpt-4o", true, 100000, 1, 1) == 0);
+
+    // A report reaching back past the kept days finds only the new call
+    app_clock_set_fixed(BASE + LLM_USAGE_KEEP_DAYS * DAY);
+    LlmUsageReport *r = llm_usage_report(LLM_USAGE_KEEP_DAYS + 1);
+    mu_assert("report", r != NULL && r->series_count == 1 && r->series[0].calls == 1);
+    llm_usage_report_free(r);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    (void)argc;  // Unused parameter
+    (void)argv;  // Unused parameter
+
+    printf("Running LLM usage tests...\n");
+
+    if (!test_home_setup()) return 1;
+    setenv("TZ", "UTC", 1);
+    tzset();
+
+    char *result = all_tests();
+    if (result != 0) {
+        printf("TEST FAILED: %s\n", result);
+    } else {
+        printf("ALL TESTS PASSED\n");
+    }
+    printf("Tests run: %d\n", tests_run);
+
+    test_home_teardown();
+    return result != 0;
+}
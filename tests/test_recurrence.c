@@ -0,0 +1,208 @@
+#include "minunit.h"
+#include "../src/recurrence.h"
+#include "../src/task.h"
+#include "../src/tz_cache.h"
+#include "../src/utils.h"
+#include <time.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+// Test counter
+int tests_run = 0;
+
+// Forward declarations for test functions
+static char *test_parse_and_format(void);
+static char *test_parse_rejects(void);
+static char *test_next_weekly(void);
+static char *test_next_monthly(void);
+static char *test_count_and_until(void);
+static char *test_task_advance(void);
+static char *test_task_occurs_between(void);
+
+// Helper function to run all tests
+static char *all_tests(void) {
+    mu_run_test(test_parse_and_format);
+    mu_run_test(test_parse_rejects);
+    mu_run_test(test_next_weekly);
+    mu_run_test(test_next_monthly);
+    mu_run_test(test_count_and_until);
+    mu_run_test(test_task_advance);
+    mu_run_test(test_task_occurs_between);
+    return 0;
+}
+
+// Helper: day number for a civil date
+static long long day_of(int y, int m, int d) {
+    return utils_days_from_civil(y, m, d);
+}
+
+// Helper: parse and re-format a rule, comparing with the expected canonical form
+static bool formats_as(const char *input, const char *expected) {
+    Recurrence r;
+    char buf[RECURRENCE_MAX_LEN];
+    if (recurrence_parse(input, &r) != 0) return false;
+    if (!recurrence_format(&r, buf, sizeof(buf))) return false;
+    return strcmp(buf, expected) == 0;
+}
+
+static char *test_parse_and_format(void) {
+    mu_assert("daily", formats_as("daily", "FREQ=DAILY"));
+    mu_assert("weekdays", formats_as("weekdays", "FREQ=WEEKLY;BYDAY=MO,TU,WE,TH,FR"));
+    mu_assert("every 2 weeks", formats_as("every 2 weeks", "FREQ=WEEKLY;INTERVAL=2"));
+    mu_assert("RRULE prefix", formats_as("RRULE:FREQ=WEEKLY;BYDAY=FR,MO", "FREQ=WEEKLY;BYDAY=MO,FR"));
+    mu_assert("monthly last day", formats_as("FREQ=MONTHLY;BYMONTHDAY=-1", "FREQ=MONTHLY;BYMONTHDAY=-1"));
+    mu_assert("count and until",
+              formats_as("freq=daily;count=3;until=20261231T235959Z", "FREQ=DAILY;COUNT=3;UNTIL=20261231"));
+    return 0;
+}
+
+static char *test_parse_rejects(void) {
+    Recurrence r;
+    mu_assert("empty", recurrence_parse("", &r) != 0);
+    mu_assert("NULL", recurrence_parse(NULL, &r) != 0);
+    mu_assert("no FREQ", recurrence_parse("INTERVAL=2", &r) != 0);
+    mu_assert("unknown part", recurrence_parse("FREQ=DAILY;BYHOUR=9", &r) != 0);
+    mu_assert("BYDAY with MONTHLY", recurrence_parse("FREQ=MONTHLY;BYDAY=MO", &r) != 0);
+    mu_assert("bad weekday", recurrence_parse("FREQ=WEEKLY;BYDAY=XX", &r) != 0);
+    mu_assert("zero interval", recurrence_parse("FREQ=DAILY;INTERVAL=0", &r) != 0);
+    mu_assert("gibberish", recurrence_parse("sometimes", &r) != 0);
+    return 0;
+}
+
+static char *test_next_weekly(void) {
+    Recurrence r;
+    long long next;
+    long long anchor = day_of(2026, 10, 14); // Wednesday
+
+    recurrence_parse("weekly", &r);
+    mu_assert("weekly next", recurrence_next(&r, anchor, anchor, &next) && next == day_of(2026, 10, 21));
+
+    recurrence_parse("FREQ=WEEKLY;BYDAY=MO,FR", &r);
+    mu_assert("BYDAY same week", recurrence_next(&r, anchor, anchor, &next) && next == day_of(2026, 10, 16));
+    mu_assert("BYDAY next week", recurrence_next(&r, anchor, next, &next) && next == day_of(2026, 10, 19));
+
+    recurrence_parse("FREQ=WEEKLY;INTERVAL=2;BYDAY=MO", &r);
+    mu_assert("biweekly skips a week",
+              recurrence_next(&r, anchor, anchor, &next) && next == day_of(2026, 10, 26));
+
+    recurrence_parse("weekdays", &r);
+    mu_assert("weekdays skip the weekend",
+              recurrence_next(&r, anchor, day_of(2026, 10, 16), &next) && next == day_of(2026, 10, 19));
+    return 0;
+}
+
+static char *test_next_monthly(void) {
+    Recurrence r;
+    long long next;
+
+    recurrence_parse("monthly", &r);
+    long long jan31 = day_of(2026, 1, 31);
+    mu_assert("31st skips short months", recurrence_next(&r, jan31, jan31, &next) && next == day_of(2026, 3, 31));
+
+    recurrence_parse("FREQ=MONTHLY;BYMONTHDAY=-1", &r);
+    mu_assert("last day of February",
+              recurrence_next(&r, jan31, jan31, &next) && next == day_of(2026, 2, 28));
+
+    recurrence_parse("yearly", &r);
+    long long leap = day_of(2024, 2, 29);
+    mu_assert("Feb 29 yearly", recurrence_next(&r, leap, leap, &next) && next == day_of(2028, 2, 29));
+
+    recurrence_parse("every 3 days", &r);
+    long long anchor = day_of(2026, 10, 1);
+    mu_assert("far window jumps directly",
+              recurrence_next(&r, anchor, day_of(2027, 10, 1), &next) && next == day_of(2027, 10, 2));
+    return 0;
+}
+
+static char *test_count_and_until(void) {
+    Recurrence r;
+    long long next;
+    long long anchor = day_of(2026, 10, 14);
+
+    recurrence_parse("FREQ=DAILY;COUNT=3", &r);
+    mu_assert("second", recurrence_next(&r, anchor, anchor, &next) && next == anchor + 1);
+    mu_assert("third", recurrence_next(&r, anchor, anchor + 1, &next) && next == anchor + 2);
+    mu_assert("series ends", !recurrence_next(&r, anchor, anchor + 2, &next));
+
+    recurrence_parse("FREQ=WEEKLY;UNTIL=20261025", &r);
+    mu_assert("before until", recurrence_next(&r, anchor, anchor, &next) && next == day_of(2026, 10, 21));
+    mu_assert("past until", !recurrence_next(&r, anchor, next, &next));
+    return 0;
+}
+
+static char *test_task_advance(void) {
+    Task *t = task_create("weekly report", 0, DUE_NONE, NULL, 0, PRIORITY_LOW);
+    mu_assert("task_create", t != NULL);
+    task_set_due(t, (time_t)(day_of(2026, 10, 16) * 86400), DUE_DATE);
+    mu_assert("set recurrence", task_set_recurrence(t, "FREQ=WEEKLY;COUNT=2") == 0);
+
+    mu_assert("advance", task_advance_recurrence(t) == 0);
+    mu_assert("next week", t->due == (time_t)(day_of(2026, 10, 23) * 86400));
+    mu_assert("count decremented", strcmp(t->recur, "FREQ=WEEKLY;COUNT=1") == 0);
+    mu_assert("series ended", task_advance_recurrence(t) == 1);
+
+    mu_assert("invalid rule rejected", task_set_recurrence(t, "FREQ=HOURLY") != 0);
+    mu_assert("rule kept", t->recur != NULL);
+    mu_assert("clear rule", task_set_recurrence(t, NULL) == 0 && t->recur == NULL);
+    mu_assert("not recurring", task_advance_recurrence(t) == -1);
+
+    task_free(t);
+    return 0;
+}
+
+static char *test_task_occurs_between(void) {
+    setenv("TZ", "Europe/Berlin", 1);
+    tzset();
+    tz_cache_reset();
+
+    // Every Monday at 10:00 local, starting Monday 2026-10-12
+    struct tm tm = {0};
+    tm.tm_year = 126;
+    tm.tm_mon = 9;
+    tm.tm_mday = 12;
+    tm.tm_hour = 10;
+    tm.tm_isdst = -1;
+    Task *t = task_create("standup", mktime(&tm), DUE_DATETIME, NULL, 0, PRIORITY_LOW);
+    mu_assert("task_create", t != NULL);
+    mu_assert("set recurrence", task_set_recurrence(t, "weekly") == 0);
+
+    // Window covering Monday 2026-11-02 (after the DST change on Oct 25)
+    tm.tm_mday = 2;
+    tm.tm_mon = 10;
+    tm.tm_hour = 0;
+    tm.tm_isdst = -1;
+    time_t start = mktime(&tm);
+    mu_assert("virtual occurrence in window", task_occurs_between(t, start, start + 86400));
+    mu_assert("no occurrence on Tuesday", !task_occurs_between(t, start + 86400, start + 2 * 86400));
+    mu_assert("first occurrence", task_occurs_between(t, t->due, t->due + 1));
+    mu_assert("nothing before the first", !task_occurs_between(t, 0, t->due));
+
+    mu_assert("advance", task_advance_recurrence(t) == 0);
+    localtime_r(&t->due, &tm);
+    mu_assert("keeps local time of day", tm.tm_mday == 19 && tm.tm_hour == 10);
+
+    task_free(t);
+    setenv("TZ", "UTC", 1);
+    tzset();
+    tz_cache_reset();
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    (void)argc;  // Unused parameter
+    (void)argv;  // Unused parameter
+
+    printf("Running recurrence tests...\n");
+
+    char *result = all_tests();
+    if (result != 0) {
+        printf("TEST FAILED: %s\n", result);
+    } else {
+        printf("ALL TESTS PASSED\n");
+    }
+    printf("Tests run: %d\n", tests_run);
+
+    return result != 0;
+}
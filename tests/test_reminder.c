@@ -0,0 +1,190 @@
+#include "minunit.h"
+#include "../src/reminder.h"
+#include "../src/task.h"
+#include "../src/tz_cache.h"
+#include "../src/utils.h"
+#include <time.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+// Test counter
+int tests_run = 0;
+
+// Forward declarations for test functions
+static char *test_pop_order(void);
+static char *test_reschedule_and_cancel(void);
+static char *test_many_reminders(void);
+static char *test_wait_due(void);
+static char *test_task_remind_at(void);
+
+// Helper function to run all tests
+static char *all_tests(void) {
+    mu_run_test(test_pop_order);
+    mu_run_test(test_reschedule_and_cancel);
+    mu_run_test(test_many_reminders);
+    mu_run_test(test_wait_due);
+    mu_run_test(test_task_remind_at);
+    return 0;
+}
+
+// Fired reminders recorded by record_fire
+typedef struct {
+    char keys[8][16];
+    time_t times[8];
+    size_t count;
+    time_t last;
+    bool ordered;
+} FireLog;
+
+// Helper: record a fired reminder
+static void record_fire(const char *key, time_t fire_at, void *data, void *user) {
+    (void)data;
+    FireLog *log = user;
+    if (fire_at < log->last) log->ordered = false;
+    log->last = fire_at;
+    if (log->count < 8) {
+        snprintf(log->keys[log->count], sizeof(log->keys[0]), "%s", key);
+        log->times[log->count] = fire_at;
+    }
+    log->count++;
+}
+
+static char *test_pop_order(void) {
+    ReminderQueue *q = reminder_queue_create();
+    mu_assert("create", q != NULL);
+    reminder_queue_schedule(q, "c", 300, NULL);
+    reminder_queue_schedule(q, "a", 100, NULL);
+    reminder_queue_schedule(q, "b", 200, NULL);
+    mu_assert("size", reminder_queue_size(q) == 3);
+
+    time_t next = 0;
+    mu_assert("peek", reminder_queue_peek(q, &next) && next == 100);
+
+    FireLog log = {.ordered = true};
+    mu_assert("nothing due yet", reminder_queue_pop_due(q, 99, record_fire, &log) == 0);
+    mu_assert("two due", reminder_queue_pop_due(q, 200, record_fire, &log) == 2);
+    mu_assert("earliest first", strcmp(log.keys[0], "a") == 0 && strcmp(log.keys[1], "b") == 0);
+    mu_assert("one left", reminder_queue_size(q) == 1);
+    mu_assert("fired keys are gone", reminder_queue_cancel(q, "a") == -1);
+
+    reminder_queue_free(q);
+    return 0;
+}
+
+static char *test_reschedule_and_cancel(void) {
+    ReminderQueue *q = reminder_queue_create();
+    reminder_queue_schedule(q, "a", 100, NULL);
+    reminder_queue_schedule(q, "b", 200, NULL);
+    reminder_queue_schedule(q, "c", 300, NULL);
+
+    // Same key moves the reminder instead of adding one
+    mu_assert("reschedule", reminder_queue_schedule(q, "c", 50, NULL) == 0);
+    mu_assert("size unchanged", reminder_queue_size(q) == 3);
+    time_t next = 0;
+    mu_assert("moved to front", reminder_queue_peek(q, &next) && next == 50);
+
+    mu_assert("cancel", reminder_queue_cancel(q, "c") == 0);
+    mu_assert("cancel missing", reminder_queue_cancel(q, "c") == -1);
+    mu_assert("front after cancel", reminder_queue_peek(q, &next) && next == 100);
+
+    reminder_queue_schedule(q, "a", 400, NULL);
+    FireLog log = {.ordered = true};
+    reminder_queue_pop_due(q, 1000, record_fire, &log);
+    mu_assert("pushed back", log.count == 2 && strcmp(log.keys[0], "b") == 0 && log.times[1] == 400);
+
+    reminder_queue_schedule(q, "x", 1, NULL);
+    reminder_queue_clear(q);
+    mu_assert("cleared", reminder_queue_size(q) == 0 && !reminder_queue_peek(q, NULL));
+    reminder_queue_free(q);
+    return 0;
+}
+
+static char *test_many_reminders(void) {
+    enum { N = 20000 };
+    ReminderQueue *q = reminder_queue_create();
+    char key[16];
+    unsigned int seed = 42;
+    for (int i = 0; i < N; i++) {
+        seed = seed * 1103515245u + 12345u;
+        snprintf(key, sizeof(key), "task-%d", i);
+        mu_assert("schedule", reminder_queue_schedule(q, key, (time_t)(seed % 100000u) + 1, NULL) == 0);
+    }
+    // Move every other reminder and cancel every tenth
+    for (int i = 0; i < N; i += 2) {
+        seed = seed * 1103515245u + 12345u;
+        snprintf(key, sizeof(key), "task-%d", i);
+        reminder_queue_schedule(q, key, (time_t)(seed % 100000u) + 1, NULL);
+    }
+    for (int i = 0; i < N; i += 10) {
+        snprintf(key, sizeof(key), "task-%d", i);
+        mu_assert("cancel", reminder_queue_cancel(q, key) == 0);
+    }
+    mu_assert("size", reminder_queue_size(q) == N - N / 10);
+
+    FireLog log = {.ordered = true};
+    reminder_queue_pop_due(q, 100001, record_fire, &log);
+    mu_assert("all fired", log.count == N - N / 10);
+    mu_assert("in order", log.ordered);
+    mu_assert("empty", reminder_queue_size(q) == 0);
+    reminder_queue_free(q);
+    return 0;
+}
+
+static char *test_wait_due(void) {
+    ReminderQueue *q = reminder_queue_create();
+    time_t now = time(NULL);
+
+    mu_assert("empty queue times out", reminder_queue_wait(q, -1, now, 10) == 0);
+    reminder_queue_schedule(q, "past", now - 60, NULL);
+    mu_assert("past reminder wakes", reminder_queue_wait(q, -1, now, 1000) == 1);
+    reminder_queue_schedule(q, "past", now + 3600, NULL);
+    mu_assert("future reminder does not wake", reminder_queue_wait(q, -1, now, 10) == 0);
+
+    reminder_queue_free(q);
+    return 0;
+}
+
+static char *test_task_remind_at(void) {
+    setenv("TZ", "Europe/Berlin", 1);
+    tzset();
+    tz_cache_reset();
+
+    Task *t = task_create("call", 0, DUE_NONE, NULL, 0, PRIORITY_LOW);
+    mu_assert("no due, no reminder", task_remind_at(t) == 0);
+
+    // Date-only: TASK_REMIND_HOUR local time on the day (CEST, UTC+2)
+    task_set_due(t, utils_parse_date("2026-10-16"), DUE_DATE);
+    mu_assert("date reminder", task_remind_at(t) == (time_t)(utils_days_from_civil(2026, 10, 16) * 86400LL
+                                                             + (TASK_REMIND_HOUR - 2) * 3600));
+
+    task_set_due(t, 1790000000, DUE_DATETIME);
+    mu_assert("datetime reminder", task_remind_at(t) == 1790000000);
+
+    t->status = STATUS_DONE;
+    mu_assert("done, no reminder", task_remind_at(t) == 0);
+
+    task_free(t);
+    setenv("TZ", "UTC", 1);
+    tzset();
+    tz_cache_reset();
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    (void)argc;  // Unused parameter
+    (void)argv;  // Unused parameter
+
+    printf("Running reminder tests...\n");
+
+    char *result = all_tests();
+    if (result != 0) {
+        printf("TEST FAILED: %s\n", result);
+    } else {
+        printf("ALL TESTS PASSED\n");
+    }
+    printf("Tests run: %d\n", tests_run);
+
+    return result != 0;
+}
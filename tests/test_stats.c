@@ -0,0 +1,221 @@
+#include "minunit.h"
+#include "test_utils.h"
+#include "../src/stats.h"
+#include "../src/storage.h"
+#include "../src/task_manager.h"
+#include "../src/daemon_client.h"
+#include "../src/app_clock.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+// Midnight UTC, day 20717; the tests run in UTC
+#define DAY 86400
+#define BASE (20717LL * DAY)
+#define HOUR 3600
+
+// Test counter
+int tests_run = 0;
+
+
+// Forward declarations for test functions
+static char *test_first_write(void);
+static char *test_per_day(void);
+static char *test_burndown_and_lead(void);
+static char *test_recurring(void);
+static char *test_rebuild_matches(void);
+
+// Helper function to run all tests
+static char *all_tests(void) {
+    mu_run_test(test_first_write);
+    mu_run_test(test_per_day);
+    mu_run_test(test_burndown_and_lead);
+    mu_run_test(test_recurring);
+    mu_run_test(test_rebuild_matches);
+    return 0;
+}
+
+// Helper: the task named name, or NULL
+static Task *find(Task **tasks, size_t count, const char *name) {
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(tasks[i]->name, name) == 0) return tasks[i];
+    }
+    return NULL;
+}
+
+// Helper: add a task to the work project at a given time and save
+static int add_task(time_t now, const char *name, time_t due, const char *repeat) {
+    app_clock_set_fixed(now);
+    size_t count = 0;
+    Task **tasks = storage_load_tasks(&count);
+    if (!tasks || task_manager_add_task(&tasks, &count, name, due, DUE_DATETIME, NULL, 0,
+                                        PRIORITY_LOW, "work") != 0) {
+        return -1;
+    }
+    tasks[count - 1]->created = now;
+    if (repeat && task_set_recurrence(tasks[count - 1], repeat) != 0) return -1;
+    int rc = storage_save_tasks(tasks, count);
+    storage_free_tasks(tasks, count);
+    return rc;
+}
+
+// Helper: change one task at a given time and save
+static int edit(time_t now, const char *name, void (*change)(Task *)) {
+    app_clock_set_fixed(now);
+    size_t count = 0;
+    Task **tasks = storage_load_tasks(&count);
+    Task *t = tasks ? find(tasks, count, name) : NULL;
+    if (!t) return -1;
+    change(t);
+    int rc = storage_save_tasks(tasks, count);
+    storage_free_tasks(tasks, count);
+    return rc;
+}
+
+static void set_done(Task *t) { t->status = STATUS_DONE; }
+static void complete(Task *t) { task_manager_complete_task(t); }
+
+// Helper: report as of a moment
+static StatsReport *report_at(time_t now, int days) {
+    app_clock_set_fixed(now);
+    return stats_report(days);
+}
+
+// Helper: the report's entry for a day number, or NULL
+static const StatsDay *day_of(const StatsReport *r, long day) {
+    for (size_t i = 0; i < r->day_count; i++) {
+        if (r->days[i].day == day) return &r->days[i];
+    }
+    return NULL;
+}
+
+// Helper: the report's entry for a project, or NULL
+static const StatsProject *project_of(const StatsReport *r, const char *name) {
+    for (size_t i = 0; i < r->project_count; i++) {
+        if (strcmp(r->projects[i].name, name) == 0) return &r->projects[i];
+    }
+    return NULL;
+}
+
+static bool close_to(double a, double b) {
+    return a - b < 1e-6 && b - a < 1e-6;
+}
+
+static char *test_first_write(void) {
+    // Counted from the first write, before stats are ever shown
+    mu_assert("add", add_task(BASE + HOUR, "Old", 0, NULL) == 0);
+    char *path = storage_path(STATS_FILE);
+    mu_assert("stats started", path && access(path, F_OK) == 0);
+    free(path);
+    mu_assert("done", edit(BASE + 2 * HOUR, "Old", set_done) == 0);
+
+    StatsReport *r = report_at(BASE + 3 * DAY, 14);
+    mu_assert("report", r && r->day_count == 14 && r->days[13].day == BASE / DAY + 3);
+    const StatsDay *d = day_of(r, BASE / DAY);
+    mu_assert("completion counted", d && d->completed == 1 && r->completed == 1);
+    mu_assert("opened and closed", d->opened == 1 && d->closed == 1);
+    mu_assert("today sampled", r->days[13].overdue == 0);
+    mu_assert("lead time", close_to(r->lead_days, 1.0 / 24) && close_to(r->lead_days_all, 1.0 / 24));
+    stats_report_free(r);
+    return 0;
+}
+
+static char *test_per_day(void) {
+    long today = BASE / DAY + 3;
+    mu_assert("add overdue", add_task(BASE + 3 * DAY + HOUR, "Late", BASE + 2 * DAY, NULL) == 0);
+    mu_assert("add", add_task(BASE + 3 * DAY + 2 * HOUR, "Quick", 0, NULL) == 0);
+    mu_assert("done next day", edit(BASE + 4 * DAY + HOUR, "Quick", set_done) == 0);
+
+    StatsReport *r = report_at(BASE + 5 * DAY + 1, 7);
+    const StatsDay *d3 = r ? day_of(r, today) : NULL;
+    const StatsDay *d4 = r ? day_of(r, today + 1) : NULL;
+    const StatsDay *d5 = r ? day_of(r, today + 2) : NULL;
+    mu_assert("days", d3 && d4 && d5);
+    mu_assert("opened", d3->opened == 2 && d3->completed == 0 && d3->closed == 0);
+    mu_assert("completed", d4->completed == 1 && d4->closed == 1 && d4->opened == 0);
+    mu_assert("overdue trend", d3->overdue == 0 && d4->overdue == 1 && d5->overdue == 1);
+    mu_assert("window total", r->completed == 2);
+    stats_report_free(r);
+    return 0;
+}
+
+static char *test_burndown_and_lead(void) {
+    StatsReport *r = report_at(BASE + 5 * DAY + 1, 4);
+    const StatsProject *work = r ? project_of(r, "work") : NULL;
+    mu_assert("project", work && work->open == 1 && work->completed == 1);
+    // Days 2..5: none open, both added on day 3, one done on day 4
+    mu_assert("burndown", work->burndown[0] == 0 && work->burndown[1] == 2
+              && work->burndown[2] == 1 && work->burndown[3] == 1);
+    // One hour and 23 hours
+    mu_assert("lead time", close_to(r->lead_days_all, 0.5));
+    mu_assert("window lead time", close_to(r->lead_days, 23.0 / 24));
+    stats_report_free(r);
+
+    char line[8];
+    unsigned values[] = {0, 4, 2, 4};
+    stats_sparkline(values, 4, line, sizeof(line));
+    mu_assert("sparkline", strcmp(line, " #=#") == 0);
+    return 0;
+}
+
+static char *test_recurring(void) {
+    long today = BASE / DAY + 5;
+    mu_assert("add recurring", add_task(BASE + 5 * DAY + HOUR, "Standup", BASE + 5 * DAY + 2 * HOUR, "daily") == 0);
+    mu_assert("complete occurrence", edit(BASE + 5 * DAY + 3 * HOUR, "Standup", complete) == 0);
+    mu_assert("complete next", edit(BASE + 5 * DAY + 4 * HOUR, "Standup", complete) == 0);
+
+    StatsReport *r = report_at(BASE + 5 * DAY + 5 * HOUR, 7);
+    const StatsDay *d = r ? day_of(r, today) : NULL;
+    mu_assert("occurrences", d && d->completed == 2 && d->opened == 1 && d->closed == 0);
+    mu_assert("still open", project_of(r, "work")->open == 2);
+    mu_assert("no lead time for occurrences", close_to(r->lead_days_all, 0.5));
+    stats_report_free(r);
+    return 0;
+}
+
+static char *test_rebuild_matches(void) {
+    StatsReport *before = report_at(BASE + 6 * DAY, 10);
+    mu_assert("report", before != NULL);
+
+    // Starting over backfills the same additions and completions from the history
+    char *path = storage_path(STATS_FILE);
+    mu_assert("removed", path && unlink(path) == 0);
+    free(path);
+    StatsReport *after = report_at(BASE + 6 * DAY, 10);
+    mu_assert("rebuilt", after && after->completed == before->completed);
+    for (size_t i = 0; i < before->day_count; i++) {
+        mu_assert("same completions", after->days[i].completed == before->days[i].completed);
+        mu_assert("same additions", after->days[i].opened == before->days[i].opened);
+    }
+    mu_assert("same lead time", close_to(after->lead_days_all, before->lead_days_all));
+    stats_report_free(before);
+    stats_report_free(after);
+
+    mu_assert("nothing to fold", stats_update(NULL, 0) == 0);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    (void)argc;  // Unused parameter
+    (void)argv;  // Unused parameter
+
+    printf("Running stats tests...\n");
+
+    if (!test_home_setup()) return 1;
+    setenv("TZ", "UTC", 1);
+    tzset();
+
+    char *result = all_tests();
+    if (result != 0) {
+        printf("TEST FAILED: %s\n", result);
+    } else {
+        printf("ALL TESTS PASSED\n");
+    }
+    printf("Tests run: %d\n", tests_run);
+
+    test_home_teardown();
+    return result != 0;
+}
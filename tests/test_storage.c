@@ -0,0 +1,283 @@
+#include "minunit.h"
+#include "test_utils.h"
+#include "../src/storage.h"
+#include "../src/task.h"
+#include "../src/journal.h"
+#include "../src/daemon_client.h"
+#include <cjson/cJSON.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <unistd.h>
+
+// Test counter
+int tests_run = 0;
+
+// Forward declarations for test functions
+static char *test_missing_file(void);
+static char *test_save_and_query(void);
+static char *test_staged_load(void);
+static char *test_journal_replay(void);
+static char *test_change_feed(void);
+static char *test_save_after_load(void);
+
+// Helper function to run all tests
+static char *all_tests(void) {
+    mu_run_test(test_missing_file);
+    mu_run_test(test_save_and_query);
+    mu_run_test(test_staged_load);
+    mu_run_test(test_journal_replay);
+    mu_run_test(test_change_feed);
+    mu_run_test(test_save_after_load);
+    return 0;
+}
+
+// Helper: create a task in a project, optionally done
+static Task *make_task(const char *name, const char *project, bool done) {
+    Task *t = task_create(name, 0, DUE_NONE, NULL, 0, PRIORITY_LOW);
+    if (!t) return NULL;
+    free(t->project);
+    t->project = strdup(project);
+    if (done) t->status = STATUS_DONE;
+    return t;
+}
+
+static char *test_missing_file(void) {
+    size_t count = 42;
+    Task **tasks = storage_load_tasks(&count);
+    mu_assert("missing file loads as empty", tasks != NULL && count == 0 && tasks[0] == NULL);
+    storage_free_tasks(tasks, count);
+    return 0;
+}
+
+static char *test_save_and_query(void) {
+    Task *saved[4] = {
+        make_task("a", "home", false),
+        make_task("b", "work", false),
+        make_task("c", "home", true),
+        make_task("d", "home", false),
+    };
+    mu_assert("save", storage_save_tasks(saved, 4) == 0);
+
+    size_t count = 0;
+    Task **tasks = storage_load_tasks(&count);
+    mu_assert("load all", tasks && count == 4 && strcmp(tasks[3]->name, "d") == 0);
+    storage_free_tasks(tasks, count);
+
+    StorageQuery query = {"home", STATUS_PENDING};
+    tasks = storage_load_tasks_query(&query, &count);
+    mu_assert("project and status", tasks && count == 2);
+    mu_assert("file order kept", strcmp(tasks[0]->name, "a") == 0 && strcmp(tasks[1]->name, "d") == 0);
+    mu_assert("NULL terminated", tasks[2] == NULL);
+    storage_free_tasks(tasks, count);
+
+    StorageQuery done = {NULL, STATUS_DONE};
+    tasks = storage_load_tasks_query(&done, &count);
+    mu_assert("status only", tasks && count == 1 && strcmp(tasks[0]->name, "c") == 0);
+    storage_free_tasks(tasks, count);
+
+    for (size_t i = 0; i < 4; i++) task_free(saved[i]);
+    return 0;
+}
+
+static char *test_staged_load(void) {
+    // The snapshot of test_save_and_query: a, b, c, d; b in work
+    StorageLoader *loader = storage_loader_open();
+    mu_assert("open", loader != NULL);
+    size_t count = 0;
+    Task **first = storage_loader_first(loader, "work", &count);
+    mu_assert("first stage", first && count == 1 && strcmp(first[0]->name, "b") == 0 && first[1] == NULL);
+    Task *b = first[0];
+    free(first);
+
+    Task **tasks = storage_loader_rest(loader, &count);
+    storage_loader_close(loader);
+    mu_assert("whole set", tasks && count == 4 && tasks[4] == NULL);
+    mu_assert("file order", strcmp(tasks[0]->name, "a") == 0 && strcmp(tasks[3]->name, "d") == 0);
+    mu_assert("first stage's task handed out", tasks[1] == b);
+    storage_free_tasks(tasks, count);
+
+    // Closed after the first stage only, the loader frees what it built
+    loader = storage_loader_open();
+    first = loader ? storage_loader_first(loader, "home", &count) : NULL;
+    mu_assert("first stage again", first && count == 3);
+    free(first);
+    storage_loader_close(loader);
+    return 0;
+}
+
+static char *test_journal_replay(void) {
+    Task *saved[2] = {make_task("a", "home", false), make_task("b", "work", false)};
+    mu_assert("save", storage_save_tasks(saved, 2) == 0);
+    mu_assert("snapshot covers the journal", !journal_has_records());
+
+    Task *added = make_task("e", "home", false);
+    saved[1]->status = STATUS_DONE;
+    mu_assert("append put", journal_append(JOURNAL_PUT, saved[1]) == 0);
+    mu_assert("append new", journal_append(JOURNAL_PUT, added) == 0);
+    mu_assert("append delete", journal_append(JOURNAL_DELETE, saved[0]) == 0);
+    mu_assert("journal has records", journal_has_records());
+
+    // A record cut short by a crash is skipped
+    char *path = storage_path(JOURNAL_FILE);
+    FILE *f = fopen(path, "a");
+    free(path);
+    mu_assert("open journal", f != NULL);
+    fputs("{\"op\":\"del\",\"id\":", f);
+    fclose(f);
+
+    size_t count = 0;
+    Task **tasks = storage_load_tasks(&count);
+    mu_assert("replayed", tasks && count == 2);
+    mu_assert("changed in place", strcmp(tasks[0]->name, "b") == 0 && tasks[0]->status == STATUS_DONE);
+    mu_assert("added at end", strcmp(tasks[1]->name, "e") == 0);
+
+    StorageQuery query = {"home", -1};
+    Task **home = storage_load_tasks_query(&query, &count);
+    mu_assert("query filters after replay", home && count == 1 && strcmp(home[0]->name, "e") == 0);
+    storage_free_tasks(home, count);
+
+    // With journal records the loader hands out the replayed set
+    StorageLoader *loader = storage_loader_open();
+    mu_assert("open replayed", loader != NULL);
+    home = storage_loader_first(loader, "home", &count);
+    mu_assert("first stage after replay", home && count == 1 && strcmp(home[0]->name, "e") == 0);
+    free(home);
+    Task **staged = storage_loader_rest(loader, &count);
+    storage_loader_close(loader);
+    mu_assert("rest after replay", staged && count == 2 && strcmp(staged[0]->name, "b") == 0);
+    storage_free_tasks(staged, count);
+
+    mu_assert("compact", storage_save_tasks(tasks, 2) == 0);
+    mu_assert("journal folded into snapshot", !journal_has_records());
+    storage_free_tasks(tasks, 2);
+
+    task_free(saved[0]);
+    task_free(saved[1]);
+    task_free(added);
+    return 0;
+}
+
+// Helper: the type of an event, or "" if it has none
+static const char *event_type(const cJSON *event) {
+    const cJSON *type = cJSON_GetObjectItem(event, "type");
+    return cJSON_IsString(type) ? type->valuestring : "";
+}
+
+static char *test_change_feed(void) {
+    size_t count = 0;
+    Task **tasks = storage_load_tasks(&count);
+    mu_assert("load", tasks && count == 2);
+    unsigned long long start = journal_last_seq();
+
+    // A full save journals only what differs from the files
+    Task *added = make_task("f", "home", false);
+    free(tasks[0]->name);
+    tasks[0]->name = strdup("b2");
+    Task *saved[2] = {tasks[0], added};
+    mu_assert("save", storage_save_tasks(saved, 2) == 0);
+    mu_assert("three records", journal_last_seq() == start + 3);
+
+    unsigned long long next = 0;
+    bool gap = true;
+    cJSON *events = journal_changes(start, 0, &next, &gap);
+    mu_assert("feed", events && cJSON_GetArraySize(events) == 3 && !gap && next == start + 3);
+    const cJSON *update = cJSON_GetArrayItem(events, 0);
+    const cJSON *changed = cJSON_GetObjectItem(update, "changed");
+    mu_assert("update first", strcmp(event_type(update), "update") == 0);
+    mu_assert("sequence numbers", cJSON_GetObjectItem(update, "seq")->valuedouble == (double)(start + 1));
+    mu_assert("changed fields", cJSON_GetArraySize(changed) == 1
+              && strcmp(cJSON_GetArrayItem(changed, 0)->valuestring, "name") == 0);
+    mu_assert("then add", strcmp(event_type(cJSON_GetArrayItem(events, 1)), "add") == 0);
+    const cJSON *removed = cJSON_GetArrayItem(events, 2);
+    mu_assert("then delete", strcmp(event_type(removed), "delete") == 0 && !cJSON_GetObjectItem(removed, "task"));
+    cJSON_Delete(events);
+
+    // Resume mid-way, in pages
+    events = journal_changes(start + 1, 1, &next, &gap);
+    mu_assert("page", cJSON_GetArraySize(events) == 1 && next == start + 2
+              && strcmp(event_type(cJSON_GetArrayItem(events, 0)), "add") == 0);
+    cJSON_Delete(events);
+    events = journal_changes(next, 0, &next, &gap);
+    mu_assert("rest", cJSON_GetArraySize(events) == 1 && next == start + 3);
+    cJSON_Delete(events);
+    events = journal_changes(next, 0, &next, &gap);
+    mu_assert("caught up", cJSON_GetArraySize(events) == 0 && !gap && next == start + 3);
+    cJSON_Delete(events);
+
+    // A reader ahead of the journal, or behind its retained history, must resync
+    events = journal_changes(start + 10, 0, &next, &gap);
+    mu_assert("ahead", events && gap && next == start + 3);
+    cJSON_Delete(events);
+    char *path = storage_path(JOURNAL_FILE);
+    FILE *f = fopen(path, "w");
+    free(path);
+    mu_assert("trim journal", f != NULL);
+    fclose(f);
+    mu_assert("append after trim", journal_append(JOURNAL_PUT, added) == 0);
+    mu_assert("numbering continues", journal_last_seq() == start + 4);
+    events = journal_changes(start, 0, &next, &gap);
+    mu_assert("behind", events && gap && cJSON_GetArraySize(events) == 0 && next == start + 4);
+    cJSON_Delete(events);
+
+    storage_free_tasks(tasks, count);
+    task_free(added);
+    return 0;
+}
+
+static char *test_save_after_load(void) {
+    Task *saved[2] = {make_task("g", "home", false), make_task("h", "work", false)};
+    mu_assert("save", storage_save_tasks(saved, 2) == 0);
+
+    // Another process changes h, so what this one saved is out of date
+    saved[1]->priority = PRIORITY_HIGH;
+    mu_assert("other writer", journal_append(JOURNAL_PUT, saved[1]) == 0);
+    task_free(saved[0]);
+    task_free(saved[1]);
+
+    size_t count = 0;
+    Task **tasks = storage_load_tasks(&count);
+    mu_assert("load", tasks && count == 2 && tasks[1]->priority == PRIORITY_HIGH);
+    unsigned long long start = journal_last_seq();
+
+    // The load fingerprinted the tasks, so the save diffs against that and
+    // does not read the files again; an unreadable snapshot shows it
+    char *path = storage_tasks_path();
+    FILE *f = fopen(path, "w");
+    free(path);
+    mu_assert("clobber snapshot", f != NULL);
+    fputs("not json", f);
+    fclose(f);
+
+    tasks[1]->status = STATUS_DONE;
+    mu_assert("save without reading back", storage_save_tasks(tasks, count) == 0);
+    mu_assert("one record", journal_last_seq() == start + 1);
+    storage_free_tasks(tasks, count);
+
+    tasks = storage_load_tasks(&count);
+    mu_assert("saved", tasks && count == 2 && tasks[1]->status == STATUS_DONE
+                       && tasks[1]->priority == PRIORITY_HIGH);
+    storage_free_tasks(tasks, count);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    (void)argc;  // Unused parameter
+    (void)argv;  // Unused parameter
+
+    printf("Running storage tests...\n");
+
+    if (!test_home_setup()) return 1;
+
+    char *result = all_tests();
+    if (result != 0) {
+        printf("TEST FAILED: %s\n", result);
+    } else {
+        printf("ALL TESTS PASSED\n");
+    }
+    printf("Tests run: %d\n", tests_run);
+
+    test_home_teardown();
+    return result != 0;
+}
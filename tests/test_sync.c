@@ -0,0 +1,247 @@
+#include "minunit.h"
+#include "test_utils.h"
+#include "../src/sync.h"
+#include "../src/storage.h"
+#include "../src/daemon_client.h"
+#include "../src/app_clock.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define T0 1790000000
+
+// Test counter
+int tests_run = 0;
+
+static char home_a[TEST_DIR_BUFSZ];
+static char home_b[TEST_DIR_BUFSZ];
+static char shared[TEST_DIR_BUFSZ];
+
+// Forward declarations for test functions
+static char *test_first_sync(void);
+static char *test_field_merge(void);
+static char *test_delete_wins(void);
+static char *test_incremental(void);
+
+// Helper function to run all tests
+static char *all_tests(void) {
+    mu_run_test(test_first_sync);
+    mu_run_test(test_field_merge);
+    mu_run_test(test_delete_wins);
+    mu_run_test(test_incremental);
+    return 0;
+}
+
+// Helper: run a step as the device living in home, in a child process so
+// each device starts with fresh storage caches like a separate machine
+static int as_device(const char *home, time_t now, int (*step)(void)) {
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        setenv("HOME", home, 1);
+        app_clock_set_fixed(now);
+        _exit(step() == 0 ? 0 : 1);
+    }
+    int status = 0;
+    if (pid < 0 || waitpid(pid, &status, 0) != pid) return -1;
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+// Helper: the task named name, or NULL
+static Task *find(Task **tasks, size_t count, const char *name) {
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(tasks[i]->name, name) == 0) return tasks[i];
+    }
+    return NULL;
+}
+
+// Helper: add a task and save
+static int add_task(const char *name, const char *project) {
+    size_t count = 0;
+    Task **tasks = storage_load_tasks(&count);
+    Task *t = task_create(name, 0, DUE_NONE, NULL, 0, PRIORITY_LOW);
+    Task **grown = (tasks && t) ? realloc(tasks, (count + 1) * sizeof(Task *)) : NULL;
+    if (!grown) return -1;
+    free(t->project);
+    t->project = strdup(project);
+    t->created = app_clock_now();
+    grown[count] = t;
+    int rc = storage_save_tasks(grown, count + 1);
+    storage_free_tasks(grown, count + 1);
+    return rc;
+}
+
+// Helper: sync and compare what was sent and applied
+static int sync_expect(size_t sent, size_t applied) {
+    SyncStats stats;
+    if (sync_run(NULL, &stats) != 0) return -1;
+    return stats.sent == sent && stats.applied == applied ? 0 : -1;
+}
+
+static int a_first(void) {
+    if (add_task("Write report", "work") != 0 || add_task("Buy milk", "home") != 0) return -1;
+    SyncStats stats;
+    if (sync_run(shared, &stats) != 0) return -1;
+    return stats.devices == 0 && stats.sent == 2 && stats.applied == 0 ? 0 : -1;
+}
+
+static int b_first(void) {
+    if (add_task("Call Bob", "work") != 0) return -1;
+    SyncStats stats;
+    if (sync_run(shared, &stats) != 0) return -1;
+    size_t count = 0;
+    Task **tasks = storage_load_tasks(&count);
+    int rc = stats.devices == 1 && stats.sent == 1 && stats.applied == 2 && count == 3
+             && find(tasks, count, "Write report") && strcmp(find(tasks, count, "Write report")->project, "work") == 0
+             ? 0 : -1;
+    storage_free_tasks(tasks, count);
+    return rc;
+}
+
+static int a_catch_up(void) {
+    if (sync_expect(0, 1) != 0) return -1;
+    size_t count = 0;
+    Task **tasks = storage_load_tasks(&count);
+    int rc = count == 3 && find(tasks, count, "Call Bob") ? 0 : -1;
+    storage_free_tasks(tasks, count);
+    return rc;
+}
+
+static char *test_first_sync(void) {
+    mu_assert("A sends its tasks", as_device(home_a, T0, a_first) == 0);
+    mu_assert("B receives them and sends its own", as_device(home_b, T0 + 10, b_first) == 0);
+    mu_assert("A receives B's task", as_device(home_a, T0 + 20, a_catch_up) == 0);
+    return 0;
+}
+
+// Helper: change one task and save
+static int edit(const char *name, void (*change)(Task *)) {
+    size_t count = 0;
+    Task **tasks = storage_load_tasks(&count);
+    Task *t = tasks ? find(tasks, count, name) : NULL;
+    if (!t) return -1;
+    change(t);
+    int rc = storage_save_tasks(tasks, count);
+    storage_free_tasks(tasks, count);
+    return rc;
+}
+
+static void set_high(Task *t) { t->priority = PRIORITY_HIGH; }
+static void set_note(Task *t) { free(t->note); t->note = strdup("Figures from Q3"); }
+static void set_home(Task *t) { free(t->project); t->project = strdup("home"); }
+static void set_office(Task *t) { free(t->project); t->project = strdup("office"); }
+static void set_done(Task *t) { t->status = STATUS_DONE; }
+
+static int a_edit(void) { return edit("Write report", set_high) || edit("Write report", set_office); }
+static int b_edit(void) { return edit("Write report", set_note) || edit("Write report", set_home); }
+
+// Helper: both edits survive and the later project wins
+static int merged(void) {
+    size_t count = 0;
+    Task **tasks = storage_load_tasks(&count);
+    Task *t = tasks ? find(tasks, count, "Write report") : NULL;
+    int rc = t && t->priority == PRIORITY_HIGH && t->note && strcmp(t->note, "Figures from Q3") == 0
+             && strcmp(t->project, "home") == 0 ? 0 : -1;
+    storage_free_tasks(tasks, count);
+    return rc;
+}
+
+static int a_send(void) { return sync_expect(1, 0); }
+static int b_sync_merged(void) { return sync_expect(1, 1) || merged(); }
+static int a_sync_merged(void) { return sync_expect(0, 1) || merged(); }
+
+static char *test_field_merge(void) {
+    mu_assert("A edits priority and project", as_device(home_a, T0 + 100, a_edit) == 0);
+    mu_assert("B edits note and project later", as_device(home_b, T0 + 200, b_edit) == 0);
+    mu_assert("A sends its edit", as_device(home_a, T0 + 300, a_send) == 0);
+    mu_assert("B merges", as_device(home_b, T0 + 400, b_sync_merged) == 0);
+    mu_assert("A merges", as_device(home_a, T0 + 500, a_sync_merged) == 0);
+    return 0;
+}
+
+static int a_delete(void) {
+    size_t count = 0;
+    Task **tasks = storage_load_tasks(&count);
+    Task *t = tasks ? find(tasks, count, "Buy milk") : NULL;
+    if (!t) return -1;
+    for (size_t i = 0; i < count; i++) {
+        if (tasks[i] == t) tasks[i] = tasks[--count];
+    }
+    task_free(t);
+    int rc = storage_save_tasks(tasks, count);
+    storage_free_tasks(tasks, count);
+    return rc != 0 || sync_expect(1, 0) != 0 ? -1 : 0;
+}
+
+static int b_done_then_sync(void) {
+    if (edit("Buy milk", set_done) != 0 || sync_expect(1, 1) != 0) return -1;
+    size_t count = 0;
+    Task **tasks = storage_load_tasks(&count);
+    int rc = count == 2 && !find(tasks, count, "Buy milk") ? 0 : -1;
+    storage_free_tasks(tasks, count);
+    return rc;
+}
+
+static int a_ignores_edit(void) {
+    if (sync_expect(0, 0) != 0) return -1;
+    size_t count = 0;
+    Task **tasks = storage_load_tasks(&count);
+    int rc = count == 2 && !find(tasks, count, "Buy milk") ? 0 : -1;
+    storage_free_tasks(tasks, count);
+    return rc;
+}
+
+static char *test_delete_wins(void) {
+    mu_assert("A deletes", as_device(home_a, T0 + 600, a_delete) == 0);
+    mu_assert("B's later edit loses to the delete", as_device(home_b, T0 + 700, b_done_then_sync) == 0);
+    mu_assert("A ignores the edit", as_device(home_a, T0 + 800, a_ignores_edit) == 0);
+    return 0;
+}
+
+// Helper: total size of the logs in the shared directory
+static long long shared_bytes(void) {
+    char cmd[256];
+    snprintf(cmd, sizeof(cmd), "cat %s/*.jsonl | wc -c", shared);
+    FILE *p = popen(cmd, "r");
+    long long n = -1;
+    if (p && fscanf(p, "%lld", &n) != 1) n = -1;
+    if (p) pclose(p);
+    return n;
+}
+
+static int quiet_sync(void) { return sync_expect(0, 0); }
+
+static char *test_incremental(void) {
+    long long before = shared_bytes();
+    mu_assert("B idle", as_device(home_b, T0 + 900, quiet_sync) == 0);
+    mu_assert("A idle", as_device(home_a, T0 + 1000, quiet_sync) == 0);
+    mu_assert("nothing resent", before > 0 && shared_bytes() == before);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    (void)argc;  // Unused parameter
+    (void)argv;  // Unused parameter
+
+    printf("Running sync tests...\n");
+
+    // Two devices with their own ~/.todo-app, sharing one directory
+    if (test_make_dir(home_a) != 0 || test_make_dir(home_b) != 0 || test_make_dir(shared) != 0) return 1;
+    daemon_client_set_enabled(false);
+
+    char *result = all_tests();
+    if (result != 0) {
+        printf("TEST FAILED: %s\n", result);
+    } else {
+        printf("ALL TESTS PASSED\n");
+    }
+    printf("Tests run: %d\n", tests_run);
+
+    test_remove_tree(home_a);
+    test_remove_tree(home_b);
+    test_remove_tree(shared);
+    return result != 0;
+}
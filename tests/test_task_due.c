@@ -0,0 +1,142 @@
+#include "minunit.h"
+#include "../src/task.h"
+#include "../src/tz_cache.h"
+#include "../src/utils.h"
+#include <time.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+// Test counter
+int tests_run = 0;
+
+// Forward declarations for test functions
+static char *test_infer_due_kind(void);
+static char *test_date_only_day(void);
+static char *test_midnight_datetime(void);
+static char *test_json_round_trip(void);
+static char *test_legacy_json(void);
+
+// Helper function to run all tests
+static char *all_tests(void) {
+    mu_run_test(test_infer_due_kind);
+    mu_run_test(test_date_only_day);
+    mu_run_test(test_midnight_datetime);
+    mu_run_test(test_json_round_trip);
+    mu_run_test(test_legacy_json);
+    return 0;
+}
+
+// Helper: switch the process time zone and drop cached segments
+static void use_zone(const char *zone) {
+    setenv("TZ", zone, 1);
+    tzset();
+    tz_cache_reset();
+}
+
+static char *test_infer_due_kind(void) {
+    mu_assert("no due", task_infer_due_kind(0) == DUE_NONE);
+    mu_assert("midnight UTC is a date", task_infer_due_kind(1779235200) == DUE_DATE);
+    mu_assert("other instants are datetimes", task_infer_due_kind(1779235200 + 3600) == DUE_DATETIME);
+    return 0;
+}
+
+static char *test_date_only_day(void) {
+    // 2026-05-20 as a date-only due must stay May 20 east and west of UTC
+    const char *zones[] = {"America/Los_Angeles", "Pacific/Auckland"};
+    for (size_t i = 0; i < 2; ++i) {
+        use_zone(zones[i]);
+        Task *t = task_create("date", 0, DUE_NONE, NULL, 0, PRIORITY_LOW);
+        mu_assert("task_create", t != NULL);
+        task_set_due(t, utils_parse_date("2026-05-20"), DUE_DATE);
+
+        char buf[16];
+        mu_assert("format", task_format_due_date(t, buf, sizeof(buf)) != NULL);
+        mu_assert("calendar date preserved", strcmp(buf, "2026-05-20") == 0);
+
+        struct tm tm = {0};
+        tm.tm_year = 126;
+        tm.tm_mon = 4;
+        tm.tm_mday = 20;
+        tm.tm_isdst = -1;
+        time_t local_midnight = mktime(&tm);
+        mu_assert("start is local midnight", task_due_start(t) == local_midnight);
+        mu_assert("deadline is the next local midnight",
+                  task_due_deadline(t) == local_midnight + 24 * 60 * 60);
+        task_free(t);
+    }
+    use_zone("UTC");
+    return 0;
+}
+
+static char *test_midnight_datetime(void) {
+    // A datetime due at midnight UTC stays a datetime: only legacy files infer the kind
+    use_zone("UTC");
+    Task *t = task_create("call", 1779235200, DUE_DATETIME, NULL, 0, PRIORITY_LOW);
+    mu_assert("task_create", t != NULL);
+    mu_assert("kind kept", t->due_kind == DUE_DATETIME && t->due == 1779235200);
+    task_free(t);
+    return 0;
+}
+
+static char *test_json_round_trip(void) {
+    use_zone("Europe/Berlin");
+    Task *t = task_create("meeting", 0, DUE_NONE, NULL, 0, PRIORITY_HIGH);
+    mu_assert("task_create", t != NULL);
+    task_set_due(t, 1779264000, DUE_DATETIME); // 2026-05-20T08:00:00Z = 10:00 CEST
+    mu_assert("due_tz recorded", t->due_tz == 120);
+
+    char *json = task_to_json(t);
+    mu_assert("task_to_json", json != NULL);
+    mu_assert("due_kind serialized", strstr(json, "\"due_kind\":\"datetime\"") != NULL);
+    mu_assert("due_tz serialized", strstr(json, "\"due_tz\":\"+02:00\"") != NULL);
+
+    Task *back = task_from_json(json);
+    mu_assert("task_from_json", back != NULL);
+    mu_assert("due", back->due == t->due);
+    mu_assert("due_kind", back->due_kind == DUE_DATETIME);
+    mu_assert("due_tz", back->due_tz == 120);
+
+    free(json);
+    task_free(back);
+    task_free(t);
+    use_zone("UTC");
+    return 0;
+}
+
+static char *test_legacy_json(void) {
+    const char *legacy =
+        "{\"id\":\"1\",\"name\":\"old\",\"created\":\"2025-04-16T20:40:00Z\","
+        "\"due\":\"2025-04-23T00:00:00Z\",\"tags\":[],\"priority\":\"low\",\"status\":\"pending\"}";
+    Task *t = task_from_json(legacy);
+    mu_assert("task_from_json", t != NULL);
+    mu_assert("legacy midnight UTC is date-only", t->due_kind == DUE_DATE);
+    task_free(t);
+
+    const char *no_due =
+        "{\"id\":\"2\",\"name\":\"none\",\"created\":\"2025-04-16T20:40:00Z\","
+        "\"due\":null,\"tags\":[],\"priority\":\"low\",\"status\":\"pending\"}";
+    t = task_from_json(no_due);
+    mu_assert("task_from_json", t != NULL);
+    mu_assert("no due", t->due_kind == DUE_NONE);
+    task_free(t);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    (void)argc;  // Unused parameter
+    (void)argv;  // Unused parameter
+
+    printf("Running task due tests...\n");
+
+    char *result = all_tests();
+    if (result != 0) {
+        printf("TEST FAILED: %s\n", result);
+    } else {
+        printf("ALL TESTS PASSED\n");
+    }
+    printf("Tests run: %d\n", tests_run);
+
+    return result != 0;
+}
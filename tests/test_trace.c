@@ -0,0 +1,239 @@
+#include "minunit.h"
+#include "../src/trace.h"
+#include <cjson/cJSON.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+// Test counter
+int tests_run = 0;
+
+static char dir[] = "/tmp/smartodo-trace-XXXXXX";
+static char dump_path[256];
+
+// Forward declarations for test functions
+static char *test_off_by_default(void);
+static char *test_spans_nest(void);
+static char *test_threads(void);
+static char *test_ring_wraps(void);
+static char *test_dump_while_recording(void);
+
+// Helper function to run all tests
+static char *all_tests(void) {
+    mu_run_test(test_off_by_default);
+    mu_run_test(test_spans_nest);
+    mu_run_test(test_threads);
+    mu_run_test(test_ring_wraps);
+    mu_run_test(test_dump_while_recording);
+    return 0;
+}
+
+// Helper: dump the trace and parse it back
+static cJSON *dump_and_read(void) {
+    if (trace_dump(dump_path) != 0) return NULL;
+    FILE *f = fopen(dump_path, "r");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    rewind(f);
+    char *data = malloc((size_t)size + 1);
+    size_t n = data ? fread(data, 1, (size_t)size, f) : 0;
+    fclose(f);
+    if (!data) return NULL;
+    data[n] = '\0';
+    cJSON *root = cJSON_Parse(data);
+    free(data);
+    return root;
+}
+
+// Helper: count the events of a phase, optionally of one name and thread
+static int count_events(const cJSON *root, const char *phase, const char *name, int tid) {
+    int n = 0;
+    const cJSON *e;
+    cJSON_ArrayForEach(e, cJSON_GetObjectItem(root, "traceEvents")) {
+        const char *ph = cJSON_GetStringValue(cJSON_GetObjectItem(e, "ph"));
+        const char *nm = cJSON_GetStringValue(cJSON_GetObjectItem(e, "name"));
+        int t = (int)cJSON_GetNumberValue(cJSON_GetObjectItem(e, "tid"));
+        if (ph && strcmp(ph, phase) == 0 && (!name || (nm && strcmp(nm, name) == 0)) && (tid < 0 || t == tid)) n++;
+    }
+    return n;
+}
+
+// Helper: whether every thread's spans are balanced, in time order
+static bool balanced(const cJSON *root) {
+    int depth[8] = {0};
+    double last[8] = {0};
+    const cJSON *e;
+    cJSON_ArrayForEach(e, cJSON_GetObjectItem(root, "traceEvents")) {
+        const char *ph = cJSON_GetStringValue(cJSON_GetObjectItem(e, "ph"));
+        int t = (int)cJSON_GetNumberValue(cJSON_GetObjectItem(e, "tid"));
+        double ts = cJSON_GetNumberValue(cJSON_GetObjectItem(e, "ts"));
+        if (!ph || ph[0] == 'M') continue;
+        if (t < 0 || t >= 8 || ts < last[t]) return false;
+        last[t] = ts;
+        depth[t] += ph[0] == 'B' ? 1 : -1;
+        if (depth[t] < 0) return false;
+    }
+    for (int t = 0; t < 8; t++) {
+        if (depth[t] != 0) return false;
+    }
+    return true;
+}
+
+static char *test_off_by_default(void) {
+    mu_assert("off before init", !trace_enabled());
+    trace_begin("ignored");
+    trace_end("ignored");
+    mu_assert("nothing to dump", trace_dump(dump_path) == -1);
+
+    char pattern[256];
+    snprintf(pattern, sizeof(pattern), "%s/trace-%%p.json", dir);
+    setenv(TRACE_ENV, pattern, 1);
+    trace_init();
+    mu_assert("on after init", trace_enabled());
+
+    // The default file has the process id in its name
+    char expected[256];
+    snprintf(expected, sizeof(expected), "%s/trace-%ld.json", dir, (long)getpid());
+    mu_assert("dump to default", trace_dump(NULL) == 0 && access(expected, F_OK) == 0);
+    unlink(expected);
+    return 0;
+}
+
+static char *test_spans_nest(void) {
+    trace_begin("outer");
+    trace_begin("inner");
+    trace_end("inner");
+    trace_begin("inner");
+    trace_end("inner");
+    trace_end("outer");
+
+    cJSON *root = dump_and_read();
+    mu_assert("dump parses", root != NULL);
+    mu_assert("no events before init", count_events(root, "B", "ignored", -1) == 0);
+    mu_assert("outer", count_events(root, "B", "outer", 1) == 1 && count_events(root, "E", "outer", 1) == 1);
+    mu_assert("inner", count_events(root, "B", "inner", 1) == 2 && count_events(root, "E", "inner", 1) == 2);
+    mu_assert("thread named", count_events(root, "M", "thread_name", 1) == 1);
+    mu_assert("process named", count_events(root, "M", "process_name", -1) == 1);
+    mu_assert("balanced", balanced(root));
+    cJSON_Delete(root);
+    return 0;
+}
+
+static void *worker(void *arg) {
+    (void)arg;
+    for (int i = 0; i < 3; i++) {
+        trace_begin("work");
+        trace_end("work");
+    }
+    return NULL;
+}
+
+static char *test_threads(void) {
+    pthread_t threads[2];
+    for (int i = 0; i < 2; i++) mu_assert("thread", pthread_create(&threads[i], NULL, worker, NULL) == 0);
+    for (int i = 0; i < 2; i++) pthread_join(threads[i], NULL);
+
+    // Ended threads keep their spans, each under a thread id of its own
+    cJSON *root = dump_and_read();
+    mu_assert("dump parses", root != NULL);
+    mu_assert("all spans", count_events(root, "B", "work", -1) == 6);
+    mu_assert("none on main", count_events(root, "B", "work", 1) == 0);
+    mu_assert("thread 2", count_events(root, "B", "work", 2) == 3);
+    mu_assert("thread 3", count_events(root, "B", "work", 3) == 3);
+    mu_assert("balanced", balanced(root));
+    cJSON_Delete(root);
+    return 0;
+}
+
+static char *test_ring_wraps(void) {
+    // The beginning of outer is overwritten; its end must not be dumped alone
+    trace_begin("outer");
+    for (int i = 0; i < TRACE_RING_EVENTS; i++) {
+        trace_begin("tick");
+        trace_end("tick");
+    }
+    trace_end("outer");
+
+    cJSON *root = dump_and_read();
+    mu_assert("dump parses", root != NULL);
+    int ticks = count_events(root, "B", "tick", 1);
+    mu_assert("newest kept", ticks >= TRACE_RING_EVENTS / 2 - 1 && ticks <= TRACE_RING_EVENTS / 2);
+    mu_assert("outer dropped", count_events(root, "E", "outer", 1) == 0);
+    mu_assert("balanced", balanced(root));
+    cJSON_Delete(root);
+    return 0;
+}
+
+static atomic_bool spinning;
+
+static void *spinner(void *arg) {
+    (void)arg;
+    while (atomic_load(&spinning)) {
+        trace_begin("spin");
+        trace_end("spin");
+    }
+    return NULL;
+}
+
+static char *test_dump_while_recording(void) {
+    // A thread keeps wrapping its ring while it is dumped; every event dumped
+    // must be whole and in order
+    atomic_store(&spinning, true);
+    pthread_t thread;
+    mu_assert("thread", pthread_create(&thread, NULL, spinner, NULL) == 0);
+    bool whole = true;
+    int dumped = 0;
+    for (int round = 0; round < 3 && whole; round++) {
+        cJSON *root = dump_and_read();
+        if (!root) {
+            whole = false;
+            break;
+        }
+        double last = 0;
+        const cJSON *e;
+        cJSON_ArrayForEach(e, cJSON_GetObjectItem(root, "traceEvents")) {
+            const char *ph = cJSON_GetStringValue(cJSON_GetObjectItem(e, "ph"));
+            const char *nm = cJSON_GetStringValue(cJSON_GetObjectItem(e, "name"));
+            double ts = cJSON_GetNumberValue(cJSON_GetObjectItem(e, "ts"));
+            if ((int)cJSON_GetNumberValue(cJSON_GetObjectItem(e, "tid")) != 4 || !ph || ph[0] == 'M') continue;
+            if (!nm || strcmp(nm, "spin") != 0 || (ph[0] != 'B' && ph[0] != 'E') || ts < last) whole = false;
+            last = ts;
+            dumped++;
+        }
+        cJSON_Delete(root);
+    }
+    atomic_store(&spinning, false);
+    pthread_join(thread, NULL);
+    mu_assert("events whole and in order", whole);
+    mu_assert("events dumped", dumped > 0);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    (void)argc;  // Unused parameter
+    (void)argv;  // Unused parameter
+
+    printf("Running trace tests...\n");
+
+    if (!mkdtemp(dir)) return 1;
+    snprintf(dump_path, sizeof(dump_path), "%s/trace.json", dir);
+
+    char *result = all_tests();
+    if (result != 0) {
+        printf("TEST FAILED: %s\n", result);
+    } else {
+        printf("ALL TESTS PASSED\n");
+    }
+    printf("Tests run: %d\n", tests_run);
+
+    // The dump at exit finds the directory gone
+    char cmd[256];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", dir);
+    system(cmd);
+    return result != 0;
+}
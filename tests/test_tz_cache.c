@@ -0,0 +1,123 @@
+#include "minunit.h"
+#include "../src/tz_cache.h"
+#include "../src/utils.h"
+#include <time.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+// Test counter
+int tests_run = 0;
+
+// Zones with DST in either hemisphere, a half-hour DST shift and no DST
+static const char *ZONES[] = {
+    "UTC", "Europe/Berlin", "America/New_York", "Australia/Sydney",
+    "Australia/Lord_Howe", "Asia/Kolkata",
+};
+
+// Forward declarations for test functions
+static char *test_offset_matches_libc(void);
+static char *test_local_day_matches_libc(void);
+static char *test_local_time_round_trip(void);
+
+// Helper function to run all tests
+static char *all_tests(void) {
+    mu_run_test(test_offset_matches_libc);
+    mu_run_test(test_local_day_matches_libc);
+    mu_run_test(test_local_time_round_trip);
+    return 0;
+}
+
+// Helper: switch the process time zone and drop cached segments
+static void use_zone(const char *zone) {
+    setenv("TZ", zone, 1);
+    tzset();
+    tz_cache_reset();
+}
+
+// Helper: offset computed directly with localtime_r
+static long libc_offset(time_t t) {
+    struct tm tm;
+    localtime_r(&t, &tm);
+    long long local = utils_days_from_civil(tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday) * 86400LL +
+                      tm.tm_hour * 3600LL + tm.tm_min * 60LL + tm.tm_sec;
+    return (long)(local - (long long)t);
+}
+
+static char *test_offset_matches_libc(void) {
+    for (size_t z = 0; z < sizeof(ZONES) / sizeof(ZONES[0]); ++z) {
+        use_zone(ZONES[z]);
+        // 2020-01-01 to 2031-01-01 in steps of 1h 7m 13s, touching every transition
+        for (time_t t = 1577836800; t < 1924992000; t += 4033) {
+            if (tz_cache_offset(t) != libc_offset(t)) {
+                printf("Mismatch in %s at %lld\n", ZONES[z], (long long)t);
+                mu_assert("offset differs from localtime_r", 0);
+            }
+        }
+        // Random access after the table is warm
+        unsigned int seed = 7;
+        for (int i = 0; i < 20000; ++i) {
+            seed = seed * 1103515245u + 12345u;
+            time_t t = (time_t)(946684800LL + (long long)(seed % 1262304000u));
+            mu_assert("random offset differs from localtime_r", tz_cache_offset(t) == libc_offset(t));
+        }
+    }
+    use_zone("UTC");
+    return 0;
+}
+
+static char *test_local_day_matches_libc(void) {
+    use_zone("America/New_York");
+    for (time_t t = 1767225600; t < 1798761600; t += 1800) { // 2026 in half hours
+        struct tm tm;
+        localtime_r(&t, &tm);
+        long long expected = utils_days_from_civil(tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+        mu_assert("local day differs from localtime_r", tz_cache_local_day(t) == expected);
+    }
+    use_zone("UTC");
+    return 0;
+}
+
+static char *test_local_time_round_trip(void) {
+    use_zone("Europe/Berlin");
+    long long day = utils_days_from_civil(2026, 3, 29); // Spring forward at 02:00
+
+    struct tm tm = {0};
+    tm.tm_year = 126;
+    tm.tm_mon = 2;
+    tm.tm_mday = 29;
+    tm.tm_isdst = -1;
+    mu_assert("midnight before the gap", tz_cache_local_time(day, 0) == mktime(&tm));
+
+    tm = (struct tm){0};
+    tm.tm_year = 126;
+    tm.tm_mon = 2;
+    tm.tm_mday = 29;
+    tm.tm_hour = 9;
+    tm.tm_isdst = -1;
+    mu_assert("09:00 after the gap", tz_cache_local_time(day, 9 * 3600) == mktime(&tm));
+
+    // 02:30 does not exist; it resolves with the pre-gap offset to 03:30 CEST
+    mu_assert("gap time", tz_cache_local_time(day, 2 * 3600 + 1800) == tz_cache_local_time(day, 3 * 3600 + 1800));
+
+    use_zone("UTC");
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    (void)argc;  // Unused parameter
+    (void)argv;  // Unused parameter
+
+    printf("Running tz_cache tests...\n");
+
+    char *result = all_tests();
+    if (result != 0) {
+        printf("TEST FAILED: %s\n", result);
+    } else {
+        printf("ALL TESTS PASSED\n");
+    }
+    printf("Tests run: %d\n", tests_run);
+
+    return result != 0;
+}
@@ -0,0 +1,151 @@
+#include "minunit.h"
+#include "../src/undo.h"
+#include "../src/task_manager.h"
+#include "../src/utils.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+// Test counter
+int tests_run = 0;
+
+static Task **tasks;
+static size_t count;
+
+// Forward declarations for test functions
+static char *test_add_delete(void);
+static char *test_edit(void);
+static char *test_group(void);
+static char *test_new_change_clears_redo(void);
+static char *test_spill(void);
+
+// Helper function to run all tests
+static char *all_tests(void) {
+    mu_run_test(test_add_delete);
+    mu_run_test(test_edit);
+    mu_run_test(test_group);
+    mu_run_test(test_new_change_clears_redo);
+    mu_run_test(test_spill);
+    return 0;
+}
+
+// Helper: the task named name, or NULL
+static Task *find(const char *name) {
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(tasks[i]->name, name) == 0) return tasks[i];
+    }
+    return NULL;
+}
+
+// Helper: add a task with default fields
+static int add(const char *name) {
+    return task_manager_add_task(&tasks, &count, name, 0, DUE_DATE, NULL, 0, PRIORITY_LOW, "default");
+}
+
+// Helper: delete the task named name
+static int delete_named(const char *name) {
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(tasks[i]->name, name) == 0) return task_manager_delete_task(&tasks, &count, i);
+    }
+    return -1;
+}
+
+static char *test_add_delete(void) {
+    char label[UNDO_LABEL_LEN];
+    mu_assert("add A", add("A") == 0);
+    mu_assert("add B", add("B") == 0);
+    mu_assert("delete A", delete_named("A") == 0 && count == 1);
+    mu_assert("three steps", undo_depth() == 3);
+
+    mu_assert("undo delete", undo_undo(&tasks, &count, label, sizeof(label)) == 1 && find("A") && count == 2);
+    mu_assert("default label", strcmp(label, "Change") == 0);
+    mu_assert("undo add", undo_undo(&tasks, &count, NULL, 0) == 1 && !find("B") && count == 1);
+    mu_assert("redo add", undo_redo(&tasks, &count, NULL, 0) == 1 && find("B") && count == 2);
+    mu_assert("redo delete", undo_redo(&tasks, &count, NULL, 0) == 1 && !find("A") && count == 1);
+    mu_assert("nothing to redo", undo_redo(&tasks, &count, NULL, 0) == 0);
+    return 0;
+}
+
+static char *test_edit(void) {
+    Task *b = find("B");
+    mu_assert("edit", task_manager_update_task(b, "B2", -1, DUE_NONE, NULL, 0, PRIORITY_HIGH, -1) == 0);
+    mu_assert("toggle", task_manager_toggle_status(b) == STATUS_DONE);
+
+    mu_assert("undo toggle", undo_undo(&tasks, &count, NULL, 0) == 1 && b->status == STATUS_PENDING);
+    mu_assert("undo edit in place", undo_undo(&tasks, &count, NULL, 0) == 1 && find("B") == b);
+    mu_assert("fields restored", b->priority == PRIORITY_LOW);
+    mu_assert("redo edit", undo_redo(&tasks, &count, NULL, 0) == 1 && strcmp(b->name, "B2") == 0
+              && b->priority == PRIORITY_HIGH && b->status == STATUS_PENDING);
+    return 0;
+}
+
+static char *test_group(void) {
+    char label[UNDO_LABEL_LEN];
+    size_t depth = undo_depth();
+    undo_begin("AI action");
+    mu_assert("add C", add("C") == 0);
+    mu_assert("edit C", task_manager_update_task(find("C"), "C2", -1, DUE_NONE, NULL, 0, -1, -1) == 0);
+    mu_assert("delete B2", delete_named("B2") == 0);
+    undo_end();
+    mu_assert("one step", undo_depth() == depth + 1);
+
+    mu_assert("undo group", undo_undo(&tasks, &count, label, sizeof(label)) == 1);
+    mu_assert("group label", strcmp(label, "AI action") == 0);
+    mu_assert("all undone", count == 1 && find("B2") && !find("C2"));
+    mu_assert("redo group", undo_redo(&tasks, &count, NULL, 0) == 1 && count == 1 && find("C2"));
+    return 0;
+}
+
+static char *test_new_change_clears_redo(void) {
+    mu_assert("undo", undo_undo(&tasks, &count, NULL, 0) == 1);
+    mu_assert("new change", add("D") == 0);
+    mu_assert("redo gone", undo_redo(&tasks, &count, NULL, 0) == 0);
+    return 0;
+}
+
+static char *test_spill(void) {
+    undo_detach();
+    mu_assert("attach with small budget", undo_attach(1024) == 0);
+    mu_assert("attached once", undo_attach(0) == 1);
+
+    Task *d = find("D");
+    char name[16];
+    for (int i = 1; i <= 50; i++) {
+        snprintf(name, sizeof(name), "v%d", i);
+        mu_assert("edit", task_manager_update_task(d, name, -1, DUE_NONE, NULL, 0, -1, -1) == 0);
+    }
+    mu_assert("budget kept", undo_memory_bytes() <= 1024);
+    mu_assert("every step kept", undo_depth() == 50);
+
+    for (int i = 0; i < 50; i++) {
+        mu_assert("undo", undo_undo(&tasks, &count, NULL, 0) == 1);
+        mu_assert("budget kept while undoing", undo_memory_bytes() <= 1024);
+    }
+    mu_assert("back to the start", strcmp(d->name, "D") == 0);
+    mu_assert("nothing left", undo_undo(&tasks, &count, NULL, 0) == 0);
+    mu_assert("redo latest", undo_redo(&tasks, &count, NULL, 0) == 1 && strcmp(d->name, "v1") == 0);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    (void)argc;  // Unused parameter
+    (void)argv;  // Unused parameter
+
+    printf("Running undo tests...\n");
+
+    tasks = utils_calloc(1, sizeof(Task *));
+    if (!tasks || undo_attach(0) != 0) return 1;
+
+    char *result = all_tests();
+    if (result != 0) {
+        printf("TEST FAILED: %s\n", result);
+    } else {
+        printf("ALL TESTS PASSED\n");
+    }
+    printf("Tests run: %d\n", tests_run);
+
+    undo_detach();
+    task_manager_cleanup(tasks, count);
+    return result != 0;
+}
@@ -1,16 +1,38 @@
 #include "test_utils.h"
-#include <stdarg.h>
-#include <stddef.h>  // For size_t
+#include "../src/daemon_client.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ftw.h>
 
-void utils_show_message(const char *format, ...) {
-    (void)format;  // Mark as unused to suppress warning
-    // No-op for tests
+static char home[TEST_DIR_BUFSZ];
+
+int test_make_dir(char *dir) {
+    snprintf(dir, TEST_DIR_BUFSZ, "/tmp/smartodo-test-XXXXXX");
+    return mkdtemp(dir) ? 0 : -1;
 }
 
-int utils_get_user_input(char *buffer, size_t size) {
-    (void)buffer;  // Mark as unused
-    (void)size;    // Mark as unused
-    // No-op for tests
+// Helper: nftw() callback; remove one entry, children first
+static int remove_entry(const char *path, const struct stat *st, int flag, struct FTW *ftw) {
+    (void)st;
+    (void)flag;
+    (void)ftw;
+    remove(path);
     return 0;
 }
-// Add any other utility function stubs that might be needed
+
+void test_remove_tree(const char *path) {
+    nftw(path, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+const char *test_home_setup(void) {
+    if (test_make_dir(home) != 0) return NULL;
+    setenv("HOME", home, 1);
+    daemon_client_set_enabled(false);
+    return home;
+}
+
+void test_home_teardown(void) {
+    if (home[0]) test_remove_tree(home);
+    home[0] = '\0';
+}
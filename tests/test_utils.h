@@ -1,7 +1,33 @@
 #ifndef TEST_UTILS_H
 #define TEST_UTILS_H
 
-// Forward declaration of the function we're stubbing
-void utils_show_message(const char *format, ...);
+// Buffer size for test_make_dir() ("/tmp/smartodo-test-XXXXXX" plus terminator)
+#define TEST_DIR_BUFSZ 26
+
+/**
+ * Create a new empty directory under /tmp.
+ * @param dir[out] Buffer of at least TEST_DIR_BUFSZ bytes for its path
+ * @return 0 on success, -1 on failure
+ */
+int test_make_dir(char *dir);
+
+/**
+ * Remove a directory and everything in it.
+ * @param path Directory path
+ */
+void test_remove_tree(const char *path);
+
+/**
+ * Point HOME at a new empty directory, so the tests stay away from the real
+ * ~/.todo-app, and keep storage calls away from a running daemon.
+ * @return The directory, or NULL on failure
+ */
+const char *test_home_setup(void);
+
+/**
+ * Remove the directory test_home_setup() made, with everything the tests
+ * wrote to it.
+ */
+void test_home_teardown(void);
 
 #endif // TEST_UTILS_H